@@ -22,12 +22,14 @@
 /**
  * SECTION:element-libvisualgl
  *
- * Wrapper for libvisual plugins that use OpenGL
+ * Wrapper for libvisual plugins that use OpenGL. The actors draw with the
+ * fixed function pipeline so a desktop OpenGL context is required, see
+ * glvisualizer for a visualisation that works on any GL API.
  *
  * <refsect2>
  * <title>Examples</title>
  * |[
- * gst-launch -v audiotestsrc ! libvisual_gl_lv_flower ! glimagesink
+ * gst-launch-1.0 -v audiotestsrc ! libvisual_gl_lv_flower ! glimagesink
  * ]|
  * </refsect2>
  */
@@ -36,12 +38,13 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include <gst/gst.h>
 #include <gst/base/gstadapter.h>
 #include <gst/video/video.h>
 #include <gst/audio/audio.h>
-#include <gst/gl/gstglbuffer.h>
-#include <gst/gl/gstgldisplay.h>
+#include <gst/gl/gl.h>
 
 #include <libvisual/libvisual.h>
 
@@ -78,11 +81,19 @@ struct _GstVisualGL
 
   /* GL stuff */
   GstGLDisplay *display;
+  GstGLContext *context;
+  GstGLShader *shader;
+  GstBufferPool *pool;
   GLuint fbo;
   GLuint depthbuffer;
   GLuint midtexture;
-  GLdouble actor_projection_matrix[16];
-  GLdouble actor_modelview_matrix[16];
+  guint out_tex;
+
+  /* fixed function state the actor left after being realized.  The
+   * context is shared with other elements so it is restored before every
+   * run and everything the actor touches is pushed and popped around it */
+  GLfloat actor_projection_matrix[16];
+  GLfloat actor_modelview_matrix[16];
   GLboolean is_enabled_gl_depth_test;
   GLint gl_depth_func;
   GLboolean is_enabled_gl_blend;
@@ -106,7 +117,8 @@ struct _GstVisualGL
   gint width;
   gint height;
   GstClockTime duration;
-  guint outsize;
+  GstVideoInfo vinfo;
+  gboolean negotiated;
 
   /* samples per frame based on caps */
   guint spf;
@@ -133,20 +145,37 @@ GType gst_visual_gl_get_type (void);
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS (GST_GL_VIDEO_CAPS)
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (GST_GL_DOWNLOAD_FORMATS))
     );
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("audio/x-raw-int, "
-        "width = (int) 16, "
-        "depth = (int) 16, "
-        "endianness = (int) BYTE_ORDER, "
-        "signed = (boolean) TRUE, " "channels = (int) { 1, 2 }, "
+    GST_STATIC_CAPS ("audio/x-raw, "
+        "format = (string) " GST_AUDIO_NE (S16) ", "
+        "layout = (string) interleaved, " "channels = (int) { 1, 2 }, "
         "rate = (int) { 8000, 11250, 22500, 32000, 44100, 48000, 96000 }")
     );
 
+/* *INDENT-OFF* */
+static const gchar *flip_vertex_source =
+  "attribute vec4 a_position;\n"
+  "attribute vec2 a_texcoord;\n"
+  "varying vec2 v_texcoord;\n"
+  "void main()\n"
+  "{\n"
+  "   gl_Position = a_position;\n"
+  "   v_texcoord = a_texcoord;\n"
+  "}\n";
+
+static const gchar *flip_fragment_source =
+  "varying vec2 v_texcoord;\n"
+  "uniform sampler2D tex;\n"
+  "void main()\n"
+  "{\n"
+  "  gl_FragColor = texture2D(tex, v_texcoord);\n"
+  "}\n";
+/* *INDENT-ON* */
 
 static void gst_visual_gl_class_init (gpointer g_class, gpointer class_data);
 static void gst_visual_gl_init (GstVisualGL * visual);
@@ -154,15 +183,25 @@ static void gst_visual_gl_dispose (GObject * object);
 
 static GstStateChangeReturn gst_visual_gl_change_state (GstElement * element,
     GstStateChange transition);
-static GstFlowReturn gst_visual_gl_chain (GstPad * pad, GstBuffer * buffer);
-static gboolean gst_visual_gl_sink_event (GstPad * pad, GstEvent * event);
-static gboolean gst_visual_gl_src_event (GstPad * pad, GstEvent * event);
-
-static gboolean gst_visual_gl_src_query (GstPad * pad, GstQuery * query);
-
-static gboolean gst_visual_gl_sink_setcaps (GstPad * pad, GstCaps * caps);
-static gboolean gst_visual_gl_src_setcaps (GstPad * pad, GstCaps * caps);
-static GstCaps *gst_visual_gl_getcaps (GstPad * pad);
+static void gst_visual_gl_set_context (GstElement * element,
+    GstContext * context);
+static GstFlowReturn gst_visual_gl_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * buffer);
+static gboolean gst_visual_gl_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event);
+static gboolean gst_visual_gl_src_event (GstPad * pad, GstObject * parent,
+    GstEvent * event);
+
+static gboolean gst_visual_gl_sink_query (GstPad * pad, GstObject * parent,
+    GstQuery * query);
+static gboolean gst_visual_gl_src_query (GstPad * pad, GstObject * parent,
+    GstQuery * query);
+
+static gboolean gst_visual_gl_sink_setcaps (GstVisualGL * visual,
+    GstCaps * caps);
+static gboolean gst_visual_gl_src_setcaps (GstVisualGL * visual,
+    GstCaps * caps);
+static GstCaps *gst_visual_gl_getcaps (GstVisualGL * visual, GstCaps * filter);
 static void libvisual_log_handler (const char *message, const char *funcname,
     void *priv);
 
@@ -208,6 +247,7 @@ gst_visual_gl_class_init (gpointer g_class, gpointer class_data)
   klass->plugin = class_data;
 
   element_class->change_state = gst_visual_gl_change_state;
+  element_class->set_context = gst_visual_gl_set_context;
 
   if (class_data == NULL) {
     parent_class = g_type_class_peek_parent (g_class);
@@ -236,14 +276,12 @@ gst_visual_gl_init (GstVisualGL * visual)
 {
   /* create the sink and src pads */
   visual->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
-  gst_pad_set_setcaps_function (visual->sinkpad, gst_visual_gl_sink_setcaps);
   gst_pad_set_chain_function (visual->sinkpad, gst_visual_gl_chain);
   gst_pad_set_event_function (visual->sinkpad, gst_visual_gl_sink_event);
+  gst_pad_set_query_function (visual->sinkpad, gst_visual_gl_sink_query);
   gst_element_add_pad (GST_ELEMENT (visual), visual->sinkpad);
 
   visual->srcpad = gst_pad_new_from_static_template (&src_template, "src");
-  gst_pad_set_setcaps_function (visual->srcpad, gst_visual_gl_src_setcaps);
-  gst_pad_set_getcaps_function (visual->srcpad, gst_visual_gl_getcaps);
   gst_pad_set_event_function (visual->srcpad, gst_visual_gl_src_event);
   gst_pad_set_query_function (visual->srcpad, gst_visual_gl_src_query);
   gst_element_add_pad (GST_ELEMENT (visual), visual->srcpad);
@@ -253,6 +291,7 @@ gst_visual_gl_init (GstVisualGL * visual)
   visual->actor = NULL;
 
   visual->display = NULL;
+  visual->context = NULL;
   visual->fbo = 0;
   visual->depthbuffer = 0;
   visual->midtexture = 0;
@@ -286,13 +325,21 @@ gst_visual_gl_dispose (GObject * object)
   GstVisualGL *visual = GST_VISUAL_GL (object);
 
   if (visual->adapter) {
-    gst_object_unref (visual->adapter);
+    g_object_unref (visual->adapter);
     visual->adapter = NULL;
   }
 
   GST_CALL_PARENT (G_OBJECT_CLASS, dispose, (object));
 }
 
+static void
+gst_visual_gl_set_context (GstElement * element, GstContext * context)
+{
+  GstVisualGL *visual = GST_VISUAL_GL (element);
+
+  gst_gl_handle_set_context (element, context, &visual->display);
+}
+
 static void
 gst_visual_gl_reset (GstVisualGL * visual)
 {
@@ -305,15 +352,39 @@ gst_visual_gl_reset (GstVisualGL * visual)
   GST_OBJECT_UNLOCK (visual);
 }
 
+/* drops everything that depends on the output caps */
+static void
+gst_visual_gl_reset_output (GstVisualGL * visual)
+{
+  if (visual->pool) {
+    gst_buffer_pool_set_active (visual->pool, FALSE);
+    gst_object_unref (visual->pool);
+    visual->pool = NULL;
+  }
+
+  if (visual->context) {
+    //blocking call, delete the FBO
+    if (visual->fbo)
+      gst_gl_context_del_fbo (visual->context, visual->fbo,
+          visual->depthbuffer);
+    if (visual->midtexture)
+      gst_gl_context_del_texture (visual->context, &visual->midtexture);
+  }
+
+  visual->fbo = 0;
+  visual->depthbuffer = 0;
+  visual->midtexture = 0;
+  visual->negotiated = FALSE;
+}
+
 static GstCaps *
-gst_visual_gl_getcaps (GstPad * pad)
+gst_visual_gl_getcaps (GstVisualGL * visual, GstCaps * filter)
 {
   GstCaps *ret;
-  GstVisualGL *visual = GST_VISUAL_GL (gst_pad_get_parent (pad));
   int depths;
 
   if (!visual->actor) {
-    ret = gst_caps_copy (gst_pad_get_pad_template_caps (visual->srcpad));
+    ret = gst_pad_get_pad_template_caps (visual->srcpad);
     goto beach;
   }
 
@@ -331,31 +402,148 @@ gst_visual_gl_getcaps (GstPad * pad)
   GST_DEBUG_OBJECT (visual, "libvisual-gl plugin supports depths %u (0x%04x)",
       depths, depths);
   /* only do GL output */
-  gst_caps_append (ret, gst_caps_from_string (GST_GL_VIDEO_CAPS));
+  gst_caps_unref (ret);
+  ret = gst_pad_get_pad_template_caps (visual->srcpad);
 
 beach:
+  if (filter) {
+    GstCaps *intersection;
+
+    intersection =
+        gst_caps_intersect_full (filter, ret, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (ret);
+    ret = intersection;
+  }
 
   GST_DEBUG_OBJECT (visual, "returning caps %" GST_PTR_FORMAT, ret);
-  gst_object_unref (visual);
   return ret;
 }
 
+/* Called in the gl thread */
+static void
+actor_setup (GstGLContext * context, GstVisualGL * visual)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+
+  /* save and clear top of the stack */
+  gl->PushAttrib (GL_ALL_ATTRIB_BITS);
+
+  gl->MatrixMode (GL_PROJECTION);
+  gl->PushMatrix ();
+  gl->LoadIdentity ();
+
+  gl->MatrixMode (GL_MODELVIEW);
+  gl->PushMatrix ();
+  gl->LoadIdentity ();
+
+  visual->actor_setup_result = visual_actor_realize (visual->actor);
+  if (visual->actor_setup_result == 0) {
+    /* store the actor's matrices for rendering the first frame */
+    gl->GetFloatv (GL_MODELVIEW_MATRIX, visual->actor_modelview_matrix);
+    gl->GetFloatv (GL_PROJECTION_MATRIX, visual->actor_projection_matrix);
+
+    visual->is_enabled_gl_depth_test = gl->IsEnabled (GL_DEPTH_TEST);
+    gl->GetIntegerv (GL_DEPTH_FUNC, &visual->gl_depth_func);
+
+    visual->is_enabled_gl_blend = gl->IsEnabled (GL_BLEND);
+    gl->GetIntegerv (GL_BLEND_SRC_ALPHA, &visual->gl_blend_src_alpha);
+  }
+
+  /* retore matrix */
+  gl->MatrixMode (GL_PROJECTION);
+  gl->PopMatrix ();
+
+  gl->MatrixMode (GL_MODELVIEW);
+  gl->PopMatrix ();
+
+  gl->PopAttrib ();
+}
+
+/* libvisual actors draw with the fixed function pipeline, which only a
+ * desktop GL context has */
 static gboolean
-gst_visual_gl_src_setcaps (GstPad * pad, GstCaps * caps)
+gst_visual_gl_ensure_context (GstVisualGL * visual)
 {
-  GstVisualGL *visual = GST_VISUAL_GL (gst_pad_get_parent (pad));
-  GstStructure *structure;
+  GError *error = NULL;
+
+  if (visual->context)
+    return TRUE;
+
+  if (!gst_gl_ensure_display (visual, &visual->display))
+    return FALSE;
+
+  visual->context = gst_gl_context_new (visual->display);
+  if (!gst_gl_context_create (visual->context, NULL, &error))
+    goto context_error;
 
-  structure = gst_caps_get_structure (caps, 0);
+  if (!(gst_gl_context_get_gl_api (visual->context) & GST_GL_API_OPENGL))
+    goto wrong_api;
 
+  //blocking call, wait the opengl thread has compiled the shader
+  if (!gst_gl_context_gen_shader (visual->context, flip_vertex_source,
+          flip_fragment_source, &visual->shader))
+    goto shader_error;
+
+  gst_gl_context_thread_add (visual->context,
+      (GstGLContextThreadFunc) actor_setup, visual);
+
+  if (visual->actor_setup_result != 0)
+    goto actor_setup_failed;
+
+  visual_actor_set_video (visual->actor, visual->video);
+
+  return TRUE;
+
+  /* ERRORS */
+context_error:
+  {
+    GST_ELEMENT_ERROR (visual, RESOURCE, NOT_FOUND, ("%s", error->message),
+        (NULL));
+    g_clear_error (&error);
+    goto failed;
+  }
+wrong_api:
+  {
+    GST_ELEMENT_ERROR (visual, RESOURCE, NOT_FOUND,
+        ("%s", "libvisual actors require a desktop OpenGL context"), (NULL));
+    goto failed;
+  }
+shader_error:
+  {
+    GST_ELEMENT_ERROR (visual, RESOURCE, NOT_FOUND,
+        ("%s", "Failed to compile the shader"), (NULL));
+    goto failed;
+  }
+actor_setup_failed:
+  {
+    GST_ELEMENT_ERROR (visual, LIBRARY, INIT, (NULL),
+        ("could not set up actor"));
+    goto failed;
+  }
+failed:
+  {
+    if (visual->shader)
+      gst_gl_context_del_shader (visual->context, visual->shader);
+    visual->shader = NULL;
+    gst_object_unref (visual->context);
+    visual->context = NULL;
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_visual_gl_src_setcaps (GstVisualGL * visual, GstCaps * caps)
+{
   GST_DEBUG_OBJECT (visual, "src pad got caps %" GST_PTR_FORMAT, caps);
 
-  if (!gst_structure_get_int (structure, "width", &visual->width))
+  if (!gst_video_info_from_caps (&visual->vinfo, caps))
     goto error;
-  if (!gst_structure_get_int (structure, "height", &visual->height))
-    goto error;
-  if (!gst_structure_get_fraction (structure, "framerate", &visual->fps_n,
-          &visual->fps_d))
+
+  visual->width = GST_VIDEO_INFO_WIDTH (&visual->vinfo);
+  visual->height = GST_VIDEO_INFO_HEIGHT (&visual->vinfo);
+  visual->fps_n = GST_VIDEO_INFO_FPS_N (&visual->vinfo);
+  visual->fps_d = GST_VIDEO_INFO_FPS_D (&visual->vinfo);
+  if (visual->fps_n <= 0)
     goto error;
 
   /* precalc some values */
@@ -364,34 +552,37 @@ gst_visual_gl_src_setcaps (GstPad * pad, GstCaps * caps)
   visual->duration =
       gst_util_uint64_scale_int (GST_SECOND, visual->fps_d, visual->fps_n);
 
-  gst_gl_display_gen_texture (visual->display, &visual->midtexture,
-      visual->width, visual->height);
+  if (!gst_pad_set_caps (visual->srcpad, caps))
+    return FALSE;
 
-  gst_gl_display_gen_fbo (visual->display, visual->width, visual->height,
-      &visual->fbo, &visual->depthbuffer);
+  if (!gst_visual_gl_ensure_context (visual))
+    return FALSE;
 
-  gst_object_unref (visual);
-  return TRUE;
+  gst_gl_context_gen_texture (visual->context, &visual->midtexture,
+      GST_VIDEO_FORMAT_RGBA, visual->width, visual->height);
+
+  //blocking call, generate a FBO
+  return gst_gl_context_gen_fbo (visual->context, visual->width,
+      visual->height, &visual->fbo, &visual->depthbuffer);
 
   /* ERRORS */
 error:
   {
     GST_DEBUG_OBJECT (visual, "error parsing caps");
-    gst_object_unref (visual);
     return FALSE;
   }
 }
 
 static gboolean
-gst_visual_gl_sink_setcaps (GstPad * pad, GstCaps * caps)
+gst_visual_gl_sink_setcaps (GstVisualGL * visual, GstCaps * caps)
 {
-  GstVisualGL *visual = GST_VISUAL_GL (gst_pad_get_parent (pad));
-  GstStructure *structure;
+  GstAudioInfo info;
 
-  structure = gst_caps_get_structure (caps, 0);
+  if (!gst_audio_info_from_caps (&info, caps))
+    return FALSE;
 
-  gst_structure_get_int (structure, "channels", &visual->channels);
-  gst_structure_get_int (structure, "rate", &visual->rate);
+  visual->channels = GST_AUDIO_INFO_CHANNELS (&info);
+  visual->rate = GST_AUDIO_INFO_RATE (&info);
 
   switch (visual->rate) {
     case 8000:
@@ -416,7 +607,6 @@ gst_visual_gl_sink_setcaps (GstPad * pad, GstCaps * caps)
       visual->libvisual_rate = VISUAL_AUDIO_SAMPLE_RATE_96000;
       break;
     default:
-      gst_object_unref (visual);
       return FALSE;
   }
 
@@ -426,9 +616,67 @@ gst_visual_gl_sink_setcaps (GstPad * pad, GstCaps * caps)
     visual->spf =
         gst_util_uint64_scale_int (visual->rate, visual->fps_d, visual->fps_n);
   }
-  visual->bps = visual->channels * sizeof (gint16);
+  visual->bps = GST_AUDIO_INFO_BPF (&info);
+
+  return TRUE;
+}
+
+static gboolean
+gst_visual_gl_decide_allocation (GstVisualGL * visual, GstCaps * caps)
+{
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  GstQuery *query;
+  guint min, max, size;
+
+  query = gst_query_new_allocation (caps, TRUE);
+  if (!gst_pad_peer_query (visual->srcpad, query)) {
+    /* not a problem, just debug a little */
+    GST_DEBUG_OBJECT (visual, "peer ALLOCATION query failed");
+  }
+
+  if (gst_query_get_n_allocation_pools (query) > 0) {
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+
+    /* we render straight into the textures of the pool so only take
+     * GL pools that live in our context and keep the frame in a single
+     * texture */
+    if (pool && GST_IS_GL_BUFFER_POOL (pool)) {
+      config = gst_buffer_pool_get_config (pool);
+      if (GST_GL_BUFFER_POOL (pool)->context != visual->context
+          || gst_buffer_pool_config_has_option (config,
+              GST_BUFFER_POOL_OPTION_GL_PLANAR)) {
+        gst_object_unref (pool);
+        pool = NULL;
+      }
+      gst_structure_free (config);
+    } else if (pool) {
+      gst_object_unref (pool);
+      pool = NULL;
+    }
+  } else {
+    size = GST_VIDEO_INFO_SIZE (&visual->vinfo);
+    min = max = 0;
+  }
+  gst_query_unref (query);
+
+  if (!pool) {
+    pool = gst_gl_buffer_pool_new (visual->context);
+    size = GST_VIDEO_INFO_SIZE (&visual->vinfo);
+  }
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, size, min, max);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+  if (!gst_buffer_pool_set_config (pool, config)
+      || !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (visual, "failed to configure the buffer pool");
+    gst_object_unref (pool);
+    return FALSE;
+  }
+
+  visual->pool = pool;
 
-  gst_object_unref (visual);
   return TRUE;
 }
 
@@ -438,26 +686,29 @@ gst_vis_gl_src_negotiate (GstVisualGL * visual)
   GstCaps *othercaps, *target;
   GstStructure *structure;
   GstCaps *caps;
+  gboolean ret;
 
-  caps = gst_pad_get_caps (visual->srcpad);
+  gst_visual_gl_reset_output (visual);
+
+  caps = gst_visual_gl_getcaps (visual, NULL);
 
   /* see what the peer can do */
-  othercaps = gst_pad_peer_get_caps (visual->srcpad);
+  othercaps = gst_pad_peer_query_caps (visual->srcpad, caps);
   if (othercaps) {
-    target = gst_caps_intersect (othercaps, caps);
-    gst_caps_unref (othercaps);
+    target = othercaps;
     gst_caps_unref (caps);
 
     if (gst_caps_is_empty (target))
       goto no_format;
 
-    gst_caps_truncate (target);
+    target = gst_caps_truncate (target);
   } else {
-    /* need a copy, we'll be modifying it when fixating */
-    target = gst_caps_copy (caps);
-    gst_caps_unref (caps);
+    target = caps;
   }
 
+  /* need a writable copy, we'll be modifying it when fixating */
+  target = gst_caps_make_writable (target);
+
   /* fixate in case something is not fixed. This does nothing if the value is
    * already fixed. For video we always try to fixate to something like
    * 320x240x25 by convention. */
@@ -466,11 +717,15 @@ gst_vis_gl_src_negotiate (GstVisualGL * visual)
   gst_structure_fixate_field_nearest_int (structure, "height", DEFAULT_HEIGHT);
   gst_structure_fixate_field_nearest_fraction (structure, "framerate",
       DEFAULT_FPS_N, DEFAULT_FPS_D);
+  target = gst_caps_fixate (target);
 
-  gst_pad_set_caps (visual->srcpad, target);
+  ret = gst_visual_gl_src_setcaps (visual, target)
+      && gst_visual_gl_decide_allocation (visual, target);
   gst_caps_unref (target);
 
-  return TRUE;
+  visual->negotiated = ret;
+
+  return ret;
 
   /* ERRORS */
 no_format:
@@ -483,14 +738,22 @@ no_format:
 }
 
 static gboolean
-gst_visual_gl_sink_event (GstPad * pad, GstEvent * event)
+gst_visual_gl_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
-  GstVisualGL *visual;
+  GstVisualGL *visual = GST_VISUAL_GL (parent);
   gboolean res;
 
-  visual = GST_VISUAL_GL (gst_pad_get_parent (pad));
-
   switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:
+    {
+      GstCaps *caps;
+
+      /* the src caps are negotiated when the first frame is rendered */
+      gst_event_parse_caps (event, &caps);
+      res = gst_visual_gl_sink_setcaps (visual, caps);
+      gst_event_unref (event);
+      break;
+    }
     case GST_EVENT_FLUSH_START:
       res = gst_pad_push_event (visual->srcpad, event);
       break;
@@ -499,44 +762,31 @@ gst_visual_gl_sink_event (GstPad * pad, GstEvent * event)
       gst_visual_gl_reset (visual);
       res = gst_pad_push_event (visual->srcpad, event);
       break;
-    case GST_EVENT_NEWSEGMENT:
+    case GST_EVENT_SEGMENT:
     {
-      GstFormat format;
-      gdouble rate, arate;
-      gint64 start, stop, time;
-      gboolean update;
-
-      /* the newsegment values are used to clip the input samples
+      /* the segment values are used to clip the input samples
        * and to convert the incomming timestamps to running time so
        * we can do QoS */
-      gst_event_parse_new_segment_full (event, &update, &rate, &arate, &format,
-          &start, &stop, &time);
-
-      /* now configure the values */
-      gst_segment_set_newsegment_full (&visual->segment, update,
-          rate, arate, format, start, stop, time);
+      gst_event_copy_segment (event, &visual->segment);
 
       /* and forward */
       res = gst_pad_push_event (visual->srcpad, event);
       break;
     }
     default:
-      res = gst_pad_push_event (visual->srcpad, event);
+      res = gst_pad_event_default (pad, parent, event);
       break;
   }
 
-  gst_object_unref (visual);
   return res;
 }
 
 static gboolean
-gst_visual_gl_src_event (GstPad * pad, GstEvent * event)
+gst_visual_gl_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
-  GstVisualGL *visual;
+  GstVisualGL *visual = GST_VISUAL_GL (parent);
   gboolean res;
 
-  visual = GST_VISUAL_GL (gst_pad_get_parent (pad));
-
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_QOS:
     {
@@ -544,7 +794,7 @@ gst_visual_gl_src_event (GstPad * pad, GstEvent * event)
       GstClockTimeDiff diff;
       GstClockTime timestamp;
 
-      gst_event_parse_qos (event, &proportion, &diff, &timestamp);
+      gst_event_parse_qos (event, NULL, &proportion, &diff, &timestamp);
 
       /* save stuff for the _chain function */
       GST_OBJECT_LOCK (visual);
@@ -562,21 +812,39 @@ gst_visual_gl_src_event (GstPad * pad, GstEvent * event)
       break;
     }
     default:
-      res = gst_pad_push_event (visual->sinkpad, event);
+      res = gst_pad_event_default (pad, parent, event);
       break;
   }
 
-  gst_object_unref (visual);
   return res;
 }
 
 static gboolean
-gst_visual_gl_src_query (GstPad * pad, GstQuery * query)
+gst_visual_gl_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
 {
+  GstVisualGL *visual = GST_VISUAL_GL (parent);
   gboolean res;
-  GstVisualGL *visual;
 
-  visual = GST_VISUAL_GL (gst_pad_get_parent (pad));
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:
+    {
+      res = gst_gl_handle_context_query ((GstElement *) visual, query,
+          &visual->display);
+      break;
+    }
+    default:
+      res = gst_pad_query_default (pad, parent, query);
+      break;
+  }
+
+  return res;
+}
+
+static gboolean
+gst_visual_gl_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstVisualGL *visual = GST_VISUAL_GL (parent);
+  gboolean res;
 
   switch (GST_QUERY_TYPE (query)) {
     case GST_QUERY_LATENCY:
@@ -617,142 +885,44 @@ gst_visual_gl_src_query (GstPad * pad, GstQuery * query)
       }
       break;
     }
-    case GST_QUERY_CUSTOM:
+    case GST_QUERY_CAPS:
     {
-      GstStructure *structure = gst_query_get_structure (query);
-      gchar *name = gst_element_get_name (visual);
-
-      res = g_strcmp0 (name, gst_structure_get_name (structure)) == 0;
-      g_free (name);
+      GstCaps *filter, *caps;
 
-      if (!res)
-        res = gst_pad_query_default (pad, query);
+      gst_query_parse_caps (query, &filter);
+      caps = gst_visual_gl_getcaps (visual, filter);
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      res = TRUE;
+      break;
+    }
+    case GST_QUERY_CONTEXT:
+    {
+      res = gst_gl_handle_context_query ((GstElement *) visual, query,
+          &visual->display);
       break;
     }
     default:
-      res = gst_pad_peer_query (visual->sinkpad, query);
+      res = gst_pad_query_default (pad, parent, query);
       break;
   }
 
-  gst_object_unref (visual);
-
   return res;
 }
 
-/* allocate and output buffer, if no format was negotiated, this
- * function will negotiate one. After calling this function, a
- * reverse negotiation could have happened. */
-static GstFlowReturn
-get_buffer (GstVisualGL * visual, GstGLBuffer ** outbuf)
-{
-  /* we don't know an output format yet, pick one */
-  if (GST_PAD_CAPS (visual->srcpad) == NULL) {
-    if (!gst_vis_gl_src_negotiate (visual))
-      return GST_FLOW_NOT_NEGOTIATED;
-  }
-
-  GST_DEBUG_OBJECT (visual, "allocating output buffer with caps %"
-      GST_PTR_FORMAT, GST_PAD_CAPS (visual->srcpad));
-
-  *outbuf = gst_gl_buffer_new (visual->display, visual->width, visual->height);
-  if (*outbuf == NULL)
-    return GST_FLOW_ERROR;
-
-  gst_buffer_set_caps (GST_BUFFER (*outbuf), GST_PAD_CAPS (visual->srcpad));
-  return GST_FLOW_OK;
-}
-
+/* feeds VISUAL_SAMPLES samples per channel to libvisual, in the streaming
+ * thread so the gl thread only renders */
 static void
-actor_setup (GstGLDisplay * display, GstVisualGL * visual)
-{
-  /* save and clear top of the stack */
-  glPushAttrib (GL_ALL_ATTRIB_BITS);
-
-  glMatrixMode (GL_PROJECTION);
-  glPushMatrix ();
-  glLoadIdentity ();
-
-  glMatrixMode (GL_MODELVIEW);
-  glPushMatrix ();
-  glLoadIdentity ();
-
-  visual->actor_setup_result = visual_actor_realize (visual->actor);
-  if (visual->actor_setup_result == 0) {
-    /* store the actor's matrices for rendering the first frame */
-    glGetDoublev (GL_MODELVIEW_MATRIX, visual->actor_modelview_matrix);
-    glGetDoublev (GL_PROJECTION_MATRIX, visual->actor_projection_matrix);
-
-    visual->is_enabled_gl_depth_test = glIsEnabled (GL_DEPTH_TEST);
-    glGetIntegerv (GL_DEPTH_FUNC, &visual->gl_depth_func);
-
-    visual->is_enabled_gl_blend = glIsEnabled (GL_BLEND);
-    glGetIntegerv (GL_BLEND_SRC_ALPHA, &visual->gl_blend_src_alpha);
-
-    /* retore matrix */
-    glMatrixMode (GL_PROJECTION);
-    glPopMatrix ();
-
-    glMatrixMode (GL_MODELVIEW);
-    glPopMatrix ();
-
-    glPopAttrib ();
-  }
-}
-
-static void
-actor_negotiate (GstGLDisplay * display, GstVisualGL * visual)
-{
-  gint err = VISUAL_OK;
-
-  err = visual_video_set_depth (visual->video, VISUAL_VIDEO_DEPTH_GL);
-  if (err != VISUAL_OK)
-    g_warning ("failed to visual_video_set_depth\n");
-
-  err =
-      visual_video_set_dimension (visual->video, visual->width, visual->height);
-  if (err != VISUAL_OK)
-    g_warning ("failed to visual_video_set_dimension\n");
-
-  err = visual_actor_video_negotiate (visual->actor, 0, FALSE, FALSE);
-  if (err != VISUAL_OK)
-    g_warning ("failed to visual_actor_video_negotiate\n");
-}
-
-static void
-check_gl_matrix (void)
-{
-  GLdouble projection_matrix[16];
-  GLdouble modelview_matrix[16];
-  gint i = 0;
-  gint j = 0;
-
-  glGetDoublev (GL_PROJECTION_MATRIX, projection_matrix);
-  glGetDoublev (GL_MODELVIEW_MATRIX, modelview_matrix);
-
-  for (j = 0; j < 4; ++j) {
-    for (i = 0; i < 4; ++i) {
-      if (projection_matrix[i + 4 * j] != projection_matrix[i + 4 * j])
-        g_warning ("invalid projection matrix at coordiante %dx%d: %f\n", i, j,
-            projection_matrix[i + 4 * j]);
-      if (modelview_matrix[i + 4 * j] != modelview_matrix[i + 4 * j])
-        g_warning ("invalid modelview_matrix matrix at coordiante %dx%d: %f\n",
-            i, j, modelview_matrix[i + 4 * j]);
-    }
-  }
-}
-
-static void
-render_frame (GstVisualGL * visual)
+feed_audio (GstVisualGL * visual)
 {
   const guint16 *data;
   VisBuffer *lbuf, *rbuf;
   guint16 ldata[VISUAL_SAMPLES], rdata[VISUAL_SAMPLES];
   guint i;
-  gcahr *name;
 
   /* Read VISUAL_SAMPLES samples per channel */
   data =
-      (const guint16 *) gst_adapter_peek (visual->adapter,
+      (const guint16 *) gst_adapter_map (visual->adapter,
       VISUAL_SAMPLES * visual->bps);
 
   lbuf = visual_buffer_new_with_buffer (ldata, sizeof (ldata), NULL);
@@ -770,6 +940,8 @@ render_frame (GstVisualGL * visual)
     }
   }
 
+  gst_adapter_unmap (visual->adapter);
+
   visual_audio_samplepool_input_channel (visual->audio->samplepool,
       lbuf, visual->libvisual_rate, VISUAL_AUDIO_SAMPLE_FORMAT_S16,
       VISUAL_AUDIO_CHANNEL_LEFT);
@@ -781,17 +953,44 @@ render_frame (GstVisualGL * visual)
   visual_object_unref (VISUAL_OBJECT (rbuf));
 
   visual_audio_analyze (visual->audio);
+}
+
+static void
+actor_negotiate (GstVisualGL * visual)
+{
+  gint err = VISUAL_OK;
+
+  err = visual_video_set_depth (visual->video, VISUAL_VIDEO_DEPTH_GL);
+  if (err != VISUAL_OK)
+    g_warning ("failed to visual_video_set_depth\n");
+
+  err =
+      visual_video_set_dimension (visual->video, visual->width, visual->height);
+  if (err != VISUAL_OK)
+    g_warning ("failed to visual_video_set_dimension\n");
+
+  err = visual_actor_video_negotiate (visual->actor, 0, FALSE, FALSE);
+  if (err != VISUAL_OK)
+    g_warning ("failed to visual_actor_video_negotiate\n");
+}
+
+/* Called in the gl thread */
+static void
+render_frame (GstVisualGL * visual)
+{
+  const GstGLFuncs *gl = visual->context->gl_vtable;
+  gchar *name;
 
   /* apply the matrices that the actor set up */
-  glPushAttrib (GL_ALL_ATTRIB_BITS);
+  gl->PushAttrib (GL_ALL_ATTRIB_BITS);
 
-  glMatrixMode (GL_PROJECTION);
-  glPushMatrix ();
-  glLoadMatrixd (visual->actor_projection_matrix);
+  gl->MatrixMode (GL_PROJECTION);
+  gl->PushMatrix ();
+  gl->LoadMatrixf (visual->actor_projection_matrix);
 
-  glMatrixMode (GL_MODELVIEW);
-  glPushMatrix ();
-  glLoadMatrixd (visual->actor_modelview_matrix);
+  gl->MatrixMode (GL_MODELVIEW);
+  gl->PushMatrix ();
+  gl->LoadMatrixf (visual->actor_modelview_matrix);
 
   /* This line try to hacks compatiblity with libprojectM
    * If libprojectM version <= 2.0.0 then we have to unbind our current
@@ -804,92 +1003,83 @@ render_frame (GstVisualGL * visual)
   name = gst_element_get_name (GST_ELEMENT (visual));
   if (g_ascii_strncasecmp (name, "visualglprojectm", 16) == 0
       && !HAVE_PROJECTM_TAKING_CARE_OF_EXTERNAL_FBO)
-    glBindFramebufferEXT (GL_FRAMEBUFFER_EXT, 0);
+    gl->BindFramebuffer (GL_FRAMEBUFFER, 0);
   g_free (name);
 
-  actor_negotiate (visual->display, visual);
+  actor_negotiate (visual);
 
   if (visual->is_enabled_gl_depth_test) {
-    glEnable (GL_DEPTH_TEST);
-    glDepthFunc (visual->gl_depth_func);
+    gl->Enable (GL_DEPTH_TEST);
+    gl->DepthFunc (visual->gl_depth_func);
   }
 
   if (visual->is_enabled_gl_blend) {
-    glEnable (GL_BLEND);
-    glBlendFunc (visual->gl_blend_src_alpha, GL_ZERO);
+    gl->Enable (GL_BLEND);
+    gl->BlendFunc (visual->gl_blend_src_alpha, GL_ZERO);
   }
 
   visual_actor_run (visual->actor, visual->audio);
 
-  check_gl_matrix ();
-
-  glMatrixMode (GL_PROJECTION);
-  glPopMatrix ();
+  gl->MatrixMode (GL_PROJECTION);
+  gl->PopMatrix ();
 
-  glMatrixMode (GL_MODELVIEW);
-  glPopMatrix ();
+  gl->MatrixMode (GL_MODELVIEW);
+  gl->PopMatrix ();
 
-  glPopAttrib ();
+  gl->PopAttrib ();
 
-  glDisable (GL_DEPTH_TEST);
-  glDisable (GL_BLEND);
-
-  /*glDisable (GL_LIGHT0);
-     glDisable (GL_LIGHTING);
-     glDisable (GL_POLYGON_OFFSET_FILL);
-     glDisable (GL_COLOR_MATERIAL);
-     glDisable (GL_CULL_FACE); */
+  gl->Disable (GL_DEPTH_TEST);
+  gl->Disable (GL_BLEND);
 
   GST_DEBUG_OBJECT (visual, "rendered one frame");
 }
 
+/* Called in the gl thread */
 static void
-bottom_up_to_top_down (gint width, gint height, guint texture,
-    GstVisualGL * visual)
+bottom_up_to_top_down (GstVisualGL * visual)
 {
+  const GstGLFuncs *gl = visual->context->gl_vtable;
 
-  glEnable (GL_TEXTURE_2D);
-  glBindTexture (GL_TEXTURE_2D, texture);
+  gst_gl_shader_use (visual->shader);
 
-  glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, visual->midtexture);
+  gst_gl_shader_set_uniform_1i (visual->shader, "tex", 0);
 
-  glMatrixMode (GL_PROJECTION);
-  glLoadIdentity ();
+  /* gst video is top-down whereas the actor rendered bottom up */
+  gst_gl_context_bind_geometry (visual->context, GST_GL_GEOMETRY_QUAD_FLIPPED,
+      gst_gl_shader_get_attribute_location (visual->shader, "a_position"),
+      gst_gl_shader_get_attribute_location (visual->shader, "a_texcoord"));
+  gst_gl_context_draw_geometry (visual->context, 0, 1);
+  gst_gl_context_unbind_geometry (visual->context);
 
-  glBegin (GL_QUADS);
-  glTexCoord2i (0, 0);
-  glVertex2i (-1, 1);
-  glTexCoord2i (width, 0);
-  glVertex2i (1, 1);
-  glTexCoord2i (width, height);
-  glVertex2i (1, -1);
-  glTexCoord2i (0, height);
-  glVertex2i (-1, -1);
-  glEnd ();
+  gl->BindTexture (GL_TEXTURE_2D, 0);
 
-  glBindTexture (GL_TEXTURE_2D, 0);
-  glDisable (GL_TEXTURE_2D);
+  gst_gl_context_clear_shader (visual->context);
 
   GST_DEBUG_OBJECT (visual, "bottom up to top down");
 }
 
 static GstFlowReturn
-gst_visual_gl_chain (GstPad * pad, GstBuffer * buffer)
+gst_visual_gl_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
-  GstGLBuffer *outbuf = NULL;
-  GstVisualGL *visual = GST_VISUAL_GL (gst_pad_get_parent (pad));
+  GstBuffer *outbuf = NULL;
+  GstVisualGL *visual = GST_VISUAL_GL (parent);
   GstFlowReturn ret = GST_FLOW_OK;
   guint avail;
 
   GST_DEBUG_OBJECT (visual, "chain function called");
 
-  /* If we don't have an output format yet, preallocate a buffer to try and
-   * set one */
-  if (GST_PAD_CAPS (visual->srcpad) == NULL) {
-    ret = get_buffer (visual, &outbuf);
-    if (ret != GST_FLOW_OK) {
+  if (visual->bps == 0) {
+    gst_buffer_unref (buffer);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+
+  /* If we don't have an output format yet, negotiate one */
+  if (gst_pad_check_reconfigure (visual->srcpad) || !visual->negotiated) {
+    if (!gst_vis_gl_src_negotiate (visual)) {
       gst_buffer_unref (buffer);
-      goto beach;
+      return GST_FLOW_NOT_NEGOTIATED;
     }
   }
 
@@ -899,12 +1089,13 @@ gst_visual_gl_chain (GstPad * pad, GstBuffer * buffer)
   }
 
   GST_DEBUG_OBJECT (visual,
-      "Input buffer has %d samples, time=%" G_GUINT64_FORMAT,
-      GST_BUFFER_SIZE (buffer) / visual->bps, GST_BUFFER_TIMESTAMP (buffer));
+      "Input buffer has %" G_GSIZE_FORMAT " samples, time=%" G_GUINT64_FORMAT,
+      gst_buffer_get_size (buffer) / visual->bps, GST_BUFFER_PTS (buffer));
 
   gst_adapter_push (visual->adapter, buffer);
 
   while (TRUE) {
+    GstVideoFrame frame;
     gboolean need_skip;
     guint64 dist, timestamp;
 
@@ -922,7 +1113,7 @@ gst_visual_gl_chain (GstPad * pad, GstBuffer * buffer)
       break;
 
     /* get timestamp of the current adapter byte */
-    timestamp = gst_adapter_prev_timestamp (visual->adapter, &dist);
+    timestamp = gst_adapter_prev_pts (visual->adapter, &dist);
     if (GST_CLOCK_TIME_IS_VALID (timestamp)) {
       /* convert bytes to time */
       dist /= visual->bps;
@@ -951,32 +1142,34 @@ gst_visual_gl_chain (GstPad * pad, GstBuffer * buffer)
       }
     }
 
-    /* alloc a buffer if we don't have one yet, this happens
-     * when we pushed a buffer in this while loop before */
-    if (outbuf == NULL) {
-      ret = get_buffer (visual, &outbuf);
-      if (ret != GST_FLOW_OK) {
-        goto beach;
-      }
+    ret = gst_buffer_pool_acquire_buffer (visual->pool, &outbuf, NULL);
+    if (ret != GST_FLOW_OK)
+      goto beach;
+
+    if (!gst_video_frame_map (&frame, &visual->vinfo, outbuf,
+            GST_MAP_WRITE | GST_MAP_GL)) {
+      ret = GST_FLOW_ERROR;
+      goto beach;
     }
+    visual->out_tex = *(guint *) frame.data[0];
+
+    feed_audio (visual);
 
     /* render libvisual plugin to our target */
-    gst_gl_display_use_fbo_v2 (visual->display,
+    gst_gl_context_use_fbo_v2 (visual->context,
         visual->width, visual->height, visual->fbo, visual->depthbuffer,
-        visual->midtexture, (GLCB_V2) render_frame, (gpointer *) visual);
+        visual->midtexture, (GLCB_V2) render_frame, visual);
 
-    /* gst video is top-down whereas opengl plan is bottom up */
-    gst_gl_display_use_fbo (visual->display,
+    gst_gl_context_use_fbo_v2 (visual->context,
         visual->width, visual->height, visual->fbo, visual->depthbuffer,
-        outbuf->texture, (GLCB) bottom_up_to_top_down,
-        visual->width, visual->height, visual->midtexture,
-        0, visual->width, 0, visual->height, GST_GL_DISPLAY_PROJECTION_ORTHO2D,
-        (gpointer *) visual);
+        visual->out_tex, (GLCB_V2) bottom_up_to_top_down, visual);
 
-    GST_BUFFER_TIMESTAMP (outbuf) = timestamp;
+    gst_video_frame_unmap (&frame);
+
+    GST_BUFFER_PTS (outbuf) = timestamp;
     GST_BUFFER_DURATION (outbuf) = visual->duration;
 
-    ret = gst_pad_push (visual->srcpad, GST_BUFFER (outbuf));
+    ret = gst_pad_push (visual->srcpad, outbuf);
     outbuf = NULL;
 
   skip:
@@ -994,9 +1187,7 @@ gst_visual_gl_chain (GstPad * pad, GstBuffer * buffer)
 beach:
 
   if (outbuf != NULL)
-    gst_gl_buffer_unref (outbuf);
-
-  gst_object_unref (visual);
+    gst_buffer_unref (outbuf);
 
   return ret;
 }
@@ -1009,67 +1200,23 @@ gst_visual_gl_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_NULL_TO_READY:
+      if (!gst_gl_ensure_display (visual, &visual->display))
+        return GST_STATE_CHANGE_FAILURE;
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
     {
-      GstElement *parent = GST_ELEMENT (gst_element_get_parent (visual));
-      GstStructure *structure = NULL;
-      GstQuery *query = NULL;
-      gboolean isPerformed = FALSE;
-      gchar *name;
-
-      if (!parent) {
-        GST_ELEMENT_ERROR (visual, CORE, STATE_CHANGE, (NULL),
-            ("A parent bin is required"));
-        return FALSE;
-      }
-
-      name = gst_element_get_name (visual);
-      structure = gst_structure_new (name, NULL);
-      query = gst_query_new_application (GST_QUERY_CUSTOM, structure);
-      g_free (name);
-
-      isPerformed = gst_element_query (parent, query);
-
-      if (isPerformed) {
-        const GValue *id_value =
-            gst_structure_get_value (structure, "gstgldisplay");
-        if (G_VALUE_HOLDS_POINTER (id_value))
-          /* at least one gl element is after in our gl chain */
-          visual->display =
-              gst_object_ref (GST_GL_DISPLAY (g_value_get_pointer (id_value)));
-        else {
-          /* this gl filter is a sink in terms of the gl chain */
-          visual->display = gst_gl_display_new ();
-          gst_gl_display_create_context (visual->display, 0);
-          //TODO visual->external_gl_context);
-        }
-
-        gst_visual_gl_reset (visual);
-
-        visual->actor =
-            visual_actor_new (GST_VISUAL_GL_GET_CLASS (visual)->plugin->info->
-            plugname);
-        visual->video = visual_video_new ();
-        visual->audio = visual_audio_new ();
-
-        if (!visual->actor || !visual->video)
-          goto actor_setup_failed;
-
-        gst_gl_display_thread_add (visual->display,
-            (GstGLDisplayThreadFunc) actor_setup, visual);
-
-        if (visual->actor_setup_result != 0)
-          goto actor_setup_failed;
-        else
-          visual_actor_set_video (visual->actor, visual->video);
-      }
+      gst_visual_gl_reset (visual);
 
-      gst_query_unref (query);
-      gst_object_unref (GST_OBJECT (parent));
+      visual->actor =
+          visual_actor_new (GST_VISUAL_GL_GET_CLASS (visual)->plugin->info->
+          plugname);
+      visual->video = visual_video_new ();
+      visual->audio = visual_audio_new ();
 
-      if (!isPerformed)
-        return GST_STATE_CHANGE_FAILURE;
+      /* the actor is realized in the gl thread once the output is
+       * negotiated and the context exists */
+      if (!visual->actor || !visual->video)
+        goto actor_setup_failed;
     }
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
@@ -1085,26 +1232,26 @@ gst_visual_gl_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
     {
-      if (visual->fbo) {
-        gst_gl_display_del_fbo (visual->display, visual->fbo,
-            visual->depthbuffer);
-        visual->fbo = 0;
-        visual->depthbuffer = 0;
-      }
-      if (visual->midtexture) {
-        gst_gl_display_del_texture (visual->display, visual->midtexture,
-            visual->width, visual->height);
-        visual->midtexture = 0;
-      }
-      if (visual->display) {
-        gst_object_unref (visual->display);
-        visual->display = NULL;
+      gst_visual_gl_reset_output (visual);
+
+      if (visual->context) {
+        //blocking call, wait the opengl thread has destroyed the shader
+        if (visual->shader)
+          gst_gl_context_del_shader (visual->context, visual->shader);
+        visual->shader = NULL;
+
+        gst_object_unref (visual->context);
+        visual->context = NULL;
       }
 
       gst_visual_gl_clear_actors (visual);
     }
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
+      if (visual->display) {
+        gst_object_unref (visual->display);
+        visual->display = NULL;
+      }
       break;
     default:
       break;
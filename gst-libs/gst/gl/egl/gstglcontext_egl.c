@@ -37,6 +37,10 @@
 #include "../win32/gstglwindow_win32.h"
 #endif
 
+#ifndef EGL_BUFFER_AGE_EXT
+#define EGL_BUFFER_AGE_EXT 0x313D
+#endif
+
 static gboolean gst_gl_context_egl_create_context (GstGLContext * context,
     GstGLAPI gl_api, GstGLContext * other_context, GError ** error);
 static void gst_gl_context_egl_destroy_context (GstGLContext * context);
@@ -46,6 +50,11 @@ static gboolean gst_gl_context_egl_choose_format (GstGLContext * context,
 static gboolean gst_gl_context_egl_activate (GstGLContext * context,
     gboolean activate);
 static void gst_gl_context_egl_swap_buffers (GstGLContext * context);
+static gint gst_gl_context_egl_get_buffer_age (GstGLContext * context);
+static void gst_gl_context_egl_swap_buffers_with_damage (GstGLContext *
+    context, const gint * rects, guint n_rects);
+static gboolean gst_gl_context_egl_get_sync_values (GstGLContext * context,
+    gint64 * ust, gint64 * msc, gint64 * sbc);
 static guintptr gst_gl_context_egl_get_gl_context (GstGLContext * context);
 static GstGLAPI gst_gl_context_egl_get_gl_api (GstGLContext * context);
 static GstGLPlatform gst_gl_context_egl_get_gl_platform (GstGLContext *
@@ -71,6 +80,12 @@ gst_gl_context_egl_class_init (GstGLContextEGLClass * klass)
       GST_DEBUG_FUNCPTR (gst_gl_context_egl_choose_format);
   context_class->swap_buffers =
       GST_DEBUG_FUNCPTR (gst_gl_context_egl_swap_buffers);
+  context_class->get_buffer_age =
+      GST_DEBUG_FUNCPTR (gst_gl_context_egl_get_buffer_age);
+  context_class->swap_buffers_with_damage =
+      GST_DEBUG_FUNCPTR (gst_gl_context_egl_swap_buffers_with_damage);
+  context_class->get_sync_values =
+      GST_DEBUG_FUNCPTR (gst_gl_context_egl_get_sync_values);
 
   context_class->get_gl_api = GST_DEBUG_FUNCPTR (gst_gl_context_egl_get_gl_api);
   context_class->get_gl_platform =
@@ -344,6 +359,19 @@ gst_gl_context_egl_create_context (GstGLContext * context,
 
   egl_exts = eglQueryString (egl->egl_display, EGL_EXTENSIONS);
 
+  egl->has_buffer_age = gst_gl_check_extension ("EGL_EXT_buffer_age",
+      egl_exts);
+  if (gst_gl_check_extension ("EGL_KHR_swap_buffers_with_damage", egl_exts))
+    egl->SwapBuffersWithDamage =
+        (gpointer) eglGetProcAddress ("eglSwapBuffersWithDamageKHR");
+  else if (gst_gl_check_extension ("EGL_EXT_swap_buffers_with_damage",
+          egl_exts))
+    egl->SwapBuffersWithDamage =
+        (gpointer) eglGetProcAddress ("eglSwapBuffersWithDamageEXT");
+  if (gst_gl_check_extension ("EGL_CHROMIUM_sync_control", egl_exts))
+    egl->GetSyncValues =
+        (gpointer) eglGetProcAddress ("eglGetSyncValuesCHROMIUM");
+
   if (other_context == NULL) {
     /* FIXME do we want a window vfunc ? */
 #if GST_GL_HAVE_WINDOW_X11
@@ -464,6 +492,69 @@ gst_gl_context_egl_swap_buffers (GstGLContext * context)
   eglSwapBuffers (egl->egl_display, egl->egl_surface);
 }
 
+static gint
+gst_gl_context_egl_get_buffer_age (GstGLContext * context)
+{
+  GstGLContextEGL *egl;
+  EGLint age = 0;
+
+  egl = GST_GL_CONTEXT_EGL (context);
+
+  if (!egl->has_buffer_age || egl->egl_surface == EGL_NO_SURFACE)
+    return 0;
+
+  if (!eglQuerySurface (egl->egl_display, egl->egl_surface,
+          EGL_BUFFER_AGE_EXT, &age))
+    return 0;
+
+  return age;
+}
+
+static void
+gst_gl_context_egl_swap_buffers_with_damage (GstGLContext * context,
+    const gint * rects, guint n_rects)
+{
+  GstGLContextEGL *egl;
+  EGLint *egl_rects;
+  guint i;
+
+  egl = GST_GL_CONTEXT_EGL (context);
+
+  if (!egl->SwapBuffersWithDamage) {
+    eglSwapBuffers (egl->egl_display, egl->egl_surface);
+    return;
+  }
+
+  egl_rects = g_newa (EGLint, n_rects * 4);
+  for (i = 0; i < n_rects * 4; i++)
+    egl_rects[i] = rects[i];
+
+  egl->SwapBuffersWithDamage (egl->egl_display, egl->egl_surface, egl_rects,
+      n_rects);
+}
+
+static gboolean
+gst_gl_context_egl_get_sync_values (GstGLContext * context, gint64 * ust,
+    gint64 * msc, gint64 * sbc)
+{
+  GstGLContextEGL *egl;
+  guint64 u, m, s;
+
+  egl = GST_GL_CONTEXT_EGL (context);
+
+  if (!egl->GetSyncValues || egl->egl_surface == EGL_NO_SURFACE)
+    return FALSE;
+
+  if (!egl->GetSyncValues (egl->egl_display, egl->egl_surface, &u, &m, &s))
+    return FALSE;
+
+  *ust = u;
+  *msc = m;
+  *sbc = s;
+
+  return TRUE;
+}
+
 static GstGLAPI
 gst_gl_context_egl_get_gl_api (GstGLContext * context)
 {
@@ -48,6 +48,13 @@ struct _GstGLContextEGL {
   EGLConfig  egl_config;
 
   GstGLAPI gl_api;
+
+  gboolean has_buffer_age;
+  EGLBoolean (*SwapBuffersWithDamage) (EGLDisplay display, EGLSurface surface,
+                                       const EGLint * rects, EGLint n_rects);
+  EGLBoolean (*GetSyncValues) (EGLDisplay display, EGLSurface surface,
+                               guint64 * ust, guint64 * msc,
+                               guint64 * sbc);
 };
 
 struct _GstGLContextEGLClass {
@@ -35,6 +35,7 @@
 #include <gst/gl/gstglmemory.h>
 #include <gst/gl/gstglbufferpool.h>
 #include <gst/gl/gstglframebuffer.h>
+#include <gst/gl/gstgloverlaycompositor.h>
 #include <gst/gl/gstglfilter.h>
 #include <gst/gl/gstglmixer.h>
 #include <gst/gl/gstglshadervariables.h>
@@ -46,6 +46,18 @@ GST_GL_EXT_FUNCTION (void, ReadBuffer,
                      (GLenum mode))
 GST_GL_EXT_END ()
 
+GST_GL_EXT_BEGIN (texture_storage, 4, 2,
+                  GST_GL_API_GLES3,
+                  "ARB:\0EXT\0",
+                  "texture_storage\0")
+GST_GL_EXT_FUNCTION (void, TexStorage2D,
+                     (GLenum target,
+                      GLsizei levels,
+                      GLenum internalformat,
+                      GLsizei width,
+                      GLsizei height))
+GST_GL_EXT_END ()
+
 GST_GL_EXT_BEGIN (draw_buffers, 2, 1,
                   GST_GL_API_GLES3,
                   "ARB\0ATI\0NV\0",
@@ -54,3 +66,40 @@ GST_GL_EXT_FUNCTION (void, DrawBuffers,
                      (GLsizei n, const GLenum *bufs))
 GST_GL_EXT_END ()
 
+GST_GL_EXT_BEGIN (vertex_array_object, 3, 0,
+                  GST_GL_API_GLES3,
+                  "ARB:\0OES\0",
+                  "vertex_array_object\0")
+GST_GL_EXT_FUNCTION (void, GenVertexArrays,
+                     (GLsizei n, GLuint *arrays))
+GST_GL_EXT_FUNCTION (void, DeleteVertexArrays,
+                     (GLsizei n, const GLuint *arrays))
+GST_GL_EXT_FUNCTION (void, BindVertexArray,
+                     (GLuint array))
+GST_GL_EXT_END ()
+
+GST_GL_EXT_BEGIN (instanced_arrays, 3, 3,
+                  GST_GL_API_GLES3,
+                  "ARB:\0EXT\0ANGLE\0",
+                  "instanced_arrays\0")
+GST_GL_EXT_FUNCTION (void, DrawArraysInstanced,
+                     (GLenum mode, GLint first, GLsizei count, GLsizei primcount))
+GST_GL_EXT_FUNCTION (void, VertexAttribDivisor,
+                     (GLuint index, GLuint divisor))
+GST_GL_EXT_END ()
+
+GST_GL_EXT_BEGIN (sync, 3, 2,
+                  GST_GL_API_GLES3,
+                  "ARB:\0APPLE\0",
+                  "sync\0")
+GST_GL_EXT_FUNCTION (GLsync, FenceSync,
+                     (GLenum condition, GLbitfield flags))
+GST_GL_EXT_FUNCTION (GLboolean, IsSync,
+                     (GLsync sync))
+GST_GL_EXT_FUNCTION (void, DeleteSync,
+                     (GLsync sync))
+GST_GL_EXT_FUNCTION (GLenum, ClientWaitSync,
+                     (GLsync sync, GLbitfield flags, GLuint64 timeout))
+GST_GL_EXT_FUNCTION (void, WaitSync,
+                     (GLsync sync, GLbitfield flags, GLuint64 timeout))
+GST_GL_EXT_END ()
@@ -36,5 +36,11 @@ typedef ptrdiff_t GLsizeiptr;
 #ifndef GST_GL_HAVE_GLINTPTR
 typedef ptrdiff_t GLintptr;
 #endif
+#ifndef GST_GL_HAVE_GLSYNC
+typedef gpointer GLsync;
+#endif
+#ifndef GST_GL_HAVE_GLUINT64
+typedef guint64 GLuint64;
+#endif
 
 #endif
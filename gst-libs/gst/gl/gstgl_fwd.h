@@ -42,6 +42,7 @@ typedef struct _GstGLWindowClass   GstGLWindowClass;
 typedef struct _GstGLMemory GstGLMemory;
 typedef struct _GstGLAllocator GstGLAllocator;
 typedef struct _GstGLAllocatorClass GstGLAllocatorClass;
+typedef struct _GstGLTextureAtlas GstGLTextureAtlas;
 
 typedef struct _GstGLShader        GstGLShader;
 typedef struct _GstGLShaderPrivate GstGLShaderPrivate;
@@ -55,6 +56,10 @@ typedef struct _GstGLUpload GstGLUpload;
 typedef struct _GstGLUploadClass GstGLUploadClass;
 typedef struct _GstGLUploadPrivate GstGLUploadPrivate;
 
+typedef struct _GstGLOverlayCompositor GstGLOverlayCompositor;
+typedef struct _GstGLOverlayCompositorClass GstGLOverlayCompositorClass;
+typedef struct _GstGLOverlayCompositorPrivate GstGLOverlayCompositorPrivate;
+
 G_END_DECLS
 
 #endif /* __GST_GL_FWD_H__ */
@@ -36,8 +36,31 @@
  *
  * #GstGLBufferPool implements the VideoMeta buffer pool option 
  * #GST_BUFFER_POOL_OPTION_VIDEO_META
+ *
+ * With the #GST_BUFFER_POOL_OPTION_GL_TEXTURE_ATLAS option, all the buffers
+ * of the pool share a single #GstGLTextureAtlas texture as long as it has
+ * free slots.
+ *
+ * With the #GST_BUFFER_POOL_OPTION_GL_PLANAR and
+ * #GST_BUFFER_POOL_OPTION_VIDEO_META options, buffers of planar YUV formats
+ * hold one #GstGLMemory per plane instead of a single RGBA texture.
+ *
+ * The internal format of the textures is picked with
+ * gst_gl_context_get_texture_format() from the caps unless it is set in the
+ * configuration with gst_buffer_pool_config_set_gl_texture_format().  The
+ * texture atlas only holds GL_RGBA8 textures.
+ *
+ * Buffers whose textures are still shared with a copy of the buffer when
+ * they are released, for example by the other branches of a tee, are not
+ * reused so that the pool never renders into a texture that is still being
+ * read.
  */
 
+/* number of atlas slots when the pool has no maximum number of buffers */
+#define DEFAULT_ATLAS_SLOTS 32
+
+#define GL_TEXTURE_FORMAT_FIELD "gl-texture-format"
+
 /* bufferpool */
 struct _GstGLBufferPoolPrivate
 {
@@ -48,7 +71,12 @@ struct _GstGLBufferPoolPrivate
   GstVideoInfo info;
   guint padded_width;
   guint padded_height;
+  GLenum tex_format;
   gboolean add_videometa;
+  gboolean want_planar;
+  gboolean want_atlas;
+  guint atlas_slots;
+  GstGLTextureAtlas *atlas;
 };
 
 static void gst_gl_buffer_pool_finalize (GObject * object);
@@ -68,7 +96,9 @@ G_DEFINE_TYPE_WITH_CODE (GstGLBufferPool, gst_gl_buffer_pool,
 static const gchar **
 gst_gl_buffer_pool_get_options (GstBufferPool * pool)
 {
-  static const gchar *options[] = { GST_BUFFER_POOL_OPTION_VIDEO_META, NULL
+  static const gchar *options[] = { GST_BUFFER_POOL_OPTION_VIDEO_META,
+    GST_BUFFER_POOL_OPTION_GL_TEXTURE_ATLAS, GST_BUFFER_POOL_OPTION_GL_PLANAR,
+    NULL
   };
 
   return options;
@@ -83,8 +113,10 @@ gst_gl_buffer_pool_set_config (GstBufferPool * pool, GstStructure * config)
   GstCaps *caps;
   GstAllocator *allocator;
   GstAllocationParams alloc_params;
+  guint max_buffers;
 
-  if (!gst_buffer_pool_config_get_params (config, &caps, NULL, NULL, NULL))
+  if (!gst_buffer_pool_config_get_params (config, &caps, NULL, NULL,
+          &max_buffers))
     goto wrong_config;
 
   if (caps == NULL)
@@ -116,8 +148,30 @@ gst_gl_buffer_pool_set_config (GstBufferPool * pool, GstStructure * config)
   priv->caps = gst_caps_ref (caps);
   priv->info = info;
 
+  if (!gst_buffer_pool_config_get_gl_texture_format (config,
+          &priv->tex_format))
+    priv->tex_format =
+        gst_gl_context_get_texture_format (glpool->context, &info);
+  GST_DEBUG_OBJECT (pool, "using texture format 0x%x", priv->tex_format);
+
   priv->add_videometa = gst_buffer_pool_config_has_option (config,
       GST_BUFFER_POOL_OPTION_VIDEO_META);
+  /* separate plane memories are only usable through the video meta */
+  priv->want_planar = priv->add_videometa
+      && gst_buffer_pool_config_has_option (config,
+      GST_BUFFER_POOL_OPTION_GL_PLANAR);
+
+  /* the atlas is sized for the new configuration on the next allocation */
+  if (priv->atlas) {
+    gst_gl_texture_atlas_unref (priv->atlas);
+    priv->atlas = NULL;
+  }
+  priv->want_atlas = priv->tex_format == GL_RGBA8
+      && GST_VIDEO_INFO_WIDTH (&info) * GST_VIDEO_INFO_HEIGHT (&info) <=
+      GST_GL_TEXTURE_ATLAS_MAX_SLOT_PIXELS
+      && gst_buffer_pool_config_has_option (config,
+      GST_BUFFER_POOL_OPTION_GL_TEXTURE_ATLAS);
+  priv->atlas_slots = max_buffers > 0 ? max_buffers : DEFAULT_ATLAS_SLOTS;
 
   return GST_BUFFER_POOL_CLASS (parent_class)->set_config (pool, config);
 
@@ -160,6 +214,8 @@ gst_gl_buffer_pool_alloc (GstBufferPool * pool, GstBuffer ** buffer,
   GstVideoInfo *info;
   GstBuffer *buf;
   GstMemory *gl_mem;
+  GstGLTextureAtlas *atlas = NULL;
+  gboolean create_atlas;
 
   info = &priv->info;
 
@@ -167,7 +223,49 @@ gst_gl_buffer_pool_alloc (GstBufferPool * pool, GstBuffer ** buffer,
     goto no_buffer;
   }
 
-  if (!(gl_mem = gst_gl_memory_alloc (glpool->context, priv->info)))
+  if (priv->want_planar) {
+    if (gst_gl_memory_setup_buffer (glpool->context, info, buf)) {
+      GST_LOG_OBJECT (pool, "allocated planar buffer %p", buf);
+      *buffer = buf;
+      return GST_FLOW_OK;
+    }
+    /* not a planar format, use a single RGBA texture */
+    priv->want_planar = FALSE;
+  }
+
+  /* buffers can be allocated from several threads.  Creating the atlas
+   * waits for the GL thread so it is done without the lock, and the first
+   * atlas installed is the one used */
+  GST_OBJECT_LOCK (pool);
+  create_atlas = priv->want_atlas && !priv->atlas;
+  GST_OBJECT_UNLOCK (pool);
+
+  if (create_atlas)
+    atlas = gst_gl_texture_atlas_new (glpool->context,
+        GST_VIDEO_INFO_WIDTH (info), GST_VIDEO_INFO_HEIGHT (info),
+        priv->atlas_slots);
+
+  gl_mem = NULL;
+  GST_OBJECT_LOCK (pool);
+  if (create_atlas && !priv->atlas) {
+    priv->atlas = atlas;
+    atlas = NULL;
+    /* don't try again for every buffer */
+    if (!priv->atlas)
+      priv->want_atlas = FALSE;
+  }
+  if (priv->atlas)
+    gl_mem = gst_gl_memory_alloc_from_atlas (priv->atlas, priv->info);
+  GST_OBJECT_UNLOCK (pool);
+
+  /* another thread installed its atlas first */
+  if (atlas)
+    gst_gl_texture_atlas_unref (atlas);
+  /* full atlas */
+  if (!gl_mem)
+    gl_mem = gst_gl_memory_alloc_with_format (glpool->context, priv->info,
+        priv->tex_format);
+  if (!gl_mem)
     goto mem_create_failed;
   gst_buffer_append_memory (buf, gl_mem);
 
@@ -200,6 +298,64 @@ mem_create_failed:
   }
 }
 
+/**
+ * gst_buffer_pool_config_set_gl_texture_format:
+ * @config: a buffer pool config
+ * @tex_format: the internal format of the textures, e.g. GL_RGB10_A2
+ *
+ * Makes a #GstGLBufferPool allocate its textures with @tex_format instead
+ * of the format picked from the caps.
+ */
+void
+gst_buffer_pool_config_set_gl_texture_format (GstStructure * config,
+    guint tex_format)
+{
+  g_return_if_fail (config != NULL);
+
+  gst_structure_set (config, GL_TEXTURE_FORMAT_FIELD, G_TYPE_UINT, tex_format,
+      NULL);
+}
+
+/**
+ * gst_buffer_pool_config_get_gl_texture_format:
+ * @config: a buffer pool config
+ * @tex_format: (out): the internal format of the textures
+ *
+ * Returns: %TRUE if a texture format was set in @config with
+ * gst_buffer_pool_config_set_gl_texture_format()
+ */
+gboolean
+gst_buffer_pool_config_get_gl_texture_format (GstStructure * config,
+    guint * tex_format)
+{
+  g_return_val_if_fail (config != NULL, FALSE);
+
+  return gst_structure_get_uint (config, GL_TEXTURE_FORMAT_FIELD, tex_format)
+      && *tex_format != 0;
+}
+
+static void
+gst_gl_buffer_pool_release_buffer (GstBufferPool * pool, GstBuffer * buffer)
+{
+  guint i, n;
+
+  /* a copy of @buffer still references the textures, drop the buffer
+   * instead of handing them out for writing again */
+  n = gst_buffer_n_memory (buffer);
+  for (i = 0; i < n; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, i);
+
+    if (!gst_memory_is_writable (mem)) {
+      GST_LOG_OBJECT (pool, "memory %p of buffer %p is still shared, "
+          "not reusing it", mem, buffer);
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+      break;
+    }
+  }
+
+  GST_BUFFER_POOL_CLASS (parent_class)->release_buffer (pool, buffer);
+}
+
 /**
  * gst_gl_buffer_pool_new:
  * @display: the #GstGLDisplay to use
@@ -233,6 +389,7 @@ gst_gl_buffer_pool_class_init (GstGLBufferPoolClass * klass)
   gstbufferpool_class->get_options = gst_gl_buffer_pool_get_options;
   gstbufferpool_class->set_config = gst_gl_buffer_pool_set_config;
   gstbufferpool_class->alloc_buffer = gst_gl_buffer_pool_alloc;
+  gstbufferpool_class->release_buffer = gst_gl_buffer_pool_release_buffer;
 }
 
 static void
@@ -265,5 +422,8 @@ gst_gl_buffer_pool_finalize (GObject * object)
   if (priv->caps)
     gst_caps_unref (priv->caps);
 
+  if (priv->atlas)
+    gst_gl_texture_atlas_unref (priv->atlas);
+
   G_OBJECT_CLASS (gst_gl_buffer_pool_parent_class)->finalize (object);
 }
@@ -33,6 +33,32 @@ typedef struct _GstGLBufferPool GstGLBufferPool;
 typedef struct _GstGLBufferPoolClass GstGLBufferPoolClass;
 typedef struct _GstGLBufferPoolPrivate GstGLBufferPoolPrivate;
 
+/**
+ * GST_BUFFER_POOL_OPTION_GL_TEXTURE_ATLAS:
+ *
+ * An option that can be activated on a #GstGLBufferPool to allocate the
+ * #GstGLMemory of its buffers from a shared #GstGLTextureAtlas.  It is
+ * ignored for frames larger than #GST_GL_TEXTURE_ATLAS_MAX_SLOT_PIXELS.
+ */
+#define GST_BUFFER_POOL_OPTION_GL_TEXTURE_ATLAS "GstBufferPoolOptionGLTextureAtlas"
+
+/**
+ * GST_GL_TEXTURE_ATLAS_MAX_SLOT_PIXELS:
+ *
+ * The largest frame, in pixels, that #GST_BUFFER_POOL_OPTION_GL_TEXTURE_ATLAS
+ * allocates from an atlas.  Larger frames get a texture of their own.
+ */
+#define GST_GL_TEXTURE_ATLAS_MAX_SLOT_PIXELS (320 * 240)
+
+/**
+ * GST_BUFFER_POOL_OPTION_GL_PLANAR:
+ *
+ * An option that can be activated on a #GstGLBufferPool to store each plane
+ * of planar YUV formats in its own #GstGLMemory, see
+ * gst_gl_memory_setup_buffer().  Requires #GST_BUFFER_POOL_OPTION_VIDEO_META.
+ */
+#define GST_BUFFER_POOL_OPTION_GL_PLANAR "GstBufferPoolOptionGLPlanar"
+
 /* buffer pool functions */
 GType gst_gl_buffer_pool_get_type (void);
 #define GST_TYPE_GL_BUFFER_POOL      (gst_gl_buffer_pool_get_type())
@@ -66,6 +92,11 @@ struct _GstGLBufferPoolClass
 
 GstBufferPool *gst_gl_buffer_pool_new (GstGLContext * context);
 
+void     gst_buffer_pool_config_set_gl_texture_format (GstStructure * config,
+                                                       guint tex_format);
+gboolean gst_buffer_pool_config_get_gl_texture_format (GstStructure * config,
+                                                       guint * tex_format);
+
 G_END_DECLS
 
 #endif /* _GST_GL_BUFFER_POOL_H_ */
@@ -44,6 +44,8 @@
 
 #include "gl.h"
 #include "gstglcontext.h"
+#include "gstgldisplay_private.h"
+#include "gstglutils_private.h"
 
 #if GST_GL_HAVE_PLATFORM_GLX
 #include "x11/gstglcontext_glx.h"
@@ -93,6 +95,9 @@ struct _GstGLContextPrivate
   GstGLContext *other_context;
   GstGLAPI gl_api;
   GError **error;
+
+  /* set of the GL extension names */
+  GHashTable *extensions;
 };
 
 typedef struct
@@ -301,6 +306,11 @@ gst_gl_context_finalize (GObject * object)
 
   gst_object_unref (context->priv->display);
 
+  if (context->priv->extensions) {
+    g_hash_table_unref (context->priv->extensions);
+    context->priv->extensions = NULL;
+  }
+
   if (context->gl_vtable) {
     g_slice_free (GstGLFuncs, context->gl_vtable);
     context->gl_vtable = NULL;
@@ -508,6 +518,10 @@ gst_gl_context_get_window (GstGLContext * context)
  * @other_context as a context to share shareable OpenGL objects with.  See the
  * OpenGL specification for what is shared between contexts.
  *
+ * When @other_context is %NULL, the new context shares with the other
+ * contexts created on the same #GstGLDisplay if the platform allows it, so
+ * that textures can be used by all the elements of a pipeline.
+ *
  * If an error occurs, and @error is not %NULL, then error will contain details
  * of the error and %FALSE will be returned.
  *
@@ -652,20 +666,46 @@ _unlock_create_thread (GstGLContext * context)
   g_mutex_unlock (&context->priv->render_lock);
 }
 
-static gchar *
-_build_extension_string (GstGLContext * context)
+static GHashTable *
+_build_extension_set (GstGLContext * context)
 {
   const GstGLFuncs *gl = context->gl_vtable;
-  GString *exts = g_string_sized_new (1024);
+  GHashTable *exts;
   int i, n;
 
+  /* GL core contexts and GLES3 */
+  if (!gl->GetIntegerv || !gl->GetStringi)
+    return _gst_gl_feature_parse_extensions ((const gchar *)
+        gl->GetString (GL_EXTENSIONS));
+
+  exts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
   gl->GetIntegerv (GL_NUM_EXTENSIONS, &n);
 
-  for (i = 0; i < n; i++) {
-    g_string_append_printf (exts, "%s ", gl->GetStringi (GL_EXTENSIONS, i));
-  }
+  for (i = 0; i < n; i++)
+    g_hash_table_add (exts,
+        g_strdup ((const gchar *) gl->GetStringi (GL_EXTENSIONS, i)));
+
+  return exts;
+}
 
-  return exts->str;
+/* identifies the driver configuration whose entry points and extensions
+ * may be shared through the display */
+static gchar *
+_build_features_key (GstGLContext * context)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+  gchar *api_s, *ret;
+
+  api_s = gst_gl_api_to_string (gst_gl_context_get_gl_api (context));
+  ret = g_strdup_printf ("%s|%u|%s|%s|%s", api_s,
+      gst_gl_context_get_gl_platform (context),
+      (const gchar *) gl->GetString (GL_VENDOR),
+      (const gchar *) gl->GetString (GL_RENDERER),
+      (const gchar *) gl->GetString (GL_VERSION));
+  g_free (api_s);
+
+  return ret;
 }
 
 //gboolean
@@ -683,9 +723,12 @@ gst_gl_context_create_thread (GstGLContext * context)
   gchar *api_string;
   gchar *compiled_api_s;
   gchar *user_api_string;
-  const gchar *user_choice, *extensions;
+  const gchar *user_choice;
+  gchar *features_key;
   GError **error;
   GstGLContext *other_context;
+  GstGLContext *share_context;
+  gboolean created;
 
   g_mutex_lock (&context->priv->render_lock);
 
@@ -731,8 +774,25 @@ gst_gl_context_create_thread (GstGLContext * context)
   GST_INFO ("Attempting to create opengl context. user chosen api(s) (%s), "
       "compiled api support (%s)", user_api_string, compiled_api_s);
 
-  if (!context_class->create_context (context, compiled_api & user_api,
-          other_context, error)) {
+  share_context = other_context ? gst_object_ref (other_context) :
+      _gst_gl_display_get_share_context (display);
+
+  created = context_class->create_context (context, compiled_api & user_api,
+      share_context, error);
+
+  /* the display's context may not be compatible with this one */
+  if (!created && share_context && share_context != other_context) {
+    GST_INFO ("could not share with %" GST_PTR_FORMAT ", retrying without "
+        "sharing", share_context);
+    g_clear_error (error);
+    created = context_class->create_context (context, compiled_api & user_api,
+        NULL, error);
+  }
+
+  if (share_context)
+    gst_object_unref (share_context);
+
+  if (!created) {
     g_assert (error == NULL || *error != NULL);
     g_free (compiled_api_s);
     g_free (user_api_string);
@@ -791,14 +851,20 @@ gst_gl_context_create_thread (GstGLContext * context)
   if (!ret)
     goto failure;
 
-  /* GL core contexts and GLES3 */
-  if (gl->GetIntegerv && gl->GetStringi) {
-    extensions = _build_extension_string (context);
-  } else {
-    extensions = (const gchar *) gl->GetString (GL_EXTENSIONS);
+  features_key = _build_features_key (context);
+  if (!_gst_gl_display_lookup_features (display, features_key, gl,
+          &context->priv->extensions)) {
+    context->priv->extensions = _build_extension_set (context);
+
+    _gst_gl_feature_check_ext_functions (context, gl_major, gl_minor,
+        context->priv->extensions);
+
+    _gst_gl_display_add_features (display, features_key, gl,
+        context->priv->extensions);
   }
+  g_free (features_key);
 
-  _gst_gl_feature_check_ext_functions (context, gl_major, gl_minor, extensions);
+  _gst_gl_display_set_share_context (display, context);
 
   context->priv->alive = TRUE;
 
@@ -816,6 +882,8 @@ gst_gl_context_create_thread (GstGLContext * context)
 
   context->priv->alive = FALSE;
 
+  _gst_gl_context_free_geometry (context);
+
   context_class->activate (context, FALSE);
 
   context_class->destroy_context (context);
@@ -866,6 +934,99 @@ gst_gl_context_get_gl_context (GstGLContext * context)
   return result;
 }
 
+/**
+ * gst_gl_context_get_buffer_age:
+ * @context: a #GstGLContext:
+ *
+ * Gets the number of swaps since the contents of the back buffer of
+ * @context were presented, as given by the EGL_EXT_buffer_age or
+ * GLX_EXT_buffer_age extensions.  A caller that knows what it drew in the
+ * last frames can skip redrawing what did not change since then.
+ *
+ * Should be called in the GL thread, before drawing the next frame.
+ *
+ * Returns: the age of the back buffer or 0 if its contents are unknown
+ */
+gint
+gst_gl_context_get_buffer_age (GstGLContext * context)
+{
+  GstGLContextClass *context_class;
+
+  g_return_val_if_fail (GST_GL_IS_CONTEXT (context), 0);
+  context_class = GST_GL_CONTEXT_GET_CLASS (context);
+
+  if (!context_class->get_buffer_age)
+    return 0;
+
+  return context_class->get_buffer_age (context);
+}
+
+/**
+ * gst_gl_context_swap_buffers_with_damage:
+ * @context: a #GstGLContext:
+ * @rects: (allow-none) (array length=n_rects): x, y, width and height of
+ *         each damaged rectangle with the origin in the bottom left corner
+ * @n_rects: the number of rectangles in @rects
+ *
+ * Presents the back buffer of @context, hinting the window system that
+ * only @rects changed since the last swap where EGL_KHR_swap_buffers_with_damage
+ * or EGL_EXT_swap_buffers_with_damage is available.  With no rectangles
+ * the whole surface is presented, like a plain swap.
+ *
+ * Should be called in the GL thread.
+ */
+void
+gst_gl_context_swap_buffers_with_damage (GstGLContext * context,
+    const gint * rects, guint n_rects)
+{
+  GstGLContextClass *context_class;
+
+  g_return_if_fail (GST_GL_IS_CONTEXT (context));
+  g_return_if_fail (rects != NULL || n_rects == 0);
+  context_class = GST_GL_CONTEXT_GET_CLASS (context);
+
+  if (n_rects > 0 && context_class->swap_buffers_with_damage)
+    context_class->swap_buffers_with_damage (context, rects, n_rects);
+  else if (context_class->swap_buffers)
+    context_class->swap_buffers (context);
+}
+
+/**
+ * gst_gl_context_get_sync_values:
+ * @context: a #GstGLContext:
+ * @ust: (out): the time of the last vertical blank, in microseconds
+ * @msc: (out): the number of vertical blanks of the output
+ * @sbc: (out): the number of swaps of @context that completed
+ *
+ * Gets the state of the output of @context, as given by the
+ * GLX_OML_sync_control or EGL_CHROMIUM_sync_control extensions.  The time
+ * at which a swap was presented is the time of the first vertical blank
+ * after it was issued at which @sbc counts it.
+ *
+ * The extensions do not say which clock @ust is on.  Mesa and the X
+ * drivers use the monotonic clock of g_get_monotonic_time() but callers
+ * comparing @ust with it should check that it is close to the current time.
+ *
+ * Should be called in the GL thread.
+ *
+ * Returns: whether the values could be queried
+ */
+gboolean
+gst_gl_context_get_sync_values (GstGLContext * context, gint64 * ust,
+    gint64 * msc, gint64 * sbc)
+{
+  GstGLContextClass *context_class;
+
+  g_return_val_if_fail (GST_GL_IS_CONTEXT (context), FALSE);
+  g_return_val_if_fail (ust != NULL && msc != NULL && sbc != NULL, FALSE);
+  context_class = GST_GL_CONTEXT_GET_CLASS (context);
+
+  if (!context_class->get_sync_values)
+    return FALSE;
+
+  return context_class->get_sync_values (context, ust, msc, sbc);
+}
+
 /**
  * gst_gl_context_get_gl_platform:
  * @context: a #GstGLContext:
@@ -900,6 +1061,29 @@ gst_gl_context_get_display (GstGLContext * context)
   return gst_object_ref (context->priv->display);
 }
 
+/**
+ * gst_gl_context_check_feature:
+ * @context: a #GstGLContext
+ * @feature: a GL extension name, e.g. "GL_ARB_texture_rg"
+ *
+ * Looks up @feature in the extensions advertised by @context.  This is a
+ * single hash lookup and may be called from any thread once @context has
+ * been created.
+ *
+ * Returns: whether @feature is supported by @context
+ */
+gboolean
+gst_gl_context_check_feature (GstGLContext * context, const gchar * feature)
+{
+  g_return_val_if_fail (GST_GL_IS_CONTEXT (context), FALSE);
+  g_return_val_if_fail (feature != NULL, FALSE);
+
+  if (!context->priv->extensions)
+    return FALSE;
+
+  return g_hash_table_contains (context->priv->extensions, feature);
+}
+
 typedef struct
 {
   GstGLContext *context;
@@ -103,9 +103,14 @@ struct _GstGLContextClass {
                                        GstGLContext *other_context, GError ** error);
   void          (*destroy_context)    (GstGLContext *context);
   void          (*swap_buffers)       (GstGLContext *context);
+  gint          (*get_buffer_age)     (GstGLContext *context);
+  void          (*swap_buffers_with_damage) (GstGLContext *context,
+                                       const gint *rects, guint n_rects);
+  gboolean      (*get_sync_values)    (GstGLContext *context, gint64 *ust,
+                                       gint64 *msc, gint64 *sbc);
 
   /*< private >*/
-  gpointer _reserved[GST_PADDING];
+  gpointer _reserved[GST_PADDING - 3];
 };
 
 /* methods */
@@ -126,6 +131,16 @@ guintptr      gst_gl_context_get_gl_context   (GstGLContext *context);
 
 gboolean      gst_gl_context_create           (GstGLContext *context, GstGLContext *other_context, GError ** error);
 
+gboolean      gst_gl_context_check_feature    (GstGLContext *context, const gchar *feature);
+
+gint          gst_gl_context_get_buffer_age   (GstGLContext *context);
+void          gst_gl_context_swap_buffers_with_damage (GstGLContext *context,
+                                                       const gint *rects,
+                                                       guint n_rects);
+gboolean      gst_gl_context_get_sync_values  (GstGLContext *context,
+                                               gint64 *ust, gint64 *msc,
+                                               gint64 *sbc);
+
 gpointer      gst_gl_context_default_get_proc_address (GstGLContext *context, const gchar *name);
 
 gboolean      gst_gl_context_set_window (GstGLContext *context, GstGLWindow *window);
@@ -36,8 +36,11 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include "gl.h"
 #include "gstgldisplay.h"
+#include "gstgldisplay_private.h"
 
 #if GST_GL_HAVE_WINDOW_X11
 #include <gst/gl/x11/gstgldisplay_x11.h>
@@ -62,9 +65,29 @@ static guintptr gst_gl_display_default_get_handle (GstGLDisplay * display);
 
 struct _GstGLDisplayPrivate
 {
-  gint dummy;
+  /* GstGLDisplayFeatures keyed by the api, platform and driver strings of
+   * the contexts that resolved them, with OBJECT_LOCK */
+  GHashTable *features;
+
+  /* the GstGLContext new contexts share their objects with when they are
+   * not given another context to share with */
+  GWeakRef share_context;
 };
 
+/* what context creation resolved for one driver configuration */
+typedef struct
+{
+  GstGLFuncs vtable;
+  GHashTable *extensions;
+} GstGLDisplayFeatures;
+
+static void
+_free_features (GstGLDisplayFeatures * features)
+{
+  g_hash_table_unref (features->extensions);
+  g_slice_free (GstGLDisplayFeatures, features);
+}
+
 static void
 gst_gl_display_class_init (GstGLDisplayClass * klass)
 {
@@ -79,6 +102,9 @@ static void
 gst_gl_display_init (GstGLDisplay * display)
 {
   display->priv = GST_GL_DISPLAY_GET_PRIVATE (display);
+  display->priv->features = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, (GDestroyNotify) _free_features);
+  g_weak_ref_init (&display->priv->share_context, NULL);
 
   display->gl_api = GST_GL_API_ANY;
   display->type = GST_GL_DISPLAY_TYPE_ANY;
@@ -98,6 +124,9 @@ gst_gl_display_finalize (GObject * object)
     display->context = NULL;
   }
 
+  g_hash_table_destroy (display->priv->features);
+  g_weak_ref_clear (&display->priv->share_context);
+
   GST_TRACE ("finalize %p", object);
 
   G_OBJECT_CLASS (gst_gl_display_parent_class)->finalize (object);
@@ -165,6 +194,48 @@ gst_gl_display_default_get_handle (GstGLDisplay * display)
   return 0;
 }
 
+/* Contexts created on the same display for the same driver resolve exactly
+ * the same entry points and extensions, so only the first one pays for the
+ * lookups and later ones copy the result from here.
+ *
+ * fills @vtable and @extensions (transfer full) from the cache */
+gboolean
+_gst_gl_display_lookup_features (GstGLDisplay * display, const gchar * key,
+    GstGLFuncs * vtable, GHashTable ** extensions)
+{
+  GstGLDisplayFeatures *features;
+
+  GST_OBJECT_LOCK (display);
+  features = g_hash_table_lookup (display->priv->features, key);
+  if (features) {
+    memcpy (vtable, &features->vtable, sizeof (GstGLFuncs));
+    *extensions = g_hash_table_ref (features->extensions);
+  }
+  GST_OBJECT_UNLOCK (display);
+
+  GST_DEBUG_OBJECT (display, "feature cache %s for %s",
+      features ? "hit" : "miss", key);
+
+  return features != NULL;
+}
+
+void
+_gst_gl_display_add_features (GstGLDisplay * display, const gchar * key,
+    const GstGLFuncs * vtable, GHashTable * extensions)
+{
+  GstGLDisplayFeatures *features;
+
+  GST_OBJECT_LOCK (display);
+  /* another context may have raced us here, both results are the same */
+  if (!g_hash_table_contains (display->priv->features, key)) {
+    features = g_slice_new (GstGLDisplayFeatures);
+    memcpy (&features->vtable, vtable, sizeof (GstGLFuncs));
+    features->extensions = g_hash_table_ref (extensions);
+    g_hash_table_insert (display->priv->features, g_strdup (key), features);
+  }
+  GST_OBJECT_UNLOCK (display);
+}
+
 /**
  * gst_context_set_gl_display:
  * @context: a #GstContext
@@ -212,3 +283,35 @@ gst_context_get_gl_display (GstContext * context, GstGLDisplay ** display)
 
   return ret;
 }
+
+/* All the contexts of a display end up in the same share group so that
+ * textures can be passed between elements that did not find each other's
+ * context, like the sinks after a tee.
+ *
+ * Returns: (transfer full): the context to share with or %NULL */
+GstGLContext *
+_gst_gl_display_get_share_context (GstGLDisplay * display)
+{
+  return (GstGLContext *) g_weak_ref_get (&display->priv->share_context);
+}
+
+/* sets @context as the context to share with unless the display already
+ * has one that is still around */
+void
+_gst_gl_display_set_share_context (GstGLDisplay * display,
+    GstGLContext * context)
+{
+  GstGLContext *share_context;
+
+  GST_OBJECT_LOCK (display);
+  share_context = g_weak_ref_get (&display->priv->share_context);
+  if (!share_context) {
+    GST_DEBUG_OBJECT (display, "sharing new contexts with %" GST_PTR_FORMAT,
+        context);
+    g_weak_ref_set (&display->priv->share_context, context);
+  }
+  GST_OBJECT_UNLOCK (display);
+
+  if (share_context)
+    gst_object_unref (share_context);
+}
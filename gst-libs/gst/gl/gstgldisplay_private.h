@@ -0,0 +1,45 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_GL_DISPLAY_PRIVATE_H__
+#define __GST_GL_DISPLAY_PRIVATE_H__
+
+#include <gst/gl/gstgldisplay.h>
+
+G_BEGIN_DECLS
+
+/* not installed, only used inside the library */
+
+gboolean _gst_gl_display_lookup_features (GstGLDisplay * display,
+                                          const gchar * key,
+                                          GstGLFuncs * vtable,
+                                          GHashTable ** extensions);
+void     _gst_gl_display_add_features    (GstGLDisplay * display,
+                                          const gchar * key,
+                                          const GstGLFuncs * vtable,
+                                          GHashTable * extensions);
+
+GstGLContext * _gst_gl_display_get_share_context (GstGLDisplay * display);
+void           _gst_gl_display_set_share_context (GstGLDisplay * display,
+                                                  GstGLContext * context);
+
+G_END_DECLS
+
+#endif /* __GST_GL_DISPLAY_PRIVATE_H__ */
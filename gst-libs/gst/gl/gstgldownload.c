@@ -65,11 +65,13 @@ static void _do_download_draw_yuv_gles2 (GstGLContext * context,
 
 /* *INDENT-OFF* */
 
+/* matrix and range of the colorimetry of the output, from
+ * gst_gl_get_rgb_to_yuv_coefficients() */
 #define RGB_TO_YUV_COEFFICIENTS \
-      "const vec3 offset = vec3(0.0625, 0.5, 0.5);\n" \
-      "const vec3 ycoeff = vec3(0.256816, 0.504154, 0.0979137);\n" \
-      "const vec3 ucoeff = vec3(-0.148246, -0.29102, 0.439266);\n" \
-      "const vec3 vcoeff = vec3(0.439271, -0.367833, -0.071438);\n"
+      "uniform vec3 offset;\n" \
+      "uniform vec3 ycoeff;\n" \
+      "uniform vec3 ucoeff;\n" \
+      "uniform vec3 vcoeff;\n"
 #if GST_GL_HAVE_OPENGL
 /* YUY2:y2,u,y1,v
    UYVY:v,y1,u,y2 */
@@ -231,6 +233,13 @@ struct _GstGLDownloadPrivate
   void (*do_yuv) (GstGLContext * context, GstGLDownload * download);
 
   gboolean result;
+
+  /* RGB to YUV conversion of the output colorimetry */
+  gfloat yuv_offset[3];
+  gfloat yuv_coeffs[9];
+
+  /* frame sized copy of atlas memories */
+  GLuint tex_id;
 };
 
 GST_DEBUG_CATEGORY_STATIC (gst_gl_download_debug);
@@ -326,6 +335,13 @@ gst_gl_download_finalize (GObject * object)
 
   download = GST_GL_DOWNLOAD (object);
 
+  if (download->priv->tex_id) {
+    if (download->in_texture == download->priv->tex_id)
+      download->in_texture = 0;
+    gst_gl_context_del_texture (download->context, &download->priv->tex_id);
+    download->priv->tex_id = 0;
+  }
+
   for (i = 0; i < GST_VIDEO_MAX_PLANES; i++) {
     if (download->out_texture[i]) {
       gst_gl_context_del_texture (download->context, &download->out_texture[i]);
@@ -366,6 +382,8 @@ gst_gl_download_finalize (GObject * object)
  * @out_height: the height to download to
  *
  * Initializes @download with the information required for download.
+ * YUV formats are converted with the default colorimetry for their size,
+ * see gst_gl_download_init_format_full().
  *
  * Returns: whether the initialization was successful
  */
@@ -374,12 +392,38 @@ gst_gl_download_init_format (GstGLDownload * download, GstVideoFormat v_format,
     guint out_width, guint out_height)
 {
   GstVideoInfo info;
-  gboolean ret;
 
-  g_return_val_if_fail (download != NULL, FALSE);
   g_return_val_if_fail (v_format != GST_VIDEO_FORMAT_UNKNOWN, FALSE);
   g_return_val_if_fail (v_format != GST_VIDEO_FORMAT_ENCODED, FALSE);
-  g_return_val_if_fail (out_width > 0 && out_height > 0, FALSE);
+
+  gst_video_info_set_format (&info, v_format, out_width, out_height);
+
+  return gst_gl_download_init_format_full (download, &info);
+}
+
+/**
+ * gst_gl_download_init_format_full:
+ * @download: a #GstGLDownload
+ * @info: the #GstVideoInfo to download to
+ *
+ * Initializes @download with the information required for download.  YUV
+ * formats are converted with the matrix and range of the colorimetry of
+ * @info.
+ *
+ * Returns: whether the initialization was successful
+ */
+gboolean
+gst_gl_download_init_format_full (GstGLDownload * download,
+    GstVideoInfo * info)
+{
+  gboolean ret;
+
+  g_return_val_if_fail (download != NULL, FALSE);
+  g_return_val_if_fail (info != NULL, FALSE);
+  g_return_val_if_fail (GST_VIDEO_INFO_FORMAT (info) !=
+      GST_VIDEO_FORMAT_UNKNOWN, FALSE);
+  g_return_val_if_fail (GST_VIDEO_INFO_WIDTH (info) > 0
+      && GST_VIDEO_INFO_HEIGHT (info) > 0, FALSE);
 
   g_mutex_lock (&download->lock);
 
@@ -388,9 +432,7 @@ gst_gl_download_init_format (GstGLDownload * download, GstVideoFormat v_format,
     return FALSE;
   }
 
-  gst_video_info_set_format (&info, v_format, out_width, out_height);
-
-  download->info = info;
+  download->info = *info;
 
   gst_gl_context_thread_add (download->context,
       (GstGLContextThreadFunc) _init_download, download);
@@ -416,6 +458,7 @@ gst_gl_download_perform_with_memory (GstGLDownload * download,
     GstGLMemory * gl_mem)
 {
   gpointer data[GST_VIDEO_MAX_PLANES];
+  GLuint tex_id;
   guint i;
   gboolean ret;
 
@@ -433,9 +476,25 @@ gst_gl_download_perform_with_memory (GstGLDownload * download,
         GST_VIDEO_INFO_PLANE_OFFSET (&download->info, i);
   }
 
-  ret =
-      _gst_gl_download_perform_with_data_unlocked (download, gl_mem->tex_id,
-      data);
+  tex_id = gl_mem->tex_id;
+
+  if (gl_mem->atlas) {
+    /* only read back the memory's slot of the atlas */
+    if (!download->priv->tex_id)
+      gst_gl_context_gen_texture (download->context, &download->priv->tex_id,
+          GST_VIDEO_INFO_FORMAT (&download->info),
+          GST_VIDEO_INFO_WIDTH (&download->info),
+          GST_VIDEO_INFO_HEIGHT (&download->info));
+
+    if (!gst_gl_memory_copy_into_texture (gl_mem, download->priv->tex_id)) {
+      g_mutex_unlock (&download->lock);
+      return FALSE;
+    }
+
+    tex_id = download->priv->tex_id;
+  }
+
+  ret = _gst_gl_download_perform_with_data_unlocked (download, tex_id, data);
 
   if (ret)
     GST_GL_MEMORY_FLAG_UNSET (gl_mem, GST_GL_MEMORY_FLAG_NEED_DOWNLOAD);
@@ -517,6 +576,9 @@ _init_download (GstGLContext * context, GstGLDownload * download)
   GST_TRACE ("initializing texture download for format %s",
       gst_video_format_to_string (v_format));
 
+  gst_gl_get_rgb_to_yuv_coefficients (&download->info,
+      download->priv->yuv_offset, download->priv->yuv_coeffs);
+
   if (USING_OPENGL (context)) {
     switch (v_format) {
       case GST_VIDEO_FORMAT_RGBx:
@@ -906,6 +968,19 @@ _do_download (GstGLContext * context, GstGLDownload * download)
   download->priv->result = TRUE;
 }
 
+/* called by the yuv draw functions (in the gl thread) */
+static void
+_set_yuv_uniforms (GstGLDownload * download)
+{
+  gfloat *coeffs = download->priv->yuv_coeffs;
+
+  gst_gl_shader_set_uniform_3fv (download->shader, "offset", 1,
+      download->priv->yuv_offset);
+  gst_gl_shader_set_uniform_3fv (download->shader, "ycoeff", 1, &coeffs[0]);
+  gst_gl_shader_set_uniform_3fv (download->shader, "ucoeff", 1, &coeffs[3]);
+  gst_gl_shader_set_uniform_3fv (download->shader, "vcoeff", 1, &coeffs[6]);
+}
+
 #if GST_GL_HAVE_OPENGL
 static void
 _do_download_draw_rgb_opengl (GstGLContext * context, GstGLDownload * download)
@@ -1121,6 +1196,7 @@ _do_download_draw_yuv_opengl (GstGLContext * context, GstGLDownload * download)
       gl->Clear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
       gst_gl_shader_use (download->shader);
+      _set_yuv_uniforms (download);
 
       gl->MatrixMode (GL_PROJECTION);
       gl->LoadIdentity ();
@@ -1141,6 +1217,7 @@ _do_download_draw_yuv_opengl (GstGLContext * context, GstGLDownload * download)
       gl->Clear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
       gst_gl_shader_use (download->shader);
+      _set_yuv_uniforms (download);
 
       gl->MatrixMode (GL_PROJECTION);
       gl->LoadIdentity ();
@@ -1309,6 +1386,7 @@ _do_download_draw_yuv_gles2 (GstGLContext * context, GstGLDownload * download)
       gl->Clear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
       gst_gl_shader_use (download->shader);
+      _set_yuv_uniforms (download);
 
       gl->VertexAttribPointer (download->shader_attr_position_loc, 3,
           GL_FLOAT, GL_FALSE, 5 * sizeof (GLfloat), vVertices);
@@ -1331,6 +1409,7 @@ _do_download_draw_yuv_gles2 (GstGLContext * context, GstGLDownload * download)
       gl->Clear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
       gst_gl_shader_use (download->shader);
+      _set_yuv_uniforms (download);
 
       gl->ActiveTexture (GL_TEXTURE0);
       gst_gl_shader_set_uniform_1i (download->shader, "tex", 0);
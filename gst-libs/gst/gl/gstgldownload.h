@@ -100,6 +100,7 @@ GstGLDownload * gst_gl_download_new          (GstGLContext * context);
 
 gboolean gst_gl_download_init_format                (GstGLDownload * download, GstVideoFormat v_format,
                                                      guint out_width, guint out_height);
+gboolean gst_gl_download_init_format_full           (GstGLDownload * download, GstVideoInfo * info);
 
 gboolean gst_gl_download_perform_with_memory        (GstGLDownload * download, GstGLMemory * gl_mem);
 gboolean gst_gl_download_perform_with_data          (GstGLDownload * download, GLuint texture_id,
@@ -51,6 +51,34 @@ gst_gl_check_extension (const char *name, const gchar * ext)
   return FALSE;
 }
 
+/* Splits a space separated extension string into a set of the names, so
+ * that every later feature test is a hash lookup instead of another scan
+ * over the whole string */
+GHashTable *
+_gst_gl_feature_parse_extensions (const gchar * extensions)
+{
+  GHashTable *set;
+  gchar **names;
+  gint i;
+
+  set = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  if (extensions == NULL)
+    return set;
+
+  names = g_strsplit (extensions, " ", -1);
+  for (i = 0; names[i]; i++) {
+    if (names[i][0] != '\0')
+      g_hash_table_add (set, names[i]);
+    else
+      g_free (names[i]);
+  }
+  /* the strings are now owned by the set */
+  g_free (names);
+
+  return set;
+}
+
 /* Define a set of arrays containing the functions required from GL
    for each feature */
 #define GST_GL_EXT_BEGIN(name,                                            \
@@ -88,8 +116,7 @@ static const GstGLFeatureData gst_gl_feature_ext_functions_data[] = {
 
 gboolean
 _gst_gl_feature_check_for_extension (const GstGLFeatureData * data,
-    const char *driver_prefix, const char *extensions_string,
-    const char **suffix)
+    const char *driver_prefix, GHashTable * extensions, const char **suffix)
 {
   const char *namespace, *namespace_suffix;
   unsigned int namespace_len;
@@ -119,7 +146,7 @@ _gst_gl_feature_check_for_extension (const GstGLFeatureData * data,
       g_string_append_c (full_extension_name, '_');
       g_string_append (full_extension_name, extension);
 
-      if (gst_gl_check_extension (full_extension_name->str, extensions_string)) {
+      if (g_hash_table_contains (extensions, full_extension_name->str)) {
         GST_TRACE ("found %s in extension string", full_extension_name->str);
         break;
       }
@@ -142,7 +169,7 @@ gboolean
 _gst_gl_feature_check (GstGLContext * context,
     const char *driver_prefix,
     const GstGLFeatureData * data,
-    int gl_major, int gl_minor, const char *extensions_string)
+    int gl_major, int gl_minor, GHashTable * extensions)
 {
   char *full_function_name = NULL;
   gboolean in_core = FALSE;
@@ -163,7 +190,7 @@ _gst_gl_feature_check (GstGLContext * context,
   } else {
     /* Otherwise try all of the extensions */
     if (!_gst_gl_feature_check_for_extension (data, driver_prefix,
-            extensions_string, &suffix))
+            extensions, &suffix))
       goto error;
   }
 
@@ -189,7 +216,7 @@ _gst_gl_feature_check (GstGLContext * context,
       GST_TRACE ("%s was not found in core, trying the extension version",
           full_function_name);
       if (!_gst_gl_feature_check_for_extension (data, driver_prefix,
-              extensions_string, &suffix)) {
+              extensions, &suffix)) {
         goto error;
       } else {
         g_free (full_function_name);
@@ -233,7 +260,7 @@ error:
 
 void
 _gst_gl_feature_check_ext_functions (GstGLContext * context,
-    int gl_major, int gl_minor, const char *gl_extensions)
+    int gl_major, int gl_minor, GHashTable * gl_extensions)
 {
   int i;
 
@@ -91,19 +91,22 @@ struct _GstGLFeatureData
 gboolean
 gst_gl_check_extension (const char *name, const gchar * ext);
 
+GHashTable *
+_gst_gl_feature_parse_extensions (const gchar * extensions);
+
 gboolean
 _gst_gl_feature_check (GstGLContext *context,
                      const char *driver_prefix,
                      const GstGLFeatureData *data,
                      int gl_major,
                      int gl_minor,
-                     const char *extensions_string);
+                     GHashTable *extensions);
 
 void
 _gst_gl_feature_check_ext_functions (GstGLContext *context,
                                    int gl_major,
                                    int gl_minor,
-                                   const char *gl_extensions);
+                                   GHashTable *gl_extensions);
 
 G_END_DECLS
 
@@ -29,6 +29,13 @@
 #define GST_CAT_DEFAULT gst_gl_filter_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
+#ifndef GL_RGB10_A2
+#define GL_RGB10_A2 0x8059
+#endif
+#ifndef GL_RGBA16F
+#define GL_RGBA16F 0x881A
+#endif
+
 
 static GstStaticPadTemplate gst_gl_filter_src_pad_template =
     GST_STATIC_PAD_TEMPLATE ("src",
@@ -54,9 +61,34 @@ static GstStaticPadTemplate gst_gl_filter_sink_pad_template =
 enum
 {
   PROP_0,
-  PROP_OTHER_CONTEXT
+  PROP_OTHER_CONTEXT,
+  PROP_TEXTURE_FORMAT
 };
 
+#define DEFAULT_TEXTURE_FORMAT 0
+
+/* the values are the internal formats given to
+ * gst_gl_context_gen_texture_full(), 0 picks one from the input caps */
+#define GST_TYPE_GL_FILTER_TEXTURE_FORMAT (gst_gl_filter_texture_format_get_type ())
+static GType
+gst_gl_filter_texture_format_get_type (void)
+{
+  static GType gl_filter_texture_format_type = 0;
+  static const GEnumValue texture_formats[] = {
+    {0, "Pick from the input format", "auto"},
+    {GL_RGBA8, "8 bits per component", "rgba8"},
+    {GL_RGB10_A2, "10 bits per color component", "rgb10a2"},
+    {GL_RGBA16F, "16 bit float per component", "rgba16f"},
+    {0, NULL, NULL}
+  };
+
+  if (!gl_filter_texture_format_type) {
+    gl_filter_texture_format_type =
+        g_enum_register_static ("GstGLFilterTextureFormat", texture_formats);
+  }
+  return gl_filter_texture_format_type;
+}
+
 #define DEBUG_INIT \
   GST_DEBUG_CATEGORY_INIT (gst_gl_filter_debug, "glfilter", 0, "glfilter element");
 #define gst_gl_filter_parent_class parent_class
@@ -89,6 +121,8 @@ static gboolean gst_gl_filter_decide_allocation (GstBaseTransform * trans,
     GstQuery * query);
 static gboolean gst_gl_filter_set_caps (GstBaseTransform * bt, GstCaps * incaps,
     GstCaps * outcaps);
+static GstFlowReturn gst_gl_filter_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * buffer);
 
 /* GstGLContextThreadFunc */
 static void gst_gl_filter_start_gl (GstGLContext * context, gpointer data);
@@ -128,6 +162,13 @@ gst_gl_filter_class_init (GstGLFilterClass * klass)
           "Give an external OpenGL context with which to share textures",
           GST_GL_TYPE_CONTEXT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_TEXTURE_FORMAT,
+      g_param_spec_enum ("texture-format", "Texture format",
+          "Internal format of the textures the filter renders into, deeper "
+          "formats avoid banding in chains of filters",
+          GST_TYPE_GL_FILTER_TEXTURE_FORMAT, DEFAULT_TEXTURE_FORMAT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&gst_gl_filter_src_pad_template));
   gst_element_class_add_pad_template (element_class,
@@ -147,6 +188,14 @@ gst_gl_filter_class_init (GstGLFilterClass * klass)
 static void
 gst_gl_filter_init (GstGLFilter * filter)
 {
+  GstPad *sinkpad = GST_BASE_TRANSFORM_SINK_PAD (filter);
+
+  filter->texture_format = DEFAULT_TEXTURE_FORMAT;
+
+  /* looks at the crop of the buffers before GstBaseTransform handles them */
+  filter->base_chain = GST_PAD_CHAINFUNC (sinkpad);
+  gst_pad_set_chain_function (sinkpad, GST_DEBUG_FUNCPTR (gst_gl_filter_chain));
+
   gst_gl_filter_reset (filter);
 }
 
@@ -164,6 +213,9 @@ gst_gl_filter_set_property (GObject * object, guint prop_id,
       filter->other_context = g_value_dup_object (value);
       break;
     }
+    case PROP_TEXTURE_FORMAT:
+      filter->texture_format = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -180,6 +232,9 @@ gst_gl_filter_get_property (GObject * object, guint prop_id,
     case PROP_OTHER_CONTEXT:
       g_value_set_object (value, filter->other_context);
       break;
+    case PROP_TEXTURE_FORMAT:
+      g_value_set_enum (value, filter->texture_format);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -257,6 +312,10 @@ gst_gl_filter_reset (GstGLFilter * filter)
     filter->display = NULL;
   }
 
+  gst_video_info_init (&filter->frame_info);
+  filter->crop_width = 0;
+  filter->crop_height = 0;
+
   filter->fbo = 0;
   filter->depthbuffer = 0;
   filter->default_shader = NULL;
@@ -320,6 +379,7 @@ static GstCaps *
 gst_gl_filter_fixate_caps (GstBaseTransform * bt,
     GstPadDirection direction, GstCaps * caps, GstCaps * othercaps)
 {
+  GstGLFilter *filter = GST_GL_FILTER (bt);
   GstStructure *ins, *outs;
   const GValue *from_par, *to_par;
   GValue fpar = { 0, }, tpar = {
@@ -384,6 +444,12 @@ gst_gl_filter_fixate_caps (GstBaseTransform * bt,
     gst_structure_get_int (ins, "width", &from_w);
     gst_structure_get_int (ins, "height", &from_h);
 
+    /* cropped frames are output at the size of their crop */
+    if (direction == GST_PAD_SINK && filter->crop_width > 0) {
+      from_w = filter->crop_width;
+      from_h = filter->crop_height;
+    }
+
     gst_structure_get_int (outs, "width", &w);
     gst_structure_get_int (outs, "height", &h);
 
@@ -696,11 +762,29 @@ gst_gl_filter_set_caps (GstBaseTransform * bt, GstCaps * incaps,
   filter = GST_GL_FILTER (bt);
   filter_class = GST_GL_FILTER_GET_CLASS (filter);
 
-  if (!gst_video_info_from_caps (&filter->in_info, incaps))
+  if (!gst_video_info_from_caps (&filter->frame_info, incaps))
     goto wrong_caps;
   if (!gst_video_info_from_caps (&filter->out_info, outcaps))
     goto wrong_caps;
 
+  /* the upload only keeps the cropped area of the frames */
+  if (filter->crop_width > 0) {
+    GstCaps *crop_caps = gst_caps_copy (incaps);
+
+    gst_caps_set_simple (crop_caps, "width", G_TYPE_INT, filter->crop_width,
+        "height", G_TYPE_INT, filter->crop_height, NULL);
+    gst_video_info_from_caps (&filter->in_info, crop_caps);
+    gst_caps_unref (crop_caps);
+  } else {
+    filter->in_info = filter->frame_info;
+  }
+
+  /* initialized again for the new sizes in decide_allocation */
+  if (filter->upload) {
+    gst_object_unref (filter->upload);
+    filter->upload = NULL;
+  }
+
   if (filter_class->set_caps) {
     if (!filter_class->set_caps (filter, incaps, outcaps))
       goto error;
@@ -723,6 +807,50 @@ error:
   }
 }
 
+/* the size of the area given by the #GstVideoCropMeta of @buffer, clamped
+ * to the frame, or 0x0 when the whole frame is used */
+static void
+gst_gl_filter_get_crop_size (GstGLFilter * filter, GstBuffer * buffer,
+    guint * width, guint * height)
+{
+  guint frame_width = GST_VIDEO_INFO_WIDTH (&filter->frame_info);
+  guint frame_height = GST_VIDEO_INFO_HEIGHT (&filter->frame_info);
+  GstVideoCropMeta *crop;
+
+  *width = *height = 0;
+
+  crop = gst_buffer_get_video_crop_meta (buffer);
+  if (!crop || crop->width == 0 || crop->height == 0
+      || crop->x >= frame_width || crop->y >= frame_height)
+    return;
+
+  *width = MIN (crop->width, frame_width - crop->x);
+  *height = MIN (crop->height, frame_height - crop->y);
+
+  if (*width == frame_width && *height == frame_height)
+    *width = *height = 0;
+}
+
+/* renegotiates the output at the size of the crop before the buffer is
+ * handled, so that cropped frames are not stretched to the full size */
+static GstFlowReturn
+gst_gl_filter_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstGLFilter *filter = GST_GL_FILTER (parent);
+  guint width, height;
+
+  gst_gl_filter_get_crop_size (filter, buffer, &width, &height);
+  if (width != filter->crop_width || height != filter->crop_height) {
+    GST_DEBUG_OBJECT (filter, "crop changed to %ux%u", width, height);
+
+    filter->crop_width = width;
+    filter->crop_height = height;
+    gst_pad_mark_reconfigure (GST_BASE_TRANSFORM_SRC_PAD (filter));
+  }
+
+  return filter->base_chain (pad, parent, buffer);
+}
+
 static gboolean
 gst_gl_filter_propose_allocation (GstBaseTransform * trans,
     GstQuery * decide_query, GstQuery * query)
@@ -786,6 +914,9 @@ gst_gl_filter_propose_allocation (GstBaseTransform * trans,
 
     config = gst_buffer_pool_get_config (pool);
     gst_buffer_pool_config_set_params (config, caps, size, 0, 0);
+    if (filter->texture_format)
+      gst_buffer_pool_config_set_gl_texture_format (config,
+          filter->texture_format);
     if (!gst_buffer_pool_set_config (pool, config))
       goto config_failed;
   }
@@ -795,6 +926,8 @@ gst_gl_filter_propose_allocation (GstBaseTransform * trans,
 
   /* we also support various metadata */
   gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, 0);
+  /* the output is negotiated at the size of the cropped area */
+  gst_query_add_allocation_meta (query, GST_VIDEO_CROP_META_API_TYPE, 0);
 
   gl_apis = gst_gl_api_to_string (gst_gl_context_get_gl_api (filter->context));
   platform =
@@ -854,9 +987,25 @@ gst_gl_filter_decide_allocation (GstBaseTransform * trans, GstQuery * query)
   GError *error = NULL;
   guint in_width, in_height, out_width, out_height;
   GstGLContext *other_context = NULL;
+  GLenum tex_format;
 
   gst_query_parse_allocation (query, &caps, NULL);
 
+  /* renegotiated, the sizes may have changed */
+  if (filter->context) {
+    if (filter->fbo)
+      gst_gl_context_del_fbo (filter->context, filter->fbo,
+          filter->depthbuffer);
+    if (filter->in_tex_id)
+      gst_gl_context_del_texture (filter->context, &filter->in_tex_id);
+    if (filter->out_tex_id)
+      gst_gl_context_del_texture (filter->context, &filter->out_tex_id);
+  }
+  filter->fbo = 0;
+  filter->depthbuffer = 0;
+  filter->in_tex_id = 0;
+  filter->out_tex_id = 0;
+
   if (gst_query_get_n_allocation_pools (query) > 0) {
     gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
 
@@ -932,19 +1081,38 @@ gst_gl_filter_decide_allocation (GstBaseTransform * trans, GstQuery * query)
 
   if (!filter->upload) {
     filter->upload = gst_gl_upload_new (filter->context);
-    gst_gl_upload_init_format (filter->upload, filter->in_info,
-        filter->out_info);
+    gst_gl_upload_init_format (filter->upload, filter->frame_info,
+        filter->in_info);
   }
+
   //blocking call, generate a FBO
   if (!gst_gl_context_gen_fbo (filter->context, out_width, out_height,
           &filter->fbo, &filter->depthbuffer))
     goto context_error;
 
-  gst_gl_context_gen_texture (filter->context, &filter->in_tex_id,
-      GST_VIDEO_FORMAT_RGBA, in_width, in_height);
+  tex_format = filter->texture_format;
+  if (!tex_format)
+    tex_format = gst_gl_context_get_texture_format (filter->context,
+        &filter->in_info);
+
+  gst_gl_context_gen_texture_full (filter->context, &filter->in_tex_id,
+      tex_format, in_width, in_height, 1);
+  gst_gl_context_gen_texture_full (filter->context, &filter->out_tex_id,
+      tex_format, out_width, out_height, 1);
 
-  gst_gl_context_gen_texture (filter->context, &filter->out_tex_id,
-      GST_VIDEO_FORMAT_RGBA, out_width, out_height);
+  if (!filter->in_tex_id || !filter->out_tex_id) {
+    GST_ELEMENT_WARNING (filter, RESOURCE, SETTINGS,
+        ("Texture format 0x%x is not supported, using RGBA8", tex_format),
+        (NULL));
+    tex_format = GL_RGBA8;
+
+    if (!filter->in_tex_id)
+      gst_gl_context_gen_texture_full (filter->context, &filter->in_tex_id,
+          tex_format, in_width, in_height, 1);
+    if (!filter->out_tex_id)
+      gst_gl_context_gen_texture_full (filter->context, &filter->out_tex_id,
+          tex_format, out_width, out_height, 1);
+  }
 
   if (filter_class->display_init_cb != NULL) {
     gst_gl_context_thread_add (filter->context, gst_gl_filter_start_gl, filter);
@@ -961,6 +1129,8 @@ gst_gl_filter_decide_allocation (GstBaseTransform * trans, GstQuery * query)
   config = gst_buffer_pool_get_config (pool);
   gst_buffer_pool_config_set_params (config, caps, size, min, max);
   gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+  /* keep the depth of the input through the output buffers */
+  gst_buffer_pool_config_set_gl_texture_format (config, tex_format);
   gst_buffer_pool_set_config (pool, config);
 
   if (update_pool)
@@ -1000,25 +1170,51 @@ error:
 gboolean
 gst_gl_filter_filter_texture (GstGLFilter * filter, GstBuffer * inbuf,
     GstBuffer * outbuf)
+{
+  guint in_tex;
+  gboolean ret;
+
+  if (!gst_gl_upload_perform_with_buffer (filter->upload, inbuf, &in_tex))
+    return FALSE;
+
+  ret = gst_gl_filter_filter_texture_to_buffer (filter, in_tex, outbuf);
+
+  gst_gl_upload_release_buffer (filter->upload);
+
+  return ret;
+}
+
+/**
+ * gst_gl_filter_filter_texture_to_buffer:
+ * @filter: a #GstGLFilter
+ * @in_tex: the input texture
+ * @outbuf: an output buffer
+ *
+ * Call filter_texture vfunc with @in_tex and then an automatic download
+ * into @outbuf if needed.  Subclasses producing several output buffers
+ * from one input use it to upload their input only once.
+ *
+ * Returns: whether the transformation succeeded
+ */
+gboolean
+gst_gl_filter_filter_texture_to_buffer (GstGLFilter * filter, guint in_tex,
+    GstBuffer * outbuf)
 {
   GstGLFilterClass *filter_class;
-  guint in_tex, out_tex;
+  guint out_tex;
   GstVideoFrame out_frame;
   gboolean ret, out_gl_mem;
   GstVideoGLTextureUploadMeta *out_tex_upload_meta;
 
   filter_class = GST_GL_FILTER_GET_CLASS (filter);
 
-  if (!gst_gl_upload_perform_with_buffer (filter->upload, inbuf, &in_tex))
-    return FALSE;
-
   if (!gst_video_frame_map (&out_frame, &filter->out_info, outbuf,
-          GST_MAP_WRITE | GST_MAP_GL)) {
-    ret = FALSE;
-    goto inbuf_error;
-  }
+          GST_MAP_WRITE | GST_MAP_GL))
+    return FALSE;
 
-  out_gl_mem = gst_is_gl_memory (out_frame.map[0].memory);
+  /* planes are written in system memory, render RGBA and download */
+  out_gl_mem = gst_is_gl_memory (out_frame.map[0].memory)
+      && !GST_GL_MEMORY_IS_PLANE (out_frame.map[0].memory);
   out_tex_upload_meta = gst_buffer_get_video_gl_texture_upload_meta (outbuf);
 
   if (out_gl_mem) {
@@ -1030,10 +1226,8 @@ gst_gl_filter_filter_texture (GstGLFilter * filter, GstBuffer * inbuf,
     if (!filter->download) {
       filter->download = gst_gl_download_new (filter->context);
 
-      if (!gst_gl_download_init_format (filter->download,
-              GST_VIDEO_FRAME_FORMAT (&out_frame),
-              GST_VIDEO_FRAME_WIDTH (&out_frame),
-              GST_VIDEO_FRAME_HEIGHT (&out_frame))) {
+      if (!gst_gl_download_init_format_full (filter->download,
+              &out_frame.info)) {
         GST_ELEMENT_ERROR (filter, RESOURCE, NOT_FOUND,
             ("%s", "Failed to init download format"), (NULL));
         ret = FALSE;
@@ -1061,8 +1255,11 @@ gst_gl_filter_filter_texture (GstGLFilter * filter, GstBuffer * inbuf,
 
 error:
   gst_video_frame_unmap (&out_frame);
-inbuf_error:
-  gst_gl_upload_release_buffer (filter->upload);
+
+  /* the output may come from a pool of a downstream context */
+  if (out_gl_mem)
+    gst_gl_memory_set_sync_point ((GstGLMemory *) out_frame.map[0].memory,
+        filter->context);
 
   return ret;
 }
@@ -1194,68 +1391,29 @@ gst_gl_filter_draw_texture (GstGLFilter * filter, GLuint texture,
     guint width, guint height)
 {
   GstGLContext *context = filter->context;
-  GstGLFuncs *gl = context->gl_vtable;
 
   GST_DEBUG ("drawing texture:%u dimensions:%ux%u", texture, width, height);
 
 #if GST_GL_HAVE_OPENGL
   if (gst_gl_context_get_gl_api (context) & GST_GL_API_OPENGL) {
-    GLfloat verts[] = { -1.0f, -1.0f,
-      1.0f, -1.0f,
-      1.0f, 1.0f,
-      -1.0f, 1.0f
-    };
-    GLfloat texcoords[] = { 0.0f, 0.0f,
-      1.0f, 0.0f,
-      1.0f, 1.0f,
-      0.0f, 1.0f
-    };
+    GstGLFuncs *gl = context->gl_vtable;
 
     gl->ActiveTexture (GL_TEXTURE0);
 
     gl->Enable (GL_TEXTURE_2D);
     gl->BindTexture (GL_TEXTURE_2D, texture);
 
-    gl->ClientActiveTexture (GL_TEXTURE0);
-
-    gl->EnableClientState (GL_VERTEX_ARRAY);
-    gl->EnableClientState (GL_TEXTURE_COORD_ARRAY);
-
-    gl->VertexPointer (2, GL_FLOAT, 0, &verts);
-    gl->TexCoordPointer (2, GL_FLOAT, 0, &texcoords);
-
-    gl->DrawArrays (GL_TRIANGLE_FAN, 0, 4);
-
-    gl->DisableClientState (GL_VERTEX_ARRAY);
-    gl->DisableClientState (GL_TEXTURE_COORD_ARRAY);
+    gst_gl_context_bind_geometry (context, GST_GL_GEOMETRY_QUAD, -1, -1);
+    gst_gl_context_draw_geometry (context, 0, 1);
+    gst_gl_context_unbind_geometry (context);
   }
 #endif
 #if GST_GL_HAVE_GLES2
   if (gst_gl_context_get_gl_api (context) & GST_GL_API_GLES2) {
-    const GLfloat vVertices[] = {
-      -1.0f, -1.0f, 0.0f,
-      0.0f, 0.0f,
-      1.0, -1.0f, 0.0f,
-      1.0f, 0.0f,
-      1.0f, 1.0f, 0.0f, 1.0f, 1.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f
-    };
-
-    GLushort indices[] = { 0, 1, 2, 0, 2, 3 };
-
-    /* glClear (GL_COLOR_BUFFER_BIT); */
-
-    /* Load the vertex position */
-    gl->VertexAttribPointer (filter->draw_attr_position_loc, 3, GL_FLOAT,
-        GL_FALSE, 5 * sizeof (GLfloat), vVertices);
-
-    /* Load the texture coordinate */
-    gl->VertexAttribPointer (filter->draw_attr_texture_loc, 2, GL_FLOAT,
-        GL_FALSE, 5 * sizeof (GLfloat), &vVertices[3]);
-
-    gl->EnableVertexAttribArray (filter->draw_attr_position_loc);
-    gl->EnableVertexAttribArray (filter->draw_attr_texture_loc);
-
-    gl->DrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+    gst_gl_context_bind_geometry (context, GST_GL_GEOMETRY_QUAD,
+        filter->draw_attr_position_loc, filter->draw_attr_texture_loc);
+    gst_gl_context_draw_geometry (context, 0, 1);
+    gst_gl_context_unbind_geometry (context);
   }
 #endif
 }
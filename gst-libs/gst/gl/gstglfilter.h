@@ -47,12 +47,14 @@ typedef struct _GstGLFilterClass GstGLFilterClass;
  * @base_transform: parent #GstBaseTransform
  * @pool: the currently configured #GstBufferPool
  * @display: the currently configured #GstGLDisplay
- * @in_info: the video info for input buffers
+ * @in_info: the video info for input frames, sized to their #GstVideoCropMeta
  * @out_info: the video info for output buffers
  * @fbo: GL Framebuffer object used for transformations
  * @depthbuffer: GL renderbuffer attached to @fbo
  * @upload: the object used for uploading data, if needed
  * @download: the object used for downloading data, if needed
+ * @texture_format: the internal format of the filter's textures, 0 to pick
+ *                  one from @in_info
  *
  * #GstGLFilter is a base class that provides the logic of getting the GL context
  * from downstream and automatic upload/download for non-#GstGLMemory
@@ -74,6 +76,8 @@ struct _GstGLFilter
   GstGLUpload       *upload;
   GstGLDownload     *download;
 
+  GLenum             texture_format;
+
   /* <private> */
   GLuint             in_tex_id;
   GLuint             out_tex_id;
@@ -83,6 +87,12 @@ struct _GstGLFilter
   GstGLContext      *context;
   GstGLContext      *other_context;
 
+  /* the whole frame of the input buffers and the size of their crop */
+  GstVideoInfo       frame_info;
+  guint              crop_width;
+  guint              crop_height;
+  GstPadChainFunction base_chain;
+
 #if GST_GL_HAVE_GLES2
   GLint draw_attr_position_loc;
   GLint draw_attr_texture_loc;
@@ -126,6 +136,8 @@ struct _GstGLFilterClass
 
 gboolean gst_gl_filter_filter_texture (GstGLFilter * filter, GstBuffer * inbuf,
                                        GstBuffer * outbuf);
+gboolean gst_gl_filter_filter_texture_to_buffer (GstGLFilter * filter, guint in_tex,
+                                                 GstBuffer * outbuf);
 
 void gst_gl_filter_render_to_target (GstGLFilter *filter, gboolean resize, GLuint input,
                                      GLuint target, GLCB func, gpointer data);
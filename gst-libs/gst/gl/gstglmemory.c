@@ -40,8 +40,78 @@
  * be wrapped through gst_gl_memory_wrapped().
  *
  * Data is uploaded or downloaded from the GPU as is necessary.
+ *
+ * Textures are GL_RGBA8 unless another internal format is given to
+ * gst_gl_memory_alloc_with_format(), such as GL_RGB10_A2 or GL_RGBA16F to
+ * keep more than 8 bits per component between GL elements, or GL_R8 and
+ * GL_RG8 for single or dual channel data like masks.  The system memory
+ * side always holds @v_info's format.
+ *
+ * Many small frames of the same size can share a single GL texture by
+ * allocating them from a #GstGLTextureAtlas with
+ * gst_gl_memory_alloc_from_atlas().  Such a memory only occupies the
+ * rectangle starting at (@tex_x, @tex_y) inside @tex_id and
+ * gst_gl_memory_get_tex_coords() returns the normalized texture coordinates
+ * to sample it with.  Mapping an atlas memory with #GST_MAP_WRITE and
+ * #GST_MAP_GL moves it into its own texture so that renderers which are not
+ * aware of atlases can keep drawing into the whole of @tex_id.
+ *
+ * gst_gl_memory_setup_buffer() fills a #GstBuffer with one #GstGLMemory per
+ * plane of a planar or semi-planar YUV frame.  Each plane is a GL_R8 (or
+ * GL_RG8 for interleaved chroma) texture so that shaders can sample the YUV
+ * data directly instead of going through an RGBA conversion pass.  Like
+ * any other #GstGLMemory, mapping a plane with #GST_MAP_GL gives its texture
+ * and what GL writes into it is read back on the next system memory map.
+ *
+ * Copying a #GstBuffer holding #GstGLMemory shares the textures so that the
+ * branches after a tee can all read the same frame.  The copy holds a read
+ * only #GstGLMemory whose parent is the memory owning the texture and
+ * mapping it maps the parent.  A parent is not writable while it is shared
+ * and mapping it with #GST_MAP_WRITE through gst_buffer_map() transparently
+ * replaces it in that buffer with a copy, leaving the other readers
+ * untouched.  Transfers between system memory and the texture are
+ * serialized per memory so that concurrent readers in different threads
+ * only upload or download once.
+ *
+ * A GL write unmapped from a #GstGLMemory is assumed to have been made in
+ * the context of the memory, elements rendering into memories of another
+ * context say so with gst_gl_memory_set_sync_point().  Readers sampling the
+ * texture from a different context call gst_gl_memory_wait_sync() which
+ * makes their context wait on the GPU for the writes.  Nothing is done when
+ * the reader and the writer are the same context.
  */
 
+#ifndef GL_RED
+#define GL_RED 0x1903
+#endif
+#ifndef GL_RG
+#define GL_RG 0x8227
+#endif
+#ifndef GL_R8
+#define GL_R8 0x8229
+#endif
+#ifndef GL_RG8
+#define GL_RG8 0x822B
+#endif
+#ifndef GL_RGB10_A2
+#define GL_RGB10_A2 0x8059
+#endif
+#ifndef GL_RGBA16F
+#define GL_RGBA16F 0x881A
+#endif
+#ifndef GL_UNPACK_ROW_LENGTH
+#define GL_UNPACK_ROW_LENGTH 0x0CF2
+#endif
+#ifndef GL_PACK_ROW_LENGTH
+#define GL_PACK_ROW_LENGTH 0x0D02
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_TIMEOUT_IGNORED
+#define GL_TIMEOUT_IGNORED G_GUINT64_CONSTANT (0xFFFFFFFFFFFFFFFF)
+#endif
+
 #define USING_OPENGL(context) (gst_gl_context_get_gl_api (context) & GST_GL_API_OPENGL)
 #define USING_OPENGL3(context) (gst_gl_context_get_gl_api (context) & GST_GL_API_OPENGL3)
 #define USING_GLES(context) (gst_gl_context_get_gl_api (context) & GST_GL_API_GLES)
@@ -60,24 +130,81 @@ typedef struct
   gboolean result;
 } GstGLMemoryCopyParams;
 
+/**
+ * GstGLTextureAtlas:
+ *
+ * Opaque refcounted GL texture split into equally sized slots that
+ * #GstGLMemory objects can be allocated from.
+ */
+struct _GstGLTextureAtlas
+{
+  volatile gint refcount;
+
+  GstGLContext *context;
+  GLuint tex_id;
+
+  gint slot_width;
+  gint slot_height;
+  guint cols;
+  guint rows;
+
+  /* protects used */
+  GMutex lock;
+  gboolean *used;
+};
+
+void _gl_mem_copy_thread (GstGLContext * context, gpointer data);
+static void _gl_mem_release_atlas_slot (GstGLMemory * gl_mem);
+
+/* the first component of @info stored in @plane */
+static gint
+_plane_component (GstVideoInfo * info, gint plane)
+{
+  gint i;
+
+  for (i = 0; i < GST_VIDEO_INFO_N_COMPONENTS (info); i++) {
+    if (GST_VIDEO_INFO_COMP_PLANE (info, i) == plane)
+      return i;
+  }
+
+  return -1;
+}
+
 static void
 _gl_mem_init (GstGLMemory * mem, GstAllocator * allocator, GstMemory * parent,
-    GstGLContext * context, GstVideoInfo v_info, gpointer user_data,
-    GDestroyNotify notify)
+    GstGLContext * context, GstVideoInfo v_info, gint plane,
+    gpointer user_data, GDestroyNotify notify)
 {
   gsize maxsize;
 
-  maxsize = v_info.size;
-
-  gst_memory_init (GST_MEMORY_CAST (mem), GST_MEMORY_FLAG_NO_SHARE,
-      allocator, parent, maxsize, 0, 0, maxsize);
+  if (plane < 0)
+    maxsize = v_info.size;
+  else
+    maxsize = GST_VIDEO_INFO_PLANE_STRIDE (&v_info, plane) *
+        GST_VIDEO_INFO_COMP_HEIGHT (&v_info, _plane_component (&v_info, plane));
+
+  gst_memory_init (GST_MEMORY_CAST (mem), 0, allocator, parent, maxsize, 0, 0,
+      maxsize);
+  g_mutex_init (&mem->lock);
+  g_cond_init (&mem->transfer_cond);
+  mem->transferring = FALSE;
+  mem->sync = NULL;
+  mem->sync_context = NULL;
+  mem->need_fence = FALSE;
 
   mem->context = gst_object_ref (context);
   mem->gl_format = GL_RGBA;
+  mem->tex_format = GL_RGBA8;
+  mem->plane = plane;
   mem->v_info = v_info;
   mem->notify = notify;
   mem->user_data = user_data;
   mem->wrapped = FALSE;
+  mem->atlas = NULL;
+  mem->tex_x = 0;
+  mem->tex_y = 0;
+  mem->tex_width = GST_VIDEO_INFO_WIDTH (&v_info);
+  mem->tex_height = GST_VIDEO_INFO_HEIGHT (&v_info);
   mem->upload = gst_gl_upload_new (context);
   mem->download = gst_gl_download_new (context);
 
@@ -88,36 +215,282 @@ _gl_mem_init (GstGLMemory * mem, GstAllocator * allocator, GstMemory * parent,
 
 static GstGLMemory *
 _gl_mem_new (GstAllocator * allocator, GstMemory * parent,
-    GstGLContext * context, GstVideoInfo v_info, gpointer user_data,
-    GDestroyNotify notify)
+    GstGLContext * context, GstVideoInfo v_info, GLenum tex_format,
+    gpointer user_data, GDestroyNotify notify)
 {
   GstGLMemory *mem;
   GLuint tex_id;
 
-  gst_gl_context_gen_texture (context, &tex_id,
-      GST_VIDEO_INFO_FORMAT (&v_info), GST_VIDEO_INFO_WIDTH (&v_info),
-      GST_VIDEO_INFO_HEIGHT (&v_info));
+  gst_gl_context_gen_texture_full (context, &tex_id, tex_format,
+      GST_VIDEO_INFO_WIDTH (&v_info), GST_VIDEO_INFO_HEIGHT (&v_info), 1);
   if (!tex_id) {
     GST_CAT_WARNING (GST_CAT_GL_MEMORY,
         "Could not create GL texture with context:%p", context);
   }
 
-  GST_CAT_TRACE (GST_CAT_GL_MEMORY, "created texture %u", tex_id);
+  GST_CAT_TRACE (GST_CAT_GL_MEMORY, "created texture %u format:0x%x", tex_id,
+      tex_format);
 
   mem = g_slice_alloc (sizeof (GstGLMemory));
-  _gl_mem_init (mem, allocator, parent, context, v_info, user_data, notify);
+  _gl_mem_init (mem, allocator, parent, context, v_info, -1, user_data,
+      notify);
 
   mem->tex_id = tex_id;
+  mem->tex_format = tex_format;
 
   return mem;
 }
 
-gpointer
-_gl_mem_map (GstGLMemory * gl_mem, gsize maxsize, GstMapFlags flags)
+static GstGLMemory *
+_gl_mem_plane_new (GstGLContext * context, GstVideoInfo * v_info, gint plane)
+{
+  GstGLMemory *mem;
+  gint comp, width, height;
+  gboolean two_channels, luminance;
+  GLuint tex_id;
+
+  comp = _plane_component (v_info, plane);
+  width = GST_VIDEO_INFO_COMP_WIDTH (v_info, comp);
+  height = GST_VIDEO_INFO_COMP_HEIGHT (v_info, comp);
+  two_channels = GST_VIDEO_INFO_COMP_PSTRIDE (v_info, comp) == 2;
+
+  gst_gl_context_gen_texture_full (context, &tex_id,
+      two_channels ? GL_RG8 : GL_R8, width, height, 1);
+  if (!tex_id) {
+    GST_CAT_WARNING (GST_CAT_GL_MEMORY,
+        "Could not create GL texture for plane %i with context:%p", plane,
+        context);
+    return NULL;
+  }
+
+  mem = g_slice_alloc (sizeof (GstGLMemory));
+  _gl_mem_init (mem, _gl_allocator, NULL, context, *v_info, plane, NULL, NULL);
+
+  /* GLES2 only has GL_R8 and GL_RG8 with immutable storage */
+  luminance = (gst_gl_context_get_gl_api (context) & GST_GL_API_GLES2)
+      && !context->gl_vtable->TexStorage2D;
+  if (two_channels)
+    mem->gl_format = luminance ? GL_LUMINANCE_ALPHA : GL_RG;
+  else
+    mem->gl_format = luminance ? GL_LUMINANCE : GL_RED;
+
+  mem->tex_id = tex_id;
+  mem->tex_format = two_channels ? GL_RG8 : GL_R8;
+  mem->tex_width = width;
+  mem->tex_height = height;
+
+  GST_CAT_TRACE (GST_CAT_GL_MEMORY, "created plane %i texture %u "
+      "dimensions:%ix%i", plane, tex_id, width, height);
+
+  mem->data = g_malloc (mem->mem.maxsize);
+  if (mem->data == NULL) {
+    gst_memory_unref ((GstMemory *) mem);
+    return NULL;
+  }
+
+  return mem;
+}
+
+static void
+_gl_mem_upload_plane_thread (GstGLContext * context, GstGLMemory * gl_mem)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+  guint8 *data = gl_mem->data;
+  gint pstride, stride, i;
+
+  pstride = GST_VIDEO_INFO_COMP_PSTRIDE (&gl_mem->v_info,
+      _plane_component (&gl_mem->v_info, gl_mem->plane));
+  stride = GST_VIDEO_INFO_PLANE_STRIDE (&gl_mem->v_info, gl_mem->plane);
+
+  gl->BindTexture (GL_TEXTURE_2D, gl_mem->tex_id);
+  gl->PixelStorei (GL_UNPACK_ALIGNMENT, 1);
+
+  if (stride == gl_mem->tex_width * pstride) {
+    gl->TexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, gl_mem->tex_width,
+        gl_mem->tex_height, gl_mem->gl_format, GL_UNSIGNED_BYTE, data);
+  } else if (gst_gl_context_get_gl_api (context) & GST_GL_API_OPENGL) {
+    gl->PixelStorei (GL_UNPACK_ROW_LENGTH, stride / pstride);
+    gl->TexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, gl_mem->tex_width,
+        gl_mem->tex_height, gl_mem->gl_format, GL_UNSIGNED_BYTE, data);
+    gl->PixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+  } else {
+    /* no GL_UNPACK_ROW_LENGTH in GLES2 */
+    for (i = 0; i < gl_mem->tex_height; i++) {
+      gl->TexSubImage2D (GL_TEXTURE_2D, 0, 0, i, gl_mem->tex_width, 1,
+          gl_mem->gl_format, GL_UNSIGNED_BYTE, data + i * stride);
+    }
+  }
+
+  gl->PixelStorei (GL_UNPACK_ALIGNMENT, 4);
+  gl->BindTexture (GL_TEXTURE_2D, 0);
+}
+
+typedef struct
+{
+  GstGLMemory *gl_mem;
+  gboolean result;
+} GstGLMemoryPlaneDownload;
+
+static void
+_gl_mem_download_plane_thread (GstGLContext * context,
+    GstGLMemoryPlaneDownload * download)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+  GstGLMemory *gl_mem = download->gl_mem;
+  guint8 *data = gl_mem->data;
+  guint8 *rgba;
+  gint pstride, stride, i, j;
+  GLuint fbo;
+
+  pstride = GST_VIDEO_INFO_COMP_PSTRIDE (&gl_mem->v_info,
+      _plane_component (&gl_mem->v_info, gl_mem->plane));
+  stride = GST_VIDEO_INFO_PLANE_STRIDE (&gl_mem->v_info, gl_mem->plane);
+
+  if (gl->GetTexImage) {
+    gl->BindTexture (GL_TEXTURE_2D, gl_mem->tex_id);
+    gl->PixelStorei (GL_PACK_ALIGNMENT, 1);
+    gl->PixelStorei (GL_PACK_ROW_LENGTH, stride / pstride);
+    gl->GetTexImage (GL_TEXTURE_2D, 0, gl_mem->gl_format, GL_UNSIGNED_BYTE,
+        data);
+    gl->PixelStorei (GL_PACK_ROW_LENGTH, 0);
+    gl->PixelStorei (GL_PACK_ALIGNMENT, 4);
+    gl->BindTexture (GL_TEXTURE_2D, 0);
+
+    download->result = TRUE;
+    return;
+  }
+
+  /* GLES can only read RGBA back from a framebuffer and luminance textures
+   * can't be rendered to */
+  if (gl_mem->gl_format != GL_RED && gl_mem->gl_format != GL_RG) {
+    GST_CAT_WARNING (GST_CAT_GL_MEMORY, "Cannot read back plane %i texture:%u",
+        gl_mem->plane, gl_mem->tex_id);
+    download->result = FALSE;
+    return;
+  }
+
+  rgba = g_malloc (gl_mem->tex_width * gl_mem->tex_height * 4);
+
+  gl->GenFramebuffers (1, &fbo);
+  gl->BindFramebuffer (GL_FRAMEBUFFER, fbo);
+  gl->FramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+      GL_TEXTURE_2D, gl_mem->tex_id, 0);
+
+  download->result = gst_gl_context_check_framebuffer_status (context);
+  if (download->result) {
+    gl->ReadPixels (0, 0, gl_mem->tex_width, gl_mem->tex_height, GL_RGBA,
+        GL_UNSIGNED_BYTE, rgba);
+
+    for (i = 0; i < gl_mem->tex_height; i++) {
+      guint8 *src = rgba + i * gl_mem->tex_width * 4;
+      guint8 *dest = data + i * stride;
+
+      for (j = 0; j < gl_mem->tex_width; j++) {
+        memcpy (dest, src, pstride);
+        src += 4;
+        dest += pstride;
+      }
+    }
+  }
+
+  gl->BindFramebuffer (GL_FRAMEBUFFER, 0);
+  gl->DeleteFramebuffers (1, &fbo);
+
+  g_free (rgba);
+}
+
+/* planes keep their system memory and texture in sync like the RGBA
+ * memories, only with a single channel or two per texture */
+static gpointer
+_gl_mem_map_plane (GstGLMemory * gl_mem, GstMapFlags flags)
+{
+  if ((flags & GST_MAP_GL) == GST_MAP_GL) {
+    GST_CAT_TRACE (GST_CAT_GL_MEMORY, "mapping plane %i texture:%u",
+        gl_mem->plane, gl_mem->tex_id);
+
+    if ((flags & GST_MAP_READ) == GST_MAP_READ
+        && GST_GL_MEMORY_FLAG_IS_SET (gl_mem, GST_GL_MEMORY_FLAG_NEED_UPLOAD)) {
+      gst_gl_context_thread_add (gl_mem->context,
+          (GstGLContextThreadFunc) _gl_mem_upload_plane_thread, gl_mem);
+      GST_GL_MEMORY_FLAG_UNSET (gl_mem, GST_GL_MEMORY_FLAG_NEED_UPLOAD);
+    }
+
+    gl_mem->map_flags = flags;
+
+    return &gl_mem->tex_id;
+  }
+
+  GST_CAT_TRACE (GST_CAT_GL_MEMORY, "mapping plane %i texture:%u in system "
+      "memory", gl_mem->plane, gl_mem->tex_id);
+
+  if ((flags & GST_MAP_READ) == GST_MAP_READ
+      && GST_GL_MEMORY_FLAG_IS_SET (gl_mem, GST_GL_MEMORY_FLAG_NEED_DOWNLOAD)) {
+    GstGLMemoryPlaneDownload download = { gl_mem, FALSE };
+
+    gst_gl_context_thread_add (gl_mem->context,
+        (GstGLContextThreadFunc) _gl_mem_download_plane_thread, &download);
+    if (!download.result)
+      return NULL;
+    GST_GL_MEMORY_FLAG_UNSET (gl_mem, GST_GL_MEMORY_FLAG_NEED_DOWNLOAD);
+  }
+
+  gl_mem->map_flags = flags;
+
+  return gl_mem->data;
+}
+
+/* moves @gl_mem out of its atlas into a texture of its own, optionally
+ * keeping the current contents */
+static gboolean
+_gl_mem_detach_from_atlas (GstGLMemory * gl_mem, gboolean keep_contents)
+{
+  GstGLMemoryCopyParams copy_params;
+  GLuint tex_id = 0;
+
+  if (keep_contents) {
+    copy_params = (GstGLMemoryCopyParams) {
+    gl_mem, 0,};
+
+    gst_gl_context_thread_add (gl_mem->context, _gl_mem_copy_thread,
+        &copy_params);
+    if (!copy_params.result)
+      return FALSE;
+
+    tex_id = copy_params.tex_id;
+  } else {
+    gst_gl_context_gen_texture (gl_mem->context, &tex_id,
+        GST_VIDEO_INFO_FORMAT (&gl_mem->v_info),
+        GST_VIDEO_INFO_WIDTH (&gl_mem->v_info),
+        GST_VIDEO_INFO_HEIGHT (&gl_mem->v_info));
+  }
+
+  if (!tex_id) {
+    GST_CAT_WARNING (GST_CAT_GL_MEMORY,
+        "Could not create GL texture with context:%p", gl_mem->context);
+    return FALSE;
+  }
+
+  GST_CAT_DEBUG (GST_CAT_GL_MEMORY, "detaching memory %p from atlas %p "
+      "into texture %u", gl_mem, gl_mem->atlas, tex_id);
+
+  _gl_mem_release_atlas_slot (gl_mem);
+
+  gl_mem->tex_id = tex_id;
+  gl_mem->tex_x = 0;
+  gl_mem->tex_y = 0;
+  gl_mem->tex_width = GST_VIDEO_INFO_WIDTH (&gl_mem->v_info);
+  gl_mem->tex_height = GST_VIDEO_INFO_HEIGHT (&gl_mem->v_info);
+
+  return TRUE;
+}
+
+static gpointer
+_gl_mem_map_unlocked (GstGLMemory * gl_mem, GstMapFlags flags)
 {
   gpointer data;
 
-  g_return_val_if_fail (maxsize == gl_mem->mem.maxsize, NULL);
+  if (gl_mem->plane >= 0)
+    return _gl_mem_map_plane (gl_mem, flags);
 
   if ((flags & GST_MAP_GL) == GST_MAP_GL) {
     if ((flags & GST_MAP_READ) == GST_MAP_READ) {
@@ -142,6 +515,13 @@ _gl_mem_map (GstGLMemory * gl_mem, gsize maxsize, GstMapFlags flags)
           gl_mem->tex_id);
     }
 
+    /* GL writers render into the whole texture */
+    if (gl_mem->atlas && (flags & GST_MAP_WRITE) == GST_MAP_WRITE) {
+      if (!_gl_mem_detach_from_atlas (gl_mem,
+              (flags & GST_MAP_READ) == GST_MAP_READ))
+        goto error;
+    }
+
     data = &gl_mem->tex_id;
   } else {                      /* not GL */
     if ((flags & GST_MAP_READ) == GST_MAP_READ) {
@@ -151,10 +531,8 @@ _gl_mem_map (GstGLMemory * gl_mem, gsize maxsize, GstMapFlags flags)
       if (GST_GL_MEMORY_FLAG_IS_SET (gl_mem, GST_GL_MEMORY_FLAG_NEED_DOWNLOAD)) {
         if (!GST_GL_MEMORY_FLAG_IS_SET (gl_mem,
                 GST_GL_MEMORY_FLAG_DOWNLOAD_INITTED)) {
-          if (!gst_gl_download_init_format (gl_mem->download,
-                  GST_VIDEO_INFO_FORMAT (&gl_mem->v_info),
-                  GST_VIDEO_INFO_WIDTH (&gl_mem->v_info),
-                  GST_VIDEO_INFO_HEIGHT (&gl_mem->v_info))) {
+          if (!gst_gl_download_init_format_full (gl_mem->download,
+                  &gl_mem->v_info)) {
             goto error;
           }
           GST_GL_MEMORY_FLAG_SET (gl_mem, GST_GL_MEMORY_FLAG_DOWNLOAD_INITTED);
@@ -182,18 +560,193 @@ error:
   }
 }
 
+/* the memory owning the texture, shared memories always point at it */
+static GstGLMemory *
+_gl_mem_get_root (GstGLMemory * gl_mem)
+{
+  if (gl_mem->mem.parent)
+    return (GstGLMemory *) gl_mem->mem.parent;
+
+  return gl_mem;
+}
+
+/* readers of a memory shared between buffers may map it from different
+ * threads at the same time.  Only one of them transfers between system
+ * memory and the texture, the others wait for it without holding the lock
+ * so that the lock is never held across a call into the GL thread. */
+static void
+_gl_mem_begin_transfer (GstGLMemory * gl_mem)
+{
+  g_mutex_lock (&gl_mem->lock);
+  while (gl_mem->transferring)
+    g_cond_wait (&gl_mem->transfer_cond, &gl_mem->lock);
+  gl_mem->transferring = TRUE;
+  g_mutex_unlock (&gl_mem->lock);
+}
+
+static void
+_gl_mem_end_transfer (GstGLMemory * gl_mem)
+{
+  g_mutex_lock (&gl_mem->lock);
+  gl_mem->transferring = FALSE;
+  g_cond_broadcast (&gl_mem->transfer_cond);
+  g_mutex_unlock (&gl_mem->lock);
+}
+
+/* called with the lock held */
+static gboolean
+_gl_mem_needs_transfer (GstGLMemory * gl_mem, GstMapFlags flags)
+{
+  if ((flags & GST_MAP_GL) == GST_MAP_GL) {
+    if ((flags & GST_MAP_READ) == GST_MAP_READ
+        && GST_GL_MEMORY_FLAG_IS_SET (gl_mem, GST_GL_MEMORY_FLAG_NEED_UPLOAD))
+      return TRUE;
+
+    return gl_mem->atlas && (flags & GST_MAP_WRITE) == GST_MAP_WRITE;
+  }
+
+  return (flags & GST_MAP_READ) == GST_MAP_READ
+      && GST_GL_MEMORY_FLAG_IS_SET (gl_mem, GST_GL_MEMORY_FLAG_NEED_DOWNLOAD);
+}
+
+/* the fence is only inserted once a reader in another context needs it,
+ * it follows every command of the writer so far */
+static void
+_gl_mem_insert_fence_thread (GstGLContext * context, GstGLMemory * gl_mem)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+
+  if (gl_mem->sync)
+    gl->DeleteSync (gl_mem->sync);
+  gl_mem->sync = NULL;
+
+  if (gl->FenceSync)
+    gl_mem->sync = gl->FenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  /* the commands, and the fence, have to reach the GPU before another
+   * context depends on them.  Without sync objects that is all we can do */
+  gl->Flush ();
+}
+
+/* the reader's context waits on the GPU, the CPU doesn't block */
+static void
+_gl_mem_wait_fence_thread (GstGLContext * context, GstGLMemory * gl_mem)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+
+  if (gl->WaitSync)
+    gl->WaitSync (gl_mem->sync, 0, GL_TIMEOUT_IGNORED);
+}
+
+static void
+_gl_mem_delete_fence_thread (GstGLContext * context, GstGLMemory * gl_mem)
+{
+  context->gl_vtable->DeleteSync (gl_mem->sync);
+  gl_mem->sync = NULL;
+}
+
+/* called with the lock held, @context is the context of the last GL write */
+static void
+_gl_mem_set_sync_context_unlocked (GstGLMemory * gl_mem,
+    GstGLContext * context)
+{
+  if (gl_mem->sync_context != context) {
+    GstGLContext *old = gl_mem->sync_context;
+
+    gl_mem->sync_context = gst_object_ref (context);
+    if (old)
+      gst_object_unref (old);
+  }
+  gl_mem->need_fence = TRUE;
+}
+
+/* called while transferring on the root memory */
+static void
+_gl_mem_sync_unlocked (GstGLMemory * gl_mem, GstGLContext * context)
+{
+  GstGLContext *writer = NULL;
+  gboolean need_fence = FALSE;
+
+  g_mutex_lock (&gl_mem->lock);
+  if (gl_mem->sync_context && gl_mem->sync_context != context) {
+    writer = gst_object_ref (gl_mem->sync_context);
+    need_fence = gl_mem->need_fence;
+    gl_mem->need_fence = FALSE;
+  }
+  g_mutex_unlock (&gl_mem->lock);
+
+  if (!writer)
+    return;
+
+  if (need_fence)
+    gst_gl_context_thread_add (writer,
+        (GstGLContextThreadFunc) _gl_mem_insert_fence_thread, gl_mem);
+
+  if (gl_mem->sync)
+    gst_gl_context_thread_add (context,
+        (GstGLContextThreadFunc) _gl_mem_wait_fence_thread, gl_mem);
+
+  gst_object_unref (writer);
+}
+
+gpointer
+_gl_mem_map (GstGLMemory * gl_mem, gsize maxsize, GstMapFlags flags)
+{
+  gpointer data;
+
+  g_return_val_if_fail (maxsize == gl_mem->mem.maxsize, NULL);
+
+  /* a shared memory maps the texture of its parent */
+  gl_mem = _gl_mem_get_root (gl_mem);
+
+  g_mutex_lock (&gl_mem->lock);
+  while (gl_mem->transferring)
+    g_cond_wait (&gl_mem->transfer_cond, &gl_mem->lock);
+
+  if (!_gl_mem_needs_transfer (gl_mem, flags)) {
+    if ((flags & GST_MAP_GL) == GST_MAP_GL)
+      data = &gl_mem->tex_id;
+    else
+      data = gl_mem->data;
+    gl_mem->map_flags = flags;
+    g_mutex_unlock (&gl_mem->lock);
+
+    return data;
+  }
+
+  gl_mem->transferring = TRUE;
+  g_mutex_unlock (&gl_mem->lock);
+
+  /* downloads read the texture in the context of the memory */
+  if ((flags & GST_MAP_GL) != GST_MAP_GL)
+    _gl_mem_sync_unlocked (gl_mem, gl_mem->context);
+
+  data = _gl_mem_map_unlocked (gl_mem, flags);
+
+  _gl_mem_end_transfer (gl_mem);
+
+  return data;
+}
+
 void
 _gl_mem_unmap (GstGLMemory * gl_mem)
 {
+  /* shared memories are read only, there is nothing to write back */
+  if (gl_mem->mem.parent)
+    return;
+
+  g_mutex_lock (&gl_mem->lock);
   if ((gl_mem->map_flags & GST_MAP_WRITE) == GST_MAP_WRITE) {
     if ((gl_mem->map_flags & GST_MAP_GL) == GST_MAP_GL) {
       GST_GL_MEMORY_FLAG_SET (gl_mem, GST_GL_MEMORY_FLAG_NEED_DOWNLOAD);
+      _gl_mem_set_sync_context_unlocked (gl_mem, gl_mem->context);
     } else {
       GST_GL_MEMORY_FLAG_SET (gl_mem, GST_GL_MEMORY_FLAG_NEED_UPLOAD);
     }
   }
 
   gl_mem->map_flags = 0;
+  g_mutex_unlock (&gl_mem->lock);
 }
 
 void
@@ -204,8 +757,7 @@ _gl_mem_copy_thread (GstGLContext * context, gpointer data)
   GLuint tex_id;
   GLuint rboId, fboId;
   gsize width, height;
-  GLuint gl_format;
-  GstVideoFormat v_format;
+  gsize tex_width, tex_height;
   GstGLFuncs *gl;
 
   copy_params = (GstGLMemoryCopyParams *) data;
@@ -213,8 +765,8 @@ _gl_mem_copy_thread (GstGLContext * context, gpointer data)
   tex_id = copy_params->tex_id;
   width = GST_VIDEO_INFO_WIDTH (&src->v_info);
   height = GST_VIDEO_INFO_HEIGHT (&src->v_info);
-  v_format = GST_VIDEO_INFO_FORMAT (&src->v_info);
-  gl_format = src->gl_format;
+  tex_width = src->tex_width;
+  tex_height = src->tex_height;
 
   gl = src->context->gl_vtable;
 
@@ -225,7 +777,8 @@ _gl_mem_copy_thread (GstGLContext * context, gpointer data)
   }
 
   if (!tex_id)
-    gst_gl_context_gen_texture (src->context, &tex_id, v_format, width, height);
+    gst_gl_context_gen_texture_full (src->context, &tex_id, src->tex_format,
+        width, height, 1);
 
   if (!tex_id) {
     GST_CAT_WARNING (GST_CAT_GL_MEMORY,
@@ -245,14 +798,14 @@ _gl_mem_copy_thread (GstGLContext * context, gpointer data)
   gl->BindRenderbuffer (GL_RENDERBUFFER, rboId);
 
   if (USING_OPENGL (src->context)) {
-    gl->RenderbufferStorage (GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width,
-        height);
+    gl->RenderbufferStorage (GL_RENDERBUFFER, GL_DEPTH_COMPONENT, tex_width,
+        tex_height);
     gl->RenderbufferStorage (GL_RENDERBUFFER, GL_DEPTH24_STENCIL8,
-        width, height);
+        tex_width, tex_height);
   }
   if (USING_GLES2 (src->context)) {
     gl->RenderbufferStorage (GL_RENDERBUFFER, GL_DEPTH_COMPONENT16,
-        width, height);
+        tex_width, tex_height);
   }
   /* attach the renderbuffer to depth attachment point */
   gl->FramebufferRenderbuffer (GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
@@ -272,7 +825,9 @@ _gl_mem_copy_thread (GstGLContext * context, gpointer data)
 
   /* copy tex */
   gl->BindTexture (GL_TEXTURE_2D, tex_id);
-  gl->CopyTexImage2D (GL_TEXTURE_2D, 0, gl_format, 0, 0, width, height, 0);
+  /* tex_id has storage of the right size, only update its contents */
+  gl->CopyTexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, src->tex_x, src->tex_y,
+      width, height);
   gl->BindTexture (GL_TEXTURE_2D, 0);
 
   gl->BindFramebuffer (GL_FRAMEBUFFER, 0);
@@ -309,9 +864,26 @@ _gl_mem_copy (GstGLMemory * src, gssize offset, gssize size)
   GstGLMemory *dest;
   GstGLMemoryCopyParams copy_params;
 
-  if (GST_GL_MEMORY_FLAG_IS_SET (src, GST_GL_MEMORY_FLAG_NEED_UPLOAD)) {
+  src = _gl_mem_get_root (src);
+
+  _gl_mem_begin_transfer (src);
+  _gl_mem_sync_unlocked (src, src->context);
+
+  if (src->plane >= 0) {
+    /* bring the system memory up to date with what GL wrote */
+    if (!_gl_mem_map_plane (src, GST_MAP_READ))
+      goto error;
+    src->map_flags = 0;
+
+    dest = _gl_mem_plane_new (src->context, &src->v_info, src->plane);
+    if (!dest)
+      goto error;
+
+    memcpy (dest->data, src->data, src->mem.maxsize);
+    GST_GL_MEMORY_FLAG_SET (dest, GST_GL_MEMORY_FLAG_NEED_UPLOAD);
+  } else if (GST_GL_MEMORY_FLAG_IS_SET (src, GST_GL_MEMORY_FLAG_NEED_UPLOAD)) {
     dest = _gl_mem_new (src->mem.allocator, NULL, src->context, src->v_info,
-        NULL, NULL);
+        src->tex_format, NULL, NULL);
     dest->data = g_malloc (src->mem.maxsize);
     memcpy (dest->data, src->data, src->mem.maxsize);
     GST_GL_MEMORY_FLAG_SET (dest, GST_GL_MEMORY_FLAG_NEED_UPLOAD);
@@ -323,31 +895,85 @@ _gl_mem_copy (GstGLMemory * src, gssize offset, gssize size)
 
     dest = g_slice_alloc (sizeof (GstGLMemory));
     _gl_mem_init (dest, src->mem.allocator, NULL, src->context, src->v_info,
-        NULL, NULL);
+        -1, NULL, NULL);
 
     if (!copy_params.result) {
       GST_CAT_WARNING (GST_CAT_GL_MEMORY, "Could not copy GL Memory");
       gst_memory_unref ((GstMemory *) dest);
-      return NULL;
+      goto error;
     }
 
     dest->tex_id = copy_params.tex_id;
+    dest->tex_format = src->tex_format;
     dest->data = g_malloc (src->mem.maxsize);
     if (dest->data == NULL) {
       GST_CAT_WARNING (GST_CAT_GL_MEMORY, "Could not copy GL Memory");
       gst_memory_unref ((GstMemory *) dest);
-      return NULL;
+      goto error;
     }
     GST_GL_MEMORY_FLAG_SET (dest, GST_GL_MEMORY_FLAG_NEED_DOWNLOAD);
   }
 
+  _gl_mem_end_transfer (src);
+
   return (GstMemory *) dest;
+
+error:
+  {
+    _gl_mem_end_transfer (src);
+    return NULL;
+  }
 }
 
 GstMemory *
 _gl_mem_share (GstGLMemory * mem, gssize offset, gssize size)
 {
-  return NULL;
+  GstGLMemory *shared, *root;
+
+  /* a texture can only be shared as a whole */
+  if (offset != 0 || (size != -1 && size != mem->mem.size))
+    return NULL;
+
+  root = _gl_mem_get_root (mem);
+
+  /* gst_memory_init() refs and exclusively locks the parent so that it is
+   * not writable and a buffer pool doesn't reuse it while it is shared */
+  shared = g_slice_alloc (sizeof (GstGLMemory));
+  gst_memory_init (GST_MEMORY_CAST (shared), GST_MINI_OBJECT_FLAG_LOCK_READONLY,
+      root->mem.allocator, (GstMemory *) root, root->mem.maxsize,
+      root->mem.align, root->mem.offset, root->mem.size);
+  g_mutex_init (&shared->lock);
+  g_cond_init (&shared->transfer_cond);
+  shared->transferring = FALSE;
+  shared->sync = NULL;
+  shared->sync_context = NULL;
+  shared->need_fence = FALSE;
+
+  shared->context = gst_object_ref (root->context);
+  shared->tex_id = root->tex_id;
+  shared->v_info = root->v_info;
+  shared->gl_format = root->gl_format;
+  shared->tex_format = root->tex_format;
+  shared->plane = root->plane;
+  shared->atlas = root->atlas;
+  shared->tex_x = root->tex_x;
+  shared->tex_y = root->tex_y;
+  shared->tex_width = root->tex_width;
+  shared->tex_height = root->tex_height;
+
+  /* everything else is done through the parent */
+  shared->upload = NULL;
+  shared->download = NULL;
+  shared->map_flags = 0;
+  shared->data = root->data;
+  shared->wrapped = TRUE;
+  shared->notify = NULL;
+  shared->user_data = NULL;
+
+  GST_CAT_DEBUG (GST_CAT_GL_MEMORY, "sharing memory %p texture:%u as %p",
+      root, root->tex_id, shared);
+
+  return (GstMemory *) shared;
 }
 
 gboolean
@@ -371,7 +997,24 @@ _gl_mem_free (GstAllocator * allocator, GstMemory * mem)
 {
   GstGLMemory *gl_mem = (GstGLMemory *) mem;
 
-  if (gl_mem->tex_id)
+  /* a shared memory only borrowed the texture of its parent */
+  if (mem->parent) {
+    gst_object_unref (gl_mem->context);
+    g_mutex_clear (&gl_mem->lock);
+    g_cond_clear (&gl_mem->transfer_cond);
+    g_slice_free (GstGLMemory, gl_mem);
+    return;
+  }
+
+  if (gl_mem->sync)
+    gst_gl_context_thread_add (gl_mem->context,
+        (GstGLContextThreadFunc) _gl_mem_delete_fence_thread, gl_mem);
+  if (gl_mem->sync_context)
+    gst_object_unref (gl_mem->sync_context);
+
+  if (gl_mem->atlas)
+    _gl_mem_release_atlas_slot (gl_mem);
+  else if (gl_mem->tex_id)
     gst_gl_context_del_texture (gl_mem->context, &gl_mem->tex_id);
 
   gst_object_unref (gl_mem->upload);
@@ -386,9 +1029,57 @@ _gl_mem_free (GstAllocator * allocator, GstMemory * mem)
     gl_mem->data = NULL;
   }
 
+  g_mutex_clear (&gl_mem->lock);
+  g_cond_clear (&gl_mem->transfer_cond);
   g_slice_free (GstGLMemory, gl_mem);
 }
 
+/**
+ * gst_gl_memory_set_sync_point:
+ * @gl_mem: a #GstGLMemory
+ * @context: the #GstGLContext GL wrote into @gl_mem with
+ *
+ * Records that the last GL write into @gl_mem was made in @context.
+ * Unmapping a #GST_MAP_GL write assumes the context of @gl_mem, elements
+ * rendering into memories of another context call this after unmapping.
+ */
+void
+gst_gl_memory_set_sync_point (GstGLMemory * gl_mem, GstGLContext * context)
+{
+  g_return_if_fail (gl_mem != NULL);
+  g_return_if_fail (GST_GL_IS_CONTEXT (context));
+
+  gl_mem = _gl_mem_get_root (gl_mem);
+
+  g_mutex_lock (&gl_mem->lock);
+  _gl_mem_set_sync_context_unlocked (gl_mem, context);
+  g_mutex_unlock (&gl_mem->lock);
+}
+
+/**
+ * gst_gl_memory_wait_sync:
+ * @gl_mem: a #GstGLMemory
+ * @context: the #GstGLContext that is going to sample @gl_mem
+ *
+ * Makes @context wait on the GPU for the last GL write into @gl_mem when it
+ * was made in another context.  It does nothing when @context wrote it, so
+ * it costs nothing in pipelines using a single context.
+ *
+ * Must not be called from the GL thread.
+ */
+void
+gst_gl_memory_wait_sync (GstGLMemory * gl_mem, GstGLContext * context)
+{
+  g_return_if_fail (gl_mem != NULL);
+  g_return_if_fail (GST_GL_IS_CONTEXT (context));
+
+  gl_mem = _gl_mem_get_root (gl_mem);
+
+  _gl_mem_begin_transfer (gl_mem);
+  _gl_mem_sync_unlocked (gl_mem, context);
+  _gl_mem_end_transfer (gl_mem);
+}
+
 /**
  * gst_gl_memory_copy_into_texture:
  * @gl_mem:a #GstGLMemory
@@ -404,6 +1095,8 @@ gst_gl_memory_copy_into_texture (GstGLMemory * gl_mem, guint tex_id)
 {
   GstGLMemoryCopyParams copy_params;
 
+  gst_gl_memory_wait_sync (gl_mem, gl_mem->context);
+
   copy_params.src = gl_mem;
   copy_params.tex_id = tex_id;
 
@@ -413,6 +1106,303 @@ gst_gl_memory_copy_into_texture (GstGLMemory * gl_mem, guint tex_id)
   return copy_params.result;
 }
 
+static void
+_gl_mem_copy_from_thread (GstGLContext * context, gpointer data)
+{
+  GstGLMemoryCopyParams *copy_params;
+  GstGLMemory *dest;
+  GLuint fboId;
+  GstGLFuncs *gl;
+
+  copy_params = (GstGLMemoryCopyParams *) data;
+  dest = copy_params->src;
+  gl = context->gl_vtable;
+
+  if (!gl->GenFramebuffers) {
+    gst_gl_context_set_error (context,
+        "Context, EXT_framebuffer_object not supported");
+    copy_params->result = FALSE;
+    return;
+  }
+
+  GST_CAT_LOG (GST_CAT_GL_MEMORY, "copying texture %u into memory %p, "
+      "tex %u at %i,%i", copy_params->tex_id, dest, dest->tex_id, dest->tex_x,
+      dest->tex_y);
+
+  gl->GenFramebuffers (1, &fboId);
+  gl->BindFramebuffer (GL_FRAMEBUFFER, fboId);
+
+  gl->FramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+      GL_TEXTURE_2D, copy_params->tex_id, 0);
+
+  if (!gst_gl_context_check_framebuffer_status (context)) {
+    gl->BindFramebuffer (GL_FRAMEBUFFER, 0);
+    gl->DeleteFramebuffers (1, &fboId);
+    copy_params->result = FALSE;
+    return;
+  }
+
+  gl->BindTexture (GL_TEXTURE_2D, dest->tex_id);
+  gl->CopyTexSubImage2D (GL_TEXTURE_2D, 0, dest->tex_x, dest->tex_y, 0, 0,
+      GST_VIDEO_INFO_WIDTH (&dest->v_info),
+      GST_VIDEO_INFO_HEIGHT (&dest->v_info));
+  gl->BindTexture (GL_TEXTURE_2D, 0);
+
+  gl->BindFramebuffer (GL_FRAMEBUFFER, 0);
+  gl->DeleteFramebuffers (1, &fboId);
+
+  copy_params->result = TRUE;
+}
+
+/**
+ * gst_gl_memory_copy_from_texture:
+ * @gl_mem:a #GstGLMemory
+ * @tex_id:OpenGL texture id
+ *
+ * Copies the texture specified by @tex_id into the area of the GL texture
+ * occupied by @gl_mem.  This assumes that @tex_id has the same dimensions as
+ * @gl_mem.
+ *
+ * Returns: Whether the copy suceeded
+ */
+gboolean
+gst_gl_memory_copy_from_texture (GstGLMemory * gl_mem, guint tex_id)
+{
+  GstGLMemoryCopyParams copy_params;
+
+  copy_params.src = gl_mem;
+  copy_params.tex_id = tex_id;
+  copy_params.result = FALSE;
+
+  gst_gl_context_thread_add (gl_mem->context, _gl_mem_copy_from_thread,
+      &copy_params);
+
+  return copy_params.result;
+}
+
+/**
+ * gst_gl_memory_get_tex_coords:
+ * @gl_mem:a #GstGLMemory
+ * @tex_coords: (out): the normalized left, top, right and bottom texture
+ *              coordinates
+ *
+ * Retrieves the rectangle of @gl_mem's texture that contains its pixels.
+ * This is the whole texture unless @gl_mem was allocated from a
+ * #GstGLTextureAtlas.
+ *
+ * The slots of an atlas have no border, so the rectangle of such a memory
+ * goes from the centre of its first texel to the centre of its last one.
+ * Linear filtering then never reads the neighbouring slots.
+ */
+void
+gst_gl_memory_get_tex_coords (GstGLMemory * gl_mem, gfloat tex_coords[4])
+{
+  gfloat tex_width = (gfloat) gl_mem->tex_width;
+  gfloat tex_height = (gfloat) gl_mem->tex_height;
+
+  if (!gl_mem->atlas) {
+    tex_coords[0] = tex_coords[1] = 0.0f;
+    tex_coords[2] = tex_coords[3] = 1.0f;
+    return;
+  }
+
+  tex_coords[0] = ((gfloat) gl_mem->tex_x + 0.5f) / tex_width;
+  tex_coords[1] = ((gfloat) gl_mem->tex_y + 0.5f) / tex_height;
+  tex_coords[2] = ((gfloat) (gl_mem->tex_x +
+          GST_VIDEO_INFO_WIDTH (&gl_mem->v_info)) - 0.5f) / tex_width;
+  tex_coords[3] = ((gfloat) (gl_mem->tex_y +
+          GST_VIDEO_INFO_HEIGHT (&gl_mem->v_info)) - 0.5f) / tex_height;
+}
+
+static void
+_get_max_texture_size (GstGLContext * context, GLint * max_size)
+{
+  context->gl_vtable->GetIntegerv (GL_MAX_TEXTURE_SIZE, max_size);
+}
+
+/**
+ * gst_gl_texture_atlas_new:
+ * @context: a #GstGLContext
+ * @slot_width: the width of a single slot
+ * @slot_height: the height of a single slot
+ * @n_slots: the number of slots wanted
+ *
+ * Creates a single GL texture that is divided into a grid of
+ * @slot_width x @slot_height slots.  Fewer than @n_slots are available when
+ * the texture would exceed GL_MAX_TEXTURE_SIZE.
+ *
+ * Returns: a new #GstGLTextureAtlas or %NULL on failure
+ */
+GstGLTextureAtlas *
+gst_gl_texture_atlas_new (GstGLContext * context, gint slot_width,
+    gint slot_height, guint n_slots)
+{
+  GstGLTextureAtlas *atlas;
+  GLint max_size = 0;
+
+  g_return_val_if_fail (GST_GL_IS_CONTEXT (context), NULL);
+  g_return_val_if_fail (slot_width > 0 && slot_height > 0, NULL);
+  g_return_val_if_fail (n_slots > 0, NULL);
+
+  atlas = g_slice_new0 (GstGLTextureAtlas);
+  atlas->refcount = 1;
+  atlas->context = gst_object_ref (context);
+  atlas->slot_width = slot_width;
+  atlas->slot_height = slot_height;
+  g_mutex_init (&atlas->lock);
+
+  gst_gl_context_thread_add (context,
+      (GstGLContextThreadFunc) _get_max_texture_size, &max_size);
+
+  if (max_size >= slot_width && max_size >= slot_height) {
+    atlas->cols = MIN (n_slots, max_size / slot_width);
+    atlas->rows = MIN ((n_slots + atlas->cols - 1) / atlas->cols,
+        max_size / slot_height);
+
+    gst_gl_context_gen_texture_full (context, &atlas->tex_id, GL_RGBA8,
+        atlas->cols * slot_width, atlas->rows * slot_height, 1);
+  }
+
+  if (!atlas->tex_id) {
+    GST_CAT_WARNING (GST_CAT_GL_MEMORY, "Could not create %ux%u atlas of "
+        "%u slots with context:%p", slot_width, slot_height, n_slots, context);
+    gst_gl_texture_atlas_unref (atlas);
+    return NULL;
+  }
+
+  atlas->used = g_new0 (gboolean, atlas->cols * atlas->rows);
+
+  GST_CAT_DEBUG (GST_CAT_GL_MEMORY, "new texture atlas %p texture:%u "
+      "slot dimensions:%ux%u grid:%ux%u", atlas, atlas->tex_id, slot_width,
+      slot_height, atlas->cols, atlas->rows);
+
+  return atlas;
+}
+
+/**
+ * gst_gl_texture_atlas_ref:
+ * @atlas: a #GstGLTextureAtlas
+ *
+ * Returns: (transfer full): @atlas with an increased reference count
+ */
+GstGLTextureAtlas *
+gst_gl_texture_atlas_ref (GstGLTextureAtlas * atlas)
+{
+  g_return_val_if_fail (atlas != NULL, NULL);
+
+  g_atomic_int_inc (&atlas->refcount);
+
+  return atlas;
+}
+
+/**
+ * gst_gl_texture_atlas_unref:
+ * @atlas: a #GstGLTextureAtlas
+ *
+ * Decreases the reference count of @atlas, deleting its texture once the
+ * last reference is dropped.  Every #GstGLMemory allocated from @atlas holds
+ * a reference.
+ */
+void
+gst_gl_texture_atlas_unref (GstGLTextureAtlas * atlas)
+{
+  g_return_if_fail (atlas != NULL);
+
+  if (!g_atomic_int_dec_and_test (&atlas->refcount))
+    return;
+
+  GST_CAT_TRACE (GST_CAT_GL_MEMORY, "freeing texture atlas %p", atlas);
+
+  if (atlas->tex_id)
+    gst_gl_context_del_texture (atlas->context, &atlas->tex_id);
+
+  gst_object_unref (atlas->context);
+  g_mutex_clear (&atlas->lock);
+  g_free (atlas->used);
+
+  g_slice_free (GstGLTextureAtlas, atlas);
+}
+
+static void
+_gl_mem_release_atlas_slot (GstGLMemory * gl_mem)
+{
+  GstGLTextureAtlas *atlas = gl_mem->atlas;
+  guint slot;
+
+  slot = (gl_mem->tex_y / atlas->slot_height) * atlas->cols +
+      gl_mem->tex_x / atlas->slot_width;
+
+  g_mutex_lock (&atlas->lock);
+  atlas->used[slot] = FALSE;
+  g_mutex_unlock (&atlas->lock);
+
+  gl_mem->atlas = NULL;
+  gl_mem->tex_id = 0;
+  gst_gl_texture_atlas_unref (atlas);
+}
+
+/**
+ * gst_gl_memory_alloc_from_atlas:
+ * @atlas:a #GstGLTextureAtlas
+ * @v_info: the #GstVideoInfo of the memory
+ *
+ * Allocates a #GstGLMemory occupying a free slot of @atlas.  @v_info must fit
+ * within a single slot.
+ *
+ * Returns: a #GstMemory object sharing the GL texture of @atlas or %NULL if
+ *          @atlas has no free slot left
+ */
+GstMemory *
+gst_gl_memory_alloc_from_atlas (GstGLTextureAtlas * atlas, GstVideoInfo v_info)
+{
+  GstGLMemory *mem;
+  guint i, n_slots;
+
+  g_return_val_if_fail (atlas != NULL, NULL);
+
+  if (GST_VIDEO_INFO_WIDTH (&v_info) > atlas->slot_width
+      || GST_VIDEO_INFO_HEIGHT (&v_info) > atlas->slot_height)
+    return NULL;
+
+  n_slots = atlas->cols * atlas->rows;
+
+  g_mutex_lock (&atlas->lock);
+  for (i = 0; i < n_slots; i++) {
+    if (!atlas->used[i]) {
+      atlas->used[i] = TRUE;
+      break;
+    }
+  }
+  g_mutex_unlock (&atlas->lock);
+
+  if (i == n_slots) {
+    GST_CAT_LOG (GST_CAT_GL_MEMORY, "texture atlas %p is full", atlas);
+    return NULL;
+  }
+
+  mem = g_slice_alloc (sizeof (GstGLMemory));
+  _gl_mem_init (mem, _gl_allocator, NULL, atlas->context, v_info, -1, NULL,
+      NULL);
+
+  mem->atlas = gst_gl_texture_atlas_ref (atlas);
+  mem->tex_id = atlas->tex_id;
+  mem->tex_x = (i % atlas->cols) * atlas->slot_width;
+  mem->tex_y = (i / atlas->cols) * atlas->slot_height;
+  mem->tex_width = atlas->cols * atlas->slot_width;
+  mem->tex_height = atlas->rows * atlas->slot_height;
+
+  GST_CAT_TRACE (GST_CAT_GL_MEMORY, "allocated memory %p from atlas %p at "
+      "%i,%i", mem, atlas, mem->tex_x, mem->tex_y);
+
+  mem->data = g_malloc (mem->mem.maxsize);
+  if (mem->data == NULL) {
+    gst_memory_unref ((GstMemory *) mem);
+    return NULL;
+  }
+
+  return (GstMemory *) mem;
+}
+
 /**
  * gst_gl_memory_alloc:
  * @context:a #GstGLContext
@@ -423,10 +1413,36 @@ gst_gl_memory_copy_into_texture (GstGLMemory * gl_mem, guint tex_id)
  */
 GstMemory *
 gst_gl_memory_alloc (GstGLContext * context, GstVideoInfo v_info)
+{
+  return gst_gl_memory_alloc_with_format (context, v_info, GL_RGBA8);
+}
+
+/**
+ * gst_gl_memory_alloc_with_format:
+ * @context:a #GstGLContext
+ * @v_info: the #GstVideoInfo of the memory
+ * @tex_format: the internal format of the texture, one of GL_RGBA8,
+ *              GL_RGB10_A2, GL_RGBA16F, GL_R8 or GL_RG8
+ *
+ * Allocates a #GstGLMemory whose texture stores @v_info's pixels with
+ * @tex_format instead of GL_RGBA8.  The system memory still holds @v_info's
+ * format and is converted on upload and download.
+ *
+ * Returns: a #GstMemory object with a GL texture specified by @v_info
+ *          from @context or %NULL if @tex_format is not supported
+ */
+GstMemory *
+gst_gl_memory_alloc_with_format (GstGLContext * context, GstVideoInfo v_info,
+    GLenum tex_format)
 {
   GstGLMemory *mem;
 
-  mem = _gl_mem_new (_gl_allocator, NULL, context, v_info, NULL, NULL);
+  mem = _gl_mem_new (_gl_allocator, NULL, context, v_info, tex_format, NULL,
+      NULL);
+  if (!mem->tex_id) {
+    gst_memory_unref ((GstMemory *) mem);
+    return NULL;
+  }
 
   mem->data = g_malloc (mem->mem.maxsize);
   if (mem->data == NULL) {
@@ -454,7 +1470,8 @@ gst_gl_memory_wrapped (GstGLContext * context, GstVideoInfo v_info,
 {
   GstGLMemory *mem;
 
-  mem = _gl_mem_new (_gl_allocator, NULL, context, v_info, user_data, notify);
+  mem = _gl_mem_new (_gl_allocator, NULL, context, v_info, GL_RGBA8,
+      user_data, notify);
 
   mem->data = data;
   mem->wrapped = TRUE;
@@ -523,3 +1540,77 @@ gst_is_gl_memory (GstMemory * mem)
 {
   return mem != NULL && mem->allocator == _gl_allocator;
 }
+
+/**
+ * gst_gl_memory_setup_buffer:
+ * @context: a #GstGLContext
+ * @info: the #GstVideoInfo of the frame
+ * @buffer: the #GstBuffer to add the memories to
+ *
+ * Appends one #GstGLMemory per plane of @info to @buffer together with a
+ * #GstVideoMeta describing them.  Each plane is stored in its own GL_R8 or
+ * GL_RG8 texture of the plane's dimensions and its system memory uses the
+ * plane stride of @info.
+ *
+ * Only the I420, YV12, Y42B, Y41B, Y444, NV12 and NV21 formats are supported.
+ *
+ * Returns: whether @buffer was set up, @buffer is unchanged otherwise
+ */
+gboolean
+gst_gl_memory_setup_buffer (GstGLContext * context, GstVideoInfo * info,
+    GstBuffer * buffer)
+{
+  GstGLMemory *gl_mem[GST_VIDEO_MAX_PLANES] = { NULL, };
+  gsize offset[GST_VIDEO_MAX_PLANES] = { 0, };
+  gint stride[GST_VIDEO_MAX_PLANES] = { 0, };
+  gsize total = 0;
+  gint i, n_planes;
+
+  g_return_val_if_fail (GST_GL_IS_CONTEXT (context), FALSE);
+  g_return_val_if_fail (info != NULL, FALSE);
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), FALSE);
+
+  switch (GST_VIDEO_INFO_FORMAT (info)) {
+    case GST_VIDEO_FORMAT_I420:
+    case GST_VIDEO_FORMAT_YV12:
+    case GST_VIDEO_FORMAT_Y42B:
+    case GST_VIDEO_FORMAT_Y41B:
+    case GST_VIDEO_FORMAT_Y444:
+    case GST_VIDEO_FORMAT_NV12:
+    case GST_VIDEO_FORMAT_NV21:
+      break;
+    default:
+      return FALSE;
+  }
+
+  n_planes = GST_VIDEO_INFO_N_PLANES (info);
+
+  for (i = 0; i < n_planes; i++) {
+    gl_mem[i] = _gl_mem_plane_new (context, info, i);
+    if (!gl_mem[i])
+      goto error;
+  }
+
+  for (i = 0; i < n_planes; i++) {
+    offset[i] = total;
+    stride[i] = GST_VIDEO_INFO_PLANE_STRIDE (info, i);
+    total += gl_mem[i]->mem.size;
+
+    gst_buffer_append_memory (buffer, (GstMemory *) gl_mem[i]);
+  }
+
+  gst_buffer_add_video_meta_full (buffer, 0, GST_VIDEO_INFO_FORMAT (info),
+      GST_VIDEO_INFO_WIDTH (info), GST_VIDEO_INFO_HEIGHT (info), n_planes,
+      offset, stride);
+
+  return TRUE;
+
+error:
+  {
+    for (i = 0; i < n_planes; i++) {
+      if (gl_mem[i])
+        gst_memory_unref ((GstMemory *) gl_mem[i]);
+    }
+    return FALSE;
+  }
+}
@@ -71,8 +71,15 @@ typedef enum
  * @tex_id: the texture id for this memory
  * @v_format: the video format of this texture
  * @gl_format: the format of the texture
- * @width: width of the texture
- * @height: height of the texture
+ * @tex_format: the sized internal format @tex_id was created with, one of
+ *              GL_RGBA8, GL_RGB10_A2, GL_RGBA16F, GL_R8 or GL_RG8
+ * @plane: the plane of @v_info held by @tex_id or -1 when @tex_id holds the
+ *         whole frame as RGBA
+ * @atlas: the #GstGLTextureAtlas @tex_id belongs to or %NULL
+ * @tex_x: horizontal offset of this memory's pixels inside @tex_id
+ * @tex_y: vertical offset of this memory's pixels inside @tex_id
+ * @tex_width: width of the whole texture @tex_id
+ * @tex_height: height of the whole texture @tex_id
  * @download: the object used to download this texture into @v_format
  * @upload: the object used to upload this texture from @v_format
  *
@@ -86,6 +93,14 @@ struct _GstGLMemory
   GLuint             tex_id;
   GstVideoInfo       v_info;
   GLenum             gl_format;
+  GLenum             tex_format;
+  gint               plane;
+
+  GstGLTextureAtlas *atlas;
+  gint               tex_x;
+  gint               tex_y;
+  gint               tex_width;
+  gint               tex_height;
 
   GstGLDownload     *download;
   GstGLUpload       *upload;
@@ -97,6 +112,13 @@ struct _GstGLMemory
   gboolean           wrapped;
   GDestroyNotify     notify;
   gpointer           user_data;
+
+  GMutex             lock;
+  GCond              transfer_cond;
+  gboolean           transferring;
+  gpointer           sync;
+  GstGLContext      *sync_context;
+  gboolean           need_fence;
 };
 
 /**
@@ -106,6 +128,15 @@ struct _GstGLMemory
  */
 #define GST_GL_MEMORY_ALLOCATOR   "GLMemory"
 
+/**
+ * GST_GL_MEMORY_IS_PLANE:
+ * @mem: a #GstGLMemory
+ *
+ * Whether @mem only holds a single plane of its video frame, see
+ * gst_gl_memory_setup_buffer()
+ */
+#define GST_GL_MEMORY_IS_PLANE(mem) (((GstGLMemory *) (mem))->plane >= 0)
+
 /**
  * GST_GL_MEMORY_FLAGS:
  * @mem: a #GstGLMemory
@@ -144,12 +175,31 @@ struct _GstGLMemory
 void gst_gl_memory_init (void);
 
 GstMemory * gst_gl_memory_alloc (GstGLContext * context, GstVideoInfo info);
+GstMemory * gst_gl_memory_alloc_with_format (GstGLContext * context, GstVideoInfo info,
+                                             GLenum tex_format);
 
 GstGLMemory * gst_gl_memory_wrapped (GstGLContext * context, GstVideoInfo info, gpointer data,
                                      gpointer user_data, GDestroyNotify notify);
 
 gboolean gst_is_gl_memory (GstMemory * mem);
+
+gboolean gst_gl_memory_setup_buffer (GstGLContext * context, GstVideoInfo * info,
+                                     GstBuffer * buffer);
+
 gboolean gst_gl_memory_copy_into_texture (GstGLMemory *gl_mem, guint tex_id);
+gboolean gst_gl_memory_copy_from_texture (GstGLMemory *gl_mem, guint tex_id);
+
+void gst_gl_memory_get_tex_coords (GstGLMemory * gl_mem, gfloat tex_coords[4]);
+
+void gst_gl_memory_set_sync_point (GstGLMemory * gl_mem, GstGLContext * context);
+void gst_gl_memory_wait_sync      (GstGLMemory * gl_mem, GstGLContext * context);
+
+GstGLTextureAtlas * gst_gl_texture_atlas_new   (GstGLContext * context, gint slot_width,
+                                                gint slot_height, guint n_slots);
+GstGLTextureAtlas * gst_gl_texture_atlas_ref   (GstGLTextureAtlas * atlas);
+void                gst_gl_texture_atlas_unref (GstGLTextureAtlas * atlas);
+
+GstMemory * gst_gl_memory_alloc_from_atlas (GstGLTextureAtlas * atlas, GstVideoInfo info);
 
 /**
  * GstGLAllocator
@@ -80,6 +80,10 @@ struct _GstGLMixerPrivate
   GstAllocator *allocator;
   GstAllocationParams params;
   GstQuery *query;
+
+  /* the last output, pushed again while the scene is unchanged */
+  GstBuffer *last_outbuf;
+  gboolean redraw;
 };
 
 G_DEFINE_TYPE (GstGLMixerPad, gst_gl_mixer_pad, GST_TYPE_PAD);
@@ -379,6 +383,11 @@ gst_gl_mixer_propose_allocation (GstGLMixer * mix,
 
     config = gst_buffer_pool_get_config (pool);
     gst_buffer_pool_config_set_params (config, caps, size, 0, 0);
+    /* small inputs can then be sampled from the same texture */
+    if (GST_VIDEO_INFO_WIDTH (&info) * GST_VIDEO_INFO_HEIGHT (&info) <=
+        GST_GL_TEXTURE_ATLAS_MAX_SLOT_PIXELS)
+      gst_buffer_pool_config_add_option (config,
+          GST_BUFFER_POOL_OPTION_GL_TEXTURE_ATLAS);
     if (!gst_buffer_pool_set_config (pool, config))
       goto config_failed;
   }
@@ -387,6 +396,8 @@ gst_gl_mixer_propose_allocation (GstGLMixer * mix,
 
   /* we also support various metadata */
   gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, 0);
+  /* the upload only draws the cropped area */
+  gst_query_add_allocation_meta (query, GST_VIDEO_CROP_META_API_TYPE, 0);
 
   gl_apis = gst_gl_api_to_string (gst_gl_context_get_gl_api (mix->context));
   platform =
@@ -691,12 +702,16 @@ gst_gl_mixer_reset (GstGLMixer * mix)
     GstGLMixerCollect *mixcol = p->mixcol;
 
     gst_buffer_replace (&mixcol->buffer, NULL);
+    gst_buffer_replace (&p->last_buffer, NULL);
     mixcol->start_time = -1;
     mixcol->end_time = -1;
 
     gst_video_info_init (&p->in_info);
   }
 
+  gst_buffer_replace (&priv->last_outbuf, NULL);
+  priv->redraw = TRUE;
+
   mix->newseg_pending = TRUE;
   mix->flush_stop_pending = FALSE;
 
@@ -1323,6 +1338,10 @@ gst_gl_mixer_src_setcaps (GstPad * pad, GstGLMixer * mix, GstCaps * caps)
 
   mix->out_info = info;
 
+  /* the last output has the previous caps */
+  gst_buffer_replace (&priv->last_outbuf, NULL);
+  priv->redraw = TRUE;
+
   GST_GL_MIXER_UNLOCK (mix);
 
   ret = gst_pad_set_caps (mix->srcpad, caps);
@@ -1418,6 +1437,8 @@ gst_gl_mixer_release_pad (GstElement * element, GstPad * pad)
   gst_child_proxy_child_removed (GST_CHILD_PROXY (mix), G_OBJECT (mixpad),
       GST_OBJECT_NAME (mixpad));
   mix->numpads--;
+  gst_buffer_replace (&mixpad->last_buffer, NULL);
+  mix->priv->redraw = TRUE;
 
   update_caps =
       GST_VIDEO_INFO_FORMAT (&mix->out_info) != GST_VIDEO_FORMAT_UNKNOWN;
@@ -1599,6 +1620,78 @@ gst_gl_mixer_fill_queues (GstGLMixer * mix,
   return 1;
 }
 
+/* the memory the frame of @buffer lives in, looking through the memories
+ * shared from it when the buffer was copied, like videorate does to
+ * repeat a frame */
+static GstMemory *
+gst_gl_mixer_get_frame_memory (GstBuffer * buffer)
+{
+  GstMemory *mem;
+
+  if (!buffer || gst_buffer_n_memory (buffer) == 0)
+    return NULL;
+
+  mem = gst_buffer_peek_memory (buffer, 0);
+  while (mem->parent)
+    mem = mem->parent;
+
+  return mem;
+}
+
+/* whether the next output frame differs from the last one, called with
+ * the mixer lock */
+static gboolean
+gst_gl_mixer_needs_redraw (GstGLMixer * mix, GstClockTime output_start_time)
+{
+  GstGLMixerClass *mix_class = GST_GL_MIXER_GET_CLASS (mix);
+  GstGLMixerPrivate *priv = mix->priv;
+  GstClockTime running_time;
+  gboolean changed;
+  GSList *l;
+
+  if (!mix_class->update_scene)
+    return TRUE;
+
+  running_time = gst_segment_to_running_time (&mix->segment, GST_FORMAT_TIME,
+      output_start_time);
+
+  /* always advance the scene, even when the inputs changed */
+  changed = mix_class->update_scene (mix, running_time);
+  changed |= priv->redraw || !priv->last_outbuf;
+
+  for (l = mix->sinkpads; l; l = l->next) {
+    GstGLMixerPad *pad = l->data;
+
+    if (gst_gl_mixer_get_frame_memory (pad->mixcol->buffer) !=
+        gst_gl_mixer_get_frame_memory (pad->last_buffer))
+      changed = TRUE;
+  }
+
+  return changed;
+}
+
+/* keeps the buffers @outbuf was rendered from, called with the mixer lock */
+static void
+gst_gl_mixer_store_last (GstGLMixer * mix, GstBuffer * outbuf)
+{
+  GstGLMixerClass *mix_class = GST_GL_MIXER_GET_CLASS (mix);
+  GstGLMixerPrivate *priv = mix->priv;
+  GSList *l;
+
+  if (!mix_class->update_scene)
+    return;
+
+  /* holding the input buffers keeps their memory from being recycled */
+  for (l = mix->sinkpads; l; l = l->next) {
+    GstGLMixerPad *pad = l->data;
+
+    gst_buffer_replace (&pad->last_buffer, pad->mixcol->buffer);
+  }
+
+  gst_buffer_replace (&priv->last_outbuf, outbuf);
+  priv->redraw = FALSE;
+}
+
 gboolean
 gst_gl_mixer_process_textures (GstGLMixer * mix, GstBuffer * outbuf)
 {
@@ -1618,7 +1711,8 @@ gst_gl_mixer_process_textures (GstGLMixer * mix, GstBuffer * outbuf)
     return FALSE;
   }
 
-  if (gst_is_gl_memory (out_frame.map[0].memory)) {
+  if (gst_is_gl_memory (out_frame.map[0].memory)
+      && !GST_GL_MEMORY_IS_PLANE (out_frame.map[0].memory)) {
     out_tex = *(guint *) out_frame.data[0];
   } else {
     GST_INFO ("Output Buffer does not contain correct memory, "
@@ -1628,10 +1722,8 @@ gst_gl_mixer_process_textures (GstGLMixer * mix, GstBuffer * outbuf)
 
     if (!mix->download) {
       mix->download = gst_gl_download_new (mix->context);
-      if (!gst_gl_download_init_format (mix->download,
-              GST_VIDEO_FRAME_FORMAT (&out_frame),
-              GST_VIDEO_FRAME_WIDTH (&out_frame),
-              GST_VIDEO_FRAME_HEIGHT (&out_frame))) {
+      if (!gst_gl_download_init_format_full (mix->download,
+              &out_frame.info)) {
         GST_ELEMENT_ERROR (mix, RESOURCE, NOT_FOUND,
             ("%s", "Failed to init upload format"), (NULL));
         res = FALSE;
@@ -1654,10 +1746,15 @@ gst_gl_mixer_process_textures (GstGLMixer * mix, GstBuffer * outbuf)
       GstSegment *seg;
       guint in_tex;
       GstGLMixerFrameData *frame;
+      GstMemory *mem;
 
       frame = g_ptr_array_index (mix->frames, array_index);
       frame->pad = pad;
       frame->texture = 0;
+      frame->tex_coords[0] = 0.0f;
+      frame->tex_coords[1] = 0.0f;
+      frame->tex_coords[2] = 1.0f;
+      frame->tex_coords[3] = 1.0f;
 
       seg = &mixcol->collect.segment;
 
@@ -1682,6 +1779,22 @@ gst_gl_mixer_process_textures (GstGLMixer * mix, GstBuffer * outbuf)
         }
       }
 
+      /* sample atlas memory in place instead of copying it out */
+      mem = gst_buffer_peek_memory (mixcol->buffer, 0);
+      if (gst_buffer_n_memory (mixcol->buffer) == 1 && gst_is_gl_memory (mem)
+          && ((GstGLMemory *) mem)->atlas
+          && ((GstGLMemory *) mem)->context == mix->context) {
+        if (gst_memory_map (mem, &pad->atlas_map, GST_MAP_READ | GST_MAP_GL)) {
+          pad->atlas_mapped = TRUE;
+          frame->texture = *(guint *) pad->atlas_map.data;
+          gst_gl_memory_wait_sync ((GstGLMemory *) mem, mix->context);
+          gst_gl_memory_get_tex_coords ((GstGLMemory *) mem,
+              frame->tex_coords);
+          ++array_index;
+          continue;
+        }
+      }
+
       if (!gst_gl_upload_perform_with_buffer (pad->upload, mixcol->buffer,
               &in_tex)) {
         ++array_index;
@@ -1716,13 +1829,22 @@ out:
     if (pad->mapped)
       gst_gl_upload_release_buffer (pad->upload);
 
+    if (pad->atlas_mapped)
+      gst_memory_unmap (pad->atlas_map.memory, &pad->atlas_map);
+
     pad->mapped = FALSE;
+    pad->atlas_mapped = FALSE;
     walk = g_slist_next (walk);
     i++;
   }
 
   gst_video_frame_unmap (&out_frame);
 
+  /* the output may come from a pool of a downstream context */
+  if (!out_gl_wrapped && gst_is_gl_memory (out_frame.map[0].memory))
+    gst_gl_memory_set_sync_point ((GstGLMemory *) out_frame.map[0].memory,
+        mix->context);
+
   return res;
 }
 
@@ -1883,7 +2005,18 @@ gst_gl_mixer_collected (GstCollectPads * pads, GstGLMixer * mix)
   }
 
   jitter = gst_gl_mixer_do_qos (mix, output_start_time);
-  if (jitter <= 0) {
+  if (jitter <= 0 && !gst_gl_mixer_needs_redraw (mix, output_start_time)) {
+    GST_LOG_OBJECT (mix, "scene unchanged, reusing the last output");
+
+    /* GstGLMemory is shared by gst_buffer_copy(), so the copy only
+     * references the texture of the last output.  The pool does not hand
+     * that buffer out again while the copy is alive. */
+    outbuf = gst_buffer_copy (mix->priv->last_outbuf);
+    GST_BUFFER_TIMESTAMP (outbuf) = output_start_time;
+    GST_BUFFER_DURATION (outbuf) = output_end_time - output_start_time;
+
+    mix->qos_processed++;
+  } else if (jitter <= 0) {
 
     if (!mix->priv->pool_active) {
       if (!gst_buffer_pool_set_active (mix->priv->pool, TRUE)) {
@@ -1914,6 +2047,8 @@ gst_gl_mixer_collected (GstCollectPads * pads, GstGLMixer * mix)
     else if (mix_class->process_textures)
       gst_gl_mixer_process_textures (mix, outbuf);
 
+    gst_gl_mixer_store_last (mix, outbuf);
+
     mix->qos_processed++;
   } else {
     GstMessage *msg;
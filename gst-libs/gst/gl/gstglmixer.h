@@ -52,6 +52,8 @@ typedef gboolean (*GstGLMixerProcessFunc) (GstGLMixer *mix,
   GPtrArray *buffers, GstBuffer *outbuf);
 typedef gboolean (*GstGLMixerProcessTextures) (GstGLMixer *mix,
   GPtrArray *frames, guint out_tex);
+typedef gboolean (*GstGLMixerUpdateScene) (GstGLMixer *mix,
+  GstClockTime running_time);
 
 struct _GstGLMixer
 {
@@ -98,6 +100,18 @@ struct _GstGLMixer
   GLuint depthbuffer;
 };
 
+/**
+ * GstGLMixerClass:
+ * @set_caps: called when the output caps are set
+ * @reset: called when the mixer stops
+ * @process_buffers: mix the input buffers into the output buffer
+ * @process_textures: mix the input textures into the output texture
+ * @update_scene: advance the scene to the running time of the next output
+ *                frame and return whether it changed otherwise than through
+ *                its inputs.  When set, the last output buffer is pushed
+ *                again without calling @process_textures as long as neither
+ *                the scene nor the input buffers change.
+ */
 struct _GstGLMixerClass
 {
   GstElementClass parent_class;
@@ -106,12 +120,21 @@ struct _GstGLMixerClass
   GstGLMixerReset reset;
   GstGLMixerProcessFunc process_buffers;
   GstGLMixerProcessTextures process_textures;
+  GstGLMixerUpdateScene update_scene;
 };
 
+/**
+ * GstGLMixerFrameData:
+ * @pad: the #GstGLMixerPad the frame was received on
+ * @texture: the texture containing the frame
+ * @tex_coords: normalized left, top, right and bottom coordinates of the
+ *              frame inside @texture
+ */
 struct _GstGLMixerFrameData
 {
   GstGLMixerPad *pad;
   guint texture;
+  gfloat tex_coords[4];
 };
 
 GType gst_gl_mixer_get_type(void);
@@ -66,6 +66,10 @@ struct _GstGLMixerPad
   GstVideoInfo in_info;
   guint in_tex_id;
   gboolean mapped;
+  GstMapInfo atlas_map;
+  gboolean atlas_mapped;
+  /* the buffer the last output was rendered from */
+  GstBuffer *last_buffer;
 
   GstGLMixerCollect *mixcol;
 };
@@ -0,0 +1,728 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gl.h"
+#include "gstgloverlaycompositor.h"
+
+/**
+ * SECTION:gstgloverlaycompositor
+ * @short_description: an object that blends overlay compositions with GL
+ * @see_also: #GstGLUpload, #GstVideoOverlayComposition
+ *
+ * #GstGLOverlayCompositor blends the #GstVideoOverlayRectangle<!-- -->s of
+ * the #GstVideoOverlayCompositionMeta<!-- -->s attached to a buffer into the
+ * current framebuffer.
+ *
+ * All the rectangles are packed into a single texture so that they are
+ * blended with one draw call.  A rectangle is uploaded the first time it is
+ * seen and stays in place for as long as the following buffers carry the
+ * same rectangle, as identified by its sequence number.  New rectangles are
+ * added after the others and the texture is only repacked, without the
+ * rectangles that disappeared, once they don't fit anymore.
+ *
+ * A #GstGLOverlayCompositor can be created with gst_gl_overlay_compositor_new()
+ */
+
+GST_DEBUG_CATEGORY_STATIC (gst_gl_overlay_compositor_debug);
+#define GST_CAT_DEFAULT gst_gl_overlay_compositor_debug
+
+#define DEBUG_INIT \
+  GST_DEBUG_CATEGORY_INIT (gst_gl_overlay_compositor_debug, "gloverlaycompositor", 0, "GL Overlay Compositor");
+
+G_DEFINE_TYPE_WITH_CODE (GstGLOverlayCompositor, gst_gl_overlay_compositor,
+    G_TYPE_OBJECT, DEBUG_INIT);
+
+#define GST_GL_OVERLAY_COMPOSITOR_GET_PRIVATE(o) \
+  (G_TYPE_INSTANCE_GET_PRIVATE((o), GST_TYPE_GL_OVERLAY_COMPOSITOR, GstGLOverlayCompositorPrivate))
+
+static void gst_gl_overlay_compositor_finalize (GObject * object);
+
+/* the rectangle pixels are in the native endian ARGB order of
+ * GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_RGB and are uploaded as RGBA bytes */
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define OVERLAY_SWIZZLE "bgra"
+#else
+#define OVERLAY_SWIZZLE "gbar"
+#endif
+
+/* *INDENT-OFF* */
+static const gchar *overlay_vertex_shader_str =
+    "attribute vec4 a_position;\n"
+    "attribute vec2 a_texcoord;\n"
+    "varying vec2 v_texcoord;\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = a_position;\n"
+    "   v_texcoord = a_texcoord;\n"
+    "}\n";
+
+static const gchar *overlay_fragment_shader_str =
+    "#ifdef GL_ES\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "varying vec2 v_texcoord;\n"
+    "uniform sampler2D tex;\n"
+    "void main()\n"
+    "{\n"
+    "  gl_FragColor = texture2D(tex, v_texcoord)." OVERLAY_SWIZZLE ";\n"
+    "}\n";
+/* *INDENT-ON* */
+
+/* smallest width of the texture the rectangles are packed into */
+#define MIN_TEXTURE_WIDTH 1024
+
+/* transparent texels left between the rectangles, what linear filtering
+ * reads past their edges */
+#define OVERLAY_PADDING 1
+
+typedef struct _GstGLCompositionOverlay
+{
+  GstVideoOverlayRectangle *rectangle;
+  guint seqnum;
+
+  /* position in the texture, placed is FALSE when it did not fit */
+  guint width;
+  guint height;
+  guint tex_x;
+  guint tex_y;
+  gboolean placed;
+  gboolean uploaded;
+} GstGLCompositionOverlay;
+
+struct _GstGLOverlayCompositorPrivate
+{
+  /* the overlays of the last uploaded buffer, in drawing order */
+  GList *overlays;
+
+  /* the texture all the overlays are packed into, in rows of rectangles.
+   * The next rectangle goes at next_x in the row that starts at row_y */
+  GLuint texture;
+  guint tex_width;
+  guint tex_height;
+  guint row_y;
+  guint row_height;
+  guint next_x;
+  gint max_texture_size;
+  gboolean texture_cleared;
+
+  /* replaced textures, deleted in the gl thread */
+  GArray *stale_textures;
+
+  /* 4 vertices of 4 floats per overlay, position then texcoord, streamed
+   * into vertex_buffer and index_buffer at each draw */
+  GArray *vertices;
+  GArray *indices;
+  GLuint vertex_buffer;
+  GLuint index_buffer;
+  gsize vertex_buffer_size;
+  gsize index_buffer_size;
+  GLuint vao;
+
+  GstGLShader *shader;
+  GLint position_loc;
+  GLint texcoord_loc;
+};
+
+static void
+gst_gl_overlay_compositor_class_init (GstGLOverlayCompositorClass * klass)
+{
+  g_type_class_add_private (klass, sizeof (GstGLOverlayCompositorPrivate));
+
+  G_OBJECT_CLASS (klass)->finalize = gst_gl_overlay_compositor_finalize;
+}
+
+static void
+gst_gl_overlay_compositor_init (GstGLOverlayCompositor * compositor)
+{
+  GstGLOverlayCompositorPrivate *priv;
+
+  priv = compositor->priv = GST_GL_OVERLAY_COMPOSITOR_GET_PRIVATE (compositor);
+
+  priv->position_loc = -1;
+  priv->texcoord_loc = -1;
+  priv->stale_textures = g_array_new (FALSE, FALSE, sizeof (GLuint));
+  priv->vertices = g_array_new (FALSE, FALSE, sizeof (GLfloat));
+  priv->indices = g_array_new (FALSE, FALSE, sizeof (GLushort));
+}
+
+static void
+_delete_buffers (GstGLContext * context, GstGLOverlayCompositorPrivate * priv)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+
+  if (priv->vao)
+    gl->DeleteVertexArrays (1, &priv->vao);
+  gl->DeleteBuffers (1, &priv->vertex_buffer);
+  gl->DeleteBuffers (1, &priv->index_buffer);
+}
+
+static void
+gst_gl_overlay_compositor_finalize (GObject * object)
+{
+  GstGLOverlayCompositor *compositor = GST_GL_OVERLAY_COMPOSITOR (object);
+
+  gst_gl_overlay_compositor_free_overlays (compositor);
+
+  if (compositor->priv->vertex_buffer)
+    gst_gl_context_thread_add (compositor->context,
+        (GstGLContextThreadFunc) _delete_buffers, compositor->priv);
+
+  g_array_free (compositor->priv->stale_textures, TRUE);
+  g_array_free (compositor->priv->vertices, TRUE);
+  g_array_free (compositor->priv->indices, TRUE);
+
+  if (compositor->priv->shader) {
+    gst_object_unref (compositor->priv->shader);
+    compositor->priv->shader = NULL;
+  }
+
+  if (compositor->context) {
+    gst_object_unref (compositor->context);
+    compositor->context = NULL;
+  }
+
+  G_OBJECT_CLASS (gst_gl_overlay_compositor_parent_class)->finalize (object);
+}
+
+/**
+ * gst_gl_overlay_compositor_new:
+ * @context: a #GstGLContext
+ *
+ * Returns: a new #GstGLOverlayCompositor object
+ */
+GstGLOverlayCompositor *
+gst_gl_overlay_compositor_new (GstGLContext * context)
+{
+  GstGLOverlayCompositor *compositor;
+
+  g_return_val_if_fail (GST_GL_IS_CONTEXT (context), NULL);
+
+  compositor = g_object_new (GST_TYPE_GL_OVERLAY_COMPOSITOR, NULL);
+
+  compositor->context = gst_object_ref (context);
+
+  return compositor;
+}
+
+static void
+_free_overlay (GstGLCompositionOverlay * overlay)
+{
+  gst_video_overlay_rectangle_unref (overlay->rectangle);
+  g_slice_free (GstGLCompositionOverlay, overlay);
+}
+
+static GstBuffer *
+_get_pixels (GstGLCompositionOverlay * overlay)
+{
+  return gst_video_overlay_rectangle_get_pixels_unscaled_argb
+      (overlay->rectangle, GST_VIDEO_OVERLAY_FORMAT_FLAG_PREMULTIPLIED_ALPHA);
+}
+
+static void
+_upload_overlay (GstGLContext * context, GstGLOverlayCompositor * compositor,
+    GstGLCompositionOverlay * overlay)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+  GstVideoMeta *vmeta;
+  GstBuffer *pixels;
+  GstMapInfo map_info;
+  guint8 *data;
+  guint i;
+
+  pixels = _get_pixels (overlay);
+  vmeta = gst_buffer_get_video_meta (pixels);
+
+  if (!gst_buffer_map (pixels, &map_info, GST_MAP_READ)) {
+    GST_WARNING ("failed to map the pixels of overlay rectangle %u",
+        overlay->seqnum);
+    return;
+  }
+
+  data = map_info.data + vmeta->offset[0];
+
+  gl->BindTexture (GL_TEXTURE_2D, compositor->priv->texture);
+  gl->PixelStorei (GL_UNPACK_ALIGNMENT, 4);
+
+  if (vmeta->stride[0] == vmeta->width * 4) {
+    gl->TexSubImage2D (GL_TEXTURE_2D, 0, overlay->tex_x, overlay->tex_y,
+        vmeta->width, vmeta->height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+  } else {
+    /* GLES2 has no GL_UNPACK_ROW_LENGTH */
+    for (i = 0; i < vmeta->height; i++)
+      gl->TexSubImage2D (GL_TEXTURE_2D, 0, overlay->tex_x,
+          overlay->tex_y + i, vmeta->width, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+          data + i * vmeta->stride[0]);
+  }
+
+  gl->BindTexture (GL_TEXTURE_2D, 0);
+
+  gst_buffer_unmap (pixels, &map_info);
+
+  overlay->uploaded = TRUE;
+}
+
+/* delete the replaced textures and fill in the new overlays */
+static void
+_sync_overlays (GstGLContext * context, GstGLOverlayCompositor * compositor)
+{
+  GstGLOverlayCompositorPrivate *priv = compositor->priv;
+  GList *l;
+
+  if (priv->stale_textures->len > 0) {
+    context->gl_vtable->DeleteTextures (priv->stale_textures->len,
+        (GLuint *) priv->stale_textures->data);
+    g_array_set_size (priv->stale_textures, 0);
+  }
+
+  /* a new texture starts transparent, for the padding */
+  if (priv->texture && !priv->texture_cleared) {
+    const GstGLFuncs *gl = context->gl_vtable;
+    guint8 *zeros = g_malloc0 (priv->tex_width * priv->tex_height * 4);
+
+    gl->BindTexture (GL_TEXTURE_2D, priv->texture);
+    gl->PixelStorei (GL_UNPACK_ALIGNMENT, 4);
+    gl->TexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, priv->tex_width,
+        priv->tex_height, GL_RGBA, GL_UNSIGNED_BYTE, zeros);
+    gl->BindTexture (GL_TEXTURE_2D, 0);
+
+    g_free (zeros);
+    priv->texture_cleared = TRUE;
+  }
+
+  for (l = priv->overlays; l; l = l->next) {
+    GstGLCompositionOverlay *overlay = l->data;
+
+    if (overlay->placed && !overlay->uploaded)
+      _upload_overlay (context, compositor, overlay);
+  }
+
+  if (priv->shader && priv->position_loc < 0) {
+    priv->position_loc =
+        gst_gl_shader_get_attribute_location (priv->shader, "a_position");
+    priv->texcoord_loc =
+        gst_gl_shader_get_attribute_location (priv->shader, "a_texcoord");
+  }
+}
+
+static void
+_get_max_texture_size (GstGLContext * context, gint * max_size)
+{
+  context->gl_vtable->GetIntegerv (GL_MAX_TEXTURE_SIZE, max_size);
+}
+
+/* places @overlay after the last one, FALSE when it doesn't fit */
+static gboolean
+_place_overlay (GstGLOverlayCompositorPrivate * priv,
+    GstGLCompositionOverlay * overlay)
+{
+  if (priv->next_x + overlay->width > priv->tex_width) {
+    priv->row_y += priv->row_height;
+    priv->row_height = 0;
+    priv->next_x = 0;
+  }
+
+  if (overlay->width > priv->tex_width
+      || priv->row_y + overlay->height > priv->tex_height)
+    return FALSE;
+
+  overlay->tex_x = priv->next_x;
+  overlay->tex_y = priv->row_y;
+  overlay->placed = TRUE;
+  overlay->uploaded = FALSE;
+
+  priv->next_x += overlay->width + OVERLAY_PADDING;
+  priv->row_height = MAX (priv->row_height, overlay->height + OVERLAY_PADDING);
+
+  return TRUE;
+}
+
+/* packs all the overlays into a new texture, with room for as many again */
+static void
+_repack_overlays (GstGLOverlayCompositor * compositor)
+{
+  GstGLOverlayCompositorPrivate *priv = compositor->priv;
+  guint width = MIN_TEXTURE_WIDTH, x = 0, y = 0, row_height = 0;
+  GList *l;
+
+  if (priv->texture) {
+    g_array_append_val (priv->stale_textures, priv->texture);
+    priv->texture = 0;
+  }
+
+  if (!priv->max_texture_size)
+    gst_gl_context_thread_add (compositor->context,
+        (GstGLContextThreadFunc) _get_max_texture_size,
+        &priv->max_texture_size);
+
+  for (l = priv->overlays; l; l = l->next)
+    width = MAX (width, ((GstGLCompositionOverlay *) l->data)->width);
+  width = MIN (width, priv->max_texture_size);
+
+  /* the height of the rows the overlays end up in */
+  for (l = priv->overlays; l; l = l->next) {
+    GstGLCompositionOverlay *overlay = l->data;
+
+    if (x + overlay->width > width) {
+      y += row_height;
+      row_height = 0;
+      x = 0;
+    }
+    x += overlay->width + OVERLAY_PADDING;
+    row_height = MAX (row_height, overlay->height + OVERLAY_PADDING);
+  }
+
+  priv->tex_width = width;
+  priv->tex_height = MIN (2 * (y + row_height), priv->max_texture_size);
+  priv->row_y = 0;
+  priv->row_height = 0;
+  priv->next_x = 0;
+  priv->texture_cleared = FALSE;
+
+  if (priv->tex_height > 0)
+    gst_gl_context_gen_texture_full (compositor->context, &priv->texture,
+        GL_RGBA8, priv->tex_width, priv->tex_height, 1);
+
+  GST_DEBUG_OBJECT (compositor, "packing %u overlays into %ux%u texture %u",
+      g_list_length (priv->overlays), priv->tex_width, priv->tex_height,
+      priv->texture);
+
+  for (l = priv->overlays; l; l = l->next) {
+    GstGLCompositionOverlay *overlay = l->data;
+
+    overlay->placed = FALSE;
+    if (priv->texture && !_place_overlay (priv, overlay))
+      GST_WARNING_OBJECT (compositor, "overlay rectangle %u of %ux%u does "
+          "not fit into the texture", overlay->seqnum, overlay->width,
+          overlay->height);
+  }
+}
+
+static gint
+_find_by_seqnum (GstGLCompositionOverlay * overlay, gpointer seqnum)
+{
+  return overlay->seqnum == GPOINTER_TO_UINT (seqnum) ? 0 : 1;
+}
+
+/**
+ * gst_gl_overlay_compositor_upload_overlays:
+ * @compositor: a #GstGLOverlayCompositor
+ * @buf: a #GstBuffer
+ *
+ * Makes the rectangles of all the #GstVideoOverlayCompositionMeta<!-- -->s on
+ * @buf the ones drawn by gst_gl_overlay_compositor_draw_overlays().  Only
+ * rectangles that were not part of the previous upload are uploaded.
+ *
+ * Must not be called in the GL thread.
+ */
+void
+gst_gl_overlay_compositor_upload_overlays (GstGLOverlayCompositor * compositor,
+    GstBuffer * buf)
+{
+  GstGLOverlayCompositorPrivate *priv;
+  GstMeta *meta;
+  gpointer state = NULL;
+  GList *previous, *added = NULL, *l;
+  gboolean changed = FALSE;
+
+  g_return_if_fail (GST_IS_GL_OVERLAY_COMPOSITOR (compositor));
+  g_return_if_fail (GST_IS_BUFFER (buf));
+
+  priv = compositor->priv;
+  previous = priv->overlays;
+  priv->overlays = NULL;
+
+  while ((meta = gst_buffer_iterate_meta (buf, &state))) {
+    GstVideoOverlayComposition *composition;
+    guint i, n;
+
+    if (meta->info->api != GST_VIDEO_OVERLAY_COMPOSITION_META_API_TYPE)
+      continue;
+
+    composition = ((GstVideoOverlayCompositionMeta *) meta)->overlay;
+    n = gst_video_overlay_composition_n_rectangles (composition);
+
+    for (i = 0; i < n; i++) {
+      GstVideoOverlayRectangle *rectangle;
+      GstGLCompositionOverlay *overlay;
+      guint seqnum;
+
+      rectangle = gst_video_overlay_composition_get_rectangle (composition, i);
+      seqnum = gst_video_overlay_rectangle_get_seqnum (rectangle);
+
+      l = g_list_find_custom (previous, GUINT_TO_POINTER (seqnum),
+          (GCompareFunc) _find_by_seqnum);
+      if (l) {
+        overlay = l->data;
+        previous = g_list_delete_link (previous, l);
+      } else {
+        GstVideoMeta *vmeta;
+
+        overlay = g_slice_new0 (GstGLCompositionOverlay);
+        overlay->rectangle = gst_video_overlay_rectangle_ref (rectangle);
+        overlay->seqnum = seqnum;
+
+        vmeta = gst_buffer_get_video_meta (_get_pixels (overlay));
+        overlay->width = vmeta->width;
+        overlay->height = vmeta->height;
+
+        GST_LOG_OBJECT (compositor, "new overlay rectangle %u, %ux%u",
+            seqnum, overlay->width, overlay->height);
+        changed = TRUE;
+        added = g_list_append (added, overlay);
+      }
+
+      priv->overlays = g_list_append (priv->overlays, overlay);
+    }
+  }
+
+  /* new overlays go after the others, unless they don't fit */
+  for (l = added; l; l = l->next) {
+    if (!priv->texture || !_place_overlay (priv, l->data)) {
+      _repack_overlays (compositor);
+      break;
+    }
+  }
+  g_list_free (added);
+
+  if (priv->overlays && !priv->shader) {
+    if (!gst_gl_context_gen_shader (compositor->context,
+            overlay_vertex_shader_str, overlay_fragment_shader_str,
+            &priv->shader))
+      GST_WARNING_OBJECT (compositor, "failed to compile the overlay shader");
+    changed = TRUE;
+  }
+
+  if (previous)
+    changed = TRUE;
+  g_list_free_full (previous, (GDestroyNotify) _free_overlay);
+
+  if (changed)
+    gst_gl_context_thread_add (compositor->context,
+        (GstGLContextThreadFunc) _sync_overlays, compositor);
+}
+
+/**
+ * gst_gl_overlay_compositor_free_overlays:
+ * @compositor: a #GstGLOverlayCompositor
+ *
+ * Releases all the uploaded rectangles and their texture.
+ *
+ * Must not be called in the GL thread.
+ */
+void
+gst_gl_overlay_compositor_free_overlays (GstGLOverlayCompositor * compositor)
+{
+  GstGLOverlayCompositorPrivate *priv;
+
+  g_return_if_fail (GST_IS_GL_OVERLAY_COMPOSITOR (compositor));
+
+  priv = compositor->priv;
+
+  g_list_free_full (priv->overlays, (GDestroyNotify) _free_overlay);
+  priv->overlays = NULL;
+
+  if (priv->texture) {
+    g_array_append_val (priv->stale_textures, priv->texture);
+    priv->texture = 0;
+  }
+
+  if (priv->stale_textures->len > 0)
+    gst_gl_context_thread_add (compositor->context,
+        (GstGLContextThreadFunc) _sync_overlays, compositor);
+}
+
+static inline void
+_append_vertex (GArray * vertices, GLfloat x, GLfloat y, GLfloat s, GLfloat t)
+{
+  GLfloat vertex[4] = { x, y, s, t };
+
+  g_array_append_vals (vertices, vertex, 4);
+}
+
+static inline void
+_append_index (GArray * indices, GLushort index)
+{
+  g_array_append_val (indices, index);
+}
+
+/* replaces the content of the buffer bound to @target with @array.  The
+ * storage is orphaned first so that the driver doesn't wait for the
+ * previous draw to finish reading it */
+static void
+_stream_buffer (const GstGLFuncs * gl, GLenum target, GArray * array,
+    gsize * buffer_size)
+{
+  gsize size = array->len * g_array_get_element_size (array);
+
+  *buffer_size = MAX (*buffer_size, size);
+  gl->BufferData (target, *buffer_size, NULL, GL_STREAM_DRAW);
+  gl->BufferSubData (target, 0, size, array->data);
+}
+
+static void
+_set_vertex_pointers (const GstGLFuncs * gl,
+    GstGLOverlayCompositorPrivate * priv)
+{
+  gl->VertexAttribPointer (priv->position_loc, 2, GL_FLOAT, GL_FALSE,
+      4 * sizeof (GLfloat), (gpointer) 0);
+  gl->VertexAttribPointer (priv->texcoord_loc, 2, GL_FLOAT, GL_FALSE,
+      4 * sizeof (GLfloat), (gpointer) (2 * sizeof (GLfloat)));
+  gl->EnableVertexAttribArray (priv->position_loc);
+  gl->EnableVertexAttribArray (priv->texcoord_loc);
+}
+
+/**
+ * gst_gl_overlay_compositor_draw_overlays:
+ * @compositor: a #GstGLOverlayCompositor
+ * @width: the width of the frame the overlays were attached to
+ * @height: the height of the frame the overlays were attached to
+ *
+ * Blends the rectangles of the last upload over the current framebuffer, in
+ * a single pass with premultiplied alpha.  The render rectangles are in the
+ * pixel coordinates of a @width x @height frame whose first row is at the
+ * bottom of the framebuffer, as for textures produced by #GstGLUpload.
+ *
+ * Must be called in the GL thread.
+ */
+void
+gst_gl_overlay_compositor_draw_overlays (GstGLOverlayCompositor * compositor,
+    guint width, guint height)
+{
+  GstGLOverlayCompositorPrivate *priv;
+  const GstGLFuncs *gl;
+  gboolean use_vao, new_vao = FALSE;
+  guint n = 0;
+  GList *l;
+
+  g_return_if_fail (GST_IS_GL_OVERLAY_COMPOSITOR (compositor));
+  g_return_if_fail (width > 0 && height > 0);
+
+  priv = compositor->priv;
+  gl = compositor->context->gl_vtable;
+
+  if (!priv->overlays || !priv->shader || !priv->texture)
+    return;
+
+  g_array_set_size (priv->vertices, 0);
+  g_array_set_size (priv->indices, 0);
+
+  for (l = priv->overlays; l; l = l->next) {
+    GstGLCompositionOverlay *overlay = l->data;
+    GLfloat x0, y0, x1, y1, s0, t0, s1, t1;
+    GLushort first = 4 * n;
+    gint x, y;
+    guint w, h;
+
+    if (!overlay->uploaded)
+      continue;
+
+    gst_video_overlay_rectangle_get_render_rectangle (overlay->rectangle,
+        &x, &y, &w, &h);
+
+    /* the corners in normalized device coordinates */
+    x0 = 2.0f * x / width - 1.0f;
+    y0 = 2.0f * y / height - 1.0f;
+    x1 = 2.0f * (x + (gint) w) / width - 1.0f;
+    y1 = 2.0f * (y + (gint) h) / height - 1.0f;
+
+    /* the whole rectangle, edge to edge */
+    s0 = (GLfloat) overlay->tex_x / priv->tex_width;
+    t0 = (GLfloat) overlay->tex_y / priv->tex_height;
+    s1 = (GLfloat) (overlay->tex_x + overlay->width) / priv->tex_width;
+    t1 = (GLfloat) (overlay->tex_y + overlay->height) / priv->tex_height;
+
+    _append_vertex (priv->vertices, x0, y0, s0, t0);
+    _append_vertex (priv->vertices, x1, y0, s1, t0);
+    _append_vertex (priv->vertices, x1, y1, s1, t1);
+    _append_vertex (priv->vertices, x0, y1, s0, t1);
+
+    _append_index (priv->indices, first);
+    _append_index (priv->indices, first + 1);
+    _append_index (priv->indices, first + 2);
+    _append_index (priv->indices, first);
+    _append_index (priv->indices, first + 2);
+    _append_index (priv->indices, first + 3);
+
+    /* GLushort indices */
+    if (++n == 16384)
+      break;
+  }
+
+  if (n == 0)
+    return;
+
+  gl->Disable (GL_DEPTH_TEST);
+  gl->Enable (GL_BLEND);
+  gl->BlendFunc (GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+  gst_gl_shader_use (priv->shader);
+
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, priv->texture);
+  gst_gl_shader_set_uniform_1i (priv->shader, "tex", 0);
+
+  if (!priv->vertex_buffer) {
+    gl->GenBuffers (1, &priv->vertex_buffer);
+    gl->GenBuffers (1, &priv->index_buffer);
+  }
+
+  /* the vertex layout is recorded once in the vertex array object */
+  use_vao = gl->GenVertexArrays != NULL;
+  if (use_vao) {
+    if (!priv->vao) {
+      gl->GenVertexArrays (1, &priv->vao);
+      new_vao = TRUE;
+    }
+    gl->BindVertexArray (priv->vao);
+  }
+
+  gl->BindBuffer (GL_ARRAY_BUFFER, priv->vertex_buffer);
+  gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, priv->index_buffer);
+
+  if (!use_vao || new_vao)
+    _set_vertex_pointers (gl, priv);
+
+  _stream_buffer (gl, GL_ARRAY_BUFFER, priv->vertices,
+      &priv->vertex_buffer_size);
+  _stream_buffer (gl, GL_ELEMENT_ARRAY_BUFFER, priv->indices,
+      &priv->index_buffer_size);
+
+  /* every rectangle in a single draw */
+  gl->DrawElements (GL_TRIANGLES, priv->indices->len, GL_UNSIGNED_SHORT,
+      (gpointer) 0);
+
+  if (use_vao) {
+    gl->BindVertexArray (0);
+  } else {
+    gl->DisableVertexAttribArray (priv->position_loc);
+    gl->DisableVertexAttribArray (priv->texcoord_loc);
+    gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+  }
+  gl->BindBuffer (GL_ARRAY_BUFFER, 0);
+
+  gl->BindTexture (GL_TEXTURE_2D, 0);
+  gl->Disable (GL_BLEND);
+
+  gst_gl_context_clear_shader (compositor->context);
+}
@@ -43,6 +43,13 @@
 #define USING_GLES2(context) (gst_gl_context_get_gl_api (context) & GST_GL_API_GLES2)
 #define USING_GLES3(context) (gst_gl_context_get_gl_api (context) & GST_GL_API_GLES3)
 
+#ifndef GL_RGB10_A2
+#define GL_RGB10_A2 0x8059
+#endif
+#ifndef GL_UNSIGNED_INT_2_10_10_10_REV
+#define GL_UNSIGNED_INT_2_10_10_10_REV 0x8368
+#endif
+
 static void _do_upload (GstGLContext * context, GstGLUpload * upload);
 static gboolean _do_upload_fill (GstGLContext * context, GstGLUpload * upload);
 static gboolean _do_upload_make (GstGLContext * context, GstGLUpload * upload);
@@ -51,6 +58,10 @@ static gboolean _init_upload_fbo (GstGLContext * context, GstGLUpload * upload);
 static gboolean _gst_gl_upload_perform_with_data_unlocked (GstGLUpload * upload,
     GLuint texture_id, gpointer data[GST_VIDEO_MAX_PLANES]);
 static void _do_upload_with_meta (GstGLContext * context, GstGLUpload * upload);
+static void _do_upload_crop (GstGLContext * context, GstGLUpload * upload);
+static gboolean _create_shader (GstGLContext * context,
+    const gchar * vertex_src, const gchar * fragment_src,
+    GstGLShader ** out_shader);
 
 #if GST_GL_HAVE_OPENGL
 static gboolean _do_upload_draw_opengl (GstGLContext * context,
@@ -63,15 +74,14 @@ static gboolean _do_upload_draw_gles2 (GstGLContext * context,
 
 /* *INDENT-OFF* */
 
-/* BT. 601 standard with the following ranges:
- * Y = [16..235] (of 255)
- * Cb/Cr = [16..240] (of 255)
+/* matrix and range of the colorimetry of the input, from
+ * gst_gl_get_yuv_to_rgb_coefficients()
  */
 #define YUV_TO_RGB_COEFFICIENTS \
-      "const vec3 offset = vec3(-0.0625, -0.5, -0.5);\n" \
-      "const vec3 rcoeff = vec3(1.164, 0.000, 1.596);\n" \
-      "const vec3 gcoeff = vec3(1.164,-0.391,-0.813);\n" \
-      "const vec3 bcoeff = vec3(1.164, 2.018, 0.000);\n"
+      "uniform vec3 offset;\n" \
+      "uniform vec3 rcoeff;\n" \
+      "uniform vec3 gcoeff;\n" \
+      "uniform vec3 bcoeff;\n"
 
 /** GRAY16 to RGB conversion 
  *  data transfered as GL_LUMINANCE_ALPHA then convert back to GRAY16 
@@ -82,6 +92,12 @@ static gboolean _do_upload_draw_gles2 (GstGLContext * context,
 #define COMPOSE_WEIGHT \
     "const vec2 compose_weight = vec2(0.996109, 0.003891);\n"
 
+/** 10 bit components stored in 16 bits, same as COMPOSE_WEIGHT normalized
+ *  to 1023 instead of 65535: 255*256/1023 and 255/1023
+ * */
+#define COMPOSE_WEIGHT_10 \
+    "const vec2 compose_weight = vec2(63.812317, 0.249267);\n"
+
 #if GST_GL_HAVE_OPENGL
 
 static const char *frag_AYUV_opengl = {
@@ -123,6 +139,71 @@ static const char *frag_PLANAR_YUV_opengl = {
       "}"
 };
 
+/** 10 bit planar YUV to RGB conversion, each plane as GL_LUMINANCE_ALPHA
+ *  LE:a,r
+ *  BE:r,a */
+static const char *frag_PLANAR_YUV_10_opengl = {
+      "uniform sampler2D Ytex,Utex,Vtex;\n"
+      "uniform vec2 tex_scale0;\n"
+      "uniform vec2 tex_scale1;\n"
+      "uniform vec2 tex_scale2;\n"
+      YUV_TO_RGB_COEFFICIENTS
+      COMPOSE_WEIGHT_10
+      "void main(void) {\n"
+      "  float r,g,b;\n"
+      "  vec3 yuv;\n"
+      "  yuv.x=dot(texture2D(Ytex, gl_TexCoord[0].xy * tex_scale0).%c%c, compose_weight);\n"
+      "  yuv.y=dot(texture2D(Utex, gl_TexCoord[0].xy * tex_scale1).%c%c, compose_weight);\n"
+      "  yuv.z=dot(texture2D(Vtex, gl_TexCoord[0].xy * tex_scale2).%c%c, compose_weight);\n"
+      "  yuv += offset;\n"
+      "  r = dot(yuv, rcoeff);\n"
+      "  g = dot(yuv, gcoeff);\n"
+      "  b = dot(yuv, bcoeff);\n"
+      "  gl_FragColor=vec4(r,g,b,1.0);\n"
+      "}"
+};
+
+/** v210 to RGB conversion
+ *  one GL_RGB10_A2 texel per 32 bit word, 6 pixels in 4 words:
+ *  Cb0 Y0 Cr0 | Y1 Cb1 Y2 | Cr1 Y3 Cb2 | Y4 Cr2 Y5 */
+static const char *frag_v210_opengl = {
+      "uniform sampler2D tex;\n"
+      "uniform vec2 tex_scale0;\n"
+      "uniform vec2 tex_scale1;\n"
+      "uniform vec2 tex_scale2;\n"
+      "uniform float width;\n"
+      "uniform float words;\n"
+      YUV_TO_RGB_COEFFICIENTS
+      "void main(void) {\n"
+      "  float r,g,b;\n"
+      "  vec3 yuv, w0, w1, w2, w3;\n"
+      "  float x = floor(gl_TexCoord[0].x * width);\n"
+      "  float group = floor(x / 6.0);\n"
+      "  float i = x - group * 6.0;\n"
+      "  float s = (group * 4.0 + 0.5) / words;\n"
+      "  float t = gl_TexCoord[0].y;\n"
+      "  w0 = texture2D(tex, vec2(s, t)).rgb;\n"
+      "  w1 = texture2D(tex, vec2(s + 1.0 / words, t)).rgb;\n"
+      "  w2 = texture2D(tex, vec2(s + 2.0 / words, t)).rgb;\n"
+      "  w3 = texture2D(tex, vec2(s + 3.0 / words, t)).rgb;\n"
+      "  if (i < 2.0) {\n"
+      "    yuv.x = i < 1.0 ? w0.g : w1.r;\n"
+      "    yuv.yz = w0.rb;\n"
+      "  } else if (i < 4.0) {\n"
+      "    yuv.x = i < 3.0 ? w1.b : w2.g;\n"
+      "    yuv.yz = vec2(w1.g, w2.r);\n"
+      "  } else {\n"
+      "    yuv.x = i < 5.0 ? w3.r : w3.b;\n"
+      "    yuv.yz = vec2(w2.b, w3.g);\n"
+      "  }\n"
+      "  yuv += offset;\n"
+      "  r = dot(yuv, rcoeff);\n"
+      "  g = dot(yuv, gcoeff);\n"
+      "  b = dot(yuv, bcoeff);\n"
+      "  gl_FragColor=vec4(r,g,b,1.0);\n"
+      "}"
+};
+
 /** NV12/NV21 to RGB conversion */
 static const char *frag_NV12_NV21_opengl = {
       "uniform sampler2D Ytex,UVtex;\n"
@@ -289,6 +370,32 @@ static const char *frag_PLANAR_YUV_gles2 = {
       "}"
 };
 
+/** 10 bit planar YUV to RGB conversion, each plane as GL_LUMINANCE_ALPHA
+ *  LE:a,r
+ *  BE:r,a */
+static const char *frag_PLANAR_YUV_10_gles2 = {
+      "precision mediump float;\n"
+      "varying vec2 v_texcoord;\n"
+      "uniform sampler2D Ytex,Utex,Vtex;\n"
+      "uniform vec2 tex_scale0;\n"
+      "uniform vec2 tex_scale1;\n"
+      "uniform vec2 tex_scale2;\n"
+      YUV_TO_RGB_COEFFICIENTS
+      COMPOSE_WEIGHT_10
+      "void main(void) {\n"
+      "  float r,g,b;\n"
+      "  vec3 yuv;\n"
+      "  yuv.x=dot(texture2D(Ytex,v_texcoord * tex_scale0).%c%c, compose_weight);\n"
+      "  yuv.y=dot(texture2D(Utex,v_texcoord * tex_scale1).%c%c, compose_weight);\n"
+      "  yuv.z=dot(texture2D(Vtex,v_texcoord * tex_scale2).%c%c, compose_weight);\n"
+      "  yuv += offset;\n"
+      "  r = dot(yuv, rcoeff);\n"
+      "  g = dot(yuv, gcoeff);\n"
+      "  b = dot(yuv, bcoeff);\n"
+      "  gl_FragColor=vec4(r,g,b,1.0);\n"
+      "}"
+};
+
 /** NV12/NV21 to RGB conversion */
 static const char *frag_NV12_NV21_gles2 = {
       "precision mediump float;\n"
@@ -369,6 +476,7 @@ struct TexData
   gfloat tex_scaling[2];
   const gchar *shader_name;
   guint unpack_length;
+  guint filter;
 };
 
 struct _GstGLUploadPrivate
@@ -378,10 +486,16 @@ struct _GstGLUploadPrivate
 
   const gchar *YUY2_UYVY;
   const gchar *PLANAR_YUV;
+  const gchar *PLANAR_YUV_10;
+  const gchar *v210;
   const gchar *AYUV;
   const gchar *NV12_NV21;
   const gchar *REORDER;
   const gchar *COPY;
+
+  /* YUV to RGB conversion of the input colorimetry */
+  gfloat yuv_offset[3];
+  gfloat yuv_coeffs[9];
   const gchar *COMPOSE;
   const gchar *vert_shader;
 
@@ -394,6 +508,21 @@ struct _GstGLUploadPrivate
   GstVideoGLTextureUploadMeta *meta;
   guint tex_id;
   gboolean mapped;
+
+  /* left, top, right and bottom texture coordinates of the area of the
+   * frame that is drawn, from its GstVideoCropMeta */
+  gfloat tex_rect[4];
+
+  /* area of out_texture that is drawn, x, y, width and height.  It is the
+   * slot of the memory when uploading into a texture atlas */
+  gint out_rect[4];
+  gboolean out_in_atlas;
+
+  /* draws the cropped area of the RGBA texture of a GstGLMemory */
+  GstGLShader *crop_shader;
+  GLint crop_attr_position_loc;
+  GLint crop_attr_texture_loc;
+  guint crop_texture;
 };
 
 GST_DEBUG_CATEGORY_STATIC (gst_gl_upload_debug);
@@ -432,6 +561,9 @@ gst_gl_upload_init (GstGLUpload * upload)
 
   upload->shader_attr_position_loc = 0;
   upload->shader_attr_texture_loc = 0;
+
+  upload->priv->tex_rect[0] = upload->priv->tex_rect[1] = 0.0f;
+  upload->priv->tex_rect[2] = upload->priv->tex_rect[3] = 1.0f;
 }
 
 /**
@@ -455,6 +587,8 @@ gst_gl_upload_new (GstGLContext * context)
   if (USING_OPENGL (context)) {
     priv->YUY2_UYVY = frag_YUY2_UYVY_opengl;
     priv->PLANAR_YUV = frag_PLANAR_YUV_opengl;
+    priv->PLANAR_YUV_10 = frag_PLANAR_YUV_10_opengl;
+    priv->v210 = frag_v210_opengl;
     priv->AYUV = frag_AYUV_opengl;
     priv->REORDER = frag_REORDER_opengl;
     priv->COMPOSE = frag_COMPOSE_opengl;
@@ -468,6 +602,8 @@ gst_gl_upload_new (GstGLContext * context)
   if (USING_GLES2 (context)) {
     priv->YUY2_UYVY = frag_YUY2_UYVY_gles2;
     priv->PLANAR_YUV = frag_PLANAR_YUV_gles2;
+    priv->PLANAR_YUV_10 = frag_PLANAR_YUV_10_gles2;
+    priv->v210 = NULL;
     priv->AYUV = frag_AYUV_gles2;
     priv->REORDER = frag_REORDER_gles2;
     priv->COMPOSE = frag_COMPOSE_gles2;
@@ -512,6 +648,10 @@ gst_gl_upload_finalize (GObject * object)
     gst_object_unref (upload->shader);
     upload->shader = NULL;
   }
+  if (upload->priv->crop_shader) {
+    gst_object_unref (upload->priv->crop_shader);
+    upload->priv->crop_shader = NULL;
+  }
 
   if (upload->context) {
     gst_object_unref (upload->context);
@@ -574,6 +714,63 @@ gst_gl_upload_init_format (GstGLUpload * upload, GstVideoInfo in_info,
   return ret;
 }
 
+/* the texture is as deep as the input so that 10 bit formats keep their
+ * precision through the conversion, and as large as the output it is drawn
+ * at */
+static void
+_gen_tex_id (GstGLUpload * upload)
+{
+  GLenum tex_format;
+
+  tex_format = gst_gl_context_get_texture_format (upload->context,
+      &upload->in_info);
+
+  gst_gl_context_gen_texture_full (upload->context, &upload->priv->tex_id,
+      tex_format, GST_VIDEO_INFO_WIDTH (&upload->out_info),
+      GST_VIDEO_INFO_HEIGHT (&upload->out_info), 1);
+}
+
+static void
+_reset_tex_rect (GstGLUpload * upload)
+{
+  upload->priv->tex_rect[0] = upload->priv->tex_rect[1] = 0.0f;
+  upload->priv->tex_rect[2] = upload->priv->tex_rect[3] = 1.0f;
+}
+
+/* draws the area of the texture of @gl_mem given by tex_rect into our own
+ * texture, scaled to the whole output */
+static gboolean
+_crop_memory (GstGLUpload * upload, GstGLMemory * gl_mem, guint in_tex)
+{
+  gfloat *rect = upload->priv->tex_rect;
+  gfloat coords[4];
+  gfloat w, h;
+
+  /* the frame only covers part of the texture of an atlas */
+  gst_gl_memory_get_tex_coords (gl_mem, coords);
+  w = coords[2] - coords[0];
+  h = coords[3] - coords[1];
+  rect[0] = coords[0] + rect[0] * w;
+  rect[1] = coords[1] + rect[1] * h;
+  rect[2] = coords[0] + rect[2] * w;
+  rect[3] = coords[1] + rect[3] * h;
+
+  if (!upload->priv->tex_id)
+    _gen_tex_id (upload);
+
+  g_mutex_lock (&upload->lock);
+
+  upload->priv->crop_texture = in_tex;
+  upload->out_texture = upload->priv->tex_id;
+
+  gst_gl_context_thread_add (upload->context,
+      (GstGLContextThreadFunc) _do_upload_crop, upload);
+
+  g_mutex_unlock (&upload->lock);
+
+  return upload->priv->result;
+}
+
 /**
  * gst_gl_upload_perform_with_buffer:
  * @upload: a #GstGLUpload
@@ -583,6 +780,14 @@ gst_gl_upload_init_format (GstGLUpload * upload, GstVideoInfo in_info,
  * Uploads @buffer to the texture given by @tex_id.  @tex_id is valid
  * until gst_gl_upload_release_buffer() is called.
  *
+ * When @buffer has a #GstVideoCropMeta, only the cropped area is drawn and
+ * it is scaled to the output size given to gst_gl_upload_init_format(),
+ * which should be the size of the crop to keep its aspect ratio.  Frames
+ * in system memory are cropped while they are converted; a #GstGLMemory
+ * costs one draw into another texture instead of being used directly.  So
+ * does a #GstGLMemory allocated from a #GstGLTextureAtlas, which only covers
+ * part of its texture.
+ *
  * Returns: whether the upload was successful
  */
 gboolean
@@ -591,38 +796,60 @@ gst_gl_upload_perform_with_buffer (GstGLUpload * upload, GstBuffer * buffer,
 {
   GstMemory *mem;
   GstVideoGLTextureUploadMeta *gl_tex_upload_meta;
+  gboolean cropped, ret;
 
   g_return_val_if_fail (upload != NULL, FALSE);
   g_return_val_if_fail (buffer != NULL, FALSE);
   g_return_val_if_fail (tex_id != NULL, FALSE);
   g_return_val_if_fail (gst_buffer_n_memory (buffer) > 0, FALSE);
 
+  cropped = gst_gl_get_crop_tex_coords (buffer, &upload->in_info,
+      upload->priv->tex_rect);
+
   /* GstGLMemory */
   mem = gst_buffer_peek_memory (buffer, 0);
 
-  if (gst_is_gl_memory (mem)) {
+  /* planes are converted from their system memory below */
+  if (gst_is_gl_memory (mem) && !GST_GL_MEMORY_IS_PLANE (mem)) {
     GST_LOG_OBJECT (upload, "Attempting upload with GstGLMemory");
     /* Assuming only one memory */
     if (!gst_video_frame_map (&upload->priv->frame, &upload->in_info, buffer,
             GST_MAP_READ | GST_MAP_GL)) {
       GST_ERROR_OBJECT (upload, "Failed to map memory");
+      _reset_tex_rect (upload);
       return FALSE;
     }
 
     *tex_id = *(guint *) upload->priv->frame.data[0];
-
     upload->priv->mapped = TRUE;
+
+    /* another context may have rendered it */
+    gst_gl_memory_wait_sync ((GstGLMemory *) mem, upload->context);
+
+    /* callers expect the frame to fill the whole texture.  Elements that
+     * can sample a slot of an atlas in place, like GstGLMixer, map the
+     * memory themselves and never get here */
+    if (cropped || ((GstGLMemory *) mem)->atlas) {
+      ret = _crop_memory (upload, (GstGLMemory *) mem, *tex_id);
+      _reset_tex_rect (upload);
+      if (!ret) {
+        GST_ERROR_OBJECT (upload, "Failed to crop memory");
+        return FALSE;
+      }
+
+      *tex_id = upload->priv->tex_id;
+    }
+
     return TRUE;
   }
 
   if (!upload->priv->tex_id)
-    gst_gl_context_gen_texture (upload->context, &upload->priv->tex_id,
-        GST_VIDEO_INFO_FORMAT (&upload->in_info),
-        GST_VIDEO_INFO_WIDTH (&upload->in_info),
-        GST_VIDEO_INFO_HEIGHT (&upload->in_info));
+    _gen_tex_id (upload);
 
-  /* GstVideoGLTextureUploadMeta */
-  gl_tex_upload_meta = gst_buffer_get_video_gl_texture_upload_meta (buffer);
+  /* GstVideoGLTextureUploadMeta, the producer uploads the whole frame so
+   * cropped frames are converted from their data */
+  gl_tex_upload_meta = cropped ? NULL :
+      gst_buffer_get_video_gl_texture_upload_meta (buffer);
   if (gl_tex_upload_meta) {
     guint texture_ids[] = { 0, 0, 0, 0 };
     GST_LOG_OBJECT (upload, "Attempting upload with "
@@ -645,13 +872,15 @@ gst_gl_upload_perform_with_buffer (GstGLUpload * upload, GstBuffer * buffer,
   if (!gst_video_frame_map (&upload->priv->frame, &upload->in_info, buffer,
           GST_MAP_READ)) {
     GST_ERROR_OBJECT (upload, "Failed to map memory");
+    _reset_tex_rect (upload);
     return FALSE;
   }
 
-  if (!gst_gl_upload_perform_with_data (upload, upload->priv->tex_id,
-          upload->priv->frame.data)) {
+  ret = gst_gl_upload_perform_with_data (upload, upload->priv->tex_id,
+      upload->priv->frame.data);
+  _reset_tex_rect (upload);
+  if (!ret)
     return FALSE;
-  }
 
   upload->priv->mapped = TRUE;
   *tex_id = upload->priv->tex_id;
@@ -713,7 +942,20 @@ gst_gl_upload_perform_with_memory (GstGLUpload * upload, GstGLMemory * gl_mem)
 
   g_mutex_lock (&upload->lock);
 
-  ret = _upload_memory_unlocked (upload, gl_mem, gl_mem->tex_id);
+  if (gl_mem->atlas) {
+    /* draw straight into the memory's slot */
+    upload->priv->out_rect[0] = gl_mem->tex_x;
+    upload->priv->out_rect[1] = gl_mem->tex_y;
+    upload->priv->out_rect[2] = GST_VIDEO_INFO_WIDTH (&gl_mem->v_info);
+    upload->priv->out_rect[3] = GST_VIDEO_INFO_HEIGHT (&gl_mem->v_info);
+    upload->priv->out_in_atlas = TRUE;
+
+    ret = _upload_memory_unlocked (upload, gl_mem, gl_mem->tex_id);
+
+    upload->priv->out_in_atlas = FALSE;
+  } else {
+    ret = _upload_memory_unlocked (upload, gl_mem, gl_mem->tex_id);
+  }
 
   g_mutex_unlock (&upload->lock);
 
@@ -759,7 +1001,7 @@ _do_upload_for_meta (GstGLUpload * upload, GstVideoGLTextureUploadMeta * meta)
   /* GstGLMemory */
   mem = gst_buffer_peek_memory (upload->priv->buffer, 0);
 
-  if (gst_is_gl_memory (mem)) {
+  if (gst_is_gl_memory (mem) && !GST_GL_MEMORY_IS_PLANE (mem)) {
     if (GST_GL_MEMORY_FLAG_IS_SET (mem, GST_GL_MEMORY_FLAG_NEED_UPLOAD)) {
       ret = _upload_memory_unlocked (upload, (GstGLMemory *) mem,
           upload->out_texture);
@@ -815,6 +1057,69 @@ error:
   upload->priv->result = FALSE;
 }
 
+/*
+ * Draws the cropped area of an RGBA texture with the normal draw function
+ * by temporarily replacing the conversion shader and input textures.
+ */
+static void
+_do_upload_crop (GstGLContext * context, GstGLUpload * upload)
+{
+  GstGLUploadPrivate *priv = upload->priv;
+  struct TexData tex_info;
+  GstGLShader *shader;
+  GLint position_loc, texture_loc;
+  guint n_textures, in_tex;
+
+  if (!upload->fbo && !_init_upload_fbo (context, upload))
+    goto error;
+
+  if (!priv->crop_shader) {
+    if (!_create_shader (context, priv->vert_shader, priv->COPY,
+            &priv->crop_shader))
+      goto error;
+
+    if (USING_GLES2 (context)) {
+      priv->crop_attr_position_loc =
+          gst_gl_shader_get_attribute_location (priv->crop_shader,
+          "a_position");
+      priv->crop_attr_texture_loc =
+          gst_gl_shader_get_attribute_location (priv->crop_shader,
+          "a_texcoord");
+    }
+  }
+
+  shader = upload->shader;
+  position_loc = upload->shader_attr_position_loc;
+  texture_loc = upload->shader_attr_texture_loc;
+  n_textures = priv->n_textures;
+  tex_info = priv->texture_info[0];
+  in_tex = upload->in_texture[0];
+
+  upload->shader = priv->crop_shader;
+  upload->shader_attr_position_loc = priv->crop_attr_position_loc;
+  upload->shader_attr_texture_loc = priv->crop_attr_texture_loc;
+  priv->n_textures = 1;
+  priv->texture_info[0].shader_name = "tex";
+  priv->texture_info[0].tex_scaling[0] = 1.0f;
+  priv->texture_info[0].tex_scaling[1] = 1.0f;
+  priv->texture_info[0].filter = GL_LINEAR;
+  upload->in_texture[0] = priv->crop_texture;
+
+  priv->result = priv->draw (context, upload);
+
+  upload->shader = shader;
+  upload->shader_attr_position_loc = position_loc;
+  upload->shader_attr_texture_loc = texture_loc;
+  priv->n_textures = n_textures;
+  priv->texture_info[0] = tex_info;
+  upload->in_texture[0] = in_tex;
+
+  return;
+
+error:
+  priv->result = FALSE;
+}
+
 /**
  * gst_gl_upload_perform_with_gl_texture_upload_meta:
  * @upload: a #GstGLUpload
@@ -1011,6 +1316,9 @@ _init_upload (GstGLContext * context, GstGLUpload * upload)
   GST_INFO ("Initializing texture upload for format:%s",
       gst_video_format_to_string (v_format));
 
+  gst_gl_get_yuv_to_rgb_coefficients (&upload->in_info,
+      upload->priv->yuv_offset, upload->priv->yuv_coeffs);
+
   if (!gl->CreateProgramObject && !gl->CreateProgram) {
     gst_gl_context_set_error (context,
         "Cannot upload YUV formats without OpenGL shaders");
@@ -1036,6 +1344,32 @@ _init_upload (GstGLContext * context, GstGLUpload * upload)
       free_frag_prog = FALSE;
       upload->priv->n_textures = 3;
       break;
+    case GST_VIDEO_FORMAT_I420_10LE:
+    case GST_VIDEO_FORMAT_I422_10LE:
+    case GST_VIDEO_FORMAT_Y444_10LE:
+      frag_prog = g_strdup_printf (upload->priv->PLANAR_YUV_10, 'a', 'r',
+          'a', 'r', 'a', 'r');
+      free_frag_prog = TRUE;
+      upload->priv->n_textures = 3;
+      break;
+    case GST_VIDEO_FORMAT_I420_10BE:
+    case GST_VIDEO_FORMAT_I422_10BE:
+    case GST_VIDEO_FORMAT_Y444_10BE:
+      frag_prog = g_strdup_printf (upload->priv->PLANAR_YUV_10, 'r', 'a',
+          'r', 'a', 'r', 'a');
+      free_frag_prog = TRUE;
+      upload->priv->n_textures = 3;
+      break;
+    case GST_VIDEO_FORMAT_v210:
+      if (!upload->priv->v210) {
+        gst_gl_context_set_error (context,
+            "v210 upload requires desktop OpenGL");
+        goto error;
+      }
+      frag_prog = (gchar *) upload->priv->v210;
+      free_frag_prog = FALSE;
+      upload->priv->n_textures = 1;
+      break;
     case GST_VIDEO_FORMAT_NV12:
       frag_prog = g_strdup_printf (upload->priv->NV12_NV21, 'r', 'a');
       free_frag_prog = TRUE;
@@ -1266,6 +1600,9 @@ _do_upload_make (GstGLContext * context, GstGLUpload * upload)
   in_height = GST_VIDEO_INFO_HEIGHT (&upload->in_info);
   v_format = GST_VIDEO_INFO_FORMAT (&upload->in_info);
 
+  for (i = 0; i < GST_VIDEO_MAX_PLANES; i++)
+    tex[i].filter = GL_LINEAR;
+
   switch (v_format) {
     case GST_VIDEO_FORMAT_RGBx:
     case GST_VIDEO_FORMAT_BGRx:
@@ -1350,6 +1687,46 @@ _do_upload_make (GstGLContext * context, GstGLUpload * upload)
       tex[2].height = in_height;
       tex[2].shader_name = "Vtex";
       break;
+    case GST_VIDEO_FORMAT_I420_10LE:
+    case GST_VIDEO_FORMAT_I420_10BE:
+    case GST_VIDEO_FORMAT_I422_10LE:
+    case GST_VIDEO_FORMAT_I422_10BE:
+    case GST_VIDEO_FORMAT_Y444_10LE:
+    case GST_VIDEO_FORMAT_Y444_10BE:
+    {
+      guint chroma_height = in_height;
+
+      if (v_format == GST_VIDEO_FORMAT_I420_10LE
+          || v_format == GST_VIDEO_FORMAT_I420_10BE)
+        chroma_height = GST_ROUND_UP_2 (in_height) / 2;
+
+      tex[0].internal_format = GL_LUMINANCE_ALPHA;
+      tex[0].format = GL_LUMINANCE_ALPHA;
+      tex[0].type = GL_UNSIGNED_BYTE;
+      tex[0].height = in_height;
+      tex[0].shader_name = "Ytex";
+      tex[1].internal_format = GL_LUMINANCE_ALPHA;
+      tex[1].format = GL_LUMINANCE_ALPHA;
+      tex[1].type = GL_UNSIGNED_BYTE;
+      tex[1].height = chroma_height;
+      tex[1].shader_name = "Utex";
+      tex[2].internal_format = GL_LUMINANCE_ALPHA;
+      tex[2].format = GL_LUMINANCE_ALPHA;
+      tex[2].type = GL_UNSIGNED_BYTE;
+      tex[2].height = chroma_height;
+      tex[2].shader_name = "Vtex";
+      break;
+    }
+    case GST_VIDEO_FORMAT_v210:
+      /* one texel per word, the shader picks the components so they must
+       * not be interpolated */
+      tex[0].internal_format = GL_RGB10_A2;
+      tex[0].format = GL_RGBA;
+      tex[0].type = GL_UNSIGNED_INT_2_10_10_10_REV;
+      tex[0].height = in_height;
+      tex[0].shader_name = "tex";
+      tex[0].filter = GL_NEAREST;
+      break;
     case GST_VIDEO_FORMAT_I420:
     case GST_VIDEO_FORMAT_YV12:
       tex[0].internal_format = GL_LUMINANCE;
@@ -1378,7 +1755,10 @@ _do_upload_make (GstGLContext * context, GstGLUpload * upload)
   for (i = 0; i < upload->priv->n_textures; i++) {
     guint plane_stride, plane_width;
 
-    if (GST_VIDEO_INFO_IS_YUV (&upload->in_info))
+    if (v_format == GST_VIDEO_FORMAT_v210)
+      /* 4 words for every 6 pixels */
+      plane_width = (GST_VIDEO_INFO_WIDTH (&upload->in_info) + 5) / 6 * 4;
+    else if (GST_VIDEO_INFO_IS_YUV (&upload->in_info))
       /* For now component width and plane width are the same and the
        * plane-component mapping matches
        */
@@ -1538,6 +1918,84 @@ _do_upload_fill (GstGLContext * context, GstGLUpload * upload)
   return TRUE;
 }
 
+/* called by the draw functions (in the gl thread) */
+static void
+_set_yuv_uniforms (GstGLUpload * upload)
+{
+  gfloat *coeffs = upload->priv->yuv_coeffs;
+
+  if (!GST_VIDEO_INFO_IS_YUV (&upload->in_info))
+    return;
+
+  gst_gl_shader_set_uniform_3fv (upload->shader, "offset", 1,
+      upload->priv->yuv_offset);
+  gst_gl_shader_set_uniform_3fv (upload->shader, "rcoeff", 1, &coeffs[0]);
+  gst_gl_shader_set_uniform_3fv (upload->shader, "gcoeff", 1, &coeffs[3]);
+  gst_gl_shader_set_uniform_3fv (upload->shader, "bcoeff", 1, &coeffs[6]);
+}
+
+/* Binds the FBO to draw into out_texture.  The depth buffer only has the
+ * size of the frame so it is detached while drawing into the slot of an
+ * atlas, the upload does not use it anyway. */
+static void
+_bind_output (GstGLContext * context, GstGLUpload * upload)
+{
+  GstGLFuncs *gl = context->gl_vtable;
+
+  gl->BindFramebuffer (GL_FRAMEBUFFER, upload->fbo);
+
+  /* setup a texture to render to */
+  gl->BindTexture (GL_TEXTURE_2D, upload->out_texture);
+
+  /* attach the texture to the FBO to renderer to */
+  gl->FramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+      GL_TEXTURE_2D, upload->out_texture, 0);
+
+  if (upload->priv->out_in_atlas) {
+    gl->FramebufferRenderbuffer (GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+        GL_RENDERBUFFER, 0);
+    if (USING_OPENGL (context))
+      gl->FramebufferRenderbuffer (GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT,
+          GL_RENDERBUFFER, 0);
+  }
+}
+
+static void
+_unbind_output (GstGLContext * context, GstGLUpload * upload)
+{
+  GstGLFuncs *gl = context->gl_vtable;
+
+  if (upload->priv->out_in_atlas) {
+    gl->FramebufferRenderbuffer (GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+        GL_RENDERBUFFER, upload->depth_buffer);
+    if (USING_OPENGL (context))
+      gl->FramebufferRenderbuffer (GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT,
+          GL_RENDERBUFFER, upload->depth_buffer);
+  }
+
+  gl->BindFramebuffer (GL_FRAMEBUFFER, 0);
+}
+
+/* the other slots of an atlas are left alone, the frame covers the whole
+ * viewport so there is nothing to clear */
+static void
+_set_output_viewport (GstGLContext * context, GstGLUpload * upload)
+{
+  GstGLFuncs *gl = context->gl_vtable;
+  gint *rect = upload->priv->out_rect;
+
+  if (upload->priv->out_in_atlas) {
+    gl->Viewport (rect[0], rect[1], rect[2], rect[3]);
+    return;
+  }
+
+  gl->Viewport (0, 0, GST_VIDEO_INFO_WIDTH (&upload->out_info),
+      GST_VIDEO_INFO_HEIGHT (&upload->out_info));
+
+  gl->ClearColor (0.0, 0.0, 0.0, 0.0);
+  gl->Clear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
 #if GST_GL_HAVE_OPENGL
 /* called by _do_upload (in the gl thread) */
 static gboolean
@@ -1546,6 +2004,7 @@ _do_upload_draw_opengl (GstGLContext * context, GstGLUpload * upload)
   GstGLFuncs *gl;
   guint out_width, out_height;
   struct TexData *tex = upload->priv->texture_info;
+  gfloat *rect = upload->priv->tex_rect;
   gint i;
 
   GLfloat verts[8] = { 1.0f, -1.0f,
@@ -1553,10 +2012,10 @@ _do_upload_draw_opengl (GstGLContext * context, GstGLUpload * upload)
     -1.0f, 1.0f,
     1.0f, 1.0f
   };
-  GLfloat texcoords[8] = { 1.0f, 0.0f,
-    0.0f, 0.0f,
-    0.0f, 1.0f,
-    1.0f, 1.0f
+  GLfloat texcoords[8] = { rect[2], rect[1],
+    rect[0], rect[1],
+    rect[0], rect[3],
+    rect[2], rect[3]
   };
 
   gl = context->gl_vtable;
@@ -1564,15 +2023,8 @@ _do_upload_draw_opengl (GstGLContext * context, GstGLUpload * upload)
   out_width = GST_VIDEO_INFO_WIDTH (&upload->out_info);
   out_height = GST_VIDEO_INFO_HEIGHT (&upload->out_info);
 
-  gl->BindFramebuffer (GL_FRAMEBUFFER, upload->fbo);
-
-  /* setup a texture to render to */
   gl->Enable (GL_TEXTURE_2D);
-  gl->BindTexture (GL_TEXTURE_2D, upload->out_texture);
-
-  /* attach the texture to the FBO to renderer to */
-  gl->FramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-      GL_TEXTURE_2D, upload->out_texture, 0);
+  _bind_output (context, upload);
 
   gst_gl_context_clear_shader (context);
 
@@ -1587,20 +2039,25 @@ _do_upload_draw_opengl (GstGLContext * context, GstGLUpload * upload)
   gl->PushMatrix ();
   gl->LoadIdentity ();
 
-  gl->Viewport (0, 0, out_width, out_height);
+  _set_output_viewport (context, upload);
 
   gl->DrawBuffer (GL_COLOR_ATTACHMENT0);
 
-  gl->ClearColor (0.0, 0.0, 0.0, 0.0);
-  gl->Clear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
   gst_gl_shader_use (upload->shader);
+  _set_yuv_uniforms (upload);
 
   gl->MatrixMode (GL_PROJECTION);
   gl->LoadIdentity ();
 
   gl->Enable (GL_TEXTURE_2D);
 
+  if (GST_VIDEO_INFO_FORMAT (&upload->in_info) == GST_VIDEO_FORMAT_v210) {
+    gst_gl_shader_set_uniform_1f (upload->shader, "width",
+        (gfloat) GST_VIDEO_INFO_WIDTH (&upload->in_info));
+    gst_gl_shader_set_uniform_1f (upload->shader, "words",
+        (gfloat) tex[0].width);
+  }
+
   for (i = upload->priv->n_textures - 1; i >= 0; i--) {
     gchar *scale_name = g_strdup_printf ("tex_scale%u", i);
 
@@ -1611,8 +2068,8 @@ _do_upload_draw_opengl (GstGLContext * context, GstGLUpload * upload)
     g_free (scale_name);
 
     gl->BindTexture (GL_TEXTURE_2D, upload->in_texture[i]);
-    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, tex[i].filter);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, tex[i].filter);
     gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   }
@@ -1643,7 +2100,7 @@ _do_upload_draw_opengl (GstGLContext * context, GstGLUpload * upload)
 
   gst_gl_context_check_framebuffer_status (context);
 
-  gl->BindFramebuffer (GL_FRAMEBUFFER, 0);
+  _unbind_output (context, upload);
 
   return TRUE;
 }
@@ -1655,47 +2112,35 @@ _do_upload_draw_gles2 (GstGLContext * context, GstGLUpload * upload)
 {
   GstGLFuncs *gl;
   struct TexData *tex = upload->priv->texture_info;
-  guint out_width, out_height;
+  gfloat *rect = upload->priv->tex_rect;
   gint i;
 
   GLint viewport_dim[4];
 
   const GLfloat vVertices[] = { 1.0f, -1.0f, 0.0f,
-    1.0f, 0.0f,
+    rect[2], rect[1],
     -1.0f, -1.0f, 0.0f,
-    0.0f, 0.0f,
+    rect[0], rect[1],
     -1.0f, 1.0f, 0.0f,
-    0.0f, 1.0f,
+    rect[0], rect[3],
     1.0f, 1.0f, 0.0f,
-    1.0f, 1.0f
+    rect[2], rect[3]
   };
 
   GLushort indices[] = { 0, 1, 2, 0, 2, 3 };
 
   gl = context->gl_vtable;
 
-  out_width = GST_VIDEO_INFO_WIDTH (&upload->out_info);
-  out_height = GST_VIDEO_INFO_HEIGHT (&upload->out_info);
-
-  gl->BindFramebuffer (GL_FRAMEBUFFER, upload->fbo);
-
-  /* setup a texture to render to */
-  gl->BindTexture (GL_TEXTURE_2D, upload->out_texture);
-
-  /* attach the texture to the FBO to renderer to */
-  gl->FramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-      GL_TEXTURE_2D, upload->out_texture, 0);
+  _bind_output (context, upload);
 
   gst_gl_context_clear_shader (context);
 
   gl->GetIntegerv (GL_VIEWPORT, viewport_dim);
 
-  gl->Viewport (0, 0, out_width, out_height);
-
-  gl->ClearColor (0.0, 0.0, 0.0, 0.0);
-  gl->Clear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  _set_output_viewport (context, upload);
 
   gst_gl_shader_use (upload->shader);
+  _set_yuv_uniforms (upload);
 
   gl->VertexAttribPointer (upload->shader_attr_position_loc, 3,
       GL_FLOAT, GL_FALSE, 5 * sizeof (GLfloat), vVertices);
@@ -1716,8 +2161,8 @@ _do_upload_draw_gles2 (GstGLContext * context, GstGLUpload * upload)
     g_free (scale_name);
 
     gl->BindTexture (GL_TEXTURE_2D, upload->in_texture[i]);
-    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, tex[i].filter);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, tex[i].filter);
     gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   }
@@ -1732,7 +2177,7 @@ _do_upload_draw_gles2 (GstGLContext * context, GstGLUpload * upload)
 
   gst_gl_context_check_framebuffer_status (context);
 
-  gl->BindFramebuffer (GL_FRAMEBUFFER, 0);
+  _unbind_output (context, upload);
 
   return TRUE;
 }
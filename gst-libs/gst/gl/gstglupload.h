@@ -90,7 +90,9 @@ struct _GstGLUploadClass
 #define GST_GL_UPLOAD_FORMATS "{ RGB, RGBx, RGBA, BGR, BGRx, BGRA, xRGB, " \
                                "xBGR, ARGB, ABGR, Y444, I420, YV12, Y42B, " \
                                "Y41B, NV12, NV21, YUY2, UYVY, AYUV, " \
-                               "GRAY8, GRAY16_LE, GRAY16_BE }"
+                               "GRAY8, GRAY16_LE, GRAY16_BE, " \
+                               "I420_10LE, I420_10BE, I422_10LE, " \
+                               "I422_10BE, Y444_10LE, Y444_10BE, v210 }"
 
 /**
  * GST_GL_UPLOAD_VIDEO_CAPS:
@@ -27,6 +27,7 @@
 
 #include "gl.h"
 #include "gstglutils.h"
+#include "gstglutils_private.h"
 
 #ifndef GL_FRAMEBUFFER_UNDEFINED
 #define GL_FRAMEBUFFER_UNDEFINED          0x8219
@@ -43,6 +44,36 @@
 #ifndef GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS
 #define GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS 0x8CD9
 #endif
+#ifndef GL_RED
+#define GL_RED                            0x1903
+#endif
+#ifndef GL_RG
+#define GL_RG                             0x8227
+#endif
+#ifndef GL_R8
+#define GL_R8                             0x8229
+#endif
+#ifndef GL_RG8
+#define GL_RG8                            0x822B
+#endif
+#ifndef GL_RGB10_A2
+#define GL_RGB10_A2                       0x8059
+#endif
+#ifndef GL_RGBA16F
+#define GL_RGBA16F                        0x881A
+#endif
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT                     0x140B
+#endif
+#ifndef GL_HALF_FLOAT_OES
+#define GL_HALF_FLOAT_OES                 0x8D61
+#endif
+#ifndef GL_UNSIGNED_INT_2_10_10_10_REV
+#define GL_UNSIGNED_INT_2_10_10_10_REV    0x8368
+#endif
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL              0x813D
+#endif
 
 #define USING_OPENGL(context) (gst_gl_context_get_gl_apie (context) & GST_GL_API_OPENGL)
 #define USING_OPENGL3(context) (gst_gl_context_get_gl_apie (context) & GST_GL_API_OPENGL3)
@@ -93,24 +124,92 @@ gst_gl_context_check_framebuffer_status (GstGLContext * context)
 typedef struct _GenTexture
 {
   guint width, height;
-  GstVideoFormat format;
+  GLenum internal_format;
+  guint n_levels;
   guint result;
 } GenTexture;
 
+/* the format and type glTexImage2D needs for an internal format */
+static gboolean
+_internal_format_to_format_type (GstGLContext * context,
+    GLenum internal_format, GLenum * format, GLenum * type)
+{
+  gboolean gles2 = (gst_gl_context_get_gl_api (context) & GST_GL_API_GLES2);
+  /* plain GLES2 has no red/green textures, fall back to luminance */
+  gboolean luminance = gles2 && !context->gl_vtable->TexStorage2D;
+
+  switch (internal_format) {
+    case GL_RGBA8:
+      *format = GL_RGBA;
+      *type = GL_UNSIGNED_BYTE;
+      break;
+    case GL_R8:
+      *format = luminance ? GL_LUMINANCE : GL_RED;
+      *type = GL_UNSIGNED_BYTE;
+      break;
+    case GL_RG8:
+      *format = luminance ? GL_LUMINANCE_ALPHA : GL_RG;
+      *type = GL_UNSIGNED_BYTE;
+      break;
+    case GL_RGB10_A2:
+      *format = GL_RGBA;
+      *type = GL_UNSIGNED_INT_2_10_10_10_REV;
+      break;
+    case GL_RGBA16F:
+      *format = GL_RGBA;
+      *type = gles2 ? GL_HALF_FLOAT_OES : GL_HALF_FLOAT;
+      break;
+    default:
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
 static void
 _gen_texture (GstGLContext * context, GenTexture * data)
 {
   const GstGLFuncs *gl = context->gl_vtable;
-
-  GST_TRACE ("Generating texture format:%u dimensions:%ux%u", data->format,
-      data->width, data->height);
+  GLenum format, type;
+  guint i;
+
+  GST_TRACE ("Generating texture internal format:0x%x dimensions:%ux%u "
+      "levels:%u", data->internal_format, data->width, data->height,
+      data->n_levels);
+
+  if (!_internal_format_to_format_type (context, data->internal_format,
+          &format, &type)) {
+    gst_gl_context_set_error (context, "Unsupported internal format 0x%x",
+        data->internal_format);
+    data->result = 0;
+    return;
+  }
 
   gl->GenTextures (1, &data->result);
   gl->BindTexture (GL_TEXTURE_2D, data->result);
-  gl->TexImage2D (GL_TEXTURE_2D, 0, GL_RGBA8, data->width,
-      data->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+  if (gl->TexStorage2D) {
+    /* immutable, later updates only ever touch the contents */
+    gl->TexStorage2D (GL_TEXTURE_2D, data->n_levels, data->internal_format,
+        data->width, data->height);
+  } else {
+    /* GLES2 wants the unsized format */
+    GLint tex_format = (gst_gl_context_get_gl_api (context) & GST_GL_API_GLES2)
+        ? format : data->internal_format;
+
+    for (i = 0; i < data->n_levels; i++) {
+      gl->TexImage2D (GL_TEXTURE_2D, i, tex_format, MAX (1, data->width >> i),
+          MAX (1, data->height >> i), 0, format, type, NULL);
+    }
+
+    if (gst_gl_context_get_gl_api (context) & GST_GL_API_OPENGL)
+      gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+          data->n_levels - 1);
+  }
 
   gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  /* only the first level is ever written here, a mipmap filter would
+   * sample undefined levels */
   gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -118,11 +217,41 @@ _gen_texture (GstGLContext * context, GenTexture * data)
   GST_LOG ("generated texture id:%d", data->result);
 }
 
+/**
+ * gst_gl_context_gen_texture_full:
+ * @context: a #GstGLContext
+ * @pTexture: (out): the generated texture
+ * @internal_format: one of GL_RGBA8, GL_R8, GL_RG8, GL_RGB10_A2 or
+ *                   GL_RGBA16F
+ * @width: the width of the texture
+ * @height: the height of the texture
+ * @n_levels: the number of mipmap levels or 0 for a complete mipmap chain
+ *
+ * Generates a texture with storage for @n_levels levels of @internal_format.
+ * When glTexStorage2D() is available the storage is immutable so the
+ * texture can only be updated with glTexSubImage2D(), glCopyTexSubImage2D()
+ * or by rendering into it.
+ *
+ * The texture is filtered with GL_LINEAR.  Callers filling the other levels,
+ * e.g. with glGenerateMipmap(), select a mipmap minification filter
+ * themselves.
+ *
+ * @pTexture is set to 0 if @internal_format is not supported.
+ */
 void
-gst_gl_context_gen_texture (GstGLContext * context, GLuint * pTexture,
-    GstVideoFormat v_format, GLint width, GLint height)
+gst_gl_context_gen_texture_full (GstGLContext * context, GLuint * pTexture,
+    GLenum internal_format, GLint width, GLint height, guint n_levels)
 {
-  GenTexture data = { width, height, v_format, 0 };
+  GenTexture data = { width, height, internal_format, n_levels, 0 };
+
+  if (n_levels == 0) {
+    gint size = MAX (width, height);
+
+    while (size > 0) {
+      data.n_levels++;
+      size >>= 1;
+    }
+  }
 
   gst_gl_context_thread_add (context, (GstGLContextThreadFunc) _gen_texture,
       &data);
@@ -130,6 +259,226 @@ gst_gl_context_gen_texture (GstGLContext * context, GLuint * pTexture,
   *pTexture = data.result;
 }
 
+void
+gst_gl_context_gen_texture (GstGLContext * context, GLuint * pTexture,
+    GstVideoFormat v_format, GLint width, GLint height)
+{
+  gst_gl_context_gen_texture_full (context, pTexture, GL_RGBA8, width, height,
+      1);
+}
+
+/**
+ * gst_gl_context_get_texture_format:
+ * @context: a #GstGLContext
+ * @info: the #GstVideoInfo of the frames to store
+ *
+ * Picks the internal format of the textures holding frames of @info so that
+ * they keep the precision of its components: GL_RGBA16F for components of
+ * more than 10 bits when float textures are available, GL_RGB10_A2 for
+ * components of more than 8 bits and GL_RGBA8 otherwise.  GLES2 contexts
+ * always get GL_RGBA8 as they cannot render into the deeper formats.
+ *
+ * Returns: an internal format for gst_gl_context_gen_texture_full()
+ */
+GLenum
+gst_gl_context_get_texture_format (GstGLContext * context, GstVideoInfo * info)
+{
+  GstGLAPI gl_api = gst_gl_context_get_gl_api (context);
+  guint depth = 0;
+  guint i;
+
+  for (i = 0; i < GST_VIDEO_INFO_N_COMPONENTS (info); i++)
+    depth = MAX (depth, GST_VIDEO_INFO_COMP_DEPTH (info, i));
+
+  if (depth <= 8 || !(gl_api & (GST_GL_API_OPENGL | GST_GL_API_OPENGL3
+              | GST_GL_API_GLES3)))
+    return GL_RGBA8;
+
+  if (depth > 10 && (gl_api & GST_GL_API_OPENGL3
+          || gst_gl_context_check_feature (context, "GL_ARB_texture_float")))
+    return GL_RGBA16F;
+
+  return GL_RGB10_A2;
+}
+
+/**
+ * gst_gl_get_crop_tex_coords:
+ * @buffer: a #GstBuffer
+ * @info: the #GstVideoInfo of @buffer
+ * @tex_coords: (out): the normalized left, top, right and bottom texture
+ *              coordinates
+ *
+ * Retrieves the area of a texture holding the whole frame of @buffer that
+ * is given by the #GstVideoCropMeta of @buffer, so that drawing with
+ * @tex_coords crops the frame without copying it.  @tex_coords covers the
+ * whole texture when @buffer has no crop metadata.
+ *
+ * Returns: whether @buffer is cropped
+ */
+gboolean
+gst_gl_get_crop_tex_coords (GstBuffer * buffer, GstVideoInfo * info,
+    gfloat tex_coords[4])
+{
+  GstVideoCropMeta *crop;
+  guint width = GST_VIDEO_INFO_WIDTH (info);
+  guint height = GST_VIDEO_INFO_HEIGHT (info);
+  guint right, bottom;
+
+  tex_coords[0] = tex_coords[1] = 0.0f;
+  tex_coords[2] = tex_coords[3] = 1.0f;
+
+  crop = gst_buffer_get_video_crop_meta (buffer);
+  if (!crop || crop->width == 0 || crop->height == 0 || width == 0
+      || height == 0 || crop->x >= width || crop->y >= height)
+    return FALSE;
+
+  right = MIN (crop->x + crop->width, width);
+  bottom = MIN (crop->y + crop->height, height);
+  if (crop->x == 0 && crop->y == 0 && right == width && bottom == height)
+    return FALSE;
+
+  tex_coords[0] = (gfloat) crop->x / width;
+  tex_coords[1] = (gfloat) crop->y / height;
+  tex_coords[2] = (gfloat) right / width;
+  tex_coords[3] = (gfloat) bottom / height;
+
+  return TRUE;
+}
+
+/* luma weights of the red and blue components */
+static void
+_get_kr_kb (GstVideoColorMatrix matrix, gdouble * kr, gdouble * kb)
+{
+  switch (matrix) {
+    case GST_VIDEO_COLOR_MATRIX_FCC:
+      *kr = 0.30;
+      *kb = 0.11;
+      break;
+    case GST_VIDEO_COLOR_MATRIX_BT709:
+      *kr = 0.2126;
+      *kb = 0.0722;
+      break;
+    case GST_VIDEO_COLOR_MATRIX_SMPTE240M:
+      *kr = 0.212;
+      *kb = 0.087;
+      break;
+#if GST_CHECK_VERSION (1, 6, 0)
+    case GST_VIDEO_COLOR_MATRIX_BT2020:
+      *kr = 0.2627;
+      *kb = 0.0593;
+      break;
+#endif
+    case GST_VIDEO_COLOR_MATRIX_BT601:
+    default:
+      *kr = 0.299;
+      *kb = 0.114;
+      break;
+  }
+}
+
+/* offsets and extents of the luma and chroma components normalized to
+ * the largest value of their bit depth, which is what textures hold */
+static void
+_get_range (GstVideoInfo * info, gdouble * y_offset, gdouble * y_scale,
+    gdouble * c_offset, gdouble * c_scale)
+{
+  guint depth = GST_VIDEO_INFO_COMP_DEPTH (info, 0);
+  gdouble max;
+
+  if (depth < 8 || depth > 16)
+    depth = 8;
+  max = (1 << depth) - 1;
+
+  *c_offset = (1 << (depth - 1)) / max;
+
+  if (info->colorimetry.range == GST_VIDEO_COLOR_RANGE_0_255) {
+    *y_offset = 0.0;
+    *y_scale = 1.0;
+    *c_scale = 1.0;
+  } else {
+    *y_offset = (16 << (depth - 8)) / max;
+    *y_scale = (219 << (depth - 8)) / max;
+    *c_scale = (224 << (depth - 8)) / max;
+  }
+}
+
+/**
+ * gst_gl_get_yuv_to_rgb_coefficients:
+ * @info: the #GstVideoInfo of the YUV frames
+ * @offset: (out): the offset to add to Y, Cb and Cr
+ * @coeffs: (out): the row major 3x3 matrix from offset YCbCr to RGB
+ *
+ * Retrieves the conversion of the YUV frames described by @info to RGB
+ * in the range 0 to 1 from their colorimetry.  The matrix and range of
+ * the colorimetry are used; both sides stay in the same transfer function
+ * and primaries.  Colorimetry that does not specify a matrix is converted
+ * as BT.601.
+ *
+ * A shader computes rgb = M * (yuv + @offset).
+ */
+void
+gst_gl_get_yuv_to_rgb_coefficients (GstVideoInfo * info, gfloat offset[3],
+    gfloat coeffs[9])
+{
+  gdouble kr, kb, kg, y_offset, y_scale, c_offset, c_scale;
+
+  _get_kr_kb (info->colorimetry.matrix, &kr, &kb);
+  kg = 1.0 - kr - kb;
+  _get_range (info, &y_offset, &y_scale, &c_offset, &c_scale);
+
+  offset[0] = -y_offset;
+  offset[1] = offset[2] = -c_offset;
+
+  coeffs[0] = 1.0 / y_scale;
+  coeffs[1] = 0.0;
+  coeffs[2] = 2.0 * (1.0 - kr) / c_scale;
+
+  coeffs[3] = 1.0 / y_scale;
+  coeffs[4] = -2.0 * kb * (1.0 - kb) / kg / c_scale;
+  coeffs[5] = -2.0 * kr * (1.0 - kr) / kg / c_scale;
+
+  coeffs[6] = 1.0 / y_scale;
+  coeffs[7] = 2.0 * (1.0 - kb) / c_scale;
+  coeffs[8] = 0.0;
+}
+
+/**
+ * gst_gl_get_rgb_to_yuv_coefficients:
+ * @info: the #GstVideoInfo of the YUV frames
+ * @offset: (out): the offset to add to the converted Y, Cb and Cr
+ * @coeffs: (out): the row major 3x3 matrix from RGB to YCbCr
+ *
+ * Retrieves the conversion from RGB in the range 0 to 1 to the YUV frames
+ * described by @info, the inverse of gst_gl_get_yuv_to_rgb_coefficients().
+ *
+ * A shader computes yuv = M * rgb + @offset.
+ */
+void
+gst_gl_get_rgb_to_yuv_coefficients (GstVideoInfo * info, gfloat offset[3],
+    gfloat coeffs[9])
+{
+  gdouble kr, kb, kg, y_offset, y_scale, c_offset, c_scale;
+
+  _get_kr_kb (info->colorimetry.matrix, &kr, &kb);
+  kg = 1.0 - kr - kb;
+  _get_range (info, &y_offset, &y_scale, &c_offset, &c_scale);
+
+  offset[0] = y_offset;
+  offset[1] = offset[2] = c_offset;
+
+  coeffs[0] = kr * y_scale;
+  coeffs[1] = kg * y_scale;
+  coeffs[2] = kb * y_scale;
+
+  coeffs[3] = -kr / (2.0 * (1.0 - kb)) * c_scale;
+  coeffs[4] = -kg / (2.0 * (1.0 - kb)) * c_scale;
+  coeffs[5] = 0.5 * c_scale;
+
+  coeffs[6] = 0.5 * c_scale;
+  coeffs[7] = -kg / (2.0 * (1.0 - kr)) * c_scale;
+  coeffs[8] = -kb / (2.0 * (1.0 - kr)) * c_scale;
+}
+
 void
 _del_texture (GstGLContext * context, guint * texture)
 {
@@ -366,6 +715,364 @@ gst_gl_context_del_shader (GstGLContext * context, GstGLShader * shader)
   gst_object_unref (shader);
 }
 
+/* 3 position + 2 texture coordinate floats per vertex, two triangles per face */
+static const GLfloat quad_vertices[] = {
+  -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+  1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
+  1.0f, 1.0f, 0.0f, 1.0f, 1.0f,
+  -1.0f, 1.0f, 0.0f, 0.0f, 1.0f
+};
+
+static const GLfloat quad_flipped_vertices[] = {
+  -1.0f, -1.0f, 0.0f, 0.0f, 1.0f,
+  1.0f, -1.0f, 0.0f, 1.0f, 1.0f,
+  1.0f, 1.0f, 0.0f, 1.0f, 0.0f,
+  -1.0f, 1.0f, 0.0f, 0.0f, 0.0f
+};
+
+static const GLfloat cube_vertices[] = {
+  /* front face */
+  1.0f, 1.0f, -1.0f, 1.0f, 0.0f,
+  1.0f, -1.0f, -1.0f, 1.0f, 1.0f,
+  -1.0f, -1.0f, -1.0f, 0.0f, 1.0f,
+  -1.0f, 1.0f, -1.0f, 0.0f, 0.0f,
+  /* back face */
+  1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+  -1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+  -1.0f, -1.0f, 1.0f, 0.0f, 1.0f,
+  1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
+  /* right face */
+  1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+  1.0f, -1.0f, 1.0f, 0.0f, 0.0f,
+  1.0f, -1.0f, -1.0f, 0.0f, 1.0f,
+  1.0f, 1.0f, -1.0f, 1.0f, 1.0f,
+  /* left face */
+  -1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+  -1.0f, 1.0f, -1.0f, 1.0f, 1.0f,
+  -1.0f, -1.0f, -1.0f, 0.0f, 1.0f,
+  -1.0f, -1.0f, 1.0f, 0.0f, 0.0f,
+  /* top face */
+  1.0f, -1.0f, 1.0f, 1.0f, 0.0f,
+  -1.0f, -1.0f, 1.0f, 0.0f, 0.0f,
+  -1.0f, -1.0f, -1.0f, 0.0f, 1.0f,
+  1.0f, -1.0f, -1.0f, 1.0f, 1.0f,
+  /* bottom face */
+  1.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+  1.0f, 1.0f, -1.0f, 1.0f, 1.0f,
+  -1.0f, 1.0f, -1.0f, 0.0f, 1.0f,
+  -1.0f, 1.0f, 1.0f, 0.0f, 0.0f
+};
+
+static const GLushort quad_indices[] = { 0, 1, 2, 0, 2, 3 };
+
+static const GLushort cube_indices[] = {
+  0, 1, 2, 0, 2, 3,
+  4, 5, 6, 4, 6, 7,
+  8, 9, 10, 8, 10, 11,
+  12, 13, 14, 12, 14, 15,
+  16, 17, 18, 16, 18, 19,
+  20, 21, 22, 20, 22, 23
+};
+
+static const struct
+{
+  const GLfloat *vertices;
+  gsize vertices_size;
+  const GLushort *indices;
+  gsize indices_size;
+  guint n_faces;
+} geometries[GST_GL_GEOMETRY_N] = {
+  {quad_vertices, sizeof (quad_vertices), quad_indices,
+      sizeof (quad_indices), 1},
+  {quad_flipped_vertices, sizeof (quad_flipped_vertices), quad_indices,
+      sizeof (quad_indices), 1},
+  {cube_vertices, sizeof (cube_vertices), cube_indices,
+      sizeof (cube_indices), 6},
+};
+
+typedef struct _GeometryObjects
+{
+  GLuint vbo;
+  GLuint ibo;
+  GLuint vao;
+  /* the attribute locations recorded in @vao, -2 when not yet recorded */
+  GLint vao_position_loc;
+  GLint vao_texcoord_loc;
+} GeometryObjects;
+
+typedef struct _GeometryCache
+{
+  GeometryObjects objects[GST_GL_GEOMETRY_N];
+
+  /* the currently bound geometry, -1 for none */
+  gint bound;
+  gboolean bound_vao;
+  GLint bound_position_loc;
+  GLint bound_texcoord_loc;
+} GeometryCache;
+
+static GQuark
+_geometry_cache_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (!quark)
+    quark = g_quark_from_static_string ("GstGLGeometryCache");
+
+  return quark;
+}
+
+static void
+_geometry_cache_free (GeometryCache * cache)
+{
+  g_slice_free (GeometryCache, cache);
+}
+
+static GeometryCache *
+_get_geometry_cache (GstGLContext * context)
+{
+  GeometryCache *cache;
+  guint i;
+
+  cache = g_object_get_qdata (G_OBJECT (context), _geometry_cache_quark ());
+  if (cache)
+    return cache;
+
+  cache = g_slice_new0 (GeometryCache);
+  cache->bound = -1;
+  for (i = 0; i < GST_GL_GEOMETRY_N; i++) {
+    cache->objects[i].vao_position_loc = -2;
+    cache->objects[i].vao_texcoord_loc = -2;
+  }
+
+  g_object_set_qdata_full (G_OBJECT (context), _geometry_cache_quark (),
+      cache, (GDestroyNotify) _geometry_cache_free);
+
+  return cache;
+}
+
+static void
+_set_vertex_pointers (GstGLContext * context, GLint position_loc,
+    GLint texcoord_loc)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+
+  if (position_loc >= 0) {
+    gl->VertexAttribPointer (position_loc, 3, GL_FLOAT, GL_FALSE,
+        5 * sizeof (GLfloat), (gpointer) 0);
+    gl->EnableVertexAttribArray (position_loc);
+
+    if (texcoord_loc >= 0) {
+      gl->VertexAttribPointer (texcoord_loc, 2, GL_FLOAT, GL_FALSE,
+          5 * sizeof (GLfloat), (gpointer) (3 * sizeof (GLfloat)));
+      gl->EnableVertexAttribArray (texcoord_loc);
+    }
+  }
+#if GST_GL_HAVE_OPENGL
+  else {
+    gl->ClientActiveTexture (GL_TEXTURE0);
+    gl->EnableClientState (GL_VERTEX_ARRAY);
+    gl->EnableClientState (GL_TEXTURE_COORD_ARRAY);
+
+    gl->VertexPointer (3, GL_FLOAT, 5 * sizeof (GLfloat), (gpointer) 0);
+    gl->TexCoordPointer (2, GL_FLOAT, 5 * sizeof (GLfloat),
+        (gpointer) (3 * sizeof (GLfloat)));
+  }
+#endif
+}
+
+/**
+ * gst_gl_context_bind_geometry:
+ * @context: a #GstGLContext
+ * @geometry: the #GstGLGeometry to bind
+ * @position_loc: the location of the vec3 position attribute or -1
+ * @texcoord_loc: the location of the vec2 texture coordinate attribute or -1
+ *
+ * Binds the static vertex and index buffers for @geometry so that it can be
+ * drawn with gst_gl_context_draw_geometry().  The buffers are created on first
+ * use and shared by every user of @context.  When a vertex array object is
+ * available, the attribute layout is recorded once and reused on later binds.
+ *
+ * A negative @position_loc selects the fixed function vertex and texture
+ * coordinate arrays instead, which is only possible with desktop OpenGL.
+ *
+ * Must be called in the GL thread and paired with
+ * gst_gl_context_unbind_geometry().
+ */
+void
+gst_gl_context_bind_geometry (GstGLContext * context, GstGLGeometry geometry,
+    GLint position_loc, GLint texcoord_loc)
+{
+  const GstGLFuncs *gl;
+  GeometryCache *cache;
+  GeometryObjects *obj;
+  gboolean use_vao;
+
+  g_return_if_fail (GST_GL_IS_CONTEXT (context));
+  g_return_if_fail (geometry >= 0 && geometry < GST_GL_GEOMETRY_N);
+
+  gl = context->gl_vtable;
+  cache = _get_geometry_cache (context);
+  obj = &cache->objects[geometry];
+
+  g_return_if_fail (cache->bound < 0);
+
+  if (!gl->GenBuffers) {
+    gst_gl_context_set_error (context, "Vertex buffer objects not supported");
+    return;
+  }
+
+  if (!obj->vbo) {
+    gl->GenBuffers (1, &obj->vbo);
+    gl->BindBuffer (GL_ARRAY_BUFFER, obj->vbo);
+    gl->BufferData (GL_ARRAY_BUFFER, geometries[geometry].vertices_size,
+        geometries[geometry].vertices, GL_STATIC_DRAW);
+
+    gl->GenBuffers (1, &obj->ibo);
+    gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, obj->ibo);
+    gl->BufferData (GL_ELEMENT_ARRAY_BUFFER, geometries[geometry].indices_size,
+        geometries[geometry].indices, GL_STATIC_DRAW);
+
+    gl->BindBuffer (GL_ARRAY_BUFFER, 0);
+    gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+  }
+
+  use_vao = position_loc >= 0 && gl->GenVertexArrays;
+
+  cache->bound = geometry;
+  cache->bound_vao = use_vao;
+  cache->bound_position_loc = position_loc;
+  cache->bound_texcoord_loc = texcoord_loc;
+
+  if (use_vao) {
+    if (!obj->vao)
+      gl->GenVertexArrays (1, &obj->vao);
+
+    gl->BindVertexArray (obj->vao);
+
+    if (obj->vao_position_loc == position_loc
+        && obj->vao_texcoord_loc == texcoord_loc)
+      return;
+
+    /* a different shader is drawing this geometry, re-record the layout */
+    if (obj->vao_position_loc >= 0)
+      gl->DisableVertexAttribArray (obj->vao_position_loc);
+    if (obj->vao_texcoord_loc >= 0)
+      gl->DisableVertexAttribArray (obj->vao_texcoord_loc);
+
+    obj->vao_position_loc = position_loc;
+    obj->vao_texcoord_loc = texcoord_loc;
+  }
+
+  gl->BindBuffer (GL_ARRAY_BUFFER, obj->vbo);
+  gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, obj->ibo);
+
+  _set_vertex_pointers (context, position_loc, texcoord_loc);
+}
+
+/**
+ * gst_gl_context_draw_geometry:
+ * @context: a #GstGLContext
+ * @first_face: the first face to draw
+ * @n_faces: the number of faces to draw
+ *
+ * Draws @n_faces faces of the geometry bound with
+ * gst_gl_context_bind_geometry(), starting at @first_face.  A quad has a
+ * single face, a cube has six.
+ *
+ * Must be called in the GL thread.
+ */
+void
+gst_gl_context_draw_geometry (GstGLContext * context, guint first_face,
+    guint n_faces)
+{
+  const GstGLFuncs *gl;
+  GeometryCache *cache;
+
+  g_return_if_fail (GST_GL_IS_CONTEXT (context));
+
+  gl = context->gl_vtable;
+  cache = _get_geometry_cache (context);
+
+  if (cache->bound < 0)
+    return;
+
+  g_return_if_fail (first_face + n_faces <= geometries[cache->bound].n_faces);
+
+  gl->DrawElements (GL_TRIANGLES, 6 * n_faces, GL_UNSIGNED_SHORT,
+      (gpointer) (first_face * 6 * sizeof (GLushort)));
+}
+
+/**
+ * gst_gl_context_unbind_geometry:
+ * @context: a #GstGLContext
+ *
+ * Restores the vertex state changed by gst_gl_context_bind_geometry().
+ *
+ * Must be called in the GL thread.
+ */
+void
+gst_gl_context_unbind_geometry (GstGLContext * context)
+{
+  const GstGLFuncs *gl;
+  GeometryCache *cache;
+
+  g_return_if_fail (GST_GL_IS_CONTEXT (context));
+
+  gl = context->gl_vtable;
+  cache = _get_geometry_cache (context);
+
+  if (cache->bound < 0)
+    return;
+
+  if (cache->bound_vao) {
+    gl->BindVertexArray (0);
+  } else if (cache->bound_position_loc >= 0) {
+    gl->DisableVertexAttribArray (cache->bound_position_loc);
+    if (cache->bound_texcoord_loc >= 0)
+      gl->DisableVertexAttribArray (cache->bound_texcoord_loc);
+  }
+#if GST_GL_HAVE_OPENGL
+  else {
+    gl->DisableClientState (GL_VERTEX_ARRAY);
+    gl->DisableClientState (GL_TEXTURE_COORD_ARRAY);
+  }
+#endif
+
+  gl->BindBuffer (GL_ARRAY_BUFFER, 0);
+  if (!cache->bound_vao)
+    gl->BindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  cache->bound = -1;
+}
+
+/* called in the gl thread while the context is still current, before it is
+ * destroyed */
+void
+_gst_gl_context_free_geometry (GstGLContext * context)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+  GeometryCache *cache;
+  guint i;
+
+  cache = g_object_get_qdata (G_OBJECT (context), _geometry_cache_quark ());
+  if (!cache)
+    return;
+
+  for (i = 0; i < GST_GL_GEOMETRY_N; i++) {
+    GeometryObjects *obj = &cache->objects[i];
+
+    if (obj->vao)
+      gl->DeleteVertexArrays (1, &obj->vao);
+    if (obj->vbo)
+      gl->DeleteBuffers (1, &obj->vbo);
+    if (obj->ibo)
+      gl->DeleteBuffers (1, &obj->ibo);
+  }
+
+  g_object_set_qdata (G_OBJECT (context), _geometry_cache_quark (), NULL);
+}
+
 static gboolean
 gst_gl_display_found (GstElement * element, GstGLDisplay * display)
 {
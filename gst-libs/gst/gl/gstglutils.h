@@ -37,6 +37,27 @@ typedef enum
   GST_GL_DISPLAY_PROJECTION_PERSPECTIVE
 } GstGLDisplayProjection;
 
+/**
+ * GstGLGeometry:
+ * @GST_GL_GEOMETRY_QUAD: a quad covering normalized device coordinates with
+ *   texture coordinate (0, 0) at the bottom left
+ * @GST_GL_GEOMETRY_QUAD_FLIPPED: the same quad with texture coordinate (0, 0)
+ *   at the top left, for presenting to a window
+ * @GST_GL_GEOMETRY_CUBE: a unit cube made of six quad faces
+ * @GST_GL_GEOMETRY_N: the number of geometries
+ *
+ * The static geometries cached per #GstGLContext.  Each vertex has three
+ * position and two texture coordinate floats.
+ */
+typedef enum
+{
+  GST_GL_GEOMETRY_QUAD,
+  GST_GL_GEOMETRY_QUAD_FLIPPED,
+  GST_GL_GEOMETRY_CUBE,
+
+  GST_GL_GEOMETRY_N
+} GstGLGeometry;
+
 /**
  * CRCB:
  * @width: new width
@@ -76,7 +97,17 @@ typedef void (*GLCB_V2) (gpointer stuff);
 
 void gst_gl_context_gen_texture (GstGLContext * context, GLuint * pTexture,
     GstVideoFormat v_format, GLint width, GLint height);
+void gst_gl_context_gen_texture_full (GstGLContext * context, GLuint * pTexture,
+    GLenum internal_format, GLint width, GLint height, guint n_levels);
 void gst_gl_context_del_texture (GstGLContext * context, GLuint * pTexture);
+GLenum gst_gl_context_get_texture_format (GstGLContext * context,
+    GstVideoInfo * info);
+gboolean gst_gl_get_crop_tex_coords (GstBuffer * buffer, GstVideoInfo * info,
+    gfloat tex_coords[4]);
+void gst_gl_get_yuv_to_rgb_coefficients (GstVideoInfo * info,
+    gfloat offset[3], gfloat coeffs[9]);
+void gst_gl_get_rgb_to_yuv_coefficients (GstVideoInfo * info,
+    gfloat offset[3], gfloat coeffs[9]);
 
 gboolean gst_gl_context_gen_fbo (GstGLContext * context, gint width, gint height,
     GLuint * fbo, GLuint * depthbuffer);
@@ -99,6 +130,12 @@ void gst_gl_context_del_shader (GstGLContext * context, GstGLShader * shader);
 
 gboolean gst_gl_context_check_framebuffer_status (GstGLContext * context);
 
+void gst_gl_context_bind_geometry (GstGLContext * context,
+    GstGLGeometry geometry, GLint position_loc, GLint texcoord_loc);
+void gst_gl_context_draw_geometry (GstGLContext * context, guint first_face,
+    guint n_faces);
+void gst_gl_context_unbind_geometry (GstGLContext * context);
+
 void gst_gl_context_set_error (GstGLContext * context, const char * format, ...);
 gchar *gst_gl_context_get_error (void);
 
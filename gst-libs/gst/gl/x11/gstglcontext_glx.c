@@ -39,6 +39,10 @@
 
 #define GST_CAT_DEFAULT gst_gl_window_debug
 
+#ifndef GLX_BACK_BUFFER_AGE_EXT
+#define GLX_BACK_BUFFER_AGE_EXT 0x20F4
+#endif
+
 #define gst_gl_context_glx_parent_class parent_class
 G_DEFINE_TYPE (GstGLContextGLX, gst_gl_context_glx, GST_GL_TYPE_CONTEXT);
 
@@ -47,6 +51,9 @@ G_DEFINE_TYPE (GstGLContextGLX, gst_gl_context_glx, GST_GL_TYPE_CONTEXT);
 
 static guintptr gst_gl_context_glx_get_gl_context (GstGLContext * context);
 static void gst_gl_context_glx_swap_buffers (GstGLContext * context);
+static gint gst_gl_context_glx_get_buffer_age (GstGLContext * context);
+static gboolean gst_gl_context_glx_get_sync_values (GstGLContext * context,
+    gint64 * ust, gint64 * msc, gint64 * sbc);
 static gboolean gst_gl_context_glx_activate (GstGLContext * context,
     gboolean activate);
 static gboolean gst_gl_context_glx_create_context (GstGLContext *
@@ -68,6 +75,9 @@ struct _GstGLContextGLXPrivate
   GstGLAPI context_api;
 
   GLXFBConfig *fbconfigs;
+  gboolean has_buffer_age;
+    Bool (*glXGetSyncValuesOML) (Display *, GLXDrawable, int64_t *, int64_t *,
+      int64_t *);
     GLXContext (*glXCreateContextAttribsARB) (Display *, GLXFBConfig,
       GLXContext, Bool, const int *);
 };
@@ -90,6 +100,10 @@ gst_gl_context_glx_class_init (GstGLContextGLXClass * klass)
       GST_DEBUG_FUNCPTR (gst_gl_context_glx_choose_format);
   context_class->swap_buffers =
       GST_DEBUG_FUNCPTR (gst_gl_context_glx_swap_buffers);
+  context_class->get_buffer_age =
+      GST_DEBUG_FUNCPTR (gst_gl_context_glx_get_buffer_age);
+  context_class->get_sync_values =
+      GST_DEBUG_FUNCPTR (gst_gl_context_glx_get_sync_values);
 
   context_class->get_gl_api = GST_DEBUG_FUNCPTR (gst_gl_context_glx_get_gl_api);
   context_class->get_gl_platform =
@@ -167,6 +181,12 @@ gst_gl_context_glx_create_context (GstGLContext * context,
   glx_exts = glXQueryExtensionsString (device, DefaultScreen (device));
 
   create_context = gst_gl_check_extension ("GLX_ARB_create_context", glx_exts);
+  context_glx->priv->has_buffer_age =
+      gst_gl_check_extension ("GLX_EXT_buffer_age", glx_exts);
+  if (gst_gl_check_extension ("GLX_OML_sync_control", glx_exts))
+    context_glx->priv->glXGetSyncValuesOML =
+        (gpointer) glXGetProcAddressARB ((const GLubyte *)
+        "glXGetSyncValuesOML");
   context_glx->priv->glXCreateContextAttribsARB =
       (gpointer) glXGetProcAddressARB ((const GLubyte *)
       "glXCreateContextAttribsARB");
@@ -370,6 +390,62 @@ gst_gl_context_glx_swap_buffers (GstGLContext * context)
   gst_object_unref (window);
 }
 
+static gint
+gst_gl_context_glx_get_buffer_age (GstGLContext * context)
+{
+  GstGLContextGLX *context_glx = GST_GL_CONTEXT_GLX (context);
+  GstGLWindow *window;
+  Display *device;
+  Window window_handle;
+  unsigned int age = 0;
+
+  if (!context_glx->priv->has_buffer_age)
+    return 0;
+
+  window = gst_gl_context_get_window (context);
+  device = (Display *) gst_gl_display_get_handle (window->display);
+  window_handle = (Window) gst_gl_window_get_window_handle (window);
+
+  glXQueryDrawable (device, window_handle, GLX_BACK_BUFFER_AGE_EXT, &age);
+
+  gst_object_unref (window);
+
+  return age;
+}
+
+static gboolean
+gst_gl_context_glx_get_sync_values (GstGLContext * context, gint64 * ust,
+    gint64 * msc, gint64 * sbc)
+{
+  GstGLContextGLX *context_glx = GST_GL_CONTEXT_GLX (context);
+  GstGLWindow *window;
+  Display *device;
+  Window window_handle;
+  int64_t u, m, s;
+  Bool ret;
+
+  if (!context_glx->priv->glXGetSyncValuesOML)
+    return FALSE;
+
+  window = gst_gl_context_get_window (context);
+  device = (Display *) gst_gl_display_get_handle (window->display);
+  window_handle = (Window) gst_gl_window_get_window_handle (window);
+
+  ret = context_glx->priv->glXGetSyncValuesOML (device, window_handle, &u, &m,
+      &s);
+
+  gst_object_unref (window);
+
+  if (!ret)
+    return FALSE;
+
+  *ust = u;
+  *msc = m;
+  *sbc = s;
+
+  return TRUE;
+}
+
 static guintptr
 gst_gl_context_glx_get_gl_context (GstGLContext * context)
 {
@@ -497,17 +497,40 @@ event_type_to_string (guint type)
   }
 }
 
+/* grows the damaged area (x1, y1, x2, y2 in window coordinates) by a
+ * rectangle */
+static void
+_add_damage (gint damage[4], gint x, gint y, gint width, gint height)
+{
+  if (damage[2] <= damage[0] || damage[3] <= damage[1]) {
+    damage[0] = x;
+    damage[1] = y;
+    damage[2] = x + width;
+    damage[3] = y + height;
+  } else {
+    damage[0] = MIN (damage[0], x);
+    damage[1] = MIN (damage[1], y);
+    damage[2] = MAX (damage[2], x + width);
+    damage[3] = MAX (damage[3], y + height);
+  }
+}
+
 gboolean
 gst_gl_window_x11_handle_event (GstGLWindowX11 * window_x11)
 {
   GstGLContext *context;
-  GstGLContextClass *context_class;
   GstGLWindow *window;
   gboolean ret = TRUE;
+  gboolean need_resize = FALSE, need_draw = FALSE, damage_all = FALSE;
+  gint width = 0, height = 0;
+  gint damage[4] = { 0, 0, 0, 0 };
 
   window = GST_GL_WINDOW (window_x11);
 
-  if (g_main_loop_is_running (window_x11->loop)
+  /* everything that is pending is handled at once so that a burst of
+   * ConfigureNotify and Expose events results in a single resize and a
+   * single redraw */
+  while (ret && g_main_loop_is_running (window_x11->loop)
       && XPending (window_x11->device)) {
     XEvent event;
 
@@ -541,40 +564,27 @@ gst_gl_window_x11_handle_event (GstGLWindowX11 * window_x11)
 
       case CreateNotify:
       case ConfigureNotify:
-      {
-        if (window->resize)
-          window->resize (window->resize_data, event.xconfigure.width,
-              event.xconfigure.height);
+        /* the viewport changes, so does the whole content */
+        need_resize = TRUE;
+        need_draw = TRUE;
+        damage_all = TRUE;
+        width = event.xconfigure.width;
+        height = event.xconfigure.height;
         break;
-      }
 
       case DestroyNotify:
         break;
 
       case Expose:
-        /* non-zero means that other Expose follows
-         * so just wait for the last one
-         * in theory we should not receive non-zero because
-         * we have no sub areas here but just in case */
-        if (event.xexpose.count != 0) {
-          break;
-        }
-
-        /* just ignore request that does not come from us
-         * they are un-necessary and it overloads the drawer
-         */
-        if (!event.xexpose.send_event)
-          break;
-
-        if (window->draw) {
-          context = gst_gl_window_get_context (window);
-          context_class = GST_GL_CONTEXT_GET_CLASS (context);
-
-          window->draw (window->draw_data);
-          context_class->swap_buffers (context);
-
-          gst_object_unref (context);
-        }
+        need_draw = TRUE;
+
+        /* ours come from gst_gl_window_x11_draw() and mean new content,
+         * the others only ask to present the exposed area again */
+        if (event.xexpose.send_event)
+          damage_all = TRUE;
+        else
+          _add_damage (damage, event.xexpose.x, event.xexpose.y,
+              event.xexpose.width, event.xexpose.height);
         break;
 
       case VisibilityNotify:
@@ -588,6 +598,40 @@ gst_gl_window_x11_handle_event (GstGLWindowX11 * window_x11)
     }                           // switch
   }                             // while running
 
+  if (!ret)
+    return FALSE;
+
+  if (need_resize && window->resize)
+    window->resize (window->resize_data, width, height);
+
+  if (need_draw && window->draw) {
+    context = gst_gl_window_get_context (window);
+
+    window->draw (window->draw_data);
+
+    if (damage_all) {
+      gst_gl_context_swap_buffers_with_damage (context, NULL, 0);
+    } else {
+      XWindowAttributes attr;
+      gint rect[4];
+
+      /* GL has its origin in the bottom left corner */
+      XGetWindowAttributes (window_x11->device, window_x11->internal_win_id,
+          &attr);
+      rect[0] = damage[0];
+      rect[1] = attr.height - damage[3];
+      rect[2] = damage[2] - damage[0];
+      rect[3] = damage[3] - damage[1];
+
+      GST_TRACE ("presenting damaged area %ix%i+%i+%i", rect[2], rect[3],
+          rect[0], rect[1]);
+
+      gst_gl_context_swap_buffers_with_damage (context, rect, 1);
+    }
+
+    gst_object_unref (context);
+  }
+
   return ret;
 }
 
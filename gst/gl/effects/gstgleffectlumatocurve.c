@@ -56,19 +56,21 @@ gst_gl_effects_luma_to_curve (GstGLEffects * effects,
   gst_gl_shader_use (shader);
 
   if (effects->curve[curve_index] == 0) {
-    /* this parameters are needed to have a right, predictable, mapping */
+    /* this parameters are needed to have a right, predictable, mapping.
+     * The curve is a row of width texels, a 1D texture is not available
+     * with GLES2 */
     gl->GenTextures (1, &effects->curve[curve_index]);
-    gl->Enable (GL_TEXTURE_1D);
-    gl->BindTexture (GL_TEXTURE_1D, effects->curve[curve_index]);
-    gl->TexParameteri (GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    gl->TexParameteri (GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    gl->TexParameteri (GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-    gl->TexParameteri (GL_TEXTURE_1D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    gl->Enable (GL_TEXTURE_2D);
+    gl->BindTexture (GL_TEXTURE_2D, effects->curve[curve_index]);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    gl->TexImage1D (GL_TEXTURE_1D, 0, curve.bytes_per_pixel,
-        curve.width, 0, GL_RGB, GL_UNSIGNED_BYTE, curve.pixel_data);
+    gl->TexImage2D (GL_TEXTURE_2D, 0, GL_RGB, curve.width, 1, 0, GL_RGB,
+        GL_UNSIGNED_BYTE, curve.pixel_data);
 
-    gl->Disable (GL_TEXTURE_1D);
+    gl->Disable (GL_TEXTURE_2D);
   }
 
   gl->ActiveTexture (GL_TEXTURE2);
@@ -80,12 +82,12 @@ gst_gl_effects_luma_to_curve (GstGLEffects * effects,
   gl->Disable (GL_TEXTURE_2D);
 
   gl->ActiveTexture (GL_TEXTURE1);
-  gl->Enable (GL_TEXTURE_1D);
-  gl->BindTexture (GL_TEXTURE_1D, effects->curve[curve_index]);
+  gl->Enable (GL_TEXTURE_2D);
+  gl->BindTexture (GL_TEXTURE_2D, effects->curve[curve_index]);
 
   gst_gl_shader_set_uniform_1i (shader, "curve", 1);
 
-  gl->Disable (GL_TEXTURE_1D);
+  gl->Disable (GL_TEXTURE_2D);
 
   gst_gl_filter_draw_texture (filter, texture, width, height);
 }
@@ -396,29 +396,29 @@ const gchar *multiply_fragment_source =
   "  gl_FragColor = (1.0 - alpha) * basecolor + alpha * basecolor * blendcolor;"
   "}";
 
-/* lut operations, map luma to tex1d, see orange book (chapter 19) */
+/* lut operations, map luma to a 256x1 curve, see orange book (chapter 19) */
 const gchar *luma_to_curve_fragment_source =
   "uniform sampler2D tex;"
-  "uniform sampler1D curve;"
+  "uniform sampler2D curve;"
   "void main () {"
   "  vec2 texturecoord = gl_TexCoord[0].st;"
   "  vec4 color = texture2D (tex, texturecoord);"
   "  float luma = dot(color.rgb, vec3(0.2125, 0.7154, 0.0721));"
-  "  color = texture1D(curve, luma);"
+  "  color = texture2D(curve, vec2(luma, 0.5));"
   "  gl_FragColor = color;"
   "}";
 
 
-/* lut operations, map rgb to tex1d, see orange book (chapter 19) */
+/* lut operations, map rgb to a 256x1 curve, see orange book (chapter 19) */
 const gchar *rgb_to_curve_fragment_source =
   "uniform sampler2D tex;"
-  "uniform sampler1D curve;"
+  "uniform sampler2D curve;"
   "void main () {"
   "  vec4 color = texture2D (tex, gl_TexCoord[0].st);"
   "  vec4 outcolor;"
-  "  outcolor.r = texture1D(curve, color.r).r;"
-  "  outcolor.g = texture1D(curve, color.g).g;"
-  "  outcolor.b = texture1D(curve, color.b).b;"
+  "  outcolor.r = texture2D(curve, vec2(color.r, 0.5)).r;"
+  "  outcolor.g = texture2D(curve, vec2(color.g, 0.5)).g;"
+  "  outcolor.b = texture2D(curve, vec2(color.b, 0.5)).b;"
   "  outcolor.a = color.a;"
   "  gl_FragColor = outcolor;"
   "}";
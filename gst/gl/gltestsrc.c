@@ -76,155 +76,332 @@ static const struct vts_color_struct vts_colors[] = {
   {32, 128, 128, 32, 32, 32, 255},
 };
 
+
+/* all the patterns are drawn with a quad covering the rectangle rect, in
+ * frame coordinates from (0,0) at the first pixel to (1,1) at the last one.
+ * v_texcoord interpolates the same coordinates */
+/* *INDENT-OFF* */
+static const gchar *pattern_vertex_shader_str =
+    "attribute vec4 a_position;\n"
+    "attribute vec2 a_texcoord;\n"
+    "uniform vec4 rect;\n"
+    "varying vec2 v_texcoord;\n"
+    "void main()\n"
+    "{\n"
+    "   vec2 pos = mix(rect.xy, rect.zw, a_texcoord);\n"
+    "   gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);\n"
+    "   v_texcoord = pos;\n"
+    "}\n";
+
+#define PATTERN_FRAGMENT_HEADER \
+    "#ifdef GL_ES\n" \
+    "#ifdef GL_FRAGMENT_PRECISION_HIGH\n" \
+    "precision highp float;\n" \
+    "#else\n" \
+    "precision mediump float;\n" \
+    "#endif\n" \
+    "#endif\n" \
+    "varying vec2 v_texcoord;\n" \
+    "uniform vec2 size;\n"
+
+static const gchar *color_fragment_shader_str =
+    PATTERN_FRAGMENT_HEADER
+    "uniform vec4 color;\n"
+    "void main()\n"
+    "{\n"
+    "  gl_FragColor = color;\n"
+    "}\n";
+
+/* red squares on even tiles, green on odd ones */
+static const gchar *checkers_fragment_shader_str =
+    PATTERN_FRAGMENT_HEADER
+    "uniform float checker_width;\n"
+    "void main()\n"
+    "{\n"
+    "  vec2 xy = floor(v_texcoord * size / checker_width);\n"
+    "  float odd = mod(xy.x + xy.y, 2.0);\n"
+    "  gl_FragColor = vec4(1.0 - odd, odd, 0.0, 1.0);\n"
+    "}\n";
+
+/* concentric rings whose frequency halves every 4 of the 8 segments */
+static const gchar *circular_fragment_shader_str =
+    PATTERN_FRAGMENT_HEADER
+    "void main()\n"
+    "{\n"
+    "  vec2 xy = floor(v_texcoord * size);\n"
+    "  float dist = length(2.0 * xy - size) / (2.0 * size.x);\n"
+    "  float seg = floor(dist * 16.0);\n"
+    "  float y = 1.0;\n"
+    "  if (seg > 0.0 && seg < 8.0) {\n"
+    "    float freq = 200.0 * pow(2.0, -(seg - 1.0) / 4.0);\n"
+    "    float d = mod(floor(256.0 * dist * freq + 0.5), 256.0);\n"
+    "    y = 0.5 + 0.5 * sin(d * 6.2831853 / 256.0);\n"
+    "  }\n"
+    "  gl_FragColor = vec4(y, y, y, 1.0);\n"
+    "}\n";
+
+static const gchar *snow_fragment_shader_str =
+    PATTERN_FRAGMENT_HEADER
+    "uniform vec2 seed;\n"
+    "void main()\n"
+    "{\n"
+    "  vec2 xy = floor(v_texcoord * size) + seed;\n"
+    "  float y = fract(sin(dot(xy, vec2(12.9898, 78.233))) * 43758.5453);\n"
+    "  gl_FragColor = vec4(y, y, y, 1.0);\n"
+    "}\n";
+
+/* the ring frequency reaches the nyquist limit at the top and bottom edges,
+ * the rings move outwards by one per second */
+static const gchar *zone_plate_fragment_shader_str =
+    PATTERN_FRAGMENT_HEADER
+    "uniform float time;\n"
+    "void main()\n"
+    "{\n"
+    "  vec2 xy = v_texcoord * size - size / 2.0;\n"
+    "  float phase = 3.1415926 * dot(xy, xy) / size.y;\n"
+    "  float y = 0.5 + 0.5 * cos(phase - 6.2831853 * fract(time));\n"
+    "  gl_FragColor = vec4(y, y, y, 1.0);\n"
+    "}\n";
+
+static const gchar *ball_fragment_shader_str =
+    PATTERN_FRAGMENT_HEADER
+    "uniform vec2 center;\n"
+    "uniform float radius;\n"
+    "void main()\n"
+    "{\n"
+    "  float d = length(v_texcoord * size - center);\n"
+    "  float y = clamp(radius - d + 0.5, 0.0, 1.0);\n"
+    "  gl_FragColor = vec4(y, y, y, 1.0);\n"
+    "}\n";
+/* *INDENT-ON* */
+
+static const gchar *
+_get_fragment_shader (GstGLTestSrcPattern pattern)
+{
+  switch (pattern) {
+    case GST_GL_TEST_SRC_SMPTE:
+    case GST_GL_TEST_SRC_SMPTE75:
+    case GST_GL_TEST_SRC_SMPTE100:
+      return color_fragment_shader_str;
+    case GST_GL_TEST_SRC_SNOW:
+      return snow_fragment_shader_str;
+    case GST_GL_TEST_SRC_CHECKERS1:
+    case GST_GL_TEST_SRC_CHECKERS2:
+    case GST_GL_TEST_SRC_CHECKERS4:
+    case GST_GL_TEST_SRC_CHECKERS8:
+      return checkers_fragment_shader_str;
+    case GST_GL_TEST_SRC_CIRCULAR:
+      return circular_fragment_shader_str;
+    case GST_GL_TEST_SRC_ZONE_PLATE:
+      return zone_plate_fragment_shader_str;
+    case GST_GL_TEST_SRC_BALL:
+      return ball_fragment_shader_str;
+    default:
+      /* plain colors only need glClear */
+      return NULL;
+  }
+}
+
+/* compiles the shader of the current pattern unless the previous pattern
+ * already used the same one, must not be called from the GL thread */
+gboolean
+gst_gl_test_src_init_shader (GstGLTestSrc * v)
+{
+  const gchar *fragment = _get_fragment_shader (v->pattern_type);
+
+  if (!fragment || fragment == v->shader_fragment)
+    return TRUE;
+
+  if (v->shader) {
+    gst_object_unref (v->shader);
+    v->shader = NULL;
+  }
+  v->shader_fragment = NULL;
+  v->position_loc = -1;
+  v->texcoord_loc = -1;
+
+  if (!gst_gl_context_gen_shader (v->context, pattern_vertex_shader_str,
+          fragment, &v->shader))
+    return FALSE;
+
+  v->shader_fragment = fragment;
+
+  return TRUE;
+}
+
+/* whether every frame of @pattern is the same */
+gboolean
+gst_gl_test_src_is_static (GstGLTestSrcPattern pattern)
+{
+  switch (pattern) {
+    case GST_GL_TEST_SRC_SNOW:
+    case GST_GL_TEST_SRC_BLINK:
+    case GST_GL_TEST_SRC_ZONE_PLATE:
+    case GST_GL_TEST_SRC_BALL:
+      return FALSE;
+    default:
+      return TRUE;
+  }
+}
+
 static void
-gst_gl_test_src_unicolor (GstGLTestSrc * v, GstBuffer * buffer, int w,
-    int h, const struct vts_color_struct *color);
+_begin_pattern (GstGLTestSrc * v, int w, int h)
+{
+  const GstGLFuncs *gl = v->context->gl_vtable;
 
-void
-gst_gl_test_src_smpte (GstGLTestSrc * v, GstBuffer * buffer, int w, int h)
+  if (v->position_loc < 0) {
+    v->position_loc =
+        gst_gl_shader_get_attribute_location (v->shader, "a_position");
+    v->texcoord_loc =
+        gst_gl_shader_get_attribute_location (v->shader, "a_texcoord");
+  }
+
+  gl->Disable (GL_DEPTH_TEST);
+  gl->Disable (GL_BLEND);
+
+  gst_gl_shader_use (v->shader);
+  gst_gl_shader_set_uniform_2f (v->shader, "size", (gfloat) w, (gfloat) h);
+  gst_gl_shader_set_uniform_4f (v->shader, "rect", 0.0f, 0.0f, 1.0f, 1.0f);
+
+  gst_gl_context_bind_geometry (v->context, GST_GL_GEOMETRY_QUAD,
+      v->position_loc, v->texcoord_loc);
+}
+
+static void
+_end_pattern (GstGLTestSrc * v)
 {
-#if GST_GL_HAVE_OPENGL
-  int i;
+  gst_gl_context_unbind_geometry (v->context);
+  gst_gl_context_clear_shader (v->context);
+}
 
-  if (gst_gl_context_get_gl_api (v->context) & GST_GL_API_OPENGL) {
+/* draws the rectangle (x1, y1) - (x2, y2) in frame coordinates */
+static void
+_draw_rect (GstGLTestSrc * v, gfloat x1, gfloat y1, gfloat x2, gfloat y2)
+{
+  gst_gl_shader_set_uniform_4f (v->shader, "rect", x1, y1, x2, y2);
+  gst_gl_context_draw_geometry (v->context, 0, 1);
+}
 
-    glClearColor (0.0, 0.0, 0.0, 1.0);
-    glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+static void
+_set_color (GstGLTestSrc * v, const struct vts_color_struct *color,
+    gfloat scale)
+{
+  gst_gl_shader_set_uniform_4f (v->shader, "color",
+      color->R * (scale / 255.0f), color->G * (scale / 255.0f),
+      color->B * (scale / 255.0f), 1.0f);
+}
 
-    glDisable (GL_CULL_FACE);
-    glDisable (GL_TEXTURE_2D);
+static void
+_draw_smpte (GstGLTestSrc * v, int w, int h, gfloat scale)
+{
+  int i;
 
-    glMatrixMode (GL_PROJECTION);
-    glLoadIdentity ();
+  _begin_pattern (v, w, h);
 
-    for (i = 0; i < 7; i++) {
-      glColor4f (vts_colors[i].R * (1 / 255.0f), vts_colors[i].G * (1 / 255.0f),
-          vts_colors[i].B * (1 / 255.0f), 1.0f);
-      glBegin (GL_QUADS);
-      glVertex3f (-1.0f + i * (2.0f / 7.0f), -1.0f + 2.0 * (2.0f / 3.0f), 0);
-      glVertex3f (-1.0f + (i + 1.0f) * (2.0f / 7.0f),
-          -1.0f + 2.0f * (2.0f / 3.0f), 0);
-      glVertex3f (-1.0f + (i + 1.0f) * (2.0f / 7.0f), -1.0f, 0);
-      glVertex3f (-1.0f + i * (2.0f / 7.0f), -1.0f, 0);
-      glEnd ();
-    }
+  for (i = 0; i < 7; i++) {
+    _set_color (v, &vts_colors[i], scale);
+    _draw_rect (v, i / 7.0f, 0.0f, (i + 1) / 7.0f, 2.0f / 3.0f);
+  }
+
+  for (i = 0; i < 7; i++) {
+    int k;
 
-    for (i = 0; i < 7; i++) {
-      int k;
-
-      if (i & 1) {
-        k = 7;
-      } else {
-        k = 6 - i;
-      }
-
-      glColor4f (vts_colors[k].R * (1 / 255.0f), vts_colors[k].G * (1 / 255.0f),
-          vts_colors[k].B * (1 / 255.0f), 1.0f);
-      glBegin (GL_QUADS);
-      glVertex3f (-1.0f + i * (2.0f / 7.0f), -1.0f + 2.0f * (3.0f / 4.0f), 0);
-      glVertex3f (-1.0f + (i + 1) * (2.0f / 7.0f), -1.0f + 2.0f * (3.0f / 4.0f),
-          0);
-      glVertex3f (-1.0f + (i + 1) * (2.0f / 7.0f), -1.0f + 2.0f * (2.0f / 3.0f),
-          0);
-      glVertex3f (-1.0f + i * (2.0f / 7.0f), -1.0f + 2.0f * (2.0f / 3.0f), 0);
-      glEnd ();
+    if (i & 1) {
+      k = 7;
+    } else {
+      k = 6 - i;
     }
 
-    for (i = 0; i < 3; i++) {
-      int k;
-
-      if (i == 0) {
-        k = 8;
-      } else if (i == 1) {
-        k = 0;
-      } else {
-        k = 9;
-      }
-
-      glColor4f (vts_colors[k].R * (1 / 255.0f), vts_colors[k].G * (1 / 255.0f),
-          vts_colors[k].B * (1 / 255.0f), 1.0f);
-      glBegin (GL_QUADS);
-      glVertex3f (-1.0f + i * (2.0f / 6.0f), -1.0f + 2.0f * 1, 0);
-      glVertex3f (-1.0f + (i + 1) * (2.0f / 6.0f), -1.0f + 2.0f * 1, 0);
-      glVertex3f (-1.0f + (i + 1) * (2.0f / 6.0f), -1.0f + 2.0f * (3.0f / 4.0f),
-          0);
-      glVertex3f (-1.0f + i * (2.0f / 6.0f), -1.0f + 2.0f * (3.0f / 4.0f), 0);
-      glEnd ();
+    _set_color (v, &vts_colors[k], scale);
+    _draw_rect (v, i / 7.0f, 2.0f / 3.0f, (i + 1) / 7.0f, 3.0f / 4.0f);
+  }
+
+  for (i = 0; i < 3; i++) {
+    int k;
+
+    if (i == 0) {
+      k = COLOR_NEG_I;
+    } else if (i == 1) {
+      k = COLOR_WHITE;
+    } else {
+      k = COLOR_POS_Q;
     }
 
-    for (i = 0; i < 3; i++) {
-      int k;
-
-      if (i == 0) {
-        k = COLOR_SUPER_BLACK;
-      } else if (i == 1) {
-        k = COLOR_BLACK;
-      } else {
-        k = COLOR_DARK_GREY;
-      }
-
-      glColor4f (vts_colors[k].R * (1 / 255.0f), vts_colors[k].G * (1 / 255.0f),
-          vts_colors[k].B * (1 / 255.0f), 1.0f);
-      glBegin (GL_QUADS);
-      glVertex3f (-1.0f + 2.0f * (0.5f + i * (1.0f / 12.0f)), -1.0 + 2.0f * 1,
-          0);
-      glVertex3f (-1.0f + 2.0f * (0.5f + (i + 1) * (1.0f / 12.0f)),
-          -1.0f + 2.0f * 1, 0);
-      glVertex3f (-1.0f + 2.0f * (0.5f + (i + 1) * (1.0f / 12.0f)),
-          -1.0f + 2.0f * (3.0f / 4.0f), 0);
-      glVertex3f (-1.0f + 2.0f * (0.5f + i * (1.0f / 12.0f)),
-          -1.0f + 2.0f * (3.0f / 4.0f), 0);
-      glEnd ();
+    _set_color (v, &vts_colors[k], 1.0f);
+    _draw_rect (v, i / 6.0f, 3.0f / 4.0f, (i + 1) / 6.0f, 1.0f);
+  }
+
+  for (i = 0; i < 3; i++) {
+    int k;
+
+    if (i == 0) {
+      k = COLOR_SUPER_BLACK;
+    } else if (i == 1) {
+      k = COLOR_BLACK;
+    } else {
+      k = COLOR_DARK_GREY;
     }
 
-    glColor4f (1.0, 1.0, 1.0, 1.0);
-    glBegin (GL_QUADS);
-    glVertex3f (-1.0 + 2.0 * (0.75), -1.0 + 2.0 * 1, 0);
-    glVertex3f (-1.0 + 2.0 * (1.0), -1.0 + 2.0 * 1, 0);
-    glVertex3f (-1.0 + 2.0 * (1.0), -1.0 + 2.0 * (3.0 / 4.0), 0);
-    glVertex3f (-1.0 + 2.0 * (0.75), -1.0 + 2.0 * (3.0 / 4.0), 0);
-    glEnd ();
+    _set_color (v, &vts_colors[k], 1.0f);
+    _draw_rect (v, 0.5f + i / 12.0f, 3.0f / 4.0f, 0.5f + (i + 1) / 12.0f,
+        1.0f);
   }
-#endif
+
+  _set_color (v, &vts_colors[COLOR_WHITE], 1.0f);
+  _draw_rect (v, 0.75f, 3.0f / 4.0f, 1.0f, 1.0f);
+
+  _end_pattern (v);
 }
 
 void
-gst_gl_test_src_snow (GstGLTestSrc * v, GstBuffer * buffer, int w, int h)
+gst_gl_test_src_smpte (GstGLTestSrc * v, GstBuffer * buffer, int w, int h)
 {
-#if GST_GL_HAVE_OPENGL
-  if (gst_gl_context_get_gl_api (v->context) & GST_GL_API_OPENGL) {
-    glClearColor (0.0, 0.0, 0.0, 1.0);
-    glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    glMatrixMode (GL_PROJECTION);
-    glLoadIdentity ();
-
-    glMatrixMode (GL_MODELVIEW);
-    glLoadIdentity ();
-
-    /* FIXME snow requires a fragment shader.  Please write. */
-    glColor4f (0.5, 0.5, 0.5, 1.0);
-    glBegin (GL_QUADS);
-    glVertex3f (-1.0 + 2.0 * (0.0), -1.0 + 2.0 * 1, 0);
-    glVertex3f (-1.0 + 2.0 * (1.0), -1.0 + 2.0 * 1, 0);
-    glVertex3f (-1.0 + 2.0 * (1.0), -1.0 + 2.0 * (0.0), 0);
-    glVertex3f (-1.0 + 2.0 * (0.0), -1.0 + 2.0 * (0.0), 0);
-    glEnd ();
+  _draw_smpte (v, w, h, 1.0f);
+}
+
+void
+gst_gl_test_src_smpte75 (GstGLTestSrc * v, GstBuffer * buffer, int w, int h)
+{
+  _draw_smpte (v, w, h, 0.75f);
+}
+
+void
+gst_gl_test_src_smpte100 (GstGLTestSrc * v, GstBuffer * buffer, int w, int h)
+{
+  int i;
+
+  _begin_pattern (v, w, h);
+
+  for (i = 0; i < 7; i++) {
+    _set_color (v, &vts_colors[i], 1.0f);
+    _draw_rect (v, i / 7.0f, 0.0f, (i + 1) / 7.0f, 1.0f);
   }
-#endif
+
+  _end_pattern (v);
+}
+
+void
+gst_gl_test_src_snow (GstGLTestSrc * v, GstBuffer * buffer, int w, int h)
+{
+  _begin_pattern (v, w, h);
+
+  gst_gl_shader_set_uniform_2f (v->shader, "seed",
+      (gfloat) g_random_double_range (0.0, 1024.0),
+      (gfloat) g_random_double_range (0.0, 1024.0));
+  gst_gl_context_draw_geometry (v->context, 0, 1);
+
+  _end_pattern (v);
 }
 
 static void
 gst_gl_test_src_unicolor (GstGLTestSrc * v, GstBuffer * buffer, int w,
     int h, const struct vts_color_struct *color)
 {
-#if GST_GL_HAVE_OPENGL
-  if (gst_gl_context_get_gl_api (v->context) & GST_GL_API_OPENGL) {
-    glClearColor (color->R * (1 / 255.0f), color->G * (1 / 255.0f),
-        color->B * (1 / 255.0f), 1.0f);
-    glClear (GL_COLOR_BUFFER_BIT);
-  }
-#endif
+  const GstGLFuncs *gl = v->context->gl_vtable;
+
+  gl->ClearColor (color->R * (1 / 255.0f), color->G * (1 / 255.0f),
+      color->B * (1 / 255.0f), 1.0f);
+  gl->Clear (GL_COLOR_BUFFER_BIT);
 }
 
 void
@@ -257,251 +434,80 @@ gst_gl_test_src_blue (GstGLTestSrc * v, GstBuffer * buffer, int w, int h)
   gst_gl_test_src_unicolor (v, buffer, w, h, vts_colors + COLOR_BLUE);
 }
 
+static void
+gst_gl_test_src_checkers (GstGLTestSrc * v, int w, int h, gint checker_width)
+{
+  _begin_pattern (v, w, h);
+
+  gst_gl_shader_set_uniform_1f (v->shader, "checker_width",
+      (gfloat) checker_width);
+  gst_gl_context_draw_geometry (v->context, 0, 1);
+
+  _end_pattern (v);
+}
+
 void
 gst_gl_test_src_checkers1 (GstGLTestSrc * v, GstBuffer * buffer, int w, int h)
 {
-#if 0
-  int x, y;
-  paintinfo pi = { NULL, };
-  paintinfo *p = &pi;
-  struct fourcc_list_struct *fourcc;
-
-  p->width = w;
-  p->height = h;
-  fourcc = v->fourcc;
-  if (fourcc == NULL)
-    return;
-
-  fourcc->paint_setup (p, dest);
-  p->paint_hline = fourcc->paint_hline;
-
-  for (y = 0; y < h; y++) {
-    p->color = vts_colors + COLOR_GREEN;
-    p->paint_hline (p, 0, y, w);
-    for (x = (y % 2); x < w; x += 2) {
-      p->color = vts_colors + COLOR_RED;
-      p->paint_hline (p, x, y, 1);
-    }
-  }
-#endif
+  gst_gl_test_src_checkers (v, w, h, 1);
 }
 
 void
 gst_gl_test_src_checkers2 (GstGLTestSrc * v, GstBuffer * buffer, int w, int h)
 {
-#if 0
-  int x, y;
-  paintinfo pi = { NULL, };
-  paintinfo *p = &pi;
-  struct fourcc_list_struct *fourcc;
-
-  p->width = w;
-  p->height = h;
-  fourcc = v->fourcc;
-  if (fourcc == NULL)
-    return;
-
-  fourcc->paint_setup (p, dest);
-  p->paint_hline = fourcc->paint_hline;
-
-  p->color = vts_colors + COLOR_GREEN;
-  for (y = 0; y < h; y++) {
-    p->paint_hline (p, 0, y, w);
-  }
-
-  for (y = 0; y < h; y += 2) {
-    for (x = ((y % 4) == 0) ? 0 : 2; x < w; x += 4) {
-      guint len = (x < (w - 1)) ? 2 : (w - x);
-
-      p->color = vts_colors + COLOR_RED;
-      p->paint_hline (p, x, y + 0, len);
-      if (G_LIKELY ((y + 1) < h)) {
-        p->paint_hline (p, x, y + 1, len);
-      }
-    }
-  }
-#endif
+  gst_gl_test_src_checkers (v, w, h, 2);
 }
 
 void
 gst_gl_test_src_checkers4 (GstGLTestSrc * v, GstBuffer * buffer, int w, int h)
 {
-#if 0
-  int x, y;
-  paintinfo pi = { NULL, };
-  paintinfo *p = &pi;
-  struct fourcc_list_struct *fourcc;
-
-  p->width = w;
-  p->height = h;
-  fourcc = v->fourcc;
-  if (fourcc == NULL)
-    return;
-
-  fourcc->paint_setup (p, dest);
-  p->paint_hline = fourcc->paint_hline;
-
-  p->color = vts_colors + COLOR_GREEN;
-  for (y = 0; y < h; y++) {
-    p->paint_hline (p, 0, y, w);
-  }
-
-  for (y = 0; y < h; y += 4) {
-    for (x = ((y % 8) == 0) ? 0 : 4; x < w; x += 8) {
-      guint len = (x < (w - 3)) ? 4 : (w - x);
-
-      p->color = vts_colors + COLOR_RED;
-      p->paint_hline (p, x, y + 0, len);
-      if (G_LIKELY ((y + 1) < h)) {
-        p->paint_hline (p, x, y + 1, len);
-        if (G_LIKELY ((y + 2) < h)) {
-          p->paint_hline (p, x, y + 2, len);
-          if (G_LIKELY ((y + 3) < h)) {
-            p->paint_hline (p, x, y + 3, len);
-          }
-        }
-      }
-    }
-  }
-#endif
+  gst_gl_test_src_checkers (v, w, h, 4);
 }
 
 void
 gst_gl_test_src_checkers8 (GstGLTestSrc * v, GstBuffer * buffer, int w, int h)
 {
-#if 0
-  int x, y;
-  paintinfo pi = { NULL, };
-  paintinfo *p = &pi;
-  struct fourcc_list_struct *fourcc;
-
-  p->width = w;
-  p->height = h;
-  fourcc = v->fourcc;
-  if (fourcc == NULL)
-    return;
-
-  fourcc->paint_setup (p, dest);
-  p->paint_hline = fourcc->paint_hline;
-
-  p->color = vts_colors + COLOR_GREEN;
-  for (y = 0; y < h; y++) {
-    p->paint_hline (p, 0, y, w);
-  }
-
-  for (y = 0; y < h; y += 8) {
-    for (x = ((GST_ROUND_UP_8 (y) % 16) == 0) ? 0 : 8; x < w; x += 16) {
-      guint len = (x < (w - 7)) ? 8 : (w - x);
-
-      p->color = vts_colors + COLOR_RED;
-      p->paint_hline (p, x, y + 0, len);
-      if (G_LIKELY ((y + 1) < h)) {
-        p->paint_hline (p, x, y + 1, len);
-        if (G_LIKELY ((y + 2) < h)) {
-          p->paint_hline (p, x, y + 2, len);
-          if (G_LIKELY ((y + 3) < h)) {
-            p->paint_hline (p, x, y + 3, len);
-            if (G_LIKELY ((y + 4) < h)) {
-              p->paint_hline (p, x, y + 4, len);
-              if (G_LIKELY ((y + 5) < h)) {
-                p->paint_hline (p, x, y + 5, len);
-                if (G_LIKELY ((y + 6) < h)) {
-                  p->paint_hline (p, x, y + 6, len);
-                  if (G_LIKELY ((y + 7) < h)) {
-                    p->paint_hline (p, x, y + 7, len);
-                  }
-                }
-              }
-            }
-          }
-        }
-      }
-    }
-  }
-#endif
+  gst_gl_test_src_checkers (v, w, h, 8);
 }
 
 void
 gst_gl_test_src_circular (GstGLTestSrc * v, GstBuffer * buffer, int w, int h)
 {
-#if 0
-  int i;
-  int j;
-  paintinfo pi = { NULL, };
-  paintinfo *p = &pi;
-  struct fourcc_list_struct *fourcc;
-  struct vts_color_struct color;
-  static uint8_t sine_array[256];
-  static int sine_array_inited = FALSE;
-  double freq[8];
-
-#ifdef SCALE_AMPLITUDE
-  double ampl[8];
-#endif
-  int d;
+  _begin_pattern (v, w, h);
+  gst_gl_context_draw_geometry (v->context, 0, 1);
+  _end_pattern (v);
+}
 
-  if (!sine_array_inited) {
-    for (i = 0; i < 256; i++) {
-      sine_array[i] =
-          floor (255 * (0.5 + 0.5 * sin (i * 2 * M_PI / 256)) + 0.5);
-    }
-    sine_array_inited = TRUE;
-  }
+void
+gst_gl_test_src_zone_plate (GstGLTestSrc * v, GstBuffer * buffer, int w,
+    int h)
+{
+  _begin_pattern (v, w, h);
 
-  p->width = w;
-  p->height = h;
-  fourcc = v->fourcc;
-  if (fourcc == NULL)
-    return;
+  gst_gl_shader_set_uniform_1f (v->shader, "time",
+      (gfloat) gst_util_guint64_to_gdouble (v->running_time) / GST_SECOND);
+  gst_gl_context_draw_geometry (v->context, 0, 1);
 
-  fourcc->paint_setup (p, dest);
-  p->paint_hline = fourcc->paint_hline;
+  _end_pattern (v);
+}
 
-  color = vts_colors[COLOR_BLACK];
-  p->color = &color;
+void
+gst_gl_test_src_ball (GstGLTestSrc * v, GstBuffer * buffer, int w, int h)
+{
+  const gfloat radius = 20.0f;
+  gdouble t = (gdouble) v->n_frames;
+  gfloat x, y;
 
-  for (i = 1; i < 8; i++) {
-    freq[i] = 200 * pow (2.0, -(i - 1) / 4.0);
-#ifdef SCALE_AMPLITUDE
-    {
-      double x;
+  /* the same path as videotestsrc */
+  x = radius + (0.5 + 0.5 * sin (2 * M_PI * t / 200)) * (w - 2 * radius);
+  y = radius + (0.5 + 0.5 * sin (2 * M_PI * sqrt (2) * t / 200)) *
+      (h - 2 * radius);
 
-      x = 2 * M_PI * freq[i] / w;
-      ampl[i] = sin (x) / x;
-    }
-#endif
-  }
+  _begin_pattern (v, w, h);
 
-  for (i = 0; i < w; i++) {
-    for (j = 0; j < h; j++) {
-      double dist;
-      int seg;
-
-      dist =
-          sqrt ((2 * i - w) * (2 * i - w) + (2 * j - h) * (2 * j -
-              h)) / (2 * w);
-      seg = floor (dist * 16);
-      if (seg == 0 || seg >= 8) {
-        color.Y = 255;
-      } else {
-#ifdef SCALE_AMPLITUDE
-        double a;
-#endif
-        d = floor (256 * dist * freq[seg] + 0.5);
-#ifdef SCALE_AMPLITUDE
-        a = ampl[seg];
-        if (a < 0)
-          a = 0;
-        color.Y = 128 + a * (sine_array[d & 0xff] - 128);
-#else
-        color.Y = sine_array[d & 0xff];
-#endif
-      }
-      color.R = color.Y;
-      color.G = color.Y;
-      color.B = color.Y;
-      p->paint_hline (p, i, j, 1);
-    }
-  }
-#endif
+  gst_gl_shader_set_uniform_2f (v->shader, "center", x, y);
+  gst_gl_shader_set_uniform_1f (v->shader, "radius", radius);
+  gst_gl_context_draw_geometry (v->context, 0, 1);
+
+  _end_pattern (v);
 }
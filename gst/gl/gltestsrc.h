@@ -54,5 +54,16 @@ void    gst_gl_test_src_checkers8    (GstGLTestSrc * v,
                                          GstBuffer *buffer, int w, int h);
 void    gst_gl_test_src_circular     (GstGLTestSrc * v,
                                          GstBuffer *buffer, int w, int h);
+void    gst_gl_test_src_smpte75      (GstGLTestSrc * v,
+                                         GstBuffer *buffer, int w, int h);
+void    gst_gl_test_src_zone_plate   (GstGLTestSrc * v,
+                                         GstBuffer *buffer, int w, int h);
+void    gst_gl_test_src_ball         (GstGLTestSrc * v,
+                                         GstBuffer *buffer, int w, int h);
+void    gst_gl_test_src_smpte100     (GstGLTestSrc * v,
+                                         GstBuffer *buffer, int w, int h);
+
+gboolean gst_gl_test_src_init_shader (GstGLTestSrc * v);
+gboolean gst_gl_test_src_is_static   (GstGLTestSrcPattern pattern);
 
 #endif
@@ -0,0 +1,433 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-glcolorgrade
+ *
+ * Colour grading with a 3D lookup table, in a single pass.
+ *
+ * The table is loaded from the .cube file of #GstGLColorGrade:location, or
+ * is one of the curves of #GstGLEffects when no file is set.  Files are
+ * parsed when the property is set, and the new table replaces the old one
+ * from the next frame on.
+ *
+ * The table is sampled with trilinear interpolation from a 3D texture with
+ * desktop OpenGL, or from a 2D texture holding one slice per blue value with
+ * OpenGL ES 2.0.  #GstGLColorGrade:intensity blends the graded colours with
+ * the original ones.
+ *
+ * <refsect2>
+ * <title>Examples</title>
+ * |[
+ * gst-launch videotestsrc ! glupload ! glcolorgrade location=film.cube ! glimagesink
+ * ]|
+ * |[
+ * gst-launch videotestsrc ! glupload ! glcolorgrade preset=sepia intensity=0.5 ! glimagesink
+ * ]|
+ * FBO (Frame Buffer Object) and GLSL (OpenGL Shading Language) are required.
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstglcolorgrade.h"
+
+#define GST_CAT_DEFAULT gst_gl_color_grade_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define DEFAULT_LOCATION NULL
+#define DEFAULT_PRESET GST_GL_LUT_BUILTIN_NONE
+#define DEFAULT_INTENSITY 1.0f
+
+enum
+{
+  PROP_0,
+  PROP_LOCATION,
+  PROP_PRESET,
+  PROP_INTENSITY
+};
+
+#define DEBUG_INIT \
+  GST_DEBUG_CATEGORY_INIT (gst_gl_color_grade_debug, "glcolorgrade", 0, "glcolorgrade element");
+
+G_DEFINE_TYPE_WITH_CODE (GstGLColorGrade, gst_gl_color_grade,
+    GST_TYPE_GL_FILTER, DEBUG_INIT);
+
+static void gst_gl_color_grade_finalize (GObject * object);
+static void gst_gl_color_grade_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_gl_color_grade_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+
+static void gst_gl_color_grade_reset (GstGLFilter * filter);
+static gboolean gst_gl_color_grade_init_shader (GstGLFilter * filter);
+static gboolean gst_gl_color_grade_filter_texture (GstGLFilter * filter,
+    guint in_tex, guint out_tex);
+static void gst_gl_color_grade_callback (gint width, gint height,
+    guint texture, gpointer stuff);
+
+#define GST_TYPE_GL_LUT_BUILTIN (gst_gl_lut_builtin_get_type ())
+static GType
+gst_gl_lut_builtin_get_type (void)
+{
+  static GType gl_lut_builtin_type = 0;
+  static const GEnumValue builtin_types[] = {
+    {GST_GL_LUT_BUILTIN_NONE, "Identity", "none"},
+    {GST_GL_LUT_BUILTIN_HEAT, "Heat signature", "heat"},
+    {GST_GL_LUT_BUILTIN_SEPIA, "Sepia toning", "sepia"},
+    {GST_GL_LUT_BUILTIN_XPRO, "Cross processing", "xpro"},
+    {GST_GL_LUT_BUILTIN_LUMA_XPRO, "Luma cross processing", "luma-xpro"},
+    {GST_GL_LUT_BUILTIN_XRAY, "X-ray", "xray"},
+    {0, NULL, NULL}
+  };
+
+  if (!gl_lut_builtin_type) {
+    gl_lut_builtin_type =
+        g_enum_register_static ("GstGLLutBuiltin", builtin_types);
+  }
+  return gl_lut_builtin_type;
+}
+
+/* *INDENT-OFF* */
+static const gchar *color_grade_vertex_source =
+  "attribute vec4 a_position;\n"
+  "attribute vec2 a_texcoord;\n"
+  "varying vec2 v_texcoord;\n"
+  "void main()\n"
+  "{\n"
+  "   gl_Position = a_position;\n"
+  "   v_texcoord = a_texcoord;\n"
+  "}\n";
+
+#define COLOR_GRADE_FRAGMENT_HEADER \
+  "#ifdef GL_ES\n" \
+  "#ifdef GL_FRAGMENT_PRECISION_HIGH\n" \
+  "precision highp float;\n" \
+  "#else\n" \
+  "precision mediump float;\n" \
+  "#endif\n" \
+  "#endif\n" \
+  "varying vec2 v_texcoord;\n" \
+  "uniform sampler2D tex;\n" \
+  "uniform float intensity;\n"
+
+#define COLOR_GRADE_FRAGMENT_MAIN \
+  "void main () {\n" \
+  "  vec4 color = texture2D(tex, v_texcoord);\n" \
+  "  vec3 graded = gst_gl_lut_lookup (color.rgb);\n" \
+  "  gl_FragColor = vec4(mix(color.rgb, graded, intensity), color.a);\n" \
+  "}\n"
+
+static const gchar *color_grade_3d_fragment_source =
+  COLOR_GRADE_FRAGMENT_HEADER
+  GST_GL_LUT_3D_SOURCE
+  COLOR_GRADE_FRAGMENT_MAIN;
+
+static const gchar *color_grade_2d_fragment_source =
+  COLOR_GRADE_FRAGMENT_HEADER
+  GST_GL_LUT_2D_SOURCE
+  COLOR_GRADE_FRAGMENT_MAIN;
+/* *INDENT-ON* */
+
+static void
+gst_gl_color_grade_class_init (GstGLColorGradeClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+
+  gobject_class = (GObjectClass *) klass;
+  element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->set_property = gst_gl_color_grade_set_property;
+  gobject_class->get_property = gst_gl_color_grade_get_property;
+  gobject_class->finalize = gst_gl_color_grade_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_LOCATION,
+      g_param_spec_string ("location", "Location",
+          "Path of a .cube LUT file, parsed when set.  Takes precedence "
+          "over the preset", DEFAULT_LOCATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PRESET,
+      g_param_spec_enum ("preset", "Preset",
+          "Built-in LUT used when no location is set",
+          GST_TYPE_GL_LUT_BUILTIN, DEFAULT_PRESET,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_INTENSITY,
+      g_param_spec_float ("intensity", "Intensity",
+          "Blend between the original colours, 0, and the graded ones, 1",
+          0.0f, 1.0f, DEFAULT_INTENSITY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_metadata (element_class,
+      "OpenGL colour grading filter", "Filter/Effect/Video",
+      "Colour grading with 3D lookup tables", "The GStreamer developers");
+
+  GST_GL_FILTER_CLASS (klass)->filter_texture =
+      gst_gl_color_grade_filter_texture;
+  GST_GL_FILTER_CLASS (klass)->onInitFBO = gst_gl_color_grade_init_shader;
+  GST_GL_FILTER_CLASS (klass)->onReset = gst_gl_color_grade_reset;
+}
+
+static void
+gst_gl_color_grade_init (GstGLColorGrade * filter)
+{
+  filter->location = DEFAULT_LOCATION;
+  filter->preset = DEFAULT_PRESET;
+  filter->intensity = DEFAULT_INTENSITY;
+  filter->lut_changed = TRUE;
+}
+
+static void
+gst_gl_color_grade_finalize (GObject * object)
+{
+  GstGLColorGrade *filter = GST_GL_COLOR_GRADE (object);
+
+  /* the textures are gone with the context */
+  if (filter->lut)
+    filter->lut->texture = 0;
+  if (filter->old_lut)
+    filter->old_lut->texture = 0;
+
+  gst_gl_lut_free (filter->pending_lut);
+  gst_gl_lut_free (filter->lut);
+  gst_gl_lut_free (filter->old_lut);
+  g_free (filter->location);
+
+  G_OBJECT_CLASS (gst_gl_color_grade_parent_class)->finalize (object);
+}
+
+static void
+gst_gl_color_grade_set_pending (GstGLColorGrade * filter, GstGLLut * lut)
+{
+  GST_OBJECT_LOCK (filter);
+  gst_gl_lut_free (filter->pending_lut);
+  filter->pending_lut = lut;
+  filter->lut_changed = TRUE;
+  GST_OBJECT_UNLOCK (filter);
+}
+
+/* runs in the thread setting the property, never in the streaming one */
+static void
+gst_gl_color_grade_load (GstGLColorGrade * filter)
+{
+  GError *error = NULL;
+  GstGLLut *lut;
+
+  if (!filter->location) {
+    gst_gl_color_grade_set_pending (filter,
+        gst_gl_lut_new_builtin (filter->preset));
+    return;
+  }
+
+  lut = gst_gl_lut_new_from_cube_file (filter->location, &error);
+  if (!lut) {
+    GST_ELEMENT_WARNING (filter, RESOURCE, READ,
+        ("Could not load LUT \"%s\", keeping the previous one",
+            filter->location), ("%s", error->message));
+    g_clear_error (&error);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (filter, "loaded \"%s\" from %s",
+      GST_STR_NULL (lut->title), filter->location);
+
+  gst_gl_color_grade_set_pending (filter, lut);
+}
+
+static void
+gst_gl_color_grade_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGLColorGrade *filter = GST_GL_COLOR_GRADE (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      g_free (filter->location);
+      filter->location = g_value_dup_string (value);
+      gst_gl_color_grade_load (filter);
+      break;
+    case PROP_PRESET:
+      filter->preset = g_value_get_enum (value);
+      if (!filter->location)
+        gst_gl_color_grade_load (filter);
+      break;
+    case PROP_INTENSITY:
+      filter->intensity = g_value_get_float (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gl_color_grade_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGLColorGrade *filter = GST_GL_COLOR_GRADE (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      g_value_set_string (value, filter->location);
+      break;
+    case PROP_PRESET:
+      g_value_set_enum (value, filter->preset);
+      break;
+    case PROP_INTENSITY:
+      g_value_set_float (value, filter->intensity);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* swaps the tables in the GL thread */
+static void
+gst_gl_color_grade_upload_lut (GstGLContext * context, gpointer data)
+{
+  GstGLColorGrade *filter = GST_GL_COLOR_GRADE (data);
+
+  if (filter->old_lut) {
+    gst_gl_lut_unload (filter->old_lut, context);
+    gst_gl_lut_free (filter->old_lut);
+    filter->old_lut = NULL;
+  }
+
+  filter->upload_failed = filter->lut
+      && !gst_gl_lut_upload (filter->lut, context, filter->texture_3d);
+}
+
+static void
+gst_gl_color_grade_unload_lut (GstGLContext * context, gpointer data)
+{
+  GstGLColorGrade *filter = GST_GL_COLOR_GRADE (data);
+
+  if (filter->lut)
+    gst_gl_lut_unload (filter->lut, context);
+}
+
+static void
+gst_gl_color_grade_reset (GstGLFilter * filter)
+{
+  GstGLColorGrade *color_grade = GST_GL_COLOR_GRADE (filter);
+
+  /* the table is kept and uploaded again in the next context */
+  gst_gl_context_thread_add (filter->context, gst_gl_color_grade_unload_lut,
+      color_grade);
+
+  //blocking call, wait the opengl thread has destroyed the shader
+  if (color_grade->shader)
+    gst_gl_context_del_shader (filter->context, color_grade->shader);
+  color_grade->shader = NULL;
+}
+
+static gboolean
+gst_gl_color_grade_init_shader (GstGLFilter * filter)
+{
+  GstGLColorGrade *color_grade = GST_GL_COLOR_GRADE (filter);
+
+  color_grade->texture_3d = gst_gl_lut_context_has_3d (filter->context);
+
+  GST_DEBUG_OBJECT (filter, "sampling the LUT from a %s texture",
+      color_grade->texture_3d ? "3D" : "2D");
+
+  //blocking call, wait the opengl thread has compiled the shader
+  return gst_gl_context_gen_shader (filter->context, color_grade_vertex_source,
+      color_grade->texture_3d ? color_grade_3d_fragment_source :
+      color_grade_2d_fragment_source, &color_grade->shader);
+}
+
+static gboolean
+gst_gl_color_grade_filter_texture (GstGLFilter * filter, guint in_tex,
+    guint out_tex)
+{
+  GstGLColorGrade *color_grade = GST_GL_COLOR_GRADE (filter);
+  GstGLLut *lut = NULL;
+  gboolean changed;
+
+  GST_OBJECT_LOCK (color_grade);
+  changed = color_grade->lut_changed;
+  if (changed) {
+    lut = color_grade->pending_lut;
+    color_grade->pending_lut = NULL;
+    color_grade->lut_changed = FALSE;
+  }
+  GST_OBJECT_UNLOCK (color_grade);
+
+  if (changed) {
+    if (!lut)
+      lut = gst_gl_lut_new_builtin (GST_GL_LUT_BUILTIN_NONE);
+    color_grade->old_lut = color_grade->lut;
+    color_grade->lut = lut;
+  }
+
+  if (color_grade->old_lut || !color_grade->lut->texture) {
+    //blocking call, upload the new table and delete the old one
+    gst_gl_context_thread_add (filter->context,
+        gst_gl_color_grade_upload_lut, color_grade);
+
+    if (color_grade->upload_failed) {
+      GST_ELEMENT_ERROR (color_grade, RESOURCE, SETTINGS,
+          ("Failed to upload a LUT of size %u", color_grade->lut->size),
+          (NULL));
+      return FALSE;
+    }
+  }
+
+  //blocking call, use a FBO
+  gst_gl_filter_render_to_target (filter, TRUE, in_tex, out_tex,
+      gst_gl_color_grade_callback, color_grade);
+
+  return TRUE;
+}
+
+//opengl scene, params: input texture
+static void
+gst_gl_color_grade_callback (gint width, gint height, guint texture,
+    gpointer stuff)
+{
+  GstGLColorGrade *color_grade = GST_GL_COLOR_GRADE (stuff);
+  GstGLFilter *filter = GST_GL_FILTER (stuff);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  GstGLShader *shader = color_grade->shader;
+
+  gst_gl_shader_use (shader);
+
+  gst_gl_lut_bind (color_grade->lut, filter->context, shader, 1);
+
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, texture);
+  gst_gl_shader_set_uniform_1i (shader, "tex", 0);
+
+  gst_gl_shader_set_uniform_1f (shader, "intensity", color_grade->intensity);
+
+  gst_gl_context_bind_geometry (filter->context, GST_GL_GEOMETRY_QUAD,
+      gst_gl_shader_get_attribute_location (shader, "a_position"),
+      gst_gl_shader_get_attribute_location (shader, "a_texcoord"));
+  gst_gl_context_draw_geometry (filter->context, 0, 1);
+  gst_gl_context_unbind_geometry (filter->context);
+
+  gst_gl_context_clear_shader (filter->context);
+}
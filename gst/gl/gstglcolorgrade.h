@@ -0,0 +1,71 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_GL_COLOR_GRADE_H_
+#define _GST_GL_COLOR_GRADE_H_
+
+#include <gst/gl/gstglfilter.h>
+
+#include "gstgllut.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GL_COLOR_GRADE            (gst_gl_color_grade_get_type())
+#define GST_GL_COLOR_GRADE(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_COLOR_GRADE,GstGLColorGrade))
+#define GST_IS_GL_COLOR_GRADE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_COLOR_GRADE))
+#define GST_GL_COLOR_GRADE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GST_TYPE_GL_COLOR_GRADE,GstGLColorGradeClass))
+#define GST_IS_GL_COLOR_GRADE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GST_TYPE_GL_COLOR_GRADE))
+#define GST_GL_COLOR_GRADE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GST_TYPE_GL_COLOR_GRADE,GstGLColorGradeClass))
+
+typedef struct _GstGLColorGrade GstGLColorGrade;
+typedef struct _GstGLColorGradeClass GstGLColorGradeClass;
+
+struct _GstGLColorGrade
+{
+  GstGLFilter  filter;
+
+  /* properties */
+  gchar        *location;
+  GstGLLutBuiltin preset;
+  gfloat        intensity;
+
+  /* table parsed by the property setters, with OBJECT_LOCK */
+  GstGLLut     *pending_lut;
+  gboolean      lut_changed;
+
+  /* table in use and the one it replaced, deleted in the GL thread */
+  GstGLLut     *lut;
+  GstGLLut     *old_lut;
+  gboolean      upload_failed;
+
+  gboolean      texture_3d;
+  GstGLShader  *shader;
+};
+
+struct _GstGLColorGradeClass
+{
+  GstGLFilterClass filter_class;
+};
+
+GType gst_gl_color_grade_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_GL_COLOR_GRADE_H_ */
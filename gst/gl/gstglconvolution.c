@@ -0,0 +1,541 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Convolutions shared by the blur, sobel and laplacian filters.  The
+ * shaders are generated with the kernel baked in, so no tap costs more
+ * than its texture fetch and taps with a zero weight cost nothing. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "gstglconvolution.h"
+
+#ifndef GL_RGBA16F
+#define GL_RGBA16F 0x881A
+#endif
+
+#define GST_CAT_DEFAULT gst_gl_convolution_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+/* relative to the largest weight of the kernel */
+#define SEPARABLE_EPSILON 1e-5
+
+/* *INDENT-OFF* */
+static const gchar *convolution_vertex_source =
+  "attribute vec4 a_position;\n"
+  "attribute vec2 a_texcoord;\n"
+  "varying vec2 v_texcoord;\n"
+  "void main()\n"
+  "{\n"
+  "   gl_Position = a_position;\n"
+  "   v_texcoord = a_texcoord;\n"
+  "}\n";
+
+static const gchar *convolution_fragment_header =
+  "#ifdef GL_ES\n"
+  "precision mediump float;\n"
+  "#endif\n"
+  "varying vec2 v_texcoord;\n"
+  "uniform sampler2D tex;\n"
+  "uniform vec2 texel;\n"
+  "void main () {\n";
+/* *INDENT-ON* */
+
+GstGLConvolution *
+gst_gl_convolution_new (GstGLFilter * filter)
+{
+  GstGLConvolution *conv;
+  static gsize debug_init = 0;
+
+  if (g_once_init_enter (&debug_init)) {
+    GST_DEBUG_CATEGORY_INIT (gst_gl_convolution_debug, "glconvolution", 0,
+        "OpenGL convolutions");
+    g_once_init_leave (&debug_init, 1);
+  }
+
+  conv = g_new0 (GstGLConvolution, 1);
+  conv->filter = filter;
+  conv->passes = g_array_new (FALSE, TRUE, sizeof (GstGLConvolutionPass));
+
+  return conv;
+}
+
+void
+gst_gl_convolution_free (GstGLConvolution * conv)
+{
+  gst_gl_convolution_clear_passes (conv);
+  g_array_free (conv->passes, TRUE);
+  g_free (conv->kernel);
+  g_free (conv);
+}
+
+/* parses rows separated by ';' of weights separated by ',' into a row
+ * major kernel, a single row is used horizontally and vertically */
+gboolean
+gst_gl_convolution_parse_kernel (const gchar * str, gfloat ** kernel,
+    guint * width, guint * height)
+{
+  gchar **rows;
+  GArray *weights;
+  guint n_rows = 0, n_columns = 0;
+  guint i, j;
+
+  if (!str)
+    return FALSE;
+
+  weights = g_array_new (FALSE, FALSE, sizeof (gfloat));
+  rows = g_strsplit (str, ";", -1);
+
+  for (i = 0; rows[i]; i++) {
+    gchar **columns;
+    guint n = 0;
+
+    if (g_strstrip (rows[i])[0] == '\0')
+      continue;
+
+    columns = g_strsplit (rows[i], ",", -1);
+    for (j = 0; columns[j]; j++) {
+      gchar *end;
+      gfloat weight = g_ascii_strtod (g_strstrip (columns[j]), &end);
+
+      if (end == columns[j] || *end != '\0') {
+        g_strfreev (columns);
+        goto error;
+      }
+      g_array_append_val (weights, weight);
+      n++;
+    }
+    g_strfreev (columns);
+
+    if (n_rows > 0 && n != n_columns)
+      goto error;
+    n_columns = n;
+    n_rows++;
+  }
+  g_strfreev (rows);
+
+  if (n_rows == 0 || n_rows > GST_GL_CONVOLUTION_MAX_SIZE
+      || n_columns > GST_GL_CONVOLUTION_MAX_SIZE || n_rows % 2 == 0
+      || n_columns % 2 == 0) {
+    g_array_free (weights, TRUE);
+    return FALSE;
+  }
+
+  if (n_rows == 1) {
+    /* the outer product of the row with itself */
+    gfloat *row = (gfloat *) weights->data;
+
+    *kernel = g_new (gfloat, n_columns * n_columns);
+    for (i = 0; i < n_columns; i++)
+      for (j = 0; j < n_columns; j++)
+        (*kernel)[i * n_columns + j] = row[i] * row[j];
+    n_rows = n_columns;
+    g_array_free (weights, TRUE);
+  } else {
+    *kernel = (gfloat *) g_array_free (weights, FALSE);
+  }
+
+  *width = n_columns;
+  *height = n_rows;
+
+  return TRUE;
+
+error:
+  g_strfreev (rows);
+  g_array_free (weights, TRUE);
+  return FALSE;
+}
+
+void
+gst_gl_convolution_clear_passes (GstGLConvolution * conv)
+{
+  guint i;
+
+  for (i = 0; i < conv->passes->len; i++) {
+    GstGLConvolutionPass *pass =
+        &g_array_index (conv->passes, GstGLConvolutionPass, i);
+
+    /* the shaders go with gst_gl_convolution_reset_gl() */
+    g_warn_if_fail (pass->shader == NULL);
+    g_array_free (pass->taps, TRUE);
+  }
+  g_array_set_size (conv->passes, 0);
+}
+
+/* the kernel is split into passes by gst_gl_convolution_init_gl(), which
+ * knows whether the intermediate results can be negative */
+gboolean
+gst_gl_convolution_set_kernel (GstGLConvolution * conv, const gfloat * kernel,
+    guint width, guint height)
+{
+  g_return_val_if_fail (width % 2 == 1 && height % 2 == 1, FALSE);
+  g_return_val_if_fail (width <= GST_GL_CONVOLUTION_MAX_SIZE
+      && height <= GST_GL_CONVOLUTION_MAX_SIZE, FALSE);
+
+  gst_gl_convolution_clear_passes (conv);
+
+  g_free (conv->kernel);
+  conv->kernel = g_memdup (kernel, width * height * sizeof (gfloat));
+  conv->kernel_width = width;
+  conv->kernel_height = height;
+
+  return TRUE;
+}
+
+static gboolean
+_is_scalar (const GstGLConvolutionTap * tap)
+{
+  return tap->weight[0] == tap->weight[1] && tap->weight[0] == tap->weight[2]
+      && tap->weight[0] == tap->weight[3];
+}
+
+/* two taps one pixel apart along an axis and weighted alike are fetched
+ * at once between the two texels, where linear filtering blends them in
+ * proportion to their weights */
+static gboolean
+_can_merge (const GstGLConvolutionTap * a, const GstGLConvolutionTap * b)
+{
+  gboolean adjacent = (b->y == a->y && b->x == a->x + 1.0)
+      || (b->x == a->x && b->y == a->y + 1.0);
+
+  return adjacent && _is_scalar (a) && _is_scalar (b)
+      && a->weight[0] * b->weight[0] > 0.0;
+}
+
+void
+gst_gl_convolution_add_pass (GstGLConvolution * conv,
+    const GstGLConvolutionTap * taps, guint n_taps, const gfloat bias[4])
+{
+  GstGLConvolutionPass pass = { NULL, {0.0, 0.0, 0.0, 0.0}, NULL };
+  guint i = 0;
+
+  /* the passes were given explicitly */
+  g_free (conv->kernel);
+  conv->kernel = NULL;
+
+  pass.taps = g_array_new (FALSE, FALSE, sizeof (GstGLConvolutionTap));
+  if (bias)
+    memcpy (pass.bias, bias, sizeof (pass.bias));
+
+  while (i < n_taps) {
+    GstGLConvolutionTap tap = taps[i];
+
+    if (i + 1 < n_taps && _can_merge (&taps[i], &taps[i + 1])) {
+      gfloat wa = taps[i].weight[0];
+      gfloat wb = taps[i + 1].weight[0];
+      gfloat w = wa + wb;
+
+      tap.x = (taps[i].x * wa + taps[i + 1].x * wb) / w;
+      tap.y = (taps[i].y * wa + taps[i + 1].y * wb) / w;
+      tap.weight[0] = tap.weight[1] = tap.weight[2] = tap.weight[3] = w;
+      i += 2;
+    } else {
+      i++;
+    }
+
+    if (tap.weight[0] != 0.0 || tap.weight[1] != 0.0 || tap.weight[2] != 0.0
+        || tap.weight[3] != 0.0)
+      g_array_append_val (pass.taps, tap);
+  }
+
+  GST_DEBUG ("pass %u: %u taps in %u fetches", conv->passes->len, n_taps,
+      pass.taps->len);
+
+  g_array_append_val (conv->passes, pass);
+}
+
+static void
+_add_scalar_pass (GstGLConvolution * conv, const gfloat * weights,
+    guint width, guint height)
+{
+  GstGLConvolutionTap *taps = g_new (GstGLConvolutionTap, width * height);
+  gint cx = width / 2, cy = height / 2;
+  guint i, j;
+
+  for (i = 0; i < height; i++) {
+    for (j = 0; j < width; j++) {
+      GstGLConvolutionTap *tap = &taps[i * width + j];
+      gfloat w = weights[i * width + j];
+
+      tap->x = (gint) j - cx;
+      tap->y = (gint) i - cy;
+      tap->weight[0] = tap->weight[1] = tap->weight[2] = tap->weight[3] = w;
+    }
+  }
+
+  gst_gl_convolution_add_pass (conv, taps, width * height, NULL);
+  g_free (taps);
+}
+
+/* finds row and column vectors whose outer product is the kernel, with
+ * the row normalized so that the horizontal pass preserves the range of
+ * the input when it has no negative weight */
+static gboolean
+_split_kernel (const gfloat * kernel, guint width, guint height,
+    gfloat * row, gfloat * column)
+{
+  guint pivot = 0, i, j;
+  gfloat max = 0.0, scale = 0.0;
+
+  for (i = 0; i < width * height; i++) {
+    if (fabs (kernel[i]) > max) {
+      max = fabs (kernel[i]);
+      pivot = i;
+    }
+  }
+  if (max == 0.0)
+    return FALSE;
+
+  for (j = 0; j < width; j++)
+    row[j] = kernel[(pivot / width) * width + j];
+  for (i = 0; i < height; i++)
+    column[i] = kernel[i * width + pivot % width] / kernel[pivot];
+
+  for (i = 0; i < height; i++)
+    for (j = 0; j < width; j++)
+      if (fabs (kernel[i * width + j] - column[i] * row[j]) >
+          SEPARABLE_EPSILON * max)
+        return FALSE;
+
+  for (j = 0; j < width; j++)
+    scale += row[j];
+  if (scale != 0.0) {
+    for (j = 0; j < width; j++)
+      row[j] /= scale;
+    for (i = 0; i < height; i++)
+      column[i] *= scale;
+  }
+
+  return TRUE;
+}
+
+static void
+_build_passes (GstGLConvolution * conv)
+{
+  guint width = conv->kernel_width, height = conv->kernel_height;
+  gfloat *row = g_new (gfloat, width);
+  gfloat *column = g_new (gfloat, height);
+  gboolean negative = FALSE;
+  guint j;
+
+  gst_gl_convolution_clear_passes (conv);
+
+  if ((width > 1 && height > 1)
+      && _split_kernel (conv->kernel, width, height, row, column)) {
+    for (j = 0; j < width; j++)
+      negative |= row[j] < 0.0;
+
+    /* an 8 bit intermediate would clamp the negative sums */
+    if (!negative || conv->float_midtexture) {
+      _add_scalar_pass (conv, row, width, 1);
+      _add_scalar_pass (conv, column, 1, height);
+      goto done;
+    }
+    GST_DEBUG ("separable kernel with negative weights, using one pass");
+  }
+
+  _add_scalar_pass (conv, conv->kernel, width, height);
+
+done:
+  g_free (row);
+  g_free (column);
+}
+
+static void
+_append_float (GString * str, gfloat value)
+{
+  gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+  g_ascii_formatd (buf, sizeof (buf), "%.9g", value);
+  g_string_append (str, buf);
+  /* GLSL ES has no implicit conversion from int */
+  if (!strpbrk (buf, ".e"))
+    g_string_append (str, ".0");
+}
+
+static void
+_append_vec4 (GString * str, const gfloat * v)
+{
+  g_string_append (str, "vec4(");
+  _append_float (str, v[0]);
+  g_string_append (str, ", ");
+  _append_float (str, v[1]);
+  g_string_append (str, ", ");
+  _append_float (str, v[2]);
+  g_string_append (str, ", ");
+  _append_float (str, v[3]);
+  g_string_append (str, ")");
+}
+
+static gchar *
+_pass_fragment_source (const GstGLConvolutionPass * pass)
+{
+  GString *str = g_string_new (convolution_fragment_header);
+  guint i;
+
+  g_string_append (str, "  vec4 sum = ");
+  _append_vec4 (str, pass->bias);
+  g_string_append (str, ";\n");
+
+  for (i = 0; i < pass->taps->len; i++) {
+    GstGLConvolutionTap *tap =
+        &g_array_index (pass->taps, GstGLConvolutionTap, i);
+
+    g_string_append (str, "  sum += texture2D(tex, v_texcoord + vec2(");
+    _append_float (str, tap->x);
+    g_string_append (str, ", ");
+    _append_float (str, tap->y);
+    g_string_append (str, ") * texel) * ");
+    if (_is_scalar (tap))
+      _append_float (str, tap->weight[0]);
+    else
+      _append_vec4 (str, tap->weight);
+    g_string_append (str, ";\n");
+  }
+
+  g_string_append (str, "  gl_FragColor = sum;\n}\n");
+
+  return g_string_free (str, FALSE);
+}
+
+/* called from the streaming thread once the context exists */
+gboolean
+gst_gl_convolution_init_gl (GstGLConvolution * conv)
+{
+  GstGLFilter *filter = conv->filter;
+  guint width = GST_VIDEO_INFO_WIDTH (&filter->out_info);
+  guint height = GST_VIDEO_INFO_HEIGHT (&filter->out_info);
+  guint i;
+
+  /* the allocation may be renegotiated without a reset */
+  gst_gl_convolution_reset_gl (conv);
+
+  conv->float_midtexture =
+      gst_gl_context_check_feature (filter->context, "GL_ARB_texture_float");
+
+  if (conv->kernel)
+    _build_passes (conv);
+
+  g_return_val_if_fail (conv->passes->len > 0, FALSE);
+
+  for (i = 0; i < MIN (conv->passes->len - 1, 2); i++) {
+    //blocking call, generate a texture
+    if (conv->float_midtexture)
+      gst_gl_context_gen_texture_full (filter->context, &conv->midtexture[i],
+          GL_RGBA16F, width, height, 1);
+    else
+      gst_gl_context_gen_texture (filter->context, &conv->midtexture[i],
+          GST_VIDEO_FORMAT_RGBA, width, height);
+  }
+
+  for (i = 0; i < conv->passes->len; i++) {
+    GstGLConvolutionPass *pass =
+        &g_array_index (conv->passes, GstGLConvolutionPass, i);
+    gchar *fragment_source = _pass_fragment_source (pass);
+    gboolean ret;
+
+    GST_LOG ("pass %u fragment shader:\n%s", i, fragment_source);
+
+    //blocking call, wait the opengl thread has compiled the shader
+    ret = gst_gl_context_gen_shader (filter->context,
+        convolution_vertex_source, fragment_source, &pass->shader);
+    g_free (fragment_source);
+
+    if (!ret)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+void
+gst_gl_convolution_reset_gl (GstGLConvolution * conv)
+{
+  GstGLFilter *filter = conv->filter;
+  guint i;
+
+  for (i = 0; i < conv->passes->len; i++) {
+    GstGLConvolutionPass *pass =
+        &g_array_index (conv->passes, GstGLConvolutionPass, i);
+
+    //blocking call, wait the opengl thread has destroyed the shader
+    if (pass->shader)
+      gst_gl_context_del_shader (filter->context, pass->shader);
+    pass->shader = NULL;
+  }
+
+  for (i = 0; i < 2; i++) {
+    if (conv->midtexture[i])
+      gst_gl_context_del_texture (filter->context, &conv->midtexture[i]);
+    conv->midtexture[i] = 0;
+  }
+}
+
+static void
+_draw_pass (gint width, gint height, guint texture, gpointer stuff)
+{
+  GstGLConvolution *conv = stuff;
+  GstGLFilter *filter = conv->filter;
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  GstGLShader *shader =
+      g_array_index (conv->passes, GstGLConvolutionPass, conv->current).shader;
+
+  gst_gl_shader_use (shader);
+
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, texture);
+
+  gst_gl_shader_set_uniform_1i (shader, "tex", 0);
+  gst_gl_shader_set_uniform_2f (shader, "texel", 1.0 / width, 1.0 / height);
+
+  gst_gl_context_bind_geometry (filter->context, GST_GL_GEOMETRY_QUAD,
+      gst_gl_shader_get_attribute_location (shader, "a_position"),
+      gst_gl_shader_get_attribute_location (shader, "a_texcoord"));
+  gst_gl_context_draw_geometry (filter->context, 0, 1);
+  gst_gl_context_unbind_geometry (filter->context);
+
+  gst_gl_context_clear_shader (filter->context);
+}
+
+/* @resize is as for gst_gl_filter_render_to_target(), for the input */
+void
+gst_gl_convolution_render (GstGLConvolution * conv, gboolean resize,
+    guint in_tex, guint out_tex)
+{
+  guint n_passes = conv->passes->len;
+  guint src = in_tex;
+  guint i;
+
+  for (i = 0; i < n_passes; i++) {
+    guint dst = i + 1 == n_passes ? out_tex : conv->midtexture[i % 2];
+
+    conv->current = i;
+
+    //blocking call, use a FBO
+    gst_gl_filter_render_to_target (conv->filter, resize && i == 0, src, dst,
+        _draw_pass, conv);
+
+    src = dst;
+  }
+}
@@ -0,0 +1,97 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_GL_CONVOLUTION_H__
+#define __GST_GL_CONVOLUTION_H__
+
+#include <gst/gl/gstglfilter.h>
+
+G_BEGIN_DECLS
+
+/* largest kernel width or height */
+#define GST_GL_CONVOLUTION_MAX_SIZE 63
+
+typedef struct _GstGLConvolution GstGLConvolution;
+typedef struct _GstGLConvolutionTap GstGLConvolutionTap;
+typedef struct _GstGLConvolutionPass GstGLConvolutionPass;
+
+/* one texture fetch at an offset in pixels from the output pixel, the
+ * weights apply to r, g, b and a */
+struct _GstGLConvolutionTap
+{
+  gfloat x, y;
+  gfloat weight[4];
+};
+
+struct _GstGLConvolutionPass
+{
+  GArray *taps;
+  gfloat bias[4];
+  GstGLShader *shader;
+};
+
+/* A convolution is made of one or more passes that each sum the weighted
+ * taps of the previous one.  The passes are either built from the kernel
+ * given to gst_gl_convolution_set_kernel() once the context is known,
+ * splitting separable kernels into a horizontal and a vertical pass, or
+ * added one by one for kernels that differ per channel.  Adjacent taps
+ * with weights of the same sign are merged into a single linearly
+ * filtered fetch. */
+struct _GstGLConvolution
+{
+  GstGLFilter *filter;
+
+  gfloat *kernel;
+  guint kernel_width;
+  guint kernel_height;
+
+  /* GstGLConvolutionPass */
+  GArray *passes;
+  guint current;
+
+  /* output of every pass but the last one */
+  GLuint midtexture[2];
+  gboolean float_midtexture;
+};
+
+GstGLConvolution * gst_gl_convolution_new        (GstGLFilter * filter);
+void               gst_gl_convolution_free       (GstGLConvolution * conv);
+
+gboolean gst_gl_convolution_parse_kernel (const gchar * str, gfloat ** kernel,
+                                          guint * width, guint * height);
+
+void     gst_gl_convolution_clear_passes (GstGLConvolution * conv);
+gboolean gst_gl_convolution_set_kernel   (GstGLConvolution * conv,
+                                          const gfloat * kernel,
+                                          guint width, guint height);
+void     gst_gl_convolution_add_pass     (GstGLConvolution * conv,
+                                          const GstGLConvolutionTap * taps,
+                                          guint n_taps, const gfloat bias[4]);
+
+gboolean gst_gl_convolution_init_gl      (GstGLConvolution * conv);
+void     gst_gl_convolution_reset_gl     (GstGLConvolution * conv);
+
+void     gst_gl_convolution_render       (GstGLConvolution * conv,
+                                          gboolean resize, guint in_tex,
+                                          guint out_tex);
+
+G_END_DECLS
+
+#endif /* __GST_GL_CONVOLUTION_H__ */
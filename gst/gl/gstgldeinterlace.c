@@ -23,11 +23,24 @@
  *
  * Deinterlacing using based on fragment shaders.
  *
+ * Only buffers that are interlaced according to the interlace-mode of the
+ * caps, or to the #GST_VIDEO_BUFFER_FLAG_INTERLACED flag for mixed streams,
+ * are deinterlaced.  The field order is taken from
+ * #GST_VIDEO_BUFFER_FLAG_TFF.  The last frames are kept in a ring of
+ * textures for the methods that look at the history.
+ *
+ * With #GstGLDeinterlace:field-rate each field is output as a frame, doubling
+ * the framerate.  Otherwise only the first field of each frame is
+ * reconstructed.
+ *
  * <refsect2>
  * <title>Examples</title>
  * |[
  * gst-launch videotestsrc ! glupload ! gldeinterlace ! glimagesink
  * ]|
+ * |[
+ * gst-launch filesrc location=1080i.ts ! decodebin ! gldeinterlace method=yadif field-rate=true ! glimagesink
+ * ]|
  * FBO (Frame Buffer Object) and GLSL (OpenGL Shading Language) are required.
  * </refsect2>
  */
@@ -41,9 +54,14 @@
 #define GST_CAT_DEFAULT gst_gl_deinterlace_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
+#define DEFAULT_METHOD GST_GL_DEINTERLACE_METHOD_GREEDYH
+#define DEFAULT_FIELD_RATE FALSE
+
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_METHOD,
+  PROP_FIELD_RATE
 };
 
 #define DEBUG_INIT \
@@ -52,11 +70,17 @@ enum
 G_DEFINE_TYPE_WITH_CODE (GstGLDeinterlace, gst_gl_deinterlace,
     GST_TYPE_GL_FILTER, DEBUG_INIT);
 
+static void gst_gl_deinterlace_finalize (GObject * object);
 static void gst_gl_deinterlace_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
 static void gst_gl_deinterlace_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec);
 
+static GstCaps *gst_gl_deinterlace_fixate_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps);
+static GstFlowReturn gst_gl_deinterlace_transform (GstBaseTransform * bt,
+    GstBuffer * inbuf, GstBuffer * outbuf);
+
 static void gst_gl_deinterlace_reset (GstGLFilter * filter);
 static gboolean gst_gl_deinterlace_init_shader (GstGLFilter * filter);
 static gboolean gst_gl_deinterlace_filter (GstGLFilter * filter,
@@ -66,8 +90,136 @@ static gboolean gst_gl_deinterlace_filter_texture (GstGLFilter * filter,
 static void gst_gl_deinterlace_callback (gint width, gint height,
     guint texture, gpointer stuff);
 
+#define GST_TYPE_GL_DEINTERLACE_METHOD (gst_gl_deinterlace_method_get_type ())
+static GType
+gst_gl_deinterlace_method_get_type (void)
+{
+  static GType gl_deinterlace_method_type = 0;
+  static const GEnumValue method_types[] = {
+    {GST_GL_DEINTERLACE_METHOD_GREEDYH, "Motion adaptive greedy high",
+        "greedyh"},
+    {GST_GL_DEINTERLACE_METHOD_BOB, "Interpolate each field", "bob"},
+    {GST_GL_DEINTERLACE_METHOD_LINEAR, "Linear blend", "linear"},
+    {GST_GL_DEINTERLACE_METHOD_YADIF, "Motion adaptive, yadif style",
+        "yadif"},
+    {0, NULL, NULL}
+  };
+
+  if (!gl_deinterlace_method_type) {
+    gl_deinterlace_method_type =
+        g_enum_register_static ("GstGLDeinterlaceMethod", method_types);
+  }
+  return gl_deinterlace_method_type;
+}
+
 /* *INDENT-OFF* */
+static const gchar *deinterlace_vertex_source =
+  "attribute vec4 a_position;\n"
+  "attribute vec2 a_texcoord;\n"
+  "varying vec2 v_texcoord;\n"
+  "void main()\n"
+  "{\n"
+  "   gl_Position = a_position;\n"
+  "   v_texcoord = a_texcoord;\n"
+  "}\n";
+
+/* tex is the current frame, tex_prev and tex_prev2 the ones before it.
+ * field is the parity of the lines of the field being reconstructed,
+ * 0.0 for the top field.  fetch() reads the texel at integer coordinates */
+#define DEINTERLACE_FRAGMENT_HEADER \
+  "#ifdef GL_ES\n" \
+  "#ifdef GL_FRAGMENT_PRECISION_HIGH\n" \
+  "precision highp float;\n" \
+  "#else\n" \
+  "precision mediump float;\n" \
+  "#endif\n" \
+  "#endif\n" \
+  "varying vec2 v_texcoord;\n" \
+  "uniform sampler2D tex;\n" \
+  "uniform sampler2D tex_prev;\n" \
+  "uniform sampler2D tex_prev2;\n" \
+  "uniform vec2 size;\n" \
+  "uniform float field;\n" \
+  "vec3 fetch (sampler2D t, vec2 xy) {\n" \
+  "  return texture2D(t, (xy + 0.5) / size).rgb;\n" \
+  "}\n" \
+  "bool is_field_line (vec2 xy) {\n" \
+  "  return abs(mod(xy.y, 2.0) - field) < 0.5;\n" \
+  "}\n"
+
+static const gchar *bob_fragment_source =
+  DEINTERLACE_FRAGMENT_HEADER
+  "void main () {\n"
+  "  vec2 xy = floor(v_texcoord * size);\n"
+  "  vec3 color;\n"
+  "  if (is_field_line (xy))\n"
+  "    color = fetch (tex, xy);\n"
+  "  else\n"
+  "    color = (fetch (tex, xy - vec2(0.0, 1.0)) + fetch (tex, xy + vec2(0.0, 1.0))) / 2.0;\n"
+  "  gl_FragColor = vec4(color, 1.0);\n"
+  "}\n";
+
+static const gchar *linear_fragment_source =
+  DEINTERLACE_FRAGMENT_HEADER
+  "void main () {\n"
+  "  vec2 xy = floor(v_texcoord * size);\n"
+  "  vec3 color = fetch (tex, xy - vec2(0.0, 1.0)) + 2.0 * fetch (tex, xy)\n"
+  "      + fetch (tex, xy + vec2(0.0, 1.0));\n"
+  "  gl_FragColor = vec4(color / 4.0, 1.0);\n"
+  "}\n";
+
+/* the missing lines are interpolated along the direction with the smallest
+ * difference between the lines above and below.  The result is clamped
+ * around the temporal prediction by the largest temporal difference of the
+ * neighbourhood, so static areas keep the full vertical resolution.
+ * temporal_weight is 0.5 when the missing field of the previous frame and
+ * the one of the current frame are equally distant in time from the field
+ * being rendered, 0.0 when only the current one is close */
+static const gchar *yadif_fragment_source =
+  DEINTERLACE_FRAGMENT_HEADER
+  "uniform float temporal_weight;\n"
+  "float score (vec2 xy, float k) {\n"
+  "  const vec3 luma = vec3(0.299, 0.587, 0.114);\n"
+  "  return dot(luma, abs(fetch (tex, xy + vec2(k - 1.0, -1.0)) - fetch (tex, xy + vec2(-k - 1.0, 1.0))))\n"
+  "       + dot(luma, abs(fetch (tex, xy + vec2(k, -1.0)) - fetch (tex, xy + vec2(-k, 1.0))))\n"
+  "       + dot(luma, abs(fetch (tex, xy + vec2(k + 1.0, -1.0)) - fetch (tex, xy + vec2(-k + 1.0, 1.0))));\n"
+  "}\n"
+  "void main () {\n"
+  "  vec2 xy = floor(v_texcoord * size);\n"
+  "  if (is_field_line (xy)) {\n"
+  "    gl_FragColor = vec4(fetch (tex, xy), 1.0);\n"
+  "    return;\n"
+  "  }\n"
+  "  vec2 up = vec2(0.0, -1.0);\n"
+  "  vec2 down = vec2(0.0, 1.0);\n"
+  "  vec3 c = fetch (tex, xy + up);\n"
+  "  vec3 e = fetch (tex, xy + down);\n"
+  "  vec3 cur = fetch (tex, xy);\n"
+  "  vec3 prev = fetch (tex_prev, xy);\n"
+  "  vec3 prev2 = fetch (tex_prev2, xy);\n"
+  "  vec3 d = mix(cur, prev, temporal_weight);\n"
+  "  vec3 diff0 = abs(cur - prev) / 2.0;\n"
+  "  vec3 diff1 = (abs(fetch (tex_prev, xy + up) - c) + abs(fetch (tex_prev, xy + down) - e)) / 2.0;\n"
+  "  vec3 diff2 = abs(prev - prev2) / 2.0;\n"
+  "  vec3 diff = max(diff0, max(diff1, diff2));\n"
+  "  vec3 spatial = (c + e) / 2.0;\n"
+  "  float best = score (xy, 0.0);\n"
+  "  float s = score (xy, -1.0);\n"
+  "  if (s < best) {\n"
+  "    best = s;\n"
+  "    spatial = (fetch (tex, xy + vec2(-1.0, -1.0)) + fetch (tex, xy + vec2(1.0, 1.0))) / 2.0;\n"
+  "  }\n"
+  "  s = score (xy, 1.0);\n"
+  "  if (s < best)\n"
+  "    spatial = (fetch (tex, xy + vec2(1.0, -1.0)) + fetch (tex, xy + vec2(-1.0, 1.0))) / 2.0;\n"
+  "  gl_FragColor = vec4(clamp(spatial, d - diff, d + diff), 1.0);\n"
+  "}\n";
+
 static const gchar *greedyh_fragment_source =
+  "#ifdef GL_ES\n"
+  "precision mediump float;\n"
+  "#endif\n"
+  "varying vec2 v_texcoord;\n"
   "uniform sampler2D tex;\n"
   "uniform sampler2D tex_prev;\n"
   "uniform float max_comb;\n"
@@ -75,9 +227,8 @@ static const gchar *greedyh_fragment_source =
   "uniform float motion_sense;\n"
   "uniform float width;\n"
   "uniform float height;\n"
-
   "void main () {\n"
-  "  vec2 texcoord = gl_TexCoord[0].xy;\n"
+  "  vec2 texcoord = v_texcoord;\n"
   "  if (int(mod(texcoord.y * height, 2.0)) == 0) {\n"
   "    gl_FragColor = vec4(texture2D(tex_prev, texcoord).rgb, 1.0);\n"
   "  } else {\n"
@@ -146,6 +297,22 @@ static const gchar *greedyh_fragment_source =
   "}\n";
 /* *INDENT-ON* */
 
+static const gchar *
+gst_gl_deinterlace_get_fragment_source (GstGLDeinterlaceMethod method)
+{
+  switch (method) {
+    case GST_GL_DEINTERLACE_METHOD_BOB:
+      return bob_fragment_source;
+    case GST_GL_DEINTERLACE_METHOD_LINEAR:
+      return linear_fragment_source;
+    case GST_GL_DEINTERLACE_METHOD_YADIF:
+      return yadif_fragment_source;
+    case GST_GL_DEINTERLACE_METHOD_GREEDYH:
+    default:
+      return greedyh_fragment_source;
+  }
+}
+
 static void
 gst_gl_deinterlace_class_init (GstGLDeinterlaceClass * klass)
 {
@@ -157,12 +324,28 @@ gst_gl_deinterlace_class_init (GstGLDeinterlaceClass * klass)
 
   gobject_class->set_property = gst_gl_deinterlace_set_property;
   gobject_class->get_property = gst_gl_deinterlace_get_property;
+  gobject_class->finalize = gst_gl_deinterlace_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_METHOD,
+      g_param_spec_enum ("method", "Method", "Deinterlacing method",
+          GST_TYPE_GL_DEINTERLACE_METHOD, DEFAULT_METHOD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FIELD_RATE,
+      g_param_spec_boolean ("field-rate", "Field rate",
+          "Output one frame per field, doubling the framerate.  Only taken "
+          "into account when the caps are negotiated", DEFAULT_FIELD_RATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_set_metadata (element_class,
       "OpenGL deinterlacing filter", "Deinterlace",
       "Deinterlacing based on fragment shaders",
       "Julien Isorce <julien.isorce@mail.com>");
 
+  GST_BASE_TRANSFORM_CLASS (klass)->fixate_caps =
+      gst_gl_deinterlace_fixate_caps;
+  GST_BASE_TRANSFORM_CLASS (klass)->transform = gst_gl_deinterlace_transform;
+
   GST_GL_FILTER_CLASS (klass)->filter = gst_gl_deinterlace_filter;
   GST_GL_FILTER_CLASS (klass)->filter_texture =
       gst_gl_deinterlace_filter_texture;
@@ -173,9 +356,21 @@ gst_gl_deinterlace_class_init (GstGLDeinterlaceClass * klass)
 static void
 gst_gl_deinterlace_init (GstGLDeinterlace * filter)
 {
+  filter->method = DEFAULT_METHOD;
+  filter->field_rate = DEFAULT_FIELD_RATE;
   filter->shader = NULL;
-  filter->prev_buffer = NULL;
-  filter->prev_tex = 0;
+  filter->history =
+      gst_gl_history_new (GST_GL_FILTER (filter), GST_GL_DEINTERLACE_HISTORY);
+}
+
+static void
+gst_gl_deinterlace_finalize (GObject * object)
+{
+  GstGLDeinterlace *filter = GST_GL_DEINTERLACE (object);
+
+  gst_gl_history_free (filter->history);
+
+  G_OBJECT_CLASS (gst_gl_deinterlace_parent_class)->finalize (object);
 }
 
 static void
@@ -183,10 +378,8 @@ gst_gl_deinterlace_reset (GstGLFilter * filter)
 {
   GstGLDeinterlace *deinterlace_filter = GST_GL_DEINTERLACE (filter);
 
-  if (deinterlace_filter->prev_buffer) {
-    gst_buffer_unref (deinterlace_filter->prev_buffer);
-    deinterlace_filter->prev_buffer = NULL;
-  }
+  gst_gl_history_reset_gl (deinterlace_filter->history);
+
   //blocking call, wait the opengl thread has destroyed the shader
   if (deinterlace_filter->shader)
     gst_gl_context_del_shader (filter->context, deinterlace_filter->shader);
@@ -197,9 +390,15 @@ static void
 gst_gl_deinterlace_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
-  //GstGLDeinterlace *filter = GST_GL_DEINTERLACE (object);
+  GstGLDeinterlace *filter = GST_GL_DEINTERLACE (object);
 
   switch (prop_id) {
+    case PROP_METHOD:
+      filter->method = g_value_get_enum (value);
+      break;
+    case PROP_FIELD_RATE:
+      filter->field_rate = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -210,22 +409,71 @@ static void
 gst_gl_deinterlace_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
-  //GstGLDeinterlace *filter = GST_GL_DEINTERLACE (object);
+  GstGLDeinterlace *filter = GST_GL_DEINTERLACE (object);
 
   switch (prop_id) {
+    case PROP_METHOD:
+      g_value_set_enum (value, filter->method);
+      break;
+    case PROP_FIELD_RATE:
+      g_value_set_boolean (value, filter->field_rate);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* deinterlacing works line by line so the size is kept, the output is
+ * progressive and has twice the framerate at field rate */
+static GstCaps *
+gst_gl_deinterlace_fixate_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps)
+{
+  GstGLDeinterlace *deinterlace_filter = GST_GL_DEINTERLACE (bt);
+  GstStructure *ins, *outs;
+  gint width, height, fps_n, fps_d;
+
+  if (direction != GST_PAD_SINK)
+    goto done;
+
+  othercaps = gst_caps_truncate (othercaps);
+  othercaps = gst_caps_make_writable (othercaps);
+
+  ins = gst_caps_get_structure (caps, 0);
+  outs = gst_caps_get_structure (othercaps, 0);
+
+  if (gst_structure_get_int (ins, "width", &width))
+    gst_structure_fixate_field_nearest_int (outs, "width", width);
+  if (gst_structure_get_int (ins, "height", &height))
+    gst_structure_fixate_field_nearest_int (outs, "height", height);
+
+  if (gst_structure_get_fraction (ins, "framerate", &fps_n, &fps_d)) {
+    if (deinterlace_filter->field_rate && fps_n > 0)
+      gst_util_fraction_multiply (fps_n, fps_d, 2, 1, &fps_n, &fps_d);
+    gst_structure_fixate_field_nearest_fraction (outs, "framerate", fps_n,
+        fps_d);
+  }
+
+  gst_structure_remove_field (outs, "interlace-mode");
+
+done:
+  return GST_BASE_TRANSFORM_CLASS (gst_gl_deinterlace_parent_class)->fixate_caps
+      (bt, direction, caps, othercaps);
+}
+
 static gboolean
 gst_gl_deinterlace_init_shader (GstGLFilter * filter)
 {
   GstGLDeinterlace *deinterlace_filter = GST_GL_DEINTERLACE (filter);
 
-  //blocking call, wait the opengl thread has compiled the shader
-  return gst_gl_context_gen_shader (filter->context, 0, greedyh_fragment_source,
+  if (!gst_gl_history_init_gl (deinterlace_filter->history))
+    return FALSE;
+
+  deinterlace_filter->shader_method = deinterlace_filter->method;
+
+  return gst_gl_context_gen_shader (filter->context, deinterlace_vertex_source,
+      gst_gl_deinterlace_get_fragment_source (deinterlace_filter->method),
       &deinterlace_filter->shader);
 }
 
@@ -235,30 +483,149 @@ gst_gl_deinterlace_filter_texture (GstGLFilter * filter, guint in_tex,
 {
   GstGLDeinterlace *deinterlace_filter = GST_GL_DEINTERLACE (filter);
 
+  /* both fields of a frame come from the same input */
+  if (!deinterlace_filter->history_pushed) {
+    gst_gl_history_push (deinterlace_filter->history, in_tex,
+        GST_CLOCK_TIME_NONE);
+    deinterlace_filter->history_pushed = TRUE;
+  }
+
   //blocking call, use a FBO
-  gst_gl_filter_render_to_target (filter, TRUE, in_tex, out_tex,
+  gst_gl_filter_render_to_target (filter, FALSE,
+      gst_gl_history_get (deinterlace_filter->history, 0), out_tex,
       gst_gl_deinterlace_callback, deinterlace_filter);
 
   return TRUE;
 }
 
+static gboolean
+gst_gl_deinterlace_is_interlaced (GstGLDeinterlace * deinterlace_filter,
+    GstBuffer * buf)
+{
+  GstGLFilter *filter = GST_GL_FILTER (deinterlace_filter);
+
+  switch (GST_VIDEO_INFO_INTERLACE_MODE (&filter->in_info)) {
+    case GST_VIDEO_INTERLACE_MODE_PROGRESSIVE:
+      return FALSE;
+    case GST_VIDEO_INTERLACE_MODE_MIXED:
+      return GST_BUFFER_FLAG_IS_SET (buf, GST_VIDEO_BUFFER_FLAG_INTERLACED);
+    default:
+      return TRUE;
+  }
+}
+
+/* the first field of the field rate output is pushed from the filter
+ * function, its flow is returned instead of the second field */
+static GstFlowReturn
+gst_gl_deinterlace_transform (GstBaseTransform * bt, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  GstGLDeinterlace *deinterlace_filter = GST_GL_DEINTERLACE (bt);
+  GstFlowReturn ret;
+
+  deinterlace_filter->first_field_flow = GST_FLOW_OK;
+
+  ret = GST_BASE_TRANSFORM_CLASS (gst_gl_deinterlace_parent_class)->transform
+      (bt, inbuf, outbuf);
+
+  if (ret == GST_FLOW_OK)
+    ret = deinterlace_filter->first_field_flow;
+
+  return ret;
+}
+
 static gboolean
 gst_gl_deinterlace_filter (GstGLFilter * filter, GstBuffer * inbuf,
     GstBuffer * outbuf)
 {
   GstGLDeinterlace *deinterlace_filter = GST_GL_DEINTERLACE (filter);
+  GstBaseTransform *bt = GST_BASE_TRANSFORM (filter);
+  GstBuffer *first_field = NULL;
+  GstClockTime duration;
+
+  if (deinterlace_filter->shader_method != deinterlace_filter->method) {
+    if (deinterlace_filter->shader)
+      gst_gl_context_del_shader (filter->context, deinterlace_filter->shader);
+    deinterlace_filter->shader = NULL;
+
+    deinterlace_filter->shader_method = deinterlace_filter->method;
+    if (!gst_gl_context_gen_shader (filter->context,
+            deinterlace_vertex_source,
+            gst_gl_deinterlace_get_fragment_source (deinterlace_filter->method),
+            &deinterlace_filter->shader))
+      return FALSE;
+  }
 
-  gst_gl_filter_filter_texture (filter, inbuf, outbuf);
+  if (GST_BUFFER_FLAG_IS_SET (inbuf, GST_BUFFER_FLAG_DISCONT))
+    gst_gl_history_flush (deinterlace_filter->history);
+
+  deinterlace_filter->interlaced =
+      gst_gl_deinterlace_is_interlaced (deinterlace_filter, inbuf);
+  deinterlace_filter->tff =
+      GST_BUFFER_FLAG_IS_SET (inbuf, GST_VIDEO_BUFFER_FLAG_TFF);
+  deinterlace_filter->history_pushed = FALSE;
+  deinterlace_filter->field_index = 0;
+
+  if (!deinterlace_filter->field_rate)
+    return gst_gl_filter_filter_texture (filter, inbuf, outbuf);
+
+  duration = GST_BUFFER_DURATION (inbuf);
+  if (!GST_CLOCK_TIME_IS_VALID (duration)
+      && GST_VIDEO_INFO_FPS_N (&filter->in_info) > 0)
+    duration = gst_util_uint64_scale_int (GST_SECOND,
+        GST_VIDEO_INFO_FPS_D (&filter->in_info),
+        GST_VIDEO_INFO_FPS_N (&filter->in_info));
+
+  /* outbuf is pushed when we return, so the first field goes in a buffer
+   * that is pushed here */
+  if (GST_BASE_TRANSFORM_CLASS
+      (gst_gl_deinterlace_parent_class)->prepare_output_buffer (bt, inbuf,
+          &first_field) != GST_FLOW_OK)
+    return FALSE;
+
+  if (!gst_gl_filter_filter_texture (filter, inbuf, first_field)) {
+    gst_buffer_unref (first_field);
+    return FALSE;
+  }
 
-  if (deinterlace_filter->prev_buffer) {
-    gst_buffer_unref (deinterlace_filter->prev_buffer);
+  if (GST_CLOCK_TIME_IS_VALID (duration)) {
+    GST_BUFFER_DURATION (first_field) = duration / 2;
+    GST_BUFFER_DURATION (outbuf) = duration - duration / 2;
+    if (GST_BUFFER_PTS_IS_VALID (inbuf))
+      GST_BUFFER_PTS (outbuf) = GST_BUFFER_PTS (inbuf) + duration / 2;
   }
-  deinterlace_filter->prev_buffer = gst_buffer_ref (inbuf);
 
-  return TRUE;
+  /* flushing, EOS or an error downstream, don't render the second field.
+   * The flow is returned by the transform function */
+  deinterlace_filter->first_field_flow =
+      gst_pad_push (GST_BASE_TRANSFORM_SRC_PAD (bt), first_field);
+  if (deinterlace_filter->first_field_flow != GST_FLOW_OK) {
+    GST_DEBUG_OBJECT (filter, "failed to push the first field: %s",
+        gst_flow_get_name (deinterlace_filter->first_field_flow));
+    return TRUE;
+  }
+
+  deinterlace_filter->field_index = 1;
+
+  return gst_gl_filter_filter_texture (filter, inbuf, outbuf);
 }
 
-//opengl scene, params: input texture (not the output filter->texture)
+static void
+gst_gl_deinterlace_draw (GstGLDeinterlace * deinterlace_filter,
+    GstGLShader * shader)
+{
+  GstGLFilter *filter = GST_GL_FILTER (deinterlace_filter);
+
+  gst_gl_context_bind_geometry (filter->context, GST_GL_GEOMETRY_QUAD,
+      gst_gl_shader_get_attribute_location (shader, "a_position"),
+      gst_gl_shader_get_attribute_location (shader, "a_texcoord"));
+  gst_gl_context_draw_geometry (filter->context, 0, 1);
+  gst_gl_context_unbind_geometry (filter->context);
+
+  gst_gl_context_clear_shader (filter->context);
+}
+
+//opengl scene, params: the newest frame of the history
 static void
 gst_gl_deinterlace_callback (gint width, gint height, guint texture,
     gpointer stuff)
@@ -266,86 +633,44 @@ gst_gl_deinterlace_callback (gint width, gint height, guint texture,
   GstGLDeinterlace *deinterlace_filter = GST_GL_DEINTERLACE (stuff);
   GstGLFilter *filter = GST_GL_FILTER (stuff);
   GstGLFuncs *gl = filter->context->gl_vtable;
-  guint temp;
+  GstGLShader *shader = deinterlace_filter->shader;
+  gboolean top;
 
-  GLfloat verts[] = { -1.0, -1.0,
-    1.0, -1.0,
-    1.0, 1.0,
-    -1.0, 1.0
-  };
-  GLfloat texcoords0[] = { 0.0f, 0.0f,
-    1.0f, 0.0f,
-    1.0f, 1.0f,
-    0.0f, 1.0f
-  };
-  GLfloat texcoords1[] = { 0.0f, 0.0f,
-    1.0f, 0.0f,
-    1.0f, 1.0f,
-    0.0f, 1.0f
-  };
+  if (!deinterlace_filter->interlaced) {
+    gst_gl_history_draw_copy (deinterlace_filter->history, texture);
+    return;
+  }
 
-  gl->MatrixMode (GL_PROJECTION);
-  gl->LoadIdentity ();
+  /* the first field is the top one for TFF frames */
+  top = deinterlace_filter->tff == (deinterlace_filter->field_index == 0);
 
-  gst_gl_shader_use (deinterlace_filter->shader);
+  gst_gl_shader_use (shader);
 
-  gl->Enable (GL_TEXTURE_2D);
+  gl->ActiveTexture (GL_TEXTURE2);
+  gl->BindTexture (GL_TEXTURE_2D,
+      gst_gl_history_get (deinterlace_filter->history, 2));
+  gst_gl_shader_set_uniform_1i (shader, "tex_prev2", 2);
 
-  if (G_UNLIKELY (deinterlace_filter->prev_tex == 0)) {
-    gst_gl_context_gen_texture (filter->context,
-        &deinterlace_filter->prev_tex,
-        GST_VIDEO_INFO_FORMAT (&filter->out_info),
-        GST_VIDEO_INFO_WIDTH (&filter->out_info),
-        GST_VIDEO_INFO_HEIGHT (&filter->out_info));
-  } else {
-    gl->ActiveTexture (GL_TEXTURE1);
-    gst_gl_shader_set_uniform_1i (deinterlace_filter->shader, "tex_prev", 1);
-    gl->BindTexture (GL_TEXTURE_2D, deinterlace_filter->prev_tex);
-  }
+  gl->ActiveTexture (GL_TEXTURE1);
+  gl->BindTexture (GL_TEXTURE_2D,
+      gst_gl_history_get (deinterlace_filter->history, 1));
+  gst_gl_shader_set_uniform_1i (shader, "tex_prev", 1);
 
   gl->ActiveTexture (GL_TEXTURE0);
-  gst_gl_shader_set_uniform_1i (deinterlace_filter->shader, "tex", 0);
   gl->BindTexture (GL_TEXTURE_2D, texture);
+  gst_gl_shader_set_uniform_1i (shader, "tex", 0);
 
-  gst_gl_shader_set_uniform_1f (deinterlace_filter->shader, "max_comb",
-      5.0f / 255.0f);
-  gst_gl_shader_set_uniform_1f (deinterlace_filter->shader, "motion_threshold",
-      25.0f / 255.0f);
-  gst_gl_shader_set_uniform_1f (deinterlace_filter->shader, "motion_sense",
-      30.0f / 255.0f);
-
-  gst_gl_shader_set_uniform_1f (deinterlace_filter->shader, "width",
-      GST_VIDEO_INFO_WIDTH (&filter->out_info));
-  gst_gl_shader_set_uniform_1f (deinterlace_filter->shader, "height",
-      GST_VIDEO_INFO_HEIGHT (&filter->out_info));
-
-  gl->ClientActiveTexture (GL_TEXTURE0);
-
-  gl->EnableClientState (GL_TEXTURE_COORD_ARRAY);
-  gl->EnableClientState (GL_VERTEX_ARRAY);
+  gst_gl_shader_set_uniform_2f (shader, "size", (gfloat) width,
+      (gfloat) height);
+  gst_gl_shader_set_uniform_1f (shader, "field", top ? 0.0f : 1.0f);
+  gst_gl_shader_set_uniform_1f (shader, "temporal_weight",
+      deinterlace_filter->field_index == 0 ? 0.5f : 0.0f);
 
-  gl->VertexPointer (2, GL_FLOAT, 0, &verts);
-  gl->TexCoordPointer (2, GL_FLOAT, 0, &texcoords0);
+  gst_gl_shader_set_uniform_1f (shader, "max_comb", 5.0f / 255.0f);
+  gst_gl_shader_set_uniform_1f (shader, "motion_threshold", 25.0f / 255.0f);
+  gst_gl_shader_set_uniform_1f (shader, "motion_sense", 30.0f / 255.0f);
+  gst_gl_shader_set_uniform_1f (shader, "width", (gfloat) width);
+  gst_gl_shader_set_uniform_1f (shader, "height", (gfloat) height);
 
-  gl->ClientActiveTexture (GL_TEXTURE1);
-  gl->EnableClientState (GL_TEXTURE_COORD_ARRAY);
-  gl->TexCoordPointer (2, GL_FLOAT, 0, &texcoords1);
-
-  gl->DrawArrays (GL_TRIANGLE_FAN, 0, 4);
-
-  gl->DisableClientState (GL_VERTEX_ARRAY);
-  gl->DisableClientState (GL_TEXTURE_COORD_ARRAY);
-
-  gl->ClientActiveTexture (GL_TEXTURE0);
-  gl->DisableClientState (GL_TEXTURE_COORD_ARRAY);
-
-  gl->Disable (GL_TEXTURE_2D);
-
-  if (texture == filter->in_tex_id) {
-    temp = filter->in_tex_id;
-    filter->in_tex_id = deinterlace_filter->prev_tex;
-    deinterlace_filter->prev_tex = temp;
-  } else {
-    deinterlace_filter->prev_tex = texture;
-  }
+  gst_gl_deinterlace_draw (deinterlace_filter, shader);
 }
@@ -1,55 +1,96 @@
-/* 
- * GStreamer
- * Copyright (C) 2009 Julien Isorce <julien.isorce@gmail.com>
- *
- * This library is free software; you can redistribute it and/or
- * modify it under the terms of the GNU Library General Public
- * License as published by the Free Software Foundation; either
- * version 2 of the License, or (at your option) any later version.
- *
- * This library is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
- * Library General Public License for more details.
- *
- * You should have received a copy of the GNU Library General Public
- * License along with this library; if not, write to the
- * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
- * Boston, MA 02110-1301, USA.
- */
-
-#ifndef _GST_GL_DEINTERLACE_H_
-#define _GST_GL_DEINTERLACE_H_
-
-#include <gst/gl/gstglfilter.h>
-
-G_BEGIN_DECLS
-
-#define GST_TYPE_GL_DEINTERLACE            (gst_gl_deinterlace_get_type())
-#define GST_GL_DEINTERLACE(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_DEINTERLACE,GstGLDeinterlace))
-#define GST_IS_GL_DEINTERLACE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_DEINTERLACE))
-#define GST_GL_DEINTERLACE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GST_TYPE_GL_DEINTERLACE,GstGLDeinterlaceClass))
-#define GST_IS_GL_DEINTERLACE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GST_TYPE_GL_DEINTERLACE))
-#define GST_GL_DEINTERLACE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GST_TYPE_GL_DEINTERLACE,GstGLDeinterlaceClass))
-
-typedef struct _GstGLDeinterlace GstGLDeinterlace;
-typedef struct _GstGLDeinterlaceClass GstGLDeinterlaceClass;
-
-struct _GstGLDeinterlace
-{
-  GstGLFilter  filter;
-  GstGLShader  *shader;
-  GstBuffer    *prev_buffer;
-  guint         prev_tex;
-};
-
-struct _GstGLDeinterlaceClass
-{
-  GstGLFilterClass filter_class;
-};
-
-GType gst_gl_deinterlace_get_type (void);
-
-G_END_DECLS
-
-#endif /* _GST_GLFILTERLAPLACIAN_H_ */
+/* 
+ * GStreamer
+ * Copyright (C) 2009 Julien Isorce <julien.isorce@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_GL_DEINTERLACE_H_
+#define _GST_GL_DEINTERLACE_H_
+
+#include <gst/gl/gstglfilter.h>
+
+#include "gstglhistory.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GL_DEINTERLACE            (gst_gl_deinterlace_get_type())
+#define GST_GL_DEINTERLACE(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_DEINTERLACE,GstGLDeinterlace))
+#define GST_IS_GL_DEINTERLACE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_DEINTERLACE))
+#define GST_GL_DEINTERLACE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GST_TYPE_GL_DEINTERLACE,GstGLDeinterlaceClass))
+#define GST_IS_GL_DEINTERLACE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GST_TYPE_GL_DEINTERLACE))
+#define GST_GL_DEINTERLACE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GST_TYPE_GL_DEINTERLACE,GstGLDeinterlaceClass))
+
+typedef struct _GstGLDeinterlace GstGLDeinterlace;
+typedef struct _GstGLDeinterlaceClass GstGLDeinterlaceClass;
+
+/**
+ * GstGLDeinterlaceMethod:
+ * @GST_GL_DEINTERLACE_METHOD_GREEDYH: motion adaptive greedy high, one
+ *   frame of history
+ * @GST_GL_DEINTERLACE_METHOD_BOB: interpolate the missing lines of each
+ *   field
+ * @GST_GL_DEINTERLACE_METHOD_LINEAR: vertical [1 2 1] blend of both fields
+ * @GST_GL_DEINTERLACE_METHOD_YADIF: edge directed spatial interpolation
+ *   bounded by the temporal differences of two frames of history
+ *
+ * The deinterlacing algorithm.
+ */
+typedef enum
+{
+  GST_GL_DEINTERLACE_METHOD_GREEDYH,
+  GST_GL_DEINTERLACE_METHOD_BOB,
+  GST_GL_DEINTERLACE_METHOD_LINEAR,
+  GST_GL_DEINTERLACE_METHOD_YADIF
+} GstGLDeinterlaceMethod;
+
+/* the current frame and the two before it */
+#define GST_GL_DEINTERLACE_HISTORY 3
+
+struct _GstGLDeinterlace
+{
+  GstGLFilter  filter;
+
+  GstGLDeinterlaceMethod method;
+  gboolean      field_rate;
+
+  /* shader of shader_method */
+  GstGLShader  *shader;
+  GstGLDeinterlaceMethod shader_method;
+
+  /* the last input frames */
+  GstGLHistory *history;
+  gboolean      history_pushed;
+
+  /* the field being rendered */
+  gboolean      interlaced;
+  gboolean      tff;
+  guint         field_index;
+
+  /* result of pushing the first field, with field-rate */
+  GstFlowReturn first_field_flow;
+};
+
+struct _GstGLDeinterlaceClass
+{
+  GstGLFilterClass filter_class;
+};
+
+GType gst_gl_deinterlace_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_GL_DEINTERLACE_H_ */
@@ -0,0 +1,399 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-gldenoise
+ *
+ * Motion adaptive recursive temporal noise reduction based on fragment
+ * shaders.
+ *
+ * Each output frame is a blend of the input frame and of the previous
+ * output frame, which is kept until the next frame.
+ * #GstGLDenoise:strength is the weight of the previous output in static
+ * areas.  Where the difference between both frames around a pixel goes
+ * above #GstGLDenoise:threshold the pixel is taken as moving and the
+ * previous output is faded out, so moving objects do not leave trails.
+ * The history is dropped on discontinuities.
+ *
+ * <refsect2>
+ * <title>Examples</title>
+ * |[
+ * gst-launch v4l2src ! glupload ! gldenoise strength=0.8 ! glimagesink
+ * ]|
+ * FBO (Frame Buffer Object) and GLSL (OpenGL Shading Language) are required.
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstgldenoise.h"
+
+#define GST_CAT_DEFAULT gst_gl_denoise_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define DEFAULT_STRENGTH 0.7f
+#define DEFAULT_THRESHOLD 0.05f
+
+enum
+{
+  PROP_0,
+  PROP_STRENGTH,
+  PROP_THRESHOLD
+};
+
+#define DEBUG_INIT \
+  GST_DEBUG_CATEGORY_INIT (gst_gl_denoise_debug, "gldenoise", 0, "gldenoise element");
+
+G_DEFINE_TYPE_WITH_CODE (GstGLDenoise, gst_gl_denoise, GST_TYPE_GL_FILTER,
+    DEBUG_INIT);
+
+static void gst_gl_denoise_finalize (GObject * object);
+static void gst_gl_denoise_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_gl_denoise_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static GstCaps *gst_gl_denoise_fixate_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps);
+
+static void gst_gl_denoise_reset (GstGLFilter * filter);
+static gboolean gst_gl_denoise_init_shader (GstGLFilter * filter);
+static gboolean gst_gl_denoise_filter (GstGLFilter * filter,
+    GstBuffer * inbuf, GstBuffer * outbuf);
+static gboolean gst_gl_denoise_filter_texture (GstGLFilter * filter,
+    guint in_tex, guint out_tex);
+static void gst_gl_denoise_callback (gint width, gint height,
+    guint texture, gpointer stuff);
+
+/* *INDENT-OFF* */
+static const gchar *denoise_vertex_source =
+  "attribute vec4 a_position;\n"
+  "attribute vec2 a_texcoord;\n"
+  "varying vec2 v_texcoord;\n"
+  "void main()\n"
+  "{\n"
+  "   gl_Position = a_position;\n"
+  "   v_texcoord = a_texcoord;\n"
+  "}\n";
+
+/* tex is the input frame and tex_prev the previous output.  The motion is
+ * the mean luma difference over 3x3 pixels, which averages the noise out
+ * while a real change moves every pixel of the neighbourhood */
+static const gchar *denoise_fragment_source =
+  "#ifdef GL_ES\n"
+  "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+  "precision highp float;\n"
+  "#else\n"
+  "precision mediump float;\n"
+  "#endif\n"
+  "#endif\n"
+  "varying vec2 v_texcoord;\n"
+  "uniform sampler2D tex;\n"
+  "uniform sampler2D tex_prev;\n"
+  "uniform vec2 size;\n"
+  "uniform float strength;\n"
+  "uniform float threshold;\n"
+  "void main () {\n"
+  "  const vec3 luma = vec3(0.299, 0.587, 0.114);\n"
+  "  float motion = 0.0;\n"
+  "  for (int y = -1; y <= 1; y++) {\n"
+  "    for (int x = -1; x <= 1; x++) {\n"
+  "      vec2 uv = v_texcoord + vec2(float(x), float(y)) / size;\n"
+  "      motion += abs(dot(luma, texture2D(tex, uv).rgb - texture2D(tex_prev, uv).rgb));\n"
+  "    }\n"
+  "  }\n"
+  "  motion /= 9.0;\n"
+  "  float k = strength * (1.0 - smoothstep(threshold, 2.0 * threshold, motion));\n"
+  "  vec3 cur = texture2D(tex, v_texcoord).rgb;\n"
+  "  vec3 prev = texture2D(tex_prev, v_texcoord).rgb;\n"
+  "  gl_FragColor = vec4(mix(cur, prev, k), 1.0);\n"
+  "}\n";
+/* *INDENT-ON* */
+
+static void
+gst_gl_denoise_class_init (GstGLDenoiseClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+
+  gobject_class = (GObjectClass *) klass;
+  element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->set_property = gst_gl_denoise_set_property;
+  gobject_class->get_property = gst_gl_denoise_get_property;
+  gobject_class->finalize = gst_gl_denoise_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_STRENGTH,
+      g_param_spec_float ("strength", "Strength",
+          "Weight of the previous frame in static areas, 0 disables the "
+          "filter", 0.0f, 0.95f, DEFAULT_STRENGTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_THRESHOLD,
+      g_param_spec_float ("threshold", "Threshold",
+          "Mean luma difference above which an area is taken as moving",
+          0.001f, 1.0f, DEFAULT_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_metadata (element_class,
+      "OpenGL temporal denoise filter", "Filter/Effect/Video",
+      "Motion adaptive recursive temporal noise reduction",
+      "The GStreamer developers");
+
+  GST_BASE_TRANSFORM_CLASS (klass)->fixate_caps = gst_gl_denoise_fixate_caps;
+
+  GST_GL_FILTER_CLASS (klass)->filter = gst_gl_denoise_filter;
+  GST_GL_FILTER_CLASS (klass)->filter_texture = gst_gl_denoise_filter_texture;
+  GST_GL_FILTER_CLASS (klass)->onInitFBO = gst_gl_denoise_init_shader;
+  GST_GL_FILTER_CLASS (klass)->onReset = gst_gl_denoise_reset;
+}
+
+static void
+gst_gl_denoise_init (GstGLDenoise * filter)
+{
+  filter->strength = DEFAULT_STRENGTH;
+  filter->threshold = DEFAULT_THRESHOLD;
+  filter->shader = NULL;
+  filter->history = gst_gl_history_new (GST_GL_FILTER (filter), 1);
+}
+
+static void
+gst_gl_denoise_finalize (GObject * object)
+{
+  GstGLDenoise *filter = GST_GL_DENOISE (object);
+
+  gst_gl_history_free (filter->history);
+
+  G_OBJECT_CLASS (gst_gl_denoise_parent_class)->finalize (object);
+}
+
+static void
+gst_gl_denoise_reset (GstGLFilter * filter)
+{
+  GstGLDenoise *denoise_filter = GST_GL_DENOISE (filter);
+
+  gst_gl_history_reset_gl (denoise_filter->history);
+  gst_buffer_replace (&denoise_filter->prev_buf, NULL);
+
+  //blocking call, wait the opengl thread has destroyed the shader
+  if (denoise_filter->shader)
+    gst_gl_context_del_shader (filter->context, denoise_filter->shader);
+  denoise_filter->shader = NULL;
+}
+
+static void
+gst_gl_denoise_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGLDenoise *filter = GST_GL_DENOISE (object);
+
+  switch (prop_id) {
+    case PROP_STRENGTH:
+      filter->strength = g_value_get_float (value);
+      break;
+    case PROP_THRESHOLD:
+      filter->threshold = g_value_get_float (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gl_denoise_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGLDenoise *filter = GST_GL_DENOISE (object);
+
+  switch (prop_id) {
+    case PROP_STRENGTH:
+      g_value_set_float (value, filter->strength);
+      break;
+    case PROP_THRESHOLD:
+      g_value_set_float (value, filter->threshold);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* the previous output is at the input size so the size is kept */
+static GstCaps *
+gst_gl_denoise_fixate_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps)
+{
+  GstStructure *ins, *outs;
+  gint width, height;
+
+  if (direction != GST_PAD_SINK)
+    goto done;
+
+  othercaps = gst_caps_truncate (othercaps);
+  othercaps = gst_caps_make_writable (othercaps);
+
+  ins = gst_caps_get_structure (caps, 0);
+  outs = gst_caps_get_structure (othercaps, 0);
+
+  if (gst_structure_get_int (ins, "width", &width))
+    gst_structure_fixate_field_nearest_int (outs, "width", width);
+  if (gst_structure_get_int (ins, "height", &height))
+    gst_structure_fixate_field_nearest_int (outs, "height", height);
+
+done:
+  return GST_BASE_TRANSFORM_CLASS (gst_gl_denoise_parent_class)->fixate_caps
+      (bt, direction, caps, othercaps);
+}
+
+static gboolean
+gst_gl_denoise_init_shader (GstGLFilter * filter)
+{
+  GstGLDenoise *denoise_filter = GST_GL_DENOISE (filter);
+
+  if (!gst_gl_history_init_gl (denoise_filter->history))
+    return FALSE;
+
+  //blocking call, wait the opengl thread has compiled the shader
+  return gst_gl_context_gen_shader (filter->context, denoise_vertex_source,
+      denoise_fragment_source, &denoise_filter->shader);
+}
+
+static gboolean
+gst_gl_denoise_filter (GstGLFilter * filter, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  GstGLDenoise *denoise_filter = GST_GL_DENOISE (filter);
+  GstVideoFrame prev_frame;
+  GstMemory *mem;
+  gboolean ret;
+
+  if (GST_BUFFER_FLAG_IS_SET (inbuf, GST_BUFFER_FLAG_DISCONT)) {
+    gst_gl_history_flush (denoise_filter->history);
+    gst_buffer_replace (&denoise_filter->prev_buf, NULL);
+  }
+
+  /* a GL output is the previous frame of the next input as it is, other
+   * outputs are downloaded from a texture that is reused */
+  mem = gst_buffer_peek_memory (outbuf, 0);
+  denoise_filter->keep_output = gst_is_gl_memory (mem)
+      && !GST_GL_MEMORY_IS_PLANE (mem);
+  if (!denoise_filter->keep_output)
+    gst_buffer_replace (&denoise_filter->prev_buf, NULL);
+
+  /* the output size changed with the caps */
+  if (denoise_filter->prev_buf) {
+    GstGLMemory *prev_mem =
+        (GstGLMemory *) gst_buffer_peek_memory (denoise_filter->prev_buf, 0);
+
+    if (GST_VIDEO_INFO_WIDTH (&prev_mem->v_info) !=
+        GST_VIDEO_INFO_WIDTH (&filter->out_info)
+        || GST_VIDEO_INFO_HEIGHT (&prev_mem->v_info) !=
+        GST_VIDEO_INFO_HEIGHT (&filter->out_info))
+      gst_buffer_replace (&denoise_filter->prev_buf, NULL);
+  }
+
+  denoise_filter->prev_tex = 0;
+  if (denoise_filter->prev_buf) {
+    if (!gst_video_frame_map (&prev_frame, &filter->out_info,
+            denoise_filter->prev_buf, GST_MAP_READ | GST_MAP_GL))
+      return FALSE;
+    denoise_filter->prev_tex = *(guint *) prev_frame.data[0];
+  }
+
+  ret = gst_gl_filter_filter_texture (filter, inbuf, outbuf);
+
+  if (denoise_filter->prev_buf)
+    gst_video_frame_unmap (&prev_frame);
+
+  if (denoise_filter->keep_output)
+    gst_buffer_replace (&denoise_filter->prev_buf, outbuf);
+
+  return ret;
+}
+
+static gboolean
+gst_gl_denoise_filter_texture (GstGLFilter * filter, guint in_tex,
+    guint out_tex)
+{
+  GstGLDenoise *denoise_filter = GST_GL_DENOISE (filter);
+
+  //blocking call, use a FBO
+  gst_gl_filter_render_to_target (filter, FALSE, in_tex, out_tex,
+      gst_gl_denoise_callback, denoise_filter);
+
+  /* the output is the history of the next frame */
+  if (!denoise_filter->keep_output)
+    gst_gl_history_push (denoise_filter->history, out_tex,
+        GST_CLOCK_TIME_NONE);
+
+  return TRUE;
+}
+
+//opengl scene, params: the input frame
+static void
+gst_gl_denoise_callback (gint width, gint height, guint texture,
+    gpointer stuff)
+{
+  GstGLDenoise *denoise_filter = GST_GL_DENOISE (stuff);
+  GstGLFilter *filter = GST_GL_FILTER (stuff);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  GstGLShader *shader = denoise_filter->shader;
+  GLuint prev_tex;
+
+  if (denoise_filter->keep_output)
+    prev_tex = denoise_filter->prev_tex;
+  else if (denoise_filter->history->len > 0)
+    prev_tex = gst_gl_history_get (denoise_filter->history, 0);
+  else
+    prev_tex = 0;
+
+  /* nothing to blend with after a discontinuity */
+  if (!prev_tex) {
+    gst_gl_history_draw_copy (denoise_filter->history, texture);
+    return;
+  }
+
+  gst_gl_shader_use (shader);
+
+  gl->ActiveTexture (GL_TEXTURE1);
+  gl->BindTexture (GL_TEXTURE_2D, prev_tex);
+  gst_gl_shader_set_uniform_1i (shader, "tex_prev", 1);
+
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, texture);
+  gst_gl_shader_set_uniform_1i (shader, "tex", 0);
+
+  gst_gl_shader_set_uniform_2f (shader, "size", (gfloat) width,
+      (gfloat) height);
+  gst_gl_shader_set_uniform_1f (shader, "strength", denoise_filter->strength);
+  gst_gl_shader_set_uniform_1f (shader, "threshold",
+      denoise_filter->threshold);
+
+  gst_gl_context_bind_geometry (filter->context, GST_GL_GEOMETRY_QUAD,
+      gst_gl_shader_get_attribute_location (shader, "a_position"),
+      gst_gl_shader_get_attribute_location (shader, "a_texcoord"));
+  gst_gl_context_draw_geometry (filter->context, 0, 1);
+  gst_gl_context_unbind_geometry (filter->context);
+
+  gst_gl_context_clear_shader (filter->context);
+}
@@ -0,0 +1,68 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_GL_DENOISE_H_
+#define _GST_GL_DENOISE_H_
+
+#include <gst/gl/gstglfilter.h>
+
+#include "gstglhistory.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GL_DENOISE            (gst_gl_denoise_get_type())
+#define GST_GL_DENOISE(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_DENOISE,GstGLDenoise))
+#define GST_IS_GL_DENOISE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_DENOISE))
+#define GST_GL_DENOISE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GST_TYPE_GL_DENOISE,GstGLDenoiseClass))
+#define GST_IS_GL_DENOISE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GST_TYPE_GL_DENOISE))
+#define GST_GL_DENOISE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GST_TYPE_GL_DENOISE,GstGLDenoiseClass))
+
+typedef struct _GstGLDenoise GstGLDenoise;
+typedef struct _GstGLDenoiseClass GstGLDenoiseClass;
+
+struct _GstGLDenoise
+{
+  GstGLFilter  filter;
+
+  /* properties */
+  gfloat        strength;
+  gfloat        threshold;
+
+  /* the previous output frame, blended with each input.  GL output
+   * buffers are kept and sampled in place, other outputs are copied into
+   * the history */
+  GstBuffer    *prev_buf;
+  GLuint        prev_tex;
+  gboolean      keep_output;
+  GstGLHistory *history;
+
+  GstGLShader  *shader;
+};
+
+struct _GstGLDenoiseClass
+{
+  GstGLFilterClass filter_class;
+};
+
+GType gst_gl_denoise_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_GL_DENOISE_H_ */
@@ -21,12 +21,23 @@
 /**
  * SECTION:element-gldifferencematte.
  *
- * Saves a background frame and replace it with a pixbuf.
+ * Compares every frame against a background model and replaces the
+ * background with a pixbuf.
+ *
+ * With #GstGLDifferenceMatte:model set to running-average the background
+ * is an exponential running average of the input kept in a float texture
+ * and updated on the GPU every frame, so slow changes like lighting are
+ * absorbed.  The foreground mask can also be output at a lower resolution
+ * on a "mask" request pad, which makes the element usable as a motion
+ * detector without a background image.
  *
  * <refsect2>
  * <title>Examples</title>
  * |[
- * gst-launch videotestsrc ! glupload ! gldifferencemate location=backgroundimagefile ! glimagesink
+ * gst-launch-1.0 videotestsrc ! glupload ! gldifferencematte location=backgroundimagefile ! glimagesink
+ * ]|
+ * |[
+ * gst-launch-1.0 v4l2src ! glupload ! gldifferencematte name=m model=running-average ! fakesink m.mask ! gldownload ! videoconvert ! autovideosink
  * ]|
  * FBO (Frame Buffer Object) and GLSL (OpenGL Shading Language) are required.
  * </refsect2>
@@ -47,6 +58,10 @@
 #define png_infopp_NULL    NULL
 #endif
 
+#ifndef GL_RGBA16F
+#define GL_RGBA16F 0x881A
+#endif
+
 #define GST_CAT_DEFAULT gst_gl_differencematte_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
@@ -61,78 +76,207 @@ static void gst_gl_differencematte_set_property (GObject * object,
 static void gst_gl_differencematte_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec);
 
+static GstPad *gst_gl_differencematte_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * req_name, const GstCaps * caps);
+static void gst_gl_differencematte_release_pad (GstElement * element,
+    GstPad * pad);
+static gboolean gst_gl_differencematte_sink_event (GstBaseTransform * trans,
+    GstEvent * event);
+static GstFlowReturn gst_gl_differencematte_transform (GstBaseTransform * bt,
+    GstBuffer * inbuf, GstBuffer * outbuf);
+
 static void gst_gl_differencematte_init_resources (GstGLFilter * filter);
 static void gst_gl_differencematte_reset_resources (GstGLFilter * filter);
 
+static gboolean gst_gl_differencematte_filter (GstGLFilter * filter,
+    GstBuffer * inbuf, GstBuffer * outbuf);
 static gboolean gst_gl_differencematte_filter_texture (GstGLFilter * filter,
     guint in_tex, guint out_tex);
 
 static gboolean gst_gl_differencematte_loader (GstGLFilter * filter);
 
+static GstStaticPadTemplate mask_template = GST_STATIC_PAD_TEMPLATE ("mask",
+    GST_PAD_SRC,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("RGBA"))
+    );
+
 enum
 {
   PROP_0,
   PROP_LOCATION,
+  PROP_MODEL,
+  PROP_LEARNING_RATE,
+  PROP_THRESHOLD,
+  PROP_MASK_SCALE
 };
 
+#define DEFAULT_MODEL GST_GL_DIFFERENCEMATTE_MODEL_STATIC
+#define DEFAULT_LEARNING_RATE 0.05
+#define DEFAULT_THRESHOLD 0.12
+#define DEFAULT_MASK_SCALE 4
+
+#define GST_TYPE_GL_DIFFERENCEMATTE_MODEL (gst_gl_differencematte_model_get_type ())
+static GType
+gst_gl_differencematte_model_get_type (void)
+{
+  static GType gl_differencematte_model_type = 0;
+  static const GEnumValue model_types[] = {
+    {GST_GL_DIFFERENCEMATTE_MODEL_STATIC,
+        "Frame seen when the background image was set", "static"},
+    {GST_GL_DIFFERENCEMATTE_MODEL_RUNNING_AVERAGE,
+        "Running average updated every frame", "running-average"},
+    {0, NULL, NULL}
+  };
+
+  if (!gl_differencematte_model_type) {
+    gl_differencematte_model_type =
+        g_enum_register_static ("GstGLDifferenceMatteModel", model_types);
+  }
+  return gl_differencematte_model_type;
+}
+
+/* The difference used to be computed, blurred horizontally, blurred
+ * vertically and composited in four full frame passes.  The difference is
+ * now computed for every tap of the horizontal blur and the vertical blur is
+ * done while compositing, so only the horizontally blurred mask goes
+ * through a texture. */
+
+/* *INDENT-OFF* */
+static const gchar *update_fragment_source =
+  "uniform sampler2D current;"
+  "uniform sampler2D model;"
+  "uniform float rate;"
+  "void main () {"
+  "  vec4 currentcolor = texture2D (current, gl_TexCoord[0].st);"
+  "  vec4 modelcolor = texture2D (model, gl_TexCoord[0].st);"
+  "  gl_FragColor = mix (modelcolor, currentcolor, rate);"
+  "}";
+
+static const gchar *diff_hblur_fragment_source =
+  "uniform sampler2D current;"
+  "uniform sampler2D model;"
+  "uniform float kernel[7];"
+  "uniform float threshold;"
+  "uniform float width;"
+  "void main () {"
+  "  float w = 1.0 / width;"
+  "  float sum = 0.0;"
+  "  int i;"
+  "  for (i = 0; i < 7; i++) {"
+  "    vec2 coord = gl_TexCoord[0].st + vec2 (float (i - 3) * w, 0.0);"
+  "    vec4 diff = texture2D (current, coord) - texture2D (model, coord);"
+  "    sum += step (threshold, length (diff)) * kernel[i];"
+  "  }"
+  "  gl_FragColor = vec4 (sum);"
+  "}";
+
+#define VBLUR_MASK_SOURCE \
+  "uniform sampler2D mask;" \
+  "uniform float kernel[7];" \
+  "uniform float height;" \
+  "float vblur_mask () {" \
+  "  float h = 1.0 / height;" \
+  "  float sum = 0.0;" \
+  "  int i;" \
+  "  for (i = 0; i < 7; i++) {" \
+  "    vec2 coord = gl_TexCoord[0].st + vec2 (0.0, float (i - 3) * h);" \
+  "    sum += texture2D (mask, coord).r * kernel[i];" \
+  "  }" \
+  "  return sum;" \
+  "}"
+
+static const gchar *vblur_interp_fragment_source =
+  VBLUR_MASK_SOURCE
+  "uniform sampler2D base;"
+  "uniform sampler2D blend;"
+  "void main () {"
+  "  vec4 basecolor = texture2D (base, gl_TexCoord[0].st);"
+  "  vec4 blendcolor = texture2D (blend, gl_TexCoord[0].st);"
+  "  float alpha = vblur_mask ();"
+  "  gl_FragColor = (alpha * blendcolor) + (1.0 - alpha) * basecolor;"
+  "}";
+
+static const gchar *vblur_mask_fragment_source =
+  VBLUR_MASK_SOURCE
+  "void main () {"
+  "  gl_FragColor = vec4 (vec3 (vblur_mask ()), 1.0);"
+  "}";
+/* *INDENT-ON* */
+
+static GLuint
+_gen_texture (GstGLFilter * filter, GLenum internal_format)
+{
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  GLuint tex;
+
+  gl->GenTextures (1, &tex);
+  gl->BindTexture (GL_TEXTURE_2D, tex);
+  gl->TexImage2D (GL_TEXTURE_2D, 0, internal_format,
+      GST_VIDEO_INFO_WIDTH (&filter->out_info),
+      GST_VIDEO_INFO_HEIGHT (&filter->out_info),
+      0, GL_RGBA, internal_format == GL_RGBA8 ? GL_UNSIGNED_BYTE : GL_FLOAT,
+      NULL);
+  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  return tex;
+}
+
+static gboolean
+_compile_shader (GstGLDifferenceMatte * differencematte, guint i,
+    const gchar * source, const gchar * name)
+{
+  GstGLFilter *filter = GST_GL_FILTER (differencematte);
+
+  differencematte->shader[i] = gst_gl_shader_new (filter->context);
+
+  if (!gst_gl_shader_compile_and_check (differencematte->shader[i],
+          source, GST_GL_SHADER_FRAGMENT_SOURCE)) {
+    gst_gl_context_set_error (filter->context,
+        "Failed to initialize %s shader", name);
+    GST_ELEMENT_ERROR (differencematte, RESOURCE, NOT_FOUND,
+        ("%s", gst_gl_context_get_error ()), (NULL));
+    return FALSE;
+  }
+
+  return TRUE;
+}
 
 /* init resources that need a gl context */
 static void
 gst_gl_differencematte_init_gl_resources (GstGLFilter * filter)
 {
   GstGLDifferenceMatte *differencematte = GST_GL_DIFFERENCEMATTE (filter);
-  GstGLFuncs *gl = filter->context->gl_vtable;
+  GLenum model_format = GL_RGBA8;
   gint i;
 
-  for (i = 0; i < 4; i++) {
-    gl->GenTextures (1, &differencematte->midtexture[i]);
-    gl->BindTexture (GL_TEXTURE_2D, differencematte->midtexture[i]);
-    gl->TexImage2D (GL_TEXTURE_2D, 0, GL_RGBA8,
-        GST_VIDEO_INFO_WIDTH (&filter->out_info),
-        GST_VIDEO_INFO_HEIGHT (&filter->out_info),
-        0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    differencematte->shader[i] = gst_gl_shader_new (filter->context);
-  }
+  /* small learning rates would never move an 8 bit average */
+  if (gst_gl_context_check_feature (filter->context, "GL_ARB_texture_float"))
+    model_format = GL_RGBA16F;
+  else
+    GST_WARNING_OBJECT (differencematte, "no float textures, the running "
+        "average is kept with 8 bits per channel");
 
-  if (!gst_gl_shader_compile_and_check (differencematte->shader[0],
-          difference_fragment_source, GST_GL_SHADER_FRAGMENT_SOURCE)) {
-    gst_gl_context_set_error (GST_GL_FILTER (differencematte)->context,
-        "Failed to initialize difference shader");
-    GST_ELEMENT_ERROR (differencematte, RESOURCE, NOT_FOUND,
-        ("%s", gst_gl_context_get_error ()), (NULL));
-    return;
-  }
+  differencematte->midtexture = _gen_texture (filter, GL_RGBA8);
+  for (i = 0; i < 2; i++)
+    differencematte->model_tex[i] = _gen_texture (filter, model_format);
+  differencematte->model_index = 0;
+  differencematte->model_reset = TRUE;
 
-  if (!gst_gl_shader_compile_and_check (differencematte->shader[1],
-          hconv7_fragment_source, GST_GL_SHADER_FRAGMENT_SOURCE)) {
-    gst_gl_context_set_error (GST_GL_FILTER (differencematte)->context,
-        "Failed to initialize hconv7 shader");
-    GST_ELEMENT_ERROR (differencematte, RESOURCE, NOT_FOUND,
-        ("%s", gst_gl_context_get_error ()), (NULL));
+  if (!_compile_shader (differencematte, 0, update_fragment_source, "update"))
     return;
-  }
-
-  if (!gst_gl_shader_compile_and_check (differencematte->shader[2],
-          vconv7_fragment_source, GST_GL_SHADER_FRAGMENT_SOURCE)) {
-    gst_gl_context_set_error (GST_GL_FILTER (differencematte)->context,
-        "Failed to initialize vconv7 shader");
-    GST_ELEMENT_ERROR (differencematte, RESOURCE, NOT_FOUND,
-        ("%s", gst_gl_context_get_error ()), (NULL));
+  if (!_compile_shader (differencematte, 1, diff_hblur_fragment_source,
+          "difference"))
     return;
-  }
-
-  if (!gst_gl_shader_compile_and_check (differencematte->shader[3],
-          texture_interp_fragment_source, GST_GL_SHADER_FRAGMENT_SOURCE)) {
-    gst_gl_context_set_error (GST_GL_FILTER (differencematte)->context,
-        "Failed to initialize interp shader");
-    GST_ELEMENT_ERROR (differencematte, RESOURCE, NOT_FOUND,
-        ("%s", gst_gl_context_get_error ()), (NULL));
+  if (!_compile_shader (differencematte, 2, vblur_interp_fragment_source,
+          "interp"))
+    return;
+  if (!_compile_shader (differencematte, 3, vblur_mask_fragment_source,
+          "mask"))
     return;
-  }
 }
 
 /* free resources that need a gl context */
@@ -143,22 +287,20 @@ gst_gl_differencematte_reset_gl_resources (GstGLFilter * filter)
   GstGLFuncs *gl = filter->context->gl_vtable;
   gint i;
 
-  gl->DeleteTextures (1, &differencematte->savedbgtexture);
   gl->DeleteTextures (1, &differencematte->newbgtexture);
+  gl->DeleteTextures (2, differencematte->model_tex);
+  gl->DeleteTextures (1, &differencematte->midtexture);
   for (i = 0; i < 4; i++) {
     if (differencematte->shader[i]) {
       gst_object_unref (differencematte->shader[i]);
       differencematte->shader[i] = NULL;
     }
-    if (differencematte->midtexture[i]) {
-      gl->DeleteTextures (1, &differencematte->midtexture[i]);
-      differencematte->midtexture[i] = 0;
-    }
   }
   differencematte->location = NULL;
   differencematte->pixbuf = NULL;
-  differencematte->savedbgtexture = 0;
   differencematte->newbgtexture = 0;
+  differencematte->midtexture = 0;
+  differencematte->model_tex[0] = differencematte->model_tex[1] = 0;
   differencematte->bg_has_changed = FALSE;
 }
 
@@ -173,6 +315,17 @@ gst_gl_differencematte_class_init (GstGLDifferenceMatteClass * klass)
   gobject_class->set_property = gst_gl_differencematte_set_property;
   gobject_class->get_property = gst_gl_differencematte_get_property;
 
+  element_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_gl_differencematte_request_new_pad);
+  element_class->release_pad =
+      GST_DEBUG_FUNCPTR (gst_gl_differencematte_release_pad);
+
+  GST_BASE_TRANSFORM_CLASS (klass)->sink_event =
+      gst_gl_differencematte_sink_event;
+  GST_BASE_TRANSFORM_CLASS (klass)->transform =
+      gst_gl_differencematte_transform;
+
+  GST_GL_FILTER_CLASS (klass)->filter = gst_gl_differencematte_filter;
   GST_GL_FILTER_CLASS (klass)->filter_texture =
       gst_gl_differencematte_filter_texture;
   GST_GL_FILTER_CLASS (klass)->display_init_cb =
@@ -189,6 +342,40 @@ gst_gl_differencematte_class_init (GstGLDifferenceMatteClass * klass)
           "Background image location", NULL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class,
+      PROP_MODEL,
+      g_param_spec_enum ("model",
+          "Background model",
+          "How the background that frames are compared against is built",
+          GST_TYPE_GL_DIFFERENCEMATTE_MODEL, DEFAULT_MODEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_LEARNING_RATE,
+      g_param_spec_double ("learning-rate",
+          "Learning rate",
+          "Weight of every new frame in the running average background",
+          0.0, 1.0, DEFAULT_LEARNING_RATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_THRESHOLD,
+      g_param_spec_double ("threshold",
+          "Threshold",
+          "Colour distance from the background above which a pixel is "
+          "foreground", 0.0, 2.0, DEFAULT_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_MASK_SCALE,
+      g_param_spec_uint ("mask-scale",
+          "Mask scale",
+          "Downscaling factor of the frames on the mask pad", 1, 16,
+          DEFAULT_MASK_SCALE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&mask_template));
+
   gst_element_class_set_metadata (element_class,
       "Gstreamer OpenGL DifferenceMatte", "Filter/Effect/Video",
       "Saves a background frame and replace it with a pixbuf",
@@ -204,17 +391,42 @@ gst_gl_differencematte_init (GstGLDifferenceMatte * differencematte)
   differencematte->shader[3] = NULL;
   differencematte->location = NULL;
   differencematte->pixbuf = NULL;
-  differencematte->savedbgtexture = 0;
   differencematte->newbgtexture = 0;
   differencematte->bg_has_changed = FALSE;
 
+  differencematte->model = DEFAULT_MODEL;
+  differencematte->learning_rate = DEFAULT_LEARNING_RATE;
+  differencematte->threshold = DEFAULT_THRESHOLD;
+  differencematte->mask_scale = DEFAULT_MASK_SCALE;
+
   fill_gaussian_kernel (differencematte->kernel, 7, 30.0);
 }
 
+static void
+_reset_mask_output (GstGLDifferenceMatte * differencematte)
+{
+  GstGLFilter *filter = GST_GL_FILTER (differencematte);
+
+  if (differencematte->mask_pool) {
+    gst_buffer_pool_set_active (differencematte->mask_pool, FALSE);
+    gst_object_unref (differencematte->mask_pool);
+    differencematte->mask_pool = NULL;
+  }
+
+  //blocking call, delete the FBO
+  if (differencematte->mask_fbo && filter->context)
+    gst_gl_context_del_fbo (filter->context, differencematte->mask_fbo,
+        differencematte->mask_depthbuffer);
+  differencematte->mask_fbo = 0;
+  differencematte->mask_depthbuffer = 0;
+}
+
 static void
 gst_gl_differencematte_reset_resources (GstGLFilter * filter)
 {
-//  GstGLDifferenceMatte* differencematte = GST_GL_DIFFERENCEMATTE(filter);
+  GstGLDifferenceMatte *differencematte = GST_GL_DIFFERENCEMATTE (filter);
+
+  _reset_mask_output (differencematte);
 }
 
 static void
@@ -230,6 +442,18 @@ gst_gl_differencematte_set_property (GObject * object, guint prop_id,
       differencematte->bg_has_changed = TRUE;
       differencematte->location = g_value_dup_string (value);
       break;
+    case PROP_MODEL:
+      differencematte->model = g_value_get_enum (value);
+      break;
+    case PROP_LEARNING_RATE:
+      differencematte->learning_rate = g_value_get_double (value);
+      break;
+    case PROP_THRESHOLD:
+      differencematte->threshold = g_value_get_double (value);
+      break;
+    case PROP_MASK_SCALE:
+      differencematte->mask_scale = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -246,6 +470,18 @@ gst_gl_differencematte_get_property (GObject * object, guint prop_id,
     case PROP_LOCATION:
       g_value_set_string (value, differencematte->location);
       break;
+    case PROP_MODEL:
+      g_value_set_enum (value, differencematte->model);
+      break;
+    case PROP_LEARNING_RATE:
+      g_value_set_double (value, differencematte->learning_rate);
+      break;
+    case PROP_THRESHOLD:
+      g_value_set_double (value, differencematte->threshold);
+      break;
+    case PROP_MASK_SCALE:
+      g_value_set_uint (value, differencematte->mask_scale);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -258,17 +494,231 @@ gst_gl_differencematte_init_resources (GstGLFilter * filter)
 //  GstGLDifferenceMatte *differencematte = GST_GL_DIFFERENCEMATTE (filter);
 }
 
+static gboolean
+_copy_sticky_event (GstPad * pad, GstEvent ** event, gpointer user_data)
+{
+  GstPad *maskpad = user_data;
+
+  /* the mask has its own caps and the segment has to follow them */
+  if (GST_EVENT_TYPE (*event) == GST_EVENT_STREAM_START)
+    gst_pad_store_sticky_event (maskpad, *event);
+
+  return TRUE;
+}
+
+static GstPad *
+gst_gl_differencematte_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * req_name, const GstCaps * caps)
+{
+  GstGLDifferenceMatte *differencematte = GST_GL_DIFFERENCEMATTE (element);
+  GstPad *maskpad;
+
+  GST_OBJECT_LOCK (differencematte);
+  if (differencematte->maskpad) {
+    GST_OBJECT_UNLOCK (differencematte);
+    GST_WARNING_OBJECT (differencematte, "the mask pad already exists");
+    return NULL;
+  }
+
+  maskpad = gst_pad_new_from_template (templ, "mask");
+  differencematte->maskpad = maskpad;
+  GST_OBJECT_UNLOCK (differencematte);
+
+  gst_pad_use_fixed_caps (maskpad);
+  gst_pad_set_active (maskpad, TRUE);
+  gst_pad_sticky_events_foreach (GST_BASE_TRANSFORM_SINK_PAD (element),
+      _copy_sticky_event, maskpad);
+  gst_element_add_pad (element, maskpad);
+
+  return maskpad;
+}
+
 static void
-gst_gl_differencematte_save_texture (gint width, gint height, guint texture,
-    gpointer stuff)
+gst_gl_differencematte_release_pad (GstElement * element, GstPad * pad)
 {
-  GstGLFilter *filter = GST_GL_FILTER (stuff);
-  GstGLFuncs *gl = filter->context->gl_vtable;
+  GstGLDifferenceMatte *differencematte = GST_GL_DIFFERENCEMATTE (element);
 
-  gl->MatrixMode (GL_PROJECTION);
-  gl->LoadIdentity ();
+  GST_OBJECT_LOCK (differencematte);
+  if (differencematte->maskpad != pad) {
+    GST_OBJECT_UNLOCK (differencematte);
+    g_warning ("Unknown pad %s", GST_PAD_NAME (pad));
+    return;
+  }
+  differencematte->maskpad = NULL;
+  GST_OBJECT_UNLOCK (differencematte);
 
-  gst_gl_filter_draw_texture (filter, texture, width, height);
+  gst_pad_set_active (pad, FALSE);
+  gst_element_remove_pad (element, pad);
+}
+
+static GstPad *
+_get_mask_pad (GstGLDifferenceMatte * differencematte)
+{
+  GstPad *maskpad = NULL;
+
+  GST_OBJECT_LOCK (differencematte);
+  if (differencematte->maskpad)
+    maskpad = gst_object_ref (differencematte->maskpad);
+  GST_OBJECT_UNLOCK (differencematte);
+
+  return maskpad;
+}
+
+static gboolean
+gst_gl_differencematte_sink_event (GstBaseTransform * trans, GstEvent * event)
+{
+  GstGLDifferenceMatte *differencematte = GST_GL_DIFFERENCEMATTE (trans);
+  GstPad *maskpad;
+
+  maskpad = _get_mask_pad (differencematte);
+  if (maskpad) {
+    switch (GST_EVENT_TYPE (event)) {
+      case GST_EVENT_CAPS:
+        /* renegotiated from the next mask frame */
+        break;
+      case GST_EVENT_SEGMENT:
+        if (gst_pad_has_current_caps (maskpad))
+          gst_pad_push_event (maskpad, gst_event_ref (event));
+        break;
+      default:
+        if (GST_EVENT_IS_SERIALIZED (event)
+            || GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_START)
+          gst_pad_push_event (maskpad, gst_event_ref (event));
+        break;
+    }
+    gst_object_unref (maskpad);
+  }
+
+  return
+      GST_BASE_TRANSFORM_CLASS (gst_gl_differencematte_parent_class)->sink_event
+      (trans, event);
+}
+
+/* (re)negotiates the mask pad, called from the streaming thread */
+static gboolean
+_ensure_mask_output (GstGLDifferenceMatte * differencematte, GstPad * maskpad)
+{
+  GstGLFilter *filter = GST_GL_FILTER (differencematte);
+  GstStructure *config;
+  GstEvent *segment;
+  GstCaps *caps;
+  gint width, height;
+
+  width = MAX (1,
+      GST_VIDEO_INFO_WIDTH (&filter->out_info) / differencematte->mask_scale);
+  height = MAX (1,
+      GST_VIDEO_INFO_HEIGHT (&filter->out_info) / differencematte->mask_scale);
+
+  if (differencematte->mask_pool
+      && GST_VIDEO_INFO_WIDTH (&differencematte->mask_info) == width
+      && GST_VIDEO_INFO_HEIGHT (&differencematte->mask_info) == height)
+    return TRUE;
+
+  _reset_mask_output (differencematte);
+
+  gst_video_info_set_format (&differencematte->mask_info,
+      GST_VIDEO_FORMAT_RGBA, width, height);
+  GST_VIDEO_INFO_FPS_N (&differencematte->mask_info) =
+      GST_VIDEO_INFO_FPS_N (&filter->out_info);
+  GST_VIDEO_INFO_FPS_D (&differencematte->mask_info) =
+      GST_VIDEO_INFO_FPS_D (&filter->out_info);
+
+  caps = gst_video_info_to_caps (&differencematte->mask_info);
+  GST_DEBUG_OBJECT (differencematte, "mask caps %" GST_PTR_FORMAT, caps);
+
+  if (!gst_pad_push_event (maskpad, gst_event_new_caps (caps))) {
+    gst_caps_unref (caps);
+    return FALSE;
+  }
+
+  segment = gst_pad_get_sticky_event (GST_BASE_TRANSFORM_SINK_PAD (filter),
+      GST_EVENT_SEGMENT, 0);
+  if (segment)
+    gst_pad_push_event (maskpad, segment);
+
+  differencematte->mask_pool = gst_gl_buffer_pool_new (filter->context);
+  config = gst_buffer_pool_get_config (differencematte->mask_pool);
+  gst_buffer_pool_config_set_params (config, caps,
+      GST_VIDEO_INFO_SIZE (&differencematte->mask_info), 0, 0);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+  gst_caps_unref (caps);
+
+  if (!gst_buffer_pool_set_config (differencematte->mask_pool, config)
+      || !gst_buffer_pool_set_active (differencematte->mask_pool, TRUE)) {
+    GST_WARNING_OBJECT (differencematte, "failed to configure the mask pool");
+    _reset_mask_output (differencematte);
+    return FALSE;
+  }
+
+  //blocking call, generate a FBO
+  if (!gst_gl_context_gen_fbo (filter->context, width, height,
+          &differencematte->mask_fbo, &differencematte->mask_depthbuffer)) {
+    _reset_mask_output (differencematte);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* the mask is pushed from the filter function, an unlinked mask pad is
+ * fine but flushing and errors downstream of it stop the stream */
+static GstFlowReturn
+gst_gl_differencematte_transform (GstBaseTransform * bt, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  GstGLDifferenceMatte *differencematte = GST_GL_DIFFERENCEMATTE (bt);
+  GstFlowReturn ret;
+
+  differencematte->mask_flow = GST_FLOW_OK;
+
+  ret =
+      GST_BASE_TRANSFORM_CLASS (gst_gl_differencematte_parent_class)->transform
+      (bt, inbuf, outbuf);
+
+  if (ret == GST_FLOW_OK && (differencematte->mask_flow == GST_FLOW_FLUSHING
+          || differencematte->mask_flow <= GST_FLOW_NOT_NEGOTIATED))
+    ret = differencematte->mask_flow;
+
+  return ret;
+}
+
+static gboolean
+gst_gl_differencematte_filter (GstGLFilter * filter, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  GstGLDifferenceMatte *differencematte = GST_GL_DIFFERENCEMATTE (filter);
+  GstBuffer *maskbuf = NULL;
+  GstVideoFrame mask_frame;
+  GstPad *maskpad;
+  gboolean ret;
+
+  maskpad = _get_mask_pad (differencematte);
+  if (maskpad && _ensure_mask_output (differencematte, maskpad)
+      && gst_buffer_pool_acquire_buffer (differencematte->mask_pool, &maskbuf,
+          NULL) == GST_FLOW_OK) {
+    if (gst_video_frame_map (&mask_frame, &differencematte->mask_info,
+            maskbuf, GST_MAP_WRITE | GST_MAP_GL)) {
+      differencematte->mask_tex = *(guint *) mask_frame.data[0];
+    } else {
+      gst_buffer_unref (maskbuf);
+      maskbuf = NULL;
+    }
+  }
+
+  ret = gst_gl_filter_filter_texture (filter, inbuf, outbuf);
+
+  if (maskbuf) {
+    gst_video_frame_unmap (&mask_frame);
+    differencematte->mask_tex = 0;
+
+    gst_buffer_copy_into (maskbuf, inbuf, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+    differencematte->mask_flow = gst_pad_push (maskpad, maskbuf);
+  }
+
+  if (maskpad)
+    gst_object_unref (maskpad);
+
+  return ret;
 }
 
 static void
@@ -288,32 +738,23 @@ init_pixbuf_texture (GstGLContext * context, gpointer data)
   gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-  if (differencematte->savedbgtexture == 0) {
-    gl->GenTextures (1, &differencematte->savedbgtexture);
-    gl->BindTexture (GL_TEXTURE_2D, differencematte->savedbgtexture);
-    gl->TexImage2D (GL_TEXTURE_2D, 0, GL_RGBA8,
-        GST_VIDEO_INFO_WIDTH (&filter->out_info),
-        GST_VIDEO_INFO_HEIGHT (&filter->out_info),
-        0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  }
 }
 
 static void
-gst_gl_differencematte_diff (gint width, gint height, guint texture,
+gst_gl_differencematte_update (gint width, gint height, guint texture,
     gpointer stuff)
 {
   GstGLDifferenceMatte *differencematte = GST_GL_DIFFERENCEMATTE (stuff);
   GstGLFilter *filter = GST_GL_FILTER (stuff);
   GstGLFuncs *gl = filter->context->gl_vtable;
+  gfloat rate;
 
   gl->MatrixMode (GL_PROJECTION);
   gl->LoadIdentity ();
 
+  /* a reset seeds the model with the current frame */
+  rate = differencematte->model_reset ? 1.0 : differencematte->learning_rate;
+
   gst_gl_shader_use (differencematte->shader[0]);
 
   gl->ActiveTexture (GL_TEXTURE0);
@@ -325,16 +766,18 @@ gst_gl_differencematte_diff (gint width, gint height, guint texture,
 
   gl->ActiveTexture (GL_TEXTURE1);
   gl->Enable (GL_TEXTURE_2D);
-  gl->BindTexture (GL_TEXTURE_2D, differencematte->savedbgtexture);
+  gl->BindTexture (GL_TEXTURE_2D,
+      differencematte->model_tex[differencematte->model_index]);
   gl->Disable (GL_TEXTURE_2D);
 
-  gst_gl_shader_set_uniform_1i (differencematte->shader[0], "saved", 1);
+  gst_gl_shader_set_uniform_1i (differencematte->shader[0], "model", 1);
+  gst_gl_shader_set_uniform_1f (differencematte->shader[0], "rate", rate);
 
   gst_gl_filter_draw_texture (filter, texture, width, height);
 }
 
 static void
-gst_gl_differencematte_hblur (gint width, gint height, guint texture,
+gst_gl_differencematte_diff_hblur (gint width, gint height, guint texture,
     gpointer stuff)
 {
   GstGLDifferenceMatte *differencematte = GST_GL_DIFFERENCEMATTE (stuff);
@@ -351,17 +794,27 @@ gst_gl_differencematte_hblur (gint width, gint height, guint texture,
   gl->BindTexture (GL_TEXTURE_2D, texture);
   gl->Disable (GL_TEXTURE_2D);
 
-  gst_gl_shader_set_uniform_1i (differencematte->shader[1], "tex", 0);
+  gst_gl_shader_set_uniform_1i (differencematte->shader[1], "current", 0);
+
+  gl->ActiveTexture (GL_TEXTURE1);
+  gl->Enable (GL_TEXTURE_2D);
+  gl->BindTexture (GL_TEXTURE_2D,
+      differencematte->model_tex[differencematte->model_index]);
+  gl->Disable (GL_TEXTURE_2D);
+
+  gst_gl_shader_set_uniform_1i (differencematte->shader[1], "model", 1);
 
   gst_gl_shader_set_uniform_1fv (differencematte->shader[1], "kernel", 7,
       differencematte->kernel);
+  gst_gl_shader_set_uniform_1f (differencematte->shader[1], "threshold",
+      differencematte->threshold);
   gst_gl_shader_set_uniform_1f (differencematte->shader[1], "width", width);
 
   gst_gl_filter_draw_texture (filter, texture, width, height);
 }
 
 static void
-gst_gl_differencematte_vblur (gint width, gint height, guint texture,
+gst_gl_differencematte_vblur_interp (gint width, gint height, guint texture,
     gpointer stuff)
 {
   GstGLDifferenceMatte *differencematte = GST_GL_DIFFERENCEMATTE (stuff);
@@ -378,7 +831,21 @@ gst_gl_differencematte_vblur (gint width, gint height, guint texture,
   gl->BindTexture (GL_TEXTURE_2D, texture);
   gl->Disable (GL_TEXTURE_2D);
 
-  gst_gl_shader_set_uniform_1i (differencematte->shader[2], "tex", 0);
+  gst_gl_shader_set_uniform_1i (differencematte->shader[2], "blend", 0);
+
+  gl->ActiveTexture (GL_TEXTURE1);
+  gl->Enable (GL_TEXTURE_2D);
+  gl->BindTexture (GL_TEXTURE_2D, differencematte->newbgtexture);
+  gl->Disable (GL_TEXTURE_2D);
+
+  gst_gl_shader_set_uniform_1i (differencematte->shader[2], "base", 1);
+
+  gl->ActiveTexture (GL_TEXTURE2);
+  gl->Enable (GL_TEXTURE_2D);
+  gl->BindTexture (GL_TEXTURE_2D, differencematte->midtexture);
+  gl->Disable (GL_TEXTURE_2D);
+
+  gst_gl_shader_set_uniform_1i (differencematte->shader[2], "mask", 2);
 
   gst_gl_shader_set_uniform_1fv (differencematte->shader[2], "kernel", 7,
       differencematte->kernel);
@@ -388,7 +855,7 @@ gst_gl_differencematte_vblur (gint width, gint height, guint texture,
 }
 
 static void
-gst_gl_differencematte_interp (gint width, gint height, guint texture,
+gst_gl_differencematte_vblur_mask (gint width, gint height, guint texture,
     gpointer stuff)
 {
   GstGLDifferenceMatte *differencematte = GST_GL_DIFFERENCEMATTE (stuff);
@@ -396,7 +863,7 @@ gst_gl_differencematte_interp (gint width, gint height, guint texture,
   GstGLFuncs *gl = filter->context->gl_vtable;
 
   gl->MatrixMode (GL_PROJECTION);
-  glLoadIdentity ();
+  gl->LoadIdentity ();
 
   gst_gl_shader_use (differencematte->shader[3]);
 
@@ -405,21 +872,12 @@ gst_gl_differencematte_interp (gint width, gint height, guint texture,
   gl->BindTexture (GL_TEXTURE_2D, texture);
   gl->Disable (GL_TEXTURE_2D);
 
-  gst_gl_shader_set_uniform_1i (differencematte->shader[3], "blend", 0);
-
-  gl->ActiveTexture (GL_TEXTURE1);
-  gl->Enable (GL_TEXTURE_2D);
-  gl->BindTexture (GL_TEXTURE_2D, differencematte->newbgtexture);
-  gl->Disable (GL_TEXTURE_2D);
-
-  gst_gl_shader_set_uniform_1i (differencematte->shader[3], "base", 1);
+  gst_gl_shader_set_uniform_1i (differencematte->shader[3], "mask", 0);
 
-  gl->ActiveTexture (GL_TEXTURE2);
-  gl->Enable (GL_TEXTURE_2D);
-  gl->BindTexture (GL_TEXTURE_2D, differencematte->midtexture[2]);
-  gl->Disable (GL_TEXTURE_2D);
-
-  gst_gl_shader_set_uniform_1i (differencematte->shader[3], "alpha", 2);
+  gst_gl_shader_set_uniform_1fv (differencematte->shader[3], "kernel", 7,
+      differencematte->kernel);
+  /* the taps are spaced at the full resolution */
+  gst_gl_shader_set_uniform_1f (differencematte->shader[3], "height", height);
 
   gst_gl_filter_draw_texture (filter, texture, width, height);
 }
@@ -438,14 +896,33 @@ gst_gl_differencematte_identity (gint width, gint height, guint texture,
   gst_gl_filter_draw_texture (filter, texture, width, height);
 }
 
+static void
+gst_gl_differencematte_update_model (GstGLDifferenceMatte * differencematte,
+    guint in_tex)
+{
+  GstGLFilter *filter = GST_GL_FILTER (differencematte);
+  guint next = 1 - differencematte->model_index;
+
+  gst_gl_filter_render_to_target (filter, TRUE, in_tex,
+      differencematte->model_tex[next], gst_gl_differencematte_update,
+      differencematte);
+
+  differencematte->model_index = next;
+  differencematte->model_reset = FALSE;
+}
+
 static gboolean
 gst_gl_differencematte_filter_texture (GstGLFilter * filter, guint in_tex,
     guint out_tex)
 {
   GstGLDifferenceMatte *differencematte = GST_GL_DIFFERENCEMATTE (filter);
+  gboolean running_average;
 
   differencematte->intexture = in_tex;
 
+  running_average =
+      differencematte->model == GST_GL_DIFFERENCEMATTE_MODEL_RUNNING_AVERAGE;
+
   if (differencematte->bg_has_changed && (differencematte->location != NULL)) {
 
     if (!gst_gl_differencematte_loader (filter))
@@ -457,9 +934,7 @@ gst_gl_differencematte_filter_texture (GstGLFilter * filter, guint in_tex,
 
     /* save current frame, needed to calculate difference between
      * this frame and next ones */
-    gst_gl_filter_render_to_target (filter, TRUE, in_tex,
-        differencematte->savedbgtexture,
-        gst_gl_differencematte_save_texture, differencematte);
+    differencematte->model_reset = TRUE;
 
     if (differencematte->pixbuf) {
       free (differencematte->pixbuf);
@@ -469,23 +944,43 @@ gst_gl_differencematte_filter_texture (GstGLFilter * filter, guint in_tex,
     differencematte->bg_has_changed = FALSE;
   }
 
-  if (differencematte->savedbgtexture != 0) {
+  /* the static model is only seeded, once there is something to compare */
+  if (differencematte->model_reset && (running_average
+          || differencematte->newbgtexture != 0
+          || differencematte->mask_tex != 0))
+    gst_gl_differencematte_update_model (differencematte, in_tex);
+
+  if (differencematte->newbgtexture != 0 || differencematte->mask_tex != 0) {
     gst_gl_filter_render_to_target (filter, TRUE, in_tex,
-        differencematte->midtexture[0], gst_gl_differencematte_diff,
+        differencematte->midtexture, gst_gl_differencematte_diff_hblur,
         differencematte);
-    gst_gl_filter_render_to_target (filter, FALSE,
-        differencematte->midtexture[0], differencematte->midtexture[1],
-        gst_gl_differencematte_hblur, differencematte);
-    gst_gl_filter_render_to_target (filter, FALSE,
-        differencematte->midtexture[1], differencematte->midtexture[2],
-        gst_gl_differencematte_vblur, differencematte);
+  }
+
+  if (differencematte->mask_tex != 0) {
+    gst_gl_context_use_fbo (filter->context,
+        GST_VIDEO_INFO_WIDTH (&differencematte->mask_info),
+        GST_VIDEO_INFO_HEIGHT (&differencematte->mask_info),
+        differencematte->mask_fbo, differencematte->mask_depthbuffer,
+        differencematte->mask_tex, gst_gl_differencematte_vblur_mask,
+        GST_VIDEO_INFO_WIDTH (&filter->out_info),
+        GST_VIDEO_INFO_HEIGHT (&filter->out_info), differencematte->midtexture,
+        0, GST_VIDEO_INFO_WIDTH (&filter->out_info), 0,
+        GST_VIDEO_INFO_HEIGHT (&filter->out_info),
+        GST_GL_DISPLAY_PROJECTION_ORTHO2D, differencematte);
+  }
+
+  if (differencematte->newbgtexture != 0) {
     gst_gl_filter_render_to_target (filter, TRUE, in_tex, out_tex,
-        gst_gl_differencematte_interp, differencematte);
+        gst_gl_differencematte_vblur_interp, differencematte);
   } else {
     gst_gl_filter_render_to_target (filter, TRUE, in_tex, out_tex,
         gst_gl_differencematte_identity, differencematte);
   }
 
+  /* the frame is compared against the background before it joins it */
+  if (running_average)
+    gst_gl_differencematte_update_model (differencematte, in_tex);
+
   return TRUE;
 }
 
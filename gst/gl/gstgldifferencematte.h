@@ -33,6 +33,21 @@
 typedef struct _GstGLDifferenceMatte GstGLDifferenceMatte;
 typedef struct _GstGLDifferenceMatteClass GstGLDifferenceMatteClass;
 
+/**
+ * GstGLDifferenceMatteModel:
+ * @GST_GL_DIFFERENCEMATTE_MODEL_STATIC: the frame seen when the background
+ *     image is set, as before
+ * @GST_GL_DIFFERENCEMATTE_MODEL_RUNNING_AVERAGE: an exponential running
+ *     average of all frames, updated every frame
+ *
+ * How the background that frames are compared against is built.
+ */
+typedef enum
+{
+  GST_GL_DIFFERENCEMATTE_MODEL_STATIC,
+  GST_GL_DIFFERENCEMATTE_MODEL_RUNNING_AVERAGE
+} GstGLDifferenceMatteModel;
+
 struct _GstGLDifferenceMatte
 {
   GstGLFilter filter;
@@ -42,13 +57,31 @@ struct _GstGLDifferenceMatte
   gchar *location;
   gboolean bg_has_changed;
 
+  GstGLDifferenceMatteModel model;
+  gdouble learning_rate;
+  gdouble threshold;
+  guint mask_scale;
+
   guchar *pixbuf;
   gint pbuf_width, pbuf_height;
-  GLuint savedbgtexture;
   GLuint newbgtexture;
-  GLuint midtexture[4];
+  GLuint midtexture;
   GLuint intexture;
   float kernel[7];
+
+  /* background model, read from one and updated into the other */
+  GLuint model_tex[2];
+  guint model_index;
+  gboolean model_reset;
+
+  /* low resolution mask output */
+  GstPad *maskpad;
+  GstVideoInfo mask_info;
+  GstBufferPool *mask_pool;
+  GLuint mask_fbo;
+  GLuint mask_depthbuffer;
+  GLuint mask_tex;
+  GstFlowReturn mask_flow;
 };
 
 struct _GstGLDifferenceMatteClass
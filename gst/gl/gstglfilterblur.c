@@ -21,13 +21,22 @@
 /**
  * SECTION:element-glfilterblur
  *
- * Blur with 9x9 separable convolution.
+ * Blur with a separable gaussian convolution, or any other convolution
+ * kernel given with the #GstGLFilterBlur:kernel property.
+ *
+ * Separable kernels are applied in a horizontal and a vertical pass and
+ * adjacent texels of the same sign are read with a single linearly
+ * filtered fetch, so that a blur of radius r costs about r + 1 fetches
+ * per pass.
  *
  * <refsect2>
  * <title>Examples</title>
  * |[
- * gst-launch videotestsrc ! glupload ! glfilterblur ! glimagesink
+ * gst-launch videotestsrc ! glupload ! glfilterblur radius=8 sigma=4 ! glimagesink
  * ]|
+ * |[
+ * gst-launch videotestsrc ! glupload ! glfilterblur kernel="1,2,1;2,4,2;1,2,1" ! glimagesink
+ * ]| A 3x3 binomial blur, the kernel is normalized.
  * FBO (Frame Buffer Object) and GLSL (OpenGL Shading Language) are required.
  * </refsect2>
  */
@@ -48,6 +57,18 @@ GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 G_DEFINE_TYPE_WITH_CODE (GstGLFilterBlur, gst_gl_filterblur,
     GST_TYPE_GL_FILTER, DEBUG_INIT);
 
+#define DEFAULT_RADIUS 3
+#define DEFAULT_SIGMA 3.0
+
+enum
+{
+  PROP_0,
+  PROP_RADIUS,
+  PROP_SIGMA,
+  PROP_KERNEL
+};
+
+static void gst_gl_filterblur_finalize (GObject * object);
 static void gst_gl_filterblur_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_gl_filterblur_get_property (GObject * object, guint prop_id,
@@ -57,38 +78,6 @@ static void gst_gl_filter_filterblur_reset (GstGLFilter * filter);
 static gboolean gst_gl_filterblur_init_shader (GstGLFilter * filter);
 static gboolean gst_gl_filterblur_filter_texture (GstGLFilter * filter,
     guint in_tex, guint out_tex);
-static void gst_gl_filterblur_hcallback (gint width, gint height, guint texture,
-    gpointer stuff);
-static void gst_gl_filterblur_vcallback (gint width, gint height, guint texture,
-    gpointer stuff);
-
-
-static void
-gst_gl_filterblur_init_resources (GstGLFilter * filter)
-{
-  GstGLFilterBlur *filterblur = GST_GL_FILTERBLUR (filter);
-  GstGLFuncs *gl = filter->context->gl_vtable;
-
-  gl->GenTextures (1, &filterblur->midtexture);
-  gl->BindTexture (GL_TEXTURE_2D, filterblur->midtexture);
-  gl->TexImage2D (GL_TEXTURE_2D, 0, GL_RGBA8,
-      GST_VIDEO_INFO_WIDTH (&filter->out_info),
-      GST_VIDEO_INFO_HEIGHT (&filter->out_info),
-      0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-}
-
-static void
-gst_gl_filterblur_reset_resources (GstGLFilter * filter)
-{
-  GstGLFilterBlur *filterblur = GST_GL_FILTERBLUR (filter);
-  GstGLFuncs *gl = filter->context->gl_vtable;
-
-  gl->DeleteTextures (1, &filterblur->midtexture);
-}
 
 static void
 gst_gl_filterblur_class_init (GstGLFilterBlurClass * klass)
@@ -99,19 +88,41 @@ gst_gl_filterblur_class_init (GstGLFilterBlurClass * klass)
   gobject_class = (GObjectClass *) klass;
   element_class = GST_ELEMENT_CLASS (klass);
 
+  gobject_class->finalize = gst_gl_filterblur_finalize;
   gobject_class->set_property = gst_gl_filterblur_set_property;
   gobject_class->get_property = gst_gl_filterblur_get_property;
 
   gst_element_class_set_metadata (element_class, "Gstreamer OpenGL Blur",
-      "Filter/Effect/Video", "Blur with 9x9 separable convolution",
+      "Filter/Effect/Video", "Blur with a separable gaussian convolution",
       "Filippo Argiolas <filippo.argiolas@gmail.com>");
 
+  g_object_class_install_property (gobject_class,
+      PROP_RADIUS,
+      g_param_spec_uint ("radius",
+          "Radius",
+          "Radius in pixels of the gaussian kernel",
+          1, GST_GL_CONVOLUTION_MAX_SIZE / 2, DEFAULT_RADIUS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_SIGMA,
+      g_param_spec_double ("sigma",
+          "Sigma",
+          "Standard deviation in pixels of the gaussian kernel",
+          0.1, 100.0, DEFAULT_SIGMA,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_KERNEL,
+      g_param_spec_string ("kernel",
+          "Kernel",
+          "Convolution kernel used instead of the gaussian, rows of comma "
+          "separated weights separated by ';', normalized to a sum of 1. "
+          "A single row is applied horizontally and vertically", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   GST_GL_FILTER_CLASS (klass)->filter_texture =
       gst_gl_filterblur_filter_texture;
-  GST_GL_FILTER_CLASS (klass)->display_init_cb =
-      gst_gl_filterblur_init_resources;
-  GST_GL_FILTER_CLASS (klass)->display_reset_cb =
-      gst_gl_filterblur_reset_resources;
   GST_GL_FILTER_CLASS (klass)->onInitFBO = gst_gl_filterblur_init_shader;
   GST_GL_FILTER_CLASS (klass)->onReset = gst_gl_filter_filterblur_reset;
 }
@@ -119,13 +130,23 @@ gst_gl_filterblur_class_init (GstGLFilterBlurClass * klass)
 static void
 gst_gl_filterblur_init (GstGLFilterBlur * filterblur)
 {
-  filterblur->shader0 = NULL;
-  filterblur->shader1 = NULL;
-  filterblur->midtexture = 0;
-  /* gaussian kernel (well, actually vector), size 9, standard
-   * deviation 3.0 */
-  /* FIXME: eventually make this a runtime property */
-  fill_gaussian_kernel (filterblur->gauss_kernel, 7, 3.0);
+  filterblur->radius = DEFAULT_RADIUS;
+  filterblur->sigma = DEFAULT_SIGMA;
+  filterblur->kernel = NULL;
+  filterblur->kernel_changed = FALSE;
+  filterblur->convolution =
+      gst_gl_convolution_new (GST_GL_FILTER (filterblur));
+}
+
+static void
+gst_gl_filterblur_finalize (GObject * object)
+{
+  GstGLFilterBlur *filterblur = GST_GL_FILTERBLUR (object);
+
+  gst_gl_convolution_free (filterblur->convolution);
+  g_free (filterblur->kernel);
+
+  G_OBJECT_CLASS (gst_gl_filterblur_parent_class)->finalize (object);
 }
 
 static void
@@ -133,125 +154,132 @@ gst_gl_filter_filterblur_reset (GstGLFilter * filter)
 {
   GstGLFilterBlur *filterblur = GST_GL_FILTERBLUR (filter);
 
-  //blocking call, wait the opengl thread has destroyed the shader
-  if (filterblur->shader0)
-    gst_gl_context_del_shader (filter->context, filterblur->shader0);
-  filterblur->shader0 = NULL;
-
-  //blocking call, wait the opengl thread has destroyed the shader
-  if (filterblur->shader1)
-    gst_gl_context_del_shader (filter->context, filterblur->shader1);
-  filterblur->shader1 = NULL;
+  gst_gl_convolution_reset_gl (filterblur->convolution);
 }
 
 static void
 gst_gl_filterblur_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
-  /* GstGLFilterBlur *filterblur = GST_GL_FILTERBLUR (object); */
+  GstGLFilterBlur *filterblur = GST_GL_FILTERBLUR (object);
 
+  GST_OBJECT_LOCK (filterblur);
   switch (prop_id) {
+    case PROP_RADIUS:
+      filterblur->radius = g_value_get_uint (value);
+      filterblur->kernel_changed = TRUE;
+      break;
+    case PROP_SIGMA:
+      filterblur->sigma = g_value_get_double (value);
+      filterblur->kernel_changed = TRUE;
+      break;
+    case PROP_KERNEL:
+      g_free (filterblur->kernel);
+      filterblur->kernel = g_value_dup_string (value);
+      filterblur->kernel_changed = TRUE;
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
+  GST_OBJECT_UNLOCK (filterblur);
 }
 
 static void
 gst_gl_filterblur_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
-  /* GstGLFilterBlur *filterblur = GST_GL_FILTERBLUR (object); */
+  GstGLFilterBlur *filterblur = GST_GL_FILTERBLUR (object);
 
+  GST_OBJECT_LOCK (filterblur);
   switch (prop_id) {
+    case PROP_RADIUS:
+      g_value_set_uint (value, filterblur->radius);
+      break;
+    case PROP_SIGMA:
+      g_value_set_double (value, filterblur->sigma);
+      break;
+    case PROP_KERNEL:
+      g_value_set_string (value, filterblur->kernel);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
+  GST_OBJECT_UNLOCK (filterblur);
 }
 
-static gboolean
-gst_gl_filterblur_init_shader (GstGLFilter * filter)
+static void
+gst_gl_filterblur_update_kernel (GstGLFilterBlur * filterblur)
 {
-  GstGLFilterBlur *blur_filter = GST_GL_FILTERBLUR (filter);
+  gfloat *kernel = NULL;
+  guint width = 0, height = 0;
+
+  GST_OBJECT_LOCK (filterblur);
+  if (filterblur->kernel) {
+    if (gst_gl_convolution_parse_kernel (filterblur->kernel, &kernel, &width,
+            &height)) {
+      gfloat sum = 0.0;
+      guint i;
+
+      for (i = 0; i < width * height; i++)
+        sum += kernel[i];
+      if (sum != 0.0)
+        for (i = 0; i < width * height; i++)
+          kernel[i] /= sum;
+    } else {
+      GST_WARNING_OBJECT (filterblur, "invalid kernel \"%s\", the rows must "
+          "have the same odd number of weights", filterblur->kernel);
+    }
+  }
 
-  //blocking call, wait the opengl thread has compiled the shader
-  if (!gst_gl_context_gen_shader (filter->context, 0, hconv7_fragment_source,
-          &blur_filter->shader0))
-    return FALSE;
+  if (!kernel) {
+    guint size = 2 * filterblur->radius + 1;
+    gfloat *gauss = g_new (gfloat, size);
+    guint i, j;
 
-  //blocking call, wait the opengl thread has compiled the shader
-  if (!gst_gl_context_gen_shader (filter->context, 0, vconv7_fragment_source,
-          &blur_filter->shader1))
-    return FALSE;
+    fill_gaussian_kernel (gauss, size, filterblur->sigma);
 
-  return TRUE;
-}
+    kernel = g_new (gfloat, size * size);
+    for (i = 0; i < size; i++)
+      for (j = 0; j < size; j++)
+        kernel[i * size + j] = gauss[i] * gauss[j];
+    width = height = size;
 
-static gboolean
-gst_gl_filterblur_filter_texture (GstGLFilter * filter, guint in_tex,
-    guint out_tex)
-{
-  GstGLFilterBlur *filterblur = GST_GL_FILTERBLUR (filter);
-
-  gst_gl_filter_render_to_target (filter, TRUE, in_tex,
-      filterblur->midtexture, gst_gl_filterblur_hcallback, filterblur);
-
-  gst_gl_filter_render_to_target (filter, FALSE, filterblur->midtexture,
-      out_tex, gst_gl_filterblur_vcallback, filterblur);
+    g_free (gauss);
+  }
+  filterblur->kernel_changed = FALSE;
+  GST_OBJECT_UNLOCK (filterblur);
 
-  return TRUE;
+  gst_gl_convolution_set_kernel (filterblur->convolution, kernel, width,
+      height);
+  g_free (kernel);
 }
 
-static void
-gst_gl_filterblur_hcallback (gint width, gint height, guint texture,
-    gpointer stuff)
+static gboolean
+gst_gl_filterblur_init_shader (GstGLFilter * filter)
 {
-  GstGLFilter *filter = GST_GL_FILTER (stuff);
   GstGLFilterBlur *filterblur = GST_GL_FILTERBLUR (filter);
-  GstGLFuncs *gl = filter->context->gl_vtable;
-
-  gl->MatrixMode (GL_PROJECTION);
-  gl->LoadIdentity ();
 
-  gst_gl_shader_use (filterblur->shader0);
+  gst_gl_convolution_reset_gl (filterblur->convolution);
+  gst_gl_filterblur_update_kernel (filterblur);
 
-  gl->ActiveTexture (GL_TEXTURE1);
-  gl->Enable (GL_TEXTURE_2D);
-  gl->BindTexture (GL_TEXTURE_2D, texture);
-  gl->Disable (GL_TEXTURE_2D);
-
-  gst_gl_shader_set_uniform_1i (filterblur->shader0, "tex", 1);
-  gst_gl_shader_set_uniform_1fv (filterblur->shader0, "kernel", 7,
-      filterblur->gauss_kernel);
-  gst_gl_shader_set_uniform_1f (filterblur->shader0, "width", width);
-
-  gst_gl_filter_draw_texture (filter, texture, width, height);
+  return gst_gl_convolution_init_gl (filterblur->convolution);
 }
 
-
-static void
-gst_gl_filterblur_vcallback (gint width, gint height, guint texture,
-    gpointer stuff)
+static gboolean
+gst_gl_filterblur_filter_texture (GstGLFilter * filter, guint in_tex,
+    guint out_tex)
 {
-  GstGLFilter *filter = GST_GL_FILTER (stuff);
   GstGLFilterBlur *filterblur = GST_GL_FILTERBLUR (filter);
-  GstGLFuncs *gl = filter->context->gl_vtable;
-
-  gl->MatrixMode (GL_PROJECTION);
-  gl->LoadIdentity ();
 
-  gst_gl_shader_use (filterblur->shader1);
-
-  gl->ActiveTexture (GL_TEXTURE1);
-  gl->Enable (GL_TEXTURE_2D);
-  gl->BindTexture (GL_TEXTURE_2D, texture);
-  gl->Disable (GL_TEXTURE_2D);
+  if (filterblur->kernel_changed) {
+    if (!gst_gl_filterblur_init_shader (filter))
+      return FALSE;
+  }
 
-  gst_gl_shader_set_uniform_1i (filterblur->shader1, "tex", 1);
-  gst_gl_shader_set_uniform_1fv (filterblur->shader1, "kernel", 7,
-      filterblur->gauss_kernel);
-  gst_gl_shader_set_uniform_1f (filterblur->shader1, "height", height);
+  gst_gl_convolution_render (filterblur->convolution, TRUE, in_tex,
+      out_tex);
 
-  gst_gl_filter_draw_texture (filter, texture, width, height);
+  return TRUE;
 }
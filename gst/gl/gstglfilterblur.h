@@ -23,6 +23,8 @@
 
 #include <gst/gl/gstglfilter.h>
 
+#include "gstglconvolution.h"
+
 #define GST_TYPE_GL_FILTERBLUR            (gst_gl_filterblur_get_type())
 #define GST_GL_FILTERBLUR(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_FILTERBLUR,GstGLFilterBlur))
 #define GST_IS_GL_FILTERBLUR(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_FILTERBLUR))
@@ -36,11 +38,14 @@ typedef struct _GstGLFilterBlurClass GstGLFilterBlurClass;
 struct _GstGLFilterBlur
 {
   GstGLFilter filter;
-  GstGLShader *shader0;
-  GstGLShader *shader1;
 
-  GLuint midtexture;
-  float gauss_kernel[7];
+  /* properties, with OBJECT_LOCK */
+  guint radius;
+  gdouble sigma;
+  gchar *kernel;
+  gboolean kernel_changed;
+
+  GstGLConvolution *convolution;
 };
 
 struct _GstGLFilterBlurClass
@@ -38,12 +38,19 @@
  * ]| Resize scene before drawing the cube.
  * The scene size is greater than the input video size.
  * </refsect2>
+ *
+ * The cube turns at a rate given by the running time of the input buffers,
+ * scaled by #GstGLFilterCube:speed.  When the cube is still and the input
+ * buffer carries the same memory as the previous one, the previous output is
+ * pushed again instead of drawing the scene.
  */
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
+#include <math.h>
+
 #include <gst/gl/gstglapi.h>
 #include "gstglfiltercube.h"
 
@@ -59,9 +66,17 @@ enum
   PROP_FOVY,
   PROP_ASPECT,
   PROP_ZNEAR,
-  PROP_ZFAR
+  PROP_ZFAR,
+  PROP_SPEED
 };
 
+#define DEFAULT_SPEED 1.0
+
+/* degrees per second at a speed of 1.0 */
+#define XROT_RATE 9.0
+#define YROT_RATE 6.0
+#define ZROT_RATE 12.0
+
 #define DEBUG_INIT \
     GST_DEBUG_CATEGORY_INIT (gst_gl_filter_cube_debug, "glfiltercube", 0, "glfiltercube element");
 
@@ -75,8 +90,12 @@ static void gst_gl_filter_cube_get_property (GObject * object, guint prop_id,
 
 static gboolean gst_gl_filter_cube_set_caps (GstGLFilter * filter,
     GstCaps * incaps, GstCaps * outcaps);
-#if GST_GL_HAVE_GLES2
 static void gst_gl_filter_cube_reset (GstGLFilter * filter);
+static GstFlowReturn gst_gl_filter_cube_prepare_output_buffer (GstBaseTransform
+    * bt, GstBuffer * inbuf, GstBuffer ** outbuf);
+static GstFlowReturn gst_gl_filter_cube_transform (GstBaseTransform * bt,
+    GstBuffer * inbuf, GstBuffer * outbuf);
+#if GST_GL_HAVE_GLES2
 static gboolean gst_gl_filter_cube_init_shader (GstGLFilter * filter);
 static void _callback_gles2 (gint width, gint height, guint texture,
     gpointer stuff);
@@ -146,8 +165,11 @@ gst_gl_filter_cube_class_init (GstGLFilterCubeClass * klass)
 
 #if GST_GL_HAVE_GLES2
   GST_GL_FILTER_CLASS (klass)->onInitFBO = gst_gl_filter_cube_init_shader;
-  GST_GL_FILTER_CLASS (klass)->onReset = gst_gl_filter_cube_reset;
 #endif
+  GST_GL_FILTER_CLASS (klass)->onReset = gst_gl_filter_cube_reset;
+  GST_BASE_TRANSFORM_CLASS (klass)->prepare_output_buffer =
+      gst_gl_filter_cube_prepare_output_buffer;
+  GST_BASE_TRANSFORM_CLASS (klass)->transform = gst_gl_filter_cube_transform;
   GST_GL_FILTER_CLASS (klass)->set_caps = gst_gl_filter_cube_set_caps;
   GST_GL_FILTER_CLASS (klass)->filter_texture =
       gst_gl_filter_cube_filter_texture;
@@ -183,6 +205,11 @@ gst_gl_filter_cube_class_init (GstGLFilterCubeClass * klass)
           "Specifies the distance from the viewer to the far clipping plane",
           0.0, 1000.0, 100.0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_SPEED,
+      g_param_spec_double ("speed", "Speed",
+          "Rotation speed of the cube, 0 keeps it still", 0.0, 100.0,
+          DEFAULT_SPEED, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_metadata (element_class, "OpenGL cube filter",
       "Filter/Effect/Video", "Map input texture on the 6 cube faces",
       "Julien Isorce <julien.isorce@gmail.com>");
@@ -196,6 +223,9 @@ gst_gl_filter_cube_init (GstGLFilterCube * filter)
   filter->aspect = 0;
   filter->znear = 0.1;
   filter->zfar = 100;
+  filter->speed = DEFAULT_SPEED;
+  filter->last_running_time = GST_CLOCK_TIME_NONE;
+  filter->redraw = TRUE;
 }
 
 static void
@@ -226,10 +256,15 @@ gst_gl_filter_cube_set_property (GObject * object, guint prop_id,
     case PROP_ZFAR:
       filter->zfar = g_value_get_double (value);
       break;
+    case PROP_SPEED:
+      filter->speed = g_value_get_double (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-      break;
+      return;
   }
+
+  filter->redraw = TRUE;
 }
 
 static void
@@ -260,6 +295,9 @@ gst_gl_filter_cube_get_property (GObject * object, guint prop_id,
     case PROP_ZFAR:
       g_value_set_double (value, filter->zfar);
       break;
+    case PROP_SPEED:
+      g_value_set_double (value, filter->speed);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -276,21 +314,142 @@ gst_gl_filter_cube_set_caps (GstGLFilter * filter, GstCaps * incaps,
     cube_filter->aspect = (gdouble) GST_VIDEO_INFO_WIDTH (&filter->out_info) /
         (gdouble) GST_VIDEO_INFO_HEIGHT (&filter->out_info);
 
+  /* the previous output has another size */
+  gst_buffer_replace (&cube_filter->last_inbuf, NULL);
+  gst_buffer_replace (&cube_filter->last_outbuf, NULL);
+  cube_filter->redraw = TRUE;
+
   return TRUE;
 }
 
-#if GST_GL_HAVE_GLES2
 static void
 gst_gl_filter_cube_reset (GstGLFilter * filter)
 {
   GstGLFilterCube *cube_filter = GST_GL_FILTER_CUBE (filter);
 
+  gst_buffer_replace (&cube_filter->last_inbuf, NULL);
+  gst_buffer_replace (&cube_filter->last_outbuf, NULL);
+  cube_filter->last_running_time = GST_CLOCK_TIME_NONE;
+  cube_filter->redraw = TRUE;
+
+#if GST_GL_HAVE_GLES2
   /* blocking call, wait the opengl thread has destroyed the shader */
   if (cube_filter->shader)
     gst_gl_context_del_shader (filter->context, cube_filter->shader);
   cube_filter->shader = NULL;
+#endif
+}
+
+/* advances the rotation to @running_time, returns whether it moved */
+static gboolean
+_update_rotation (GstGLFilterCube * cube_filter, GstClockTime running_time)
+{
+  gdouble elapsed;
+
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return FALSE;
+
+  if (!GST_CLOCK_TIME_IS_VALID (cube_filter->last_running_time)
+      || running_time < cube_filter->last_running_time) {
+    cube_filter->last_running_time = running_time;
+    return FALSE;
+  }
+
+  elapsed = cube_filter->speed * (gdouble) (running_time -
+      cube_filter->last_running_time) / (gdouble) GST_SECOND;
+  cube_filter->last_running_time = running_time;
+
+  if (elapsed == 0.0)
+    return FALSE;
+
+  cube_filter->xrot = fmod (cube_filter->xrot + XROT_RATE * elapsed, 360.0);
+  cube_filter->yrot = fmod (cube_filter->yrot + YROT_RATE * elapsed, 360.0);
+  cube_filter->zrot = fmod (cube_filter->zrot + ZROT_RATE * elapsed, 360.0);
+
+  return TRUE;
+}
+
+/* the memory the frame of @buffer lives in, looking through the memories
+ * shared from it when the buffer was copied, like videorate does to
+ * repeat a frame */
+static GstMemory *
+_get_frame_memory (GstBuffer * buffer)
+{
+  GstMemory *mem;
+
+  if (!buffer || gst_buffer_n_memory (buffer) == 0)
+    return NULL;
+
+  mem = gst_buffer_peek_memory (buffer, 0);
+  while (mem->parent)
+    mem = mem->parent;
+
+  return mem;
+}
+
+static GstFlowReturn
+gst_gl_filter_cube_prepare_output_buffer (GstBaseTransform * bt,
+    GstBuffer * inbuf, GstBuffer ** outbuf)
+{
+  GstGLFilterCube *cube_filter = GST_GL_FILTER_CUBE (bt);
+  GstClockTime running_time;
+  gboolean changed;
+
+  running_time = gst_segment_to_running_time (&bt->segment, GST_FORMAT_TIME,
+      GST_BUFFER_TIMESTAMP (inbuf));
+
+  changed = _update_rotation (cube_filter, running_time);
+  changed |= cube_filter->redraw;
+  changed |= !_get_frame_memory (inbuf)
+      || _get_frame_memory (inbuf) !=
+      _get_frame_memory (cube_filter->last_inbuf);
+
+  if (!changed && cube_filter->last_outbuf) {
+    GST_LOG_OBJECT (cube_filter, "scene unchanged, reusing the last output");
+
+    /* GstGLMemory is shared by gst_buffer_copy(), so the copy only
+     * references the texture of the last output.  The pool does not hand
+     * that buffer out again while the copy is alive. */
+    *outbuf = gst_buffer_copy (cube_filter->last_outbuf);
+    gst_buffer_copy_into (*outbuf, inbuf, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+    cube_filter->reuse = TRUE;
+
+    return GST_FLOW_OK;
+  }
+
+  cube_filter->reuse = FALSE;
+  cube_filter->redraw = FALSE;
+  /* keeps the memory from being recycled while it is compared against */
+  gst_buffer_replace (&cube_filter->last_inbuf, inbuf);
+
+  return
+      GST_BASE_TRANSFORM_CLASS (gst_gl_filter_cube_parent_class)->
+      prepare_output_buffer (bt, inbuf, outbuf);
 }
 
+static GstFlowReturn
+gst_gl_filter_cube_transform (GstBaseTransform * bt, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  GstGLFilterCube *cube_filter = GST_GL_FILTER_CUBE (bt);
+  GstFlowReturn ret;
+
+  if (cube_filter->reuse)
+    return GST_FLOW_OK;
+
+  ret = GST_BASE_TRANSFORM_CLASS (gst_gl_filter_cube_parent_class)->transform
+      (bt, inbuf, outbuf);
+
+  if (ret == GST_FLOW_OK)
+    gst_buffer_replace (&cube_filter->last_outbuf, outbuf);
+  else
+    gst_buffer_replace (&cube_filter->last_outbuf, NULL);
+
+  return ret;
+}
+
+#if GST_GL_HAVE_GLES2
+
 static gboolean
 gst_gl_filter_cube_init_shader (GstGLFilter * filter)
 {
@@ -348,61 +507,6 @@ _callback_opengl (gint width, gint height, guint texture, gpointer stuff)
   GstGLFilter *filter = GST_GL_FILTER (stuff);
   GstGLFuncs *gl = filter->context->gl_vtable;
 
-  static GLfloat xrot = 0;
-  static GLfloat yrot = 0;
-  static GLfloat zrot = 0;
-
-/* *INDENT-OFF* */
-  const GLfloat v_vertices[] = {
- /*|     Vertex     | TexCoord |*/ 
-    /* front face */
-     1.0,  1.0, -1.0, 0.0, 0.0,
-     1.0, -1.0, -1.0, 1.0, 0.0,
-    -1.0, -1.0, -1.0, 1.0, 1.0,
-    -1.0,  1.0, -1.0, 0.0, 1.0,
-    /* back face */
-    -1.0,  1.0,  1.0, 0.0, 0.0,
-    -1.0, -1.0,  1.0, 1.0, 0.0,
-     1.0, -1.0,  1.0, 1.0, 1.0,
-     1.0,  1.0,  1.0, 0.0, 1.0,
-    /* right face */
-    -1.0,  1.0, -1.0, 0.0, 0.0,
-    -1.0, -1.0, -1.0, 1.0, 0.0,
-    -1.0, -1.0,  1.0, 1.0, 1.0,
-    -1.0,  1.0,  1.0, 0.0, 1.0,
-    /* left face */
-     1.0,  1.0,  1.0, 0.0, 0.0,
-     1.0, -1.0,  1.0, 1.0, 0.0,
-     1.0, -1.0, -1.0, 1.0, 1.0,
-     1.0,  1.0, -1.0, 0.0, 1.0,
-    /* top face */
-     1.0,  1.0,  1.0, 0.0, 0.0,
-     1.0,  1.0, -1.0, 1.0, 0.0,
-    -1.0,  1.0, -1.0, 1.0, 1.0,
-    -1.0,  1.0,  1.0, 0.0, 1.0,
-    /* bottom face */
-     1.0, -1.0,  1.0, 0.0, 0.0,
-     1.0, -1.0, -1.0, 1.0, 0.0,
-    -1.0, -1.0, -1.0, 1.0, 1.0,
-    -1.0, -1.0,  1.0, 0.0, 1.0,
-  };
-/* *INDENT-ON* */
-
-  GLushort indices[] = {
-    0, 1, 2,
-    0, 2, 3,
-    4, 5, 6,
-    4, 6, 7,
-    8, 9, 10,
-    8, 10, 11,
-    12, 13, 14,
-    12, 14, 15,
-    16, 17, 18,
-    16, 18, 19,
-    20, 21, 22,
-    20, 22, 23
-  };
-
   gl->Enable (GL_DEPTH_TEST);
 
   gl->Enable (GL_TEXTURE_2D);
@@ -418,27 +522,15 @@ _callback_opengl (gint width, gint height, guint texture, gpointer stuff)
 
 //  gl->Translatef (0.0f, 0.0f, -5.0f);
 
-  gl->Rotatef (xrot, 1.0f, 0.0f, 0.0f);
-  gl->Rotatef (yrot, 0.0f, 1.0f, 0.0f);
-  gl->Rotatef (zrot, 0.0f, 0.0f, 1.0f);
+  gl->Rotatef (cube_filter->xrot, 1.0f, 0.0f, 0.0f);
+  gl->Rotatef (cube_filter->yrot, 0.0f, 1.0f, 0.0f);
+  gl->Rotatef (cube_filter->zrot, 0.0f, 0.0f, 1.0f);
 
-  gl->ClientActiveTexture (GL_TEXTURE0);
-  gl->EnableClientState (GL_TEXTURE_COORD_ARRAY);
-  gl->EnableClientState (GL_VERTEX_ARRAY);
-
-  gl->VertexPointer (3, GL_FLOAT, 5 * sizeof (float), v_vertices);
-  gl->TexCoordPointer (2, GL_FLOAT, 5 * sizeof (float), &v_vertices[3]);
-
-  gl->DrawElements (GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, indices);
-
-  gl->DisableClientState (GL_TEXTURE_COORD_ARRAY);
-  gl->DisableClientState (GL_VERTEX_ARRAY);
+  gst_gl_context_bind_geometry (filter->context, GST_GL_GEOMETRY_CUBE, -1, -1);
+  gst_gl_context_draw_geometry (filter->context, 0, 6);
+  gst_gl_context_unbind_geometry (filter->context);
 
   gl->Disable (GL_DEPTH_TEST);
-
-  xrot += 0.3f;
-  yrot += 0.2f;
-  zrot += 0.4f;
 }
 #endif
 
@@ -450,61 +542,6 @@ _callback_gles2 (gint width, gint height, guint texture, gpointer stuff)
   GstGLFilterCube *cube_filter = GST_GL_FILTER_CUBE (filter);
   GstGLFuncs *gl = filter->context->gl_vtable;
 
-  static GLfloat xrot = 0;
-  static GLfloat yrot = 0;
-  static GLfloat zrot = 0;
-
-/* *INDENT-OFF* */
-  const GLfloat v_vertices[] = {
- /*|     Vertex     | TexCoord |*/ 
-    /* front face */
-     1.0,  1.0, -1.0, 1.0, 0.0,
-     1.0, -1.0, -1.0, 1.0, 1.0,
-    -1.0, -1.0, -1.0, 0.0, 1.0,
-    -1.0,  1.0, -1.0, 0.0, 0.0,
-    /* back face */
-     1.0,  1.0,  1.0, 1.0, 0.0,
-    -1.0,  1.0,  1.0, 0.0, 0.0,
-    -1.0, -1.0,  1.0, 0.0, 1.0,
-     1.0, -1.0,  1.0, 1.0, 1.0,
-    /* right face */
-     1.0,  1.0,  1.0, 1.0, 0.0,
-     1.0, -1.0,  1.0, 0.0, 0.0,
-     1.0, -1.0, -1.0, 0.0, 1.0,
-     1.0,  1.0, -1.0, 1.0, 1.0,
-    /* left face */
-    -1.0,  1.0,  1.0, 1.0, 0.0,
-    -1.0,  1.0, -1.0, 1.0, 1.0,
-    -1.0, -1.0, -1.0, 0.0, 1.0,
-    -1.0, -1.0,  1.0, 0.0, 0.0,
-    /* top face */
-     1.0, -1.0,  1.0, 1.0, 0.0,
-    -1.0, -1.0,  1.0, 0.0, 0.0,
-    -1.0, -1.0, -1.0, 0.0, 1.0,
-     1.0, -1.0, -1.0, 1.0, 1.0,
-    /* bottom face */
-     1.0,  1.0,  1.0, 1.0, 0.0,
-     1.0,  1.0, -1.0, 1.0, 1.0,
-    -1.0,  1.0, -1.0, 0.0, 1.0,
-    -1.0,  1.0,  1.0, 0.0, 0.0
-  };
-/* *INDENT-ON* */
-
-  GLushort indices[] = {
-    0, 1, 2,
-    0, 2, 3,
-    4, 5, 6,
-    4, 6, 7,
-    8, 9, 10,
-    8, 10, 11,
-    12, 13, 14,
-    12, 14, 15,
-    16, 17, 18,
-    16, 18, 19,
-    20, 21, 22,
-    20, 22, 23
-  };
-
   GLint attr_position_loc = 0;
   GLint attr_texture_loc = 0;
 
@@ -527,35 +564,23 @@ _callback_gles2 (gint width, gint height, guint texture, gpointer stuff)
   attr_texture_loc =
       gst_gl_shader_get_attribute_location (cube_filter->shader, "a_texCoord");
 
-  /* Load the vertex position */
-  gl->VertexAttribPointer (attr_position_loc, 3, GL_FLOAT,
-      GL_FALSE, 5 * sizeof (GLfloat), v_vertices);
-
-  /* Load the texture coordinate */
-  gl->VertexAttribPointer (attr_texture_loc, 2, GL_FLOAT,
-      GL_FALSE, 5 * sizeof (GLfloat), &v_vertices[3]);
-
-  gl->EnableVertexAttribArray (attr_position_loc);
-  gl->EnableVertexAttribArray (attr_texture_loc);
-
   gl->ActiveTexture (GL_TEXTURE0);
   gl->BindTexture (GL_TEXTURE_2D, texture);
   gst_gl_shader_set_uniform_1i (cube_filter->shader, "s_texture", 0);
-  gst_gl_shader_set_uniform_1f (cube_filter->shader, "xrot_degree", xrot);
-  gst_gl_shader_set_uniform_1f (cube_filter->shader, "yrot_degree", yrot);
-  gst_gl_shader_set_uniform_1f (cube_filter->shader, "zrot_degree", zrot);
+  gst_gl_shader_set_uniform_1f (cube_filter->shader, "xrot_degree",
+      cube_filter->xrot);
+  gst_gl_shader_set_uniform_1f (cube_filter->shader, "yrot_degree",
+      cube_filter->yrot);
+  gst_gl_shader_set_uniform_1f (cube_filter->shader, "zrot_degree",
+      cube_filter->zrot);
   gst_gl_shader_set_uniform_matrix_4fv (cube_filter->shader, "u_matrix", 1,
       GL_FALSE, matrix);
 
-  gl->DrawElements (GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, indices);
-
-  gl->DisableVertexAttribArray (attr_position_loc);
-  gl->DisableVertexAttribArray (attr_texture_loc);
+  gst_gl_context_bind_geometry (filter->context, GST_GL_GEOMETRY_CUBE,
+      attr_position_loc, attr_texture_loc);
+  gst_gl_context_draw_geometry (filter->context, 0, 6);
+  gst_gl_context_unbind_geometry (filter->context);
 
   gl->Disable (GL_DEPTH_TEST);
-
-  xrot += 0.3f;
-  yrot += 0.2f;
-  zrot += 0.4f;
 }
 #endif
@@ -51,6 +51,20 @@ struct _GstGLFilterCube
     gdouble aspect;
     gdouble znear;
     gdouble zfar;
+
+    /* rotation in degrees, advanced with the running time */
+    gdouble speed;
+    GLfloat xrot;
+    GLfloat yrot;
+    GLfloat zrot;
+    GstClockTime last_running_time;
+
+    /* render on demand: the last input and output buffers and whether the
+     * scene must be drawn again */
+    GstBuffer *last_inbuf;
+    GstBuffer *last_outbuf;
+    gboolean redraw;
+    gboolean reuse;
 };
 
 struct _GstGLFilterCubeClass
@@ -23,11 +23,18 @@
  *
  * Laplacian Convolution Demo Filter.
  *
+ * The kernel can be replaced by any other with the
+ * #GstGLFilterLaplacian:kernel property, zero weights are not sampled and
+ * separable kernels are applied in two passes.
+ *
  * <refsect2>
  * <title>Examples</title>
  * |[
  * gst-launch videotestsrc ! glupload ! glfilterlaplacian ! glimagesink
  * ]|
+ * |[
+ * gst-launch videotestsrc ! glupload ! glfilterlaplacian kernel="-1,-1,-1;-1,8,-1;-1,-1,-1" ! glimagesink
+ * ]| The laplacian with diagonals.
  * FBO (Frame Buffer Object) and GLSL (OpenGL Shading Language) are required.
  * </refsect2>
  */
@@ -41,9 +48,12 @@
 #define GST_CAT_DEFAULT gst_gl_filter_laplacian_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
+#define DEFAULT_KERNEL "0,-1,0;-1,4,-1;0,-1,0"
+
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_KERNEL
 };
 
 #define DEBUG_INIT \
@@ -52,6 +62,7 @@ enum
 G_DEFINE_TYPE_WITH_CODE (GstGLFilterLaplacian, gst_gl_filter_laplacian,
     GST_TYPE_GL_FILTER, DEBUG_INIT);
 
+static void gst_gl_filter_laplacian_finalize (GObject * object);
 static void gst_gl_filter_laplacian_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
 static void gst_gl_filter_laplacian_get_property (GObject * object,
@@ -61,42 +72,6 @@ static void gst_gl_filter_laplacian_reset (GstGLFilter * filter);
 static gboolean gst_gl_filter_laplacian_init_shader (GstGLFilter * filter);
 static gboolean gst_gl_filter_laplacian_filter_texture (GstGLFilter * filter,
     guint in_tex, guint out_tex);
-static void gst_gl_filter_laplacian_callback (gint width, gint height,
-    guint texture, gpointer stuff);
-
-/* *INDENT-OFF* */
-
-/* This filter is meant as a demo of gst-plugins-gl + glsl
-   capabilities. So I'm keeping this shader readable enough. If and
-   when this shader will be used in production be careful to hard code
-   kernel into the shader and remove unneeded zero multiplications in
-   the convolution */
-static const gchar *convolution_fragment_source =
-  "uniform sampler2D tex;"
-  "uniform float kernel[9];"
-  "uniform float width, height;"
-  "void main () {"
-  "  float w = 1.0 / width;"
-  "  float h = 1.0 / height;"
-  "  vec2 texturecoord[9];"
-  "  texturecoord[4] = gl_TexCoord[0].st;"                /*  0  0 */
-  "  texturecoord[5] = texturecoord[4] + vec2(w,   0.0);" /*  1  0 */
-  "  texturecoord[2] = texturecoord[5] - vec2(0.0, h);" /*  1 -1 */
-  "  texturecoord[1] = texturecoord[2] - vec2(w,   0.0);" /*  0 -1 */
-  "  texturecoord[0] = texturecoord[1] - vec2(w,   0.0);" /* -1 -1 */
-  "  texturecoord[3] = texturecoord[0] + vec2(0.0, h);" /* -1  0 */
-  "  texturecoord[6] = texturecoord[3] + vec2(0.0, h);" /* -1  1 */
-  "  texturecoord[7] = texturecoord[6] + vec2(w,   0.0);" /*  0  1 */
-  "  texturecoord[8] = texturecoord[7] + vec2(w,   0.0);" /*  1  1 */
-  "  int i;"
-  "  vec4 sum = vec4 (0.0);"
-  "  for (i = 0; i < 9; i++) { "
-  "    vec4 neighbor = texture2D(tex, texturecoord[i]);"
-  "    sum += neighbor * kernel[i];"
-  "  }"
-  "  gl_FragColor = sum;"
-  "}";
-/* *INDENT-ON* */
 
 static void
 gst_gl_filter_laplacian_class_init (GstGLFilterLaplacianClass * klass)
@@ -107,9 +82,18 @@ gst_gl_filter_laplacian_class_init (GstGLFilterLaplacianClass * klass)
   gobject_class = (GObjectClass *) klass;
   element_class = GST_ELEMENT_CLASS (klass);
 
+  gobject_class->finalize = gst_gl_filter_laplacian_finalize;
   gobject_class->set_property = gst_gl_filter_laplacian_set_property;
   gobject_class->get_property = gst_gl_filter_laplacian_get_property;
 
+  g_object_class_install_property (gobject_class,
+      PROP_KERNEL,
+      g_param_spec_string ("kernel",
+          "Kernel",
+          "Convolution kernel, rows of comma separated weights separated "
+          "by ';', a single row is applied horizontally and vertically",
+          DEFAULT_KERNEL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_metadata (element_class,
       "OpenGL laplacian filter", "Filter/Effect/Video",
       "Laplacian Convolution Demo Filter",
@@ -124,7 +108,20 @@ gst_gl_filter_laplacian_class_init (GstGLFilterLaplacianClass * klass)
 static void
 gst_gl_filter_laplacian_init (GstGLFilterLaplacian * filter)
 {
-  filter->shader = NULL;
+  filter->kernel = g_strdup (DEFAULT_KERNEL);
+  filter->kernel_changed = FALSE;
+  filter->convolution = gst_gl_convolution_new (GST_GL_FILTER (filter));
+}
+
+static void
+gst_gl_filter_laplacian_finalize (GObject * object)
+{
+  GstGLFilterLaplacian *laplacian_filter = GST_GL_FILTER_LAPLACIAN (object);
+
+  gst_gl_convolution_free (laplacian_filter->convolution);
+  g_free (laplacian_filter->kernel);
+
+  G_OBJECT_CLASS (gst_gl_filter_laplacian_parent_class)->finalize (object);
 }
 
 static void
@@ -132,19 +129,23 @@ gst_gl_filter_laplacian_reset (GstGLFilter * filter)
 {
   GstGLFilterLaplacian *laplacian_filter = GST_GL_FILTER_LAPLACIAN (filter);
 
-  //blocking call, wait the opengl thread has destroyed the shader
-  if (laplacian_filter->shader)
-    gst_gl_context_del_shader (filter->context, laplacian_filter->shader);
-  laplacian_filter->shader = NULL;
+  gst_gl_convolution_reset_gl (laplacian_filter->convolution);
 }
 
 static void
 gst_gl_filter_laplacian_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
-  //GstGLFilterLaplacian *filter = GST_GL_FILTER_LAPLACIAN (object);
+  GstGLFilterLaplacian *filter = GST_GL_FILTER_LAPLACIAN (object);
 
   switch (prop_id) {
+    case PROP_KERNEL:
+      GST_OBJECT_LOCK (filter);
+      g_free (filter->kernel);
+      filter->kernel = g_value_dup_string (value);
+      filter->kernel_changed = TRUE;
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -155,9 +156,14 @@ static void
 gst_gl_filter_laplacian_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
-  //GstGLFilterLaplacian *filter = GST_GL_FILTER_LAPLACIAN (object);
+  GstGLFilterLaplacian *filter = GST_GL_FILTER_LAPLACIAN (object);
 
   switch (prop_id) {
+    case PROP_KERNEL:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_string (value, filter->kernel);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -168,55 +174,43 @@ static gboolean
 gst_gl_filter_laplacian_init_shader (GstGLFilter * filter)
 {
   GstGLFilterLaplacian *laplacian_filter = GST_GL_FILTER_LAPLACIAN (filter);
+  gfloat *kernel = NULL;
+  guint width, height;
+  gboolean ret;
+
+  GST_OBJECT_LOCK (laplacian_filter);
+  ret = gst_gl_convolution_parse_kernel (laplacian_filter->kernel, &kernel,
+      &width, &height);
+  if (!ret) {
+    GST_WARNING_OBJECT (laplacian_filter, "invalid kernel \"%s\", using "
+        "the default one", GST_STR_NULL (laplacian_filter->kernel));
+    gst_gl_convolution_parse_kernel (DEFAULT_KERNEL, &kernel, &width,
+        &height);
+  }
+  laplacian_filter->kernel_changed = FALSE;
+  GST_OBJECT_UNLOCK (laplacian_filter);
+
+  gst_gl_convolution_reset_gl (laplacian_filter->convolution);
+  gst_gl_convolution_set_kernel (laplacian_filter->convolution, kernel, width,
+      height);
+  g_free (kernel);
 
-  //blocking call, wait the opengl thread has compiled the shader
-  return gst_gl_context_gen_shader (filter->context, 0,
-      convolution_fragment_source, &laplacian_filter->shader);
+  return gst_gl_convolution_init_gl (laplacian_filter->convolution);
 }
 
 static gboolean
 gst_gl_filter_laplacian_filter_texture (GstGLFilter * filter, guint in_tex,
     guint out_tex)
 {
-  gpointer laplacian_filter = GST_GL_FILTER_LAPLACIAN (filter);
-
-
-  //blocking call, use a FBO
-  gst_gl_filter_render_to_target (filter, TRUE, in_tex, out_tex,
-      gst_gl_filter_laplacian_callback, laplacian_filter);
-
-  return TRUE;
-}
-
-//opengl scene, params: input texture (not the output filter->texture)
-static void
-gst_gl_filter_laplacian_callback (gint width, gint height, guint texture,
-    gpointer stuff)
-{
-  GstGLFilter *filter = GST_GL_FILTER (stuff);
   GstGLFilterLaplacian *laplacian_filter = GST_GL_FILTER_LAPLACIAN (filter);
-  GstGLFuncs *gl = filter->context->gl_vtable;
-
-  gfloat kernel[9] = { 0.0, -1.0, 0.0,
-    -1.0, 4.0, -1.0,
-    0.0, -1.0, 0.0
-  };
-
-  gl->MatrixMode (GL_PROJECTION);
-  gl->LoadIdentity ();
 
-  gst_gl_shader_use (laplacian_filter->shader);
-
-  gl->ActiveTexture (GL_TEXTURE0);
-  gl->Enable (GL_TEXTURE_2D);
-  gl->BindTexture (GL_TEXTURE_2D, texture);
+  if (laplacian_filter->kernel_changed) {
+    if (!gst_gl_filter_laplacian_init_shader (filter))
+      return FALSE;
+  }
 
-  gst_gl_shader_set_uniform_1i (laplacian_filter->shader, "tex", 0);
-  gst_gl_shader_set_uniform_1fv (laplacian_filter->shader, "kernel", 9, kernel);
-  gst_gl_shader_set_uniform_1f (laplacian_filter->shader, "width",
-      (gfloat) width);
-  gst_gl_shader_set_uniform_1f (laplacian_filter->shader, "height",
-      (gfloat) height);
+  gst_gl_convolution_render (laplacian_filter->convolution, TRUE, in_tex,
+      out_tex);
 
-  gst_gl_filter_draw_texture (filter, texture, width, height);
+  return TRUE;
 }
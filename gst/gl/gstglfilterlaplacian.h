@@ -23,6 +23,8 @@
 
 #include <gst/gl/gstglfilter.h>
 
+#include "gstglconvolution.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_GL_FILTER_LAPLACIAN            (gst_gl_filter_laplacian_get_type())
@@ -38,7 +40,12 @@ typedef struct _GstGLFilterLaplacianClass GstGLFilterLaplacianClass;
 struct _GstGLFilterLaplacian
 {
   GstGLFilter filter;
-  GstGLShader *shader;
+
+  /* with OBJECT_LOCK */
+  gchar *kernel;
+  gboolean kernel_changed;
+
+  GstGLConvolution *convolution;
 };
 
 struct _GstGLFilterLaplacianClass
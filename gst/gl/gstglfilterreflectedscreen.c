@@ -243,10 +243,89 @@ gst_gl_filter_reflected_screen_filter_texture (GstGLFilter * filter,
   return TRUE;
 }
 
+/* *INDENT-OFF* */
+/* position and texture coordinates of the screens, one quad per face */
+static const GLfloat separated_screen_vertices[] = {
+  /* right face */
+  -0.75f, 0.0f, -1.0f, 0.5f, 1.0f,
+  -0.75f, 1.25f, -1.0f, 0.5f, 0.0f,
+  1.25f, 1.25f, -1.0f, 1.0f, 0.0f,
+  1.25f, 0.0f, -1.0f, 1.0f, 1.0f,
+  /* left face */
+  -1.0f, 0.0f, -0.75f, 0.5f, 1.0f,
+  -1.0f, 0.0f, 1.25f, 0.0f, 1.0f,
+  -1.0f, 1.25f, 1.25f, 0.0f, 0.0f,
+  -1.0f, 1.25f, -0.75f, 0.5f, 0.0f
+};
+
+static const GLfloat screen_vertices[] = {
+  /* right face */
+  -1.0f, 0.0f, -1.0f, 0.5f, 1.0f,
+  -1.0f, 1.0f, -1.0f, 0.5f, 0.0f,
+  1.0f, 1.0f, -1.0f, 1.0f, 0.0f,
+  1.0f, 0.0f, -1.0f, 1.0f, 1.0f,
+  /* left face */
+  -1.0f, 0.0f, -1.0f, 0.5f, 1.0f,
+  -1.0f, 0.0f, 1.0f, 0.0f, 1.0f,
+  -1.0f, 1.0f, 1.0f, 0.0f, 0.0f,
+  -1.0f, 1.0f, -1.0f, 0.5f, 0.0f
+};
+
+static const GLfloat background_vertices[] = {
+  -10.0f, -10.0f, -1.0f, 0.0f, 0.0f,
+  -10.0f, 10.0f, -1.0f, 0.0f, 0.0f,
+  10.0f, 10.0f, -1.0f, 0.0f, 0.0f,
+  10.0f, -10.0f, -1.0f, 0.0f, 0.0f
+};
+/* *INDENT-ON* */
+
+/* draws n_quads quads from vertices with one color per vertex, or the
+ * current color if colors is NULL */
+static void
+gst_gl_filter_reflected_screen_draw_quads (const GLfloat * vertices,
+    const GLfloat * colors, guint n_quads)
+{
+  glEnableClientState (GL_VERTEX_ARRAY);
+  glEnableClientState (GL_TEXTURE_COORD_ARRAY);
+  glVertexPointer (3, GL_FLOAT, 5 * sizeof (GLfloat), vertices);
+  glTexCoordPointer (2, GL_FLOAT, 5 * sizeof (GLfloat), &vertices[3]);
+
+  if (colors) {
+    glEnableClientState (GL_COLOR_ARRAY);
+    glColorPointer (4, GL_FLOAT, 0, colors);
+  }
+
+  glDrawArrays (GL_QUADS, 0, 4 * n_quads);
+
+  if (colors) {
+    glDisableClientState (GL_COLOR_ARRAY);
+    /* the current color is undefined after drawing with a color array, leave
+     * it at the last vertex color like glBegin ()/glEnd () did */
+    glColor4fv (&colors[4 * (4 * n_quads - 1)]);
+  }
+  glDisableClientState (GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState (GL_VERTEX_ARRAY);
+}
+
 static void
 gst_gl_filter_reflected_screen_draw_separated_screen (GstGLFilter * filter,
     gint width, gint height, guint texture, gfloat alphs, gfloat alphe)
 {
+  /* *INDENT-OFF* */
+  const GLfloat colors[] = {
+    /* right face */
+    1.0f, 1.0f, 1.0f, alphs,
+    1.0f, 1.0f, 1.0f, alphe,
+    1.0f, 1.0f, 1.0f, alphe,
+    1.0f, 1.0f, 1.0f, alphs,
+    /* left face */
+    1.0f, 1.0f, 1.0f, alphs,
+    1.0f, 1.0f, 1.0f, alphs,
+    1.0f, 1.0f, 1.0f, alphe,
+    1.0f, 1.0f, 1.0f, alphe
+  };
+  /* *INDENT-ON* */
+
   //enable ARB Rectangular texturing
   //that's necessary to have the video displayed on our screen (with gstreamer)
   glEnable (GL_TEXTURE_2D);
@@ -260,33 +339,8 @@ gst_gl_filter_reflected_screen_draw_separated_screen (GstGLFilter * filter,
   glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
   //creating screen and setting the texture (depending on texture's height and width)
-  glBegin (GL_QUADS);
-
-  // right Face
-  glColor4f (1.0f, 1.0f, 1.0f, alphs);
-  glTexCoord2f (0.5f, 1.0f);
-  glVertex3f (-0.75f, 0.0f, -1.0f);
-  glColor4f (1.0f, 1.0f, 1.0f, alphe);
-  glTexCoord2f (0.5f, 0.0f);
-  glVertex3f (-0.75f, 1.25f, -1.0f);
-  glTexCoord2f (1.0f, 0.0f);
-  glVertex3f (1.25f, 1.25f, -1.0f);
-  glColor4f (1.0f, 1.0f, 1.0f, alphs);
-  glTexCoord2f (1.0f, 1.0f);
-  glVertex3f (1.25f, 0.0f, -1.0f);
-  // Left Face
-  glColor4f (1.0f, 1.0f, 1.0f, alphs);
-  glTexCoord2f (0.5f, 1.0f);
-  glVertex3f (-1.0f, 0.0f, -0.75f);
-  glTexCoord2f (0.0f, 1.0f);
-  glVertex3f (-1.0f, 0.0f, 1.25f);
-  glColor4f (1.0f, 1.0f, 1.0f, alphe);
-  glTexCoord2f (0.0f, 0.0f);
-  glVertex3f (-1.0f, 1.25f, 1.25f);
-  glTexCoord2f (0.5f, 0.0f);
-  glVertex3f (-1.0f, 1.25f, -0.75f);
-
-  glEnd ();
+  gst_gl_filter_reflected_screen_draw_quads (separated_screen_vertices, colors,
+      2);
   glDisable (GL_TEXTURE_2D);
 }
 
@@ -307,27 +361,7 @@ gst_gl_filter_reflected_screen_draw_screen (GstGLFilter * filter,
   glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
   //creating screen and setting the texture (depending on texture's height and width)
-  glBegin (GL_QUADS);
-
-  glTexCoord2f (0.5f, 1.0f);
-  glVertex3f (-1.0f, 0.0f, -1.0f);
-  glTexCoord2f (0.5f, 0.0f);
-  glVertex3f (-1.0f, 1.0f, -1.0f);
-  glTexCoord2f (1.0f, 0.0f);
-  glVertex3f (1.0f, 1.0f, -1.0f);
-  glTexCoord2f (1.0f, 1.0f);
-  glVertex3f (1.0f, 0.0f, -1.0f);
-  // Left Face
-  glTexCoord2f (0.5f, 1.0f);
-  glVertex3f (-1.0f, 0.0f, -1.0f);
-  glTexCoord2f (0.0f, 1.0f);
-  glVertex3f (-1.0f, 0.0f, 1.0f);
-  glTexCoord2f (0.0f, 0.0f);
-  glVertex3f (-1.0f, 1.0f, 1.0f);
-  glTexCoord2f (0.5f, 0.0f);
-  glVertex3f (-1.0f, 1.0f, -1.0f);
-
-  glEnd ();
+  gst_gl_filter_reflected_screen_draw_quads (screen_vertices, NULL, 2);
 
   //disable this kind of texturing (useless for the gluDisk)
   glDisable (GL_TEXTURE_2D);
@@ -336,19 +370,16 @@ gst_gl_filter_reflected_screen_draw_screen (GstGLFilter * filter,
 static void
 gst_gl_filter_reflected_screen_draw_background ()
 {
-  glBegin (GL_QUADS);
-
-  // right Face
-
-  glColor4f (0.0f, 0.0f, 0.0f, 1.0f);
-  glVertex3f (-10.0f, -10.0f, -1.0f);
-
-  glColor4f (0.0f, 0.0f, 0.2f, 1.0f);
-  glVertex3f (-10.0f, 10.0f, -1.0f);
-  glVertex3f (10.0f, 10.0f, -1.0f);
-  glVertex3f (10.0f, -10.0f, -1.0f);
-
-  glEnd ();
+  /* *INDENT-OFF* */
+  const GLfloat colors[] = {
+    0.0f, 0.0f, 0.0f, 1.0f,
+    0.0f, 0.0f, 0.2f, 1.0f,
+    0.0f, 0.0f, 0.2f, 1.0f,
+    0.0f, 0.0f, 0.2f, 1.0f
+  };
+  /* *INDENT-ON* */
+
+  gst_gl_filter_reflected_screen_draw_quads (background_vertices, colors, 1);
 }
 
 static void
@@ -54,6 +54,7 @@ GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 G_DEFINE_TYPE_WITH_CODE (GstGLFilterSobel, gst_gl_filtersobel,
     GST_TYPE_GL_FILTER, DEBUG_INIT);
 
+static void gst_gl_filtersobel_finalize (GObject * object);
 static void gst_gl_filtersobel_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_gl_filtersobel_get_property (GObject * object, guint prop_id,
@@ -109,6 +110,7 @@ gst_gl_filtersobel_class_init (GstGLFilterSobelClass * klass)
   gobject_class = (GObjectClass *) klass;
   element_class = GST_ELEMENT_CLASS (klass);
 
+  gobject_class->finalize = gst_gl_filtersobel_finalize;
   gobject_class->set_property = gst_gl_filtersobel_set_property;
   gobject_class->get_property = gst_gl_filtersobel_get_property;
 
@@ -133,16 +135,49 @@ gst_gl_filtersobel_class_init (GstGLFilterSobelClass * klass)
       "Filippo Argiolas <filippo.argiolas@gmail.com>");
 }
 
+/* the gradients are stored offset by 0.5 in the green channel after the
+ * horizontal pass and in the red channel after the vertical one, each
+ * pass blurs the other channel */
+static const GstGLConvolutionTap sobel_htaps[] = {
+  {-1.0, 0.0, {0.25, 1.0, 0.0, 0.0}},
+  {0.0, 0.0, {0.5, 0.0, 0.0, 0.0}},
+  {1.0, 0.0, {0.25, -1.0, 0.0, 0.0}}
+};
+
+static const GstGLConvolutionTap sobel_vtaps[] = {
+  {0.0, -1.0, {1.0, 0.25, 0.0, 0.0}},
+  {0.0, 0.0, {0.0, 0.5, 0.0, 0.0}},
+  {0.0, 1.0, {-1.0, 0.25, 0.0, 0.0}}
+};
+
+static const gfloat sobel_hbias[4] = { 0.0, 0.5, 0.0, 0.0 };
+static const gfloat sobel_vbias[4] = { 0.5, 0.0, 0.0, 0.0 };
+
 static void
 gst_gl_filtersobel_init (GstGLFilterSobel * filtersobel)
 {
   int i;
-  filtersobel->hconv = NULL;
-  filtersobel->vconv = NULL;
   filtersobel->invert = FALSE;
   for (i = 0; i < 2; i++) {
     filtersobel->midtexture[i] = 0;
   }
+
+  filtersobel->convolution =
+      gst_gl_convolution_new (GST_GL_FILTER (filtersobel));
+  gst_gl_convolution_add_pass (filtersobel->convolution, sobel_htaps,
+      G_N_ELEMENTS (sobel_htaps), sobel_hbias);
+  gst_gl_convolution_add_pass (filtersobel->convolution, sobel_vtaps,
+      G_N_ELEMENTS (sobel_vtaps), sobel_vbias);
+}
+
+static void
+gst_gl_filtersobel_finalize (GObject * object)
+{
+  GstGLFilterSobel *filtersobel = GST_GL_FILTERSOBEL (object);
+
+  gst_gl_convolution_free (filtersobel->convolution);
+
+  G_OBJECT_CLASS (gst_gl_filtersobel_parent_class)->finalize (object);
 }
 
 static void
@@ -155,13 +190,7 @@ gst_gl_filter_filtersobel_reset (GstGLFilter * filter)
     gst_gl_context_del_shader (filter->context, filtersobel->desat);
   filtersobel->desat = NULL;
 
-  if (filtersobel->hconv)
-    gst_gl_context_del_shader (filter->context, filtersobel->hconv);
-  filtersobel->hconv = NULL;
-
-  if (filtersobel->vconv)
-    gst_gl_context_del_shader (filter->context, filtersobel->vconv);
-  filtersobel->vconv = NULL;
+  gst_gl_convolution_reset_gl (filtersobel->convolution);
 
   if (filtersobel->len)
     gst_gl_context_del_shader (filter->context, filtersobel->len);
@@ -210,12 +239,7 @@ gst_gl_filtersobel_init_shader (GstGLFilter * filter)
   ret =
       gst_gl_context_gen_shader (filter->context, 0, desaturate_fragment_source,
       &filtersobel->desat);
-  ret &=
-      gst_gl_context_gen_shader (filter->context, 0,
-      sep_sobel_hconv3_fragment_source, &filtersobel->hconv);
-  ret &=
-      gst_gl_context_gen_shader (filter->context, 0,
-      sep_sobel_vconv3_fragment_source, &filtersobel->vconv);
+  ret &= gst_gl_convolution_init_gl (filtersobel->convolution);
   ret &=
       gst_gl_context_gen_shader (filter->context, 0,
       sep_sobel_length_fragment_source, &filtersobel->len);
@@ -231,13 +255,9 @@ gst_gl_filtersobel_filter_texture (GstGLFilter * filter, guint in_tex,
 
   gst_gl_filter_render_to_target_with_shader (filter, TRUE, in_tex,
       filtersobel->midtexture[0], filtersobel->desat);
-  gst_gl_filter_render_to_target_with_shader (filter, FALSE,
-      filtersobel->midtexture[0], filtersobel->midtexture[1],
-      filtersobel->hconv);
-  gst_gl_filter_render_to_target_with_shader (filter, FALSE,
-      filtersobel->midtexture[1], filtersobel->midtexture[0],
-      filtersobel->vconv);
-  gst_gl_filter_render_to_target (filter, FALSE, filtersobel->midtexture[0],
+  gst_gl_convolution_render (filtersobel->convolution, FALSE,
+      filtersobel->midtexture[0], filtersobel->midtexture[1]);
+  gst_gl_filter_render_to_target (filter, FALSE, filtersobel->midtexture[1],
       out_tex, gst_gl_filtersobel_length, filtersobel);
 
   return TRUE;
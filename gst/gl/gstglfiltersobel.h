@@ -23,6 +23,8 @@
 
 #include <gst/gl/gstglfilter.h>
 
+#include "gstglconvolution.h"
+
 #define GST_TYPE_GL_FILTERSOBEL            (gst_gl_filtersobel_get_type())
 #define GST_GL_FILTERSOBEL(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_FILTERSOBEL,GstGLFilterSobel))
 #define GST_IS_GL_FILTERSOBEL(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_FILTERSOBEL))
@@ -36,12 +38,11 @@ typedef struct _GstGLFilterSobelClass GstGLFilterSobelClass;
 struct _GstGLFilterSobel
 {
   GstGLFilter filter;
-  GstGLShader *hconv;
-  GstGLShader *vconv;
+  GstGLConvolution *convolution;
   GstGLShader *len;
   GstGLShader *desat;
 
-  GLuint midtexture[5];
+  GLuint midtexture[2];
 
   gboolean invert;
 };
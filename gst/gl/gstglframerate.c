@@ -0,0 +1,756 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-glframerate
+ *
+ * Frame rate conversion based on fragment shaders.
+ *
+ * The output frames are spaced by the framerate of the src caps, starting
+ * at the timestamp of the first input frame and again after each
+ * discontinuity.  Each output frame is interpolated from the two input
+ * frames around its timestamp, so the output is one input frame behind.
+ * The last input frames are kept in a ring of textures, like in
+ * #GstGLDeinterlace.
+ *
+ * With the motion method a motion vector is searched for each block of
+ * #GstGLFrameRate:block-size pixels, up to #GstGLFrameRate:search-range
+ * pixels away in the previous frame, and both frames are moved along the
+ * vectors before they are blended.  Blocks without a good match fall back to
+ * a plain blend.
+ *
+ * <refsect2>
+ * <title>Examples</title>
+ * |[
+ * gst-launch videotestsrc pattern=ball ! video/x-raw,framerate=24/1 ! glupload ! glframerate method=motion ! video/x-raw,framerate=60/1 ! glimagesink
+ * ]|
+ * FBO (Frame Buffer Object) and GLSL (OpenGL Shading Language) are required.
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstglframerate.h"
+
+#define GST_CAT_DEFAULT gst_gl_frame_rate_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define DEFAULT_METHOD GST_GL_FRAME_RATE_METHOD_BLEND
+#define DEFAULT_BLOCK_SIZE 16
+#define DEFAULT_SEARCH_RANGE 16
+
+/* mean luma difference of a match above which blending takes over, the
+ * blend is complete at twice that */
+#define MATCH_THRESHOLD 0.08f
+
+/* inputs further apart than this are not interpolated */
+#define MAX_GAP GST_SECOND
+
+enum
+{
+  PROP_0,
+  PROP_METHOD,
+  PROP_BLOCK_SIZE,
+  PROP_SEARCH_RANGE
+};
+
+#define DEBUG_INIT \
+  GST_DEBUG_CATEGORY_INIT (gst_gl_frame_rate_debug, "glframerate", 0, "glframerate element");
+
+G_DEFINE_TYPE_WITH_CODE (GstGLFrameRate, gst_gl_frame_rate,
+    GST_TYPE_GL_FILTER, DEBUG_INIT);
+
+static void gst_gl_frame_rate_finalize (GObject * object);
+static void gst_gl_frame_rate_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_gl_frame_rate_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+
+static GstCaps *gst_gl_frame_rate_fixate_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps);
+static gboolean gst_gl_frame_rate_query (GstBaseTransform * bt,
+    GstPadDirection direction, GstQuery * query);
+static GstFlowReturn gst_gl_frame_rate_transform (GstBaseTransform * bt,
+    GstBuffer * inbuf, GstBuffer * outbuf);
+
+static void gst_gl_frame_rate_reset (GstGLFilter * filter);
+static gboolean gst_gl_frame_rate_init_shader (GstGLFilter * filter);
+static gboolean gst_gl_frame_rate_filter_texture (GstGLFilter * filter,
+    guint in_tex, guint out_tex);
+
+#define GST_TYPE_GL_FRAME_RATE_METHOD (gst_gl_frame_rate_method_get_type ())
+static GType
+gst_gl_frame_rate_method_get_type (void)
+{
+  static GType gl_frame_rate_method_type = 0;
+  static const GEnumValue method_types[] = {
+    {GST_GL_FRAME_RATE_METHOD_NEAREST, "Nearest input frame", "nearest"},
+    {GST_GL_FRAME_RATE_METHOD_BLEND, "Blend the input frames", "blend"},
+    {GST_GL_FRAME_RATE_METHOD_MOTION, "Motion compensated interpolation",
+        "motion"},
+    {0, NULL, NULL}
+  };
+
+  if (!gl_frame_rate_method_type) {
+    gl_frame_rate_method_type =
+        g_enum_register_static ("GstGLFrameRateMethod", method_types);
+  }
+  return gl_frame_rate_method_type;
+}
+
+/* *INDENT-OFF* */
+static const gchar *frame_rate_vertex_source =
+  "attribute vec4 a_position;\n"
+  "attribute vec2 a_texcoord;\n"
+  "varying vec2 v_texcoord;\n"
+  "void main()\n"
+  "{\n"
+  "   gl_Position = a_position;\n"
+  "   v_texcoord = a_texcoord;\n"
+  "}\n";
+
+/* tex is the current frame and tex_prev the one before it */
+#define FRAME_RATE_FRAGMENT_HEADER \
+  "#ifdef GL_ES\n" \
+  "#ifdef GL_FRAGMENT_PRECISION_HIGH\n" \
+  "precision highp float;\n" \
+  "#else\n" \
+  "precision mediump float;\n" \
+  "#endif\n" \
+  "#endif\n" \
+  "varying vec2 v_texcoord;\n" \
+  "uniform sampler2D tex;\n" \
+  "uniform sampler2D tex_prev;\n" \
+  "uniform vec2 size;\n"
+
+static const gchar *blend_fragment_source =
+  FRAME_RATE_FRAGMENT_HEADER
+  "uniform float phase;\n"
+  "void main () {\n"
+  "  vec3 prev = texture2D(tex_prev, v_texcoord).rgb;\n"
+  "  vec3 cur = texture2D(tex, v_texcoord).rgb;\n"
+  "  gl_FragColor = vec4(mix(prev, cur, phase), 1.0);\n"
+  "}\n";
+
+/* one fragment per block.  Three step search of the vector v, in pixels,
+ * that moves the block of the previous frame at xy - v to the block of the
+ * current frame at xy.  The difference is the mean over 4x4 luma samples.
+ * The vector is stored with 0 at 128/255 so that static blocks are exact */
+static const gchar *motion_fragment_source =
+  FRAME_RATE_FRAGMENT_HEADER
+  "uniform vec2 blocks;\n"
+  "uniform float block_size;\n"
+  "uniform float range;\n"
+  "float luma (sampler2D t, vec2 xy) {\n"
+  "  return dot(texture2D(t, xy / size).rgb, vec3(0.299, 0.587, 0.114));\n"
+  "}\n"
+  "float difference (vec2 origin, vec2 v) {\n"
+  "  float s = 0.0;\n"
+  "  float spacing = block_size / 4.0;\n"
+  "  for (int j = 0; j < 4; j++) {\n"
+  "    for (int i = 0; i < 4; i++) {\n"
+  "      vec2 xy = origin + (vec2(float(i), float(j)) + 0.5) * spacing;\n"
+  "      s += abs(luma (tex, xy) - luma (tex_prev, xy - v));\n"
+  "    }\n"
+  "  }\n"
+  "  return s / 16.0;\n"
+  "}\n"
+  "void main () {\n"
+  "  vec2 origin = floor(v_texcoord * blocks) * block_size;\n"
+  "  vec2 best = vec2(0.0);\n"
+  "  float best_diff = difference (origin, best);\n"
+  "  float step = max(floor(range / 2.0 + 0.5), 1.0);\n"
+  "  for (int r = 0; r < 6; r++) {\n"
+  "    vec2 centre = best;\n"
+  "    for (int y = -1; y <= 1; y++) {\n"
+  "      for (int x = -1; x <= 1; x++) {\n"
+  "        vec2 v = centre + vec2(float(x), float(y)) * step;\n"
+  "        if ((x != 0 || y != 0) && max(abs(v.x), abs(v.y)) <= range) {\n"
+  "          float d = difference (origin, v);\n"
+  "          if (d < best_diff) {\n"
+  "            best_diff = d;\n"
+  "            best = v;\n"
+  "          }\n"
+  "        }\n"
+  "      }\n"
+  "    }\n"
+  "    if (step <= 1.0)\n"
+  "      break;\n"
+  "    step = floor(step / 2.0);\n"
+  "  }\n"
+  "  gl_FragColor = vec4((best / range * 127.0 + 128.0) / 255.0, best_diff, 1.0);\n"
+  "}\n";
+
+/* at phase the content at xy was at xy - phase * v in the previous frame
+ * and is at xy + (1 - phase) * v in the current one */
+static const gchar *interp_fragment_source =
+  FRAME_RATE_FRAGMENT_HEADER
+  "uniform sampler2D tex_vectors;\n"
+  "uniform float range;\n"
+  "uniform float phase;\n"
+  "uniform float threshold;\n"
+  "void main () {\n"
+  "  vec3 m = texture2D(tex_vectors, v_texcoord).xyz;\n"
+  "  vec2 v = (m.xy * 255.0 - 128.0) / 127.0 * range / size;\n"
+  "  vec3 prev = texture2D(tex_prev, v_texcoord - phase * v).rgb;\n"
+  "  vec3 cur = texture2D(tex, v_texcoord + (1.0 - phase) * v).rgb;\n"
+  "  vec3 compensated = mix(prev, cur, phase);\n"
+  "  vec3 blended = mix(texture2D(tex_prev, v_texcoord).rgb,\n"
+  "      texture2D(tex, v_texcoord).rgb, phase);\n"
+  "  float mismatch = smoothstep(threshold, 2.0 * threshold, m.z);\n"
+  "  gl_FragColor = vec4(mix(compensated, blended, mismatch), 1.0);\n"
+  "}\n";
+/* *INDENT-ON* */
+
+static void
+gst_gl_frame_rate_class_init (GstGLFrameRateClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+
+  gobject_class = (GObjectClass *) klass;
+  element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->set_property = gst_gl_frame_rate_set_property;
+  gobject_class->get_property = gst_gl_frame_rate_get_property;
+  gobject_class->finalize = gst_gl_frame_rate_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_METHOD,
+      g_param_spec_enum ("method", "Method", "Interpolation method",
+          GST_TYPE_GL_FRAME_RATE_METHOD, DEFAULT_METHOD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_BLOCK_SIZE,
+      g_param_spec_uint ("block-size", "Block size",
+          "Size in pixels of the blocks of the motion search.  Only taken "
+          "into account when the caps are negotiated", 4, 64,
+          DEFAULT_BLOCK_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SEARCH_RANGE,
+      g_param_spec_uint ("search-range", "Search range",
+          "Largest motion in pixels between two input frames", 1, 64,
+          DEFAULT_SEARCH_RANGE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_metadata (element_class,
+      "OpenGL frame rate converter", "Filter/Effect/Video",
+      "Frame rate conversion with blended or motion compensated "
+      "interpolation", "The GStreamer developers");
+
+  GST_BASE_TRANSFORM_CLASS (klass)->fixate_caps =
+      gst_gl_frame_rate_fixate_caps;
+  GST_BASE_TRANSFORM_CLASS (klass)->query = gst_gl_frame_rate_query;
+  GST_BASE_TRANSFORM_CLASS (klass)->transform = gst_gl_frame_rate_transform;
+
+  GST_GL_FILTER_CLASS (klass)->filter_texture =
+      gst_gl_frame_rate_filter_texture;
+  GST_GL_FILTER_CLASS (klass)->onInitFBO = gst_gl_frame_rate_init_shader;
+  GST_GL_FILTER_CLASS (klass)->onReset = gst_gl_frame_rate_reset;
+}
+
+static void
+gst_gl_frame_rate_init (GstGLFrameRate * filter)
+{
+  filter->method = DEFAULT_METHOD;
+  filter->block_size = DEFAULT_BLOCK_SIZE;
+  filter->search_range = DEFAULT_SEARCH_RANGE;
+  filter->history =
+      gst_gl_history_new (GST_GL_FILTER (filter), GST_GL_FRAME_RATE_HISTORY);
+  filter->base_ts = GST_CLOCK_TIME_NONE;
+  filter->in_ts = GST_CLOCK_TIME_NONE;
+  filter->phase = 1.0f;
+}
+
+static void
+gst_gl_frame_rate_finalize (GObject * object)
+{
+  GstGLFrameRate *filter = GST_GL_FRAME_RATE (object);
+
+  gst_gl_history_free (filter->history);
+
+  G_OBJECT_CLASS (gst_gl_frame_rate_parent_class)->finalize (object);
+}
+
+static void
+gst_gl_frame_rate_reset (GstGLFilter * filter)
+{
+  GstGLFrameRate *frame_rate = GST_GL_FRAME_RATE (filter);
+
+  gst_gl_history_reset_gl (frame_rate->history);
+
+  //blocking call, wait the opengl thread has destroyed the shaders
+  if (frame_rate->blend_shader)
+    gst_gl_context_del_shader (filter->context, frame_rate->blend_shader);
+  frame_rate->blend_shader = NULL;
+  if (frame_rate->motion_shader)
+    gst_gl_context_del_shader (filter->context, frame_rate->motion_shader);
+  frame_rate->motion_shader = NULL;
+  if (frame_rate->interp_shader)
+    gst_gl_context_del_shader (filter->context, frame_rate->interp_shader);
+  frame_rate->interp_shader = NULL;
+
+  if (frame_rate->vector_tex)
+    gst_gl_context_del_texture (filter->context, &frame_rate->vector_tex);
+  frame_rate->vector_tex = 0;
+  if (frame_rate->vector_fbo)
+    gst_gl_context_del_fbo (filter->context, frame_rate->vector_fbo,
+        frame_rate->vector_depthbuffer);
+  frame_rate->vector_fbo = 0;
+  frame_rate->vector_depthbuffer = 0;
+  frame_rate->vectors_valid = FALSE;
+
+  frame_rate->base_ts = GST_CLOCK_TIME_NONE;
+  frame_rate->out_count = 0;
+}
+
+static void
+gst_gl_frame_rate_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGLFrameRate *filter = GST_GL_FRAME_RATE (object);
+
+  switch (prop_id) {
+    case PROP_METHOD:
+      filter->method = g_value_get_enum (value);
+      break;
+    case PROP_BLOCK_SIZE:
+      filter->block_size = g_value_get_uint (value);
+      break;
+    case PROP_SEARCH_RANGE:
+      filter->search_range = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gl_frame_rate_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGLFrameRate *filter = GST_GL_FRAME_RATE (object);
+
+  switch (prop_id) {
+    case PROP_METHOD:
+      g_value_set_enum (value, filter->method);
+      break;
+    case PROP_BLOCK_SIZE:
+      g_value_set_uint (value, filter->block_size);
+      break;
+    case PROP_SEARCH_RANGE:
+      g_value_set_uint (value, filter->search_range);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* the history is at the input size so the size is kept, the framerate is
+ * only kept when downstream does not ask for another one */
+static GstCaps *
+gst_gl_frame_rate_fixate_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps)
+{
+  GstStructure *ins, *outs;
+  gint width, height, fps_n, fps_d;
+
+  if (direction != GST_PAD_SINK)
+    goto done;
+
+  othercaps = gst_caps_truncate (othercaps);
+  othercaps = gst_caps_make_writable (othercaps);
+
+  ins = gst_caps_get_structure (caps, 0);
+  outs = gst_caps_get_structure (othercaps, 0);
+
+  if (gst_structure_get_int (ins, "width", &width))
+    gst_structure_fixate_field_nearest_int (outs, "width", width);
+  if (gst_structure_get_int (ins, "height", &height))
+    gst_structure_fixate_field_nearest_int (outs, "height", height);
+  if (gst_structure_get_fraction (ins, "framerate", &fps_n, &fps_d))
+    gst_structure_fixate_field_nearest_fraction (outs, "framerate", fps_n,
+        fps_d);
+
+done:
+  return GST_BASE_TRANSFORM_CLASS (gst_gl_frame_rate_parent_class)->fixate_caps
+      (bt, direction, caps, othercaps);
+}
+
+/* an output frame waits for the input frame after it */
+static gboolean
+gst_gl_frame_rate_query (GstBaseTransform * bt, GstPadDirection direction,
+    GstQuery * query)
+{
+  GstGLFilter *filter = GST_GL_FILTER (bt);
+  GstClockTime min, max, latency = 0;
+  gboolean res, live;
+
+  res = GST_BASE_TRANSFORM_CLASS (gst_gl_frame_rate_parent_class)->query (bt,
+      direction, query);
+
+  if (!res || direction != GST_PAD_SRC
+      || GST_QUERY_TYPE (query) != GST_QUERY_LATENCY)
+    return res;
+
+  if (GST_VIDEO_INFO_FPS_N (&filter->in_info) > 0)
+    latency = gst_util_uint64_scale_int (GST_SECOND,
+        GST_VIDEO_INFO_FPS_D (&filter->in_info),
+        GST_VIDEO_INFO_FPS_N (&filter->in_info));
+
+  gst_query_parse_latency (query, &live, &min, &max);
+
+  GST_DEBUG_OBJECT (filter, "adding %" GST_TIME_FORMAT " of latency",
+      GST_TIME_ARGS (latency));
+
+  min += latency;
+  if (GST_CLOCK_TIME_IS_VALID (max))
+    max += latency;
+
+  gst_query_set_latency (query, live, min, max);
+
+  return TRUE;
+}
+
+static gboolean
+gst_gl_frame_rate_init_shader (GstGLFilter * filter)
+{
+  GstGLFrameRate *frame_rate = GST_GL_FRAME_RATE (filter);
+  guint block_size = frame_rate->block_size;
+
+  if (!gst_gl_history_init_gl (frame_rate->history))
+    return FALSE;
+
+  //blocking call, wait the opengl thread has compiled the shaders
+  if (!gst_gl_context_gen_shader (filter->context, frame_rate_vertex_source,
+          blend_fragment_source, &frame_rate->blend_shader))
+    return FALSE;
+  if (!gst_gl_context_gen_shader (filter->context, frame_rate_vertex_source,
+          motion_fragment_source, &frame_rate->motion_shader))
+    return FALSE;
+  if (!gst_gl_context_gen_shader (filter->context, frame_rate_vertex_source,
+          interp_fragment_source, &frame_rate->interp_shader))
+    return FALSE;
+
+  frame_rate->vector_block_size = block_size;
+  frame_rate->vector_width =
+      (GST_VIDEO_INFO_WIDTH (&filter->in_info) + block_size - 1) / block_size;
+  frame_rate->vector_height =
+      (GST_VIDEO_INFO_HEIGHT (&filter->in_info) + block_size - 1) / block_size;
+  frame_rate->vectors_valid = FALSE;
+
+  //blocking call, generate a texture and a FBO at the block resolution
+  gst_gl_context_gen_texture_full (filter->context, &frame_rate->vector_tex,
+      GL_RGBA8, frame_rate->vector_width, frame_rate->vector_height, 1);
+
+  return gst_gl_context_gen_fbo (filter->context, frame_rate->vector_width,
+      frame_rate->vector_height, &frame_rate->vector_fbo,
+      &frame_rate->vector_depthbuffer);
+}
+
+static void
+gst_gl_frame_rate_draw (GstGLFrameRate * frame_rate, GstGLShader * shader)
+{
+  GstGLFilter *filter = GST_GL_FILTER (frame_rate);
+
+  gst_gl_context_bind_geometry (filter->context, GST_GL_GEOMETRY_QUAD,
+      gst_gl_shader_get_attribute_location (shader, "a_position"),
+      gst_gl_shader_get_attribute_location (shader, "a_texcoord"));
+  gst_gl_context_draw_geometry (filter->context, 0, 1);
+  gst_gl_context_unbind_geometry (filter->context);
+
+  gst_gl_context_clear_shader (filter->context);
+}
+
+/* binds the current frame, texture, and the previous one */
+static void
+gst_gl_frame_rate_bind_frames (GstGLFrameRate * frame_rate,
+    GstGLShader * shader, guint texture)
+{
+  GstGLFilter *filter = GST_GL_FILTER (frame_rate);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+
+  gl->ActiveTexture (GL_TEXTURE1);
+  gl->BindTexture (GL_TEXTURE_2D, gst_gl_history_get (frame_rate->history, 1));
+  gst_gl_shader_set_uniform_1i (shader, "tex_prev", 1);
+
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, texture);
+  gst_gl_shader_set_uniform_1i (shader, "tex", 0);
+
+  gst_gl_shader_set_uniform_2f (shader, "size",
+      (gfloat) GST_VIDEO_INFO_WIDTH (&filter->in_info),
+      (gfloat) GST_VIDEO_INFO_HEIGHT (&filter->in_info));
+}
+
+//opengl scene, params: the current frame, rendered at the block resolution
+static void
+gst_gl_frame_rate_motion_callback (gint width, gint height, guint texture,
+    gpointer stuff)
+{
+  GstGLFrameRate *frame_rate = GST_GL_FRAME_RATE (stuff);
+  GstGLShader *shader = frame_rate->motion_shader;
+
+  gst_gl_shader_use (shader);
+
+  gst_gl_frame_rate_bind_frames (frame_rate, shader, texture);
+  gst_gl_shader_set_uniform_2f (shader, "blocks",
+      (gfloat) frame_rate->vector_width, (gfloat) frame_rate->vector_height);
+  gst_gl_shader_set_uniform_1f (shader, "block_size",
+      (gfloat) frame_rate->vector_block_size);
+  gst_gl_shader_set_uniform_1f (shader, "range",
+      (gfloat) frame_rate->search_range);
+
+  gst_gl_frame_rate_draw (frame_rate, shader);
+}
+
+//opengl scene, params: the current frame
+static void
+gst_gl_frame_rate_interp_callback (gint width, gint height, guint texture,
+    gpointer stuff)
+{
+  GstGLFrameRate *frame_rate = GST_GL_FRAME_RATE (stuff);
+  GstGLFilter *filter = GST_GL_FILTER (stuff);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  GstGLShader *shader = frame_rate->interp_shader;
+
+  gst_gl_shader_use (shader);
+
+  gl->ActiveTexture (GL_TEXTURE2);
+  gl->BindTexture (GL_TEXTURE_2D, frame_rate->vector_tex);
+  gst_gl_shader_set_uniform_1i (shader, "tex_vectors", 2);
+
+  gst_gl_frame_rate_bind_frames (frame_rate, shader, texture);
+  gst_gl_shader_set_uniform_1f (shader, "range",
+      (gfloat) frame_rate->search_range);
+  gst_gl_shader_set_uniform_1f (shader, "phase", frame_rate->phase);
+  gst_gl_shader_set_uniform_1f (shader, "threshold", MATCH_THRESHOLD);
+
+  gst_gl_frame_rate_draw (frame_rate, shader);
+}
+
+//opengl scene, params: the current frame
+static void
+gst_gl_frame_rate_blend_callback (gint width, gint height, guint texture,
+    gpointer stuff)
+{
+  GstGLFrameRate *frame_rate = GST_GL_FRAME_RATE (stuff);
+  GstGLShader *shader = frame_rate->blend_shader;
+  gfloat phase = frame_rate->phase;
+
+  if (frame_rate->method == GST_GL_FRAME_RATE_METHOD_NEAREST)
+    phase = phase < 0.5f ? 0.0f : 1.0f;
+
+  gst_gl_shader_use (shader);
+
+  gst_gl_frame_rate_bind_frames (frame_rate, shader, texture);
+  gst_gl_shader_set_uniform_1f (shader, "phase", phase);
+
+  gst_gl_frame_rate_draw (frame_rate, shader);
+}
+
+static gboolean
+gst_gl_frame_rate_filter_texture (GstGLFilter * filter, guint in_tex,
+    guint out_tex)
+{
+  GstGLFrameRate *frame_rate = GST_GL_FRAME_RATE (filter);
+  GstGLHistory *history = frame_rate->history;
+  GLCB callback = gst_gl_frame_rate_blend_callback;
+  guint in_width, in_height;
+
+  /* in_tex is the current frame of the history */
+  if (frame_rate->method == GST_GL_FRAME_RATE_METHOD_MOTION
+      && history->len > 1) {
+    if (!frame_rate->vectors_valid) {
+      in_width = GST_VIDEO_INFO_WIDTH (&filter->in_info);
+      in_height = GST_VIDEO_INFO_HEIGHT (&filter->in_info);
+
+      //blocking call, use a FBO at the block resolution
+      gst_gl_context_use_fbo (filter->context, frame_rate->vector_width,
+          frame_rate->vector_height, frame_rate->vector_fbo,
+          frame_rate->vector_depthbuffer, frame_rate->vector_tex,
+          gst_gl_frame_rate_motion_callback, in_width, in_height,
+          gst_gl_history_get (history, 0), 0, in_width, 0, in_height,
+          GST_GL_DISPLAY_PROJECTION_ORTHO2D, frame_rate);
+      frame_rate->vectors_valid = TRUE;
+    }
+    callback = gst_gl_frame_rate_interp_callback;
+  }
+
+  //blocking call, use a FBO
+  gst_gl_filter_render_to_target (filter, FALSE, in_tex, out_tex, callback,
+      frame_rate);
+
+  return TRUE;
+}
+
+static void
+gst_gl_frame_rate_set_times (GstGLFrameRate * frame_rate, GstBuffer * buf,
+    gint fps_n, gint fps_d)
+{
+  guint64 count = frame_rate->out_count;
+  GstClockTime ts, next_ts;
+
+  ts = frame_rate->base_ts + gst_util_uint64_scale (count,
+      fps_d * GST_SECOND, fps_n);
+  next_ts = frame_rate->base_ts + gst_util_uint64_scale (count + 1,
+      fps_d * GST_SECOND, fps_n);
+
+  GST_BUFFER_PTS (buf) = ts;
+  GST_BUFFER_DTS (buf) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION (buf) = next_ts - ts;
+  GST_BUFFER_OFFSET (buf) = count;
+  GST_BUFFER_OFFSET_END (buf) = count + 1;
+}
+
+/* uploads @inbuf into the history, as the current frame */
+static gboolean
+gst_gl_frame_rate_push_history (GstGLFrameRate * frame_rate, GstBuffer * inbuf)
+{
+  GstGLFilter *filter = GST_GL_FILTER (frame_rate);
+  guint in_tex;
+
+  if (!gst_gl_upload_perform_with_buffer (filter->upload, inbuf, &in_tex))
+    return FALSE;
+
+  gst_gl_history_push (frame_rate->history, in_tex, frame_rate->in_ts);
+  gst_gl_upload_release_buffer (filter->upload);
+  frame_rate->vectors_valid = FALSE;
+
+  return TRUE;
+}
+
+/* the input is uploaded once into the history, every output frame whose
+ * time is reached by the input is then rendered from it, all but the last
+ * one are pushed here and the last one goes in outbuf */
+static GstFlowReturn
+gst_gl_frame_rate_transform (GstBaseTransform * bt, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  GstGLFrameRate *frame_rate = GST_GL_FRAME_RATE (bt);
+  GstGLFilter *filter = GST_GL_FILTER (bt);
+  GstGLHistory *history = frame_rate->history;
+  GstClockTime ts, prev_ts = GST_CLOCK_TIME_NONE, out_ts;
+  GstBuffer *buf;
+  GstFlowReturn ret;
+  gboolean discont;
+  gint fps_n, fps_d;
+  guint in_tex;
+
+  if (!gst_gl_ensure_display (filter, &filter->display))
+    return GST_FLOW_NOT_NEGOTIATED;
+
+  ts = GST_BUFFER_PTS (inbuf);
+  fps_n = GST_VIDEO_INFO_FPS_N (&filter->out_info);
+  fps_d = GST_VIDEO_INFO_FPS_D (&filter->out_info);
+
+  /* nothing to convert, show the current frame */
+  if (!GST_CLOCK_TIME_IS_VALID (ts) || fps_n <= 0 || fps_d <= 0) {
+    frame_rate->in_ts = GST_CLOCK_TIME_NONE;
+    frame_rate->phase = 1.0f;
+    if (!gst_gl_frame_rate_push_history (frame_rate, inbuf))
+      return GST_FLOW_ERROR;
+    if (!gst_gl_filter_filter_texture_to_buffer (filter,
+            gst_gl_history_get (history, 0), outbuf))
+      return GST_FLOW_ERROR;
+    return GST_FLOW_OK;
+  }
+
+  if (history->len > 0)
+    prev_ts = gst_gl_history_get_timestamp (history, 0);
+
+  discont = GST_BUFFER_FLAG_IS_SET (inbuf, GST_BUFFER_FLAG_DISCONT)
+      || !GST_CLOCK_TIME_IS_VALID (frame_rate->base_ts)
+      || !GST_CLOCK_TIME_IS_VALID (prev_ts) || ts <= prev_ts
+      || ts - prev_ts > MAX_GAP;
+
+  if (discont) {
+    GST_DEBUG_OBJECT (frame_rate, "restarting the output at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (ts));
+    gst_gl_history_flush (history);
+    prev_ts = GST_CLOCK_TIME_NONE;
+    frame_rate->base_ts = ts;
+    frame_rate->out_count = 0;
+  }
+
+  frame_rate->in_ts = ts;
+  if (!gst_gl_frame_rate_push_history (frame_rate, inbuf))
+    return GST_FLOW_ERROR;
+  in_tex = gst_gl_history_get (history, 0);
+
+  out_ts = frame_rate->base_ts + gst_util_uint64_scale (frame_rate->out_count,
+      fps_d * GST_SECOND, fps_n);
+
+  /* no output frame falls before this input, only remember it */
+  if (out_ts > ts) {
+    GST_LOG_OBJECT (frame_rate, "no output frame before %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (ts));
+
+    return GST_BASE_TRANSFORM_FLOW_DROPPED;
+  }
+
+  while (TRUE) {
+    gboolean last;
+
+    if (GST_CLOCK_TIME_IS_VALID (prev_ts))
+      frame_rate->phase = (gfloat) (out_ts - prev_ts) / (ts - prev_ts);
+    else
+      frame_rate->phase = 1.0f;
+
+    out_ts = frame_rate->base_ts + gst_util_uint64_scale
+        (frame_rate->out_count + 1, fps_d * GST_SECOND, fps_n);
+    last = out_ts > ts;
+
+    if (last) {
+      buf = outbuf;
+    } else {
+      buf = NULL;
+      ret = GST_BASE_TRANSFORM_CLASS
+          (gst_gl_frame_rate_parent_class)->prepare_output_buffer (bt, inbuf,
+          &buf);
+      if (ret != GST_FLOW_OK)
+        return ret;
+    }
+
+    if (!gst_gl_filter_filter_texture_to_buffer (filter, in_tex, buf)) {
+      if (buf != outbuf)
+        gst_buffer_unref (buf);
+      return GST_FLOW_ERROR;
+    }
+
+    gst_gl_frame_rate_set_times (frame_rate, buf, fps_n, fps_d);
+    if (frame_rate->out_count == 0)
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+    else
+      GST_BUFFER_FLAG_UNSET (buf, GST_BUFFER_FLAG_DISCONT);
+    frame_rate->out_count++;
+
+    if (last)
+      break;
+
+    ret = gst_pad_push (GST_BASE_TRANSFORM_SRC_PAD (bt), buf);
+    if (ret != GST_FLOW_OK)
+      return ret;
+  }
+
+  return GST_FLOW_OK;
+}
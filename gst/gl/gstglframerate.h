@@ -0,0 +1,107 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_GL_FRAME_RATE_H_
+#define _GST_GL_FRAME_RATE_H_
+
+#include <gst/gl/gstglfilter.h>
+
+#include "gstglhistory.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GL_FRAME_RATE            (gst_gl_frame_rate_get_type())
+#define GST_GL_FRAME_RATE(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_FRAME_RATE,GstGLFrameRate))
+#define GST_IS_GL_FRAME_RATE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_FRAME_RATE))
+#define GST_GL_FRAME_RATE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GST_TYPE_GL_FRAME_RATE,GstGLFrameRateClass))
+#define GST_IS_GL_FRAME_RATE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GST_TYPE_GL_FRAME_RATE))
+#define GST_GL_FRAME_RATE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GST_TYPE_GL_FRAME_RATE,GstGLFrameRateClass))
+
+typedef struct _GstGLFrameRate GstGLFrameRate;
+typedef struct _GstGLFrameRateClass GstGLFrameRateClass;
+
+/**
+ * GstGLFrameRateMethod:
+ * @GST_GL_FRAME_RATE_METHOD_NEAREST: repeat or drop the closest input frame
+ * @GST_GL_FRAME_RATE_METHOD_BLEND: blend the two input frames around the
+ *   output time
+ * @GST_GL_FRAME_RATE_METHOD_MOTION: move the blocks of both input frames
+ *   along their motion vectors, blend where no match is found
+ *
+ * The interpolation of the output frames.
+ */
+typedef enum
+{
+  GST_GL_FRAME_RATE_METHOD_NEAREST,
+  GST_GL_FRAME_RATE_METHOD_BLEND,
+  GST_GL_FRAME_RATE_METHOD_MOTION
+} GstGLFrameRateMethod;
+
+/* the current frame and the one before it */
+#define GST_GL_FRAME_RATE_HISTORY 2
+
+struct _GstGLFrameRate
+{
+  GstGLFilter  filter;
+
+  /* properties */
+  GstGLFrameRateMethod method;
+  guint         block_size;
+  guint         search_range;
+
+  /* the last input frames */
+  GstGLHistory *history;
+
+  GstGLShader  *blend_shader;
+  GstGLShader  *motion_shader;
+  GstGLShader  *interp_shader;
+
+  /* one motion vector per block, from the previous frame to the current
+   * one, with the mean difference of the match */
+  GLuint        vector_tex;
+  GLuint        vector_fbo;
+  GLuint        vector_depthbuffer;
+  guint         vector_width;
+  guint         vector_height;
+  guint         vector_block_size;
+  gboolean      vectors_valid;
+
+  /* output timeline, out_count frames since base_ts */
+  GstClockTime  base_ts;
+  guint64       out_count;
+
+  /* timestamp of the input frame being processed */
+  GstClockTime  in_ts;
+
+  /* position of the frame being rendered between the previous input, 0.0,
+   * and the current one, 1.0 */
+  gfloat        phase;
+};
+
+struct _GstGLFrameRateClass
+{
+  GstGLFilterClass filter_class;
+};
+
+GType gst_gl_frame_rate_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_GL_FRAME_RATE_H_ */
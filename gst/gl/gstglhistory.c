@@ -0,0 +1,210 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The last input frames of the filters that look back in time, shared by
+ * the deinterlacer and the frame rate converter.  The input and output of
+ * the filter must have the same size. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstglhistory.h"
+
+#define GST_CAT_DEFAULT gst_gl_history_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+/* *INDENT-OFF* */
+static const gchar *history_vertex_source =
+  "attribute vec4 a_position;\n"
+  "attribute vec2 a_texcoord;\n"
+  "varying vec2 v_texcoord;\n"
+  "void main()\n"
+  "{\n"
+  "   gl_Position = a_position;\n"
+  "   v_texcoord = a_texcoord;\n"
+  "}\n";
+
+static const gchar *copy_fragment_source =
+  "#ifdef GL_ES\n"
+  "precision mediump float;\n"
+  "#endif\n"
+  "varying vec2 v_texcoord;\n"
+  "uniform sampler2D tex;\n"
+  "void main () {\n"
+  "  gl_FragColor = texture2D(tex, v_texcoord);\n"
+  "}\n";
+/* *INDENT-ON* */
+
+GstGLHistory *
+gst_gl_history_new (GstGLFilter * filter, guint size)
+{
+  GstGLHistory *history;
+  static gsize debug_init = 0;
+
+  g_return_val_if_fail (size > 0 && size <= GST_GL_HISTORY_MAX_SIZE, NULL);
+
+  if (g_once_init_enter (&debug_init)) {
+    GST_DEBUG_CATEGORY_INIT (gst_gl_history_debug, "glhistory", 0,
+        "OpenGL frame history");
+    g_once_init_leave (&debug_init, 1);
+  }
+
+  history = g_new0 (GstGLHistory, 1);
+  history->filter = filter;
+  history->size = size;
+
+  return history;
+}
+
+void
+gst_gl_history_free (GstGLHistory * history)
+{
+  g_free (history);
+}
+
+gboolean
+gst_gl_history_init_gl (GstGLHistory * history)
+{
+  GstGLFilter *filter = history->filter;
+  guint i;
+
+  for (i = 0; i < history->size; i++) {
+    //blocking call, generate a texture
+    if (!history->textures[i])
+      gst_gl_context_gen_texture_full (filter->context, &history->textures[i],
+          GL_RGBA8, GST_VIDEO_INFO_WIDTH (&filter->in_info),
+          GST_VIDEO_INFO_HEIGHT (&filter->in_info), 1);
+  }
+  history->len = 0;
+
+  //blocking call, wait the opengl thread has compiled the shader
+  if (!history->copy_shader
+      && !gst_gl_context_gen_shader (filter->context, history_vertex_source,
+          copy_fragment_source, &history->copy_shader))
+    return FALSE;
+
+  return TRUE;
+}
+
+void
+gst_gl_history_reset_gl (GstGLHistory * history)
+{
+  GstGLFilter *filter = history->filter;
+  guint i;
+
+  for (i = 0; i < history->size; i++) {
+    if (history->textures[i])
+      gst_gl_context_del_texture (filter->context, &history->textures[i]);
+    history->textures[i] = 0;
+  }
+  history->len = 0;
+
+  //blocking call, wait the opengl thread has destroyed the shader
+  if (history->copy_shader)
+    gst_gl_context_del_shader (filter->context, history->copy_shader);
+  history->copy_shader = NULL;
+}
+
+void
+gst_gl_history_flush (GstGLHistory * history)
+{
+  history->len = 0;
+}
+
+/* draws @texture over the whole target, from a callback of
+ * gst_gl_filter_render_to_target() */
+void
+gst_gl_history_draw_copy (GstGLHistory * history, GLuint texture)
+{
+  GstGLFilter *filter = history->filter;
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  GstGLShader *shader = history->copy_shader;
+
+  gst_gl_shader_use (shader);
+
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, texture);
+  gst_gl_shader_set_uniform_1i (shader, "tex", 0);
+
+  gst_gl_context_bind_geometry (filter->context, GST_GL_GEOMETRY_QUAD,
+      gst_gl_shader_get_attribute_location (shader, "a_position"),
+      gst_gl_shader_get_attribute_location (shader, "a_texcoord"));
+  gst_gl_context_draw_geometry (filter->context, 0, 1);
+  gst_gl_context_unbind_geometry (filter->context);
+
+  gst_gl_context_clear_shader (filter->context);
+}
+
+static void
+_copy_callback (gint width, gint height, guint texture, gpointer stuff)
+{
+  gst_gl_history_draw_copy ((GstGLHistory *) stuff, texture);
+}
+
+void
+gst_gl_history_push (GstGLHistory * history, guint in_tex,
+    GstClockTime timestamp)
+{
+  GstGLFilter *filter = history->filter;
+  guint i;
+
+  history->current = (history->current + 1) % history->size;
+
+  //blocking call, use a FBO
+  gst_gl_filter_render_to_target (filter, FALSE, in_tex,
+      history->textures[history->current], _copy_callback, history);
+  history->timestamps[history->current] = timestamp;
+
+  /* after a discontinuity the whole history is the first frame */
+  if (history->len == 0) {
+    for (i = 0; i < history->size; i++) {
+      if (i == history->current)
+        continue;
+
+      gst_gl_filter_render_to_target (filter, FALSE, in_tex,
+          history->textures[i], _copy_callback, history);
+      history->timestamps[i] = timestamp;
+    }
+  }
+
+  history->len = MIN (history->len + 1, history->size);
+
+  GST_TRACE ("pushed texture %u at %" GST_TIME_FORMAT ", %u frames", in_tex,
+      GST_TIME_ARGS (timestamp), history->len);
+}
+
+GLuint
+gst_gl_history_get (GstGLHistory * history, guint age)
+{
+  g_return_val_if_fail (age < history->size, 0);
+
+  return history->textures[(history->current + history->size - age) %
+      history->size];
+}
+
+GstClockTime
+gst_gl_history_get_timestamp (GstGLHistory * history, guint age)
+{
+  g_return_val_if_fail (age < history->size, GST_CLOCK_TIME_NONE);
+
+  return history->timestamps[(history->current + history->size - age) %
+      history->size];
+}
@@ -0,0 +1,69 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_GL_HISTORY_H__
+#define __GST_GL_HISTORY_H__
+
+#include <gst/gl/gstglfilter.h>
+
+G_BEGIN_DECLS
+
+/* largest number of frames kept */
+#define GST_GL_HISTORY_MAX_SIZE 8
+
+typedef struct _GstGLHistory GstGLHistory;
+
+/* A ring of copies of the last input frames of a filter, in RGBA textures
+ * of the input size.  Age 0 is the newest frame.  After a discontinuity
+ * the first frame pushed fills the whole ring, so every age is valid. */
+struct _GstGLHistory
+{
+  GstGLFilter *filter;
+  guint size;
+
+  GLuint textures[GST_GL_HISTORY_MAX_SIZE];
+  GstClockTime timestamps[GST_GL_HISTORY_MAX_SIZE];
+  guint current;
+
+  /* frames pushed since the last flush, up to size */
+  guint len;
+
+  GstGLShader *copy_shader;
+};
+
+GstGLHistory * gst_gl_history_new       (GstGLFilter * filter, guint size);
+void           gst_gl_history_free      (GstGLHistory * history);
+
+gboolean       gst_gl_history_init_gl   (GstGLHistory * history);
+void           gst_gl_history_reset_gl  (GstGLHistory * history);
+
+void           gst_gl_history_flush     (GstGLHistory * history);
+void           gst_gl_history_push      (GstGLHistory * history,
+                                         guint in_tex, GstClockTime timestamp);
+GLuint         gst_gl_history_get       (GstGLHistory * history, guint age);
+GstClockTime   gst_gl_history_get_timestamp (GstGLHistory * history,
+                                             guint age);
+
+void           gst_gl_history_draw_copy (GstGLHistory * history,
+                                         GLuint texture);
+
+G_END_DECLS
+
+#endif /* __GST_GL_HISTORY_H__ */
@@ -51,6 +51,33 @@
  * </para>
  * </refsect2>
  * <refsect2>
+ * <title>Frame pacing</title>
+ * <para>
+ * glimagesink follows every frame until the output presents it, using the
+ * vertical blank and swap counters of GLX_OML_sync_control or
+ * EGL_CHROMIUM_sync_control.  Without them, for example with a headless
+ * test setup, or when their vertical blank times are not on the monotonic
+ * clock, the time the frame was drawn is taken instead.  When
+ * #GstGLImageSink:frame-pacing is enabled the render delay is set once
+ * from the time the first frames took from render to present, so that
+ * frames appear at their running time, and frames that would only appear
+ * after their end are skipped.  The difference between the time frames
+ * were presented at and their running time is reported upstream with QoS
+ * events.
+ * </para>
+ * <para>
+ * Every #GstGLImageSink:stats-interval milliseconds, an element message
+ * named "GstGLImageSinkStats" is posted with the #guint fields
+ * "displayed", "dropped" and "late" counting the frames of the interval,
+ * the #GstClockTime "interval" and "present-latency", the #gint64 "jitter-mean"
+ * and "jitter-max" in nanoseconds, the #GstValueArray of #guint
+ * "jitter-histogram" counting the frames by present jitter in bins of
+ * "jitter-bin-width" nanoseconds centered on 0, the outer bins taking
+ * everything beyond, and the #gboolean "sync-control" telling whether the
+ * present times came from the output.
+ * </para>
+ * </refsect2>
+ * <refsect2>
  * <title>Examples</title>
  * |[
  * gst-launch -v videotestsrc ! "video/x-raw-rgb" ! glimagesink
@@ -83,6 +110,8 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include <gst/video/videooverlay.h>
 
 #include "gstglimagesink.h"
@@ -106,11 +135,14 @@ GST_DEBUG_CATEGORY (gst_debug_glimage_sink);
 #if GST_GL_HAVE_GLES2
 static void gst_glimage_sink_thread_init_redisplay (GstGLImageSink * gl_sink);
 #endif
+static void gst_glimage_sink_thread_init_yuv_redisplay (GstGLImageSink *
+    gl_sink);
 static void gst_glimage_sink_on_close (GstGLImageSink * gl_sink);
-static void gst_glimage_sink_on_resize (const GstGLImageSink * gl_sink,
+static void gst_glimage_sink_on_resize (GstGLImageSink * gl_sink,
     gint width, gint height);
-static void gst_glimage_sink_on_draw (const GstGLImageSink * gl_sink);
+static void gst_glimage_sink_on_draw (GstGLImageSink * gl_sink);
 static gboolean gst_glimage_sink_redisplay (GstGLImageSink * gl_sink);
+static void _reset_pacing (GstGLImageSink * gl_sink);
 
 static void gst_glimage_sink_finalize (GObject * object);
 static void gst_glimage_sink_set_property (GObject * object, guint prop_id,
@@ -130,6 +162,8 @@ gst_glimage_sink_change_state (GstElement * element, GstStateChange transition);
 static void gst_glimage_sink_get_times (GstBaseSink * bsink, GstBuffer * buf,
     GstClockTime * start, GstClockTime * end);
 static gboolean gst_glimage_sink_set_caps (GstBaseSink * bsink, GstCaps * caps);
+static GstFlowReturn gst_glimage_sink_preroll (GstBaseSink * bsink,
+    GstBuffer * buf);
 static GstFlowReturn gst_glimage_sink_render (GstBaseSink * bsink,
     GstBuffer * buf);
 static gboolean gst_glimage_sink_propose_allocation (GstBaseSink * bsink,
@@ -142,18 +176,66 @@ static void gst_glimage_sink_set_window_handle (GstVideoOverlay * overlay,
 static void gst_glimage_sink_expose (GstVideoOverlay * overlay);
 
 
-#if GST_GL_HAVE_GLES2
 /* *INDENT-OFF* */
+/* also used by the YUV shaders on desktop GL */
 static const gchar *redisplay_vertex_shader_str_gles2 =
       "attribute vec4 a_position;   \n"
       "attribute vec2 a_texCoord;   \n"
+      "uniform vec4 u_texRect;      \n"
       "varying vec2 v_texCoord;     \n"
       "void main()                  \n"
       "{                            \n"
       "   gl_Position = a_position; \n"
-      "   v_texCoord = a_texCoord;  \n"
+      "   v_texCoord = u_texRect.xy + a_texCoord * u_texRect.zw;\n"
       "}                            \n";
 
+/* matrix and range of the colorimetry of the caps */
+#define YUV_TO_RGB_COEFFICIENTS \
+      "uniform vec3 offset;\n" \
+      "uniform vec3 rcoeff;\n" \
+      "uniform vec3 gcoeff;\n" \
+      "uniform vec3 bcoeff;\n"
+
+/* one GL_R8 texture per plane */
+static const gchar *redisplay_planar_yuv_fragment_shader_str =
+      "#ifdef GL_ES\n"
+      "precision mediump float;\n"
+      "#endif\n"
+      "varying vec2 v_texCoord;\n"
+      "uniform sampler2D Ytex, Utex, Vtex;\n"
+      YUV_TO_RGB_COEFFICIENTS
+      "void main()\n"
+      "{\n"
+      "  vec3 yuv;\n"
+      "  yuv.x = texture2D(Ytex, v_texCoord).r;\n"
+      "  yuv.y = texture2D(Utex, v_texCoord).r;\n"
+      "  yuv.z = texture2D(Vtex, v_texCoord).r;\n"
+      "  yuv += offset;\n"
+      "  gl_FragColor = vec4(dot(yuv, rcoeff), dot(yuv, gcoeff),\n"
+      "      dot(yuv, bcoeff), 1.0);\n"
+      "}\n";
+
+/* GL_R8 luma and GL_RG8 (or GL_LUMINANCE_ALPHA) chroma textures */
+static const gchar *redisplay_nv12_nv21_fragment_shader_str =
+      "#ifdef GL_ES\n"
+      "precision mediump float;\n"
+      "#endif\n"
+      "varying vec2 v_texCoord;\n"
+      "uniform sampler2D Ytex, UVtex;\n"
+      YUV_TO_RGB_COEFFICIENTS
+      "void main()\n"
+      "{\n"
+      "  vec3 yuv;\n"
+      "  yuv.x = texture2D(Ytex, v_texCoord).r;\n"
+      "  yuv.yz = texture2D(UVtex, v_texCoord).%c%c;\n"
+      "  yuv += offset;\n"
+      "  gl_FragColor = vec4(dot(yuv, rcoeff), dot(yuv, gcoeff),\n"
+      "      dot(yuv, bcoeff), 1.0);\n"
+      "}\n";
+/* *INDENT-ON* */
+
+#if GST_GL_HAVE_GLES2
+/* *INDENT-OFF* */
 static const gchar *redisplay_fragment_shader_str_gles2 =
       "precision mediump float;                            \n"
       "varying vec2 v_texCoord;                            \n"
@@ -184,9 +266,21 @@ enum
   PROP_CLIENT_DATA,
   PROP_FORCE_ASPECT_RATIO,
   PROP_PIXEL_ASPECT_RATIO,
-  PROP_OTHER_CONTEXT
+  PROP_OTHER_CONTEXT,
+  PROP_FRAME_PACING,
+  PROP_STATS_INTERVAL
 };
 
+#define DEFAULT_FRAME_PACING TRUE
+#define DEFAULT_STATS_INTERVAL 1000
+
+/* width of the bins of the present jitter histogram */
+#define JITTER_BIN_WIDTH (2 * GST_MSECOND)
+/* largest number of frames waiting to be presented or accounted */
+#define MAX_PENDING_FRAMES 8
+/* number of presented frames the render delay is estimated from */
+#define RENDER_DELAY_FRAMES 30
+
 #define gst_glimage_sink_parent_class parent_class
 G_DEFINE_TYPE_WITH_CODE (GstGLImageSink, gst_glimage_sink,
     GST_TYPE_VIDEO_SINK, G_IMPLEMENT_INTERFACE (GST_TYPE_VIDEO_OVERLAY,
@@ -251,6 +345,18 @@ gst_glimage_sink_class_init (GstGLImageSinkClass * klass)
           "Give an external OpenGL context with which to share textures",
           GST_GL_TYPE_CONTEXT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_FRAME_PACING,
+      g_param_spec_boolean ("frame-pacing", "Frame pacing",
+          "Render early by the time frames take to be presented and skip "
+          "frames that would be presented after their end",
+          DEFAULT_FRAME_PACING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STATS_INTERVAL,
+      g_param_spec_uint ("stats-interval", "Statistics interval",
+          "Interval in milliseconds between the presentation statistics "
+          "messages, 0 disables them", 0, G_MAXUINT, DEFAULT_STATS_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&gst_glimage_sink_template));
 
@@ -261,7 +367,7 @@ gst_glimage_sink_class_init (GstGLImageSinkClass * klass)
   gstbasesink_class->query = GST_DEBUG_FUNCPTR (gst_glimage_sink_query);
   gstbasesink_class->set_caps = gst_glimage_sink_set_caps;
   gstbasesink_class->get_times = gst_glimage_sink_get_times;
-  gstbasesink_class->preroll = gst_glimage_sink_render;
+  gstbasesink_class->preroll = gst_glimage_sink_preroll;
   gstbasesink_class->render = gst_glimage_sink_render;
   gstbasesink_class->propose_allocation = gst_glimage_sink_propose_allocation;
   gstbasesink_class->stop = gst_glimage_sink_stop;
@@ -282,6 +388,19 @@ gst_glimage_sink_init (GstGLImageSink * glimage_sink)
   glimage_sink->par_d = 1;
   glimage_sink->pool = NULL;
   glimage_sink->redisplay_texture = 0;
+  glimage_sink->stored_buffer = NULL;
+  glimage_sink->redisplay_n_planes = 0;
+  glimage_sink->yuv_shader = NULL;
+  glimage_sink->yuv_shader_format = GST_VIDEO_FORMAT_UNKNOWN;
+  glimage_sink->redisplay_crop[0] = glimage_sink->redisplay_crop[1] = 0.0f;
+  glimage_sink->redisplay_crop[2] = glimage_sink->redisplay_crop[3] = 1.0f;
+  glimage_sink->force_redisplay = TRUE;
+  glimage_sink->content_changed = TRUE;
+  glimage_sink->buffer_history = 0;
+  glimage_sink->frame_pacing = DEFAULT_FRAME_PACING;
+  glimage_sink->stats_interval = DEFAULT_STATS_INTERVAL;
+  g_queue_init (&glimage_sink->drawn_frames);
+  g_queue_init (&glimage_sink->presented_frames);
 
   g_mutex_init (&glimage_sink->drawing_lock);
 }
@@ -336,6 +455,20 @@ gst_glimage_sink_set_property (GObject * object, guint prop_id,
       glimage_sink->other_context = g_value_dup_object (value);
       break;
     }
+    case PROP_FRAME_PACING:
+    {
+      GST_GLIMAGE_SINK_LOCK (glimage_sink);
+      glimage_sink->frame_pacing = g_value_get_boolean (value);
+      GST_GLIMAGE_SINK_UNLOCK (glimage_sink);
+      break;
+    }
+    case PROP_STATS_INTERVAL:
+    {
+      GST_GLIMAGE_SINK_LOCK (glimage_sink);
+      glimage_sink->stats_interval = g_value_get_uint (value);
+      GST_GLIMAGE_SINK_UNLOCK (glimage_sink);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -381,6 +514,12 @@ gst_glimage_sink_get_property (GObject * object, guint prop_id,
     case PROP_OTHER_CONTEXT:
       g_value_set_object (value, glimage_sink->other_context);
       break;
+    case PROP_FRAME_PACING:
+      g_value_set_boolean (value, glimage_sink->frame_pacing);
+      break;
+    case PROP_STATS_INTERVAL:
+      g_value_set_uint (value, glimage_sink->stats_interval);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -455,6 +594,11 @@ gst_glimage_sink_cleanup_glthread (GstGLImageSink * gl_sink)
     gl_sink->redisplay_shader = NULL;
   }
 #endif
+
+  if (gl_sink->yuv_shader) {
+    gst_object_unref (gl_sink->yuv_shader);
+    gl_sink->yuv_shader = NULL;
+  }
 }
 
 /*
@@ -497,6 +641,9 @@ gst_glimage_sink_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       g_atomic_int_set (&glimage_sink->to_quit, 0);
+      GST_GLIMAGE_SINK_LOCK (glimage_sink);
+      _reset_pacing (glimage_sink);
+      GST_GLIMAGE_SINK_UNLOCK (glimage_sink);
       if (!glimage_sink->display) {
         GstGLWindow *window;
         GError *error = NULL;
@@ -565,6 +712,9 @@ gst_glimage_sink_change_state (GstElement * element, GstStateChange transition)
        */
       GST_GLIMAGE_SINK_LOCK (glimage_sink);
       glimage_sink->redisplay_texture = 0;
+      glimage_sink->redisplay_n_planes = 0;
+      gst_buffer_replace (&glimage_sink->stored_buffer, NULL);
+      _reset_pacing (glimage_sink);
       GST_GLIMAGE_SINK_UNLOCK (glimage_sink);
 
       if (glimage_sink->upload) {
@@ -715,6 +865,8 @@ gst_glimage_sink_set_caps (GstBaseSink * bsink, GstCaps * caps)
   newpool = gst_gl_buffer_pool_new (glimage_sink->context);
   structure = gst_buffer_pool_get_config (newpool);
   gst_buffer_pool_config_set_params (structure, caps, vinfo.size, 2, 0);
+  gst_buffer_pool_config_add_option (structure,
+      GST_BUFFER_POOL_OPTION_GL_PLANAR);
   gst_buffer_pool_set_config (newpool, structure);
 
   oldpool = glimage_sink->pool;
@@ -723,6 +875,8 @@ gst_glimage_sink_set_caps (GstBaseSink * bsink, GstCaps * caps)
    * activate it when we render into it */
   glimage_sink->pool = newpool;
 
+  glimage_sink->force_redisplay = TRUE;
+
   /* unref the old sink */
   if (oldpool) {
     /* we don't deactivate, some elements might still be using it, it will
@@ -733,11 +887,476 @@ gst_glimage_sink_set_caps (GstBaseSink * bsink, GstCaps * caps)
   return TRUE;
 }
 
+/* retrieves the textures of a buffer from a planar #GstGLBufferPool of our
+ * context, uploading the planes that were written to */
+static gboolean
+_get_plane_textures (GstGLImageSink * glimage_sink, GstBuffer * buf,
+    GLuint * textures)
+{
+  guint i, n_planes = GST_VIDEO_INFO_N_PLANES (&glimage_sink->info);
+  GstMemory *mem;
+  GstMapInfo map;
+
+  /* the client draw callback only takes a single RGBA texture */
+  if (glimage_sink->clientDrawCallback
+      || gst_buffer_n_memory (buf) != n_planes)
+    return FALSE;
+
+  for (i = 0; i < n_planes; i++) {
+    mem = gst_buffer_peek_memory (buf, i);
+    if (!gst_is_gl_memory (mem) || ((GstGLMemory *) mem)->plane != i
+        || ((GstGLMemory *) mem)->context != glimage_sink->context)
+      return FALSE;
+  }
+
+  for (i = 0; i < n_planes; i++) {
+    mem = gst_buffer_peek_memory (buf, i);
+    if (!gst_memory_map (mem, &map, GST_MAP_READ | GST_MAP_GL))
+      return FALSE;
+    textures[i] = *(GLuint *) map.data;
+    gst_memory_unmap (mem, &map);
+    /* upstream may have rendered into our pool from its context */
+    gst_gl_memory_wait_sync ((GstGLMemory *) mem, glimage_sink->context);
+  }
+
+  return TRUE;
+}
+
+/* retrieves the texture of a #GstGLMemory of our context so that its crop
+ * is applied while drawing instead of by another draw in the upload */
+static gboolean
+_get_texture (GstGLImageSink * glimage_sink, GstBuffer * buf,
+    GLuint * texture)
+{
+  GstMemory *mem;
+  GstMapInfo map;
+
+  if (glimage_sink->clientDrawCallback || gst_buffer_n_memory (buf) != 1)
+    return FALSE;
+
+  mem = gst_buffer_peek_memory (buf, 0);
+  if (!gst_is_gl_memory (mem) || GST_GL_MEMORY_IS_PLANE (mem)
+      || ((GstGLMemory *) mem)->atlas
+      || ((GstGLMemory *) mem)->context != glimage_sink->context)
+    return FALSE;
+
+  if (!gst_memory_map (mem, &map, GST_MAP_READ | GST_MAP_GL))
+    return FALSE;
+  *texture = *(GLuint *) map.data;
+  gst_memory_unmap (mem, &map);
+  gst_gl_memory_wait_sync ((GstGLMemory *) mem, glimage_sink->context);
+
+  return TRUE;
+}
+
+static gboolean
+_crop_meta_equal (GstBuffer * buf1, GstBuffer * buf2)
+{
+  GstVideoCropMeta *meta1 = gst_buffer_get_video_crop_meta (buf1);
+  GstVideoCropMeta *meta2 = gst_buffer_get_video_crop_meta (buf2);
+
+  if (!meta1 || !meta2)
+    return meta1 == meta2;
+
+  return meta1->x == meta2->x && meta1->y == meta2->y
+      && meta1->width == meta2->width && meta1->height == meta2->height;
+}
+
+static void
+_free_frame (GstGLImageSinkFrame * frame)
+{
+  g_slice_free (GstGLImageSinkFrame, frame);
+}
+
+/* with the lock */
+static void
+_reset_pacing (GstGLImageSink * gl_sink)
+{
+  g_queue_foreach (&gl_sink->drawn_frames, (GFunc) _free_frame, NULL);
+  g_queue_clear (&gl_sink->drawn_frames);
+  g_queue_foreach (&gl_sink->presented_frames, (GFunc) _free_frame, NULL);
+  g_queue_clear (&gl_sink->presented_frames);
+
+  gl_sink->have_sync_values = TRUE;
+  gl_sink->render_delay_set = FALSE;
+  gl_sink->have_next_frame = FALSE;
+  gl_sink->dropped_last = FALSE;
+  gl_sink->msc_ust = gl_sink->msc_count = 0;
+  gl_sink->msc_period = 0;
+  gl_sink->present_latency = 0;
+  gl_sink->n_latencies = 0;
+  gl_sink->qos_proportion = 1.0;
+
+  gl_sink->stats_start = g_get_monotonic_time ();
+  gl_sink->stats_displayed = gl_sink->stats_dropped = gl_sink->stats_late = 0;
+  memset (gl_sink->stats_jitter, 0, sizeof (gl_sink->stats_jitter));
+  gl_sink->stats_jitter_sum = gl_sink->stats_jitter_max = 0;
+}
+
+/* with the lock */
+static void
+_push_presented (GstGLImageSink * gl_sink, GstGLImageSinkFrame * frame)
+{
+  g_queue_push_tail (&gl_sink->presented_frames, frame);
+
+  /* nobody renders, nobody accounts */
+  while (g_queue_get_length (&gl_sink->presented_frames) > MAX_PENDING_FRAMES)
+    _free_frame (g_queue_pop_head (&gl_sink->presented_frames));
+}
+
+/* Called in the gl thread.  The sync control extensions do not say which
+ * clock the vertical blank times count, the pacing compares them with
+ * g_get_monotonic_time() so a time more than a second away is taken for
+ * another clock and the sync values are not used. */
+static gboolean
+_get_sync_values (GstGLImageSink * gl_sink, gint64 * ust, gint64 * msc,
+    gint64 * sbc)
+{
+  gint64 now;
+
+  if (!gst_gl_context_get_sync_values (gl_sink->context, ust, msc, sbc))
+    return FALSE;
+
+  now = g_get_monotonic_time ();
+  if (ABS (now - *ust) > G_USEC_PER_SEC) {
+    GST_DEBUG ("vertical blank time %" G_GINT64_FORMAT " is not on the "
+        "monotonic clock (%" G_GINT64_FORMAT ")", *ust, now);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Called in the gl thread with the lock.  A frame is presented at the
+ * first vertical blank after it was drawn at which its swap completed. */
+static void
+_collect_presents (GstGLImageSink * gl_sink)
+{
+  GstGLImageSinkFrame *frame;
+  gint64 ust, msc, sbc;
+
+  if (!gl_sink->have_sync_values)
+    return;
+
+  if (!_get_sync_values (gl_sink, &ust, &msc, &sbc)) {
+    GST_DEBUG ("no present feedback from the output, using draw times");
+    gl_sink->have_sync_values = FALSE;
+
+    while ((frame = g_queue_pop_head (&gl_sink->drawn_frames))) {
+      frame->present_time = g_get_monotonic_time ();
+      _push_presented (gl_sink, frame);
+    }
+    return;
+  }
+
+  if (gl_sink->msc_count > 0 && msc > gl_sink->msc_count) {
+    gint64 period = (ust - gl_sink->msc_ust) / (msc - gl_sink->msc_count);
+
+    if (gl_sink->msc_period > 0)
+      gl_sink->msc_period = (7 * gl_sink->msc_period + period) / 8;
+    else
+      gl_sink->msc_period = period;
+  }
+  gl_sink->msc_ust = ust;
+  gl_sink->msc_count = msc;
+
+  while ((frame = g_queue_peek_head (&gl_sink->drawn_frames))
+      && sbc > frame->sbc) {
+    g_queue_pop_head (&gl_sink->drawn_frames);
+
+    frame->present_time =
+        ust - MAX (msc - frame->msc - 1, 0) * gl_sink->msc_period;
+    _push_presented (gl_sink, frame);
+  }
+}
+
+static void
+_collect_presents_cb (GstGLImageSink * gl_sink)
+{
+  GST_GLIMAGE_SINK_LOCK (gl_sink);
+  _collect_presents (gl_sink);
+  GST_GLIMAGE_SINK_UNLOCK (gl_sink);
+}
+
+/* Called in the gl thread with the lock, when next_frame is drawn */
+static void
+_frame_drawn (GstGLImageSink * gl_sink)
+{
+  GstGLImageSinkFrame *frame;
+
+  frame = g_slice_dup (GstGLImageSinkFrame, &gl_sink->next_frame);
+  gl_sink->have_next_frame = FALSE;
+
+  if (gl_sink->have_sync_values
+      && _get_sync_values (gl_sink, &frame->present_time, &frame->msc,
+          &frame->sbc)) {
+    g_queue_push_tail (&gl_sink->drawn_frames, frame);
+
+    /* swaps that never complete, the window is hidden */
+    while (g_queue_get_length (&gl_sink->drawn_frames) > MAX_PENDING_FRAMES)
+      _free_frame (g_queue_pop_head (&gl_sink->drawn_frames));
+  } else {
+    frame->present_time = g_get_monotonic_time ();
+    _push_presented (gl_sink, frame);
+  }
+}
+
+/* Fills @frame with the times of @buf, FALSE when it is not synchronized
+ * to the clock */
+static gboolean
+_get_frame_times (GstGLImageSink * gl_sink, GstBuffer * buf,
+    GstGLImageSinkFrame * frame)
+{
+  GstBaseSink *bsink = GST_BASE_SINK (gl_sink);
+  GstClock *clock;
+  GstClockTime now, base_time;
+
+  if (!GST_BUFFER_TIMESTAMP_IS_VALID (buf))
+    return FALSE;
+
+  if (!(clock = gst_element_get_clock (GST_ELEMENT (gl_sink))))
+    return FALSE;
+
+  now = gst_clock_get_time (clock);
+  frame->render_time = g_get_monotonic_time ();
+  base_time = gst_element_get_base_time (GST_ELEMENT (gl_sink));
+  gst_object_unref (clock);
+
+  frame->clock_offset = (GstClockTimeDiff) (now - base_time)
+      - frame->render_time * GST_USECOND;
+
+  GST_OBJECT_LOCK (bsink);
+  frame->running_time = gst_segment_to_running_time (&bsink->segment,
+      GST_FORMAT_TIME, GST_BUFFER_TIMESTAMP (buf));
+  GST_OBJECT_UNLOCK (bsink);
+
+  if (GST_BUFFER_DURATION_IS_VALID (buf))
+    frame->duration = GST_BUFFER_DURATION (buf);
+  else if (GST_VIDEO_INFO_FPS_N (&gl_sink->info) > 0)
+    frame->duration = gst_util_uint64_scale_int (GST_SECOND,
+        GST_VIDEO_INFO_FPS_D (&gl_sink->info),
+        GST_VIDEO_INFO_FPS_N (&gl_sink->info));
+  else
+    frame->duration = GST_CLOCK_TIME_NONE;
+
+  return GST_CLOCK_TIME_IS_VALID (frame->running_time);
+}
+
+/* with the lock, returns the message to post */
+static GstMessage *
+_make_stats_message (GstGLImageSink * gl_sink, gint64 now)
+{
+  GstStructure *s;
+  GValue histogram = G_VALUE_INIT;
+  GValue v = G_VALUE_INIT;
+  gint64 mean = 0;
+  guint i;
+
+  if (gl_sink->stats_displayed > 0)
+    mean = gl_sink->stats_jitter_sum / (gint64) gl_sink->stats_displayed;
+
+  s = gst_structure_new ("GstGLImageSinkStats",
+      "interval", G_TYPE_UINT64, (guint64) (now - gl_sink->stats_start)
+      * GST_USECOND,
+      "displayed", G_TYPE_UINT, gl_sink->stats_displayed,
+      "dropped", G_TYPE_UINT, gl_sink->stats_dropped,
+      "late", G_TYPE_UINT, gl_sink->stats_late,
+      "present-latency", G_TYPE_UINT64,
+      (guint64) gl_sink->present_latency * GST_USECOND,
+      "jitter-mean", G_TYPE_INT64, mean,
+      "jitter-max", G_TYPE_INT64, (gint64) gl_sink->stats_jitter_max,
+      "jitter-bin-width", G_TYPE_UINT64, (guint64) JITTER_BIN_WIDTH,
+      "sync-control", G_TYPE_BOOLEAN, gl_sink->have_sync_values, NULL);
+
+  g_value_init (&histogram, GST_TYPE_ARRAY);
+  g_value_init (&v, G_TYPE_UINT);
+  for (i = 0; i < GST_GLIMAGE_SINK_JITTER_BINS; i++) {
+    g_value_set_uint (&v, gl_sink->stats_jitter[i]);
+    gst_value_array_append_value (&histogram, &v);
+  }
+  g_value_unset (&v);
+  gst_structure_take_value (s, "jitter-histogram", &histogram);
+
+  gl_sink->stats_start = now;
+  gl_sink->stats_displayed = gl_sink->stats_dropped = gl_sink->stats_late = 0;
+  memset (gl_sink->stats_jitter, 0, sizeof (gl_sink->stats_jitter));
+  gl_sink->stats_jitter_sum = gl_sink->stats_jitter_max = 0;
+
+  return gst_message_new_element (GST_OBJECT (gl_sink), s);
+}
+
+/* Accounts the frames presented since the last render: statistics, QoS
+ * and render delay */
+static void
+_account_presents (GstGLImageSink * gl_sink)
+{
+  GstBaseSink *bsink = GST_BASE_SINK (gl_sink);
+  GstGLImageSinkFrame *frame;
+  GstGLWindow *window;
+  GstMessage *message = NULL;
+  GstEvent *qos = NULL;
+  GstClockTime render_delay = GST_CLOCK_TIME_NONE;
+  gint64 now;
+
+  window = gst_gl_context_get_window (gl_sink->context);
+  if (gl_sink->have_sync_values && gst_gl_window_is_running (window))
+    gst_gl_window_send_message (window,
+        GST_GL_WINDOW_CB (_collect_presents_cb), gl_sink);
+  gst_object_unref (window);
+
+  GST_GLIMAGE_SINK_LOCK (gl_sink);
+
+  while ((frame = g_queue_pop_head (&gl_sink->presented_frames))) {
+    GstClockTimeDiff jitter;
+    GstClockTime late_threshold;
+    gint64 latency, bin;
+
+    jitter = frame->present_time * GST_USECOND + frame->clock_offset
+        - (GstClockTimeDiff) frame->running_time;
+
+    latency = frame->present_time - frame->render_time;
+    if (gl_sink->present_latency > 0)
+      gl_sink->present_latency = (7 * gl_sink->present_latency + latency) / 8;
+    else
+      gl_sink->present_latency = MAX (latency, 1);
+    gl_sink->n_latencies++;
+
+    gl_sink->stats_displayed++;
+    gl_sink->stats_jitter_sum += jitter;
+    gl_sink->stats_jitter_max = MAX (gl_sink->stats_jitter_max, jitter);
+
+    bin = (jitter + (GST_GLIMAGE_SINK_JITTER_BINS / 2) * JITTER_BIN_WIDTH)
+        / (gint64) JITTER_BIN_WIDTH;
+    gl_sink->stats_jitter[CLAMP (bin, 0, GST_GLIMAGE_SINK_JITTER_BINS - 1)]++;
+
+    /* late once the next frame is due */
+    if (GST_CLOCK_TIME_IS_VALID (frame->duration))
+      late_threshold = frame->duration / 2;
+    else
+      late_threshold = 10 * GST_MSECOND;
+
+    if (jitter > (GstClockTimeDiff) late_threshold)
+      gl_sink->stats_late++;
+
+    /* like basesink, the rate is how long the frame took over its
+     * duration, smoothed so that a single late present doesn't make
+     * upstream drop frames */
+    if (GST_CLOCK_TIME_IS_VALID (frame->duration) && frame->duration > 0) {
+      gdouble rate = (gdouble) ((GstClockTimeDiff) frame->duration + jitter)
+          / frame->duration;
+
+      rate = CLAMP (rate, 0.0, 8.0);
+      gl_sink->qos_proportion = (3.0 * gl_sink->qos_proportion + rate) / 4.0;
+    }
+
+    /* only the last present is reported, once per render.  An early
+     * present can't be before the start of the segment */
+    if (qos)
+      gst_event_unref (qos);
+    qos = gst_event_new_qos (jitter > (GstClockTimeDiff) late_threshold ?
+        GST_QOS_TYPE_UNDERFLOW : GST_QOS_TYPE_OVERFLOW,
+        gl_sink->qos_proportion, MAX (jitter,
+            -(GstClockTimeDiff) frame->running_time), frame->running_time);
+
+    _free_frame (frame);
+  }
+
+  now = g_get_monotonic_time ();
+  if (gl_sink->stats_interval > 0
+      && now - gl_sink->stats_start >=
+      (gint64) gl_sink->stats_interval * 1000)
+    message = _make_stats_message (gl_sink, now);
+
+  /* set once, every change of the render delay changes the latency of the
+   * pipeline */
+  if (gl_sink->frame_pacing && gl_sink->n_latencies >= RENDER_DELAY_FRAMES
+      && !gl_sink->render_delay_set) {
+    render_delay = (gl_sink->present_latency / 1000) * GST_MSECOND;
+    gl_sink->render_delay_set = TRUE;
+  }
+
+  GST_GLIMAGE_SINK_UNLOCK (gl_sink);
+
+  if (qos && gst_base_sink_is_qos_enabled (bsink)) {
+    GST_LOG ("sending QoS upstream: %" GST_PTR_FORMAT, qos);
+    gst_pad_push_event (GST_BASE_SINK_PAD (bsink), qos);
+  } else if (qos) {
+    gst_event_unref (qos);
+  }
+
+  if (message)
+    gst_element_post_message (GST_ELEMENT (gl_sink), message);
+
+  if (GST_CLOCK_TIME_IS_VALID (render_delay)) {
+    GST_DEBUG ("render delay %" GST_TIME_FORMAT, GST_TIME_ARGS (render_delay));
+    gst_base_sink_set_render_delay (bsink, render_delay);
+  }
+}
+
+/* whether @frame would only be presented after its end.  Never skips two
+ * frames in a row, so that the picture keeps moving. */
+static gboolean
+_frame_too_late (GstGLImageSink * gl_sink, const GstGLImageSinkFrame * frame)
+{
+  GstClockTimeDiff present;
+  gboolean too_late = FALSE;
+
+  GST_GLIMAGE_SINK_LOCK (gl_sink);
+
+  if (gl_sink->frame_pacing && !gl_sink->dropped_last
+      && gl_sink->present_latency > 0
+      && GST_CLOCK_TIME_IS_VALID (frame->duration)) {
+    present = (frame->render_time + gl_sink->present_latency) * GST_USECOND
+        + frame->clock_offset;
+    too_late = present > (GstClockTimeDiff) (frame->running_time +
+        frame->duration);
+  }
+
+  if (too_late)
+    gl_sink->stats_dropped++;
+  gl_sink->dropped_last = too_late;
+
+  GST_GLIMAGE_SINK_UNLOCK (gl_sink);
+
+  return too_late;
+}
+
+/* Whether @buf shows exactly what is already displayed.  stored_buffer
+ * shares its memories, so they cannot have been written to since: writing
+ * to a shared memory replaces it with a copy. */
+static gboolean
+_buffer_unchanged (GstGLImageSink * glimage_sink, GstBuffer * buf)
+{
+  GstBuffer *stored = glimage_sink->stored_buffer;
+  guint i, n;
+
+  if (glimage_sink->force_redisplay || !stored)
+    return FALSE;
+
+  n = gst_buffer_n_memory (buf);
+  if (n != gst_buffer_n_memory (stored))
+    return FALSE;
+
+  for (i = 0; i < n; i++) {
+    if (gst_buffer_peek_memory (buf, i) != gst_buffer_peek_memory (stored, i))
+      return FALSE;
+  }
+
+  return _crop_meta_equal (buf, stored);
+}
+
+/* @timed is FALSE for the preroll, which is not synchronized to the
+ * clock */
 static GstFlowReturn
-gst_glimage_sink_render (GstBaseSink * bsink, GstBuffer * buf)
+_render (GstBaseSink * bsink, GstBuffer * buf, gboolean timed)
 {
   GstGLImageSink *glimage_sink;
+  GLuint planes[GST_VIDEO_MAX_PLANES];
+  guint n_planes = 0;
   guint tex_id;
+  gfloat crop[4];
+  gboolean cropped, uploaded = FALSE;
+  GstGLImageSinkFrame frame = { 0, };
 
   GST_TRACE ("rendering buffer:%p", buf);
 
@@ -751,18 +1370,53 @@ gst_glimage_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   if (!_ensure_gl_setup (glimage_sink))
     return GST_FLOW_NOT_NEGOTIATED;
 
-  if (!gst_gl_upload_perform_with_buffer (glimage_sink->upload, buf, &tex_id))
-    goto upload_failed;
-
   if (glimage_sink->window_id != glimage_sink->new_window_id) {
     GstGLWindow *window = gst_gl_context_get_window (glimage_sink->context);
 
     glimage_sink->window_id = glimage_sink->new_window_id;
     gst_gl_window_set_window_handle (window, glimage_sink->window_id);
+    glimage_sink->force_redisplay = TRUE;
 
     gst_object_unref (window);
   }
 
+  /* still content, the window redraws itself when it is exposed or
+   * resized */
+  if (_buffer_unchanged (glimage_sink, buf)
+      && g_atomic_int_get (&glimage_sink->to_quit) == 0) {
+    GST_TRACE ("buffer:%p holds the displayed frame, not redisplaying", buf);
+    return GST_FLOW_OK;
+  }
+
+  if (timed) {
+    _account_presents (glimage_sink);
+
+    timed = _get_frame_times (glimage_sink, buf, &frame);
+    if (timed && _frame_too_late (glimage_sink, &frame)) {
+      GST_DEBUG ("buffer:%p would be presented after its end, skipping", buf);
+      return GST_FLOW_OK;
+    }
+  }
+
+  cropped = gst_gl_get_crop_tex_coords (buf, &glimage_sink->info, crop);
+
+  if (_get_plane_textures (glimage_sink, buf, planes)) {
+    n_planes = GST_VIDEO_INFO_N_PLANES (&glimage_sink->info);
+    tex_id = planes[0];
+    GST_TRACE ("drawing %u planes without conversion", n_planes);
+  } else if (cropped && _get_texture (glimage_sink, buf, &tex_id)) {
+    GST_TRACE ("drawing cropped texture without copying");
+  } else {
+    if (!gst_gl_upload_perform_with_buffer (glimage_sink->upload, buf,
+            &tex_id))
+      goto upload_failed;
+    uploaded = TRUE;
+
+    /* the upload only keeps the cropped area */
+    crop[0] = crop[1] = 0.0f;
+    crop[2] = crop[3] = 1.0f;
+  }
+
   GST_TRACE ("redisplay texture:%u of size:%ux%u, window size:%ux%u", tex_id,
       GST_VIDEO_INFO_WIDTH (&glimage_sink->info),
       GST_VIDEO_INFO_HEIGHT (&glimage_sink->info),
@@ -772,6 +1426,30 @@ gst_glimage_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   /* Avoid to release the texture while drawing */
   GST_GLIMAGE_SINK_LOCK (glimage_sink);
   glimage_sink->redisplay_texture = tex_id;
+  glimage_sink->redisplay_n_planes = n_planes;
+  if (n_planes > 0) {
+    memcpy (glimage_sink->redisplay_planes, planes, sizeof (planes));
+    glimage_sink->redisplay_chroma_format =
+        ((GstGLMemory *) gst_buffer_peek_memory (buf, 1))->gl_format;
+  }
+  memcpy (glimage_sink->redisplay_crop, crop, sizeof (crop));
+  if (cropped) {
+    GstVideoCropMeta *meta = gst_buffer_get_video_crop_meta (buf);
+
+    /* the area drawn stops at the edges of the frame */
+    glimage_sink->crop_width = MIN (meta->width,
+        GST_VIDEO_INFO_WIDTH (&glimage_sink->info) - meta->x);
+    glimage_sink->crop_height = MIN (meta->height,
+        GST_VIDEO_INFO_HEIGHT (&glimage_sink->info) - meta->y);
+  } else {
+    glimage_sink->crop_width = GST_VIDEO_INFO_WIDTH (&glimage_sink->info);
+    glimage_sink->crop_height = GST_VIDEO_INFO_HEIGHT (&glimage_sink->info);
+  }
+  gst_buffer_replace (&glimage_sink->stored_buffer, buf);
+  glimage_sink->content_changed = TRUE;
+  glimage_sink->force_redisplay = FALSE;
+  glimage_sink->next_frame = frame;
+  glimage_sink->have_next_frame = timed;
   GST_GLIMAGE_SINK_UNLOCK (glimage_sink);
 
   /* Ask the underlying window to redraw its content */
@@ -783,17 +1461,20 @@ gst_glimage_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   if (g_atomic_int_get (&glimage_sink->to_quit) != 0) {
     GST_ELEMENT_ERROR (glimage_sink, RESOURCE, NOT_FOUND,
         ("%s", gst_gl_context_get_error ()), (NULL));
-    gst_gl_upload_release_buffer (glimage_sink->upload);
+    if (uploaded)
+      gst_gl_upload_release_buffer (glimage_sink->upload);
     return GST_FLOW_ERROR;
   }
 
-  gst_gl_upload_release_buffer (glimage_sink->upload);
+  if (uploaded)
+    gst_gl_upload_release_buffer (glimage_sink->upload);
   return GST_FLOW_OK;
 
 /* ERRORS */
 redisplay_failed:
   {
-    gst_gl_upload_release_buffer (glimage_sink->upload);
+    if (uploaded)
+      gst_gl_upload_release_buffer (glimage_sink->upload);
     GST_ELEMENT_ERROR (glimage_sink, RESOURCE, NOT_FOUND,
         ("%s", gst_gl_context_get_error ()), (NULL));
     return GST_FLOW_ERROR;
@@ -807,6 +1488,18 @@ upload_failed:
   }
 }
 
+static GstFlowReturn
+gst_glimage_sink_preroll (GstBaseSink * bsink, GstBuffer * buf)
+{
+  return _render (bsink, buf, FALSE);
+}
+
+static GstFlowReturn
+gst_glimage_sink_render (GstBaseSink * bsink, GstBuffer * buf)
+{
+  return _render (bsink, buf, TRUE);
+}
+
 
 static void
 gst_glimage_sink_video_overlay_init (GstVideoOverlayInterface * iface)
@@ -906,6 +1599,10 @@ gst_glimage_sink_propose_allocation (GstBaseSink * bsink, GstQuery * query)
 
     config = gst_buffer_pool_get_config (pool);
     gst_buffer_pool_config_set_params (config, caps, size, 0, 0);
+    /* planar YUV is drawn without converting to RGBA first, only taken by
+     * upstream elements that also enable the video meta */
+    gst_buffer_pool_config_add_option (config,
+        GST_BUFFER_POOL_OPTION_GL_PLANAR);
     if (!gst_buffer_pool_set_config (pool, config))
       goto config_failed;
   }
@@ -914,6 +1611,7 @@ gst_glimage_sink_propose_allocation (GstBaseSink * bsink, GstQuery * query)
 
   /* we also support various metadata */
   gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, 0);
+  gst_query_add_allocation_meta (query, GST_VIDEO_CROP_META_API_TYPE, 0);
 
   gst_object_unref (pool);
 
@@ -986,9 +1684,61 @@ gst_glimage_sink_thread_init_redisplay (GstGLImageSink * gl_sink)
 }
 #endif
 
+/* Called in the gl thread */
 static void
-gst_glimage_sink_on_resize (const GstGLImageSink * gl_sink, gint width,
-    gint height)
+gst_glimage_sink_thread_init_yuv_redisplay (GstGLImageSink * gl_sink)
+{
+  GstVideoFormat format = GST_VIDEO_INFO_FORMAT (&gl_sink->info);
+  GError *error = NULL;
+  gchar *frag_str;
+  gchar u, v;
+
+  if (gl_sink->yuv_shader) {
+    gst_object_unref (gl_sink->yuv_shader);
+    gl_sink->yuv_shader = NULL;
+  }
+
+  if (format == GST_VIDEO_FORMAT_NV12 || format == GST_VIDEO_FORMAT_NV21) {
+    /* GLES2 stores the chroma plane as luminance and alpha */
+    u = 'r';
+    v = gl_sink->redisplay_chroma_format == GL_LUMINANCE_ALPHA ? 'a' : 'g';
+    if (format == GST_VIDEO_FORMAT_NV21)
+      frag_str = g_strdup_printf (redisplay_nv12_nv21_fragment_shader_str, v,
+          u);
+    else
+      frag_str = g_strdup_printf (redisplay_nv12_nv21_fragment_shader_str, u,
+          v);
+  } else {
+    frag_str = g_strdup (redisplay_planar_yuv_fragment_shader_str);
+  }
+
+  gl_sink->yuv_shader = gst_gl_shader_new (gl_sink->context);
+  gl_sink->yuv_shader_format = format;
+
+  gst_gl_shader_set_vertex_source (gl_sink->yuv_shader,
+      redisplay_vertex_shader_str_gles2);
+  gst_gl_shader_set_fragment_source (gl_sink->yuv_shader, frag_str);
+  g_free (frag_str);
+
+  gst_gl_shader_compile (gl_sink->yuv_shader, &error);
+  if (error) {
+    gst_gl_context_set_error (gl_sink->context, "%s", error->message);
+    g_error_free (error);
+    gst_gl_context_clear_shader (gl_sink->context);
+    gst_object_unref (gl_sink->yuv_shader);
+    gl_sink->yuv_shader = NULL;
+  } else {
+    gl_sink->yuv_attr_position_loc =
+        gst_gl_shader_get_attribute_location (gl_sink->yuv_shader,
+        "a_position");
+    gl_sink->yuv_attr_texture_loc =
+        gst_gl_shader_get_attribute_location (gl_sink->yuv_shader,
+        "a_texCoord");
+  }
+}
+
+static void
+gst_glimage_sink_on_resize (GstGLImageSink * gl_sink, gint width, gint height)
 {
   /* Here gl_sink members (ex:gl_sink->info) have a life time of set_caps.
    * It means that they cannot not change between two set_caps
@@ -997,6 +1747,12 @@ gst_glimage_sink_on_resize (const GstGLImageSink * gl_sink, gint width,
 
   GST_TRACE ("GL Window resized to %ux%u", width, height);
 
+  gl_sink->window_width = width;
+  gl_sink->window_height = height;
+  gl_sink->viewport_crop_width = gl_sink->crop_width;
+  gl_sink->viewport_crop_height = gl_sink->crop_height;
+  gl_sink->content_changed = TRUE;
+
   /* check if a client reshape callback is registered */
   if (gl_sink->clientReshapeCallback)
     gl_sink->clientReshapeCallback (width, height, gl_sink->client_data);
@@ -1006,10 +1762,13 @@ gst_glimage_sink_on_resize (const GstGLImageSink * gl_sink, gint width,
     if (gl_sink->keep_aspect_ratio) {
       GstVideoRectangle src, dst, result;
 
+      /* the aspect ratio of what is drawn */
       src.x = 0;
       src.y = 0;
-      src.w = GST_VIDEO_INFO_WIDTH (&gl_sink->info);
-      src.h = GST_VIDEO_INFO_HEIGHT (&gl_sink->info);
+      src.w = gl_sink->crop_width > 0 ? gl_sink->crop_width :
+          GST_VIDEO_INFO_WIDTH (&gl_sink->info);
+      src.h = gl_sink->crop_height > 0 ? gl_sink->crop_height :
+          GST_VIDEO_INFO_HEIGHT (&gl_sink->info);
 
       dst.x = 0;
       dst.y = 0;
@@ -1033,8 +1792,81 @@ gst_glimage_sink_on_resize (const GstGLImageSink * gl_sink, gint width,
 }
 
 
+/* maps the texture coordinates of the geometry to the cropped area */
 static void
-gst_glimage_sink_on_draw (const GstGLImageSink * gl_sink)
+_set_tex_rect (const GstGLImageSink * gl_sink, GstGLShader * shader)
+{
+  const gfloat *crop = gl_sink->redisplay_crop;
+
+  gst_gl_shader_set_uniform_4f (shader, "u_texRect", crop[0], crop[1],
+      crop[2] - crop[0], crop[3] - crop[1]);
+}
+
+/* Called in the gl thread with the drawing lock */
+static void
+gst_glimage_sink_draw_yuv (const GstGLImageSink * gl_sink)
+{
+  const GstGLFuncs *gl = gl_sink->context->gl_vtable;
+  const gchar *planar_samplers[] = { "Ytex", "Utex", "Vtex" };
+  const gchar *nv12_samplers[] = { "Ytex", "UVtex" };
+  const gchar **samplers;
+  GLuint textures[GST_VIDEO_MAX_PLANES];
+  gfloat offset[3], coeffs[9];
+  guint i;
+
+  if (!gl_sink->yuv_shader)
+    return;
+
+  memcpy (textures, gl_sink->redisplay_planes, sizeof (textures));
+  /* YV12 has its V plane before its U plane */
+  if (GST_VIDEO_INFO_FORMAT (&gl_sink->info) == GST_VIDEO_FORMAT_YV12) {
+    textures[1] = gl_sink->redisplay_planes[2];
+    textures[2] = gl_sink->redisplay_planes[1];
+  }
+  samplers = gl_sink->redisplay_n_planes == 2 ? nv12_samplers :
+      planar_samplers;
+
+  gl->Clear (GL_COLOR_BUFFER_BIT);
+
+  gst_gl_shader_use (gl_sink->yuv_shader);
+
+  _set_tex_rect (gl_sink, gl_sink->yuv_shader);
+
+  gst_gl_get_yuv_to_rgb_coefficients ((GstVideoInfo *) & gl_sink->info,
+      offset, coeffs);
+  gst_gl_shader_set_uniform_3fv (gl_sink->yuv_shader, "offset", 1, offset);
+  gst_gl_shader_set_uniform_3fv (gl_sink->yuv_shader, "rcoeff", 1, &coeffs[0]);
+  gst_gl_shader_set_uniform_3fv (gl_sink->yuv_shader, "gcoeff", 1, &coeffs[3]);
+  gst_gl_shader_set_uniform_3fv (gl_sink->yuv_shader, "bcoeff", 1, &coeffs[6]);
+
+  gst_gl_context_bind_geometry (gl_sink->context,
+      GST_GL_GEOMETRY_QUAD_FLIPPED, gl_sink->yuv_attr_position_loc,
+      gl_sink->yuv_attr_texture_loc);
+
+  for (i = 0; i < gl_sink->redisplay_n_planes; i++) {
+    gl->ActiveTexture (GL_TEXTURE0 + i);
+    gl->BindTexture (GL_TEXTURE_2D, textures[i]);
+    gst_gl_shader_set_uniform_1i (gl_sink->yuv_shader, samplers[i], i);
+  }
+
+  gst_gl_context_draw_geometry (gl_sink->context, 0, 1);
+  gst_gl_context_unbind_geometry (gl_sink->context);
+
+  gl->ActiveTexture (GL_TEXTURE0);
+  gst_gl_context_clear_shader (gl_sink->context);
+}
+
+/* every draw is followed by a swap, records whether the buffer it
+ * presents holds the current content */
+static inline void
+_push_buffer_history (GstGLImageSink * gl_sink, gboolean up_to_date)
+{
+  gl_sink->buffer_history = (gl_sink->buffer_history << 1)
+      | (up_to_date ? 1 : 0);
+}
+
+static void
+gst_glimage_sink_on_draw (GstGLImageSink * gl_sink)
 {
   /* Here gl_sink members (ex:gl_sink->info) have a life time of set_caps.
    * It means that they cannot not change between two set_caps as well as
@@ -1044,6 +1876,7 @@ gst_glimage_sink_on_draw (const GstGLImageSink * gl_sink)
 
   const GstGLFuncs *gl = NULL;
   GstGLWindow *window = NULL;
+  gint age;
 
   g_return_if_fail (GST_IS_GLIMAGE_SINK (gl_sink));
 
@@ -1053,6 +1886,7 @@ gst_glimage_sink_on_draw (const GstGLImageSink * gl_sink)
 
   /* check if texture is ready for being drawn */
   if (!gl_sink->redisplay_texture) {
+    _push_buffer_history (gl_sink, FALSE);
     GST_GLIMAGE_SINK_UNLOCK (gl_sink);
     return;
   }
@@ -1060,6 +1894,34 @@ gst_glimage_sink_on_draw (const GstGLImageSink * gl_sink)
   window = gst_gl_context_get_window (gl_sink->context);
   window->is_drawing = TRUE;
 
+  _collect_presents (gl_sink);
+  if (gl_sink->have_next_frame)
+    _frame_drawn (gl_sink);
+
+  /* keep the aspect ratio of the cropped area */
+  if (gl_sink->keep_aspect_ratio && !gl_sink->clientReshapeCallback
+      && gl_sink->window_width > 0
+      && (gl_sink->crop_width != gl_sink->viewport_crop_width
+          || gl_sink->crop_height != gl_sink->viewport_crop_height))
+    gst_glimage_sink_on_resize (gl_sink, gl_sink->window_width,
+        gl_sink->window_height);
+
+  /* a back buffer that was last presented after the content changed
+   * already holds the frame and only needs to be presented again */
+  age = gst_gl_context_get_buffer_age (gl_sink->context);
+  if (gl_sink->content_changed || gl_sink->clientDrawCallback) {
+    gl_sink->content_changed = FALSE;
+    gl_sink->buffer_history = 0;
+  } else if (age > 0 && age <= 64
+      && (gl_sink->buffer_history >> (age - 1)) & 1) {
+    GST_TRACE ("back buffer of age %i is up to date", age);
+    _push_buffer_history (gl_sink, TRUE);
+    window->is_drawing = FALSE;
+    gst_object_unref (window);
+    GST_GLIMAGE_SINK_UNLOCK (gl_sink);
+    return;
+  }
+
   /* opengl scene */
   GST_TRACE ("redrawing texture:%u", gl_sink->redisplay_texture);
 
@@ -1087,20 +1949,14 @@ gst_glimage_sink_on_draw (const GstGLImageSink * gl_sink)
           GST_VIDEO_INFO_WIDTH (&gl_sink->info),
           GST_VIDEO_INFO_HEIGHT (&gl_sink->info));
   }
+  /* planar YUV frame */
+  else if (gl_sink->redisplay_n_planes > 0) {
+    gst_glimage_sink_draw_yuv (gl_sink);
+  }
   /* default opengl scene */
   else {
 #if GST_GL_HAVE_OPENGL
     if (USING_OPENGL (gl_sink->context)) {
-      GLfloat verts[8] = { 1.0f, 1.0f,
-        -1.0f, 1.0f,
-        -1.0f, -1.0f,
-        1.0f, -1.0f
-      };
-      GLfloat texcoords[8] = { 1.0f, 0.0f,
-        0.0f, 0.0f,
-        0.0f, 1.0f,
-        1.0f, 1.0f
-      };
       gl->Clear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
       gl->MatrixMode (GL_PROJECTION);
@@ -1109,57 +1965,48 @@ gst_glimage_sink_on_draw (const GstGLImageSink * gl_sink)
       gl->Enable (GL_TEXTURE_2D);
       gl->BindTexture (GL_TEXTURE_2D, gl_sink->redisplay_texture);
 
-      gl->EnableClientState (GL_VERTEX_ARRAY);
-      gl->EnableClientState (GL_TEXTURE_COORD_ARRAY);
-      gl->VertexPointer (2, GL_FLOAT, 0, &verts);
-      gl->TexCoordPointer (2, GL_FLOAT, 0, &texcoords);
+      /* maps the texture coordinates to the cropped area */
+      gl->MatrixMode (GL_TEXTURE);
+      gl->LoadIdentity ();
+      gl->Translatef (gl_sink->redisplay_crop[0], gl_sink->redisplay_crop[1],
+          0.0f);
+      gl->Scalef (gl_sink->redisplay_crop[2] - gl_sink->redisplay_crop[0],
+          gl_sink->redisplay_crop[3] - gl_sink->redisplay_crop[1], 1.0f);
 
-      gl->DrawArrays (GL_TRIANGLE_FAN, 0, 4);
+      gst_gl_context_bind_geometry (gl_sink->context,
+          GST_GL_GEOMETRY_QUAD_FLIPPED, -1, -1);
+      gst_gl_context_draw_geometry (gl_sink->context, 0, 1);
+      gst_gl_context_unbind_geometry (gl_sink->context);
 
-      gl->DisableClientState (GL_VERTEX_ARRAY);
-      gl->DisableClientState (GL_TEXTURE_COORD_ARRAY);
+      gl->LoadIdentity ();
+      gl->MatrixMode (GL_MODELVIEW);
 
       gl->Disable (GL_TEXTURE_2D);
     }
 #endif
 #if GST_GL_HAVE_GLES2
     if (USING_GLES2 (gl_sink->context)) {
-      const GLfloat vVertices[] = { 1.0f, 1.0f, 0.0f,
-        1.0f, 0.0f,
-        -1.0f, 1.0f, 0.0f,
-        0.0f, 0.0f,
-        -1.0f, -1.0f, 0.0f,
-        0.0f, 1.0f,
-        1.0f, -1.0f, 0.0f,
-        1.0f, 1.0f
-      };
-
-      GLushort indices[] = { 0, 1, 2, 0, 2, 3 };
-
       gl->Clear (GL_COLOR_BUFFER_BIT);
 
       gst_gl_shader_use (gl_sink->redisplay_shader);
 
-      /* Load the vertex position */
-      gl->VertexAttribPointer (gl_sink->redisplay_attr_position_loc, 3,
-          GL_FLOAT, GL_FALSE, 5 * sizeof (GLfloat), vVertices);
-
-      /* Load the texture coordinate */
-      gl->VertexAttribPointer (gl_sink->redisplay_attr_texture_loc, 2,
-          GL_FLOAT, GL_FALSE, 5 * sizeof (GLfloat), &vVertices[3]);
-
-      gl->EnableVertexAttribArray (gl_sink->redisplay_attr_position_loc);
-      gl->EnableVertexAttribArray (gl_sink->redisplay_attr_texture_loc);
-
       gl->ActiveTexture (GL_TEXTURE0);
       gl->BindTexture (GL_TEXTURE_2D, gl_sink->redisplay_texture);
       gst_gl_shader_set_uniform_1i (gl_sink->redisplay_shader, "s_texture", 0);
+      _set_tex_rect (gl_sink, gl_sink->redisplay_shader);
 
-      gl->DrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+      gst_gl_context_bind_geometry (gl_sink->context,
+          GST_GL_GEOMETRY_QUAD_FLIPPED, gl_sink->redisplay_attr_position_loc,
+          gl_sink->redisplay_attr_texture_loc);
+      gst_gl_context_draw_geometry (gl_sink->context, 0, 1);
+      gst_gl_context_unbind_geometry (gl_sink->context);
     }
 #endif
   }                             /* end default opengl scene */
 
+  /* what the client draws is not known */
+  _push_buffer_history (gl_sink, !gl_sink->clientDrawCallback);
+
   window->is_drawing = FALSE;
   gst_object_unref (window);
 
@@ -1193,6 +2040,14 @@ gst_glimage_sink_redisplay (GstGLImageSink * gl_sink)
     }
 #endif
 
+    if (gl_sink->redisplay_n_planes > 0 && (!gl_sink->yuv_shader
+            || gl_sink->yuv_shader_format !=
+            GST_VIDEO_INFO_FORMAT (&gl_sink->info))) {
+      gst_gl_window_send_message (window,
+          GST_GL_WINDOW_CB (gst_glimage_sink_thread_init_yuv_redisplay),
+          gl_sink);
+    }
+
     /* Drawing is asynchrone: gst_gl_window_draw is not blocking
      * It means that it does not wait for stuff being executed in other threads
      */
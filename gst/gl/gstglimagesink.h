@@ -46,6 +46,27 @@ GST_DEBUG_CATEGORY_EXTERN (gst_debug_glimage_sink);
 
 typedef struct _GstGLImageSink GstGLImageSink;
 typedef struct _GstGLImageSinkClass GstGLImageSinkClass;
+typedef struct _GstGLImageSinkFrame GstGLImageSinkFrame;
+
+/* number of bins of the present jitter histogram */
+#define GST_GLIMAGE_SINK_JITTER_BINS 16
+
+/* a rendered frame, followed until it is presented */
+struct _GstGLImageSinkFrame
+{
+    GstClockTime running_time;
+    GstClockTime duration;
+
+    /* running time minus monotonic time, in nanoseconds */
+    GstClockTimeDiff clock_offset;
+
+    /* monotonic time in microseconds when rendered and presented */
+    gint64 render_time;
+    gint64 present_time;
+
+    /* vertical blank and swap counters of the output when drawn */
+    gint64 msc, sbc;
+};
 
 struct _GstGLImageSink
 {
@@ -81,6 +102,67 @@ struct _GstGLImageSink
     GMutex drawing_lock;
     GLuint redisplay_texture;
 
+    /* the last rendered buffer, keeps the textures drawn straight from it
+     * alive and tells whether the next one brings anything new */
+    GstBuffer *stored_buffer;
+    GLuint redisplay_planes[GST_VIDEO_MAX_PLANES];
+    guint redisplay_n_planes;
+    GLenum redisplay_chroma_format;
+
+    /* left, top, right and bottom texture coordinates of the area of the
+     * frame given by its GstVideoCropMeta, and its size in pixels */
+    gfloat redisplay_crop[4];
+    gint crop_width, crop_height;
+
+    /* last window size, the viewport is recomputed when the crop size
+     * changes with keep-aspect-ratio */
+    gint window_width, window_height;
+    gint viewport_crop_width, viewport_crop_height;
+
+    /* redisplay even if the next buffer holds the same memory */
+    gboolean force_redisplay;
+
+    /* what is drawn changed since the last draw.  Bit n of buffer_history
+     * is set when the buffer presented n + 1 swaps ago holds what is drawn
+     * now, to tell from the buffer age whether the back buffer is up to
+     * date */
+    gboolean content_changed;
+    guint64 buffer_history;
+
+    /* frame pacing, with the drawing_lock.  Rendered frames are drawn by
+     * the window thread, then followed until the output presents them and
+     * accounted by the next render. */
+    gboolean frame_pacing;
+    guint stats_interval;
+    gboolean have_sync_values;
+    GstGLImageSinkFrame next_frame;
+    gboolean have_next_frame;
+    GQueue drawn_frames;
+    GQueue presented_frames;
+    gboolean dropped_last;
+
+    /* last vertical blank and average period of the output, and average
+     * time from render to present over n_latencies frames, in
+     * microseconds */
+    gint64 msc_ust, msc_count;
+    gint64 msc_period;
+    gint64 present_latency;
+    guint n_latencies;
+    gboolean render_delay_set;
+    /* smoothed rate of the QoS events */
+    gdouble qos_proportion;
+
+    /* statistics since stats_start */
+    gint64 stats_start;
+    guint stats_displayed, stats_dropped, stats_late;
+    guint stats_jitter[GST_GLIMAGE_SINK_JITTER_BINS];
+    GstClockTimeDiff stats_jitter_sum, stats_jitter_max;
+
+    GstGLShader *yuv_shader;
+    GstVideoFormat yuv_shader_format;
+    GLint yuv_attr_position_loc;
+    GLint yuv_attr_texture_loc;
+
 #if GST_GL_HAVE_GLES2
   GstGLShader *redisplay_shader;
   GLint redisplay_attr_position_loc;
@@ -0,0 +1,537 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* 3D colour lookup tables of glcolorgrade.  The curve effects of gleffects
+ * keep their exact 256 entry curves.  Tables are parsed and built in any
+ * thread, only
+ * gst_gl_lut_upload(), gst_gl_lut_unload() and gst_gl_lut_bind() need the
+ * GL thread. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "gstgllut.h"
+#include "effects/gstgleffectscurves.h"
+
+#ifndef GL_TEXTURE_3D
+#define GL_TEXTURE_3D 0x806F
+#endif
+#ifndef GL_TEXTURE_WRAP_R
+#define GL_TEXTURE_WRAP_R 0x8072
+#endif
+#ifndef GL_MAX_3D_TEXTURE_SIZE
+#define GL_MAX_3D_TEXTURE_SIZE 0x8073
+#endif
+
+#define GST_CAT_DEFAULT gst_gl_lut_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+static void
+_init_debug (void)
+{
+  static gsize debug_init = 0;
+
+  if (g_once_init_enter (&debug_init)) {
+    GST_DEBUG_CATEGORY_INIT (gst_gl_lut_debug, "gllut", 0,
+        "OpenGL colour lookup tables");
+    g_once_init_leave (&debug_init, 1);
+  }
+}
+
+static inline guint8
+_to_byte (gfloat v)
+{
+  return (guint8) (CLAMP (v, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static inline guint8 *
+_entry (GstGLLut * lut, guint r, guint g, guint b)
+{
+  return &lut->data[(((b * lut->size) + g) * lut->size + r) * 4];
+}
+
+/* an identity table of size^3 entries over 0..1 */
+GstGLLut *
+gst_gl_lut_new (guint size)
+{
+  GstGLLut *lut;
+  guint r, g, b;
+
+  g_return_val_if_fail (size >= 2 && size <= GST_GL_LUT_MAX_SIZE, NULL);
+
+  _init_debug ();
+
+  lut = g_new0 (GstGLLut, 1);
+  lut->size = size;
+  lut->data = g_malloc (size * size * size * 4);
+  lut->domain_max[0] = lut->domain_max[1] = lut->domain_max[2] = 1.0f;
+
+  for (b = 0; b < size; b++) {
+    for (g = 0; g < size; g++) {
+      for (r = 0; r < size; r++) {
+        guint8 *e = _entry (lut, r, g, b);
+
+        e[0] = _to_byte ((gfloat) r / (size - 1));
+        e[1] = _to_byte ((gfloat) g / (size - 1));
+        e[2] = _to_byte ((gfloat) b / (size - 1));
+        e[3] = 255;
+      }
+    }
+  }
+
+  return lut;
+}
+
+void
+gst_gl_lut_free (GstGLLut * lut)
+{
+  if (!lut)
+    return;
+
+  if (lut->texture)
+    GST_WARNING ("freeing LUT \"%s\" with texture %u still uploaded",
+        GST_STR_NULL (lut->title), lut->texture);
+
+  g_free (lut->title);
+  g_free (lut->data);
+  g_free (lut);
+}
+
+/* the curves are sampled like the 256x1 textures gleffects draws them
+ * with, nearest texel of 256, but only at the GST_GL_LUT_CURVE_SIZE
+ * points of each axis of the table.  In between the trilinear lookup
+ * blends the neighbouring points, which smooths curves steeper than the
+ * 1/63 step of the table, like the bands of heat. */
+static GstGLLut *
+_new_from_curve (const GstGLEffectsCurve * curve, gboolean luma)
+{
+  GstGLLut *lut = gst_gl_lut_new (GST_GL_LUT_CURVE_SIZE);
+  guint size = lut->size;
+  guint r, g, b, c;
+
+  for (b = 0; b < size; b++) {
+    for (g = 0; g < size; g++) {
+      for (r = 0; r < size; r++) {
+        guint8 *e = _entry (lut, r, g, b);
+        gfloat in[3], l;
+
+        in[0] = (gfloat) r / (size - 1);
+        in[1] = (gfloat) g / (size - 1);
+        in[2] = (gfloat) b / (size - 1);
+
+        if (luma) {
+          l = 0.2125f * in[0] + 0.7154f * in[1] + 0.0721f * in[2];
+          in[0] = in[1] = in[2] = l;
+        }
+
+        for (c = 0; c < 3; c++) {
+          guint i = MIN ((guint) (in[c] * curve->width), curve->width - 1);
+
+          e[c] = curve->pixel_data[i * curve->bytes_per_pixel + c];
+        }
+      }
+    }
+  }
+
+  return lut;
+}
+
+GstGLLut *
+gst_gl_lut_new_builtin (GstGLLutBuiltin builtin)
+{
+  GstGLLut *lut;
+
+  switch (builtin) {
+    case GST_GL_LUT_BUILTIN_HEAT:
+      lut = _new_from_curve (&heat_curve, TRUE);
+      break;
+    case GST_GL_LUT_BUILTIN_SEPIA:
+      lut = _new_from_curve (&sepia_curve, TRUE);
+      break;
+    case GST_GL_LUT_BUILTIN_XPRO:
+      lut = _new_from_curve (&xpro_curve, FALSE);
+      break;
+    case GST_GL_LUT_BUILTIN_LUMA_XPRO:
+      lut = _new_from_curve (&luma_xpro_curve, TRUE);
+      break;
+    case GST_GL_LUT_BUILTIN_XRAY:
+      lut = _new_from_curve (&xray_curve, TRUE);
+      break;
+    case GST_GL_LUT_BUILTIN_NONE:
+    default:
+      lut = gst_gl_lut_new (2);
+      break;
+  }
+
+  return lut;
+}
+
+static gboolean
+_parse_floats (const gchar * str, gfloat * values, guint n)
+{
+  gchar *end;
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    values[i] = (gfloat) g_ascii_strtod (str, &end);
+    if (end == str)
+      return FALSE;
+    str = end;
+  }
+
+  while (g_ascii_isspace (*str))
+    str++;
+
+  return *str == '\0';
+}
+
+static gboolean
+_parse_size (const gchar * str, guint max, guint * size)
+{
+  gchar *end;
+  guint64 v;
+
+  v = g_ascii_strtoull (str, &end, 10);
+  if (end == str || v < 2 || v > max)
+    return FALSE;
+
+  while (g_ascii_isspace (*end))
+    end++;
+
+  *size = (guint) v;
+  return *end == '\0';
+}
+
+/* a 1D table applies to each channel on its own, linearly interpolated */
+static GstGLLut *
+_new_from_1d (const gfloat * table, guint length)
+{
+  GstGLLut *lut = gst_gl_lut_new (GST_GL_LUT_CURVE_SIZE);
+  guint size = lut->size;
+  guint r, g, b, c;
+
+  for (b = 0; b < size; b++) {
+    for (g = 0; g < size; g++) {
+      for (r = 0; r < size; r++) {
+        guint8 *e = _entry (lut, r, g, b);
+        guint in[3] = { r, g, b };
+
+        for (c = 0; c < 3; c++) {
+          gfloat p = (gfloat) in[c] * (length - 1) / (size - 1);
+          guint i = MIN ((guint) p, length - 2);
+          gfloat f = p - i;
+
+          e[c] = _to_byte (table[i * 3 + c] * (1.0f - f)
+              + table[(i + 1) * 3 + c] * f);
+        }
+      }
+    }
+  }
+
+  return lut;
+}
+
+/* Parses the Adobe/Resolve .cube format: TITLE, LUT_1D_SIZE or
+ * LUT_3D_SIZE, DOMAIN_MIN/DOMAIN_MAX or LUT_*_INPUT_RANGE, then one "r g b"
+ * line per entry with red varying fastest */
+GstGLLut *
+gst_gl_lut_new_from_cube (const gchar * data, gsize length, GError ** error)
+{
+  GstGLLut *lut = NULL;
+  gchar *text, **lines, *title = NULL;
+  gfloat domain_min[3] = { 0.0f, 0.0f, 0.0f };
+  gfloat domain_max[3] = { 1.0f, 1.0f, 1.0f };
+  gfloat *table = NULL;
+  guint size = 0, size_1d = 0, n_entries = 0, count = 0, i, c;
+
+  _init_debug ();
+
+  text = g_strndup (data, length);
+  lines = g_strsplit (text, "\n", -1);
+  g_free (text);
+
+  for (i = 0; lines[i]; i++) {
+    gchar *line = g_strstrip (lines[i]);
+    gfloat v[3];
+
+    if (line[0] == '\0' || line[0] == '#')
+      continue;
+
+    if (g_ascii_isalpha (line[0])) {
+      if (g_str_has_prefix (line, "TITLE")) {
+        gchar *start = strchr (line, '"'), *end = strrchr (line, '"');
+
+        g_free (title);
+        title = start && end > start ? g_strndup (start + 1, end - start - 1)
+            : NULL;
+      } else if (g_str_has_prefix (line, "LUT_3D_SIZE")) {
+        if (n_entries || !_parse_size (line + 11, GST_GL_LUT_MAX_SIZE, &size))
+          goto syntax_error;
+        n_entries = size * size * size;
+      } else if (g_str_has_prefix (line, "LUT_1D_SIZE")) {
+        if (n_entries || !_parse_size (line + 11, 65536, &size_1d))
+          goto syntax_error;
+        n_entries = size_1d;
+      } else if (g_str_has_prefix (line, "DOMAIN_MIN")) {
+        if (!_parse_floats (line + 10, domain_min, 3))
+          goto syntax_error;
+      } else if (g_str_has_prefix (line, "DOMAIN_MAX")) {
+        if (!_parse_floats (line + 10, domain_max, 3))
+          goto syntax_error;
+      } else if (g_str_has_prefix (line, "LUT_3D_INPUT_RANGE")
+          || g_str_has_prefix (line, "LUT_1D_INPUT_RANGE")) {
+        if (!_parse_floats (line + 18, v, 2))
+          goto syntax_error;
+        for (c = 0; c < 3; c++) {
+          domain_min[c] = v[0];
+          domain_max[c] = v[1];
+        }
+      } else {
+        GST_DEBUG ("ignoring line %u: %s", i + 1, line);
+      }
+      continue;
+    }
+
+    if (!n_entries || count >= n_entries || !_parse_floats (line, v, 3))
+      goto syntax_error;
+
+    if (!table)
+      table = g_new (gfloat, n_entries * 3);
+    for (c = 0; c < 3; c++)
+      table[count * 3 + c] = v[c];
+    count++;
+  }
+
+  if (!n_entries || count != n_entries) {
+    g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT,
+        "expected %u entries, found %u", n_entries, count);
+    goto done;
+  }
+
+  for (c = 0; c < 3; c++) {
+    if (!(domain_max[c] > domain_min[c])) {
+      g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT,
+          "empty domain %f..%f", domain_min[c], domain_max[c]);
+      goto done;
+    }
+  }
+
+  if (size_1d) {
+    lut = _new_from_1d (table, size_1d);
+  } else {
+    lut = gst_gl_lut_new (size);
+    for (i = 0; i < n_entries; i++) {
+      for (c = 0; c < 3; c++)
+        lut->data[i * 4 + c] = _to_byte (table[i * 3 + c]);
+    }
+  }
+
+  lut->title = title;
+  title = NULL;
+  memcpy (lut->domain_min, domain_min, sizeof (domain_min));
+  memcpy (lut->domain_max, domain_max, sizeof (domain_max));
+
+  GST_DEBUG ("parsed LUT \"%s\" of %u entries, %u^3 in GL",
+      GST_STR_NULL (lut->title), n_entries, lut->size);
+
+done:
+  g_strfreev (lines);
+  g_free (table);
+  g_free (title);
+
+  return lut;
+
+syntax_error:
+  g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT,
+      "invalid line %u: %s", i + 1, lines[i]);
+  goto done;
+}
+
+GstGLLut *
+gst_gl_lut_new_from_cube_file (const gchar * filename, GError ** error)
+{
+  GstGLLut *lut;
+  gchar *contents;
+  gsize length;
+
+  if (!g_file_get_contents (filename, &contents, &length, error))
+    return NULL;
+
+  lut = gst_gl_lut_new_from_cube (contents, length, error);
+  g_free (contents);
+
+  return lut;
+}
+
+/* GLES2 has no 3D textures, and the shaders would need
+ * GL_OES_texture_3D */
+gboolean
+gst_gl_lut_context_has_3d (GstGLContext * context)
+{
+  GstGLFuncs *gl = context->gl_vtable;
+
+  return (gst_gl_context_get_gl_api (context) & GST_GL_API_OPENGL)
+      && gl->TexImage3D != NULL;
+}
+
+/* must be called in the GL thread */
+gboolean
+gst_gl_lut_upload (GstGLLut * lut, GstGLContext * context,
+    gboolean texture_3d)
+{
+  GstGLFuncs *gl = context->gl_vtable;
+  guint size = lut->size;
+  guint width, height, b, g;
+  GLint max_size = 0;
+  GLenum gl_err;
+  guint8 *atlas;
+
+  if (lut->texture)
+    return TRUE;
+
+  if (texture_3d) {
+    gl->GetIntegerv (GL_MAX_3D_TEXTURE_SIZE, &max_size);
+    if (size > (guint) max_size) {
+      GST_WARNING ("%u^3 LUT larger than the %d^3 of 3D textures", size,
+          max_size);
+      return FALSE;
+    }
+
+    /* an error left by an earlier call is not ours */
+    gl->GetError ();
+
+    gl->GenTextures (1, &lut->texture);
+    gl->BindTexture (GL_TEXTURE_3D, lut->texture);
+    gl->TexParameteri (GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gl->TexParameteri (GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl->TexParameteri (GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl->TexParameteri (GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl->TexParameteri (GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    gl->TexImage3D (GL_TEXTURE_3D, 0, GL_RGBA8, size, size, size, 0,
+        GL_RGBA, GL_UNSIGNED_BYTE, lut->data);
+    gl->BindTexture (GL_TEXTURE_3D, 0);
+
+    /* out of memory for the large tables */
+    if ((gl_err = gl->GetError ()) != GL_NO_ERROR) {
+      GST_WARNING ("failed to upload %u^3 LUT into a 3D texture: 0x%x", size,
+          gl_err);
+      gl->DeleteTextures (1, &lut->texture);
+      lut->texture = 0;
+      return FALSE;
+    }
+
+    lut->texture_3d = TRUE;
+    lut->grid[0] = lut->grid[1] = 1;
+
+    GST_DEBUG ("uploaded %u^3 LUT into 3D texture %u", size, lut->texture);
+    return TRUE;
+  }
+
+  /* the slices of constant blue are laid out in a grid, to keep both
+   * dimensions of the texture small */
+  lut->grid[0] = (guint) ceil (sqrt ((gdouble) size));
+  lut->grid[1] = (size + lut->grid[0] - 1) / lut->grid[0];
+  width = lut->grid[0] * size;
+  height = lut->grid[1] * size;
+
+  gl->GetIntegerv (GL_MAX_TEXTURE_SIZE, &max_size);
+  if (width > (guint) max_size || height > (guint) max_size) {
+    GST_WARNING ("%u^3 LUT atlas of %ux%u larger than %d", size, width,
+        height, max_size);
+    return FALSE;
+  }
+
+  atlas = g_malloc0 (width * height * 4);
+  for (b = 0; b < size; b++) {
+    guint x = (b % lut->grid[0]) * size;
+    guint y = (b / lut->grid[0]) * size;
+
+    for (g = 0; g < size; g++)
+      memcpy (&atlas[((y + g) * width + x) * 4], _entry (lut, 0, g, b),
+          size * 4);
+  }
+
+  gl->GetError ();
+
+  gl->GenTextures (1, &lut->texture);
+  gl->BindTexture (GL_TEXTURE_2D, lut->texture);
+  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  gl->TexImage2D (GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+      GL_UNSIGNED_BYTE, atlas);
+  gl->BindTexture (GL_TEXTURE_2D, 0);
+  g_free (atlas);
+
+  if ((gl_err = gl->GetError ()) != GL_NO_ERROR) {
+    GST_WARNING ("failed to upload %u^3 LUT into a %ux%u atlas: 0x%x", size,
+        width, height, gl_err);
+    gl->DeleteTextures (1, &lut->texture);
+    lut->texture = 0;
+    return FALSE;
+  }
+
+  lut->texture_3d = FALSE;
+
+  GST_DEBUG ("uploaded %u^3 LUT into %ux%u atlas %u", size, width, height,
+      lut->texture);
+  return TRUE;
+}
+
+/* must be called in the GL thread */
+void
+gst_gl_lut_unload (GstGLLut * lut, GstGLContext * context)
+{
+  GstGLFuncs *gl = context->gl_vtable;
+
+  if (lut->texture)
+    gl->DeleteTextures (1, &lut->texture);
+  lut->texture = 0;
+}
+
+/* binds the uploaded table to texture unit @unit for the
+ * gst_gl_lut_lookup() of @shader, which must be in use */
+void
+gst_gl_lut_bind (GstGLLut * lut, GstGLContext * context,
+    GstGLShader * shader, guint unit)
+{
+  GstGLFuncs *gl = context->gl_vtable;
+
+  gl->ActiveTexture (GL_TEXTURE0 + unit);
+  gl->BindTexture (lut->texture_3d ? GL_TEXTURE_3D : GL_TEXTURE_2D,
+      lut->texture);
+  gst_gl_shader_set_uniform_1i (shader, "lut", unit);
+
+  gst_gl_shader_set_uniform_1f (shader, "lut_size", (gfloat) lut->size);
+  gst_gl_shader_set_uniform_3f (shader, "lut_domain_min",
+      lut->domain_min[0], lut->domain_min[1], lut->domain_min[2]);
+  gst_gl_shader_set_uniform_3f (shader, "lut_domain_scale",
+      1.0f / (lut->domain_max[0] - lut->domain_min[0]),
+      1.0f / (lut->domain_max[1] - lut->domain_min[1]),
+      1.0f / (lut->domain_max[2] - lut->domain_min[2]));
+  if (!lut->texture_3d)
+    gst_gl_shader_set_uniform_2f (shader, "lut_grid", (gfloat) lut->grid[0],
+        (gfloat) lut->grid[1]);
+}
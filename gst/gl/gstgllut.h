@@ -0,0 +1,137 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_GL_LUT_H__
+#define __GST_GL_LUT_H__
+
+#include <gst/gl/gl.h>
+
+G_BEGIN_DECLS
+
+/* largest LUT_3D_SIZE of a .cube file */
+#define GST_GL_LUT_MAX_SIZE 256
+
+/* size of the LUTs built from 1D curves, a 256^3 table would take 64 MB
+ * so the curves are only exact at the points of the table.  gleffects
+ * looks its curves up in exact 256x1 textures instead. */
+#define GST_GL_LUT_CURVE_SIZE 64
+
+typedef struct _GstGLLut GstGLLut;
+
+/**
+ * GstGLLutBuiltin:
+ * @GST_GL_LUT_BUILTIN_NONE: identity
+ * @GST_GL_LUT_BUILTIN_HEAT: luma mapped to a heat signature
+ * @GST_GL_LUT_BUILTIN_SEPIA: luma mapped to sepia tones
+ * @GST_GL_LUT_BUILTIN_XPRO: cross processing of each channel
+ * @GST_GL_LUT_BUILTIN_LUMA_XPRO: luma mapped to cross processed tones
+ * @GST_GL_LUT_BUILTIN_XRAY: luma mapped to x-ray tones
+ *
+ * The LUTs built from the curves of the gleffects effects, as presets
+ * of glcolorgrade.
+ */
+typedef enum
+{
+  GST_GL_LUT_BUILTIN_NONE,
+  GST_GL_LUT_BUILTIN_HEAT,
+  GST_GL_LUT_BUILTIN_SEPIA,
+  GST_GL_LUT_BUILTIN_XPRO,
+  GST_GL_LUT_BUILTIN_LUMA_XPRO,
+  GST_GL_LUT_BUILTIN_XRAY
+} GstGLLutBuiltin;
+
+/* A 3D colour lookup table of size^3 RGB entries, red varying fastest then
+ * green then blue, as in .cube files.  The input colour is scaled from
+ * domain_min..domain_max to the table.
+ *
+ * In the GL thread the table is uploaded into a 3D texture, or into a 2D
+ * atlas of grid[0] x grid[1] slices of constant blue where 3D textures are
+ * not available.  Both are sampled with trilinear interpolation by the
+ * gst_gl_lut_lookup() function of GST_GL_LUT_3D_SOURCE and
+ * GST_GL_LUT_2D_SOURCE, whose uniforms are set by gst_gl_lut_bind(). */
+struct _GstGLLut
+{
+  gchar        *title;
+  guint         size;
+  guint8       *data;
+  gfloat        domain_min[3];
+  gfloat        domain_max[3];
+
+  GLuint        texture;
+  gboolean      texture_3d;
+  guint         grid[2];
+};
+
+GstGLLut *   gst_gl_lut_new               (guint size);
+GstGLLut *   gst_gl_lut_new_builtin       (GstGLLutBuiltin builtin);
+GstGLLut *   gst_gl_lut_new_from_cube     (const gchar * data, gsize length,
+                                           GError ** error);
+GstGLLut *   gst_gl_lut_new_from_cube_file (const gchar * filename,
+                                            GError ** error);
+void         gst_gl_lut_free              (GstGLLut * lut);
+
+gboolean     gst_gl_lut_context_has_3d    (GstGLContext * context);
+gboolean     gst_gl_lut_upload            (GstGLLut * lut,
+                                           GstGLContext * context,
+                                           gboolean texture_3d);
+void         gst_gl_lut_unload            (GstGLLut * lut,
+                                           GstGLContext * context);
+void         gst_gl_lut_bind              (GstGLLut * lut,
+                                           GstGLContext * context,
+                                           GstGLShader * shader, guint unit);
+
+/* GLSL declaring vec3 gst_gl_lut_lookup (vec3 color) */
+#define GST_GL_LUT_COMMON_SOURCE \
+  "uniform float lut_size;\n" \
+  "uniform vec3 lut_domain_min;\n" \
+  "uniform vec3 lut_domain_scale;\n" \
+  "vec3 gst_gl_lut_position (vec3 color) {\n" \
+  "  vec3 c = clamp((color - lut_domain_min) * lut_domain_scale, 0.0, 1.0);\n" \
+  "  return c * (lut_size - 1.0);\n" \
+  "}\n"
+
+#define GST_GL_LUT_3D_SOURCE \
+  GST_GL_LUT_COMMON_SOURCE \
+  "uniform sampler3D lut;\n" \
+  "vec3 gst_gl_lut_lookup (vec3 color) {\n" \
+  "  vec3 p = gst_gl_lut_position (color);\n" \
+  "  return texture3D(lut, (p + 0.5) / lut_size).rgb;\n" \
+  "}\n"
+
+/* the slices on both sides of blue are sampled bilinearly and blended */
+#define GST_GL_LUT_2D_SOURCE \
+  GST_GL_LUT_COMMON_SOURCE \
+  "uniform sampler2D lut;\n" \
+  "uniform vec2 lut_grid;\n" \
+  "vec3 gst_gl_lut_slice (vec2 rg, float b) {\n" \
+  "  vec2 tile = vec2(mod(b, lut_grid.x), floor(b / lut_grid.x));\n" \
+  "  return texture2D(lut, (tile * lut_size + rg + 0.5) / (lut_grid * lut_size)).rgb;\n" \
+  "}\n" \
+  "vec3 gst_gl_lut_lookup (vec3 color) {\n" \
+  "  vec3 p = gst_gl_lut_position (color);\n" \
+  "  float b0 = floor(p.b);\n" \
+  "  float b1 = min(b0 + 1.0, lut_size - 1.0);\n" \
+  "  return mix(gst_gl_lut_slice (p.rg, b0), gst_gl_lut_slice (p.rg, b1),\n" \
+  "      p.b - b0);\n" \
+  "}\n"
+
+G_END_DECLS
+
+#endif /* __GST_GL_LUT_H__ */
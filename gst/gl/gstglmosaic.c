@@ -33,12 +33,19 @@
  * ]|
  * FBO (Frame Buffer Object) is required.
  * </refsect2>
+ *
+ * The cube turns at a rate given by the running time of the output,
+ * scaled by #GstGLMosaic:speed.  While the cube is still and no input
+ * receives a new buffer, the previous output is pushed again instead of
+ * drawing the scene.
  */
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
+#include <math.h>
+
 #include "gstglmosaic.h"
 
 #define GST_CAT_DEFAULT gst_gl_mosaic_debug
@@ -47,8 +54,16 @@ GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 enum
 {
   PROP_0,
+  PROP_SPEED
 };
 
+#define DEFAULT_SPEED 1.0
+
+/* degrees per second at a speed of 1.0 */
+#define XROT_RATE 18.0
+#define YROT_RATE 12.0
+#define ZROT_RATE 24.0
+
 #define DEBUG_INIT \
     GST_DEBUG_CATEGORY_INIT (gst_gl_mosaic_debug, "glmosaic", 0, "glmosaic element");
 
@@ -66,6 +81,8 @@ static gboolean gst_gl_mosaic_init_shader (GstGLMixer * mixer,
 
 static gboolean gst_gl_mosaic_process_textures (GstGLMixer * mixer,
     GPtrArray * frames, guint out_tex);
+static gboolean gst_gl_mosaic_update_scene (GstGLMixer * mixer,
+    GstClockTime running_time);
 static void gst_gl_mosaic_callback (gpointer stuff);
 
 //vertex source
@@ -74,6 +91,7 @@ static const gchar *mosaic_v_src =
     "uniform float xrot_degree, yrot_degree, zrot_degree;         \n"
     "attribute vec4 a_position;                                   \n"
     "attribute vec2 a_texCoord;                                   \n"
+    "uniform vec4 tex_rect;                                       \n"
     "varying vec2 v_texCoord;                                     \n"
     "void main()                                                  \n"
     "{                                                            \n"
@@ -97,7 +115,7 @@ static const gchar *mosaic_v_src =
     "            0.0,        0.0,        1.0, 0.0,                \n"
     "            0.0,        0.0,        0.0, 1.0 );              \n"
     "   gl_Position = u_matrix * matZ * matY * matX * a_position; \n"
-    "   v_texCoord = a_texCoord;                                  \n"
+    "   v_texCoord = mix(tex_rect.xy, tex_rect.zw, a_texCoord);   \n"
     "}                                                            \n";
 
 //fragment source
@@ -122,6 +140,11 @@ gst_gl_mosaic_class_init (GstGLMosaicClass * klass)
   gobject_class->set_property = gst_gl_mosaic_set_property;
   gobject_class->get_property = gst_gl_mosaic_get_property;
 
+  g_object_class_install_property (gobject_class, PROP_SPEED,
+      g_param_spec_double ("speed", "Speed",
+          "Rotation speed of the cube, 0 keeps it still", 0.0, 100.0,
+          DEFAULT_SPEED, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_metadata (element_class, "OpenGL mosaic",
       "Filter/Effect/Video", "OpenGL mosaic",
       "Julien Isorce <julien.isorce@gmail.com>");
@@ -129,6 +152,7 @@ gst_gl_mosaic_class_init (GstGLMosaicClass * klass)
   GST_GL_MIXER_CLASS (klass)->set_caps = gst_gl_mosaic_init_shader;
   GST_GL_MIXER_CLASS (klass)->reset = gst_gl_mosaic_reset;
   GST_GL_MIXER_CLASS (klass)->process_textures = gst_gl_mosaic_process_textures;
+  GST_GL_MIXER_CLASS (klass)->update_scene = gst_gl_mosaic_update_scene;
 }
 
 static void
@@ -136,15 +160,22 @@ gst_gl_mosaic_init (GstGLMosaic * mosaic)
 {
   mosaic->shader = NULL;
   mosaic->input_frames = NULL;
+  mosaic->speed = DEFAULT_SPEED;
+  mosaic->last_running_time = GST_CLOCK_TIME_NONE;
+  mosaic->redraw = TRUE;
 }
 
 static void
 gst_gl_mosaic_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
-  //GstGLMosaic *mixer = GST_GL_MOSAIC (object);
+  GstGLMosaic *mosaic = GST_GL_MOSAIC (object);
 
   switch (prop_id) {
+    case PROP_SPEED:
+      mosaic->speed = g_value_get_double (value);
+      mosaic->redraw = TRUE;
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -155,9 +186,12 @@ static void
 gst_gl_mosaic_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
-  //GstGLMosaic* mixer = GST_GL_MOSAIC (object);
+  GstGLMosaic *mosaic = GST_GL_MOSAIC (object);
 
   switch (prop_id) {
+    case PROP_SPEED:
+      g_value_set_double (value, mosaic->speed);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -170,6 +204,8 @@ gst_gl_mosaic_reset (GstGLMixer * mixer)
   GstGLMosaic *mosaic = GST_GL_MOSAIC (mixer);
 
   mosaic->input_frames = NULL;
+  mosaic->last_running_time = GST_CLOCK_TIME_NONE;
+  mosaic->redraw = TRUE;
 
   //blocking call, wait the opengl thread has destroyed the shader
   if (mosaic->shader)
@@ -187,6 +223,39 @@ gst_gl_mosaic_init_shader (GstGLMixer * mixer, GstCaps * outcaps)
       &mosaic->shader);
 }
 
+/* advances the rotation to @running_time, returns whether the scene moved */
+static gboolean
+gst_gl_mosaic_update_scene (GstGLMixer * mixer, GstClockTime running_time)
+{
+  GstGLMosaic *mosaic = GST_GL_MOSAIC (mixer);
+  gboolean changed = mosaic->redraw;
+  gdouble elapsed;
+
+  mosaic->redraw = FALSE;
+
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return changed;
+
+  if (!GST_CLOCK_TIME_IS_VALID (mosaic->last_running_time)
+      || running_time < mosaic->last_running_time) {
+    mosaic->last_running_time = running_time;
+    return changed;
+  }
+
+  elapsed = mosaic->speed * (gdouble) (running_time -
+      mosaic->last_running_time) / (gdouble) GST_SECOND;
+  mosaic->last_running_time = running_time;
+
+  if (elapsed == 0.0)
+    return changed;
+
+  mosaic->xrot = fmod (mosaic->xrot + XROT_RATE * elapsed, 360.0);
+  mosaic->yrot = fmod (mosaic->yrot + YROT_RATE * elapsed, 360.0);
+  mosaic->zrot = fmod (mosaic->zrot + ZROT_RATE * elapsed, 360.0);
+
+  return TRUE;
+}
+
 static gboolean
 gst_gl_mosaic_process_textures (GstGLMixer * mix, GPtrArray * frames,
     guint out_tex)
@@ -212,10 +281,6 @@ gst_gl_mosaic_callback (gpointer stuff)
   GstGLMixer *mixer = GST_GL_MIXER (mosaic);
   GstGLFuncs *gl = mixer->context->gl_vtable;
 
-  static GLfloat xrot = 0;
-  static GLfloat yrot = 0;
-  static GLfloat zrot = 0;
-
   GLint attr_position_loc = 0;
   GLint attr_texture_loc = 0;
 
@@ -225,12 +290,11 @@ gst_gl_mosaic_callback (gpointer stuff)
     0.0f, 0.0f, 0.5f, 0.0f,
     0.0f, 0.0f, 0.0f, 1.0f
   };
-  const GLushort indices[] = {
-    0, 1, 2,
-    0, 2, 3
-  };
+  /* faces of GST_GL_GEOMETRY_CUBE the inputs are drawn on, in input order */
+  const guint faces[] = { 0, 2, 3, 4, 5, 1 };
 
   guint count = 0;
+  guint bound_tex = 0;
 
   gst_gl_context_clear_shader (mixer->context);
   gl->BindTexture (GL_TEXTURE_2D, 0);
@@ -248,11 +312,22 @@ gst_gl_mosaic_callback (gpointer stuff)
   attr_texture_loc =
       gst_gl_shader_get_attribute_location (mosaic->shader, "a_texCoord");
 
+  gl->ActiveTexture (GL_TEXTURE0);
+  gst_gl_shader_set_uniform_1i (mosaic->shader, "s_texture", 0);
+  gst_gl_shader_set_uniform_1f (mosaic->shader, "xrot_degree", mosaic->xrot);
+  gst_gl_shader_set_uniform_1f (mosaic->shader, "yrot_degree", mosaic->yrot);
+  gst_gl_shader_set_uniform_1f (mosaic->shader, "zrot_degree", mosaic->zrot);
+  gst_gl_shader_set_uniform_matrix_4fv (mosaic->shader, "u_matrix", 1,
+      GL_FALSE, matrix);
+
+  gst_gl_context_bind_geometry (mixer->context, GST_GL_GEOMETRY_CUBE,
+      attr_position_loc, attr_texture_loc);
+
   while (count < mosaic->input_frames->len && count < 6) {
     GstGLMixerFrameData *frame;
-    GLfloat *v_vertices;
     guint in_tex;
     guint width, height;
+    gfloat *tc;
 
     frame = g_ptr_array_index (mosaic->input_frames, count);
     in_tex = frame->texture;
@@ -268,98 +343,27 @@ gst_gl_mosaic_callback (gpointer stuff)
 
     GST_TRACE ("processing texture:%u dimensions:%ux%u", in_tex, width, height);
 
-    /* *INDENT-OFF* */
-    v_vertices = (GLfloat[]) {
-      /* front face */
-      1.0f, 1.0f, -1.0f,
-      1.0f, 0.0f,
-      1.0f, -1.0f, -1.0f,
-      1.0f, 1.0f,
-      -1.0f, -1.0f, -1.0f,
-      0.0f, 1.0f,
-      -1.0f, 1.0f, -1.0f,
-      0.0f, 0.0f,
-      /* right face */
-      1.0f, 1.0f, 1.0f,
-      1.0f, 0.0f,
-      1.0f, -1.0f, 1.0f,
-      0.0f, 0.0f,
-      1.0f, -1.0f, -1.0f,
-      0.0f, 1.0f,
-      1.0f, 1.0f, -1.0f,
-      1.0f, 1.0f,
-      /* left face */
-      -1.0f, 1.0f, 1.0f,
-      1.0f, 0.0f,
-      -1.0f, 1.0f, -1.0f,
-      1.0f, 1.0f,
-      -1.0f, -1.0f, -1.0f,
-      0.0f, 1.0f,
-      -1.0f, -1.0f, 1.0f,
-      0.0f, 0.0f,
-      /* top face */
-      1.0f, -1.0f, 1.0f,
-      1.0f, 0.0f,
-      -1.0f, -1.0f, 1.0f,
-      0.0f, 0.0f,
-      -1.0f, -1.0f, -1.0f,
-      0.0f, 1.0f,
-      1.0f, -1.0f, -1.0f,
-      1.0f, 1.0f,
-      /* bottom face */
-      1.0f, 1.0f, 1.0f,
-      1.0f, 0.0f,
-      1.0f, 1.0f, -1.0f,
-      1.0f, 1.0f,
-      -1.0f, 1.0f, -1.0f,
-      0.0f, 1.0f,
-      -1.0f, 1.0f, 1.0f,
-      0.0f, 0.0f,
-      /* back face */
-      1.0f, 1.0f, 1.0f,
-      1.0f, 0.0f,
-      -1.0f, 1.0f, 1.0f,
-      0.0f, 0.0f,
-      -1.0f, -1.0f, 1.0f,
-      0.0f, 1.0f,
-      1.0f, -1.0f, 1.0f,
-      1.0f, 1.0f
-    };
-    /* *INDENT-ON* */
-
-    gl->VertexAttribPointer (attr_position_loc, 3, GL_FLOAT,
-        GL_FALSE, 5 * sizeof (GLfloat), &v_vertices[5 * 4 * count]);
-
-    gl->VertexAttribPointer (attr_texture_loc, 2, GL_FLOAT,
-        GL_FALSE, 5 * sizeof (GLfloat), &v_vertices[5 * 4 * count + 3]);
-
-    gl->EnableVertexAttribArray (attr_position_loc);
-    gl->EnableVertexAttribArray (attr_texture_loc);
-
-    gl->ActiveTexture (GL_TEXTURE0);
-    gl->BindTexture (GL_TEXTURE_2D, in_tex);
-    gst_gl_shader_set_uniform_1i (mosaic->shader, "s_texture", 0);
-    gst_gl_shader_set_uniform_1f (mosaic->shader, "xrot_degree", xrot);
-    gst_gl_shader_set_uniform_1f (mosaic->shader, "yrot_degree", yrot);
-    gst_gl_shader_set_uniform_1f (mosaic->shader, "zrot_degree", zrot);
-    gst_gl_shader_set_uniform_matrix_4fv (mosaic->shader, "u_matrix", 1,
-        GL_FALSE, matrix);
-
-    gl->DrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+    /* map the face onto the part of in_tex covered by the frame, which is
+     * smaller than the texture for inputs allocated from a texture atlas */
+    tc = frame->tex_coords;
+    gst_gl_shader_set_uniform_4f (mosaic->shader, "tex_rect", tc[0], tc[1],
+        tc[2], tc[3]);
+
+    if (in_tex != bound_tex) {
+      gl->BindTexture (GL_TEXTURE_2D, in_tex);
+      bound_tex = in_tex;
+    }
+
+    gst_gl_context_draw_geometry (mixer->context, faces[count], 1);
 
     ++count;
   }
 
-  gl->DisableVertexAttribArray (attr_position_loc);
-  gl->DisableVertexAttribArray (attr_texture_loc);
+  gst_gl_context_unbind_geometry (mixer->context);
 
   gl->BindTexture (GL_TEXTURE_2D, 0);
 
   gl->Disable (GL_DEPTH_TEST);
 
   gst_gl_context_clear_shader (mixer->context);
-
-  xrot += 0.6f;
-  yrot += 0.4f;
-  zrot += 0.8f;
 }
@@ -41,6 +41,14 @@ struct _GstGLMosaic
 
     GstGLShader *shader;
     GPtrArray *input_frames;
+
+    /* rotation in degrees, advanced with the running time */
+    gdouble speed;
+    GLfloat xrot;
+    GLfloat yrot;
+    GLfloat zrot;
+    GstClockTime last_running_time;
+    gboolean redraw;
 };
 
 struct _GstGLMosaicClass
@@ -23,12 +23,25 @@
  *
  * Overlay GL video texture with a PNG image
  *
+ * The image is decoded in a separate thread and swapped in on the first frame
+ * rendered after decoding finished, so changing #GstGLOverlay:location while
+ * playing does not stall the stream.
+ *
+ * Any #GstVideoOverlayComposition attached to the input buffers, as produced
+ * by textoverlay or subtitle renderers, is blended on top of the output with
+ * a #GstGLOverlayCompositor instead of being rendered in system memory
+ * upstream.
+ *
  * <refsect2>
  * <title>Examples</title>
  * |[
  * gst-launch  videotestsrc ! "video/x-raw-rgb" ! glupload ! gloverlay location=imagefile ! glimagesink
  * ]|
  * FBO (Frame Buffer Object) is required.
+ * |[
+ * gst-launch videotestsrc ! textoverlay text="Hello" ! gloverlay ! glimagesink
+ * ]|
+ * The text is blended by gloverlay.
  * </refsect2>
  */
 
@@ -62,6 +75,31 @@ GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 G_DEFINE_TYPE_WITH_CODE (GstGLOverlay, gst_gl_overlay, GST_TYPE_GL_FILTER,
     DEBUG_INIT);
 
+static GstStaticPadTemplate gst_gl_overlay_sink_pad_template =
+    GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY ","
+            GST_CAPS_FEATURE_META_GST_VIDEO_OVERLAY_COMPOSITION,
+            GST_GL_UPLOAD_FORMATS) "; "
+        GST_VIDEO_CAPS_MAKE (GST_GL_UPLOAD_FORMATS) "; "
+        GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_META_GST_VIDEO_GL_TEXTURE_UPLOAD_META,
+            "RGBA"))
+    );
+
+typedef struct _GstGLOverlayImage
+{
+  gchar *location;
+  guint serial;
+
+  /* RGBA, rows in the order of the file for PNG and bottom-up for JPEG */
+  guchar *pixbuf;
+  gint width, height;
+  gint type_file;
+} GstGLOverlayImage;
+
 static gboolean gst_gl_overlay_set_caps (GstGLFilter * filter,
     GstCaps * incaps, GstCaps * outcaps);
 
@@ -73,11 +111,20 @@ static void gst_gl_overlay_get_property (GObject * object, guint prop_id,
 static void gst_gl_overlay_init_resources (GstGLFilter * filter);
 static void gst_gl_overlay_reset_resources (GstGLFilter * filter);
 
+static gboolean gst_gl_overlay_filter (GstGLFilter * filter,
+    GstBuffer * inbuf, GstBuffer * outbuf);
 static gboolean gst_gl_overlay_filter_texture (GstGLFilter * filter,
     guint in_tex, guint out_tex);
 
-static gint gst_gl_overlay_load_png (GstGLFilter * filter);
-static gint gst_gl_overlay_load_jpeg (GstGLFilter * filter);
+static GstCaps *gst_gl_overlay_transform_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter);
+static gboolean gst_gl_overlay_propose_allocation (GstBaseTransform * trans,
+    GstQuery * decide_query, GstQuery * query);
+static gboolean gst_gl_overlay_transform_meta (GstBaseTransform * trans,
+    GstBuffer * outbuf, GstMeta * meta, GstBuffer * inbuf);
+
+static gint gst_gl_overlay_load_png (GstGLOverlayImage * image);
+static gint gst_gl_overlay_load_jpeg (GstGLOverlayImage * image);
 
 enum
 {
@@ -112,7 +159,10 @@ gst_gl_overlay_reset_gl_resources (GstGLFilter * filter)
   GstGLOverlay *overlay = GST_GL_OVERLAY (filter);
   const GstGLFuncs *gl = filter->context->gl_vtable;
 
-  gl->DeleteTextures (1, &overlay->pbuftexture);
+  if (overlay->pbuftexture) {
+    gl->DeleteTextures (1, &overlay->pbuftexture);
+    overlay->pbuftexture = 0;
+  }
 }
 
 static void
@@ -127,7 +177,18 @@ gst_gl_overlay_class_init (GstGLOverlayClass * klass)
   gobject_class->set_property = gst_gl_overlay_set_property;
   gobject_class->get_property = gst_gl_overlay_get_property;
 
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_gl_overlay_sink_pad_template));
+
+  GST_BASE_TRANSFORM_CLASS (klass)->transform_caps =
+      gst_gl_overlay_transform_caps;
+  GST_BASE_TRANSFORM_CLASS (klass)->propose_allocation =
+      gst_gl_overlay_propose_allocation;
+  GST_BASE_TRANSFORM_CLASS (klass)->transform_meta =
+      gst_gl_overlay_transform_meta;
+
   GST_GL_FILTER_CLASS (klass)->set_caps = gst_gl_overlay_set_caps;
+  GST_GL_FILTER_CLASS (klass)->filter = gst_gl_overlay_filter;
   GST_GL_FILTER_CLASS (klass)->filter_texture = gst_gl_overlay_filter_texture;
   GST_GL_FILTER_CLASS (klass)->display_init_cb =
       gst_gl_overlay_init_gl_resources;
@@ -304,13 +365,7 @@ gst_gl_overlay_draw (GstGLOverlay * o, int flag)
   };
 /* *INDENT-ON* */
 
-  if (flag == 1) {
-    width = 1.0f;
-    height = 1.0f;
-  } else if (flag == 0 && o->type_file == 1) {
-    width = (gfloat) o->width;
-    height = (gfloat) o->height;
-  } else if (flag == 0 && o->type_file == 2) {
+  if (flag == 1 || o->type_file != 0) {
     width = 1.0f;
     height = 1.0f;
   }
@@ -409,8 +464,6 @@ static void
 gst_gl_overlay_init (GstGLOverlay * overlay)
 {
   overlay->location = NULL;
-  overlay->pixbuf = NULL;
-  overlay->pbuftexture = 0;
   overlay->pbuftexture = 0;
   overlay->width = 0;
   overlay->height = 0;
@@ -428,12 +481,45 @@ gst_gl_overlay_init (GstGLOverlay * overlay)
   overlay->ratio_video = 0;
   //  overlay->stretch = TRUE;
   overlay->pbuf_has_changed = FALSE;
+  overlay->decode_pool = NULL;
+  overlay->location_serial = 0;
+  overlay->pending_image = NULL;
+  overlay->overlay_compositor = NULL;
+}
+
+static void
+gst_gl_overlay_image_free (GstGLOverlayImage * image)
+{
+  g_free (image->location);
+  free (image->pixbuf);
+  g_slice_free (GstGLOverlayImage, image);
 }
 
 static void
 gst_gl_overlay_reset_resources (GstGLFilter * filter)
 {
-  // GstGLOverlay* overlay = GST_GL_OVERLAY(filter);
+  GstGLOverlay *overlay = GST_GL_OVERLAY (filter);
+
+  if (overlay->decode_pool) {
+    /* outdate the queued jobs so they are dropped once decoded */
+    GST_OBJECT_LOCK (overlay);
+    overlay->location_serial++;
+    GST_OBJECT_UNLOCK (overlay);
+
+    g_thread_pool_free (overlay->decode_pool, FALSE, TRUE);
+    overlay->decode_pool = NULL;
+  }
+
+  if (overlay->pending_image) {
+    gst_gl_overlay_image_free (overlay->pending_image);
+    overlay->pending_image = NULL;
+  }
+
+  if (overlay->overlay_compositor) {
+    gst_gl_overlay_compositor_free_overlays (overlay->overlay_compositor);
+    gst_object_unref (overlay->overlay_compositor);
+    overlay->overlay_compositor = NULL;
+  }
 }
 
 static void
@@ -444,10 +530,12 @@ gst_gl_overlay_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_LOCATION:
-      if (overlay->location != NULL)
-        g_free (overlay->location);
-      overlay->pbuf_has_changed = TRUE;
+      GST_OBJECT_LOCK (overlay);
+      g_free (overlay->location);
       overlay->location = g_value_dup_string (value);
+      overlay->location_serial++;
+      overlay->pbuf_has_changed = TRUE;
+      GST_OBJECT_UNLOCK (overlay);
       break;
     case PROP_XPOS_PNG:
       overlay->pos_x_png = g_value_get_int (value);
@@ -503,7 +591,9 @@ gst_gl_overlay_get_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_LOCATION:
+      GST_OBJECT_LOCK (overlay);
       g_value_set_string (value, overlay->location);
+      GST_OBJECT_UNLOCK (overlay);
       break;
     case PROP_XPOS_PNG:
       g_value_set_int (value, overlay->pos_x_png);
@@ -569,10 +659,97 @@ gst_gl_overlay_set_caps (GstGLFilter * filter, GstCaps * incaps,
   return TRUE;
 }
 
+static GstCaps *
+gst_gl_overlay_transform_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter)
+{
+  GstCaps *newcaps, *result;
+
+  /* GstGLFilter only knows about its own sink template */
+  if (direction != GST_PAD_SRC)
+    return
+        GST_BASE_TRANSFORM_CLASS (gst_gl_overlay_parent_class)->transform_caps
+        (bt, direction, caps, filter);
+
+  newcaps =
+      gst_static_pad_template_get_caps (&gst_gl_overlay_sink_pad_template);
+
+  if (filter) {
+    result =
+        gst_caps_intersect_full (filter, newcaps, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (newcaps);
+    newcaps = result;
+  }
+
+  GST_DEBUG_OBJECT (bt, "returning caps: %" GST_PTR_FORMAT, newcaps);
+
+  return newcaps;
+}
+
+static gboolean
+gst_gl_overlay_propose_allocation (GstBaseTransform * trans,
+    GstQuery * decide_query, GstQuery * query)
+{
+  if (!GST_BASE_TRANSFORM_CLASS (gst_gl_overlay_parent_class)->propose_allocation
+      (trans, decide_query, query))
+    return FALSE;
+
+  gst_query_add_allocation_meta (query,
+      GST_VIDEO_OVERLAY_COMPOSITION_META_API_TYPE, 0);
+
+  return TRUE;
+}
+
+static gboolean
+gst_gl_overlay_transform_meta (GstBaseTransform * trans, GstBuffer * outbuf,
+    GstMeta * meta, GstBuffer * inbuf)
+{
+  /* the composition is blended into the output */
+  if (meta->info->api == GST_VIDEO_OVERLAY_COMPOSITION_META_API_TYPE)
+    return FALSE;
+
+  return GST_BASE_TRANSFORM_CLASS (gst_gl_overlay_parent_class)->transform_meta
+      (trans, outbuf, meta, inbuf);
+}
+
+/* runs in the decode pool */
+static void
+gst_gl_overlay_decode_image (GstGLOverlayImage * image, GstGLOverlay * overlay)
+{
+  if ((image->type_file = gst_gl_overlay_load_png (image)) == 0)
+    image->type_file = gst_gl_overlay_load_jpeg (image);
+
+  /* a failed load keeps showing the previous image */
+  if (image->type_file != 0) {
+    GST_OBJECT_LOCK (overlay);
+    if (image->serial == overlay->location_serial) {
+      if (overlay->pending_image)
+        gst_gl_overlay_image_free (overlay->pending_image);
+      overlay->pending_image = image;
+      image = NULL;
+    }
+    GST_OBJECT_UNLOCK (overlay);
+  }
+
+  if (image) {
+    GST_DEBUG_OBJECT (overlay, "dropping image %s", image->location);
+    gst_gl_overlay_image_free (image);
+  }
+}
+
 static void
 gst_gl_overlay_init_resources (GstGLFilter * filter)
 {
-//  GstGLOverlay *overlay = GST_GL_OVERLAY (filter);
+  GstGLOverlay *overlay = GST_GL_OVERLAY (filter);
+
+  overlay->decode_pool =
+      g_thread_pool_new ((GFunc) gst_gl_overlay_decode_image, overlay, 1,
+      FALSE, NULL);
+
+  /* the texture went away with the previous context */
+  GST_OBJECT_LOCK (overlay);
+  overlay->pbuf_has_changed = overlay->location != NULL;
+  GST_OBJECT_UNLOCK (overlay);
 }
 
 static void
@@ -600,41 +777,69 @@ gst_gl_overlay_callback (gint width, gint height, guint texture, gpointer stuff)
     gst_gl_overlay_load_texture (overlay, texture, 1);
   } else {
     gst_gl_overlay_load_texture (overlay, texture, 1);
-    if (overlay->pbuftexture == 0)
-      return;
-    // if (overlay->stretch) {
-    //   width = (gfloat) overlay->width;
-    //   height = (gfloat) overlay->height;
-    // }
-    gl->LoadIdentity ();
-    gst_gl_overlay_load_texture (overlay, overlay->pbuftexture, 0);
+    if (overlay->pbuftexture != 0) {
+      // if (overlay->stretch) {
+      //   width = (gfloat) overlay->width;
+      //   height = (gfloat) overlay->height;
+      // }
+      gl->LoadIdentity ();
+      gst_gl_overlay_load_texture (overlay, overlay->pbuftexture, 0);
+    }
   }
+
+  if (overlay->overlay_compositor)
+    gst_gl_overlay_compositor_draw_overlays (overlay->overlay_compositor,
+        GST_VIDEO_INFO_WIDTH (&filter->in_info),
+        GST_VIDEO_INFO_HEIGHT (&filter->in_info));
 }
 
+typedef struct _SwapImage
+{
+  GstGLOverlay *overlay;
+  GstGLOverlayImage *image;
+  GLuint texture;
+} SwapImage;
+
+/* fills the new texture and replaces the current one with it, so a frame is
+ * rendered either with the previous image or with the new one */
 static void
-init_pixbuf_texture (GstGLContext * context, gpointer data)
+init_pixbuf_texture (GstGLContext * context, SwapImage * data)
 {
-  GstGLOverlay *overlay = GST_GL_OVERLAY (data);
-  GstGLFilter *filter = GST_GL_FILTER (overlay);
-  const GstGLFuncs *gl = filter->context->gl_vtable;
+  GstGLOverlay *overlay = data->overlay;
+  GstGLOverlayImage *image = data->image;
+  const GstGLFuncs *gl = context->gl_vtable;
 
-  if (overlay->pixbuf) {
+  gl->BindTexture (GL_TEXTURE_2D, data->texture);
+  gl->PixelStorei (GL_UNPACK_ALIGNMENT, 4);
+  gl->TexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, image->width, image->height,
+      GL_RGBA, GL_UNSIGNED_BYTE, image->pixbuf);
+  gl->BindTexture (GL_TEXTURE_2D, 0);
+
+  if (overlay->pbuftexture)
     gl->DeleteTextures (1, &overlay->pbuftexture);
-    gl->GenTextures (1, &overlay->pbuftexture);
-    if (overlay->type_file == 1) {
-      gl->BindTexture (GL_TEXTURE_2D, overlay->pbuftexture);
-      gl->TexImage2D (GL_TEXTURE_2D, 0, GL_RGBA,
-          (gint) overlay->width, (gint) overlay->height, 0,
-          GL_RGBA, GL_UNSIGNED_BYTE, overlay->pixbuf);
-    } else if (overlay->type_file == 2) {
-      gl->BindTexture (GL_TEXTURE_2D, overlay->pbuftexture);
-      gl->TexImage2D (GL_TEXTURE_2D, 0, overlay->internalFormat,
-          overlay->width, overlay->height, 0, overlay->format,
-          GL_UNSIGNED_BYTE, overlay->pixbuf);
-      gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-      gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    }
-  }
+
+  overlay->pbuftexture = data->texture;
+  overlay->width = image->width;
+  overlay->height = image->height;
+  overlay->type_file = image->type_file;
+}
+
+static gboolean
+gst_gl_overlay_filter (GstGLFilter * filter, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  GstGLOverlay *overlay = GST_GL_OVERLAY (filter);
+
+  if (!overlay->overlay_compositor
+      && gst_buffer_get_video_overlay_composition_meta (inbuf))
+    overlay->overlay_compositor = gst_gl_overlay_compositor_new
+        (filter->context);
+
+  if (overlay->overlay_compositor)
+    gst_gl_overlay_compositor_upload_overlays (overlay->overlay_compositor,
+        inbuf);
+
+  return gst_gl_filter_filter_texture (filter, inbuf, outbuf);
 }
 
 static gboolean
@@ -642,19 +847,32 @@ gst_gl_overlay_filter_texture (GstGLFilter * filter, guint in_tex,
     guint out_tex)
 {
   GstGLOverlay *overlay = GST_GL_OVERLAY (filter);
+  GstGLOverlayImage *image;
 
+  GST_OBJECT_LOCK (overlay);
   if (overlay->pbuf_has_changed && (overlay->location != NULL)) {
-    if ((overlay->type_file = gst_gl_overlay_load_png (filter)) == 0)
-      if ((overlay->type_file = gst_gl_overlay_load_jpeg (filter)) == 0)
-        overlay->pixbuf = NULL;
-    /* if loader failed then context is turned off */
-    gst_gl_context_thread_add (filter->context, init_pixbuf_texture, overlay);
-    if (overlay->pixbuf) {
-      free (overlay->pixbuf);
-      overlay->pixbuf = NULL;
-    }
+    image = g_slice_new0 (GstGLOverlayImage);
+    image->location = g_strdup (overlay->location);
+    image->serial = overlay->location_serial;
+
+    g_thread_pool_push (overlay->decode_pool, image, NULL);
+  }
+  overlay->pbuf_has_changed = FALSE;
+
+  image = overlay->pending_image;
+  overlay->pending_image = NULL;
+  GST_OBJECT_UNLOCK (overlay);
+
+  if (image) {
+    SwapImage data = { overlay, image, 0 };
 
-    overlay->pbuf_has_changed = FALSE;
+    gst_gl_context_gen_texture_full (filter->context, &data.texture, GL_RGBA8,
+        image->width, image->height, 1);
+    if (data.texture)
+      gst_gl_context_thread_add (filter->context,
+          (GstGLContextThreadFunc) init_pixbuf_texture, &data);
+
+    gst_gl_overlay_image_free (image);
   }
 
   gst_gl_filter_render_to_target (filter, TRUE, in_tex, out_tex,
@@ -669,42 +887,43 @@ user_warning_fn (png_structp png_ptr, png_const_charp warning_msg)
   g_warning ("%s\n", warning_msg);
 }
 
-#define LOAD_ERROR(msg) { GST_WARNING ("unable to load %s: %s", overlay->location, msg); return FALSE; }
+#define LOAD_ERROR(msg) { GST_WARNING ("unable to load %s: %s", image->location, msg); return FALSE; }
 
 static gint
-gst_gl_overlay_load_jpeg (GstGLFilter * filter)
+gst_gl_overlay_load_jpeg (GstGLOverlayImage * image)
 {
-  GstGLOverlay *overlay = GST_GL_OVERLAY (filter);
   FILE *fp = NULL;
   struct jpeg_decompress_struct cinfo;
   struct jpeg_error_mgr jerr;
   JSAMPROW j;
-  int i;
+  guchar *rgba;
+  int i, x;
+
+  fp = fopen (image->location, "rb");
+  if (!fp)
+    LOAD_ERROR ("file not found");
 
-  fp = fopen (overlay->location, "rb");
-  if (!fp) {
-    g_error ("error: couldn't open file!\n");
-    return 0;
-  }
   jpeg_create_decompress (&cinfo);
   cinfo.err = jpeg_std_error (&jerr);
   jpeg_stdio_src (&cinfo, fp);
   jpeg_read_header (&cinfo, TRUE);
+  /* grayscale images are expanded as well */
+  cinfo.out_color_space = JCS_RGB;
   jpeg_start_decompress (&cinfo);
-  overlay->width = cinfo.image_width;
-  overlay->height = cinfo.image_height;
-  overlay->internalFormat = cinfo.num_components;
-  if (cinfo.num_components == 1)
-    overlay->format = GL_LUMINANCE;
-  else
-    overlay->format = GL_RGB;
-  overlay->pixbuf = (GLubyte *) malloc (sizeof (GLubyte) * overlay->width
-      * overlay->height * overlay->internalFormat);
-  for (i = 0; i < overlay->height; ++i) {
-    j = (overlay->pixbuf +
-        (((int) overlay->height - (i +
-                    1)) * (int) overlay->width * overlay->internalFormat));
+  image->width = cinfo.output_width;
+  image->height = cinfo.output_height;
+  image->pixbuf = (guchar *) malloc (image->width * image->height * 4);
+  for (i = 0; i < image->height; ++i) {
+    /* decode into the end of the row and expand to RGBA in place */
+    rgba = image->pixbuf + (image->height - (i + 1)) * image->width * 4;
+    j = rgba + image->width;
     jpeg_read_scanlines (&cinfo, &j, 1);
+    for (x = 0; x < image->width; x++) {
+      rgba[4 * x + 0] = j[3 * x + 0];
+      rgba[4 * x + 1] = j[3 * x + 1];
+      rgba[4 * x + 2] = j[3 * x + 2];
+      rgba[4 * x + 3] = 0xff;
+    }
   }
   jpeg_finish_decompress (&cinfo);
   jpeg_destroy_decompress (&cinfo);
@@ -713,10 +932,8 @@ gst_gl_overlay_load_jpeg (GstGLFilter * filter)
 }
 
 static gint
-gst_gl_overlay_load_png (GstGLFilter * filter)
+gst_gl_overlay_load_png (GstGLOverlayImage * image)
 {
-  GstGLOverlay *overlay = GST_GL_OVERLAY (filter);
-
   png_structp png_ptr;
   png_infop info_ptr;
   png_uint_32 width = 0;
@@ -731,10 +948,7 @@ gst_gl_overlay_load_png (GstGLFilter * filter)
   png_byte magic[8];
   gint n_read;
 
-  if (!filter->context)
-    return 1;
-
-  if ((fp = fopen (overlay->location, "rb")) == NULL)
+  if ((fp = fopen (image->location, "rb")) == NULL)
     LOAD_ERROR ("file not found");
 
   /* Read magic number */
@@ -787,15 +1001,15 @@ gst_gl_overlay_load_png (GstGLFilter * filter)
     LOAD_ERROR ("color type is not rgb");
   }
 
-  overlay->width = width;
-  overlay->height = height;
+  image->width = width;
+  image->height = height;
 
-  overlay->pixbuf = (guchar *) malloc (sizeof (guchar) * width * height * 4);
+  image->pixbuf = (guchar *) malloc (sizeof (guchar) * width * height * 4);
 
   rows = (guchar **) malloc (sizeof (guchar *) * height);
 
   for (y = 0; y < height; ++y)
-    rows[y] = (guchar *) (overlay->pixbuf + y * width * 4);
+    rows[y] = (guchar *) (image->pixbuf + y * width * 4);
 
   png_read_image (png_ptr, rows);
 
@@ -51,12 +51,18 @@ struct _GstGLOverlay
   guint8 rotate_video;
   gint8 angle_png;
   gint8 angle_video;
-  guchar *pixbuf;
   gint width, height;
   GLuint pbuftexture;
-  GLint internalFormat;
-  GLenum format;
   gint type_file;               // 0 = No; 1 = PNG and 2 = JPEG
+
+  /* images are decoded off the streaming thread, the result is picked up
+   * by the next frame.  protected by the object lock */
+  GThreadPool *decode_pool;
+  guint location_serial;
+  gpointer pending_image;
+
+  GstGLOverlayCompositor *overlay_compositor;
+
   gfloat width_window;
   gfloat height_window;
   gfloat posx;
@@ -0,0 +1,1106 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-glscaleladder
+ *
+ * Produces several scaled renditions of a video stream from a single upload.
+ *
+ * <refsect2>
+ * <title>Scaling ladder</title>
+ * <para>
+ * The input frame is uploaded once.  Every request src pad negotiates its own
+ * size and format with downstream.  All renditions are then rendered in one
+ * pass on the GL thread, largest first, each one being scaled down from the
+ * smallest already rendered level that is still at least as big as itself.
+ * The renditions are downloaded into the format negotiated on their pad when
+ * downstream maps them.
+ * </para>
+ * </refsect2>
+ * <refsect2>
+ * <title>Examples</title>
+ * |[
+ * gst-launch-1.0 videotestsrc ! video/x-raw, width=1920, height=1080 ! glscaleladder name=l \
+ *   l.src_0 ! video/x-raw, width=1280, height=720, format=I420 ! queue ! fakesink \
+ *   l.src_1 ! video/x-raw, width=640, height=360, format=I420 ! queue ! fakesink \
+ *   l.src_2 ! video/x-raw, width=320, height=180, format=I420 ! queue ! fakesink
+ * ]| Produce three renditions of the same stream.
+ * FBO (Frame Buffer Object) and GLSL are required.
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstglscaleladder.h"
+
+#define GST_CAT_DEFAULT gst_gl_scale_ladder_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define USING_GLES2(context) (gst_gl_context_get_gl_api (context) & GST_GL_API_GLES2)
+
+static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (GST_GL_UPLOAD_FORMATS) "; "
+        GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_META_GST_VIDEO_GL_TEXTURE_UPLOAD_META,
+            "RGBA"))
+    );
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src_%u",
+    GST_PAD_SRC,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (GST_GL_DOWNLOAD_FORMATS))
+    );
+
+enum
+{
+  PROP_0,
+  PROP_OTHER_CONTEXT
+};
+
+/* per src pad state, attached to the pad as qdata */
+typedef struct _GstGLScaleLadderOutput
+{
+  GstGLScaleLadder *ladder;
+  GstPad *pad;
+
+  gboolean negotiated;
+  GstVideoInfo info;
+  GstBufferPool *pool;
+
+  GstGLContext *context;
+  GLuint fbo;
+  GLuint depthbuffer;
+
+  /* valid while a frame is being processed */
+  GstBuffer *outbuf;
+  GstVideoFrame frame;
+  guint tex;
+  guint src_tex;
+} GstGLScaleLadderOutput;
+
+static GQuark output_quark;
+
+#define DEBUG_INIT \
+  GST_DEBUG_CATEGORY_INIT (gst_gl_scale_ladder_debug, "glscaleladder", 0, "glscaleladder element"); \
+  output_quark = g_quark_from_static_string ("gst-gl-scale-ladder-output");
+
+#define gst_gl_scale_ladder_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstGLScaleLadder, gst_gl_scale_ladder,
+    GST_TYPE_ELEMENT, DEBUG_INIT);
+
+static void gst_gl_scale_ladder_finalize (GObject * object);
+static void gst_gl_scale_ladder_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_gl_scale_ladder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static GstPad *gst_gl_scale_ladder_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * req_name, const GstCaps * caps);
+static void gst_gl_scale_ladder_release_pad (GstElement * element,
+    GstPad * pad);
+static void gst_gl_scale_ladder_set_context (GstElement * element,
+    GstContext * context);
+static GstStateChangeReturn gst_gl_scale_ladder_change_state (GstElement *
+    element, GstStateChange transition);
+
+static GstFlowReturn gst_gl_scale_ladder_chain (GstPad * pad,
+    GstObject * parent, GstBuffer * buffer);
+static gboolean gst_gl_scale_ladder_sink_event (GstPad * pad,
+    GstObject * parent, GstEvent * event);
+static gboolean gst_gl_scale_ladder_sink_query (GstPad * pad,
+    GstObject * parent, GstQuery * query);
+static gboolean gst_gl_scale_ladder_src_query (GstPad * pad,
+    GstObject * parent, GstQuery * query);
+
+static void gst_gl_scale_ladder_reset (GstGLScaleLadder * ladder);
+static void _render_levels (GstGLContext * context, GstGLScaleLadder * ladder);
+static void _draw_level (gpointer stuff);
+
+static const gchar *ladder_v_src =
+    "attribute vec4 a_position;                          \n"
+    "attribute vec2 a_texCoord;                          \n"
+    "varying vec2 v_texCoord;                            \n"
+    "void main()                                         \n"
+    "{                                                   \n"
+    "   gl_Position = a_position;                        \n"
+    "   v_texCoord = a_texCoord;                         \n"
+    "}                                                   \n";
+
+static const gchar *ladder_f_src =
+    "varying vec2 v_texCoord;                            \n"
+    "uniform sampler2D s_texture;                        \n"
+    "void main()                                         \n"
+    "{                                                   \n"
+    "  gl_FragColor = texture2D( s_texture, v_texCoord );\n"
+    "}                                                   \n";
+
+static void
+gst_gl_scale_ladder_class_init (GstGLScaleLadderClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+
+  gobject_class = (GObjectClass *) klass;
+  element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->finalize = gst_gl_scale_ladder_finalize;
+  gobject_class->set_property = gst_gl_scale_ladder_set_property;
+  gobject_class->get_property = gst_gl_scale_ladder_get_property;
+
+  element_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_gl_scale_ladder_request_new_pad);
+  element_class->release_pad =
+      GST_DEBUG_FUNCPTR (gst_gl_scale_ladder_release_pad);
+  element_class->set_context = gst_gl_scale_ladder_set_context;
+  element_class->change_state = gst_gl_scale_ladder_change_state;
+
+  g_object_class_install_property (gobject_class, PROP_OTHER_CONTEXT,
+      g_param_spec_object ("other-context",
+          "External OpenGL context",
+          "Give an external OpenGL context with which to share textures",
+          GST_GL_TYPE_CONTEXT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_factory));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_factory));
+
+  gst_element_class_set_metadata (element_class, "OpenGL scaling ladder",
+      "Filter/Converter/Video/Scaler",
+      "Scales one video stream to several resolutions from a single upload",
+      "The GStreamer developers <gstreamer-devel@lists.freedesktop.org>");
+}
+
+static void
+gst_gl_scale_ladder_init (GstGLScaleLadder * ladder)
+{
+  ladder->sinkpad = gst_pad_new_from_static_template (&sink_factory, "sink");
+  gst_pad_set_chain_function (ladder->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_gl_scale_ladder_chain));
+  gst_pad_set_event_function (ladder->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_gl_scale_ladder_sink_event));
+  gst_pad_set_query_function (ladder->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_gl_scale_ladder_sink_query));
+  gst_element_add_pad (GST_ELEMENT (ladder), ladder->sinkpad);
+
+  ladder->srcpads = NULL;
+  ladder->next_srcpad = 0;
+  ladder->levels = g_ptr_array_new ();
+
+  gst_video_info_init (&ladder->in_info);
+}
+
+static void
+gst_gl_scale_ladder_finalize (GObject * object)
+{
+  GstGLScaleLadder *ladder = GST_GL_SCALE_LADDER (object);
+
+  g_ptr_array_free (ladder->levels, TRUE);
+
+  if (ladder->other_context) {
+    gst_object_unref (ladder->other_context);
+    ladder->other_context = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_gl_scale_ladder_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGLScaleLadder *ladder = GST_GL_SCALE_LADDER (object);
+
+  switch (prop_id) {
+    case PROP_OTHER_CONTEXT:
+    {
+      if (ladder->other_context)
+        gst_object_unref (ladder->other_context);
+      ladder->other_context = g_value_dup_object (value);
+      break;
+    }
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gl_scale_ladder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGLScaleLadder *ladder = GST_GL_SCALE_LADDER (object);
+
+  switch (prop_id) {
+    case PROP_OTHER_CONTEXT:
+      g_value_set_object (value, ladder->other_context);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gl_scale_ladder_set_context (GstElement * element, GstContext * context)
+{
+  GstGLScaleLadder *ladder = GST_GL_SCALE_LADDER (element);
+
+  gst_gl_handle_set_context (element, context, &ladder->display);
+}
+
+static GstGLScaleLadderOutput *
+_get_output (GstPad * pad)
+{
+  return g_object_get_qdata (G_OBJECT (pad), output_quark);
+}
+
+/* drops everything that depends on the negotiated caps or on the context */
+static void
+_output_reset (GstGLScaleLadderOutput * output)
+{
+  if (output->pool) {
+    gst_buffer_pool_set_active (output->pool, FALSE);
+    gst_object_unref (output->pool);
+    output->pool = NULL;
+  }
+
+  if (output->context) {
+    //blocking call, delete the FBO
+    if (output->fbo)
+      gst_gl_context_del_fbo (output->context, output->fbo,
+          output->depthbuffer);
+    gst_object_unref (output->context);
+    output->context = NULL;
+  }
+
+  output->fbo = 0;
+  output->depthbuffer = 0;
+  output->negotiated = FALSE;
+}
+
+static void
+_output_free (GstGLScaleLadderOutput * output)
+{
+  _output_reset (output);
+
+  g_slice_free (GstGLScaleLadderOutput, output);
+}
+
+/* Caps are negotiated separately for every src pad, in the chain function.
+ * A new pad only gets the events that go before the caps, the others are
+ * copied once the pad has caps so that downstream sees them in order. */
+static gboolean
+_copy_sticky_event (GstPad * pad, GstEvent ** event, gpointer user_data)
+{
+  GstPad *srcpad = GST_PAD (user_data);
+
+  if (GST_EVENT_TYPE (*event) < GST_EVENT_CAPS)
+    gst_pad_store_sticky_event (srcpad, *event);
+
+  return TRUE;
+}
+
+static gboolean
+_copy_sticky_event_after_caps (GstPad * pad, GstEvent ** event,
+    gpointer user_data)
+{
+  GstPad *srcpad = GST_PAD (user_data);
+
+  if (GST_EVENT_TYPE (*event) > GST_EVENT_CAPS)
+    gst_pad_store_sticky_event (srcpad, *event);
+
+  return TRUE;
+}
+
+static GstPad *
+gst_gl_scale_ladder_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * req_name, const GstCaps * caps)
+{
+  GstGLScaleLadder *ladder = GST_GL_SCALE_LADDER (element);
+  GstGLScaleLadderOutput *output;
+  GstPad *srcpad;
+  gchar *name;
+  guint serial;
+
+  GST_OBJECT_LOCK (ladder);
+  if (req_name == NULL || strlen (req_name) < 5
+      || !g_str_has_prefix (req_name, "src_")) {
+    /* no name given when requesting the pad, use next available int */
+    serial = ladder->next_srcpad++;
+  } else {
+    /* parse serial number from requested padname */
+    serial = g_ascii_strtoull (&req_name[4], NULL, 10);
+    if (serial >= ladder->next_srcpad)
+      ladder->next_srcpad = serial + 1;
+  }
+  GST_OBJECT_UNLOCK (ladder);
+
+  name = g_strdup_printf ("src_%u", serial);
+  srcpad = gst_pad_new_from_template (templ, name);
+  g_free (name);
+
+  output = g_slice_new0 (GstGLScaleLadderOutput);
+  output->ladder = ladder;
+  output->pad = srcpad;
+  gst_video_info_init (&output->info);
+  g_object_set_qdata_full (G_OBJECT (srcpad), output_quark, output,
+      (GDestroyNotify) _output_free);
+
+  gst_pad_set_query_function (srcpad,
+      GST_DEBUG_FUNCPTR (gst_gl_scale_ladder_src_query));
+
+  GST_OBJECT_LOCK (ladder);
+  ladder->srcpads = g_list_append (ladder->srcpads, srcpad);
+  GST_OBJECT_UNLOCK (ladder);
+
+  GST_DEBUG_OBJECT (element, "Adding pad %s", GST_PAD_NAME (srcpad));
+
+  gst_pad_set_active (srcpad, TRUE);
+  gst_pad_sticky_events_foreach (ladder->sinkpad, _copy_sticky_event, srcpad);
+  gst_element_add_pad (element, srcpad);
+
+  return srcpad;
+}
+
+static void
+gst_gl_scale_ladder_release_pad (GstElement * element, GstPad * pad)
+{
+  GstGLScaleLadder *ladder = GST_GL_SCALE_LADDER (element);
+
+  GST_OBJECT_LOCK (ladder);
+  if (G_UNLIKELY (g_list_find (ladder->srcpads, pad) == NULL)) {
+    GST_OBJECT_UNLOCK (ladder);
+    g_warning ("Unknown pad %s", GST_PAD_NAME (pad));
+    return;
+  }
+  ladder->srcpads = g_list_remove (ladder->srcpads, pad);
+  GST_OBJECT_UNLOCK (ladder);
+
+  GST_DEBUG_OBJECT (element, "Removing pad %s", GST_PAD_NAME (pad));
+
+  /* the output state goes away with the last reference to the pad, which may
+   * still be held by a streaming thread */
+  gst_pad_set_active (pad, FALSE);
+  gst_element_remove_pad (element, pad);
+}
+
+static void
+gst_gl_scale_ladder_reset (GstGLScaleLadder * ladder)
+{
+  GList *pads, *l;
+
+  GST_OBJECT_LOCK (ladder);
+  pads = g_list_copy (ladder->srcpads);
+  g_list_foreach (pads, (GFunc) gst_object_ref, NULL);
+  GST_OBJECT_UNLOCK (ladder);
+
+  for (l = pads; l; l = l->next)
+    _output_reset (_get_output (l->data));
+  g_list_free_full (pads, (GDestroyNotify) gst_object_unref);
+
+  g_ptr_array_set_size (ladder->levels, 0);
+
+  if (ladder->upload) {
+    gst_object_unref (ladder->upload);
+    ladder->upload = NULL;
+  }
+
+  if (ladder->context) {
+    //blocking call, wait the opengl thread has destroyed the shader
+    if (ladder->shader)
+      gst_gl_context_del_shader (ladder->context, ladder->shader);
+    ladder->shader = NULL;
+
+    if (ladder->frame) {
+      gst_object_unref (ladder->frame);
+      ladder->frame = NULL;
+    }
+
+    gst_object_unref (ladder->context);
+    ladder->context = NULL;
+  }
+
+  if (ladder->display) {
+    gst_object_unref (ladder->display);
+    ladder->display = NULL;
+  }
+
+  gst_video_info_init (&ladder->in_info);
+}
+
+static GstStateChangeReturn
+gst_gl_scale_ladder_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstGLScaleLadder *ladder = GST_GL_SCALE_LADDER (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (!gst_gl_ensure_display (ladder, &ladder->display))
+        return GST_STATE_CHANGE_FAILURE;
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      gst_gl_scale_ladder_reset (ladder);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static gboolean
+_ensure_context (GstGLScaleLadder * ladder)
+{
+  GError *error = NULL;
+  gchar *v_src, *f_src;
+  gboolean ret;
+
+  if (ladder->context)
+    return TRUE;
+
+  if (!gst_gl_ensure_display (ladder, &ladder->display))
+    return FALSE;
+
+  ladder->context = gst_gl_context_new (ladder->display);
+  if (!gst_gl_context_create (ladder->context, ladder->other_context, &error))
+    goto context_error;
+
+  ladder->frame = gst_gl_framebuffer_new (ladder->context);
+
+  if (USING_GLES2 (ladder->context)) {
+    v_src = g_strdup (ladder_v_src);
+    f_src = g_strconcat ("precision mediump float;\n", ladder_f_src, NULL);
+  } else {
+    v_src = g_strdup (ladder_v_src);
+    f_src = g_strdup (ladder_f_src);
+  }
+
+  //blocking call, wait the opengl thread has compiled the shader
+  ret = gst_gl_context_gen_shader (ladder->context, v_src, f_src,
+      &ladder->shader);
+
+  g_free (v_src);
+  g_free (f_src);
+
+  if (!ret) {
+    GST_ELEMENT_ERROR (ladder, RESOURCE, NOT_FOUND,
+        ("%s", "Failed to compile the scaling shader"), (NULL));
+    return FALSE;
+  }
+
+  return TRUE;
+
+context_error:
+  {
+    GST_ELEMENT_ERROR (ladder, RESOURCE, NOT_FOUND, ("%s", error->message),
+        (NULL));
+    g_clear_error (&error);
+    gst_object_unref (ladder->context);
+    ladder->context = NULL;
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_gl_scale_ladder_set_caps (GstGLScaleLadder * ladder, GstCaps * caps)
+{
+  GstVideoInfo in_info, out_info;
+  GList *l;
+
+  if (!gst_video_info_from_caps (&in_info, caps))
+    goto wrong_caps;
+
+  if (!_ensure_context (ladder))
+    return FALSE;
+
+  gst_video_info_set_format (&out_info, GST_VIDEO_FORMAT_RGBA,
+      GST_VIDEO_INFO_WIDTH (&in_info), GST_VIDEO_INFO_HEIGHT (&in_info));
+
+  if (ladder->upload)
+    gst_object_unref (ladder->upload);
+  ladder->upload = gst_gl_upload_new (ladder->context);
+  if (!gst_gl_upload_init_format (ladder->upload, in_info, out_info))
+    goto upload_error;
+
+  ladder->in_info = in_info;
+
+  /* every rendition has to renegotiate against the new input */
+  GST_OBJECT_LOCK (ladder);
+  for (l = ladder->srcpads; l; l = l->next)
+    _get_output (l->data)->negotiated = FALSE;
+  GST_OBJECT_UNLOCK (ladder);
+
+  GST_DEBUG_OBJECT (ladder, "set_caps %dx%d", GST_VIDEO_INFO_WIDTH (&in_info),
+      GST_VIDEO_INFO_HEIGHT (&in_info));
+
+  return TRUE;
+
+/* ERRORS */
+wrong_caps:
+  {
+    GST_WARNING_OBJECT (ladder, "Wrong caps %" GST_PTR_FORMAT, caps);
+    return FALSE;
+  }
+upload_error:
+  {
+    GST_ELEMENT_ERROR (ladder, RESOURCE, NOT_FOUND,
+        ("%s", "Failed to init upload format"), (NULL));
+    gst_object_unref (ladder->upload);
+    ladder->upload = NULL;
+    return FALSE;
+  }
+}
+
+/* Fixate the size of a rendition.  Anything downstream left open is taken
+ * from the input while keeping the input display aspect ratio with square
+ * pixels on the output. */
+static GstCaps *
+_fixate_output_caps (GstGLScaleLadder * ladder, GstCaps * caps)
+{
+  GstStructure *s;
+  gint in_w, in_h, par_n, par_d;
+  gint w = 0, h = 0;
+
+  caps = gst_caps_truncate (caps);
+  caps = gst_caps_make_writable (caps);
+  s = gst_caps_get_structure (caps, 0);
+
+  in_w = GST_VIDEO_INFO_WIDTH (&ladder->in_info);
+  in_h = GST_VIDEO_INFO_HEIGHT (&ladder->in_info);
+  par_n = GST_VIDEO_INFO_PAR_N (&ladder->in_info);
+  par_d = GST_VIDEO_INFO_PAR_D (&ladder->in_info);
+
+  gst_structure_get_int (s, "width", &w);
+  gst_structure_get_int (s, "height", &h);
+
+  if (w && !h)
+    h = gst_util_uint64_scale_int (w, in_h * par_d, in_w * par_n);
+  else if (h && !w)
+    w = gst_util_uint64_scale_int (h, in_w * par_n, in_h * par_d);
+  else if (!w && !h) {
+    w = in_w;
+    h = in_h;
+  }
+
+  gst_structure_fixate_field_nearest_int (s, "width", w);
+  gst_structure_fixate_field_nearest_int (s, "height", h);
+
+  if (gst_structure_has_field (s, "pixel-aspect-ratio"))
+    gst_structure_fixate_field_nearest_fraction (s, "pixel-aspect-ratio", 1, 1);
+  else
+    gst_structure_set (s, "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1, NULL);
+
+  if (gst_structure_has_field (s, "framerate"))
+    gst_structure_fixate_field_nearest_fraction (s, "framerate",
+        GST_VIDEO_INFO_FPS_N (&ladder->in_info),
+        GST_VIDEO_INFO_FPS_D (&ladder->in_info));
+  else
+    gst_structure_set (s, "framerate", GST_TYPE_FRACTION,
+        GST_VIDEO_INFO_FPS_N (&ladder->in_info),
+        GST_VIDEO_INFO_FPS_D (&ladder->in_info), NULL);
+
+  return gst_caps_fixate (caps);
+}
+
+static gboolean
+_output_decide_allocation (GstGLScaleLadder * ladder,
+    GstGLScaleLadderOutput * output, GstCaps * caps)
+{
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  GstQuery *query;
+  guint min, max, size;
+
+  query = gst_query_new_allocation (caps, TRUE);
+  if (!gst_pad_peer_query (output->pad, query)) {
+    /* not a problem, just debug a little */
+    GST_DEBUG_OBJECT (output->pad, "peer ALLOCATION query failed");
+  }
+
+  if (gst_query_get_n_allocation_pools (query) > 0) {
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+
+    /* we render straight into the textures of the pool so only take
+     * GL pools that live in our context and keep the frame in a single
+     * texture */
+    if (pool && GST_IS_GL_BUFFER_POOL (pool)) {
+      config = gst_buffer_pool_get_config (pool);
+      if (GST_GL_BUFFER_POOL (pool)->context != ladder->context
+          || gst_buffer_pool_config_has_option (config,
+              GST_BUFFER_POOL_OPTION_GL_PLANAR)) {
+        gst_object_unref (pool);
+        pool = NULL;
+      }
+      gst_structure_free (config);
+    } else if (pool) {
+      gst_object_unref (pool);
+      pool = NULL;
+    }
+  } else {
+    size = GST_VIDEO_INFO_SIZE (&output->info);
+    min = max = 0;
+  }
+  gst_query_unref (query);
+
+  if (!pool) {
+    pool = gst_gl_buffer_pool_new (ladder->context);
+    size = GST_VIDEO_INFO_SIZE (&output->info);
+  }
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, size, min, max);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+  if (!gst_buffer_pool_set_config (pool, config)
+      || !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (output->pad, "failed to configure the buffer pool");
+    gst_object_unref (pool);
+    return FALSE;
+  }
+
+  output->pool = pool;
+
+  return TRUE;
+}
+
+static gboolean
+_negotiate_output (GstGLScaleLadder * ladder, GstGLScaleLadderOutput * output)
+{
+  GstCaps *templ, *caps;
+  gboolean ret = FALSE;
+
+  _output_reset (output);
+
+  templ = gst_pad_get_pad_template_caps (output->pad);
+  caps = gst_pad_peer_query_caps (output->pad, templ);
+  gst_caps_unref (templ);
+
+  if (gst_caps_is_empty (caps)) {
+    gst_caps_unref (caps);
+    return FALSE;
+  }
+
+  caps = _fixate_output_caps (ladder, caps);
+
+  GST_DEBUG_OBJECT (output->pad, "negotiating %" GST_PTR_FORMAT, caps);
+
+  if (!gst_video_info_from_caps (&output->info, caps))
+    goto out;
+
+  if (!gst_pad_set_caps (output->pad, caps))
+    goto out;
+
+  /* segment and tags follow the caps */
+  gst_pad_sticky_events_foreach (ladder->sinkpad,
+      _copy_sticky_event_after_caps, output->pad);
+
+  output->context = gst_object_ref (ladder->context);
+
+  //blocking call, generate a FBO
+  if (!gst_gl_context_gen_fbo (output->context,
+          GST_VIDEO_INFO_WIDTH (&output->info),
+          GST_VIDEO_INFO_HEIGHT (&output->info), &output->fbo,
+          &output->depthbuffer))
+    goto out;
+
+  if (!_output_decide_allocation (ladder, output, caps))
+    goto out;
+
+  output->negotiated = TRUE;
+  ret = TRUE;
+
+out:
+  gst_caps_unref (caps);
+
+  return ret;
+}
+
+static gint
+_compare_level_size (gconstpointer a, gconstpointer b)
+{
+  const GstGLScaleLadderOutput *out_a = *(GstGLScaleLadderOutput **) a;
+  const GstGLScaleLadderOutput *out_b = *(GstGLScaleLadderOutput **) b;
+  gint64 area_a, area_b;
+
+  area_a = (gint64) GST_VIDEO_INFO_WIDTH (&out_a->info) *
+      GST_VIDEO_INFO_HEIGHT (&out_a->info);
+  area_b = (gint64) GST_VIDEO_INFO_WIDTH (&out_b->info) *
+      GST_VIDEO_INFO_HEIGHT (&out_b->info);
+
+  return area_a < area_b ? 1 : (area_a > area_b ? -1 : 0);
+}
+
+/* Levels are sorted largest first.  Each one is scaled from the smallest
+ * previous level that still covers it so that no single pass has to reduce
+ * by a large factor, falling back to the uploaded input. */
+static void
+_assign_level_sources (GstGLScaleLadder * ladder, guint in_tex)
+{
+  guint i;
+  gint j;
+
+  g_ptr_array_sort (ladder->levels, _compare_level_size);
+
+  for (i = 0; i < ladder->levels->len; i++) {
+    GstGLScaleLadderOutput *output = g_ptr_array_index (ladder->levels, i);
+    gint width = GST_VIDEO_INFO_WIDTH (&output->info);
+    gint height = GST_VIDEO_INFO_HEIGHT (&output->info);
+
+    output->src_tex = in_tex;
+
+    for (j = i - 1; j >= 0; j--) {
+      GstGLScaleLadderOutput *prev = g_ptr_array_index (ladder->levels, j);
+
+      if (GST_VIDEO_INFO_WIDTH (&prev->info) >= width
+          && GST_VIDEO_INFO_HEIGHT (&prev->info) >= height) {
+        output->src_tex = prev->tex;
+        break;
+      }
+    }
+
+    GST_TRACE_OBJECT (output->pad, "level %ux%u texture:%u from texture:%u",
+        width, height, output->tex, output->src_tex);
+  }
+}
+
+static GstFlowReturn
+_combine_flows (GstFlowReturn ret, GstFlowReturn flow)
+{
+  /* errors and flushing win.  Not linked and not negotiated only concern
+   * their own pad, one output taking the buffer is enough to keep going and
+   * the stream only fails when every output does */
+  if (ret == GST_FLOW_FLUSHING || ret < GST_FLOW_NOT_NEGOTIATED)
+    return ret;
+  if (flow == GST_FLOW_FLUSHING || flow < GST_FLOW_NOT_NEGOTIATED)
+    return flow;
+  if (flow == GST_FLOW_OK || ret == GST_FLOW_OK)
+    return GST_FLOW_OK;
+  if (flow == GST_FLOW_EOS || ret == GST_FLOW_EOS)
+    return GST_FLOW_EOS;
+  if (flow == GST_FLOW_NOT_NEGOTIATED)
+    return GST_FLOW_NOT_NEGOTIATED;
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_gl_scale_ladder_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstGLScaleLadder *ladder = GST_GL_SCALE_LADDER (parent);
+  GstFlowReturn ret = GST_FLOW_NOT_LINKED;
+  GPtrArray *pads;
+  GList *l;
+  guint in_tex;
+  guint i;
+
+  if (!ladder->upload) {
+    gst_buffer_unref (buf);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+
+  /* hold a reference on the pads so they can be released concurrently */
+  pads = g_ptr_array_new_with_free_func ((GDestroyNotify) gst_object_unref);
+  GST_OBJECT_LOCK (ladder);
+  for (l = ladder->srcpads; l; l = l->next)
+    g_ptr_array_add (pads, gst_object_ref (l->data));
+  GST_OBJECT_UNLOCK (ladder);
+
+  g_ptr_array_set_size (ladder->levels, 0);
+
+  for (i = 0; i < pads->len; i++) {
+    GstPad *srcpad = g_ptr_array_index (pads, i);
+    GstGLScaleLadderOutput *output = _get_output (srcpad);
+    GstFlowReturn flow;
+
+    if (!gst_pad_is_linked (srcpad))
+      continue;
+
+    if (gst_pad_check_reconfigure (srcpad) || !output->negotiated) {
+      if (!_negotiate_output (ladder, output)) {
+        GST_WARNING_OBJECT (srcpad, "failed to negotiate");
+        ret = _combine_flows (ret, GST_FLOW_NOT_NEGOTIATED);
+        continue;
+      }
+    }
+
+    flow = gst_buffer_pool_acquire_buffer (output->pool, &output->outbuf,
+        NULL);
+    if (flow != GST_FLOW_OK) {
+      GST_WARNING_OBJECT (srcpad, "failed to acquire an output buffer: %s",
+          gst_flow_get_name (flow));
+      ret = _combine_flows (ret, flow);
+      continue;
+    }
+
+    if (!gst_video_frame_map (&output->frame, &output->info, output->outbuf,
+            GST_MAP_WRITE | GST_MAP_GL)) {
+      gst_buffer_unref (output->outbuf);
+      output->outbuf = NULL;
+      continue;
+    }
+
+    output->tex = *(guint *) output->frame.data[0];
+    g_ptr_array_add (ladder->levels, output);
+  }
+
+  if (ladder->levels->len == 0)
+    goto done;
+
+  /* upload once for every rendition */
+  if (!gst_gl_upload_perform_with_buffer (ladder->upload, buf, &in_tex)) {
+    GST_ELEMENT_ERROR (ladder, RESOURCE, NOT_FOUND,
+        ("%s", "Failed to upload video frame"), (NULL));
+    ret = GST_FLOW_ERROR;
+  } else {
+    _assign_level_sources (ladder, in_tex);
+
+    //blocking call, render the whole ladder in one go
+    gst_gl_context_thread_add (ladder->context,
+        (GstGLContextThreadFunc) _render_levels, ladder);
+
+    gst_gl_upload_release_buffer (ladder->upload);
+  }
+
+  for (i = 0; i < ladder->levels->len; i++) {
+    GstGLScaleLadderOutput *output = g_ptr_array_index (ladder->levels, i);
+
+    gst_video_frame_unmap (&output->frame);
+    /* the renditions may come from pools of downstream contexts */
+    if (gst_is_gl_memory (output->frame.map[0].memory))
+      gst_gl_memory_set_sync_point ((GstGLMemory *)
+          output->frame.map[0].memory, ladder->context);
+  }
+
+  for (i = 0; i < ladder->levels->len; i++) {
+    GstGLScaleLadderOutput *output = g_ptr_array_index (ladder->levels, i);
+    GstBuffer *outbuf = output->outbuf;
+
+    output->outbuf = NULL;
+
+    if (ret == GST_FLOW_ERROR) {
+      gst_buffer_unref (outbuf);
+      continue;
+    }
+
+    gst_buffer_copy_into (outbuf, buf,
+        GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+
+    ret = _combine_flows (ret, gst_pad_push (output->pad, outbuf));
+  }
+
+done:
+  g_ptr_array_set_size (ladder->levels, 0);
+  g_ptr_array_unref (pads);
+  gst_buffer_unref (buf);
+
+  return ret;
+}
+
+/* Called in the gl thread */
+static void
+_render_levels (GstGLContext * context, GstGLScaleLadder * ladder)
+{
+  guint i;
+
+  for (i = 0; i < ladder->levels->len; i++) {
+    GstGLScaleLadderOutput *output = g_ptr_array_index (ladder->levels, i);
+
+    gst_gl_framebuffer_use_v2 (ladder->frame,
+        GST_VIDEO_INFO_WIDTH (&output->info),
+        GST_VIDEO_INFO_HEIGHT (&output->info), output->fbo,
+        output->depthbuffer, output->tex, _draw_level, output);
+  }
+}
+
+static void
+_draw_level (gpointer stuff)
+{
+  GstGLScaleLadderOutput *output = stuff;
+  GstGLScaleLadder *ladder = output->ladder;
+  GstGLFuncs *gl = ladder->context->gl_vtable;
+  GLint attr_position_loc, attr_texture_loc;
+
+  gst_gl_shader_use (ladder->shader);
+
+  attr_position_loc =
+      gst_gl_shader_get_attribute_location (ladder->shader, "a_position");
+  attr_texture_loc =
+      gst_gl_shader_get_attribute_location (ladder->shader, "a_texCoord");
+
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, output->src_tex);
+  gst_gl_shader_set_uniform_1i (ladder->shader, "s_texture", 0);
+
+  gst_gl_context_bind_geometry (ladder->context, GST_GL_GEOMETRY_QUAD,
+      attr_position_loc, attr_texture_loc);
+  gst_gl_context_draw_geometry (ladder->context, 0, 1);
+  gst_gl_context_unbind_geometry (ladder->context);
+
+  gl->BindTexture (GL_TEXTURE_2D, 0);
+
+  gst_gl_context_clear_shader (ladder->context);
+}
+
+static gboolean
+_push_to_negotiated (GstPad * srcpad, gpointer user_data)
+{
+  GstEvent *event = user_data;
+
+  if (_get_output (srcpad)->negotiated)
+    gst_pad_push_event (srcpad, gst_event_ref (event));
+
+  return FALSE;
+}
+
+static gboolean
+gst_gl_scale_ladder_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstGLScaleLadder *ladder = GST_GL_SCALE_LADDER (parent);
+  gboolean res;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:
+    {
+      GstCaps *caps;
+
+      /* every src pad negotiates its own caps */
+      gst_event_parse_caps (event, &caps);
+      res = gst_gl_scale_ladder_set_caps (ladder, caps);
+      gst_event_unref (event);
+      break;
+    }
+    default:
+      if (GST_EVENT_IS_STICKY (event)
+          && GST_EVENT_TYPE (event) > GST_EVENT_CAPS
+          && GST_EVENT_TYPE (event) != GST_EVENT_EOS) {
+        /* the outputs without caps get segment and tags on negotiation, from
+         * the sticky events of the sink pad */
+        gst_pad_forward (pad, _push_to_negotiated, event);
+        gst_event_unref (event);
+        res = TRUE;
+      } else {
+        res = gst_pad_event_default (pad, parent, event);
+      }
+      break;
+  }
+
+  return res;
+}
+
+static gboolean
+gst_gl_scale_ladder_sink_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  GstGLScaleLadder *ladder = GST_GL_SCALE_LADDER (parent);
+  gboolean res;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:
+    {
+      res = gst_gl_handle_context_query ((GstElement *) ladder, query,
+          &ladder->display);
+      break;
+    }
+    case GST_QUERY_ALLOCATION:
+    {
+      GstBufferPool *pool;
+      GstStructure *config;
+      GstVideoInfo info;
+      GstCaps *caps;
+      gboolean need_pool;
+
+      gst_query_parse_allocation (query, &caps, &need_pool);
+
+      if (caps == NULL || !gst_video_info_from_caps (&info, caps)) {
+        res = FALSE;
+        break;
+      }
+
+      if (!_ensure_context (ladder)) {
+        res = FALSE;
+        break;
+      }
+
+      if (need_pool) {
+        pool = gst_gl_buffer_pool_new (ladder->context);
+
+        config = gst_buffer_pool_get_config (pool);
+        gst_buffer_pool_config_set_params (config, caps, info.size, 0, 0);
+        if (!gst_buffer_pool_set_config (pool, config)) {
+          gst_object_unref (pool);
+          res = FALSE;
+          break;
+        }
+
+        gst_query_add_allocation_pool (query, pool, info.size, 1, 0);
+        gst_object_unref (pool);
+      }
+
+      gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, 0);
+      res = TRUE;
+      break;
+    }
+    default:
+      res = gst_pad_query_default (pad, parent, query);
+      break;
+  }
+
+  return res;
+}
+
+static gboolean
+gst_gl_scale_ladder_src_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  GstGLScaleLadder *ladder = GST_GL_SCALE_LADDER (parent);
+  gboolean res;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:
+    {
+      res = gst_gl_handle_context_query ((GstElement *) ladder, query,
+          &ladder->display);
+      break;
+    }
+    default:
+      res = gst_pad_query_default (pad, parent, query);
+      break;
+  }
+
+  return res;
+}
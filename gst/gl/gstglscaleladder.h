@@ -0,0 +1,74 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_GL_SCALE_LADDER_H_
+#define _GST_GL_SCALE_LADDER_H_
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include <gst/gl/gl.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GL_SCALE_LADDER            (gst_gl_scale_ladder_get_type())
+#define GST_GL_SCALE_LADDER(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_SCALE_LADDER,GstGLScaleLadder))
+#define GST_IS_GL_SCALE_LADDER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_SCALE_LADDER))
+#define GST_GL_SCALE_LADDER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GST_TYPE_GL_SCALE_LADDER,GstGLScaleLadderClass))
+#define GST_IS_GL_SCALE_LADDER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GST_TYPE_GL_SCALE_LADDER))
+#define GST_GL_SCALE_LADDER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GST_TYPE_GL_SCALE_LADDER,GstGLScaleLadderClass))
+
+typedef struct _GstGLScaleLadder GstGLScaleLadder;
+typedef struct _GstGLScaleLadderClass GstGLScaleLadderClass;
+
+struct _GstGLScaleLadder
+{
+  GstElement element;
+
+  GstPad *sinkpad;
+
+  /* request src pads, protected by the object lock */
+  GList *srcpads;
+  guint next_srcpad;
+
+  GstVideoInfo in_info;
+
+  GstGLDisplay *display;
+  GstGLContext *context;
+  GstGLContext *other_context;
+
+  GstGLUpload *upload;
+  GstGLFramebuffer *frame;
+  GstGLShader *shader;
+
+  /* outputs rendered for the current frame, largest first */
+  GPtrArray *levels;
+};
+
+struct _GstGLScaleLadderClass
+{
+  GstElementClass element_class;
+};
+
+GType gst_gl_scale_ladder_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_GL_SCALE_LADDER_H_ */
@@ -0,0 +1,1250 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-glstats
+ *
+ * Measures the luma of the frames going through it on the GPU and posts
+ * the results as element messages.  The element works in passthrough: the
+ * frames are passed on untouched, only the measured ones are uploaded when
+ * they are not textures already, and nothing is rendered for the output.
+ *
+ * The frame is reduced to 4x4 pixel blocks in one pass and every region is
+ * then reduced by a factor of four in each direction per pass down to a
+ * single texel, so only a few floats per region are read back instead of
+ * the frame.  On desktop OpenGL the read back goes through pixel buffer
+ * objects and the results of a frame are posted two measurements later,
+ * when the GPU is done with them.  The messages carry the timestamps of
+ * the frame that was measured.
+ *
+ * The "glstats" message contains the following fields:
+ * <itemizedlist>
+ * <listitem>
+ *   <para>
+ *   #GstClockTime
+ *   <classname>&quot;timestamp&quot;</classname>,
+ *   <classname>&quot;stream-time&quot;</classname>,
+ *   <classname>&quot;running-time&quot;</classname>,
+ *   <classname>&quot;duration&quot;</classname>:
+ *   of the measured frame.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #gdouble
+ *   <classname>&quot;mean&quot;</classname>,
+ *   <classname>&quot;min&quot;</classname>,
+ *   <classname>&quot;max&quot;</classname>:
+ *   luma of the frame, between 0.0 and 1.0.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #gdouble
+ *   <classname>&quot;motion&quot;</classname>:
+ *   mean absolute difference of the 4x4 block luma since the previous
+ *   measurement.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #GstValueArray of #gdouble
+ *   <classname>&quot;histogram&quot;</classname>:
+ *   fraction of the pixels in each luma bin, only present when
+ *   #GstGLStats:histogram-bins is not 0.  Every other pixel of every
+ *   other line is counted.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #GstValueArray of #GstStructure
+ *   <classname>&quot;rois&quot;</classname>:
+ *   one "roi" structure per region of #GstGLStats:rois that intersects the
+ *   frame, with the "x", "y", "width" and "height" actually measured and
+ *   the "mean", "min", "max" and "motion" fields described above.  Regions
+ *   are aligned to 4 pixels.
+ *   </para>
+ * </listitem>
+ * </itemizedlist>
+ *
+ * <refsect2>
+ * <title>Examples</title>
+ * |[
+ * gst-launch-1.0 -m videotestsrc pattern=ball ! glupload ! glstats rois="0,0,160,120;160,120,160,120" ! glimagesink
+ * ]|
+ * FBO (Frame Buffer Object), GLSL (OpenGL Shading Language) and floating
+ * point render targets are required.
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gstglstats.h"
+
+#ifndef GL_RGBA32F
+#define GL_RGBA32F 0x8814
+#endif
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_READ_ONLY
+#define GL_READ_ONLY 0x88B8
+#endif
+#ifndef GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS
+#define GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS 0x8B4C
+#endif
+
+#define GST_CAT_DEFAULT gst_gl_stats_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+enum
+{
+  PROP_0,
+  PROP_ROIS,
+  PROP_HISTOGRAM_BINS,
+  PROP_INTERVAL
+};
+
+#define DEFAULT_HISTOGRAM_BINS 64
+#define DEFAULT_INTERVAL 1
+
+#define MAX_HISTOGRAM_BINS 256
+/* the full frame takes the first texel of the results */
+#define MAX_ROIS 255
+
+/* every other pixel of every other line goes in the histogram */
+#define HISTOGRAM_STEP 2
+
+typedef struct
+{
+  gint x, y, width, height;
+} GstGLStatsRect;
+
+#define DEBUG_INIT \
+  GST_DEBUG_CATEGORY_INIT (gst_gl_stats_debug, "glstats", 0, "glstats element");
+
+G_DEFINE_TYPE_WITH_CODE (GstGLStats, gst_gl_stats, GST_TYPE_GL_FILTER,
+    DEBUG_INIT);
+
+static void gst_gl_stats_finalize (GObject * object);
+static void gst_gl_stats_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_gl_stats_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static gboolean gst_gl_stats_sink_event (GstBaseTransform * trans,
+    GstEvent * event);
+static GstCaps *gst_gl_stats_transform_caps (GstBaseTransform * trans,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter);
+static gboolean gst_gl_stats_propose_allocation (GstBaseTransform * trans,
+    GstQuery * decide_query, GstQuery * query);
+static GstFlowReturn gst_gl_stats_transform_ip (GstBaseTransform * trans,
+    GstBuffer * buf);
+
+static void gst_gl_stats_init_gl_resources (GstGLFilter * filter);
+static void gst_gl_stats_reset_gl_resources (GstGLFilter * filter);
+static void gst_gl_stats_reset_resources (GstGLFilter * filter);
+
+/* *INDENT-OFF* */
+static const gchar *quad_vertex_source =
+  "attribute vec4 a_position;\n"
+  "void main()\n"
+  "{\n"
+  "   gl_Position = a_position;\n"
+  "}\n";
+
+/* the sums of the reduction need all the precision there is */
+#define STATS_FRAGMENT_HEADER \
+  "#ifdef GL_ES\n" \
+  "#ifdef GL_FRAGMENT_PRECISION_HIGH\n" \
+  "precision highp float;\n" \
+  "#else\n" \
+  "precision mediump float;\n" \
+  "#endif\n" \
+  "#endif\n" \
+  "const vec3 luma = vec3(0.299, 0.587, 0.114);\n"
+
+/* every texel is a 4x4 block of the frame with its mean, min and max luma
+ * and how much the mean moved since the previous measurement.  Blocks on
+ * the right and bottom edges only look at the pixels inside the frame */
+static const gchar *block_fragment_source =
+  STATS_FRAGMENT_HEADER
+  "uniform sampler2D tex;\n"
+  "uniform sampler2D prev;\n"
+  "uniform vec2 size;\n"
+  "uniform vec2 level_size;\n"
+  "uniform float reset;\n"
+  "void main () {\n"
+  "  vec2 texel = floor(gl_FragCoord.xy);\n"
+  "  vec2 block = texel * 4.0;\n"
+  "  float sum = 0.0;\n"
+  "  float n = 0.0;\n"
+  "  float lo = 1.0;\n"
+  "  float hi = 0.0;\n"
+  "  for (int j = 0; j < 4; j++) {\n"
+  "    for (int i = 0; i < 4; i++) {\n"
+  "      vec2 xy = block + vec2(float(i), float(j));\n"
+  "      if (xy.x < size.x && xy.y < size.y) {\n"
+  "        float l = dot(luma, texture2D(tex, (xy + 0.5) / size).rgb);\n"
+  "        sum += l;\n"
+  "        n += 1.0;\n"
+  "        lo = min(lo, l);\n"
+  "        hi = max(hi, l);\n"
+  "      }\n"
+  "    }\n"
+  "  }\n"
+  "  float mean = sum / n;\n"
+  "  float before = texture2D(prev, (texel + 0.5) / level_size).r;\n"
+  "  gl_FragColor = vec4(mean, lo, hi, abs(mean - before) * (1.0 - reset));\n"
+  "}\n";
+
+/* reduces the 4x4 texels of src_rect under every output texel, the means
+ * and the motion are summed and divided by the area when read back */
+static const gchar *reduce_fragment_source =
+  STATS_FRAGMENT_HEADER
+  "uniform sampler2D tex;\n"
+  "uniform vec2 tex_size;\n"
+  "uniform vec4 src_rect;\n"
+  "uniform vec2 dst_origin;\n"
+  "void main () {\n"
+  "  vec2 block = (floor(gl_FragCoord.xy) - dst_origin) * 4.0;\n"
+  "  vec4 acc = vec4(0.0, 1.0, 0.0, 0.0);\n"
+  "  for (int j = 0; j < 4; j++) {\n"
+  "    for (int i = 0; i < 4; i++) {\n"
+  "      vec2 xy = block + vec2(float(i), float(j));\n"
+  "      if (xy.x < src_rect.z && xy.y < src_rect.w) {\n"
+  "        vec4 t = texture2D(tex, (src_rect.xy + xy + 0.5) / tex_size);\n"
+  "        acc.r += t.r;\n"
+  "        acc.g = min(acc.g, t.g);\n"
+  "        acc.b = max(acc.b, t.b);\n"
+  "        acc.a += t.a;\n"
+  "      }\n"
+  "    }\n"
+  "  }\n"
+  "  gl_FragColor = acc;\n"
+  "}\n";
+
+/* one point per sampled pixel, moved to the texel of its bin and added up
+ * with blending */
+static const gchar *histogram_vertex_source =
+  "attribute vec2 a_texcoord;\n"
+  "uniform sampler2D tex;\n"
+  "uniform float bins;\n"
+  "void main()\n"
+  "{\n"
+  "   const vec3 luma = vec3(0.299, 0.587, 0.114);\n"
+  "   float l = dot(luma, texture2DLod(tex, a_texcoord, 0.0).rgb);\n"
+  "   float bin = min(floor(l * bins), bins - 1.0);\n"
+  "   gl_Position = vec4((bin + 0.5) / bins * 2.0 - 1.0, 0.0, 0.0, 1.0);\n"
+  "   gl_PointSize = 1.0;\n"
+  "}\n";
+
+static const gchar *histogram_fragment_source =
+  "#ifdef GL_ES\n"
+  "precision mediump float;\n"
+  "#endif\n"
+  "void main () {\n"
+  "  gl_FragColor = vec4(1.0);\n"
+  "}\n";
+/* *INDENT-ON* */
+
+static void
+gst_gl_stats_class_init (GstGLStatsClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+
+  gobject_class = (GObjectClass *) klass;
+  element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->finalize = gst_gl_stats_finalize;
+  gobject_class->set_property = gst_gl_stats_set_property;
+  gobject_class->get_property = gst_gl_stats_get_property;
+
+  GST_BASE_TRANSFORM_CLASS (klass)->sink_event = gst_gl_stats_sink_event;
+  GST_BASE_TRANSFORM_CLASS (klass)->transform_caps =
+      gst_gl_stats_transform_caps;
+  GST_BASE_TRANSFORM_CLASS (klass)->propose_allocation =
+      gst_gl_stats_propose_allocation;
+  GST_BASE_TRANSFORM_CLASS (klass)->transform_ip = gst_gl_stats_transform_ip;
+  GST_BASE_TRANSFORM_CLASS (klass)->transform_ip_on_passthrough = TRUE;
+  GST_BASE_TRANSFORM_CLASS (klass)->passthrough_on_same_caps = TRUE;
+
+  GST_GL_FILTER_CLASS (klass)->display_init_cb =
+      gst_gl_stats_init_gl_resources;
+  GST_GL_FILTER_CLASS (klass)->display_reset_cb =
+      gst_gl_stats_reset_gl_resources;
+  GST_GL_FILTER_CLASS (klass)->onStop = gst_gl_stats_reset_resources;
+
+  g_object_class_install_property (gobject_class, PROP_ROIS,
+      g_param_spec_string ("rois", "Regions of interest",
+          "Regions measured on their own as \"x,y,width,height\" in pixels, "
+          "separated by ';'", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_HISTOGRAM_BINS,
+      g_param_spec_uint ("histogram-bins", "Histogram bins",
+          "Number of bins of the luma histogram, 0 disables it", 0,
+          MAX_HISTOGRAM_BINS, DEFAULT_HISTOGRAM_BINS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_INTERVAL,
+      g_param_spec_uint ("interval", "Interval",
+          "Measure one frame out of this many", 1, G_MAXUINT,
+          DEFAULT_INTERVAL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_metadata (element_class, "OpenGL statistics",
+      "Filter/Analyzer/Video",
+      "Measures luma statistics and histograms on the GPU",
+      "The GStreamer developers");
+}
+
+static void
+gst_gl_stats_init (GstGLStats * stats)
+{
+  stats->rois = g_array_new (FALSE, FALSE, sizeof (GstGLStatsRect));
+  stats->bins = DEFAULT_HISTOGRAM_BINS;
+  stats->interval = DEFAULT_INTERVAL;
+  stats->reset = TRUE;
+}
+
+static void
+gst_gl_stats_finalize (GObject * object)
+{
+  GstGLStats *stats = GST_GL_STATS (object);
+  guint i;
+
+  for (i = 0; i < GST_GL_STATS_RING_SIZE; i++) {
+    if (stats->ring[i].rects)
+      g_array_free (stats->ring[i].rects, TRUE);
+    g_free (stats->ring[i].data);
+  }
+
+  g_array_free (stats->rois, TRUE);
+  g_free (stats->rois_str);
+
+  G_OBJECT_CLASS (gst_gl_stats_parent_class)->finalize (object);
+}
+
+static GArray *
+_parse_rois (GstGLStats * stats, const gchar * str)
+{
+  GArray *rois = g_array_new (FALSE, FALSE, sizeof (GstGLStatsRect));
+  gchar **entries;
+  guint i;
+
+  if (!str)
+    return rois;
+
+  entries = g_strsplit (str, ";", -1);
+  for (i = 0; entries[i]; i++) {
+    GstGLStatsRect rect;
+
+    if (g_strstrip (entries[i])[0] == '\0')
+      continue;
+
+    if (sscanf (entries[i], "%d,%d,%d,%d", &rect.x, &rect.y, &rect.width,
+            &rect.height) != 4 || rect.width <= 0 || rect.height <= 0) {
+      GST_WARNING_OBJECT (stats, "ignoring invalid region \"%s\"",
+          entries[i]);
+      continue;
+    }
+
+    if (rois->len == MAX_ROIS) {
+      GST_WARNING_OBJECT (stats, "only %u regions are measured", MAX_ROIS);
+      break;
+    }
+
+    g_array_append_val (rois, rect);
+  }
+  g_strfreev (entries);
+
+  return rois;
+}
+
+static void
+gst_gl_stats_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGLStats *stats = GST_GL_STATS (object);
+
+  switch (prop_id) {
+    case PROP_ROIS:
+    {
+      GArray *rois = _parse_rois (stats, g_value_get_string (value));
+
+      GST_OBJECT_LOCK (stats);
+      g_free (stats->rois_str);
+      stats->rois_str = g_value_dup_string (value);
+      g_array_free (stats->rois, TRUE);
+      stats->rois = rois;
+      GST_OBJECT_UNLOCK (stats);
+      break;
+    }
+    case PROP_HISTOGRAM_BINS:
+      GST_OBJECT_LOCK (stats);
+      stats->bins = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (stats);
+      break;
+    case PROP_INTERVAL:
+      GST_OBJECT_LOCK (stats);
+      stats->interval = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (stats);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gl_stats_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGLStats *stats = GST_GL_STATS (object);
+
+  switch (prop_id) {
+    case PROP_ROIS:
+      GST_OBJECT_LOCK (stats);
+      g_value_set_string (value, stats->rois_str);
+      GST_OBJECT_UNLOCK (stats);
+      break;
+    case PROP_HISTOGRAM_BINS:
+      GST_OBJECT_LOCK (stats);
+      g_value_set_uint (value, stats->bins);
+      GST_OBJECT_UNLOCK (stats);
+      break;
+    case PROP_INTERVAL:
+      GST_OBJECT_LOCK (stats);
+      g_value_set_uint (value, stats->interval);
+      GST_OBJECT_UNLOCK (stats);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static GLuint
+_gen_float_texture (GstGLStats * stats, guint width, guint height)
+{
+  GstGLFilter *filter = GST_GL_FILTER (stats);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  GLuint tex;
+
+  gl->GenTextures (1, &tex);
+  gl->BindTexture (GL_TEXTURE_2D, tex);
+  gl->TexImage2D (GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA,
+      GL_FLOAT, NULL);
+  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  gl->TexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  return tex;
+}
+
+static void
+_attach (GstGLStats * stats, GLuint tex)
+{
+  GstGLFilter *filter = GST_GL_FILTER (stats);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+
+  gl->FramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+      GL_TEXTURE_2D, tex, 0);
+}
+
+static gboolean
+_compile_shader (GstGLStats * stats, GstGLShader ** shader,
+    const gchar * vertex_source, const gchar * fragment_source)
+{
+  GstGLFilter *filter = GST_GL_FILTER (stats);
+  GError *error = NULL;
+
+  *shader = gst_gl_shader_new (filter->context);
+  gst_gl_shader_set_vertex_source (*shader, vertex_source);
+  gst_gl_shader_set_fragment_source (*shader, fragment_source);
+
+  gst_gl_shader_compile (*shader, &error);
+  if (error) {
+    gst_gl_context_set_error (filter->context, "%s", error->message);
+    g_error_free (error);
+    gst_gl_context_clear_shader (filter->context);
+    gst_object_unref (*shader);
+    *shader = NULL;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void
+_init_points (GstGLStats * stats)
+{
+  GstGLFilter *filter = GST_GL_FILTER (stats);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  gint width = GST_VIDEO_INFO_WIDTH (&filter->in_info);
+  gint height = GST_VIDEO_INFO_HEIGHT (&filter->in_info);
+  GLint texcoord_loc;
+  gfloat *points;
+  gint x, y;
+  guint i = 0;
+
+  stats->n_points = ((width + HISTOGRAM_STEP - 1) / HISTOGRAM_STEP)
+      * ((height + HISTOGRAM_STEP - 1) / HISTOGRAM_STEP);
+  points = g_new (gfloat, 2 * stats->n_points);
+
+  for (y = 0; y < height; y += HISTOGRAM_STEP) {
+    for (x = 0; x < width; x += HISTOGRAM_STEP) {
+      points[i++] = (x + 0.5f) / width;
+      points[i++] = (y + 0.5f) / height;
+    }
+  }
+
+  gl->GenBuffers (1, &stats->points_vbo);
+  gl->BindBuffer (GL_ARRAY_BUFFER, stats->points_vbo);
+  gl->BufferData (GL_ARRAY_BUFFER, 2 * stats->n_points * sizeof (gfloat),
+      points, GL_STATIC_DRAW);
+  g_free (points);
+
+  if (gl->GenVertexArrays) {
+    texcoord_loc =
+        gst_gl_shader_get_attribute_location (stats->histogram_shader,
+        "a_texcoord");
+
+    gl->GenVertexArrays (1, &stats->points_vao);
+    gl->BindVertexArray (stats->points_vao);
+    gl->VertexAttribPointer (texcoord_loc, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    gl->EnableVertexAttribArray (texcoord_loc);
+    gl->BindVertexArray (0);
+  }
+
+  gl->BindBuffer (GL_ARRAY_BUFFER, 0);
+}
+
+/* init resources that need a gl context */
+static void
+gst_gl_stats_init_gl_resources (GstGLFilter * filter)
+{
+  GstGLStats *stats = GST_GL_STATS (filter);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  GLint vertex_units = 0;
+  GLenum status;
+  guint i;
+
+  /* the caps changed, start over */
+  gst_gl_stats_reset_gl_resources (filter);
+
+  if (!_compile_shader (stats, &stats->block_shader, quad_vertex_source,
+          block_fragment_source))
+    return;
+  if (!_compile_shader (stats, &stats->reduce_shader, quad_vertex_source,
+          reduce_fragment_source))
+    return;
+
+  stats->level_width = (GST_VIDEO_INFO_WIDTH (&filter->in_info) + 3) / 4;
+  stats->level_height = (GST_VIDEO_INFO_HEIGHT (&filter->in_info) + 3) / 4;
+  stats->scratch_width = (stats->level_width + 3) / 4;
+  stats->scratch_height = (stats->level_height + 3) / 4;
+  stats->results_width = MAX_ROIS + 1;
+  stats->histogram_width = MAX_HISTOGRAM_BINS;
+
+  for (i = 0; i < 2; i++) {
+    stats->level[i] = _gen_float_texture (stats, stats->level_width,
+        stats->level_height);
+    stats->scratch[i] = _gen_float_texture (stats, stats->scratch_width,
+        stats->scratch_height);
+  }
+  stats->level_index = 0;
+  stats->results_tex = _gen_float_texture (stats, stats->results_width, 1);
+  stats->histogram_tex = _gen_float_texture (stats, stats->histogram_width, 1);
+
+  gl->GenFramebuffers (1, &stats->fbo);
+  gl->BindFramebuffer (GL_FRAMEBUFFER, stats->fbo);
+
+  /* the motion of the first measurement reads the previous level */
+  gl->ClearColor (0.0, 0.0, 0.0, 0.0);
+  for (i = 0; i < 2; i++) {
+    _attach (stats, stats->level[i]);
+    gl->Clear (GL_COLOR_BUFFER_BIT);
+  }
+
+  status = gl->CheckFramebufferStatus (GL_FRAMEBUFFER);
+  gl->BindFramebuffer (GL_FRAMEBUFFER, 0);
+
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    gst_gl_context_set_error (filter->context,
+        "Floating point textures cannot be rendered to (status 0x%x)", status);
+    return;
+  }
+
+  gl->GetIntegerv (GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &vertex_units);
+  if (vertex_units > 0 && _compile_shader (stats, &stats->histogram_shader,
+          histogram_vertex_source, histogram_fragment_source)) {
+    _init_points (stats);
+    stats->histogram_supported = TRUE;
+  } else {
+    GST_WARNING_OBJECT (stats, "no texture fetches in vertex shaders, "
+        "the histogram is disabled");
+    stats->histogram_supported = FALSE;
+  }
+
+  /* read back without waiting when the results can be mapped later */
+  stats->use_pbo =
+      (gst_gl_context_get_gl_api (filter->context) & GST_GL_API_OPENGL)
+      && gl->MapBuffer
+      && gst_gl_context_check_feature (filter->context,
+      "GL_ARB_pixel_buffer_object");
+  if (stats->use_pbo) {
+    for (i = 0; i < GST_GL_STATS_RING_SIZE; i++)
+      gl->GenBuffers (1, &stats->ring[i].pbo);
+  }
+  stats->n_pending = 0;
+
+  GST_DEBUG_OBJECT (stats, "reducing %ux%u blocks, histogram %s, %s readback",
+      stats->level_width, stats->level_height,
+      stats->histogram_supported ? "enabled" : "disabled",
+      stats->use_pbo ? "asynchronous" : "synchronous");
+
+  stats->gl_ok = TRUE;
+}
+
+/* free resources that need a gl context */
+static void
+gst_gl_stats_reset_gl_resources (GstGLFilter * filter)
+{
+  GstGLStats *stats = GST_GL_STATS (filter);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  guint i;
+
+  if (stats->block_shader) {
+    gst_object_unref (stats->block_shader);
+    stats->block_shader = NULL;
+  }
+  if (stats->reduce_shader) {
+    gst_object_unref (stats->reduce_shader);
+    stats->reduce_shader = NULL;
+  }
+  if (stats->histogram_shader) {
+    gst_object_unref (stats->histogram_shader);
+    stats->histogram_shader = NULL;
+  }
+
+  if (stats->fbo) {
+    gl->DeleteFramebuffers (1, &stats->fbo);
+    stats->fbo = 0;
+  }
+
+  if (stats->level[0]) {
+    gl->DeleteTextures (2, stats->level);
+    gl->DeleteTextures (2, stats->scratch);
+    gl->DeleteTextures (1, &stats->results_tex);
+    gl->DeleteTextures (1, &stats->histogram_tex);
+  }
+  stats->level[0] = stats->level[1] = 0;
+  stats->scratch[0] = stats->scratch[1] = 0;
+  stats->results_tex = 0;
+  stats->histogram_tex = 0;
+
+  if (stats->points_vao) {
+    gl->DeleteVertexArrays (1, &stats->points_vao);
+    stats->points_vao = 0;
+  }
+  if (stats->points_vbo) {
+    gl->DeleteBuffers (1, &stats->points_vbo);
+    stats->points_vbo = 0;
+  }
+
+  for (i = 0; i < GST_GL_STATS_RING_SIZE; i++) {
+    if (stats->ring[i].pbo) {
+      gl->DeleteBuffers (1, &stats->ring[i].pbo);
+      stats->ring[i].pbo = 0;
+    }
+  }
+
+  stats->n_pending = 0;
+  stats->gl_ok = FALSE;
+}
+
+/* drops the measurements that were not posted yet */
+static void
+_discard_results (GstGLStats * stats)
+{
+  guint i;
+
+  for (i = 0; i < GST_GL_STATS_RING_SIZE; i++)
+    stats->ring[i].state = GST_GL_STATS_SLOT_FREE;
+
+  stats->read_index = stats->write_index = 0;
+  stats->n_queued = 0;
+  stats->n_pending = 0;
+}
+
+static void
+gst_gl_stats_reset_resources (GstGLFilter * filter)
+{
+  GstGLStats *stats = GST_GL_STATS (filter);
+
+  _discard_results (stats);
+  stats->frame_count = 0;
+  stats->reset = TRUE;
+}
+
+static void
+_draw_quad (GstGLStats * stats, GstGLShader * shader)
+{
+  GstGLFilter *filter = GST_GL_FILTER (stats);
+
+  gst_gl_context_bind_geometry (filter->context, GST_GL_GEOMETRY_QUAD,
+      gst_gl_shader_get_attribute_location (shader, "a_position"), -1);
+  gst_gl_context_draw_geometry (filter->context, 0, 1);
+  gst_gl_context_unbind_geometry (filter->context);
+}
+
+/* reduces rect of the block level down to the texel index of the results */
+static void
+_reduce_rect (GstGLStats * stats, guint index, const GstGLStatsRect * rect)
+{
+  GstGLFilter *filter = GST_GL_FILTER (stats);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  GstGLShader *shader = stats->reduce_shader;
+  GLuint src = stats->level[stats->level_index];
+  guint src_width = stats->level_width;
+  guint src_height = stats->level_height;
+  GstGLStatsRect src_rect = *rect;
+  guint target = 0;
+
+  gst_gl_shader_use (shader);
+  gl->ActiveTexture (GL_TEXTURE0);
+  gst_gl_shader_set_uniform_1i (shader, "tex", 0);
+
+  while (TRUE) {
+    gint dst_width = (src_rect.width + 3) / 4;
+    gint dst_height = (src_rect.height + 3) / 4;
+    gboolean last = dst_width == 1 && dst_height == 1;
+
+    gl->BindTexture (GL_TEXTURE_2D, src);
+    gst_gl_shader_set_uniform_2f (shader, "tex_size", src_width, src_height);
+    gst_gl_shader_set_uniform_4f (shader, "src_rect", src_rect.x, src_rect.y,
+        src_rect.width, src_rect.height);
+
+    if (last) {
+      _attach (stats, stats->results_tex);
+      gl->Viewport (index, 0, 1, 1);
+      gst_gl_shader_set_uniform_2f (shader, "dst_origin", index, 0.0);
+    } else {
+      _attach (stats, stats->scratch[target]);
+      gl->Viewport (0, 0, dst_width, dst_height);
+      gst_gl_shader_set_uniform_2f (shader, "dst_origin", 0.0, 0.0);
+    }
+
+    _draw_quad (stats, shader);
+
+    if (last)
+      break;
+
+    src = stats->scratch[target];
+    src_width = stats->scratch_width;
+    src_height = stats->scratch_height;
+    src_rect.x = src_rect.y = 0;
+    src_rect.width = dst_width;
+    src_rect.height = dst_height;
+    target = 1 - target;
+  }
+}
+
+static void
+_draw_histogram (GstGLStats * stats, guint bins)
+{
+  GstGLFilter *filter = GST_GL_FILTER (stats);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  GstGLShader *shader = stats->histogram_shader;
+  GLint texcoord_loc;
+
+  _attach (stats, stats->histogram_tex);
+  gl->Viewport (0, 0, bins, 1);
+  gl->ClearColor (0.0, 0.0, 0.0, 0.0);
+  gl->Clear (GL_COLOR_BUFFER_BIT);
+
+  gst_gl_shader_use (shader);
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, stats->in_tex);
+  gst_gl_shader_set_uniform_1i (shader, "tex", 0);
+  gst_gl_shader_set_uniform_1f (shader, "bins", bins);
+
+  texcoord_loc = gst_gl_shader_get_attribute_location (shader, "a_texcoord");
+
+  if (stats->points_vao) {
+    gl->BindVertexArray (stats->points_vao);
+  } else {
+    gl->BindBuffer (GL_ARRAY_BUFFER, stats->points_vbo);
+    gl->VertexAttribPointer (texcoord_loc, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    gl->EnableVertexAttribArray (texcoord_loc);
+  }
+
+  gl->Enable (GL_BLEND);
+  gl->BlendFunc (GL_ONE, GL_ONE);
+  gl->DrawArrays (GL_POINTS, 0, stats->n_points);
+  gl->Disable (GL_BLEND);
+
+  if (stats->points_vao) {
+    gl->BindVertexArray (0);
+  } else {
+    gl->DisableVertexAttribArray (texcoord_loc);
+    gl->BindBuffer (GL_ARRAY_BUFFER, 0);
+  }
+}
+
+/* reads the results texels either into the pixel buffer of the slot or
+ * straight into its data */
+static void
+_read_results (GstGLStats * stats, GstGLStatsSlot * slot)
+{
+  GstGLFilter *filter = GST_GL_FILTER (stats);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  guint n_rects = slot->rects->len;
+  gsize histogram_offset = 4 * n_rects * sizeof (gfloat);
+
+  if (stats->use_pbo) {
+    gl->BindBuffer (GL_PIXEL_PACK_BUFFER, slot->pbo);
+    gl->BufferData (GL_PIXEL_PACK_BUFFER, slot->data_size * sizeof (gfloat),
+        NULL, GL_STREAM_READ);
+  }
+
+  /* with a pixel pack buffer bound the pointers are offsets into it */
+  _attach (stats, stats->results_tex);
+  gl->ReadPixels (0, 0, n_rects, 1, GL_RGBA, GL_FLOAT,
+      stats->use_pbo ? (gpointer) 0 : slot->data);
+
+  if (slot->bins) {
+    _attach (stats, stats->histogram_tex);
+    gl->ReadPixels (0, 0, slot->bins, 1, GL_RGBA, GL_FLOAT,
+        stats->use_pbo ? (gpointer) histogram_offset :
+        (guint8 *) slot->data + histogram_offset);
+  }
+
+  if (stats->use_pbo) {
+    gl->BindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+    slot->state = GST_GL_STATS_SLOT_PENDING;
+    stats->n_pending++;
+  } else {
+    slot->state = GST_GL_STATS_SLOT_READY;
+  }
+}
+
+/* maps the oldest pixel buffer in flight, the GPU is done with it by now */
+static void
+_collect_oldest (GstGLStats * stats)
+{
+  GstGLFilter *filter = GST_GL_FILTER (stats);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  GstGLStatsSlot *slot = NULL;
+  gpointer data;
+  guint i;
+
+  for (i = 0; i < GST_GL_STATS_RING_SIZE; i++) {
+    slot = &stats->ring[(stats->read_index + i) % GST_GL_STATS_RING_SIZE];
+    if (slot->state == GST_GL_STATS_SLOT_PENDING)
+      break;
+  }
+  g_return_if_fail (slot && slot->state == GST_GL_STATS_SLOT_PENDING);
+
+  gl->BindBuffer (GL_PIXEL_PACK_BUFFER, slot->pbo);
+  data = gl->MapBuffer (GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+  if (data) {
+    memcpy (slot->data, data, slot->data_size * sizeof (gfloat));
+    gl->UnmapBuffer (GL_PIXEL_PACK_BUFFER);
+    slot->state = GST_GL_STATS_SLOT_READY;
+  } else {
+    GST_WARNING_OBJECT (stats, "failed to map the results, dropping them");
+    slot->state = GST_GL_STATS_SLOT_FREE;
+  }
+  gl->BindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+
+  stats->n_pending--;
+}
+
+static void
+_collect_all (GstGLContext * context, GstGLStats * stats)
+{
+  while (stats->n_pending > 0)
+    _collect_oldest (stats);
+}
+
+static void
+_measure (GstGLContext * context, GstGLStats * stats)
+{
+  GstGLFilter *filter = GST_GL_FILTER (stats);
+  GstGLFuncs *gl = filter->context->gl_vtable;
+  GstGLStatsSlot *slot = stats->current;
+  GstGLShader *shader = stats->block_shader;
+  GLuint prev;
+  guint i;
+
+  gl->BindFramebuffer (GL_FRAMEBUFFER, stats->fbo);
+
+  prev = stats->level[stats->level_index];
+  stats->level_index = 1 - stats->level_index;
+
+  _attach (stats, stats->level[stats->level_index]);
+  gl->Viewport (0, 0, stats->level_width, stats->level_height);
+
+  gst_gl_shader_use (shader);
+
+  gl->ActiveTexture (GL_TEXTURE1);
+  gl->BindTexture (GL_TEXTURE_2D, prev);
+  gst_gl_shader_set_uniform_1i (shader, "prev", 1);
+
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, stats->in_tex);
+  gst_gl_shader_set_uniform_1i (shader, "tex", 0);
+
+  gst_gl_shader_set_uniform_2f (shader, "size",
+      GST_VIDEO_INFO_WIDTH (&filter->in_info),
+      GST_VIDEO_INFO_HEIGHT (&filter->in_info));
+  gst_gl_shader_set_uniform_2f (shader, "level_size", stats->level_width,
+      stats->level_height);
+  gst_gl_shader_set_uniform_1f (shader, "reset", stats->reset ? 1.0 : 0.0);
+
+  _draw_quad (stats, shader);
+
+  for (i = 0; i < slot->rects->len; i++)
+    _reduce_rect (stats, i, &g_array_index (slot->rects, GstGLStatsRect, i));
+
+  if (slot->bins)
+    _draw_histogram (stats, slot->bins);
+
+  _read_results (stats, slot);
+
+  gl->BindFramebuffer (GL_FRAMEBUFFER, 0);
+  gst_gl_context_clear_shader (filter->context);
+
+  /* keep the GPU busy with the newer measurements meanwhile */
+  while (stats->n_pending >= GST_GL_STATS_RING_SIZE)
+    _collect_oldest (stats);
+}
+
+/* called from the streaming thread, picks what the next measurement covers */
+static GstGLStatsSlot *
+_prepare_slot (GstGLStats * stats, GstBuffer * inbuf)
+{
+  GstBaseTransform *trans = GST_BASE_TRANSFORM (stats);
+  GstGLFilter *filter = GST_GL_FILTER (stats);
+  gint width = GST_VIDEO_INFO_WIDTH (&filter->in_info);
+  gint height = GST_VIDEO_INFO_HEIGHT (&filter->in_info);
+  GstGLStatsSlot *slot;
+  GstGLStatsRect rect;
+  guint i;
+
+  if (stats->n_queued == GST_GL_STATS_RING_SIZE) {
+    GST_DEBUG_OBJECT (stats, "all measurements in flight, skipping a frame");
+    return NULL;
+  }
+
+  slot = &stats->ring[stats->write_index];
+  if (!slot->rects)
+    slot->rects = g_array_new (FALSE, FALSE, sizeof (GstGLStatsRect));
+  g_array_set_size (slot->rects, 0);
+
+  rect.x = rect.y = 0;
+  rect.width = stats->level_width;
+  rect.height = stats->level_height;
+  g_array_append_val (slot->rects, rect);
+
+  GST_OBJECT_LOCK (stats);
+  for (i = 0; i < stats->rois->len; i++) {
+    GstGLStatsRect *roi = &g_array_index (stats->rois, GstGLStatsRect, i);
+    gint x0 = CLAMP (roi->x, 0, width) / 4;
+    gint y0 = CLAMP (roi->y, 0, height) / 4;
+    gint x1 = (CLAMP (roi->x + roi->width, 0, width) + 3) / 4;
+    gint y1 = (CLAMP (roi->y + roi->height, 0, height) + 3) / 4;
+
+    if (x1 <= x0 || y1 <= y0)
+      continue;
+
+    rect.x = x0;
+    rect.y = y0;
+    rect.width = x1 - x0;
+    rect.height = y1 - y0;
+    g_array_append_val (slot->rects, rect);
+  }
+  slot->bins = stats->histogram_supported ? stats->bins : 0;
+  GST_OBJECT_UNLOCK (stats);
+
+  slot->n_points = stats->n_points;
+  slot->data_size = 4 * (slot->rects->len + slot->bins);
+  slot->data = g_renew (gfloat, slot->data, slot->data_size);
+
+  slot->timestamp = GST_BUFFER_TIMESTAMP (inbuf);
+  slot->duration = GST_BUFFER_DURATION (inbuf);
+  slot->stream_time = gst_segment_to_stream_time (&trans->segment,
+      GST_FORMAT_TIME, slot->timestamp);
+  slot->running_time = gst_segment_to_running_time (&trans->segment,
+      GST_FORMAT_TIME, slot->timestamp);
+
+  stats->write_index = (stats->write_index + 1) % GST_GL_STATS_RING_SIZE;
+  stats->n_queued++;
+
+  return slot;
+}
+
+static GstStructure *
+_rect_stats (GstGLStats * stats, const gchar * name,
+    const GstGLStatsRect * rect, const gfloat * texel)
+{
+  GstGLFilter *filter = GST_GL_FILTER (stats);
+  gint width = GST_VIDEO_INFO_WIDTH (&filter->in_info);
+  gint height = GST_VIDEO_INFO_HEIGHT (&filter->in_info);
+  gdouble area = rect->width * rect->height;
+
+  return gst_structure_new (name,
+      "x", G_TYPE_INT, rect->x * 4,
+      "y", G_TYPE_INT, rect->y * 4,
+      "width", G_TYPE_INT, MIN (rect->width * 4, width - rect->x * 4),
+      "height", G_TYPE_INT, MIN (rect->height * 4, height - rect->y * 4),
+      "mean", G_TYPE_DOUBLE, texel[0] / area,
+      "min", G_TYPE_DOUBLE, (gdouble) texel[1],
+      "max", G_TYPE_DOUBLE, (gdouble) texel[2],
+      "motion", G_TYPE_DOUBLE, texel[3] / area, NULL);
+}
+
+static void
+_post_slot (GstGLStats * stats, GstGLStatsSlot * slot)
+{
+  GstStructure *s, *roi;
+  GValue rois = G_VALUE_INIT;
+  guint n_rects = slot->rects->len;
+  guint i;
+
+  s = _rect_stats (stats, "glstats",
+      &g_array_index (slot->rects, GstGLStatsRect, 0), slot->data);
+  gst_structure_remove_fields (s, "x", "y", "width", "height", NULL);
+  gst_structure_set (s,
+      "timestamp", G_TYPE_UINT64, slot->timestamp,
+      "stream-time", G_TYPE_UINT64, slot->stream_time,
+      "running-time", G_TYPE_UINT64, slot->running_time,
+      "duration", G_TYPE_UINT64, slot->duration, NULL);
+
+  if (slot->bins) {
+    GValue histogram = G_VALUE_INIT;
+    const gfloat *texel = slot->data + 4 * n_rects;
+
+    g_value_init (&histogram, GST_TYPE_ARRAY);
+    for (i = 0; i < slot->bins; i++) {
+      GValue v = G_VALUE_INIT;
+
+      g_value_init (&v, G_TYPE_DOUBLE);
+      g_value_set_double (&v, texel[4 * i] / (gdouble) slot->n_points);
+      gst_value_array_append_value (&histogram, &v);
+      g_value_unset (&v);
+    }
+    gst_structure_take_value (s, "histogram", &histogram);
+  }
+
+  g_value_init (&rois, GST_TYPE_ARRAY);
+  for (i = 1; i < n_rects; i++) {
+    GValue v = G_VALUE_INIT;
+
+    roi = _rect_stats (stats, "roi",
+        &g_array_index (slot->rects, GstGLStatsRect, i), slot->data + 4 * i);
+
+    g_value_init (&v, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (&v, roi);
+    gst_value_array_append_value (&rois, &v);
+    g_value_unset (&v);
+  }
+  gst_structure_take_value (s, "rois", &rois);
+
+  gst_element_post_message (GST_ELEMENT (stats),
+      gst_message_new_element (GST_OBJECT (stats), s));
+}
+
+/* posts the measurements that were read back, oldest first */
+static void
+_post_results (GstGLStats * stats)
+{
+  while (stats->n_queued > 0) {
+    GstGLStatsSlot *slot = &stats->ring[stats->read_index];
+
+    if (slot->state == GST_GL_STATS_SLOT_PENDING)
+      break;
+
+    if (slot->state == GST_GL_STATS_SLOT_READY)
+      _post_slot (stats, slot);
+
+    slot->state = GST_GL_STATS_SLOT_FREE;
+    stats->read_index = (stats->read_index + 1) % GST_GL_STATS_RING_SIZE;
+    stats->n_queued--;
+  }
+}
+
+static gboolean
+gst_gl_stats_sink_event (GstBaseTransform * trans, GstEvent * event)
+{
+  GstGLStats *stats = GST_GL_STATS (trans);
+  GstGLFilter *filter = GST_GL_FILTER (trans);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_EOS:
+      /* the last measurements go out before the EOS */
+      if (filter->context && stats->n_pending > 0)
+        gst_gl_context_thread_add (filter->context,
+            (GstGLContextThreadFunc) _collect_all, stats);
+      _post_results (stats);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      _discard_results (stats);
+      stats->reset = TRUE;
+      break;
+    default:
+      break;
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (gst_gl_stats_parent_class)->sink_event
+      (trans, event);
+}
+
+/* the frames go through untouched */
+static GstCaps *
+gst_gl_stats_transform_caps (GstBaseTransform * trans,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter)
+{
+  if (filter)
+    return gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+
+  return gst_caps_ref (caps);
+}
+
+/* upstream allocates from downstream, as if the element wasn't there */
+static gboolean
+gst_gl_stats_propose_allocation (GstBaseTransform * trans,
+    GstQuery * decide_query, GstQuery * query)
+{
+  return gst_pad_peer_query (GST_BASE_TRANSFORM_SRC_PAD (trans), query);
+}
+
+static void
+_init_gl_thread (GstGLContext * context, GstGLStats * stats)
+{
+  gst_gl_stats_init_gl_resources (GST_GL_FILTER (stats));
+}
+
+/* GstGLFilter sets up GL when it decides the allocation of its output,
+ * which never happens in passthrough.  Frames that are textures are
+ * measured in their own context, the upload is made again when the caps
+ * or the crop changed */
+static gboolean
+_ensure_gl (GstGLStats * stats, GstBuffer * buf)
+{
+  GstGLFilter *filter = GST_GL_FILTER (stats);
+  GstMemory *mem = gst_buffer_peek_memory (buf, 0);
+  GError *error = NULL;
+
+  if (!gst_gl_ensure_display (filter, &filter->display))
+    return FALSE;
+
+  if (!filter->context) {
+    if (gst_is_gl_memory (mem)) {
+      filter->context = gst_object_ref (((GstGLMemory *) mem)->context);
+    } else {
+      filter->context = gst_gl_context_new (filter->display);
+      if (!gst_gl_context_create (filter->context, filter->other_context,
+              &error)) {
+        GST_ELEMENT_ERROR (stats, RESOURCE, NOT_FOUND, ("%s",
+                error->message), (NULL));
+        g_clear_error (&error);
+        return FALSE;
+      }
+    }
+  }
+
+  if (!filter->upload) {
+    filter->upload = gst_gl_upload_new (filter->context);
+    if (!gst_gl_upload_init_format (filter->upload, filter->frame_info,
+            filter->in_info)) {
+      GST_ELEMENT_ERROR (stats, RESOURCE, NOT_FOUND, ("%s",
+              "Failed to init upload format"), (NULL));
+      return FALSE;
+    }
+
+    gst_gl_context_thread_add (filter->context,
+        (GstGLContextThreadFunc) _init_gl_thread, stats);
+  }
+
+  if (!stats->gl_ok) {
+    GST_ELEMENT_ERROR (stats, RESOURCE, NOT_FOUND,
+        ("%s", gst_gl_context_get_error ()), (NULL));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_gl_stats_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
+{
+  GstGLStats *stats = GST_GL_STATS (trans);
+  GstGLFilter *filter = GST_GL_FILTER (trans);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint interval;
+
+  GST_OBJECT_LOCK (stats);
+  interval = stats->interval;
+  GST_OBJECT_UNLOCK (stats);
+
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DISCONT))
+    stats->reset = TRUE;
+
+  if (stats->frame_count++ % interval != 0)
+    goto done;
+
+  if (!_ensure_gl (stats, buf))
+    return GST_FLOW_ERROR;
+
+  stats->current = _prepare_slot (stats, buf);
+  if (!stats->current)
+    goto done;
+
+  if (!gst_gl_upload_perform_with_buffer (filter->upload, buf,
+          &stats->in_tex)) {
+    GST_ELEMENT_ERROR (stats, RESOURCE, NOT_FOUND,
+        ("%s", "Failed to upload video frame"), (NULL));
+    ret = GST_FLOW_ERROR;
+  } else {
+    gst_gl_context_thread_add (filter->context,
+        (GstGLContextThreadFunc) _measure, stats);
+    gst_gl_upload_release_buffer (filter->upload);
+    stats->reset = FALSE;
+  }
+  stats->current = NULL;
+
+done:
+  _post_results (stats);
+
+  return ret;
+}
@@ -0,0 +1,133 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_GL_STATS_H_
+#define _GST_GL_STATS_H_
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include <gst/gl/gstglfilter.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GL_STATS            (gst_gl_stats_get_type())
+#define GST_GL_STATS(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_STATS,GstGLStats))
+#define GST_IS_GL_STATS(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_STATS))
+#define GST_GL_STATS_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GST_TYPE_GL_STATS,GstGLStatsClass))
+#define GST_IS_GL_STATS_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GST_TYPE_GL_STATS))
+#define GST_GL_STATS_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GST_TYPE_GL_STATS,GstGLStatsClass))
+
+/* number of measurements in flight, results are posted this many
+ * measurements minus one late when they are read back asynchronously */
+#define GST_GL_STATS_RING_SIZE 3
+
+typedef struct _GstGLStats GstGLStats;
+typedef struct _GstGLStatsClass GstGLStatsClass;
+typedef struct _GstGLStatsSlot GstGLStatsSlot;
+
+typedef enum
+{
+  GST_GL_STATS_SLOT_FREE,
+  GST_GL_STATS_SLOT_PENDING,
+  GST_GL_STATS_SLOT_READY
+} GstGLStatsSlotState;
+
+/* one measurement, from the streaming thread to the GL thread and back */
+struct _GstGLStatsSlot
+{
+  GstGLStatsSlotState state;
+  GLuint pbo;
+
+  GstClockTime timestamp;
+  GstClockTime stream_time;
+  GstClockTime running_time;
+  GstClockTime duration;
+
+  /* x, y, width and height in reduced texels, the full frame first */
+  GArray *rects;
+  guint bins;
+  guint n_points;
+
+  /* RGBA floats, one texel per rectangle followed by one per bin */
+  gfloat *data;
+  guint data_size;
+};
+
+struct _GstGLStats
+{
+  GstGLFilter filter;
+
+  /* properties, with OBJECT_LOCK */
+  gchar *rois_str;
+  GArray *rois;
+  guint bins;
+  guint interval;
+
+  /* streaming thread */
+  guint frame_count;
+  gboolean reset;
+  GstGLStatsSlot ring[GST_GL_STATS_RING_SIZE];
+  guint write_index;
+  guint read_index;
+  guint n_queued;
+  GstGLStatsSlot *current;
+
+  /* GL thread */
+  gboolean gl_ok;
+  gboolean use_pbo;
+  gboolean histogram_supported;
+  guint n_pending;
+  guint in_tex;
+
+  GstGLShader *block_shader;
+  GstGLShader *reduce_shader;
+  GstGLShader *histogram_shader;
+  GLuint fbo;
+
+  guint level_width;
+  guint level_height;
+  GLuint level[2];
+  guint level_index;
+
+  guint scratch_width;
+  guint scratch_height;
+  GLuint scratch[2];
+
+  GLuint results_tex;
+  guint results_width;
+  GLuint histogram_tex;
+  guint histogram_width;
+
+  GLuint points_vbo;
+  GLuint points_vao;
+  guint n_points;
+};
+
+struct _GstGLStatsClass
+{
+  GstGLFilterClass filter_class;
+};
+
+GType gst_gl_stats_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_GL_STATS_H_ */
@@ -36,6 +36,11 @@
  * </programlisting>
  * Shows original SMPTE color bars in a window.
  * </para>
+ * <para>
+ * All the patterns are generated with fragment shaders.  Patterns that do not
+ * change over time are only rendered once, the following buffers share the
+ * memory of the first one.
+ * </para>
  * </refsect2>
  */
 
@@ -83,6 +88,8 @@ static void gst_gl_test_src_set_context (GstElement * element,
 
 static void gst_gl_test_src_get_times (GstBaseSrc * basesrc,
     GstBuffer * buffer, GstClockTime * start, GstClockTime * end);
+static GstFlowReturn gst_gl_test_src_create (GstBaseSrc * bsrc,
+    guint64 offset, guint length, GstBuffer ** buffer);
 static GstFlowReturn gst_gl_test_src_fill (GstPushSrc * psrc,
     GstBuffer * buffer);
 static gboolean gst_gl_test_src_start (GstBaseSrc * basesrc);
@@ -111,6 +118,10 @@ gst_gl_test_src_pattern_get_type (void)
     {GST_GL_TEST_SRC_CHECKERS8, "Checkers 8px", "checkers-8"},
     {GST_GL_TEST_SRC_CIRCULAR, "Circular", "circular"},
     {GST_GL_TEST_SRC_BLINK, "Blink", "blink"},
+    {GST_GL_TEST_SRC_SMPTE75, "SMPTE 75% color bars", "smpte75"},
+    {GST_GL_TEST_SRC_ZONE_PLATE, "Zone plate", "zone-plate"},
+    {GST_GL_TEST_SRC_BALL, "Moving ball", "ball"},
+    {GST_GL_TEST_SRC_SMPTE100, "SMPTE 100% color bars", "smpte100"},
     {0, NULL, NULL}
   };
 
@@ -173,6 +184,7 @@ gst_gl_test_src_class_init (GstGLTestSrcClass * klass)
   gstbasesrc_class->stop = gst_gl_test_src_stop;
   gstbasesrc_class->fixate = gst_gl_test_src_fixate;
   gstbasesrc_class->decide_allocation = gst_gl_test_src_decide_allocation;
+  gstbasesrc_class->create = gst_gl_test_src_create;
 
   gstpushsrc_class->fill = gst_gl_test_src_fill;
 }
@@ -184,6 +196,12 @@ gst_gl_test_src_init (GstGLTestSrc * src)
 
   src->timestamp_offset = 0;
 
+  src->shader = NULL;
+  src->shader_fragment = NULL;
+  src->position_loc = -1;
+  src->texcoord_loc = -1;
+  src->cached_buffer = NULL;
+
   /* we operate in time */
   gst_base_src_set_format (GST_BASE_SRC (src), GST_FORMAT_TIME);
   gst_base_src_set_live (GST_BASE_SRC (src), FALSE);
@@ -256,6 +274,18 @@ gst_gl_test_src_set_pattern (GstGLTestSrc * gltestsrc, gint pattern_type)
     case GST_GL_TEST_SRC_BLINK:
       gltestsrc->make_image = gst_gl_test_src_black;
       break;
+    case GST_GL_TEST_SRC_SMPTE75:
+      gltestsrc->make_image = gst_gl_test_src_smpte75;
+      break;
+    case GST_GL_TEST_SRC_ZONE_PLATE:
+      gltestsrc->make_image = gst_gl_test_src_zone_plate;
+      break;
+    case GST_GL_TEST_SRC_BALL:
+      gltestsrc->make_image = gst_gl_test_src_ball;
+      break;
+    case GST_GL_TEST_SRC_SMPTE100:
+      gltestsrc->make_image = gst_gl_test_src_smpte100;
+      break;
     default:
       g_assert_not_reached ();
   }
@@ -314,6 +344,7 @@ gst_gl_test_src_setcaps (GstBaseSrc * bsrc, GstCaps * caps)
   if (!gst_video_info_from_caps (&gltestsrc->out_info, caps))
     goto wrong_caps;
 
+  gst_buffer_replace (&gltestsrc->cached_buffer, NULL);
   gltestsrc->negotiated = TRUE;
 
   return TRUE;
@@ -428,11 +459,71 @@ gst_gl_test_src_is_seekable (GstBaseSrc * psrc)
   return TRUE;
 }
 
+static void
+gst_gl_test_src_set_timestamps (GstGLTestSrc * src, GstBuffer * buffer)
+{
+  GstClockTime next_time;
+
+  GST_BUFFER_TIMESTAMP (buffer) = src->timestamp_offset + src->running_time;
+  GST_BUFFER_OFFSET (buffer) = src->n_frames;
+  src->n_frames++;
+  GST_BUFFER_OFFSET_END (buffer) = src->n_frames;
+  if (src->out_info.fps_n) {
+    next_time = gst_util_uint64_scale_int (src->n_frames * GST_SECOND,
+        src->out_info.fps_d, src->out_info.fps_n);
+    GST_BUFFER_DURATION (buffer) = next_time - src->running_time;
+  } else {
+    next_time = src->timestamp_offset;
+    /* NONE means forever */
+    GST_BUFFER_DURATION (buffer) = GST_CLOCK_TIME_NONE;
+  }
+
+  src->running_time = next_time;
+}
+
+static GstFlowReturn
+gst_gl_test_src_create (GstBaseSrc * bsrc, guint64 offset, guint length,
+    GstBuffer ** buffer)
+{
+  GstGLTestSrc *src = GST_GL_TEST_SRC (bsrc);
+
+  /* 0 framerate and we are at the second frame, eos */
+  if (G_UNLIKELY (GST_VIDEO_INFO_FPS_N (&src->out_info) == 0
+          && src->n_frames == 1))
+    goto eos;
+
+  if (src->cached_buffer && src->cached_pattern != src->pattern_type)
+    gst_buffer_replace (&src->cached_buffer, NULL);
+
+  if (src->cached_buffer) {
+    /* only the timestamps differ.  Downstream has usually released the
+     * previous frame by now and the cached buffer itself goes out again,
+     * otherwise a copy shares its texture */
+    if (gst_buffer_is_writable (src->cached_buffer)) {
+      gst_gl_test_src_set_timestamps (src, src->cached_buffer);
+      *buffer = gst_buffer_ref (src->cached_buffer);
+    } else {
+      *buffer = gst_buffer_copy (src->cached_buffer);
+      gst_gl_test_src_set_timestamps (src, *buffer);
+    }
+
+    return GST_FLOW_OK;
+  }
+
+  return GST_BASE_SRC_CLASS (parent_class)->create (bsrc, offset, length,
+      buffer);
+
+eos:
+  {
+    GST_DEBUG_OBJECT (src, "eos: 0 framerate, frame %d", (gint) src->n_frames);
+    return GST_FLOW_EOS;
+  }
+}
+
 static GstFlowReturn
 gst_gl_test_src_fill (GstPushSrc * psrc, GstBuffer * buffer)
 {
   GstGLTestSrc *src;
-  GstClockTime next_time;
   gint width, height;
   GstVideoFrame out_frame;
   gboolean out_gl_wrapped = FALSE;
@@ -446,11 +537,6 @@ gst_gl_test_src_fill (GstPushSrc * psrc, GstBuffer * buffer)
   width = GST_VIDEO_INFO_WIDTH (&src->out_info);
   height = GST_VIDEO_INFO_HEIGHT (&src->out_info);
 
-  /* 0 framerate and we are at the second frame, eos */
-  if (G_UNLIKELY (GST_VIDEO_INFO_FPS_N (&src->out_info) == 0
-          && src->n_frames == 1))
-    goto eos;
-
   if (src->pattern_type == GST_GL_TEST_SRC_BLINK) {
     if (src->n_frames & 0x1)
       src->make_image = gst_gl_test_src_white;
@@ -463,7 +549,8 @@ gst_gl_test_src_fill (GstPushSrc * psrc, GstBuffer * buffer)
     return GST_FLOW_NOT_NEGOTIATED;
   }
 
-  if (gst_is_gl_memory (out_frame.map[0].memory)) {
+  if (gst_is_gl_memory (out_frame.map[0].memory)
+      && !GST_GL_MEMORY_IS_PLANE (out_frame.map[0].memory)) {
     out_tex = *(guint *) out_frame.data[0];
   } else {
     GST_INFO ("Output Buffer does not contain correct meta, "
@@ -479,10 +566,8 @@ gst_gl_test_src_fill (GstPushSrc * psrc, GstBuffer * buffer)
     if (!src->download) {
       src->download = gst_gl_download_new (src->context);
 
-      if (!gst_gl_download_init_format (src->download,
-              GST_VIDEO_FRAME_FORMAT (&out_frame),
-              GST_VIDEO_FRAME_WIDTH (&out_frame),
-              GST_VIDEO_FRAME_HEIGHT (&out_frame))) {
+      if (!gst_gl_download_init_format_full (src->download,
+              &out_frame.info)) {
         GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND,
             ("%s", "Failed to init download format"), (NULL));
         return FALSE;
@@ -492,6 +577,13 @@ gst_gl_test_src_fill (GstPushSrc * psrc, GstBuffer * buffer)
     out_gl_wrapped = TRUE;
   }
 
+  if (!gst_gl_test_src_init_shader (src)) {
+    gst_video_frame_unmap (&out_frame);
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, ("%s",
+            "Failed to compile the pattern shader"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+
   gst_buffer_replace (&src->buffer, buffer);
 
   //blocking call, generate a FBO
@@ -511,21 +603,17 @@ gst_gl_test_src_fill (GstPushSrc * psrc, GstBuffer * buffer)
   }
   gst_video_frame_unmap (&out_frame);
 
-  GST_BUFFER_TIMESTAMP (buffer) = src->timestamp_offset + src->running_time;
-  GST_BUFFER_OFFSET (buffer) = src->n_frames;
-  src->n_frames++;
-  GST_BUFFER_OFFSET_END (buffer) = src->n_frames;
-  if (src->out_info.fps_n) {
-    next_time = gst_util_uint64_scale_int (src->n_frames * GST_SECOND,
-        src->out_info.fps_d, src->out_info.fps_n);
-    GST_BUFFER_DURATION (buffer) = next_time - src->running_time;
-  } else {
-    next_time = src->timestamp_offset;
-    /* NONE means forever */
-    GST_BUFFER_DURATION (buffer) = GST_CLOCK_TIME_NONE;
-  }
+  /* the output may come from a pool of a downstream context */
+  if (!out_gl_wrapped)
+    gst_gl_memory_set_sync_point ((GstGLMemory *) out_frame.map[0].memory,
+        src->context);
 
-  src->running_time = next_time;
+  gst_gl_test_src_set_timestamps (src, buffer);
+
+  if (gst_gl_test_src_is_static (src->pattern_type)) {
+    gst_buffer_replace (&src->cached_buffer, buffer);
+    src->cached_pattern = src->pattern_type;
+  }
 
   return GST_FLOW_OK;
 
@@ -535,11 +623,6 @@ not_negotiated:
         (_("format wasn't negotiated before get function")));
     return GST_FLOW_NOT_NEGOTIATED;
   }
-eos:
-  {
-    GST_DEBUG_OBJECT (src, "eos: 0 framerate, frame %d", (gint) src->n_frames);
-    return GST_FLOW_EOS;
-  }
 }
 
 static gboolean
@@ -562,7 +645,17 @@ gst_gl_test_src_stop (GstBaseSrc * basesrc)
 {
   GstGLTestSrc *src = GST_GL_TEST_SRC (basesrc);
 
+  gst_buffer_replace (&src->cached_buffer, NULL);
+
   if (src->context) {
+    if (src->shader) {
+      gst_object_unref (src->shader);
+      src->shader = NULL;
+      src->shader_fragment = NULL;
+      src->position_loc = -1;
+      src->texcoord_loc = -1;
+    }
+
     if (src->out_tex_id) {
       gst_gl_context_del_texture (src->context, &src->out_tex_id);
     }
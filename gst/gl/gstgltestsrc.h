@@ -56,6 +56,10 @@ G_BEGIN_DECLS
  * @GST_GL_TEST_SRC_CHECKERS8: Checkers pattern (8px)
  * @GST_GL_TEST_SRC_CIRCULAR: Circular pattern
  * @GST_GL_TEST_SRC_BLINK: Alternate between black and white
+ * @GST_GL_TEST_SRC_SMPTE75: SMPTE test pattern (75% color bars)
+ * @GST_GL_TEST_SRC_ZONE_PLATE: Moving zone plate
+ * @GST_GL_TEST_SRC_BALL: Moving ball
+ * @GST_GL_TEST_SRC_SMPTE100: SMPTE test pattern (100% color bars)
  *
  * The test pattern to produce.
  */
@@ -72,7 +76,11 @@ typedef enum {
     GST_GL_TEST_SRC_CHECKERS4,
     GST_GL_TEST_SRC_CHECKERS8,
     GST_GL_TEST_SRC_CIRCULAR,
-    GST_GL_TEST_SRC_BLINK
+    GST_GL_TEST_SRC_BLINK,
+    GST_GL_TEST_SRC_SMPTE75,
+    GST_GL_TEST_SRC_ZONE_PLATE,
+    GST_GL_TEST_SRC_BALL,
+    GST_GL_TEST_SRC_SMPTE100
 } GstGLTestSrcPattern;
 
 typedef struct _GstGLTestSrc GstGLTestSrc;
@@ -104,6 +112,16 @@ struct _GstGLTestSrc {
     guint out_tex_id;
     GstGLDownload *download;
 
+    /* shader of the current pattern, NULL for plain colors */
+    GstGLShader *shader;
+    const gchar *shader_fragment;
+    GLint position_loc;
+    GLint texcoord_loc;
+
+    /* last frame of a static pattern, pushed again instead of rendering */
+    GstBuffer *cached_buffer;
+    GstGLTestSrcPattern cached_pattern;
+
     GstGLDisplay *display;
     GstGLContext *context;
     gint64 timestamp_offset;              /* base offset */
@@ -0,0 +1,942 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-gltexturesink
+ *
+ * Hands the frames as RGBA textures to the application, which pulls them
+ * with the "pull-sample" action signal instead of drawing them in a
+ * window.  Give the application's own OpenGL context with
+ * #GstGLTextureSink:other-context so that the textures are shared with it.
+ *
+ * Frames that are already textures of the context of the sink, as
+ * produced by the other OpenGL elements, are handed out without a copy.
+ * The sample keeps the buffer and therefore the texture alive until it is
+ * released; the sink asks upstream for enough buffers to cover
+ * #GstGLTextureSink:max-samples samples plus the one in use by the
+ * application.
+ *
+ * In "latest" mode, the default, only the newest frame is kept and older
+ * ones are dropped when the application pulls slower than the frame rate.
+ * In "fifo" mode up to #GstGLTextureSink:max-samples frames are queued and
+ * new frames are dropped while the queue is full.  Samples are handed over
+ * without taking a lock; "pull-sample" returns %NULL immediately when no
+ * sample is queued.  "new-sample" is emitted from the streaming thread
+ * after a sample was queued.
+ *
+ * The info structure of each sample, named "GstGLTextureSample", contains:
+ * <itemizedlist>
+ * <listitem>
+ *   <para>
+ *   #guint
+ *   <classname>&quot;texture&quot;</classname>:
+ *   the id of the RGBA texture.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #guint
+ *   <classname>&quot;target&quot;</classname>:
+ *   the texture target, GL_TEXTURE_2D.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #GstGLContext
+ *   <classname>&quot;context&quot;</classname>:
+ *   the context the texture was produced in.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #gpointer
+ *   <classname>&quot;sync&quot;</classname>:
+ *   a GLsync fence signalled when the texture is complete, that the
+ *   application waits on with glWaitSync() or glClientWaitSync() in its
+ *   own context before using the texture.  It is %NULL when the context
+ *   has no sync objects, the sink then waits for the texture with
+ *   glFinish() itself.  The fence is deleted with the sample.
+ *   </para>
+ * </listitem>
+ * </itemizedlist>
+ *
+ * <refsect2>
+ * <title>Examples</title>
+ * |[
+ * sample = NULL;
+ * g_signal_emit_by_name (sink, "pull-sample", &sample);
+ * if (sample) {
+ *   const GstStructure *info = gst_sample_get_info (sample);
+ *   guint texture;
+ *   GLsync sync;
+ *
+ *   gst_structure_get (info, "texture", G_TYPE_UINT, &texture,
+ *       "sync", G_TYPE_POINTER, &sync, NULL);
+ *   if (sync)
+ *     glWaitSync (sync, 0, GL_TIMEOUT_IGNORED);
+ *   ... draw texture ...
+ *   gst_sample_unref (sample);
+ * }
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstgltexturesink.h"
+
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+
+#define GST_CAT_DEFAULT gst_gl_texture_sink_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+enum
+{
+  SIGNAL_NEW_SAMPLE,
+  SIGNAL_PULL_SAMPLE,
+  LAST_SIGNAL
+};
+
+enum
+{
+  PROP_0,
+  PROP_MODE,
+  PROP_MAX_SAMPLES,
+  PROP_OTHER_CONTEXT
+};
+
+#define DEFAULT_MODE GST_GL_TEXTURE_SINK_MODE_LATEST
+#define DEFAULT_MAX_SAMPLES 3
+
+static guint gst_gl_texture_sink_signals[LAST_SIGNAL] = { 0 };
+
+static GstStaticPadTemplate gst_gl_texture_sink_template =
+    GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (GST_GL_UPLOAD_FORMATS) "; "
+        GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_META_GST_VIDEO_GL_TEXTURE_UPLOAD_META,
+            GST_GL_UPLOAD_FORMATS))
+    );
+
+#define GST_TYPE_GL_TEXTURE_SINK_MODE (gst_gl_texture_sink_mode_get_type ())
+static GType
+gst_gl_texture_sink_mode_get_type (void)
+{
+  static GType gl_texture_sink_mode_type = 0;
+  static const GEnumValue mode_types[] = {
+    {GST_GL_TEXTURE_SINK_MODE_LATEST, "Keep the newest frame only", "latest"},
+    {GST_GL_TEXTURE_SINK_MODE_FIFO, "Queue frames in order", "fifo"},
+    {0, NULL, NULL}
+  };
+
+  if (!gl_texture_sink_mode_type) {
+    gl_texture_sink_mode_type =
+        g_enum_register_static ("GstGLTextureSinkMode", mode_types);
+  }
+  return gl_texture_sink_mode_type;
+}
+
+#define gst_gl_texture_sink_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstGLTextureSink, gst_gl_texture_sink,
+    GST_TYPE_VIDEO_SINK, GST_DEBUG_CATEGORY_INIT (gst_gl_texture_sink_debug,
+        "gltexturesink", 0, "OpenGL texture sink"));
+
+static void gst_gl_texture_sink_finalize (GObject * object);
+static void gst_gl_texture_sink_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_gl_texture_sink_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+
+static void gst_gl_texture_sink_set_context (GstElement * element,
+    GstContext * context);
+static GstStateChangeReturn gst_gl_texture_sink_change_state (GstElement *
+    element, GstStateChange transition);
+
+static gboolean gst_gl_texture_sink_query (GstBaseSink * bsink,
+    GstQuery * query);
+static gboolean gst_gl_texture_sink_event (GstBaseSink * bsink,
+    GstEvent * event);
+static gboolean gst_gl_texture_sink_set_caps (GstBaseSink * bsink,
+    GstCaps * caps);
+static gboolean gst_gl_texture_sink_propose_allocation (GstBaseSink * bsink,
+    GstQuery * query);
+static GstFlowReturn gst_gl_texture_sink_preroll (GstBaseSink * bsink,
+    GstBuffer * buf);
+static GstFlowReturn gst_gl_texture_sink_render (GstBaseSink * bsink,
+    GstBuffer * buf);
+
+static GstSample *gst_gl_texture_sink_pull_sample (GstGLTextureSink * sink);
+
+static void
+gst_gl_texture_sink_class_init (GstGLTextureSinkClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+  GstBaseSinkClass *basesink_class;
+
+  gobject_class = (GObjectClass *) klass;
+  element_class = GST_ELEMENT_CLASS (klass);
+  basesink_class = GST_BASE_SINK_CLASS (klass);
+
+  gobject_class->set_property = gst_gl_texture_sink_set_property;
+  gobject_class->get_property = gst_gl_texture_sink_get_property;
+  gobject_class->finalize = gst_gl_texture_sink_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_MODE,
+      g_param_spec_enum ("mode", "Mode",
+          "Whether to keep the newest frame only or to queue frames",
+          GST_TYPE_GL_TEXTURE_SINK_MODE, DEFAULT_MODE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_SAMPLES,
+      g_param_spec_uint ("max-samples", "Max samples",
+          "Number of samples queued in fifo mode", 1,
+          GST_GL_TEXTURE_SINK_MAX_SAMPLES, DEFAULT_MAX_SAMPLES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_OTHER_CONTEXT,
+      g_param_spec_object ("other-context",
+          "External OpenGL context",
+          "Give an external OpenGL context with which to share textures",
+          GST_GL_TYPE_CONTEXT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstGLTextureSink::new-sample:
+   * @sink: the #GstGLTextureSink
+   *
+   * Emitted from the streaming thread when a sample was queued.
+   */
+  gst_gl_texture_sink_signals[SIGNAL_NEW_SAMPLE] =
+      g_signal_new ("new-sample", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, 0, NULL, NULL, g_cclosure_marshal_generic,
+      G_TYPE_NONE, 0, G_TYPE_NONE);
+
+  /**
+   * GstGLTextureSink::pull-sample:
+   * @sink: the #GstGLTextureSink
+   *
+   * Takes the next sample, or the newest one in "latest" mode, without
+   * blocking.
+   *
+   * Returns: a #GstSample or %NULL when no sample is queued.
+   */
+  gst_gl_texture_sink_signals[SIGNAL_PULL_SAMPLE] =
+      g_signal_new ("pull-sample", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstGLTextureSinkClass, pull_sample), NULL, NULL,
+      g_cclosure_marshal_generic, GST_TYPE_SAMPLE, 0, G_TYPE_NONE);
+
+  gst_element_class_set_metadata (element_class, "OpenGL texture sink",
+      "Sink/Video", "Hands the frames to the application as OpenGL textures",
+      "The GStreamer developers");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_gl_texture_sink_template));
+
+  element_class->change_state = gst_gl_texture_sink_change_state;
+  element_class->set_context = gst_gl_texture_sink_set_context;
+
+  basesink_class->query = GST_DEBUG_FUNCPTR (gst_gl_texture_sink_query);
+  basesink_class->event = GST_DEBUG_FUNCPTR (gst_gl_texture_sink_event);
+  basesink_class->set_caps = gst_gl_texture_sink_set_caps;
+  basesink_class->propose_allocation = gst_gl_texture_sink_propose_allocation;
+  basesink_class->preroll = gst_gl_texture_sink_preroll;
+  basesink_class->render = gst_gl_texture_sink_render;
+
+  klass->pull_sample = gst_gl_texture_sink_pull_sample;
+}
+
+static void
+gst_gl_texture_sink_init (GstGLTextureSink * sink)
+{
+  sink->mode = DEFAULT_MODE;
+  sink->max_samples = DEFAULT_MAX_SAMPLES;
+  sink->ring_size = DEFAULT_MAX_SAMPLES;
+}
+
+/* swaps the pointer at @atomic for @newval, returning the previous one */
+static gpointer
+_exchange_pointer (gpointer * atomic, gpointer newval)
+{
+  gpointer oldval;
+
+  do {
+    oldval = g_atomic_pointer_get (atomic);
+  } while (!g_atomic_pointer_compare_and_exchange (atomic, oldval, newval));
+
+  return oldval;
+}
+
+/* Called in the gl thread */
+static void
+_delete_fence (GstGLContext * context, GstGLTextureSinkFence * fence)
+{
+  context->gl_vtable->DeleteSync (fence->sync);
+}
+
+static void
+_free_fence (GstGLTextureSinkFence * fence)
+{
+  gst_object_unref (fence->context);
+  gst_object_unref (fence->sink);
+  g_slice_free (GstGLTextureSinkFence, fence);
+}
+
+/* Called in the gl thread of @context, deletes the fences of released
+ * samples */
+static void
+_delete_released_fences (GstGLTextureSink * sink, GstGLContext * context)
+{
+  GstGLTextureSinkFence *fence, *next;
+
+  fence = _exchange_pointer ((gpointer *) & sink->released_fences, NULL);
+
+  for (; fence; fence = next) {
+    next = fence->next;
+
+    if (fence->context == context)
+      _delete_fence (context, fence);
+    else
+      gst_gl_context_thread_add (fence->context,
+          (GstGLContextThreadFunc) _delete_fence, fence);
+
+    _free_fence (fence);
+  }
+}
+
+static void
+_delete_released_fences_thread (GstGLContext * context, GstGLTextureSink * sink)
+{
+  _delete_released_fences (sink, context);
+}
+
+/* the application released a sample, its fence is deleted in the gl thread
+ * with the next frame, or right away once the sink is stopped */
+static void
+_sample_released (GstGLTextureSinkFence * fence, GstMiniObject * sample)
+{
+  GstGLTextureSink *sink = fence->sink;
+
+  if (!g_atomic_int_get (&sink->running)) {
+    gst_gl_context_thread_add (fence->context,
+        (GstGLContextThreadFunc) _delete_fence, fence);
+    _free_fence (fence);
+    return;
+  }
+
+  do {
+    fence->next = g_atomic_pointer_get (&sink->released_fences);
+  } while (!g_atomic_pointer_compare_and_exchange (&sink->released_fences,
+          fence->next, fence));
+}
+
+static void
+gst_gl_texture_sink_finalize (GObject * object)
+{
+  GstGLTextureSink *sink = GST_GL_TEXTURE_SINK (object);
+  GstGLTextureSinkFence *fence, *next;
+
+  /* samples hold a ref on the sink, only fences of samples released after
+   * the sink was stopped can be left */
+  fence = _exchange_pointer ((gpointer *) & sink->released_fences, NULL);
+  for (; fence; fence = next) {
+    next = fence->next;
+    gst_gl_context_thread_add (fence->context,
+        (GstGLContextThreadFunc) _delete_fence, fence);
+    _free_fence (fence);
+  }
+
+  if (sink->other_context) {
+    gst_object_unref (sink->other_context);
+    sink->other_context = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_gl_texture_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGLTextureSink *sink = GST_GL_TEXTURE_SINK (object);
+
+  switch (prop_id) {
+    case PROP_MODE:
+      sink->mode = g_value_get_enum (value);
+      break;
+    case PROP_MAX_SAMPLES:
+      sink->max_samples = g_value_get_uint (value);
+      break;
+    case PROP_OTHER_CONTEXT:
+      if (sink->other_context)
+        gst_object_unref (sink->other_context);
+      sink->other_context = g_value_dup_object (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gl_texture_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGLTextureSink *sink = GST_GL_TEXTURE_SINK (object);
+
+  switch (prop_id) {
+    case PROP_MODE:
+      g_value_set_enum (value, sink->mode);
+      break;
+    case PROP_MAX_SAMPLES:
+      g_value_set_uint (value, sink->max_samples);
+      break;
+    case PROP_OTHER_CONTEXT:
+      g_value_set_object (value, sink->other_context);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* Queues @sample, returns FALSE when the queue was full and @sample was
+ * dropped.  Only called from the streaming thread. */
+static gboolean
+_push_sample (GstGLTextureSink * sink, GstSample * sample)
+{
+  GstSample *old;
+  gint index;
+
+  if (sink->mode == GST_GL_TEXTURE_SINK_MODE_LATEST) {
+    old = _exchange_pointer (&sink->ring[0], sample);
+    if (old) {
+      GST_LOG_OBJECT (sink, "dropping sample %p not pulled in time", old);
+      gst_sample_unref (old);
+    }
+    return TRUE;
+  }
+
+  index = sink->write_index;
+  if (!g_atomic_pointer_compare_and_exchange (&sink->ring[index], NULL,
+          sample)) {
+    GST_LOG_OBJECT (sink, "queue full, dropping sample");
+    gst_sample_unref (sample);
+    return FALSE;
+  }
+  sink->write_index = (index + 1) % sink->ring_size;
+
+  return TRUE;
+}
+
+/* Takes the next queued sample, the slot is claimed by advancing the read
+ * index first so that flushing and the application can pop concurrently */
+static GstSample *
+_pop_sample (GstGLTextureSink * sink)
+{
+  gint index;
+
+  if (sink->mode == GST_GL_TEXTURE_SINK_MODE_LATEST)
+    return _exchange_pointer (&sink->ring[0], NULL);
+
+  do {
+    index = g_atomic_int_get (&sink->read_index);
+    if (!g_atomic_pointer_get (&sink->ring[index]))
+      return NULL;
+  } while (!g_atomic_int_compare_and_exchange (&sink->read_index, index,
+          (index + 1) % sink->ring_size));
+
+  return _exchange_pointer (&sink->ring[index], NULL);
+}
+
+static void
+_flush_samples (GstGLTextureSink * sink)
+{
+  GstSample *sample;
+
+  while ((sample = _pop_sample (sink)))
+    gst_sample_unref (sample);
+
+  gst_buffer_replace (&sink->preroll_buffer, NULL);
+}
+
+static GstSample *
+gst_gl_texture_sink_pull_sample (GstGLTextureSink * sink)
+{
+  return _pop_sample (sink);
+}
+
+static gboolean
+_ensure_gl_setup (GstGLTextureSink * sink)
+{
+  GError *error = NULL;
+
+  if (!gst_gl_ensure_display (sink, &sink->display))
+    return FALSE;
+
+  if (!sink->context) {
+    sink->context = gst_gl_context_new (sink->display);
+    if (!gst_gl_context_create (sink->context, sink->other_context, &error))
+      goto context_error;
+
+    sink->have_sync = sink->context->gl_vtable->FenceSync != NULL;
+    GST_INFO_OBJECT (sink, "handing out %s",
+        sink->have_sync ? "fences" : "finished textures");
+  }
+
+  return TRUE;
+
+context_error:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, NOT_FOUND, ("%s", error->message),
+        (NULL));
+    g_clear_error (&error);
+    gst_object_unref (sink->context);
+    sink->context = NULL;
+    return FALSE;
+  }
+}
+
+static void
+gst_gl_texture_sink_set_context (GstElement * element, GstContext * context)
+{
+  GstGLTextureSink *sink = GST_GL_TEXTURE_SINK (element);
+
+  gst_gl_handle_set_context (element, context, &sink->display);
+}
+
+static gboolean
+gst_gl_texture_sink_query (GstBaseSink * bsink, GstQuery * query)
+{
+  GstGLTextureSink *sink = GST_GL_TEXTURE_SINK (bsink);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:
+      return gst_gl_handle_context_query ((GstElement *) sink, query,
+          &sink->display);
+    default:
+      return GST_BASE_SINK_CLASS (parent_class)->query (bsink, query);
+  }
+}
+
+static gboolean
+gst_gl_texture_sink_event (GstBaseSink * bsink, GstEvent * event)
+{
+  GstGLTextureSink *sink = GST_GL_TEXTURE_SINK (bsink);
+
+  /* serialized, nothing is pushed while the samples are dropped */
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+    _flush_samples (sink);
+
+  return GST_BASE_SINK_CLASS (parent_class)->event (bsink, event);
+}
+
+static void
+_cleanup_gl (GstGLTextureSink * sink)
+{
+  if (sink->upload) {
+    gst_object_unref (sink->upload);
+    sink->upload = NULL;
+  }
+
+  if (sink->pool) {
+    gst_object_unref (sink->pool);
+    sink->pool = NULL;
+  }
+
+  if (sink->copy_pool) {
+    gst_buffer_pool_set_active (sink->copy_pool, FALSE);
+    gst_object_unref (sink->copy_pool);
+    sink->copy_pool = NULL;
+  }
+
+  if (sink->caps) {
+    gst_caps_unref (sink->caps);
+    sink->caps = NULL;
+  }
+
+  if (sink->context) {
+    gst_gl_context_thread_add (sink->context,
+        (GstGLContextThreadFunc) _delete_released_fences_thread, sink);
+    gst_object_unref (sink->context);
+    sink->context = NULL;
+  }
+
+  if (sink->display) {
+    gst_object_unref (sink->display);
+    sink->display = NULL;
+  }
+}
+
+static GstStateChangeReturn
+gst_gl_texture_sink_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstGLTextureSink *sink = GST_GL_TEXTURE_SINK (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      sink->ring_size = sink->mode == GST_GL_TEXTURE_SINK_MODE_FIFO ?
+          sink->max_samples : 1;
+      sink->write_index = 0;
+      g_atomic_int_set (&sink->read_index, 0);
+      g_atomic_int_set (&sink->running, 1);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      _flush_samples (sink);
+      g_atomic_int_set (&sink->running, 0);
+      _cleanup_gl (sink);
+      GST_VIDEO_SINK_WIDTH (sink) = 1;
+      GST_VIDEO_SINK_HEIGHT (sink) = 1;
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static gboolean
+gst_gl_texture_sink_set_caps (GstBaseSink * bsink, GstCaps * caps)
+{
+  GstGLTextureSink *sink = GST_GL_TEXTURE_SINK (bsink);
+  GstVideoInfo info, out_info;
+  GstStructure *config;
+
+  GST_DEBUG_OBJECT (sink, "set caps with %" GST_PTR_FORMAT, caps);
+
+  if (!gst_video_info_from_caps (&info, caps))
+    return FALSE;
+
+  if (!_ensure_gl_setup (sink))
+    return FALSE;
+
+  /* the textures handed out are always RGBA */
+  gst_video_info_set_format (&out_info, GST_VIDEO_FORMAT_RGBA,
+      GST_VIDEO_INFO_WIDTH (&info), GST_VIDEO_INFO_HEIGHT (&info));
+  GST_VIDEO_INFO_FPS_N (&out_info) = GST_VIDEO_INFO_FPS_N (&info);
+  GST_VIDEO_INFO_FPS_D (&out_info) = GST_VIDEO_INFO_FPS_D (&info);
+  GST_VIDEO_INFO_PAR_N (&out_info) = GST_VIDEO_INFO_PAR_N (&info);
+  GST_VIDEO_INFO_PAR_D (&out_info) = GST_VIDEO_INFO_PAR_D (&info);
+
+  if (sink->caps)
+    gst_caps_unref (sink->caps);
+  sink->caps = gst_video_info_to_caps (&out_info);
+
+  if (sink->upload)
+    gst_object_unref (sink->upload);
+  sink->upload = gst_gl_upload_new (sink->context);
+  if (!gst_gl_upload_init_format (sink->upload, info, out_info))
+    goto upload_error;
+
+  /* frames that are not textures of our context are copied into buffers
+   * of this pool, it has no maximum as the application holds samples for
+   * as long as it wants */
+  if (sink->copy_pool) {
+    gst_buffer_pool_set_active (sink->copy_pool, FALSE);
+    gst_object_unref (sink->copy_pool);
+  }
+  sink->copy_pool = gst_gl_buffer_pool_new (sink->context);
+  config = gst_buffer_pool_get_config (sink->copy_pool);
+  gst_buffer_pool_config_set_params (config, sink->caps, out_info.size, 0, 0);
+  if (!gst_buffer_pool_set_config (sink->copy_pool, config))
+    goto pool_error;
+
+  sink->info = info;
+  GST_VIDEO_SINK_WIDTH (sink) = GST_VIDEO_INFO_WIDTH (&info);
+  GST_VIDEO_SINK_HEIGHT (sink) = GST_VIDEO_INFO_HEIGHT (&info);
+
+  return TRUE;
+
+upload_error:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, NOT_FOUND, ("Failed to init upload"),
+        (NULL));
+    return FALSE;
+  }
+pool_error:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, SETTINGS,
+        ("Failed to configure the texture pool"), (NULL));
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_gl_texture_sink_propose_allocation (GstBaseSink * bsink, GstQuery * query)
+{
+  GstGLTextureSink *sink = GST_GL_TEXTURE_SINK (bsink);
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  GstStructure *gl_context;
+  GstCaps *caps;
+  GstVideoInfo info;
+  gchar *platform, *gl_apis;
+  gpointer handle;
+  gboolean need_pool;
+  guint min_buffers;
+
+  if (!_ensure_gl_setup (sink))
+    return FALSE;
+
+  gst_query_parse_allocation (query, &caps, &need_pool);
+
+  if (caps == NULL) {
+    GST_DEBUG_OBJECT (sink, "no caps specified");
+    return FALSE;
+  }
+
+  if (!gst_video_info_from_caps (&info, caps)) {
+    GST_DEBUG_OBJECT (sink, "invalid caps specified");
+    return FALSE;
+  }
+
+  /* the queued samples, the one the application draws and the one being
+   * rendered */
+  min_buffers = sink->max_samples + 2;
+
+  if (need_pool) {
+    if (sink->pool)
+      gst_object_unref (sink->pool);
+    sink->pool = pool = gst_gl_buffer_pool_new (sink->context);
+
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, info.size, min_buffers,
+        0);
+    if (!gst_buffer_pool_set_config (pool, config)) {
+      GST_DEBUG_OBJECT (sink, "failed setting config");
+      return FALSE;
+    }
+  }
+
+  gst_query_add_allocation_pool (query, pool, info.size, min_buffers, 0);
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, 0);
+
+  gl_apis = gst_gl_api_to_string (gst_gl_context_get_gl_api (sink->context));
+  platform =
+      gst_gl_platform_to_string (gst_gl_context_get_gl_platform
+      (sink->context));
+  handle = (gpointer) gst_gl_context_get_gl_context (sink->context);
+
+  gl_context =
+      gst_structure_new ("GstVideoGLTextureUploadMeta", "gst.gl.GstGLContext",
+      GST_GL_TYPE_CONTEXT, sink->context, "gst.gl.context.handle",
+      G_TYPE_POINTER, handle, "gst.gl.context.type", G_TYPE_STRING, platform,
+      "gst.gl.context.apis", G_TYPE_STRING, gl_apis, NULL);
+  gst_query_add_allocation_meta (query,
+      GST_VIDEO_GL_TEXTURE_UPLOAD_META_API_TYPE, gl_context);
+
+  g_free (gl_apis);
+  g_free (platform);
+  gst_structure_free (gl_context);
+
+  return TRUE;
+}
+
+/* Returns the texture of @buf when it is a whole RGBA texture of our
+ * context, 0 otherwise */
+static guint
+_get_buffer_texture (GstGLTextureSink * sink, GstBuffer * buf)
+{
+  GstGLMemory *gl_mem;
+  GstMapInfo map;
+  guint tex_id;
+
+  if (gst_buffer_n_memory (buf) != 1)
+    return 0;
+
+  gl_mem = (GstGLMemory *) gst_buffer_peek_memory (buf, 0);
+  if (!gst_is_gl_memory ((GstMemory *) gl_mem)
+      || GST_GL_MEMORY_IS_PLANE (gl_mem) || gl_mem->atlas
+      || gl_mem->context != sink->context)
+    return 0;
+
+  /* uploads the data when it was written to from the CPU */
+  if (!gst_memory_map ((GstMemory *) gl_mem, &map, GST_MAP_READ | GST_MAP_GL))
+    return 0;
+  tex_id = *(guint *) map.data;
+  gst_memory_unmap ((GstMemory *) gl_mem, &map);
+  /* upstream may have rendered into our pool from its context */
+  gst_gl_memory_wait_sync (gl_mem, sink->context);
+
+  return tex_id;
+}
+
+/* Uploads @buf into a texture of the copy pool */
+static GstBuffer *
+_copy_buffer (GstGLTextureSink * sink, GstBuffer * buf, guint * tex_id)
+{
+  GstBuffer *outbuf = NULL;
+  GstGLMemory *gl_mem;
+  guint upload_tex;
+
+  if (!gst_buffer_pool_is_active (sink->copy_pool)
+      && !gst_buffer_pool_set_active (sink->copy_pool, TRUE))
+    return NULL;
+
+  if (gst_buffer_pool_acquire_buffer (sink->copy_pool, &outbuf,
+          NULL) != GST_FLOW_OK)
+    return NULL;
+
+  if (!gst_gl_upload_perform_with_buffer (sink->upload, buf, &upload_tex))
+    goto error;
+
+  gl_mem = (GstGLMemory *) gst_buffer_peek_memory (outbuf, 0);
+  if (!gst_gl_memory_copy_from_texture (gl_mem, upload_tex)) {
+    gst_gl_upload_release_buffer (sink->upload);
+    goto error;
+  }
+  gst_gl_upload_release_buffer (sink->upload);
+
+  GST_GL_MEMORY_FLAG_SET (gl_mem, GST_GL_MEMORY_FLAG_NEED_DOWNLOAD);
+  gst_buffer_copy_into (outbuf, buf, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+  *tex_id = gl_mem->tex_id;
+
+  return outbuf;
+
+error:
+  gst_buffer_unref (outbuf);
+  return NULL;
+}
+
+typedef struct
+{
+  GstGLTextureSink *sink;
+  GLsync sync;
+} FenceParams;
+
+/* Called in the gl thread */
+static void
+_insert_fence (GstGLContext * context, FenceParams * params)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+
+  _delete_released_fences (params->sink, context);
+
+  if (params->sink->have_sync) {
+    params->sync = gl->FenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    /* the fence has to reach the GPU before another context waits on it */
+    gl->Flush ();
+  } else {
+    params->sync = NULL;
+    gl->Finish ();
+  }
+}
+
+static GstSample *
+_make_sample (GstGLTextureSink * sink, GstBuffer * buf)
+{
+  GstBaseSink *bsink = GST_BASE_SINK (sink);
+  GstGLTextureSinkFence *fence;
+  GstBuffer *outbuf;
+  GstSample *sample;
+  FenceParams params;
+  guint tex_id;
+
+  if ((tex_id = _get_buffer_texture (sink, buf))) {
+    outbuf = gst_buffer_ref (buf);
+  } else if (!(outbuf = _copy_buffer (sink, buf, &tex_id))) {
+    return NULL;
+  }
+
+  params.sink = sink;
+  gst_gl_context_thread_add (sink->context,
+      (GstGLContextThreadFunc) _insert_fence, &params);
+
+  sample = gst_sample_new (outbuf, sink->caps, &bsink->segment,
+      gst_structure_new ("GstGLTextureSample",
+          "texture", G_TYPE_UINT, tex_id,
+          "target", G_TYPE_UINT, (guint) GL_TEXTURE_2D,
+          "context", GST_GL_TYPE_CONTEXT, sink->context,
+          "sync", G_TYPE_POINTER, params.sync, NULL));
+  gst_buffer_unref (outbuf);
+
+  if (params.sync) {
+    fence = g_slice_new0 (GstGLTextureSinkFence);
+    fence->sink = gst_object_ref (sink);
+    fence->context = gst_object_ref (sink->context);
+    fence->sync = params.sync;
+    gst_mini_object_weak_ref (GST_MINI_OBJECT (sample),
+        (GstMiniObjectNotify) _sample_released, fence);
+  }
+
+  return sample;
+}
+
+static GstFlowReturn
+_queue_buffer (GstGLTextureSink * sink, GstBuffer * buf)
+{
+  GstSample *sample;
+
+  if (!sink->context || !sink->caps)
+    return GST_FLOW_NOT_NEGOTIATED;
+
+  if (!(sample = _make_sample (sink, buf))) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, NOT_FOUND,
+        ("%s", "Failed to get a texture for the frame"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+
+  if (_push_sample (sink, sample))
+    g_signal_emit (sink, gst_gl_texture_sink_signals[SIGNAL_NEW_SAMPLE], 0);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_gl_texture_sink_preroll (GstBaseSink * bsink, GstBuffer * buf)
+{
+  GstGLTextureSink *sink = GST_GL_TEXTURE_SINK (bsink);
+
+  gst_buffer_replace (&sink->preroll_buffer, buf);
+
+  return _queue_buffer (sink, buf);
+}
+
+static GstFlowReturn
+gst_gl_texture_sink_render (GstBaseSink * bsink, GstBuffer * buf)
+{
+  GstGLTextureSink *sink = GST_GL_TEXTURE_SINK (bsink);
+
+  /* already handed out when prerolling */
+  if (buf == sink->preroll_buffer) {
+    gst_buffer_replace (&sink->preroll_buffer, NULL);
+    return GST_FLOW_OK;
+  }
+  gst_buffer_replace (&sink->preroll_buffer, NULL);
+
+  return _queue_buffer (sink, buf);
+}
@@ -0,0 +1,110 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_GL_TEXTURE_SINK_H_
+#define _GST_GL_TEXTURE_SINK_H_
+
+#include <gst/gst.h>
+#include <gst/video/gstvideosink.h>
+#include <gst/video/video.h>
+
+#include <gst/gl/gl.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GL_TEXTURE_SINK            (gst_gl_texture_sink_get_type())
+#define GST_GL_TEXTURE_SINK(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_TEXTURE_SINK,GstGLTextureSink))
+#define GST_IS_GL_TEXTURE_SINK(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_TEXTURE_SINK))
+#define GST_GL_TEXTURE_SINK_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GST_TYPE_GL_TEXTURE_SINK,GstGLTextureSinkClass))
+#define GST_IS_GL_TEXTURE_SINK_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GST_TYPE_GL_TEXTURE_SINK))
+#define GST_GL_TEXTURE_SINK_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GST_TYPE_GL_TEXTURE_SINK,GstGLTextureSinkClass))
+
+/* largest number of queued samples */
+#define GST_GL_TEXTURE_SINK_MAX_SAMPLES 16
+
+typedef struct _GstGLTextureSink GstGLTextureSink;
+typedef struct _GstGLTextureSinkClass GstGLTextureSinkClass;
+typedef struct _GstGLTextureSinkFence GstGLTextureSinkFence;
+
+typedef enum
+{
+  GST_GL_TEXTURE_SINK_MODE_LATEST,
+  GST_GL_TEXTURE_SINK_MODE_FIFO
+} GstGLTextureSinkMode;
+
+/* a fence that is still referenced by a sample, deleted in the GL thread
+ * once the sample is gone */
+struct _GstGLTextureSinkFence
+{
+  GstGLTextureSinkFence *next;
+  GstGLTextureSink *sink;
+  GstGLContext *context;
+  GLsync sync;
+};
+
+struct _GstGLTextureSink
+{
+  GstVideoSink video_sink;
+
+  /* properties, only changed in NULL or READY */
+  GstGLTextureSinkMode mode;
+  guint max_samples;
+
+  GstVideoInfo info;
+  GstCaps *caps;
+
+  GstGLDisplay *display;
+  GstGLContext *context;
+  GstGLContext *other_context;
+
+  GstGLUpload *upload;
+  GstBufferPool *pool;
+  GstBufferPool *copy_pool;
+
+  /* samples handed from the streaming thread to the application, only
+   * accessed atomically.  In latest mode only ring[0] is used. */
+  gpointer ring[GST_GL_TEXTURE_SINK_MAX_SAMPLES];
+  guint ring_size;
+  gint write_index;
+  gint read_index;
+
+  /* the prerolled buffer, not queued again when it is rendered */
+  GstBuffer *preroll_buffer;
+
+  /* fences released by the application, pushed atomically */
+  GstGLTextureSinkFence *released_fences;
+  volatile gint running;
+
+  gboolean have_sync;
+};
+
+struct _GstGLTextureSinkClass
+{
+  GstVideoSinkClass video_sink_class;
+
+  /* actions */
+  GstSample *(*pull_sample) (GstGLTextureSink * sink);
+};
+
+GType gst_gl_texture_sink_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_GL_TEXTURE_SINK_H_ */
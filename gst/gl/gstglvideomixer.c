@@ -74,11 +74,12 @@ static const gchar *video_mixer_v_src =
     "attribute vec2 a_texCoord;                                   \n"
     "uniform float x_scale;                                       \n"
     "uniform float y_scale;                                       \n"
+    "uniform vec4 tex_rect;                                       \n"
     "varying vec2 v_texCoord;                                     \n"
     "void main()                                                  \n"
     "{                                                            \n"
     "   gl_Position = a_position * vec4(x_scale, y_scale, 1.0, 1.0);\n"
-    "   v_texCoord = a_texCoord;                                  \n" "}";
+    "   v_texCoord = mix(tex_rect.xy, tex_rect.zw, a_texCoord);   \n" "}";
 
 /* fragment source */
 static const gchar *video_mixer_f_src =
@@ -190,12 +191,8 @@ gst_gl_video_mixer_callback (gpointer stuff)
   GLint attr_texture_loc = 0;
   guint out_width, out_height;
 
-  const GLushort indices[] = {
-    0, 1, 2,
-    0, 2, 3
-  };
-
   guint count = 0;
+  guint bound_tex = 0;
 
   out_width = GST_VIDEO_INFO_WIDTH (&mixer->out_info);
   out_height = GST_VIDEO_INFO_HEIGHT (&mixer->out_info);
@@ -219,12 +216,21 @@ gst_gl_video_mixer_callback (gpointer stuff)
 
   gl->Enable (GL_BLEND);
 
+  gl->BlendFunc (GL_SRC_COLOR, GL_ONE_MINUS_SRC_COLOR);
+  gl->BlendEquation (GL_FUNC_ADD);
+
+  gl->ActiveTexture (GL_TEXTURE0);
+  gst_gl_shader_set_uniform_1i (video_mixer->shader, "texture", 0);
+
+  gst_gl_context_bind_geometry (mixer->context, GST_GL_GEOMETRY_QUAD,
+      attr_position_loc, attr_texture_loc);
+
   while (count < video_mixer->input_frames->len) {
     GstGLMixerFrameData *frame;
-    GLfloat *v_vertices;
     guint in_tex;
     guint in_width, in_height;
     gfloat w, h;
+    gfloat *tc;
 
     frame = g_ptr_array_index (video_mixer->input_frames, count);
     in_tex = frame->texture;
@@ -246,45 +252,24 @@ gst_gl_video_mixer_callback (gpointer stuff)
     GST_TRACE ("processing texture:%u dimensions:%ux%u, %fx%f", in_tex,
         in_width, in_height, w, h);
 
-    /* *INDENT-OFF* */
-    v_vertices = (GLfloat[]) {
-      /* front face */
-      -1.0, -1.0, -1.0f,
-      0.0f, 0.0f,
-      1.0, -1.0, -1.0f,
-      1.0f, 0.0f,
-      1.0, 1.0, -1.0f,
-      1.0f, 1.0f,
-      -1.0, 1.0, -1.0f,
-      0.0f, 1.0f,
-    };
-    /* *INDENT-ON* */
-
-    gl->VertexAttribPointer (attr_position_loc, 3, GL_FLOAT,
-        GL_FALSE, 5 * sizeof (GLfloat), &v_vertices[0]);
-
-    gl->VertexAttribPointer (attr_texture_loc, 2, GL_FLOAT,
-        GL_FALSE, 5 * sizeof (GLfloat), &v_vertices[3]);
-
-    gl->EnableVertexAttribArray (attr_position_loc);
-    gl->EnableVertexAttribArray (attr_texture_loc);
-
-    gl->BlendFunc (GL_SRC_COLOR, GL_ONE_MINUS_SRC_COLOR);
-    gl->BlendEquation (GL_FUNC_ADD);
-
-    gl->ActiveTexture (GL_TEXTURE0);
-    gl->BindTexture (GL_TEXTURE_2D, in_tex);
-    gst_gl_shader_set_uniform_1i (video_mixer->shader, "texture", 0);
+    /* inputs allocated from a texture atlas only cover part of in_tex */
+    tc = frame->tex_coords;
+
+    if (in_tex != bound_tex) {
+      gl->BindTexture (GL_TEXTURE_2D, in_tex);
+      bound_tex = in_tex;
+    }
     gst_gl_shader_set_uniform_1f (video_mixer->shader, "x_scale", w);
     gst_gl_shader_set_uniform_1f (video_mixer->shader, "y_scale", h);
+    gst_gl_shader_set_uniform_4f (video_mixer->shader, "tex_rect", tc[0], tc[1],
+        tc[2], tc[3]);
 
-    gl->DrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+    gst_gl_context_draw_geometry (mixer->context, 0, 1);
 
     ++count;
   }
 
-  gl->DisableVertexAttribArray (attr_position_loc);
-  gl->DisableVertexAttribArray (attr_texture_loc);
+  gst_gl_context_unbind_geometry (mixer->context);
 
   gl->BindTexture (GL_TEXTURE_2D, 0);
 
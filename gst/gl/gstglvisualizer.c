@@ -0,0 +1,1299 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-glvisualizer
+ *
+ * Renders an audio stream as a spectrum, a waveform or a stereo scope.
+ *
+ * <refsect2>
+ * <title>Rendering</title>
+ * <para>
+ * The analysis is done on the CPU: the spectrum comes from a real FFT of the
+ * mono mix, reduced to log-spaced bands.  The result is uploaded as one small
+ * vertex attribute per bar, line segment or point and everything is drawn
+ * with a single instanced draw call, so many of these can render next to
+ * each other for little GPU time.  Without instanced arrays the instances are
+ * expanded on the CPU and still drawn in one call.  No fixed function state
+ * is used, so GLES2 and core profile contexts work as well.
+ * </para>
+ * </refsect2>
+ * <refsect2>
+ * <title>Examples</title>
+ * |[
+ * gst-launch-1.0 audiotestsrc wave=pink-noise ! glvisualizer style=spectrum bands=32 ! glimagesink
+ * ]| Show the spectrum of pink noise in 32 bands.
+ * |[
+ * gst-launch-1.0 filesrc location=music.ogg ! decodebin ! audioconvert ! glvisualizer style=scope ! \
+ *   video/x-raw, width=256, height=256 ! glimagesink
+ * ]| Show the stereo image of a song.
+ * FBO (Frame Buffer Object) and GLSL are required.
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "gstglvisualizer.h"
+
+#define GST_CAT_DEFAULT gst_gl_visualizer_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+#define DEFAULT_STYLE GST_GL_VISUALIZER_STYLE_SPECTRUM
+#define DEFAULT_BANDS 64
+#define MAX_BANDS 256
+
+#define DEFAULT_WIDTH   320
+#define DEFAULT_HEIGHT  240
+#define DEFAULT_FPS_N   25
+#define DEFAULT_FPS_D   1
+
+/* samples looked at by the FFT, frames shorter than that look back */
+#define FFT_LENGTH 1024
+/* line segments of the waveform and points of the scope */
+#define MAX_POINTS 1024
+#define MAX_INSTANCES (MAX (MAX_BANDS, MAX_POINTS))
+
+/* bands fall back by this factor every frame */
+#define SPECTRUM_DECAY 0.85f
+#define SPECTRUM_FLOOR_DB -60.0f
+
+static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/x-raw, "
+        "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32) " }, "
+        "layout = (string) interleaved, "
+        "channels = (int) [ 1, 2 ], " "rate = (int) [ 1, MAX ]")
+    );
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (GST_GL_DOWNLOAD_FORMATS))
+    );
+
+enum
+{
+  PROP_0,
+  PROP_STYLE,
+  PROP_BANDS,
+  PROP_OTHER_CONTEXT
+};
+
+#define DEBUG_INIT \
+  GST_DEBUG_CATEGORY_INIT (gst_gl_visualizer_debug, "glvisualizer", 0, "glvisualizer element");
+
+#define gst_gl_visualizer_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstGLVisualizer, gst_gl_visualizer,
+    GST_TYPE_ELEMENT, DEBUG_INIT);
+
+static void gst_gl_visualizer_finalize (GObject * object);
+static void gst_gl_visualizer_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_gl_visualizer_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static void gst_gl_visualizer_set_context (GstElement * element,
+    GstContext * context);
+static GstStateChangeReturn gst_gl_visualizer_change_state (GstElement *
+    element, GstStateChange transition);
+
+static GstFlowReturn gst_gl_visualizer_chain (GstPad * pad,
+    GstObject * parent, GstBuffer * buffer);
+static gboolean gst_gl_visualizer_sink_event (GstPad * pad,
+    GstObject * parent, GstEvent * event);
+static gboolean gst_gl_visualizer_sink_query (GstPad * pad,
+    GstObject * parent, GstQuery * query);
+static gboolean gst_gl_visualizer_src_event (GstPad * pad,
+    GstObject * parent, GstEvent * event);
+static gboolean gst_gl_visualizer_src_query (GstPad * pad,
+    GstObject * parent, GstQuery * query);
+
+static void gst_gl_visualizer_reset (GstGLVisualizer * visual);
+static void _render_frame (GstGLContext * context, GstGLVisualizer * visual);
+static void _draw_instances (gpointer stuff);
+static void _delete_buffers (GstGLContext * context, GstGLVisualizer * visual);
+
+#define GST_TYPE_GL_VISUALIZER_STYLE (gst_gl_visualizer_style_get_type ())
+static GType
+gst_gl_visualizer_style_get_type (void)
+{
+  static GType gl_visualizer_style_type = 0;
+  static const GEnumValue style_types[] = {
+    {GST_GL_VISUALIZER_STYLE_SPECTRUM, "Frequency spectrum", "spectrum"},
+    {GST_GL_VISUALIZER_STYLE_WAVEFORM, "Waveform", "waveform"},
+    {GST_GL_VISUALIZER_STYLE_SCOPE, "Stereo vector scope", "scope"},
+    {0, NULL, NULL}
+  };
+
+  if (!gl_visualizer_style_type) {
+    gl_visualizer_style_type =
+        g_enum_register_static ("GstGLVisualizerStyle", style_types);
+  }
+  return gl_visualizer_style_type;
+}
+
+/* *INDENT-OFF* */
+
+/* every instance is a quad, a_corner goes from (0,0) to (1,1) over it and
+ * a_instance holds what was computed on the CPU for it.  The frame is stored
+ * with its first line at y = -1 so y is flipped to draw upwards.  v_value
+ * selects the color, v_alpha fades the instance */
+#define VISUALIZER_VERTEX_HEADER \
+  "attribute vec2 a_corner;\n" \
+  "attribute vec3 a_instance;\n" \
+  "uniform float n_instances;\n" \
+  "uniform vec2 pixel_size;\n" \
+  "varying float v_value;\n" \
+  "varying float v_alpha;\n"
+
+/* a_instance: band, level in [0,1] */
+static const gchar *spectrum_vertex_source =
+  VISUALIZER_VERTEX_HEADER
+  "void main () {\n"
+  "  float width = 2.0 / n_instances;\n"
+  "  float x = -1.0 + (a_instance.x + 0.1 + 0.8 * a_corner.x) * width;\n"
+  "  float y = 1.0 - 2.0 * a_instance.y * a_corner.y;\n"
+  "  gl_Position = vec4(x, y, 0.0, 1.0);\n"
+  "  v_value = a_instance.y * a_corner.y;\n"
+  "  v_alpha = 1.0;\n"
+  "}\n";
+
+/* a_instance: segment, previous and current sample in [-1,1].  The segment
+ * covers both samples plus a pixel so steep edges stay connected */
+static const gchar *waveform_vertex_source =
+  VISUALIZER_VERTEX_HEADER
+  "void main () {\n"
+  "  float width = 2.0 / n_instances;\n"
+  "  float x = -1.0 + (a_instance.x + a_corner.x) * width;\n"
+  "  float lo = min(a_instance.y, a_instance.z) - pixel_size.y;\n"
+  "  float hi = max(a_instance.y, a_instance.z) + pixel_size.y;\n"
+  "  float y = mix(lo, hi, a_corner.y);\n"
+  "  gl_Position = vec4(x, -y, 0.0, 1.0);\n"
+  "  v_value = abs(y);\n"
+  "  v_alpha = 1.0;\n"
+  "}\n";
+
+/* a_instance: left and right sample in [-1,1], age in [0,1].  Mono is
+ * vertical, out of phase content is horizontal */
+static const gchar *scope_vertex_source =
+  VISUALIZER_VERTEX_HEADER
+  "void main () {\n"
+  "  vec2 center = vec2(a_instance.y - a_instance.x,\n"
+  "      a_instance.x + a_instance.y) * 0.70710678;\n"
+  "  vec2 pos = center + (a_corner - 0.5) * pixel_size * 3.0;\n"
+  "  gl_Position = vec4(pos.x, -pos.y, 0.0, 1.0);\n"
+  "  v_value = length(center);\n"
+  "  v_alpha = 1.0 - a_instance.z;\n"
+  "}\n";
+
+static const gchar *visualizer_fragment_source =
+  "#ifdef GL_ES\n"
+  "precision mediump float;\n"
+  "#endif\n"
+  "varying float v_value;\n"
+  "varying float v_alpha;\n"
+  "void main () {\n"
+  "  vec3 low = vec3(0.1, 0.8, 0.3);\n"
+  "  vec3 mid = vec3(0.9, 0.8, 0.1);\n"
+  "  vec3 high = vec3(1.0, 0.2, 0.1);\n"
+  "  vec3 color = v_value < 0.5 ? mix(low, mid, v_value * 2.0)\n"
+  "      : mix(mid, high, v_value * 2.0 - 1.0);\n"
+  "  gl_FragColor = vec4(color, v_alpha);\n"
+  "}\n";
+
+/* triangle strip of the unit quad */
+static const GLfloat corners[] = {
+  0.0f, 0.0f,
+  1.0f, 0.0f,
+  0.0f, 1.0f,
+  1.0f, 1.0f
+};
+
+/* *INDENT-ON* */
+
+/* the same quad as two triangles, used when the instances are expanded */
+static const guint expanded_corners[] = { 0, 1, 2, 2, 1, 3 };
+
+static const gchar *
+gst_gl_visualizer_get_vertex_source (GstGLVisualizerStyle style)
+{
+  switch (style) {
+    case GST_GL_VISUALIZER_STYLE_WAVEFORM:
+      return waveform_vertex_source;
+    case GST_GL_VISUALIZER_STYLE_SCOPE:
+      return scope_vertex_source;
+    case GST_GL_VISUALIZER_STYLE_SPECTRUM:
+    default:
+      return spectrum_vertex_source;
+  }
+}
+
+static void
+gst_gl_visualizer_class_init (GstGLVisualizerClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+
+  gobject_class = (GObjectClass *) klass;
+  element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->finalize = gst_gl_visualizer_finalize;
+  gobject_class->set_property = gst_gl_visualizer_set_property;
+  gobject_class->get_property = gst_gl_visualizer_get_property;
+
+  element_class->set_context = gst_gl_visualizer_set_context;
+  element_class->change_state = gst_gl_visualizer_change_state;
+
+  g_object_class_install_property (gobject_class, PROP_STYLE,
+      g_param_spec_enum ("style", "Style", "What to draw",
+          GST_TYPE_GL_VISUALIZER_STYLE, DEFAULT_STYLE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_BANDS,
+      g_param_spec_uint ("bands", "Bands",
+          "Number of bars of the spectrum", 1, MAX_BANDS, DEFAULT_BANDS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_OTHER_CONTEXT,
+      g_param_spec_object ("other-context",
+          "External OpenGL context",
+          "Give an external OpenGL context with which to share textures",
+          GST_GL_TYPE_CONTEXT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_factory));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_factory));
+
+  gst_element_class_set_metadata (element_class, "OpenGL audio visualizer",
+      "Visualization",
+      "Draws a spectrum, waveform or scope of audio with OpenGL",
+      "The GStreamer developers <gstreamer-devel@lists.freedesktop.org>");
+}
+
+static void
+gst_gl_visualizer_init (GstGLVisualizer * visual)
+{
+  visual->sinkpad = gst_pad_new_from_static_template (&sink_factory, "sink");
+  gst_pad_set_chain_function (visual->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_gl_visualizer_chain));
+  gst_pad_set_event_function (visual->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_gl_visualizer_sink_event));
+  gst_pad_set_query_function (visual->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_gl_visualizer_sink_query));
+  gst_element_add_pad (GST_ELEMENT (visual), visual->sinkpad);
+
+  visual->srcpad = gst_pad_new_from_static_template (&src_factory, "src");
+  gst_pad_set_event_function (visual->srcpad,
+      GST_DEBUG_FUNCPTR (gst_gl_visualizer_src_event));
+  gst_pad_set_query_function (visual->srcpad,
+      GST_DEBUG_FUNCPTR (gst_gl_visualizer_src_query));
+  gst_element_add_pad (GST_ELEMENT (visual), visual->srcpad);
+
+  visual->adapter = gst_adapter_new ();
+
+  visual->style = DEFAULT_STYLE;
+  visual->bands = DEFAULT_BANDS;
+
+  visual->fft = gst_fft_f32_new (FFT_LENGTH, FALSE);
+  visual->fft_in = g_new0 (gfloat, FFT_LENGTH);
+  visual->fft_out = g_new0 (GstFFTF32Complex, FFT_LENGTH / 2 + 1);
+  visual->levels = g_new0 (gfloat, MAX_BANDS);
+
+  visual->max_instances = MAX_INSTANCES;
+  visual->instances = g_new0 (gfloat, 3 * visual->max_instances);
+  visual->expanded = g_new0 (gfloat, 6 * 5 * visual->max_instances);
+
+  gst_audio_info_init (&visual->ainfo);
+  gst_video_info_init (&visual->vinfo);
+  gst_segment_init (&visual->segment, GST_FORMAT_UNDEFINED);
+}
+
+static void
+gst_gl_visualizer_finalize (GObject * object)
+{
+  GstGLVisualizer *visual = GST_GL_VISUALIZER (object);
+
+  g_object_unref (visual->adapter);
+
+  gst_fft_f32_free (visual->fft);
+  g_free (visual->fft_in);
+  g_free (visual->fft_out);
+  g_free (visual->levels);
+  g_free (visual->left);
+  g_free (visual->right);
+  g_free (visual->instances);
+  g_free (visual->expanded);
+
+  if (visual->other_context) {
+    gst_object_unref (visual->other_context);
+    visual->other_context = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_gl_visualizer_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGLVisualizer *visual = GST_GL_VISUALIZER (object);
+
+  switch (prop_id) {
+    case PROP_STYLE:
+      visual->style = g_value_get_enum (value);
+      break;
+    case PROP_BANDS:
+      visual->bands = g_value_get_uint (value);
+      break;
+    case PROP_OTHER_CONTEXT:
+    {
+      if (visual->other_context)
+        gst_object_unref (visual->other_context);
+      visual->other_context = g_value_dup_object (value);
+      break;
+    }
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gl_visualizer_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGLVisualizer *visual = GST_GL_VISUALIZER (object);
+
+  switch (prop_id) {
+    case PROP_STYLE:
+      g_value_set_enum (value, visual->style);
+      break;
+    case PROP_BANDS:
+      g_value_set_uint (value, visual->bands);
+      break;
+    case PROP_OTHER_CONTEXT:
+      g_value_set_object (value, visual->other_context);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gl_visualizer_set_context (GstElement * element, GstContext * context)
+{
+  GstGLVisualizer *visual = GST_GL_VISUALIZER (element);
+
+  gst_gl_handle_set_context (element, context, &visual->display);
+}
+
+/* drops the queued samples and the QoS state */
+static void
+gst_gl_visualizer_flush (GstGLVisualizer * visual)
+{
+  gst_adapter_clear (visual->adapter);
+  memset (visual->levels, 0, MAX_BANDS * sizeof (gfloat));
+
+  GST_OBJECT_LOCK (visual);
+  visual->proportion = 1.0;
+  visual->earliest_time = GST_CLOCK_TIME_NONE;
+  GST_OBJECT_UNLOCK (visual);
+}
+
+/* drops everything that depends on the output caps */
+static void
+gst_gl_visualizer_reset_output (GstGLVisualizer * visual)
+{
+  if (visual->pool) {
+    gst_buffer_pool_set_active (visual->pool, FALSE);
+    gst_object_unref (visual->pool);
+    visual->pool = NULL;
+  }
+
+  //blocking call, delete the FBO
+  if (visual->context && visual->fbo)
+    gst_gl_context_del_fbo (visual->context, visual->fbo, visual->depthbuffer);
+  visual->fbo = 0;
+  visual->depthbuffer = 0;
+
+  visual->negotiated = FALSE;
+}
+
+static void
+gst_gl_visualizer_reset (GstGLVisualizer * visual)
+{
+  gst_gl_visualizer_reset_output (visual);
+  gst_gl_visualizer_flush (visual);
+
+  if (visual->context) {
+    //blocking call, wait the opengl thread has destroyed the shader
+    if (visual->shader)
+      gst_gl_context_del_shader (visual->context, visual->shader);
+    visual->shader = NULL;
+
+    gst_gl_context_thread_add (visual->context,
+        (GstGLContextThreadFunc) _delete_buffers, visual);
+
+    if (visual->frame) {
+      gst_object_unref (visual->frame);
+      visual->frame = NULL;
+    }
+
+    gst_object_unref (visual->context);
+    visual->context = NULL;
+  }
+
+  if (visual->display) {
+    gst_object_unref (visual->display);
+    visual->display = NULL;
+  }
+
+  gst_audio_info_init (&visual->ainfo);
+  gst_video_info_init (&visual->vinfo);
+  gst_segment_init (&visual->segment, GST_FORMAT_UNDEFINED);
+}
+
+static GstStateChangeReturn
+gst_gl_visualizer_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstGLVisualizer *visual = GST_GL_VISUALIZER (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (!gst_gl_ensure_display (visual, &visual->display))
+        return GST_STATE_CHANGE_FAILURE;
+      break;
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_gl_visualizer_flush (visual);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      gst_gl_visualizer_reset (visual);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+_update_frame_size (GstGLVisualizer * visual)
+{
+  gint rate = GST_AUDIO_INFO_RATE (&visual->ainfo);
+  gint fps_n = GST_VIDEO_INFO_FPS_N (&visual->vinfo);
+  gint fps_d = GST_VIDEO_INFO_FPS_D (&visual->vinfo);
+
+  if (rate <= 0 || fps_n <= 0)
+    return;
+
+  visual->spf = gst_util_uint64_scale_int (rate, fps_d, fps_n);
+  visual->duration = gst_util_uint64_scale_int (GST_SECOND, fps_d, fps_n);
+  visual->n_samples = MAX (visual->spf, FFT_LENGTH);
+
+  g_free (visual->left);
+  g_free (visual->right);
+  visual->left = g_new0 (gfloat, visual->n_samples);
+  visual->right = g_new0 (gfloat, visual->n_samples);
+}
+
+static gboolean
+gst_gl_visualizer_sink_setcaps (GstGLVisualizer * visual, GstCaps * caps)
+{
+  GstAudioInfo info;
+
+  if (!gst_audio_info_from_caps (&info, caps))
+    goto wrong_caps;
+
+  visual->ainfo = info;
+  gst_adapter_clear (visual->adapter);
+  _update_frame_size (visual);
+
+  GST_DEBUG_OBJECT (visual, "%d channels at %d Hz",
+      GST_AUDIO_INFO_CHANNELS (&info), GST_AUDIO_INFO_RATE (&info));
+
+  return TRUE;
+
+/* ERRORS */
+wrong_caps:
+  {
+    GST_WARNING_OBJECT (visual, "Wrong caps %" GST_PTR_FORMAT, caps);
+    return FALSE;
+  }
+}
+
+static gboolean
+_ensure_context (GstGLVisualizer * visual)
+{
+  GError *error = NULL;
+
+  if (visual->context)
+    return TRUE;
+
+  if (!gst_gl_ensure_display (visual, &visual->display))
+    return FALSE;
+
+  visual->context = gst_gl_context_new (visual->display);
+  if (!gst_gl_context_create (visual->context, visual->other_context, &error))
+    goto context_error;
+
+  visual->frame = gst_gl_framebuffer_new (visual->context);
+
+  return TRUE;
+
+context_error:
+  {
+    GST_ELEMENT_ERROR (visual, RESOURCE, NOT_FOUND, ("%s", error->message),
+        (NULL));
+    g_clear_error (&error);
+    gst_object_unref (visual->context);
+    visual->context = NULL;
+    return FALSE;
+  }
+}
+
+/* compiles the shader of the current style, outside of the gl thread */
+static gboolean
+_ensure_shader (GstGLVisualizer * visual, GstGLVisualizerStyle style)
+{
+  if (visual->shader && visual->shader_style == style)
+    return TRUE;
+
+  if (visual->shader)
+    gst_gl_context_del_shader (visual->context, visual->shader);
+  visual->shader = NULL;
+
+  //blocking call, wait the opengl thread has compiled the shader
+  if (!gst_gl_context_gen_shader (visual->context,
+          gst_gl_visualizer_get_vertex_source (style),
+          visualizer_fragment_source, &visual->shader)) {
+    GST_ELEMENT_ERROR (visual, RESOURCE, NOT_FOUND,
+        ("%s", "Failed to compile the visualizer shader"), (NULL));
+    return FALSE;
+  }
+  visual->shader_style = style;
+
+  return TRUE;
+}
+
+static GstCaps *
+_fixate_output_caps (GstGLVisualizer * visual, GstCaps * caps)
+{
+  GstStructure *s;
+
+  caps = gst_caps_truncate (caps);
+  caps = gst_caps_make_writable (caps);
+  s = gst_caps_get_structure (caps, 0);
+
+  /* like other visualizers, fixate to something like 320x240x25 */
+  gst_structure_fixate_field_nearest_int (s, "width", DEFAULT_WIDTH);
+  gst_structure_fixate_field_nearest_int (s, "height", DEFAULT_HEIGHT);
+
+  if (gst_structure_has_field (s, "framerate"))
+    gst_structure_fixate_field_nearest_fraction (s, "framerate", DEFAULT_FPS_N,
+        DEFAULT_FPS_D);
+  else
+    gst_structure_set (s, "framerate", GST_TYPE_FRACTION, DEFAULT_FPS_N,
+        DEFAULT_FPS_D, NULL);
+
+  if (gst_structure_has_field (s, "pixel-aspect-ratio"))
+    gst_structure_fixate_field_nearest_fraction (s, "pixel-aspect-ratio", 1, 1);
+
+  return gst_caps_fixate (caps);
+}
+
+static gboolean
+_decide_allocation (GstGLVisualizer * visual, GstCaps * caps)
+{
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  GstQuery *query;
+  guint min, max, size;
+
+  query = gst_query_new_allocation (caps, TRUE);
+  if (!gst_pad_peer_query (visual->srcpad, query)) {
+    /* not a problem, just debug a little */
+    GST_DEBUG_OBJECT (visual, "peer ALLOCATION query failed");
+  }
+
+  if (gst_query_get_n_allocation_pools (query) > 0) {
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+
+    /* we render straight into the textures of the pool so only take
+     * GL pools whose context shares textures with ours, which is the case
+     * for the contexts created on the same display, and that keep the
+     * frame in a single texture */
+    if (pool && GST_IS_GL_BUFFER_POOL (pool)) {
+      GstGLContext *pool_context = GST_GL_BUFFER_POOL (pool)->context;
+      GstGLDisplay *pool_display = NULL;
+
+      if (pool_context)
+        pool_display = gst_gl_context_get_display (pool_context);
+
+      config = gst_buffer_pool_get_config (pool);
+      if ((pool_context != visual->context
+              && pool_display != visual->display)
+          || gst_buffer_pool_config_has_option (config,
+              GST_BUFFER_POOL_OPTION_GL_PLANAR)) {
+        gst_object_unref (pool);
+        pool = NULL;
+      }
+      gst_structure_free (config);
+      if (pool_display)
+        gst_object_unref (pool_display);
+    } else if (pool) {
+      gst_object_unref (pool);
+      pool = NULL;
+    }
+  } else {
+    size = GST_VIDEO_INFO_SIZE (&visual->vinfo);
+    min = max = 0;
+  }
+  gst_query_unref (query);
+
+  if (!pool) {
+    pool = gst_gl_buffer_pool_new (visual->context);
+    size = GST_VIDEO_INFO_SIZE (&visual->vinfo);
+  }
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, size, min, max);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+  if (!gst_buffer_pool_set_config (pool, config)
+      || !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (visual, "failed to configure the buffer pool");
+    gst_object_unref (pool);
+    return FALSE;
+  }
+
+  visual->pool = pool;
+
+  return TRUE;
+}
+
+static gboolean
+gst_gl_visualizer_negotiate (GstGLVisualizer * visual)
+{
+  GstCaps *templ, *caps;
+  gboolean ret = FALSE;
+
+  gst_gl_visualizer_reset_output (visual);
+
+  templ = gst_pad_get_pad_template_caps (visual->srcpad);
+  caps = gst_pad_peer_query_caps (visual->srcpad, templ);
+  gst_caps_unref (templ);
+
+  if (gst_caps_is_empty (caps))
+    goto no_format;
+
+  caps = _fixate_output_caps (visual, caps);
+
+  GST_DEBUG_OBJECT (visual, "negotiating %" GST_PTR_FORMAT, caps);
+
+  if (!gst_video_info_from_caps (&visual->vinfo, caps))
+    goto out;
+
+  if (!gst_pad_set_caps (visual->srcpad, caps))
+    goto out;
+
+  if (!_ensure_context (visual))
+    goto out;
+
+  //blocking call, generate a FBO
+  if (!gst_gl_context_gen_fbo (visual->context,
+          GST_VIDEO_INFO_WIDTH (&visual->vinfo),
+          GST_VIDEO_INFO_HEIGHT (&visual->vinfo), &visual->fbo,
+          &visual->depthbuffer))
+    goto out;
+
+  if (!_decide_allocation (visual, caps))
+    goto out;
+
+  _update_frame_size (visual);
+
+  visual->negotiated = TRUE;
+  ret = TRUE;
+
+out:
+  gst_caps_unref (caps);
+
+  return ret;
+
+  /* ERRORS */
+no_format:
+  {
+    GST_ELEMENT_ERROR (visual, STREAM, FORMAT, (NULL),
+        ("could not negotiate output format"));
+    gst_caps_unref (caps);
+    return FALSE;
+  }
+}
+
+/* deinterleaves the first n_samples of the adapter into left and right */
+static void
+_read_samples (GstGLVisualizer * visual)
+{
+  gint channels = GST_AUDIO_INFO_CHANNELS (&visual->ainfo);
+  guint n = visual->n_samples;
+  const guint8 *data;
+  guint i;
+
+  data = gst_adapter_map (visual->adapter,
+      n * GST_AUDIO_INFO_BPF (&visual->ainfo));
+
+  if (GST_AUDIO_INFO_FORMAT (&visual->ainfo) == GST_AUDIO_FORMAT_F32) {
+    const gfloat *s = (const gfloat *) data;
+
+    for (i = 0; i < n; i++, s += channels) {
+      visual->left[i] = s[0];
+      visual->right[i] = s[channels - 1];
+    }
+  } else {
+    const gint16 *s = (const gint16 *) data;
+
+    for (i = 0; i < n; i++, s += channels) {
+      visual->left[i] = s[0] / 32768.0f;
+      visual->right[i] = s[channels - 1] / 32768.0f;
+    }
+  }
+
+  gst_adapter_unmap (visual->adapter);
+}
+
+/* Log-spaced bands over the FFT bins of the mono mix.  Each band takes the
+ * loudest bin it covers, in dB relative to a full scale sine */
+static void
+_compute_spectrum (GstGLVisualizer * visual, guint bands)
+{
+  const guint n_bins = FFT_LENGTH / 2 + 1;
+  /* hamming window coherent gain times the half length of the FFT */
+  const gfloat full_scale = 0.54f * FFT_LENGTH / 2;
+  gfloat *instances = visual->instances;
+  guint b, i, lo, hi;
+
+  for (i = 0; i < FFT_LENGTH; i++)
+    visual->fft_in[i] = (visual->left[i] + visual->right[i]) / 2;
+
+  gst_fft_f32_window (visual->fft, visual->fft_in, GST_FFT_WINDOW_HAMMING);
+  gst_fft_f32_fft (visual->fft, visual->fft_in, visual->fft_out);
+
+  hi = 1;
+  for (b = 0; b < bands; b++) {
+    gfloat power = 0.0f, db, level;
+
+    lo = hi;
+    hi = (guint) pow (n_bins - 1, (gdouble) (b + 1) / bands);
+    hi = CLAMP (hi, lo + 1, n_bins);
+
+    for (i = lo; i < hi && i < n_bins; i++) {
+      GstFFTF32Complex *c = &visual->fft_out[i];
+
+      power = MAX (power, c->r * c->r + c->i * c->i);
+    }
+
+    db = 10.0f * log10f (power / (full_scale * full_scale) + 1e-12f);
+    level = CLAMP (1.0f - db / SPECTRUM_FLOOR_DB, 0.0f, 1.0f);
+
+    visual->levels[b] = MAX (level, visual->levels[b] * SPECTRUM_DECAY);
+
+    instances[3 * b + 0] = b;
+    instances[3 * b + 1] = visual->levels[b];
+    instances[3 * b + 2] = 0.0f;
+  }
+
+  visual->n_instances = bands;
+}
+
+/* one segment per point, between the previous sample and this one */
+static void
+_compute_waveform (GstGLVisualizer * visual)
+{
+  guint n = MIN (visual->spf, MAX_POINTS);
+  gfloat *instances = visual->instances;
+  gfloat prev = 0.0f;
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    guint j = (guint) ((guint64) i * visual->spf / n);
+    gfloat v = CLAMP ((visual->left[j] + visual->right[j]) / 2, -1.0f, 1.0f);
+
+    instances[3 * i + 0] = i;
+    instances[3 * i + 1] = i ? prev : v;
+    instances[3 * i + 2] = v;
+    prev = v;
+  }
+
+  visual->n_instances = n;
+}
+
+/* one point per sample, the older ones fading out */
+static void
+_compute_scope (GstGLVisualizer * visual)
+{
+  guint n = MIN (visual->spf, MAX_POINTS);
+  gfloat *instances = visual->instances;
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    guint j = (guint) ((guint64) i * visual->spf / n);
+
+    instances[3 * i + 0] = CLAMP (visual->left[j], -1.0f, 1.0f);
+    instances[3 * i + 1] = CLAMP (visual->right[j], -1.0f, 1.0f);
+    instances[3 * i + 2] = 1.0f - (gfloat) (i + 1) / n;
+  }
+
+  visual->n_instances = n;
+}
+
+static GstFlowReturn
+gst_gl_visualizer_render (GstGLVisualizer * visual, GstClockTime timestamp)
+{
+  GstGLVisualizerStyle style;
+  GstVideoFrame frame;
+  GstBuffer *outbuf = NULL;
+  GstFlowReturn ret;
+  guint bands;
+
+  GST_OBJECT_LOCK (visual);
+  style = visual->style;
+  bands = visual->bands;
+  GST_OBJECT_UNLOCK (visual);
+
+  if (!_ensure_shader (visual, style))
+    return GST_FLOW_ERROR;
+
+  _read_samples (visual);
+
+  switch (style) {
+    case GST_GL_VISUALIZER_STYLE_WAVEFORM:
+      _compute_waveform (visual);
+      break;
+    case GST_GL_VISUALIZER_STYLE_SCOPE:
+      _compute_scope (visual);
+      break;
+    case GST_GL_VISUALIZER_STYLE_SPECTRUM:
+    default:
+      _compute_spectrum (visual, bands);
+      break;
+  }
+
+  ret = gst_buffer_pool_acquire_buffer (visual->pool, &outbuf, NULL);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  if (!gst_video_frame_map (&frame, &visual->vinfo, outbuf,
+          GST_MAP_WRITE | GST_MAP_GL)) {
+    gst_buffer_unref (outbuf);
+    return GST_FLOW_ERROR;
+  }
+
+  visual->out_tex = *(guint *) frame.data[0];
+
+  //blocking call, draw the frame in one dispatch
+  gst_gl_context_thread_add (visual->context,
+      (GstGLContextThreadFunc) _render_frame, visual);
+
+  gst_video_frame_unmap (&frame);
+
+  /* the output may come from a pool of a downstream context */
+  if (gst_is_gl_memory (frame.map[0].memory))
+    gst_gl_memory_set_sync_point ((GstGLMemory *) frame.map[0].memory,
+        visual->context);
+
+  GST_BUFFER_PTS (outbuf) = timestamp;
+  GST_BUFFER_DURATION (outbuf) = visual->duration;
+
+  return gst_pad_push (visual->srcpad, outbuf);
+}
+
+static GstFlowReturn
+gst_gl_visualizer_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstGLVisualizer *visual = GST_GL_VISUALIZER (parent);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint bpf, avail;
+
+  if (GST_AUDIO_INFO_RATE (&visual->ainfo) <= 0) {
+    gst_buffer_unref (buffer);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+
+  if (gst_pad_check_reconfigure (visual->srcpad) || !visual->negotiated) {
+    if (!gst_gl_visualizer_negotiate (visual)) {
+      gst_buffer_unref (buffer);
+      return GST_FLOW_NOT_NEGOTIATED;
+    }
+  }
+
+  /* resync on DISCONT */
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DISCONT))
+    gst_adapter_clear (visual->adapter);
+
+  bpf = GST_AUDIO_INFO_BPF (&visual->ainfo);
+
+  gst_adapter_push (visual->adapter, buffer);
+
+  while (TRUE) {
+    GstClockTime timestamp;
+    guint64 dist;
+    gboolean need_skip = FALSE;
+
+    avail = gst_adapter_available (visual->adapter);
+
+    /* we need enough samples for the analysis and for one frame */
+    if (avail < visual->n_samples * bpf)
+      break;
+
+    /* get timestamp of the current adapter byte */
+    timestamp = gst_adapter_prev_pts (visual->adapter, &dist);
+    if (GST_CLOCK_TIME_IS_VALID (timestamp))
+      timestamp += gst_util_uint64_scale_int (dist / bpf, GST_SECOND,
+          GST_AUDIO_INFO_RATE (&visual->ainfo));
+
+    if (GST_CLOCK_TIME_IS_VALID (timestamp)) {
+      GstClockTime qostime;
+
+      /* QoS is done on running time */
+      qostime = gst_segment_to_running_time (&visual->segment, GST_FORMAT_TIME,
+          timestamp) + visual->duration;
+
+      GST_OBJECT_LOCK (visual);
+      /* check for QoS, don't compute buffers that are known to be late */
+      need_skip = GST_CLOCK_TIME_IS_VALID (visual->earliest_time)
+          && qostime <= visual->earliest_time;
+      GST_OBJECT_UNLOCK (visual);
+
+      if (need_skip)
+        GST_DEBUG_OBJECT (visual, "QoS: skip ts: %" GST_TIME_FORMAT
+            ", earliest: %" GST_TIME_FORMAT, GST_TIME_ARGS (qostime),
+            GST_TIME_ARGS (visual->earliest_time));
+    }
+
+    if (!need_skip)
+      ret = gst_gl_visualizer_render (visual, timestamp);
+
+    /* Flush out the number of samples per frame */
+    gst_adapter_flush (visual->adapter, visual->spf * bpf);
+
+    /* quit the loop if something was wrong */
+    if (ret != GST_FLOW_OK)
+      break;
+  }
+
+  return ret;
+}
+
+/* Called in the gl thread */
+static void
+_render_frame (GstGLContext * context, GstGLVisualizer * visual)
+{
+  gst_gl_framebuffer_use_v2 (visual->frame,
+      GST_VIDEO_INFO_WIDTH (&visual->vinfo),
+      GST_VIDEO_INFO_HEIGHT (&visual->vinfo), visual->fbo,
+      visual->depthbuffer, visual->out_tex, _draw_instances, visual);
+}
+
+/* Called in the gl thread */
+static void
+_delete_buffers (GstGLContext * context, GstGLVisualizer * visual)
+{
+  GstGLFuncs *gl = context->gl_vtable;
+
+  if (visual->vertex_buffer)
+    gl->DeleteBuffers (1, &visual->vertex_buffer);
+  visual->vertex_buffer = 0;
+
+  if (visual->instance_buffer)
+    gl->DeleteBuffers (1, &visual->instance_buffer);
+  visual->instance_buffer = 0;
+
+  if (visual->vao)
+    gl->DeleteVertexArrays (1, &visual->vao);
+  visual->vao = 0;
+}
+
+/* without instanced arrays, writes the quad of every instance as two
+ * triangles of (corner, instance) vertices */
+static guint
+_expand_instances (GstGLVisualizer * visual)
+{
+  gfloat *v = visual->expanded;
+  guint i, k;
+
+  for (i = 0; i < visual->n_instances; i++) {
+    for (k = 0; k < G_N_ELEMENTS (expanded_corners); k++) {
+      const GLfloat *corner = &corners[2 * expanded_corners[k]];
+
+      *v++ = corner[0];
+      *v++ = corner[1];
+      *v++ = visual->instances[3 * i + 0];
+      *v++ = visual->instances[3 * i + 1];
+      *v++ = visual->instances[3 * i + 2];
+    }
+  }
+
+  return visual->n_instances * G_N_ELEMENTS (expanded_corners);
+}
+
+static void
+_draw_instances (gpointer stuff)
+{
+  GstGLVisualizer *visual = GST_GL_VISUALIZER (stuff);
+  GstGLFuncs *gl = visual->context->gl_vtable;
+  GstGLShader *shader = visual->shader;
+  GLint corner_loc, instance_loc;
+
+  gl->ClearColor (0.0f, 0.0f, 0.0f, 1.0f);
+  gl->Clear (GL_COLOR_BUFFER_BIT);
+
+  if (visual->n_instances == 0)
+    return;
+
+  if (!visual->vertex_buffer) {
+    gl->GenBuffers (1, &visual->vertex_buffer);
+    gl->BindBuffer (GL_ARRAY_BUFFER, visual->vertex_buffer);
+    gl->BufferData (GL_ARRAY_BUFFER, sizeof (corners), corners,
+        GL_STATIC_DRAW);
+
+    gl->GenBuffers (1, &visual->instance_buffer);
+
+    if (gl->GenVertexArrays)
+      gl->GenVertexArrays (1, &visual->vao);
+  }
+
+  if (visual->vao)
+    gl->BindVertexArray (visual->vao);
+
+  gst_gl_shader_use (shader);
+  gst_gl_shader_set_uniform_1f (shader, "n_instances",
+      (gfloat) visual->n_instances);
+  gst_gl_shader_set_uniform_2f (shader, "pixel_size",
+      2.0f / GST_VIDEO_INFO_WIDTH (&visual->vinfo),
+      2.0f / GST_VIDEO_INFO_HEIGHT (&visual->vinfo));
+
+  corner_loc = gst_gl_shader_get_attribute_location (shader, "a_corner");
+  instance_loc = gst_gl_shader_get_attribute_location (shader, "a_instance");
+
+  /* points of the scope add up where the signal stays */
+  gl->Enable (GL_BLEND);
+  gl->BlendFunc (GL_SRC_ALPHA, GL_ONE);
+
+  if (gl->DrawArraysInstanced && gl->VertexAttribDivisor) {
+    gl->BindBuffer (GL_ARRAY_BUFFER, visual->vertex_buffer);
+    gl->VertexAttribPointer (corner_loc, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+    gl->EnableVertexAttribArray (corner_loc);
+
+    gl->BindBuffer (GL_ARRAY_BUFFER, visual->instance_buffer);
+    gl->BufferData (GL_ARRAY_BUFFER,
+        3 * visual->n_instances * sizeof (gfloat), visual->instances,
+        GL_STREAM_DRAW);
+    gl->VertexAttribPointer (instance_loc, 3, GL_FLOAT, GL_FALSE, 0, NULL);
+    gl->EnableVertexAttribArray (instance_loc);
+    gl->VertexAttribDivisor (instance_loc, 1);
+
+    gl->DrawArraysInstanced (GL_TRIANGLE_STRIP, 0, 4, visual->n_instances);
+
+    gl->VertexAttribDivisor (instance_loc, 0);
+  } else {
+    guint n_vertices = _expand_instances (visual);
+
+    gl->BindBuffer (GL_ARRAY_BUFFER, visual->instance_buffer);
+    gl->BufferData (GL_ARRAY_BUFFER, 5 * n_vertices * sizeof (gfloat),
+        visual->expanded, GL_STREAM_DRAW);
+    gl->VertexAttribPointer (corner_loc, 2, GL_FLOAT, GL_FALSE,
+        5 * sizeof (gfloat), NULL);
+    gl->EnableVertexAttribArray (corner_loc);
+    gl->VertexAttribPointer (instance_loc, 3, GL_FLOAT, GL_FALSE,
+        5 * sizeof (gfloat), (const GLvoid *) (2 * sizeof (gfloat)));
+    gl->EnableVertexAttribArray (instance_loc);
+
+    gl->DrawArrays (GL_TRIANGLES, 0, n_vertices);
+  }
+
+  gl->DisableVertexAttribArray (corner_loc);
+  gl->DisableVertexAttribArray (instance_loc);
+  gl->BindBuffer (GL_ARRAY_BUFFER, 0);
+
+  if (visual->vao)
+    gl->BindVertexArray (0);
+
+  gl->Disable (GL_BLEND);
+
+  gst_gl_context_clear_shader (visual->context);
+}
+
+static gboolean
+gst_gl_visualizer_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstGLVisualizer *visual = GST_GL_VISUALIZER (parent);
+  gboolean res;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:
+    {
+      GstCaps *caps;
+
+      /* the src caps are negotiated when the first frame is rendered */
+      gst_event_parse_caps (event, &caps);
+      res = gst_gl_visualizer_sink_setcaps (visual, caps);
+      gst_event_unref (event);
+      break;
+    }
+    case GST_EVENT_FLUSH_STOP:
+      gst_gl_visualizer_flush (visual);
+      res = gst_pad_push_event (visual->srcpad, event);
+      break;
+    case GST_EVENT_SEGMENT:
+    {
+      /* the segment is used to convert the incoming timestamps to running
+       * time for QoS */
+      gst_event_copy_segment (event, &visual->segment);
+      res = gst_pad_push_event (visual->srcpad, event);
+      break;
+    }
+    default:
+      res = gst_pad_event_default (pad, parent, event);
+      break;
+  }
+
+  return res;
+}
+
+static gboolean
+gst_gl_visualizer_sink_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  GstGLVisualizer *visual = GST_GL_VISUALIZER (parent);
+  gboolean res;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:
+    {
+      res = gst_gl_handle_context_query ((GstElement *) visual, query,
+          &visual->display);
+      break;
+    }
+    default:
+      res = gst_pad_query_default (pad, parent, query);
+      break;
+  }
+
+  return res;
+}
+
+static gboolean
+gst_gl_visualizer_src_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstGLVisualizer *visual = GST_GL_VISUALIZER (parent);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_QOS:
+    {
+      gdouble proportion;
+      GstClockTimeDiff diff;
+      GstClockTime timestamp;
+
+      gst_event_parse_qos (event, NULL, &proportion, &diff, &timestamp);
+
+      /* save stuff for the _chain function */
+      GST_OBJECT_LOCK (visual);
+      visual->proportion = proportion;
+      if (diff >= 0)
+        /* we're late, this is a good estimate for next displayable
+         * frame (see part-qos.txt) */
+        visual->earliest_time = timestamp + 2 * diff + visual->duration;
+      else
+        visual->earliest_time = timestamp + diff;
+      GST_OBJECT_UNLOCK (visual);
+      break;
+    }
+    default:
+      break;
+  }
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+static gboolean
+gst_gl_visualizer_src_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  GstGLVisualizer *visual = GST_GL_VISUALIZER (parent);
+  gboolean res;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:
+    {
+      res = gst_gl_handle_context_query ((GstElement *) visual, query,
+          &visual->display);
+      break;
+    }
+    case GST_QUERY_LATENCY:
+    {
+      GstClockTime min_latency, max_latency, our_latency;
+      gboolean us_live;
+      gint rate = GST_AUDIO_INFO_RATE (&visual->ainfo);
+
+      if ((res = gst_pad_peer_query (visual->sinkpad, query))) {
+        gst_query_parse_latency (query, &us_live, &min_latency, &max_latency);
+
+        /* we buffer the samples of the analysis window */
+        our_latency = rate > 0 ?
+            gst_util_uint64_scale_int (MAX (visual->n_samples, FFT_LENGTH),
+            GST_SECOND, rate) : 0;
+
+        GST_DEBUG_OBJECT (visual, "Our latency: %" GST_TIME_FORMAT,
+            GST_TIME_ARGS (our_latency));
+
+        min_latency += our_latency;
+        if (GST_CLOCK_TIME_IS_VALID (max_latency))
+          max_latency += our_latency;
+
+        gst_query_set_latency (query, us_live, min_latency, max_latency);
+      }
+      break;
+    }
+    default:
+      res = gst_pad_query_default (pad, parent, query);
+      break;
+  }
+
+  return res;
+}
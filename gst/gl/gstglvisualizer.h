@@ -0,0 +1,124 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_GL_VISUALIZER_H_
+#define _GST_GL_VISUALIZER_H_
+
+#include <gst/gst.h>
+#include <gst/base/gstadapter.h>
+#include <gst/audio/audio.h>
+#include <gst/video/video.h>
+#include <gst/fft/gstfftf32.h>
+
+#include <gst/gl/gl.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GL_VISUALIZER            (gst_gl_visualizer_get_type())
+#define GST_GL_VISUALIZER(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_VISUALIZER,GstGLVisualizer))
+#define GST_IS_GL_VISUALIZER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_VISUALIZER))
+#define GST_GL_VISUALIZER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GST_TYPE_GL_VISUALIZER,GstGLVisualizerClass))
+#define GST_IS_GL_VISUALIZER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GST_TYPE_GL_VISUALIZER))
+#define GST_GL_VISUALIZER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GST_TYPE_GL_VISUALIZER,GstGLVisualizerClass))
+
+typedef struct _GstGLVisualizer GstGLVisualizer;
+typedef struct _GstGLVisualizerClass GstGLVisualizerClass;
+
+/**
+ * GstGLVisualizerStyle:
+ * @GST_GL_VISUALIZER_STYLE_SPECTRUM: bars of the log-spaced spectrum
+ * @GST_GL_VISUALIZER_STYLE_WAVEFORM: the mono mix over the frame duration
+ * @GST_GL_VISUALIZER_STYLE_SCOPE: stereo vector scope, mid up and side across
+ *
+ * What is drawn.
+ */
+typedef enum
+{
+  GST_GL_VISUALIZER_STYLE_SPECTRUM,
+  GST_GL_VISUALIZER_STYLE_WAVEFORM,
+  GST_GL_VISUALIZER_STYLE_SCOPE
+} GstGLVisualizerStyle;
+
+struct _GstGLVisualizer
+{
+  GstElement element;
+
+  GstPad *sinkpad;
+  GstPad *srcpad;
+  GstSegment segment;
+  GstAdapter *adapter;
+
+  GstGLVisualizerStyle style;
+  guint bands;
+
+  /* audio/video state */
+  GstAudioInfo ainfo;
+  GstVideoInfo vinfo;
+  gboolean negotiated;
+  GstBufferPool *pool;
+  GstClockTime duration;
+  /* samples consumed per frame and samples looked at per frame */
+  guint spf;
+  guint n_samples;
+
+  /* analysis, all in the streaming thread */
+  GstFFTF32 *fft;
+  gfloat *fft_in;
+  GstFFTF32Complex *fft_out;
+  gfloat *left;
+  gfloat *right;
+  gfloat *levels;
+  guint n_levels;
+
+  /* one vec3 per drawn instance, see the vertex shaders */
+  gfloat *instances;
+  guint n_instances;
+  guint max_instances;
+
+  GstGLDisplay *display;
+  GstGLContext *context;
+  GstGLContext *other_context;
+  GstGLFramebuffer *frame;
+  GLuint fbo;
+  GLuint depthbuffer;
+
+  GstGLShader *shader;
+  GstGLVisualizerStyle shader_style;
+  GLuint vao;
+  GLuint vertex_buffer;
+  GLuint instance_buffer;
+  gfloat *expanded;
+  guint out_tex;
+
+  /* QoS stuff, with LOCK */
+  gdouble proportion;
+  GstClockTime earliest_time;
+};
+
+struct _GstGLVisualizerClass
+{
+  GstElementClass element_class;
+};
+
+GType gst_gl_visualizer_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_GL_VISUALIZER_H_ */
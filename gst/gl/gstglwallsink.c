@@ -0,0 +1,1224 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-glwallsink
+ *
+ * Draws regions of one stream into several windows, or into several
+ * rectangles of the same window, as needed by video walls.  The frame is
+ * uploaded once into a texture of the context of the sink; every window
+ * has its own context, thread and shader and shares the textures of the
+ * sink's context.
+ *
+ * The outputs are given by #GstGLWallSink:outputs, a list of outputs
+ * separated by ';'.  Each output is a list of key=value pairs separated by
+ * spaces:
+ * <itemizedlist>
+ * <listitem>
+ *   <para>
+ *   <classname>&quot;window&quot;</classname>: the index of the window
+ *   to draw into, 0 by default.  Windows are created for every index up to
+ *   the largest one used.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   <classname>&quot;crop&quot;</classname>: x,y,width,height of the
+ *   region of the frame to draw, in pixels.  The whole frame by default.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   <classname>&quot;viewport&quot;</classname>: x,y,width,height of the
+ *   rectangle of the window to draw into, in fractions of the window size
+ *   from its top left corner.  The whole window by default.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   <classname>&quot;aspect&quot;</classname>: "keep" to add borders that
+ *   keep the aspect ratio of the region, "stretch" to fill the rectangle.
+ *   Follows #GstGLWallSink:force-aspect-ratio by default.
+ *   </para>
+ * </listitem>
+ * </itemizedlist>
+ *
+ * Window 0 is given to the application through the #GstVideoOverlay
+ * interface, the other ones with the "set-window-handle" action signal.
+ * Windows without a handle are created by the sink.
+ *
+ * Every frame is presented by all windows at once: the sink asks each
+ * window thread to draw and swap, then waits for all of them before the
+ * next frame, so that the outputs of a wall change on the same vertical
+ * blank when the swaps are synchronized to it.
+ *
+ * <refsect2>
+ * <title>Examples</title>
+ * |[
+ * gst-launch-1.0 videotestsrc ! glwallsink outputs="crop=0,0,160,240 window=0; crop=160,0,160,240 window=1"
+ * ]| The left and right halves of the frame in two windows.
+ * |[
+ * gst-launch-1.0 videotestsrc ! glwallsink outputs="viewport=0,0,0.5,1; viewport=0.5,0,0.5,1 crop=80,60,160,120 aspect=keep"
+ * ]| The frame and a zoom on its center side by side in one window.
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/video/videooverlay.h>
+
+#include "gstglwallsink.h"
+
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_TIMEOUT_IGNORED
+#define GL_TIMEOUT_IGNORED G_GUINT64_CONSTANT (0xFFFFFFFFFFFFFFFF)
+#endif
+
+#define GST_CAT_DEFAULT gst_gl_wall_sink_debug
+GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
+
+enum
+{
+  SIGNAL_SET_WINDOW_HANDLE,
+  LAST_SIGNAL
+};
+
+enum
+{
+  PROP_0,
+  PROP_OUTPUTS,
+  PROP_FORCE_ASPECT_RATIO,
+  PROP_OTHER_CONTEXT
+};
+
+#define DEFAULT_FORCE_ASPECT_RATIO FALSE
+
+static guint gst_gl_wall_sink_signals[LAST_SIGNAL] = { 0 };
+
+/* *INDENT-OFF* */
+static const gchar *wall_vertex_shader_str =
+      "attribute vec4 a_position;   \n"
+      "attribute vec2 a_texCoord;   \n"
+      "uniform vec4 u_texRect;      \n"
+      "varying vec2 v_texCoord;     \n"
+      "void main()                  \n"
+      "{                            \n"
+      "   gl_Position = a_position; \n"
+      "   v_texCoord = u_texRect.xy + a_texCoord * u_texRect.zw;\n"
+      "}                            \n";
+
+static const gchar *wall_fragment_shader_str =
+      "#ifdef GL_ES\n"
+      "precision mediump float;\n"
+      "#endif\n"
+      "varying vec2 v_texCoord;\n"
+      "uniform sampler2D s_texture;\n"
+      "void main()\n"
+      "{\n"
+      "  gl_FragColor = texture2D(s_texture, v_texCoord);\n"
+      "}\n";
+/* *INDENT-ON* */
+
+static GstStaticPadTemplate gst_gl_wall_sink_template =
+    GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (GST_GL_UPLOAD_FORMATS) "; "
+        GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_META_GST_VIDEO_GL_TEXTURE_UPLOAD_META,
+            GST_GL_UPLOAD_FORMATS))
+    );
+
+static void gst_gl_wall_sink_video_overlay_init (GstVideoOverlayInterface *
+    iface);
+
+#define gst_gl_wall_sink_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstGLWallSink, gst_gl_wall_sink,
+    GST_TYPE_VIDEO_SINK, G_IMPLEMENT_INTERFACE (GST_TYPE_VIDEO_OVERLAY,
+        gst_gl_wall_sink_video_overlay_init);
+    GST_DEBUG_CATEGORY_INIT (gst_gl_wall_sink_debug, "glwallsink", 0,
+        "OpenGL video wall sink"));
+
+static void gst_gl_wall_sink_finalize (GObject * object);
+static void gst_gl_wall_sink_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_gl_wall_sink_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+
+static void gst_gl_wall_sink_set_context (GstElement * element,
+    GstContext * context);
+static GstStateChangeReturn gst_gl_wall_sink_change_state (GstElement *
+    element, GstStateChange transition);
+
+static gboolean gst_gl_wall_sink_query (GstBaseSink * bsink,
+    GstQuery * query);
+static void gst_gl_wall_sink_get_times (GstBaseSink * bsink, GstBuffer * buf,
+    GstClockTime * start, GstClockTime * end);
+static gboolean gst_gl_wall_sink_set_caps (GstBaseSink * bsink,
+    GstCaps * caps);
+static gboolean gst_gl_wall_sink_propose_allocation (GstBaseSink * bsink,
+    GstQuery * query);
+static GstFlowReturn gst_gl_wall_sink_render (GstBaseSink * bsink,
+    GstBuffer * buf);
+
+static void gst_gl_wall_sink_set_window_handle_action (GstGLWallSink * sink,
+    guint window, guint64 handle);
+
+static gboolean _parse_outputs (const gchar * desc, GArray * outputs,
+    guint * n_windows);
+
+static void
+gst_gl_wall_sink_class_init (GstGLWallSinkClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+  GstBaseSinkClass *basesink_class;
+
+  gobject_class = (GObjectClass *) klass;
+  element_class = GST_ELEMENT_CLASS (klass);
+  basesink_class = GST_BASE_SINK_CLASS (klass);
+
+  gobject_class->set_property = gst_gl_wall_sink_set_property;
+  gobject_class->get_property = gst_gl_wall_sink_get_property;
+  gobject_class->finalize = gst_gl_wall_sink_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_OUTPUTS,
+      g_param_spec_string ("outputs", "Outputs",
+          "Outputs separated by ';', each made of \"window=N\", "
+          "\"crop=x,y,width,height\", \"viewport=x,y,width,height\" and "
+          "\"aspect=keep|stretch\" separated by spaces", NULL,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FORCE_ASPECT_RATIO,
+      g_param_spec_boolean ("force-aspect-ratio", "Force aspect ratio",
+          "When enabled, outputs that do not say otherwise keep the aspect "
+          "ratio of their region", DEFAULT_FORCE_ASPECT_RATIO,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_OTHER_CONTEXT,
+      g_param_spec_object ("other-context",
+          "External OpenGL context",
+          "Give an external OpenGL context with which to share textures",
+          GST_GL_TYPE_CONTEXT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstGLWallSink::set-window-handle:
+   * @sink: the #GstGLWallSink
+   * @window: the index of the window
+   * @handle: the native window handle to draw into
+   *
+   * Gives the sink the window to draw the outputs of @window into, like
+   * gst_video_overlay_set_window_handle() does for window 0.
+   */
+  gst_gl_wall_sink_signals[SIGNAL_SET_WINDOW_HANDLE] =
+      g_signal_new ("set-window-handle", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstGLWallSinkClass, set_window_handle), NULL, NULL,
+      g_cclosure_marshal_generic, G_TYPE_NONE, 2, G_TYPE_UINT, G_TYPE_UINT64);
+
+  gst_element_class_set_metadata (element_class, "OpenGL video wall sink",
+      "Sink/Video", "Draws regions of a stream into several windows",
+      "The GStreamer developers");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gst_gl_wall_sink_template));
+
+  element_class->change_state = gst_gl_wall_sink_change_state;
+  element_class->set_context = gst_gl_wall_sink_set_context;
+
+  basesink_class->query = GST_DEBUG_FUNCPTR (gst_gl_wall_sink_query);
+  basesink_class->get_times = gst_gl_wall_sink_get_times;
+  basesink_class->set_caps = gst_gl_wall_sink_set_caps;
+  basesink_class->propose_allocation = gst_gl_wall_sink_propose_allocation;
+  basesink_class->preroll = gst_gl_wall_sink_render;
+  basesink_class->render = gst_gl_wall_sink_render;
+
+  klass->set_window_handle = gst_gl_wall_sink_set_window_handle_action;
+}
+
+static void
+gst_gl_wall_sink_init (GstGLWallSink * sink)
+{
+  sink->keep_aspect_ratio = DEFAULT_FORCE_ASPECT_RATIO;
+  sink->outputs = g_array_new (FALSE, TRUE, sizeof (GstGLWallSinkOutput));
+  _parse_outputs (NULL, sink->outputs, &sink->n_windows);
+
+  g_mutex_init (&sink->lock);
+  g_cond_init (&sink->cond);
+}
+
+static void
+gst_gl_wall_sink_finalize (GObject * object)
+{
+  GstGLWallSink *sink = GST_GL_WALL_SINK (object);
+
+  g_free (sink->outputs_desc);
+  g_array_free (sink->outputs, TRUE);
+
+  if (sink->other_context) {
+    gst_object_unref (sink->other_context);
+    sink->other_context = NULL;
+  }
+
+  g_mutex_clear (&sink->lock);
+  g_cond_clear (&sink->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static gboolean
+_parse_int_rect (const gchar * str, gint rect[4])
+{
+  gchar **parts = g_strsplit (str, ",", -1);
+  gboolean ret = g_strv_length (parts) == 4;
+  gint i;
+
+  for (i = 0; ret && i < 4; i++) {
+    gchar *end;
+    gint64 val = g_ascii_strtoll (parts[i], &end, 10);
+
+    if (end == parts[i] || *end != '\0' || val < 0 || val > G_MAXINT)
+      ret = FALSE;
+    rect[i] = val;
+  }
+  g_strfreev (parts);
+
+  return ret;
+}
+
+static gboolean
+_parse_float_rect (const gchar * str, gfloat rect[4])
+{
+  gchar **parts = g_strsplit (str, ",", -1);
+  gboolean ret = g_strv_length (parts) == 4;
+  gint i;
+
+  for (i = 0; ret && i < 4; i++) {
+    gchar *end;
+    gdouble val = g_ascii_strtod (parts[i], &end);
+
+    if (end == parts[i] || *end != '\0' || val < 0.0 || val > 1.0)
+      ret = FALSE;
+    rect[i] = val;
+  }
+  g_strfreev (parts);
+
+  return ret && rect[0] + rect[2] <= 1.0f && rect[1] + rect[3] <= 1.0f;
+}
+
+static gboolean
+_parse_output (const gchar * desc, GstGLWallSinkOutput * output)
+{
+  gchar **pairs;
+  gboolean ret = TRUE;
+  gint i;
+
+  output->window = 0;
+  memset (output->crop, 0, sizeof (output->crop));
+  output->viewport[0] = output->viewport[1] = 0.0f;
+  output->viewport[2] = output->viewport[3] = 1.0f;
+  output->keep_aspect_ratio = -1;
+
+  pairs = g_strsplit_set (desc, " \t", -1);
+  for (i = 0; ret && pairs[i]; i++) {
+    gchar *value;
+
+    if (pairs[i][0] == '\0')
+      continue;
+
+    value = strchr (pairs[i], '=');
+    if (!value) {
+      ret = FALSE;
+      break;
+    }
+    *value++ = '\0';
+
+    if (g_strcmp0 (pairs[i], "window") == 0) {
+      gchar *end;
+      guint64 window = g_ascii_strtoull (value, &end, 10);
+
+      ret = end != value && *end == '\0'
+          && window < GST_GL_WALL_SINK_MAX_WINDOWS;
+      output->window = window;
+    } else if (g_strcmp0 (pairs[i], "crop") == 0) {
+      ret = _parse_int_rect (value, output->crop);
+    } else if (g_strcmp0 (pairs[i], "viewport") == 0) {
+      ret = _parse_float_rect (value, output->viewport);
+    } else if (g_strcmp0 (pairs[i], "aspect") == 0) {
+      if (g_strcmp0 (value, "keep") == 0)
+        output->keep_aspect_ratio = 1;
+      else if (g_strcmp0 (value, "stretch") == 0)
+        output->keep_aspect_ratio = 0;
+      else
+        ret = FALSE;
+    } else {
+      ret = FALSE;
+    }
+  }
+  g_strfreev (pairs);
+
+  return ret;
+}
+
+/* fills @outputs from @desc, one output covering window 0 when @desc is
+ * empty */
+static gboolean
+_parse_outputs (const gchar * desc, GArray * outputs, guint * n_windows)
+{
+  gchar **entries;
+  gboolean ret = TRUE;
+  guint i;
+
+  g_array_set_size (outputs, 0);
+  *n_windows = 0;
+
+  entries = g_strsplit (desc ? desc : "", ";", -1);
+  for (i = 0; ret && entries[i]; i++) {
+    GstGLWallSinkOutput output;
+
+    g_strstrip (entries[i]);
+    if (entries[i][0] == '\0')
+      continue;
+
+    if (outputs->len >= GST_GL_WALL_SINK_MAX_OUTPUTS
+        || !_parse_output (entries[i], &output)) {
+      ret = FALSE;
+      break;
+    }
+
+    g_array_append_val (outputs, output);
+    *n_windows = MAX (*n_windows, output.window + 1);
+  }
+  g_strfreev (entries);
+
+  if (ret && outputs->len == 0) {
+    GstGLWallSinkOutput output;
+
+    _parse_output ("", &output);
+    g_array_append_val (outputs, output);
+    *n_windows = 1;
+  }
+
+  return ret;
+}
+
+static void
+gst_gl_wall_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGLWallSink *sink = GST_GL_WALL_SINK (object);
+
+  switch (prop_id) {
+    case PROP_OUTPUTS:
+    {
+      const gchar *desc = g_value_get_string (value);
+      GArray *outputs, *old_outputs;
+      guint n_windows;
+
+      /* the windows are only created when going to PAUSED */
+      GST_OBJECT_LOCK (sink);
+      if (GST_STATE (sink) > GST_STATE_READY) {
+        GST_OBJECT_UNLOCK (sink);
+        GST_WARNING_OBJECT (sink, "outputs can only be changed in NULL or "
+            "READY");
+        break;
+      }
+      GST_OBJECT_UNLOCK (sink);
+
+      outputs = g_array_new (FALSE, TRUE, sizeof (GstGLWallSinkOutput));
+      if (_parse_outputs (desc, outputs, &n_windows)) {
+        g_mutex_lock (&sink->lock);
+        old_outputs = sink->outputs;
+        sink->outputs = outputs;
+        sink->n_windows = n_windows;
+        g_mutex_unlock (&sink->lock);
+
+        g_array_free (old_outputs, TRUE);
+        g_free (sink->outputs_desc);
+        sink->outputs_desc = g_strdup (desc);
+      } else {
+        GST_WARNING_OBJECT (sink, "invalid outputs \"%s\"", desc);
+        g_array_free (outputs, TRUE);
+      }
+      break;
+    }
+    case PROP_FORCE_ASPECT_RATIO:
+      sink->keep_aspect_ratio = g_value_get_boolean (value);
+      break;
+    case PROP_OTHER_CONTEXT:
+      if (sink->other_context)
+        gst_object_unref (sink->other_context);
+      sink->other_context = g_value_dup_object (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gl_wall_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGLWallSink *sink = GST_GL_WALL_SINK (object);
+
+  switch (prop_id) {
+    case PROP_OUTPUTS:
+      g_value_set_string (value, sink->outputs_desc);
+      break;
+    case PROP_FORCE_ASPECT_RATIO:
+      g_value_set_boolean (value, sink->keep_aspect_ratio);
+      break;
+    case PROP_OTHER_CONTEXT:
+      g_value_set_object (value, sink->other_context);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* Called in the gl thread of the window */
+static void
+_init_window_gl (GstGLWallSinkWindow * win)
+{
+  GError *error = NULL;
+
+  win->shader = gst_gl_shader_new (win->context);
+  gst_gl_shader_set_vertex_source (win->shader, wall_vertex_shader_str);
+  gst_gl_shader_set_fragment_source (win->shader, wall_fragment_shader_str);
+
+  if (!gst_gl_shader_compile (win->shader, &error)) {
+    gst_gl_context_set_error (win->context, "%s", error->message);
+    g_error_free (error);
+    gst_object_unref (win->shader);
+    win->shader = NULL;
+    gst_gl_context_clear_shader (win->context);
+    return;
+  }
+
+  win->attr_position_loc =
+      gst_gl_shader_get_attribute_location (win->shader, "a_position");
+  win->attr_texture_loc =
+      gst_gl_shader_get_attribute_location (win->shader, "a_texCoord");
+}
+
+/* Called in the gl thread of the window */
+static void
+_cleanup_window_gl (GstGLWallSinkWindow * win)
+{
+  if (win->shader) {
+    gst_object_unref (win->shader);
+    win->shader = NULL;
+  }
+}
+
+/* Called in the gl thread of the window with the lock */
+static void
+_draw_output (GstGLWallSinkWindow * win, const GstGLWallSinkOutput * output)
+{
+  GstGLWallSink *sink = win->sink;
+  const GstGLFuncs *gl = win->context->gl_vtable;
+  GstVideoRectangle src, dst, result;
+  gint frame_width, frame_height;
+  gint crop[4];
+  gboolean keep_aspect_ratio;
+
+  frame_width = GST_VIDEO_INFO_WIDTH (&sink->info);
+  frame_height = GST_VIDEO_INFO_HEIGHT (&sink->info);
+
+  if (output->crop[2] > 0 && output->crop[3] > 0) {
+    crop[0] = MIN (output->crop[0], frame_width - 1);
+    crop[1] = MIN (output->crop[1], frame_height - 1);
+    crop[2] = MIN (output->crop[2], frame_width - crop[0]);
+    crop[3] = MIN (output->crop[3], frame_height - crop[1]);
+  } else {
+    crop[0] = crop[1] = 0;
+    crop[2] = frame_width;
+    crop[3] = frame_height;
+  }
+
+  /* GL viewports start from the bottom left corner */
+  dst.x = output->viewport[0] * win->width;
+  dst.w = output->viewport[2] * win->width;
+  dst.h = output->viewport[3] * win->height;
+  dst.y = win->height - output->viewport[1] * win->height - dst.h;
+
+  keep_aspect_ratio = output->keep_aspect_ratio < 0 ?
+      sink->keep_aspect_ratio : output->keep_aspect_ratio;
+
+  if (keep_aspect_ratio) {
+    src.x = src.y = 0;
+    src.w = gst_util_uint64_scale_int (crop[2],
+        GST_VIDEO_INFO_PAR_N (&sink->info),
+        MAX (GST_VIDEO_INFO_PAR_D (&sink->info), 1));
+    src.h = crop[3];
+
+    gst_video_sink_center_rect (src, dst, &result, TRUE);
+  } else {
+    result = dst;
+  }
+
+  gl->Viewport (result.x, result.y, result.w, result.h);
+
+  gst_gl_shader_set_uniform_4f (win->shader, "u_texRect",
+      (gfloat) crop[0] / frame_width, (gfloat) crop[1] / frame_height,
+      (gfloat) crop[2] / frame_width, (gfloat) crop[3] / frame_height);
+
+  gst_gl_context_draw_geometry (win->context, 0, 1);
+}
+
+/* Called in the gl thread of the window with the lock */
+static void
+_draw_window (GstGLWallSinkWindow * win)
+{
+  GstGLWallSink *sink = win->sink;
+  const GstGLFuncs *gl = win->context->gl_vtable;
+  guint i;
+
+  gl->Viewport (0, 0, win->width, win->height);
+  gl->ClearColor (0.0f, 0.0f, 0.0f, 1.0f);
+  gl->Clear (GL_COLOR_BUFFER_BIT);
+
+  if (!sink->redisplay_texture || !win->shader)
+    return;
+
+  /* the texture was drawn in the context of the sink */
+  if (sink->redisplay_sync)
+    gl->WaitSync (sink->redisplay_sync, 0, GL_TIMEOUT_IGNORED);
+
+  gst_gl_shader_use (win->shader);
+
+  gl->ActiveTexture (GL_TEXTURE0);
+  gl->BindTexture (GL_TEXTURE_2D, sink->redisplay_texture);
+  gst_gl_shader_set_uniform_1i (win->shader, "s_texture", 0);
+
+  gst_gl_context_bind_geometry (win->context, GST_GL_GEOMETRY_QUAD_FLIPPED,
+      win->attr_position_loc, win->attr_texture_loc);
+
+  for (i = 0; i < sink->outputs->len; i++) {
+    const GstGLWallSinkOutput *output =
+        &g_array_index (sink->outputs, GstGLWallSinkOutput, i);
+
+    if (output->window == win->index)
+      _draw_output (win, output);
+  }
+
+  gst_gl_context_unbind_geometry (win->context);
+
+  gl->BindTexture (GL_TEXTURE_2D, 0);
+  gst_gl_context_clear_shader (win->context);
+}
+
+/* draw callback of the window, which swaps the buffers itself */
+static void
+_on_draw (GstGLWallSinkWindow * win)
+{
+  g_mutex_lock (&win->sink->lock);
+  _draw_window (win);
+  g_mutex_unlock (&win->sink->lock);
+}
+
+static void
+_on_resize (GstGLWallSinkWindow * win, guint width, guint height)
+{
+  GST_TRACE_OBJECT (win->sink, "window %u resized to %ux%u", win->index,
+      width, height);
+
+  g_mutex_lock (&win->sink->lock);
+  win->width = width;
+  win->height = height;
+  g_mutex_unlock (&win->sink->lock);
+}
+
+static void
+_on_close (GstGLWallSinkWindow * win)
+{
+  GstGLWallSink *sink = win->sink;
+
+  gst_gl_context_set_error (win->context, "Output window %u was closed",
+      win->index);
+
+  g_mutex_lock (&sink->lock);
+  g_atomic_int_set (&sink->to_quit, 1);
+  g_cond_broadcast (&sink->cond);
+  g_mutex_unlock (&sink->lock);
+}
+
+/* Called in the gl thread of the window.  The draws of the windows are
+ * serialized by the lock, the swaps, which wait for the vertical blank,
+ * are not. */
+static void
+_present_window (GstGLWallSinkWindow * win)
+{
+  GstGLWallSink *sink = win->sink;
+
+  g_mutex_lock (&sink->lock);
+  _draw_window (win);
+  g_mutex_unlock (&sink->lock);
+
+  gst_gl_context_swap_buffers_with_damage (win->context, NULL, 0);
+
+  g_mutex_lock (&sink->lock);
+  if (sink->pending_presents > 0)
+    sink->pending_presents--;
+  g_cond_broadcast (&sink->cond);
+  g_mutex_unlock (&sink->lock);
+}
+
+static GstGLWallSinkWindow *
+_create_window (GstGLWallSink * sink, guint index)
+{
+  GstGLWallSinkWindow *win;
+  GstGLWindow *window;
+  GError *error = NULL;
+
+  win = g_slice_new0 (GstGLWallSinkWindow);
+  win->sink = sink;
+  win->index = index;
+  win->width = GST_VIDEO_SINK_WIDTH (sink);
+  win->height = GST_VIDEO_SINK_HEIGHT (sink);
+  win->context = gst_gl_context_new (sink->display);
+
+  window = gst_gl_context_get_window (win->context);
+
+  GST_OBJECT_LOCK (sink);
+  win->window_id = sink->window_ids[index];
+  GST_OBJECT_UNLOCK (sink);
+  if (win->window_id)
+    gst_gl_window_set_window_handle (window, win->window_id);
+
+  if (!gst_gl_context_create (win->context, sink->context, &error)) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, NOT_FOUND, ("%s", error->message),
+        (NULL));
+    g_clear_error (&error);
+    gst_object_unref (window);
+    gst_object_unref (win->context);
+    g_slice_free (GstGLWallSinkWindow, win);
+    return NULL;
+  }
+
+  gst_gl_window_set_resize_callback (window,
+      GST_GL_WINDOW_RESIZE_CB (_on_resize), win, NULL);
+  gst_gl_window_set_draw_callback (window, GST_GL_WINDOW_CB (_on_draw), win,
+      NULL);
+  gst_gl_window_set_close_callback (window, GST_GL_WINDOW_CB (_on_close), win,
+      NULL);
+
+  gst_gl_window_send_message (window, GST_GL_WINDOW_CB (_init_window_gl), win);
+
+  gst_object_unref (window);
+
+  GST_DEBUG_OBJECT (sink, "created window %u", index);
+
+  return win;
+}
+
+static void
+_free_window (GstGLWallSinkWindow * win)
+{
+  GstGLWindow *window = gst_gl_context_get_window (win->context);
+
+  gst_gl_window_send_message (window, GST_GL_WINDOW_CB (_cleanup_window_gl),
+      win);
+
+  gst_gl_window_set_resize_callback (window, NULL, NULL, NULL);
+  gst_gl_window_set_draw_callback (window, NULL, NULL, NULL);
+  gst_gl_window_set_close_callback (window, NULL, NULL, NULL);
+
+  gst_object_unref (window);
+  gst_object_unref (win->context);
+  g_slice_free (GstGLWallSinkWindow, win);
+}
+
+static gboolean
+_ensure_gl_setup (GstGLWallSink * sink)
+{
+  GError *error = NULL;
+  guint i;
+
+  if (!gst_gl_ensure_display (sink, &sink->display))
+    return FALSE;
+
+  if (!sink->context) {
+    sink->context = gst_gl_context_new (sink->display);
+    if (!gst_gl_context_create (sink->context, sink->other_context, &error))
+      goto context_error;
+
+    sink->have_sync = sink->context->gl_vtable->FenceSync != NULL;
+  }
+
+  for (i = 0; i < sink->n_windows; i++) {
+    if (!sink->windows[i] && !(sink->windows[i] = _create_window (sink, i)))
+      return FALSE;
+  }
+
+  return TRUE;
+
+context_error:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, NOT_FOUND, ("%s", error->message),
+        (NULL));
+    g_clear_error (&error);
+    gst_object_unref (sink->context);
+    sink->context = NULL;
+    return FALSE;
+  }
+}
+
+/* Called in the gl thread */
+static void
+_delete_sync (GstGLContext * context, GLsync sync)
+{
+  context->gl_vtable->DeleteSync (sync);
+}
+
+/* lets go of the frame held by upload @i, the windows must not draw its
+ * texture anymore */
+static void
+_release_upload (GstGLWallSink * sink, guint i)
+{
+  if (sink->uploaded[i]) {
+    gst_gl_upload_release_buffer (sink->upload[i]);
+    gst_buffer_unref (sink->uploaded[i]);
+    sink->uploaded[i] = NULL;
+  }
+}
+
+static void
+_cleanup_gl (GstGLWallSink * sink)
+{
+  guint i;
+
+  g_mutex_lock (&sink->lock);
+  sink->redisplay_texture = 0;
+  g_mutex_unlock (&sink->lock);
+
+  for (i = 0; i < GST_GL_WALL_SINK_MAX_WINDOWS; i++) {
+    if (sink->windows[i]) {
+      _free_window (sink->windows[i]);
+      sink->windows[i] = NULL;
+    }
+  }
+
+  for (i = 0; i < 2; i++) {
+    if (sink->upload[i]) {
+      _release_upload (sink, i);
+      gst_object_unref (sink->upload[i]);
+      sink->upload[i] = NULL;
+    }
+  }
+
+  if (sink->pool) {
+    gst_object_unref (sink->pool);
+    sink->pool = NULL;
+  }
+
+  if (sink->context) {
+    gst_object_unref (sink->context);
+    sink->context = NULL;
+  }
+
+  if (sink->display) {
+    gst_object_unref (sink->display);
+    sink->display = NULL;
+  }
+}
+
+static void
+gst_gl_wall_sink_set_context (GstElement * element, GstContext * context)
+{
+  GstGLWallSink *sink = GST_GL_WALL_SINK (element);
+
+  gst_gl_handle_set_context (element, context, &sink->display);
+}
+
+static gboolean
+gst_gl_wall_sink_query (GstBaseSink * bsink, GstQuery * query)
+{
+  GstGLWallSink *sink = GST_GL_WALL_SINK (bsink);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:
+      return gst_gl_handle_context_query ((GstElement *) sink, query,
+          &sink->display);
+    default:
+      return GST_BASE_SINK_CLASS (parent_class)->query (bsink, query);
+  }
+}
+
+static GstStateChangeReturn
+gst_gl_wall_sink_change_state (GstElement * element, GstStateChange transition)
+{
+  GstGLWallSink *sink = GST_GL_WALL_SINK (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      g_atomic_int_set (&sink->to_quit, 0);
+
+      GST_OBJECT_LOCK (sink);
+      if (!sink->window_ids[0]) {
+        GST_OBJECT_UNLOCK (sink);
+        gst_video_overlay_prepare_window_handle (GST_VIDEO_OVERLAY (sink));
+      } else {
+        GST_OBJECT_UNLOCK (sink);
+      }
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      _cleanup_gl (sink);
+      GST_VIDEO_SINK_WIDTH (sink) = 1;
+      GST_VIDEO_SINK_HEIGHT (sink) = 1;
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+gst_gl_wall_sink_get_times (GstBaseSink * bsink, GstBuffer * buf,
+    GstClockTime * start, GstClockTime * end)
+{
+  GstGLWallSink *sink = GST_GL_WALL_SINK (bsink);
+
+  if (GST_BUFFER_TIMESTAMP_IS_VALID (buf)) {
+    *start = GST_BUFFER_TIMESTAMP (buf);
+    if (GST_BUFFER_DURATION_IS_VALID (buf))
+      *end = *start + GST_BUFFER_DURATION (buf);
+    else if (GST_VIDEO_INFO_FPS_N (&sink->info) > 0)
+      *end = *start + gst_util_uint64_scale_int (GST_SECOND,
+          GST_VIDEO_INFO_FPS_D (&sink->info),
+          GST_VIDEO_INFO_FPS_N (&sink->info));
+  }
+}
+
+static gboolean
+gst_gl_wall_sink_set_caps (GstBaseSink * bsink, GstCaps * caps)
+{
+  GstGLWallSink *sink = GST_GL_WALL_SINK (bsink);
+  GstVideoInfo info;
+  guint i;
+
+  GST_DEBUG_OBJECT (sink, "set caps with %" GST_PTR_FORMAT, caps);
+
+  if (!gst_video_info_from_caps (&info, caps))
+    return FALSE;
+
+  g_mutex_lock (&sink->lock);
+  sink->info = info;
+  sink->redisplay_texture = 0;
+  g_mutex_unlock (&sink->lock);
+
+  GST_VIDEO_SINK_WIDTH (sink) = GST_VIDEO_INFO_WIDTH (&info);
+  GST_VIDEO_SINK_HEIGHT (sink) = GST_VIDEO_INFO_HEIGHT (&info);
+
+  if (!_ensure_gl_setup (sink))
+    return FALSE;
+
+  for (i = 0; i < 2; i++) {
+    if (sink->upload[i]) {
+      _release_upload (sink, i);
+      gst_object_unref (sink->upload[i]);
+    }
+    sink->upload[i] = gst_gl_upload_new (sink->context);
+    if (!gst_gl_upload_init_format (sink->upload[i], info, info)) {
+      GST_ELEMENT_ERROR (sink, RESOURCE, NOT_FOUND, ("Failed to init upload"),
+          (NULL));
+      return FALSE;
+    }
+  }
+  sink->next_upload = 0;
+
+  return TRUE;
+}
+
+static gboolean
+gst_gl_wall_sink_propose_allocation (GstBaseSink * bsink, GstQuery * query)
+{
+  GstGLWallSink *sink = GST_GL_WALL_SINK (bsink);
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  GstStructure *gl_context;
+  GstCaps *caps;
+  GstVideoInfo info;
+  gchar *platform, *gl_apis;
+  gpointer handle;
+  gboolean need_pool;
+
+  if (!_ensure_gl_setup (sink))
+    return FALSE;
+
+  gst_query_parse_allocation (query, &caps, &need_pool);
+
+  if (caps == NULL) {
+    GST_DEBUG_OBJECT (sink, "no caps specified");
+    return FALSE;
+  }
+
+  if (!gst_video_info_from_caps (&info, caps)) {
+    GST_DEBUG_OBJECT (sink, "invalid caps specified");
+    return FALSE;
+  }
+
+  if (need_pool) {
+    if (sink->pool)
+      gst_object_unref (sink->pool);
+    sink->pool = pool = gst_gl_buffer_pool_new (sink->context);
+
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, info.size, 3, 0);
+    if (!gst_buffer_pool_set_config (pool, config)) {
+      GST_DEBUG_OBJECT (sink, "failed setting config");
+      return FALSE;
+    }
+  }
+
+  /* we need at least 3 buffers because we hold on to the last two */
+  gst_query_add_allocation_pool (query, pool, info.size, 3, 0);
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, 0);
+  gst_query_add_allocation_meta (query, GST_VIDEO_CROP_META_API_TYPE, 0);
+
+  gl_apis = gst_gl_api_to_string (gst_gl_context_get_gl_api (sink->context));
+  platform =
+      gst_gl_platform_to_string (gst_gl_context_get_gl_platform
+      (sink->context));
+  handle = (gpointer) gst_gl_context_get_gl_context (sink->context);
+
+  gl_context =
+      gst_structure_new ("GstVideoGLTextureUploadMeta", "gst.gl.GstGLContext",
+      GST_GL_TYPE_CONTEXT, sink->context, "gst.gl.context.handle",
+      G_TYPE_POINTER, handle, "gst.gl.context.type", G_TYPE_STRING, platform,
+      "gst.gl.context.apis", G_TYPE_STRING, gl_apis, NULL);
+  gst_query_add_allocation_meta (query,
+      GST_VIDEO_GL_TEXTURE_UPLOAD_META_API_TYPE, gl_context);
+
+  g_free (gl_apis);
+  g_free (platform);
+  gst_structure_free (gl_context);
+
+  return TRUE;
+}
+
+typedef struct
+{
+  GstGLWallSink *sink;
+  GLsync sync;
+} FenceParams;
+
+/* Called in the gl thread */
+static void
+_insert_fence (GstGLContext * context, FenceParams * params)
+{
+  const GstGLFuncs *gl = context->gl_vtable;
+
+  if (params->sink->have_sync) {
+    params->sync = gl->FenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    /* the fence has to reach the GPU before another context waits on it */
+    gl->Flush ();
+  } else {
+    params->sync = NULL;
+    gl->Finish ();
+  }
+}
+
+/* applies the window handles given since the last frame */
+static void
+_update_window_handles (GstGLWallSink * sink)
+{
+  guint i;
+
+  for (i = 0; i < sink->n_windows; i++) {
+    GstGLWallSinkWindow *win = sink->windows[i];
+    guintptr window_id;
+
+    GST_OBJECT_LOCK (sink);
+    window_id = sink->window_ids[i];
+    GST_OBJECT_UNLOCK (sink);
+
+    if (win && window_id != win->window_id) {
+      GstGLWindow *window = gst_gl_context_get_window (win->context);
+
+      win->window_id = window_id;
+      gst_gl_window_set_window_handle (window, window_id);
+
+      gst_object_unref (window);
+    }
+  }
+}
+
+static GstFlowReturn
+gst_gl_wall_sink_render (GstBaseSink * bsink, GstBuffer * buf)
+{
+  GstGLWallSink *sink = GST_GL_WALL_SINK (bsink);
+  FenceParams params;
+  GLsync old_sync;
+  guint tex_id, next;
+  guint i;
+
+  if (!sink->upload[0])
+    return GST_FLOW_NOT_NEGOTIATED;
+
+  _update_window_handles (sink);
+
+  /* the windows may redraw the texture of the other upload on expose until
+   * every window presented this frame, this one was last drawn two frames
+   * ago and can be reused */
+  next = sink->next_upload;
+  _release_upload (sink, next);
+
+  /* once for all the outputs */
+  if (!gst_gl_upload_perform_with_buffer (sink->upload[next], buf, &tex_id))
+    goto upload_failed;
+  sink->uploaded[next] = gst_buffer_ref (buf);
+  sink->next_upload = next ^ 1;
+
+  params.sink = sink;
+  gst_gl_context_thread_add (sink->context,
+      (GstGLContextThreadFunc) _insert_fence, &params);
+
+  g_mutex_lock (&sink->lock);
+  sink->redisplay_texture = tex_id;
+  old_sync = sink->redisplay_sync;
+  sink->redisplay_sync = params.sync;
+  g_mutex_unlock (&sink->lock);
+
+  /* maps the windows the first time, the draw callback takes the lock */
+  for (i = 0; i < sink->n_windows; i++) {
+    GstGLWallSinkWindow *win = sink->windows[i];
+
+    if (win && !win->shown) {
+      GstGLWindow *window = gst_gl_context_get_window (win->context);
+
+      gst_gl_window_draw (window, win->width, win->height);
+      win->shown = TRUE;
+      gst_object_unref (window);
+    }
+  }
+
+  g_mutex_lock (&sink->lock);
+  sink->pending_presents = 0;
+
+  for (i = 0; i < sink->n_windows; i++) {
+    GstGLWallSinkWindow *win = sink->windows[i];
+    GstGLWindow *window;
+
+    if (!win)
+      continue;
+
+    window = gst_gl_context_get_window (win->context);
+    if (gst_gl_window_is_running (window)) {
+      sink->pending_presents++;
+      gst_gl_window_send_message_async (window,
+          GST_GL_WINDOW_CB (_present_window), win, NULL);
+    }
+
+    gst_object_unref (window);
+  }
+
+  /* all the windows present the frame before the next one is uploaded */
+  while (sink->pending_presents > 0
+      && g_atomic_int_get (&sink->to_quit) == 0)
+    g_cond_wait (&sink->cond, &sink->lock);
+  g_mutex_unlock (&sink->lock);
+
+  if (old_sync)
+    gst_gl_context_thread_add (sink->context,
+        (GstGLContextThreadFunc) _delete_sync, old_sync);
+
+  if (g_atomic_int_get (&sink->to_quit) != 0) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, NOT_FOUND,
+        ("%s", "An output window was closed"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+
+  return GST_FLOW_OK;
+
+upload_failed:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, NOT_FOUND,
+        ("%s", "Failed to upload format"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+}
+
+static void
+gst_gl_wall_sink_set_window_handle_action (GstGLWallSink * sink, guint window,
+    guint64 handle)
+{
+  g_return_if_fail (window < GST_GL_WALL_SINK_MAX_WINDOWS);
+
+  GST_DEBUG_OBJECT (sink, "window %u handle %" G_GUINT64_FORMAT, window,
+      handle);
+
+  GST_OBJECT_LOCK (sink);
+  sink->window_ids[window] = (guintptr) handle;
+  GST_OBJECT_UNLOCK (sink);
+}
+
+static void
+gst_gl_wall_sink_set_window_handle (GstVideoOverlay * overlay, guintptr id)
+{
+  gst_gl_wall_sink_set_window_handle_action (GST_GL_WALL_SINK (overlay), 0,
+      (guint64) id);
+}
+
+static void
+gst_gl_wall_sink_expose (GstVideoOverlay * overlay)
+{
+  GstGLWallSink *sink = GST_GL_WALL_SINK (overlay);
+  guint i;
+
+  for (i = 0; i < GST_GL_WALL_SINK_MAX_WINDOWS; i++) {
+    GstGLWallSinkWindow *win = sink->windows[i];
+    GstGLWindow *window;
+
+    if (!win || !win->shown)
+      continue;
+
+    window = gst_gl_context_get_window (win->context);
+    gst_gl_window_draw (window, win->width, win->height);
+    gst_object_unref (window);
+  }
+}
+
+static void
+gst_gl_wall_sink_video_overlay_init (GstVideoOverlayInterface * iface)
+{
+  iface->set_window_handle = gst_gl_wall_sink_set_window_handle;
+  iface->expose = gst_gl_wall_sink_expose;
+}
@@ -0,0 +1,138 @@
+/*
+ * GStreamer
+ * Copyright (C) 2013 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_GL_WALL_SINK_H_
+#define _GST_GL_WALL_SINK_H_
+
+#include <gst/gst.h>
+#include <gst/video/gstvideosink.h>
+#include <gst/video/video.h>
+
+#include <gst/gl/gl.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GL_WALL_SINK            (gst_gl_wall_sink_get_type())
+#define GST_GL_WALL_SINK(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GL_WALL_SINK,GstGLWallSink))
+#define GST_IS_GL_WALL_SINK(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GL_WALL_SINK))
+#define GST_GL_WALL_SINK_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass) ,GST_TYPE_GL_WALL_SINK,GstGLWallSinkClass))
+#define GST_IS_GL_WALL_SINK_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass) ,GST_TYPE_GL_WALL_SINK))
+#define GST_GL_WALL_SINK_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GST_TYPE_GL_WALL_SINK,GstGLWallSinkClass))
+
+/* largest number of windows and of outputs */
+#define GST_GL_WALL_SINK_MAX_WINDOWS 16
+#define GST_GL_WALL_SINK_MAX_OUTPUTS 64
+
+typedef struct _GstGLWallSink GstGLWallSink;
+typedef struct _GstGLWallSinkClass GstGLWallSinkClass;
+typedef struct _GstGLWallSinkOutput GstGLWallSinkOutput;
+typedef struct _GstGLWallSinkWindow GstGLWallSinkWindow;
+
+/* a region of the frame drawn into a rectangle of one of the windows */
+struct _GstGLWallSinkOutput
+{
+  guint window;
+
+  /* x, y, width and height in pixels of the frame, an empty rectangle
+   * stands for the whole frame */
+  gint crop[4];
+
+  /* x, y, width and height in fractions of the window, from the top left
+   * corner */
+  gfloat viewport[4];
+
+  /* -1 to follow the force-aspect-ratio property */
+  gint keep_aspect_ratio;
+};
+
+/* a window with its own context, which shares its textures with the
+ * context of the sink */
+struct _GstGLWallSinkWindow
+{
+  GstGLWallSink *sink;
+  guint index;
+
+  GstGLContext *context;
+  guintptr window_id;
+  guint width, height;
+  gboolean shown;
+
+  GstGLShader *shader;
+  GLint attr_position_loc;
+  GLint attr_texture_loc;
+};
+
+struct _GstGLWallSink
+{
+  GstVideoSink video_sink;
+
+  /* properties */
+  gchar *outputs_desc;
+  gboolean keep_aspect_ratio;
+  GstGLContext *other_context;
+
+  /* GstGLWallSinkOutput, only changed in NULL or READY, with the lock */
+  GArray *outputs;
+  guint n_windows;
+
+  /* window handles given by the application, with OBJECT_LOCK */
+  guintptr window_ids[GST_GL_WALL_SINK_MAX_WINDOWS];
+
+  GstVideoInfo info;
+
+  GstGLDisplay *display;
+  GstGLContext *context;
+  GstBufferPool *pool;
+
+  /* frames are uploaded by each upload in turn and stay mapped until the
+   * upload is used again, so that the texture the windows may redraw on
+   * expose is not overwritten by the next frame */
+  GstGLUpload *upload[2];
+  GstBuffer *uploaded[2];
+  guint next_upload;
+  gboolean have_sync;
+
+  GstGLWallSinkWindow *windows[GST_GL_WALL_SINK_MAX_WINDOWS];
+
+  /* the frame drawn by every window and the presents that are still
+   * pending for it */
+  GMutex lock;
+  GCond cond;
+  GLuint redisplay_texture;
+  GLsync redisplay_sync;
+  guint pending_presents;
+
+  volatile gint to_quit;
+};
+
+struct _GstGLWallSinkClass
+{
+  GstVideoSinkClass video_sink_class;
+
+  /* actions */
+  void (*set_window_handle) (GstGLWallSink * sink, guint window,
+                             guint64 handle);
+};
+
+GType gst_gl_wall_sink_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_GL_WALL_SINK_H_ */
@@ -50,10 +50,16 @@
 #include <gst/gl/gstglconfig.h>
 
 #include "gstglimagesink.h"
+#include "gstgltexturesink.h"
+#include "gstglwallsink.h"
 
 #include "gstglfiltercube.h"
 #include "gstgleffects.h"
 #include "gstglcolorscale.h"
+#include "gstglscaleladder.h"
+#include "gstglvisualizer.h"
+#include "gstglstats.h"
+#include "gstglcolorgrade.h"
 
 GType gst_gl_filter_cube_get_type (void);
 GType gst_gl_effects_get_type (void);
@@ -66,6 +72,8 @@ GType gst_gl_effects_get_type (void);
 #include "gstglfilterreflectedscreen.h"
 #include "gstglfiltershader.h"
 #include "gstgldeinterlace.h"
+#include "gstglframerate.h"
+#include "gstgldenoise.h"
 #include "gstglmosaic.h"
 #include "gstglvideomixer.h"
 
@@ -114,6 +122,16 @@ plugin_init (GstPlugin * plugin)
     return FALSE;
   }
 
+  if (!gst_element_register (plugin, "gltexturesink",
+          GST_RANK_NONE, GST_TYPE_GL_TEXTURE_SINK)) {
+    return FALSE;
+  }
+
+  if (!gst_element_register (plugin, "glwallsink",
+          GST_RANK_NONE, GST_TYPE_GL_WALL_SINK)) {
+    return FALSE;
+  }
+
   if (!gst_element_register (plugin, "glfiltercube",
           GST_RANK_NONE, GST_TYPE_GL_FILTER_CUBE)) {
     return FALSE;
@@ -128,6 +146,26 @@ plugin_init (GstPlugin * plugin)
           GST_RANK_NONE, GST_TYPE_GL_COLORSCALE)) {
     return FALSE;
   }
+
+  if (!gst_element_register (plugin, "glscaleladder",
+          GST_RANK_NONE, GST_TYPE_GL_SCALE_LADDER)) {
+    return FALSE;
+  }
+
+  if (!gst_element_register (plugin, "glvisualizer",
+          GST_RANK_NONE, GST_TYPE_GL_VISUALIZER)) {
+    return FALSE;
+  }
+
+  if (!gst_element_register (plugin, "glstats",
+          GST_RANK_NONE, GST_TYPE_GL_STATS)) {
+    return FALSE;
+  }
+
+  if (!gst_element_register (plugin, "glcolorgrade",
+          GST_RANK_NONE, GST_TYPE_GL_COLOR_GRADE)) {
+    return FALSE;
+  }
 #if GST_GL_HAVE_OPENGL
   if (!gst_element_register (plugin, "gltestsrc",
           GST_RANK_NONE, GST_TYPE_GL_TEST_SRC)) {
@@ -174,6 +212,16 @@ plugin_init (GstPlugin * plugin)
     return FALSE;
   }
 
+  if (!gst_element_register (plugin, "glframerate",
+          GST_RANK_NONE, GST_TYPE_GL_FRAME_RATE)) {
+    return FALSE;
+  }
+
+  if (!gst_element_register (plugin, "gldenoise",
+          GST_RANK_NONE, GST_TYPE_GL_DENOISE)) {
+    return FALSE;
+  }
+
   if (!gst_element_register (plugin, "glmosaic",
           GST_RANK_NONE, GST_TYPE_GL_MOSAIC)) {
     return FALSE;
@@ -27,6 +27,7 @@
 #include <gst/gl/gstglcontext.h>
 
 #include <stdio.h>
+#include <string.h>
 
 #if GST_GL_HAVE_GLES2
 /* *INDENT-OFF* */
@@ -342,6 +343,54 @@ GST_START_TEST (test_wrapped_context)
 
 GST_END_TEST;
 
+static GstGLContext *
+_create_context (void)
+{
+  GstGLContext *context;
+  GError *error = NULL;
+
+  context = gst_gl_context_new (display);
+  gst_gl_context_create (context, 0, &error);
+
+  fail_if (error != NULL, "Error creating context %s\n",
+      error ? error->message : "Unknown Error");
+
+  return context;
+}
+
+GST_START_TEST (test_startup_latency)
+{
+  GstGLContext *first, *context;
+  gint64 start, cold, warm = 0;
+  gint i;
+
+  /* the first context on a display resolves every entry point */
+  start = g_get_monotonic_time ();
+  first = _create_context ();
+  cold = g_get_monotonic_time () - start;
+
+  /* later ones copy them from the display */
+  for (i = 0; i < 10; i++) {
+    start = g_get_monotonic_time ();
+    context = _create_context ();
+    warm += g_get_monotonic_time () - start;
+
+    fail_unless (memcmp (first->gl_vtable, context->gl_vtable,
+            sizeof (GstGLFuncs)) == 0);
+    fail_unless (gst_gl_context_check_feature (context, "GL_bogus_feature")
+        == FALSE);
+
+    gst_object_unref (context);
+  }
+
+  GST_INFO ("context startup: first %" G_GINT64_FORMAT " us, "
+      "following %" G_GINT64_FORMAT " us on average", cold, warm / 10);
+
+  gst_object_unref (first);
+}
+
+GST_END_TEST;
+
 
 Suite *
 gst_gl_memory_suite (void)
@@ -353,6 +402,7 @@ gst_gl_memory_suite (void)
   tcase_add_checked_fixture (tc_chain, setup, teardown);
   tcase_add_test (tc_chain, test_share);
   tcase_add_test (tc_chain, test_wrapped_context);
+  tcase_add_test (tc_chain, test_startup_latency);
 
   return s;
 }
@@ -0,0 +1,325 @@
+/* GStreamer
+ *
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+#include <gst/gl/gstglcontext.h>
+
+/* the LUTs are part of the plugin, the test is built with gstgllut.c */
+#include "gstgllut.h"
+#include "effects/gstgleffectscurves.h"
+
+#include <string.h>
+
+static GstGLDisplay *display;
+static GstGLContext *context;
+
+void
+setup (void)
+{
+  display = gst_gl_display_new ();
+  context = gst_gl_context_new (display);
+  gst_gl_context_create (context, 0, NULL);
+}
+
+void
+teardown (void)
+{
+  gst_object_unref (display);
+  gst_object_unref (context);
+}
+
+static const guint8 *
+_entry (GstGLLut * lut, guint r, guint g, guint b)
+{
+  return &lut->data[(((b * lut->size) + g) * lut->size + r) * 4];
+}
+
+static void
+_check_entry (GstGLLut * lut, guint r, guint g, guint b, guint8 red,
+    guint8 green, guint8 blue)
+{
+  const guint8 *e = _entry (lut, r, g, b);
+
+  fail_unless (e[0] == red && e[1] == green && e[2] == blue,
+      "entry %u,%u,%u is %u,%u,%u instead of %u,%u,%u", r, g, b, e[0], e[1],
+      e[2], red, green, blue);
+}
+
+/* *INDENT-OFF* */
+static const gchar cube_3d[] =
+    "# a comment\n"
+    "TITLE \"swap\"\n"
+    "LUT_3D_SIZE 2\n"
+    "DOMAIN_MIN 0 0 0\n"
+    "DOMAIN_MAX 1 2 1\n"
+    "\n"
+    "0 0 0\n"
+    "0 1 0\n"
+    "1 0 0\n"
+    "1 1 0\n"
+    "0 0 1\n"
+    "0 1 1\n"
+    "1 0 1\n"
+    "1 1 1\n";
+
+static const gchar cube_1d[] =
+    "LUT_1D_SIZE 3\n"
+    "LUT_1D_INPUT_RANGE 0.0 2.0\n"
+    "1 0 0\n"
+    "0.5 0.5 0.5\n"
+    "0 1 1\n";
+/* *INDENT-ON* */
+
+GST_START_TEST (test_cube_3d)
+{
+  GstGLLut *lut;
+  GError *error = NULL;
+
+  lut = gst_gl_lut_new_from_cube (cube_3d, strlen (cube_3d), &error);
+  fail_unless (lut != NULL);
+  fail_unless (error == NULL);
+
+  fail_unless_equals_string (lut->title, "swap");
+  fail_unless_equals_int (lut->size, 2);
+  fail_unless (lut->domain_min[1] == 0.0f);
+  fail_unless (lut->domain_max[0] == 1.0f);
+  fail_unless (lut->domain_max[1] == 2.0f);
+
+  /* red varies fastest, the table swaps red and green */
+  _check_entry (lut, 0, 0, 0, 0, 0, 0);
+  _check_entry (lut, 1, 0, 0, 0, 255, 0);
+  _check_entry (lut, 0, 1, 0, 255, 0, 0);
+  _check_entry (lut, 0, 0, 1, 0, 0, 255);
+  _check_entry (lut, 1, 1, 1, 255, 255, 255);
+
+  gst_gl_lut_free (lut);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_cube_1d)
+{
+  GstGLLut *lut;
+  GError *error = NULL;
+  guint mid;
+
+  lut = gst_gl_lut_new_from_cube (cube_1d, strlen (cube_1d), &error);
+  fail_unless (lut != NULL);
+  fail_unless (error == NULL);
+
+  fail_unless (lut->title == NULL);
+  fail_unless_equals_int (lut->size, GST_GL_LUT_CURVE_SIZE);
+  fail_unless (lut->domain_min[2] == 0.0f);
+  fail_unless (lut->domain_max[2] == 2.0f);
+
+  /* each channel on its own */
+  _check_entry (lut, 0, 0, 0, 255, 0, 0);
+  _check_entry (lut, lut->size - 1, 0, lut->size - 1, 0, 0, 255);
+  _check_entry (lut, lut->size - 1, lut->size - 1, lut->size - 1, 0, 255,
+      255);
+
+  /* linearly interpolated between the entries */
+  mid = (lut->size - 1) / 2;
+  fail_unless (ABS (_entry (lut, mid, 0, 0)[0] - 128) <= 3);
+  fail_unless (ABS (_entry (lut, 0, mid, 0)[1] - 128) <= 3);
+
+  gst_gl_lut_free (lut);
+}
+
+GST_END_TEST;
+
+static void
+_check_cube_error (const gchar * data)
+{
+  GstGLLut *lut;
+  GError *error = NULL;
+
+  lut = gst_gl_lut_new_from_cube (data, strlen (data), &error);
+  fail_unless (lut == NULL, "parsed invalid cube \"%s\"", data);
+  fail_unless (error != NULL);
+  fail_unless (error->domain == GST_STREAM_ERROR);
+  GST_DEBUG ("%s", error->message);
+  g_clear_error (&error);
+}
+
+GST_START_TEST (test_cube_errors)
+{
+  /* no size */
+  _check_cube_error ("");
+  _check_cube_error ("0 0 0\n");
+  /* too small, too large */
+  _check_cube_error ("LUT_3D_SIZE 1\n0 0 0\n");
+  _check_cube_error ("LUT_3D_SIZE 257\n");
+  /* too few and too many entries */
+  _check_cube_error ("LUT_3D_SIZE 2\n0 0 0\n");
+  _check_cube_error ("LUT_1D_SIZE 2\n0 0 0\n1 1 1\n1 1 1\n");
+  /* both sizes */
+  _check_cube_error ("LUT_1D_SIZE 2\nLUT_3D_SIZE 2\n");
+  /* bad entries */
+  _check_cube_error ("LUT_1D_SIZE 2\n0 0 0\n1 x 1\n");
+  _check_cube_error ("LUT_1D_SIZE 2\n0 0 0\n1 1\n");
+  _check_cube_error ("LUT_1D_SIZE 2\n0 0 0\n1 1 1 1\n");
+  /* empty domain */
+  _check_cube_error ("LUT_1D_SIZE 2\nDOMAIN_MIN 0 1 0\nDOMAIN_MAX 1 1 1\n"
+      "0 0 0\n1 1 1\n");
+}
+
+GST_END_TEST;
+
+static void
+_check_curve_entry (GstGLLut * lut, const GstGLEffectsCurve * curve,
+    guint r, guint g, guint b, guint ir, guint ig, guint ib)
+{
+  const guint8 *data = curve->pixel_data;
+  guint bpp = curve->bytes_per_pixel;
+
+  _check_entry (lut, r, g, b, data[ir * bpp], data[ig * bpp + 1],
+      data[ib * bpp + 2]);
+}
+
+GST_START_TEST (test_builtin)
+{
+  const GstGLEffectsCurve *luma_curves[] =
+      { &heat_curve, &sepia_curve, &luma_xpro_curve, &xray_curve };
+  const GstGLLutBuiltin luma_builtins[] = { GST_GL_LUT_BUILTIN_HEAT,
+    GST_GL_LUT_BUILTIN_SEPIA, GST_GL_LUT_BUILTIN_LUMA_XPRO,
+    GST_GL_LUT_BUILTIN_XRAY
+  };
+  GstGLLut *lut;
+  guint i, last;
+
+  /* identity */
+  lut = gst_gl_lut_new_builtin (GST_GL_LUT_BUILTIN_NONE);
+  fail_unless_equals_int (lut->size, 2);
+  _check_entry (lut, 0, 0, 0, 0, 0, 0);
+  _check_entry (lut, 1, 0, 0, 255, 0, 0);
+  _check_entry (lut, 0, 1, 1, 0, 255, 255);
+  gst_gl_lut_free (lut);
+
+  /* the luma curves give the ends of the curve for black and white */
+  for (i = 0; i < G_N_ELEMENTS (luma_builtins); i++) {
+    const GstGLEffectsCurve *curve = luma_curves[i];
+
+    lut = gst_gl_lut_new_builtin (luma_builtins[i]);
+    fail_unless_equals_int (lut->size, GST_GL_LUT_CURVE_SIZE);
+    last = lut->size - 1;
+
+    _check_curve_entry (lut, curve, 0, 0, 0, 0, 0, 0);
+    _check_curve_entry (lut, curve, last, last, last, curve->width - 1,
+        curve->width - 1, curve->width - 1);
+    gst_gl_lut_free (lut);
+  }
+
+  /* cross processing maps each channel through its own curve */
+  lut = gst_gl_lut_new_builtin (GST_GL_LUT_BUILTIN_XPRO);
+  fail_unless_equals_int (lut->size, GST_GL_LUT_CURVE_SIZE);
+  last = lut->size - 1;
+  _check_curve_entry (lut, &xpro_curve, last, 0, 0, xpro_curve.width - 1, 0,
+      0);
+  _check_curve_entry (lut, &xpro_curve, 0, last, 0, 0, xpro_curve.width - 1,
+      0);
+  _check_curve_entry (lut, &xpro_curve, 0, 0, last, 0, 0,
+      xpro_curve.width - 1);
+  gst_gl_lut_free (lut);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  GstGLLut *lut;
+  gboolean texture_3d;
+  gboolean result;
+} UploadParams;
+
+static void
+_upload_lut (GstGLContext * context, UploadParams * params)
+{
+  params->result = gst_gl_lut_upload (params->lut, context,
+      params->texture_3d);
+}
+
+static void
+_unload_lut (GstGLContext * context, UploadParams * params)
+{
+  gst_gl_lut_unload (params->lut, context);
+}
+
+GST_START_TEST (test_upload)
+{
+  UploadParams params;
+
+  params.lut = gst_gl_lut_new_builtin (GST_GL_LUT_BUILTIN_HEAT);
+
+  /* the slices of the 2D atlas are laid out in a square grid */
+  params.texture_3d = FALSE;
+  gst_gl_context_thread_add (context,
+      (GstGLContextThreadFunc) _upload_lut, &params);
+  fail_unless (params.result);
+  fail_unless (params.lut->texture != 0);
+  fail_if (params.lut->texture_3d);
+  fail_unless_equals_int (params.lut->grid[0], 8);
+  fail_unless_equals_int (params.lut->grid[1], 8);
+
+  gst_gl_context_thread_add (context,
+      (GstGLContextThreadFunc) _unload_lut, &params);
+  fail_unless (params.lut->texture == 0);
+
+  if (gst_gl_lut_context_has_3d (context)) {
+    params.texture_3d = TRUE;
+    gst_gl_context_thread_add (context,
+        (GstGLContextThreadFunc) _upload_lut, &params);
+    fail_unless (params.result);
+    fail_unless (params.lut->texture != 0);
+    fail_unless (params.lut->texture_3d);
+
+    gst_gl_context_thread_add (context,
+        (GstGLContextThreadFunc) _unload_lut, &params);
+  }
+
+  gst_gl_lut_free (params.lut);
+}
+
+GST_END_TEST;
+
+
+Suite *
+gst_gl_lut_suite (void)
+{
+  Suite *s = suite_create ("GstGLLut");
+  TCase *tc_chain = tcase_create ("lut");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_checked_fixture (tc_chain, setup, teardown);
+  tcase_add_test (tc_chain, test_cube_3d);
+  tcase_add_test (tc_chain, test_cube_1d);
+  tcase_add_test (tc_chain, test_cube_errors);
+  tcase_add_test (tc_chain, test_builtin);
+  tcase_add_test (tc_chain, test_upload);
+
+  return s;
+}
+
+GST_CHECK_MAIN (gst_gl_lut);
@@ -27,8 +27,15 @@
 #include <gst/check/gstcheck.h>
 
 #include <gst/gl/gstglmemory.h>
+#include <gst/gl/gstglbufferpool.h>
 
+#include <math.h>
 #include <stdio.h>
+#include <string.h>
+
+#ifndef GL_RGB10_A2
+#define GL_RGB10_A2 0x8059
+#endif
 
 static GstGLDisplay *display;
 static GstGLContext *context;
@@ -114,6 +121,364 @@ GST_START_TEST (test_basic)
 
 GST_END_TEST;
 
+GST_START_TEST (test_atlas)
+{
+  GstGLTextureAtlas *atlas;
+  GstMemory *mem[3], *mem2;
+  GstGLMemory *gl_mem0, *gl_mem1, *gl_mem2;
+  GstVideoInfo vinfo;
+  gfloat tc[4];
+  gint i;
+
+  gst_video_info_set_format (&vinfo, GST_VIDEO_FORMAT_RGBA, 64, 32);
+
+  atlas = gst_gl_texture_atlas_new (context, 64, 32, 2);
+  fail_if (atlas == NULL);
+
+  for (i = 0; i < 2; i++) {
+    mem[i] = gst_gl_memory_alloc_from_atlas (atlas, vinfo);
+    fail_if (mem[i] == NULL);
+  }
+  gl_mem0 = (GstGLMemory *) mem[0];
+  gl_mem1 = (GstGLMemory *) mem[1];
+
+  /* both share the atlas texture at different offsets */
+  fail_if (gl_mem0->tex_id == 0);
+  fail_unless (gl_mem0->tex_id == gl_mem1->tex_id);
+  fail_if (gl_mem0->tex_x == gl_mem1->tex_x && gl_mem0->tex_y == gl_mem1->tex_y);
+
+  /* the atlas is full */
+  mem[2] = gst_gl_memory_alloc_from_atlas (atlas, vinfo);
+  fail_unless (mem[2] == NULL);
+
+  gst_gl_memory_get_tex_coords (gl_mem1, tc);
+  fail_unless (tc[0] >= 0.0f && tc[2] <= 1.0f && tc[0] < tc[2]);
+  fail_unless (tc[1] >= 0.0f && tc[3] <= 1.0f && tc[1] < tc[3]);
+  fail_unless (tc[2] - tc[0] < 1.0f || tc[3] - tc[1] < 1.0f);
+  /* linear sampling stays inside the slot */
+  fail_unless (fabs (tc[0] * gl_mem1->tex_width - (gl_mem1->tex_x + 0.5)) <
+      1e-3);
+  fail_unless (fabs (tc[3] * gl_mem1->tex_height - (gl_mem1->tex_y + 32 -
+              0.5)) < 1e-3);
+
+  /* copies don't live in the atlas */
+  mem2 = gst_memory_copy (mem[1], 0, -1);
+  fail_if (mem2 == NULL);
+  gl_mem2 = (GstGLMemory *) mem2;
+  fail_unless (gl_mem2->atlas == NULL);
+  fail_if (gl_mem2->tex_id == gl_mem1->tex_id);
+  gst_gl_memory_get_tex_coords (gl_mem2, tc);
+  fail_unless (fabs (tc[0]) < 1e-6 && fabs (tc[1]) < 1e-6);
+  fail_unless (fabs (tc[2] - 1.0) < 1e-6 && fabs (tc[3] - 1.0) < 1e-6);
+  gst_memory_unref (mem2);
+
+  /* a freed slot can be reused */
+  gst_memory_unref (mem[0]);
+  mem[0] = gst_gl_memory_alloc_from_atlas (atlas, vinfo);
+  fail_if (mem[0] == NULL);
+
+  if (gst_gl_context_get_error ())
+    printf ("%s\n", gst_gl_context_get_error ());
+  fail_if (gst_gl_context_get_error () != NULL);
+
+  gst_memory_unref (mem[0]);
+  gst_memory_unref (mem[1]);
+  gst_gl_texture_atlas_unref (atlas);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_planes)
+{
+  GstBuffer *buffer;
+  GstVideoMeta *meta;
+  GstVideoFrame frame;
+  GstVideoInfo vinfo;
+  GstGLMemory *gl_mem;
+  GstMapInfo map;
+  gint i;
+  static GstVideoFormat formats[3] = {
+    GST_VIDEO_FORMAT_I420, GST_VIDEO_FORMAT_NV12, GST_VIDEO_FORMAT_Y444,
+  };
+
+  /* packed formats are not split */
+  gst_video_info_set_format (&vinfo, GST_VIDEO_FORMAT_RGBA, 320, 240);
+  buffer = gst_buffer_new ();
+  fail_if (gst_gl_memory_setup_buffer (context, &vinfo, buffer));
+  fail_unless (gst_buffer_n_memory (buffer) == 0);
+  gst_buffer_unref (buffer);
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    guint p;
+
+    gst_video_info_set_format (&vinfo, formats[i], 322, 241);
+    buffer = gst_buffer_new ();
+    fail_unless (gst_gl_memory_setup_buffer (context, &vinfo, buffer));
+
+    fail_unless (gst_buffer_n_memory (buffer) ==
+        GST_VIDEO_INFO_N_PLANES (&vinfo));
+    meta = gst_buffer_get_video_meta (buffer);
+    fail_if (meta == NULL);
+    fail_unless (meta->n_planes == GST_VIDEO_INFO_N_PLANES (&vinfo));
+
+    for (p = 0; p < GST_VIDEO_INFO_N_PLANES (&vinfo); p++) {
+      gl_mem = (GstGLMemory *) gst_buffer_peek_memory (buffer, p);
+      fail_unless (gst_is_gl_memory ((GstMemory *) gl_mem));
+      fail_unless (GST_GL_MEMORY_IS_PLANE (gl_mem));
+      fail_unless (gl_mem->plane == p);
+      fail_if (gl_mem->tex_id == 0);
+      fail_unless (meta->stride[p] == GST_VIDEO_INFO_PLANE_STRIDE (&vinfo, p));
+    }
+
+    /* write through the video meta then sample the planes */
+    fail_unless (gst_video_frame_map (&frame, &vinfo, buffer, GST_MAP_WRITE));
+    memset (GST_VIDEO_FRAME_PLANE_DATA (&frame, 0), 0x80,
+        GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0));
+    gst_video_frame_unmap (&frame);
+
+    gl_mem = (GstGLMemory *) gst_buffer_peek_memory (buffer, 0);
+    fail_unless (GST_GL_MEMORY_FLAG_IS_SET (gl_mem,
+            GST_GL_MEMORY_FLAG_NEED_UPLOAD));
+    fail_unless (gst_memory_map ((GstMemory *) gl_mem, &map,
+            GST_MAP_READ | GST_MAP_GL));
+    fail_unless (*(guint *) map.data == gl_mem->tex_id);
+    gst_memory_unmap ((GstMemory *) gl_mem, &map);
+    fail_if (GST_GL_MEMORY_FLAG_IS_SET (gl_mem,
+            GST_GL_MEMORY_FLAG_NEED_UPLOAD));
+
+    /* GL writers get the texture and the system memory is read back */
+    fail_unless (gst_memory_map ((GstMemory *) gl_mem, &map,
+            GST_MAP_WRITE | GST_MAP_GL));
+    fail_unless (*(guint *) map.data == gl_mem->tex_id);
+    gst_memory_unmap ((GstMemory *) gl_mem, &map);
+    fail_unless (GST_GL_MEMORY_FLAG_IS_SET (gl_mem,
+            GST_GL_MEMORY_FLAG_NEED_DOWNLOAD));
+    fail_unless (gst_memory_map ((GstMemory *) gl_mem, &map, GST_MAP_READ));
+    fail_unless (map.data == gl_mem->data);
+    fail_unless (((guint8 *) map.data)[0] == 0x80);
+    gst_memory_unmap ((GstMemory *) gl_mem, &map);
+    fail_if (GST_GL_MEMORY_FLAG_IS_SET (gl_mem,
+            GST_GL_MEMORY_FLAG_NEED_DOWNLOAD));
+
+    if (gst_gl_context_get_error ())
+      printf ("%s\n", gst_gl_context_get_error ());
+    fail_if (gst_gl_context_get_error () != NULL);
+
+    gst_buffer_unref (buffer);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_texture_format)
+{
+  GstMemory *mem, *mem2;
+  GstGLMemory *gl_mem;
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstVideoInfo vinfo;
+  GstCaps *caps;
+  guint tex_format;
+
+  gst_video_info_set_format (&vinfo, GST_VIDEO_FORMAT_RGBA, 320, 240);
+
+  /* the default */
+  mem = gst_gl_memory_alloc (context, vinfo);
+  fail_if (mem == NULL);
+  fail_unless (((GstGLMemory *) mem)->tex_format == GL_RGBA8);
+  gst_memory_unref (mem);
+
+  /* 10 bits per component, kept by copies */
+  mem = gst_gl_memory_alloc_with_format (context, vinfo, GL_RGB10_A2);
+  if (mem) {
+    gl_mem = (GstGLMemory *) mem;
+    fail_if (gl_mem->tex_id == 0);
+    fail_unless (gl_mem->tex_format == GL_RGB10_A2);
+
+    mem2 = gst_memory_copy (mem, 0, -1);
+    fail_if (mem2 == NULL);
+    fail_unless (((GstGLMemory *) mem2)->tex_format == GL_RGB10_A2);
+    fail_if (((GstGLMemory *) mem2)->tex_id == gl_mem->tex_id);
+
+    gst_memory_unref (mem2);
+    gst_memory_unref (mem);
+  }
+
+  /* an unknown format */
+  mem = gst_gl_memory_alloc_with_format (context, vinfo, 0);
+  fail_unless (mem == NULL);
+
+  /* the pool config */
+  pool = gst_gl_buffer_pool_new (context);
+  config = gst_buffer_pool_get_config (pool);
+  fail_if (gst_buffer_pool_config_get_gl_texture_format (config, &tex_format));
+  gst_buffer_pool_config_set_gl_texture_format (config, GL_RGB10_A2);
+  fail_unless (gst_buffer_pool_config_get_gl_texture_format (config,
+          &tex_format));
+  fail_unless (tex_format == GL_RGB10_A2);
+
+  caps = gst_video_info_to_caps (&vinfo);
+  gst_buffer_pool_config_set_params (config, caps, vinfo.size, 0, 0);
+  gst_caps_unref (caps);
+  fail_unless (gst_buffer_pool_set_config (pool, config));
+
+  config = gst_buffer_pool_get_config (pool);
+  fail_unless (gst_buffer_pool_config_get_gl_texture_format (config,
+          &tex_format));
+  fail_unless (tex_format == GL_RGB10_A2);
+  gst_structure_free (config);
+  gst_object_unref (pool);
+
+  if (gst_gl_context_get_error ())
+    printf ("%s\n", gst_gl_context_get_error ());
+  fail_if (gst_gl_context_get_error () != NULL);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_buffer_share)
+{
+  GstBuffer *buffer, *copy, *buffer2;
+  GstMemory *mem, *mem2, *shared, *shared2;
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstVideoInfo vinfo;
+  GstCaps *caps;
+  GstMapInfo map;
+  guint tex_id;
+
+  gst_video_info_set_format (&vinfo, GST_VIDEO_FORMAT_RGBA, 320, 240);
+
+  mem = gst_gl_memory_alloc (context, vinfo);
+  fail_if (mem == NULL);
+  buffer = gst_buffer_new ();
+  gst_buffer_append_memory (buffer, mem);
+
+  /* copies share the same texture through a child memory */
+  copy = gst_buffer_copy (buffer);
+  shared = gst_buffer_peek_memory (copy, 0);
+  fail_if (shared == mem);
+  fail_unless (shared->parent == mem);
+  fail_unless (((GstGLMemory *) shared)->tex_id ==
+      ((GstGLMemory *) mem)->tex_id);
+  fail_if (gst_memory_is_writable (mem));
+  fail_if (gst_memory_is_writable (shared));
+
+  /* sharing a shared memory shares its parent */
+  shared2 = gst_memory_share (shared, 0, -1);
+  fail_unless (shared2->parent == mem);
+  gst_memory_unref (shared2);
+
+  /* reading does not copy */
+  fail_unless (gst_buffer_map (copy, &map, GST_MAP_READ | GST_MAP_GL));
+  fail_unless (*(guint *) map.data == ((GstGLMemory *) mem)->tex_id);
+  gst_buffer_unmap (copy, &map);
+  fail_unless (gst_buffer_peek_memory (copy, 0) == shared);
+
+  /* writing replaces the memory of the writer only */
+  fail_unless (gst_buffer_map (copy, &map, GST_MAP_WRITE | GST_MAP_GL));
+  tex_id = *(guint *) map.data;
+  gst_buffer_unmap (copy, &map);
+  mem2 = gst_buffer_peek_memory (copy, 0);
+  fail_if (mem2 == mem);
+  fail_unless (mem2->parent == NULL);
+  fail_unless (((GstGLMemory *) mem2)->tex_id == tex_id);
+  fail_if (tex_id == ((GstGLMemory *) mem)->tex_id);
+  fail_unless (gst_buffer_peek_memory (buffer, 0) == mem);
+  fail_unless (gst_memory_is_writable (mem));
+
+  gst_buffer_unref (copy);
+  gst_buffer_unref (buffer);
+
+  /* the pool does not reuse buffers that are still shared */
+  pool = gst_gl_buffer_pool_new (context);
+  config = gst_buffer_pool_get_config (pool);
+  caps = gst_video_info_to_caps (&vinfo);
+  gst_buffer_pool_config_set_params (config, caps, vinfo.size, 1, 1);
+  gst_caps_unref (caps);
+  fail_unless (gst_buffer_pool_set_config (pool, config));
+  fail_unless (gst_buffer_pool_set_active (pool, TRUE));
+
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buffer,
+          NULL) == GST_FLOW_OK);
+  mem = gst_buffer_peek_memory (buffer, 0);
+  copy = gst_buffer_copy (buffer);
+  gst_buffer_unref (buffer);
+
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buffer2,
+          NULL) == GST_FLOW_OK);
+  fail_if (gst_buffer_peek_memory (buffer2, 0) == mem);
+  mem2 = gst_buffer_peek_memory (buffer2, 0);
+  gst_buffer_unref (buffer2);
+  gst_buffer_unref (copy);
+
+  /* and reuses them otherwise */
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buffer2,
+          NULL) == GST_FLOW_OK);
+  fail_unless (gst_buffer_peek_memory (buffer2, 0) == mem2);
+  gst_buffer_unref (buffer2);
+
+  fail_unless (gst_buffer_pool_set_active (pool, FALSE));
+  gst_object_unref (pool);
+
+  if (gst_gl_context_get_error ())
+    printf ("%s\n", gst_gl_context_get_error ());
+  fail_if (gst_gl_context_get_error () != NULL);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_sync)
+{
+  GstGLContext *other;
+  GstGLMemory *gl_mem;
+  GstMemory *mem;
+  GstVideoInfo vinfo;
+  GstMapInfo map;
+
+  gst_video_info_set_format (&vinfo, GST_VIDEO_FORMAT_RGBA, 320, 240);
+
+  mem = gst_gl_memory_alloc (context, vinfo);
+  gl_mem = (GstGLMemory *) mem;
+
+  /* a GL write is assumed to come from the context of the memory */
+  fail_unless (gst_memory_map (mem, &map, GST_MAP_WRITE | GST_MAP_GL));
+  gst_memory_unmap (mem, &map);
+  fail_unless (gl_mem->sync_context == context);
+
+  /* reading from the same context needs no fence */
+  gst_gl_memory_wait_sync (gl_mem, context);
+  fail_unless (gl_mem->sync == NULL);
+  fail_unless (gl_mem->need_fence);
+
+  other = gst_gl_context_new (display);
+  fail_unless (gst_gl_context_create (other, context, NULL));
+
+  /* another context gets a fence, once */
+  gst_gl_memory_wait_sync (gl_mem, other);
+  fail_if (gl_mem->need_fence);
+  gst_gl_memory_wait_sync (gl_mem, other);
+  fail_if (gl_mem->need_fence);
+
+  /* the writer can be another context */
+  gst_gl_memory_set_sync_point (gl_mem, other);
+  fail_unless (gl_mem->sync_context == other);
+  fail_unless (gl_mem->need_fence);
+  gst_gl_memory_wait_sync (gl_mem, other);
+  fail_unless (gl_mem->need_fence);
+  gst_gl_memory_wait_sync (gl_mem, context);
+  fail_if (gl_mem->need_fence);
+
+  gst_memory_unref (mem);
+  gst_object_unref (other);
+
+  if (gst_gl_context_get_error ())
+    printf ("%s\n", gst_gl_context_get_error ());
+  fail_if (gst_gl_context_get_error () != NULL);
+}
+
+GST_END_TEST;
+
 
 Suite *
 gst_gl_memory_suite (void)
@@ -124,6 +489,11 @@ gst_gl_memory_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_checked_fixture (tc_chain, setup, teardown);
   tcase_add_test (tc_chain, test_basic);
+  tcase_add_test (tc_chain, test_atlas);
+  tcase_add_test (tc_chain, test_planes);
+  tcase_add_test (tc_chain, test_texture_format);
+  tcase_add_test (tc_chain, test_buffer_share);
+  tcase_add_test (tc_chain, test_sync);
 
   return s;
 }
@@ -26,7 +26,10 @@
 
 #include <gst/gl/gstglcontext.h>
 #include <gst/gl/gstglupload.h>
+#include <gst/gl/gstgldownload.h>
+#include <gst/gl/gstglutils.h>
 
+#include <math.h>
 #include <stdio.h>
 
 #if GST_GL_HAVE_GLES2
@@ -402,6 +405,339 @@ GST_START_TEST (test_upload_meta_producer)
 
 GST_END_TEST;
 
+/* checks that the texture holds the 5 red pixels of the cropped row */
+static void
+_check_cropped_row (GstGLDownload * download)
+{
+  guint8 rgba[5 * 4];
+  gpointer out_data[GST_VIDEO_MAX_PLANES] = { rgba, NULL, NULL, NULL };
+  guint i;
+
+  fail_unless (gst_gl_download_perform_with_data (download, tex_id,
+          out_data));
+
+  for (i = 0; i < 5; i++) {
+    fail_unless (rgba[i * 4] == 0xff && rgba[i * 4 + 1] == 0x00
+        && rgba[i * 4 + 2] == 0x00 && rgba[i * 4 + 3] == 0xff,
+        "pixel %u is 0x%02x%02x%02x%02x instead of red", i, rgba[i * 4],
+        rgba[i * 4 + 1], rgba[i * 4 + 2], rgba[i * 4 + 3]);
+  }
+}
+
+GST_START_TEST (test_upload_buffer_crop)
+{
+  GstBuffer *buffer;
+  GstGLMemory *gl_mem;
+  GstGLDownload *download;
+  GstVideoInfo in_info;
+  GstVideoInfo out_info;
+  GstVideoCropMeta *crop;
+  gfloat coords[4];
+  gboolean res;
+  gint i = 0;
+
+  /* the output has the size of the crop, each pixel samples one texel */
+  gst_video_info_set_format (&in_info, FORMAT, WIDTH, HEIGHT);
+  gst_video_info_set_format (&out_info, FORMAT, 5, 1);
+
+  gst_gl_upload_init_format (upload, in_info, out_info);
+
+  download = gst_gl_download_new (context);
+  fail_unless (gst_gl_download_init_format (download, GST_VIDEO_FORMAT_RGBA,
+          5, 1));
+
+  /* the red row of a frame in system memory */
+  buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, rgba_data,
+      sizeof (rgba_data), 0, sizeof (rgba_data), NULL, NULL);
+  crop = gst_buffer_add_video_crop_meta (buffer);
+  crop->x = 2;
+  crop->y = 3;
+  crop->width = 5;
+  crop->height = 1;
+
+  res = gst_gl_get_crop_tex_coords (buffer, &in_info, coords);
+  fail_unless (res == TRUE);
+  fail_unless (coords[0] == 0.2f && coords[1] == 0.3f);
+  fail_unless (coords[2] == 0.7f && coords[3] == 0.4f);
+
+  res = gst_gl_upload_perform_with_buffer (upload, buffer, &tex_id);
+  fail_if (res == FALSE, "Failed to upload cropped buffer: %s\n",
+      gst_gl_context_get_error ());
+  _check_cropped_row (download);
+  gst_gl_upload_release_buffer (upload);
+  gst_buffer_unref (buffer);
+
+  /* covering the whole frame is the same as not cropping */
+  buffer = gst_buffer_new ();
+  gl_mem = gst_gl_memory_wrapped (context, in_info, rgba_data, NULL, NULL);
+  gst_buffer_append_memory (buffer, (GstMemory *) gl_mem);
+  crop = gst_buffer_add_video_crop_meta (buffer);
+  crop->width = WIDTH;
+  crop->height = HEIGHT;
+
+  res = gst_gl_get_crop_tex_coords (buffer, &in_info, coords);
+  fail_unless (res == FALSE);
+  fail_unless (coords[0] == 0.0f && coords[1] == 0.0f);
+  fail_unless (coords[2] == 1.0f && coords[3] == 1.0f);
+
+  /* a GstGLMemory is drawn into another texture */
+  crop->y = 3;
+  crop->height = 1;
+
+  res = gst_gl_upload_perform_with_buffer (upload, buffer, &tex_id);
+  fail_if (res == FALSE, "Failed to upload cropped GstGLMemory: %s\n",
+      gst_gl_context_get_error ());
+  fail_if (tex_id == gl_mem->tex_id);
+  _check_cropped_row (download);
+
+  gst_gl_window_draw (window, WIDTH, HEIGHT);
+  gst_gl_window_send_message (window, GST_GL_WINDOW_CB (init), context);
+
+  while (i < 2) {
+    gst_gl_window_send_message (window, GST_GL_WINDOW_CB (draw_render),
+        context);
+    i++;
+  }
+
+  gst_gl_upload_release_buffer (upload);
+  gst_buffer_unref (buffer);
+  gst_object_unref (download);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_colorimetry_coefficients)
+{
+  const GstVideoColorMatrix matrices[] = { GST_VIDEO_COLOR_MATRIX_BT601,
+    GST_VIDEO_COLOR_MATRIX_BT709, GST_VIDEO_COLOR_MATRIX_SMPTE240M
+  };
+  const GstVideoColorRange ranges[] = { GST_VIDEO_COLOR_RANGE_16_235,
+    GST_VIDEO_COLOR_RANGE_0_255
+  };
+  gfloat to_rgb_offset[3], to_rgb[9], to_yuv_offset[3], to_yuv[9];
+  GstVideoInfo info;
+  guint i, j, k, l;
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_I420, WIDTH, HEIGHT);
+
+  for (i = 0; i < G_N_ELEMENTS (matrices); i++) {
+    for (j = 0; j < G_N_ELEMENTS (ranges); j++) {
+      info.colorimetry.matrix = matrices[i];
+      info.colorimetry.range = ranges[j];
+
+      gst_gl_get_yuv_to_rgb_coefficients (&info, to_rgb_offset, to_rgb);
+      gst_gl_get_rgb_to_yuv_coefficients (&info, to_yuv_offset, to_yuv);
+
+      /* one conversion undoes the other */
+      for (k = 0; k < 3; k++) {
+        fail_unless (fabs (to_yuv_offset[k] + to_rgb_offset[k]) < 1e-6);
+
+        for (l = 0; l < 3; l++) {
+          gfloat v = to_yuv[k * 3] * to_rgb[l] + to_yuv[k * 3 + 1] *
+              to_rgb[3 + l] + to_yuv[k * 3 + 2] * to_rgb[6 + l];
+
+          fail_unless (fabs (v - (k == l ? 1.0 : 0.0)) < 1e-5,
+              "matrix %u range %u: %f at %u,%u", matrices[i], ranges[j], v, k,
+              l);
+        }
+      }
+
+      /* grey stays grey */
+      fail_unless (fabs (to_yuv[3] + to_yuv[4] + to_yuv[5]) < 1e-6);
+      fail_unless (fabs (to_yuv[6] + to_yuv[7] + to_yuv[8]) < 1e-6);
+    }
+  }
+
+  /* BT.601 limited range as it used to be hardcoded */
+  info.colorimetry.matrix = GST_VIDEO_COLOR_MATRIX_BT601;
+  info.colorimetry.range = GST_VIDEO_COLOR_RANGE_16_235;
+  gst_gl_get_yuv_to_rgb_coefficients (&info, to_rgb_offset, to_rgb);
+  fail_unless (fabs (to_rgb[0] - 1.164) < 1e-3);
+  fail_unless (fabs (to_rgb[2] - 1.596) < 1e-3);
+  fail_unless (fabs (to_rgb[4] + 0.391) < 1e-3);
+  fail_unless (fabs (to_rgb[5] + 0.813) < 1e-3);
+  fail_unless (fabs (to_rgb[7] - 2.018) < 1e-3);
+}
+
+GST_END_TEST;
+
+static void
+_fill_yuv (GstVideoFrame * frame, guint8 y, guint8 u, guint8 v)
+{
+  guint8 *data = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+  guint i, j, width, height, stride;
+
+  width = GST_VIDEO_FRAME_WIDTH (frame);
+  height = GST_VIDEO_FRAME_HEIGHT (frame);
+  stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+
+  switch (GST_VIDEO_FRAME_FORMAT (frame)) {
+    case GST_VIDEO_FORMAT_AYUV:
+      for (i = 0; i < height; i++) {
+        for (j = 0; j < width; j++) {
+          data[i * stride + j * 4] = 0xff;
+          data[i * stride + j * 4 + 1] = y;
+          data[i * stride + j * 4 + 2] = u;
+          data[i * stride + j * 4 + 3] = v;
+        }
+      }
+      break;
+    case GST_VIDEO_FORMAT_YUY2:
+      for (i = 0; i < height; i++) {
+        for (j = 0; j < GST_ROUND_UP_2 (width) / 2; j++) {
+          data[i * stride + j * 4] = y;
+          data[i * stride + j * 4 + 1] = u;
+          data[i * stride + j * 4 + 2] = y;
+          data[i * stride + j * 4 + 3] = v;
+        }
+      }
+      break;
+    case GST_VIDEO_FORMAT_NV12:
+      for (i = 0; i < height; i++)
+        memset (data + i * stride, y, width);
+      data = GST_VIDEO_FRAME_PLANE_DATA (frame, 1);
+      stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 1);
+      for (i = 0; i < GST_VIDEO_FRAME_COMP_HEIGHT (frame, 1); i++) {
+        for (j = 0; j < GST_VIDEO_FRAME_COMP_WIDTH (frame, 1); j++) {
+          data[i * stride + j * 2] = u;
+          data[i * stride + j * 2 + 1] = v;
+        }
+      }
+      break;
+    case GST_VIDEO_FORMAT_I420:
+      for (i = 0; i < height; i++)
+        memset (data + i * stride, y, width);
+      for (j = 1; j < 3; j++) {
+        data = GST_VIDEO_FRAME_PLANE_DATA (frame, j);
+        stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, j);
+        for (i = 0; i < GST_VIDEO_FRAME_COMP_HEIGHT (frame, j); i++)
+          memset (data + i * stride, j == 1 ? u : v,
+              GST_VIDEO_FRAME_COMP_WIDTH (frame, j));
+      }
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+}
+
+/* the textbook conversion, independent from the one in the library */
+static void
+_yuv_to_rgb_reference (gdouble kr, gdouble kb, gboolean full_range,
+    guint8 y, guint8 u, guint8 v, gdouble rgb[3])
+{
+  gdouble luma, pb, pr;
+  guint i;
+
+  if (full_range) {
+    luma = y / 255.0;
+    pb = (u - 128) / 255.0;
+    pr = (v - 128) / 255.0;
+  } else {
+    luma = (y - 16) / 219.0;
+    pb = (u - 128) / 224.0;
+    pr = (v - 128) / 224.0;
+  }
+
+  rgb[0] = luma + 2.0 * (1.0 - kr) * pr;
+  rgb[2] = luma + 2.0 * (1.0 - kb) * pb;
+  rgb[1] = (luma - kr * rgb[0] - kb * rgb[2]) / (1.0 - kr - kb);
+
+  for (i = 0; i < 3; i++)
+    rgb[i] = CLAMP (rgb[i], 0.0, 1.0) * 255.0;
+}
+
+/* compares frames converted by the upload shaders to the reference */
+GST_START_TEST (test_upload_colorimetry)
+{
+  const GstVideoFormat formats[] = { GST_VIDEO_FORMAT_AYUV,
+    GST_VIDEO_FORMAT_I420, GST_VIDEO_FORMAT_NV12, GST_VIDEO_FORMAT_YUY2
+  };
+  const struct
+  {
+    GstVideoColorMatrix matrix;
+    gdouble kr, kb;
+  } matrices[] = {
+    {
+    GST_VIDEO_COLOR_MATRIX_BT601, 0.299, 0.114}, {
+    GST_VIDEO_COLOR_MATRIX_BT709, 0.2126, 0.0722}
+  };
+  const guint8 colors[][3] = { {81, 90, 240}, {145, 54, 34}, {41, 240, 110},
+  {180, 128, 128}, {235, 128, 128}, {16, 128, 128}
+  };
+  guint8 rgba[WIDTH * HEIGHT * 4];
+  gpointer out_data[GST_VIDEO_MAX_PLANES] = { rgba, NULL, NULL, NULL };
+  gdouble max_error = 0.0;
+  guint f, m, full, c, i, k;
+
+  for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+    for (m = 0; m < G_N_ELEMENTS (matrices); m++) {
+      for (full = 0; full < 2; full++) {
+        GstVideoInfo in_info, out_info;
+        GstGLDownload *download;
+        GstVideoFrame frame;
+        GstBuffer *buffer;
+
+        gst_video_info_set_format (&in_info, formats[f], WIDTH, HEIGHT);
+        in_info.colorimetry.matrix = matrices[m].matrix;
+        in_info.colorimetry.range = full ? GST_VIDEO_COLOR_RANGE_0_255 :
+            GST_VIDEO_COLOR_RANGE_16_235;
+        gst_video_info_set_format (&out_info, GST_VIDEO_FORMAT_RGBA, WIDTH,
+            HEIGHT);
+
+        gst_object_unref (upload);
+        upload = gst_gl_upload_new (context);
+        fail_unless (gst_gl_upload_init_format (upload, in_info, out_info));
+
+        download = gst_gl_download_new (context);
+        fail_unless (gst_gl_download_init_format (download,
+                GST_VIDEO_FORMAT_RGBA, WIDTH, HEIGHT));
+
+        gst_gl_context_gen_texture (context, &tex_id, GST_VIDEO_FORMAT_RGBA,
+            WIDTH, HEIGHT);
+
+        buffer = gst_buffer_new_allocate (NULL, in_info.size, NULL);
+        fail_unless (gst_video_frame_map (&frame, &in_info, buffer,
+                GST_MAP_READWRITE));
+
+        for (c = 0; c < G_N_ELEMENTS (colors); c++) {
+          gdouble ref[3];
+
+          _fill_yuv (&frame, colors[c][0], colors[c][1], colors[c][2]);
+          _yuv_to_rgb_reference (matrices[m].kr, matrices[m].kb, full,
+              colors[c][0], colors[c][1], colors[c][2], ref);
+
+          fail_unless (gst_gl_upload_perform_with_data (upload, tex_id,
+                  frame.data));
+          fail_unless (gst_gl_download_perform_with_data (download, tex_id,
+                  out_data));
+
+          for (i = 0; i < WIDTH * HEIGHT; i++) {
+            for (k = 0; k < 3; k++) {
+              gdouble error = fabs (rgba[i * 4 + k] - ref[k]);
+
+              max_error = MAX (max_error, error);
+              fail_unless (error <= 2.5, "%s matrix %u %s range: color %u "
+                  "component %u is %u instead of %.1f",
+                  gst_video_format_to_string (formats[f]), matrices[m].matrix,
+                  full ? "full" : "limited", c, k, rgba[i * 4 + k], ref[k]);
+            }
+          }
+        }
+
+        gst_video_frame_unmap (&frame);
+        gst_buffer_unref (buffer);
+        gst_gl_context_del_texture (context, &tex_id);
+        gst_object_unref (download);
+      }
+    }
+  }
+
+  GST_INFO ("largest difference to the reference: %f", max_error);
+}
+
+GST_END_TEST;
+
 
 Suite *
 gst_gl_upload_suite (void)
@@ -416,6 +752,9 @@ gst_gl_upload_suite (void)
   tcase_add_test (tc_chain, test_upload_memory);
   tcase_add_test (tc_chain, test_upload_buffer);
   tcase_add_test (tc_chain, test_upload_meta_producer);
+  tcase_add_test (tc_chain, test_upload_buffer_crop);
+  tcase_add_test (tc_chain, test_colorimetry_coefficients);
+  tcase_add_test (tc_chain, test_upload_colorimetry);
 
   return s;
 }
@@ -106,6 +106,80 @@ done:
   gst_object_unref (bus);
 }
 
+typedef struct
+{
+  GstBuffer *last_buf;
+  guint n_reused;
+} ReuseCount;
+
+static GstMemory *
+get_frame_memory (GstBuffer * buf)
+{
+  GstMemory *mem = gst_buffer_peek_memory (buf, 0);
+
+  while (mem->parent)
+    mem = mem->parent;
+
+  return mem;
+}
+
+/* counts the output frames living in the same memory as the frame before
+ * them, which the elements that render on demand push instead of drawing
+ * the same scene again */
+static GstPadProbeReturn
+count_reused_frames (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  ReuseCount *count = user_data;
+  GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  /* holding the last buffer keeps its memory from being recycled by the
+   * pool for a newly drawn frame */
+  if (count->last_buf
+      && get_frame_memory (buf) == get_frame_memory (count->last_buf))
+    count->n_reused++;
+  gst_buffer_replace (&count->last_buf, buf);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static guint
+run_reuse_pipeline (const gchar * descr)
+{
+  GstElement *pipe, *sink;
+  GstMessage *message;
+  GstBus *bus;
+  GstPad *pad;
+  ReuseCount count = { NULL, 0 };
+
+  pipe = setup_pipeline (descr);
+  fail_unless (pipe != NULL);
+  sink = gst_bin_get_by_name (GST_BIN (pipe), "sink");
+  fail_unless (sink != NULL);
+
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, count_reused_frames,
+      &count, NULL);
+  gst_object_unref (pad);
+  gst_object_unref (sink);
+
+  fail_if (gst_element_set_state (pipe, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE, "Could not set pipeline %s to playing", descr);
+
+  bus = gst_element_get_bus (pipe);
+  message = gst_bus_timed_pop_filtered (bus, 10 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (message != NULL, "Timeout running %s", descr);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+  gst_object_unref (bus);
+
+  gst_buffer_replace (&count.last_buf, NULL);
+  gst_element_set_state (pipe, GST_STATE_NULL);
+  gst_object_unref (pipe);
+
+  return count.n_reused;
+}
+
 GST_START_TEST (test_glimagesink)
 {
   gchar *s;
@@ -129,6 +203,19 @@ GST_START_TEST (test_glfiltercube)
       GST_MESSAGE_UNKNOWN, target_state);
 }
 
+GST_END_TEST
+GST_START_TEST (test_glfiltercube_reuse)
+{
+  const gchar *s;
+
+  /* videorate repeats each frame 6 times and the cube does not move, so
+   * only the first output of every input frame is drawn */
+  s = "videotestsrc num-buffers=2 ! video/x-raw,framerate=5/1 ! videorate "
+      "! video/x-raw,framerate=30/1 ! glfiltercube speed=0 "
+      "! fakesink name=sink";
+  fail_unless (run_reuse_pipeline (s) > 0);
+}
+
 GST_END_TEST
 #if GST_GL_HAVE_GLES2
 # define N_EFFECTS 3
@@ -273,6 +360,16 @@ GST_START_TEST (test_glmosaic)
       GST_MESSAGE_UNKNOWN, target_state);
 }
 
+GST_END_TEST
+GST_START_TEST (test_glmosaic_reuse)
+{
+  const gchar *s;
+
+  s = "videotestsrc num-buffers=2 ! video/x-raw,framerate=5/1 ! videorate "
+      "! video/x-raw,framerate=30/1 ! glmosaic speed=0 ! fakesink name=sink";
+  fail_unless (run_reuse_pipeline (s) > 0);
+}
+
 GST_END_TEST
 #if 0
 GST_START_TEST (test_glshader)
@@ -324,6 +421,7 @@ GST_END_TEST
 #ifndef GST_DISABLE_PARSE
   tcase_add_test (tc_chain, test_glimagesink);
   tcase_add_test (tc_chain, test_glfiltercube);
+  tcase_add_test (tc_chain, test_glfiltercube_reuse);
   tcase_add_test (tc_chain, test_gleffects);
 #if GST_GL_HAVE_OPENGL
   tcase_add_test (tc_chain, test_gltestsrc);
@@ -333,6 +431,7 @@ GST_END_TEST
   tcase_add_test (tc_chain, test_glfilterreflectedscreen);
   tcase_add_test (tc_chain, test_gldeinterlace);
   tcase_add_test (tc_chain, test_glmosaic);
+  tcase_add_test (tc_chain, test_glmosaic_reuse);
 #if 0
   tcase_add_test (tc_chain, test_glshader);
   tcase_add_test (tc_chain, test_glfilterapp);